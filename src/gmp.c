@@ -133,6 +133,15 @@
 
 /* Static headers. */
 
+static void
+result_annotations_xml_clear ();
+
+static void
+command_timing_start (const gchar *);
+
+static void
+command_timing_finish ();
+
 /** @todo Exported for manage_sql.c. */
 void
 buffer_results_xml (GString *, iterator_t *, task_t, int, int, int, int, int,
@@ -725,8 +734,49 @@ typedef struct
   char *task_id;                  ///< ID of container task.
   char *type;                     ///< Type of report.
   int wrapper;                    ///< Whether there was a wrapper REPORT.
+  report_t stream_report;         ///< Report receiving results while parsing.
+  int stream_failed;              ///< Whether adding results while parsing failed.
 } create_report_data_t;
 
+/**
+ * @brief Number of parsed results at which CREATE_REPORT adds them to the DB.
+ */
+#define CREATE_REPORT_STREAM_SIZE 3000
+
+/**
+ * @brief Free the parsed results of a create_report command.
+ *
+ * Leaves the array empty.
+ *
+ * @param[in]  results  Array of create_report_result_t pointers.
+ */
+static void
+create_report_results_clear (array_t *results)
+{
+  guint index = results->len;
+  while (index--)
+    {
+      create_report_result_t *result;
+      result = (create_report_result_t*) g_ptr_array_index (results,
+                                                            index);
+      if (result)
+        {
+          free (result->host);
+          free (result->hostname);
+          free (result->description);
+          free (result->nvt_oid);
+          free (result->port);
+          free (result->qod);
+          free (result->qod_type);
+          free (result->scan_nvt_version);
+          free (result->severity);
+          free (result->threat);
+          g_free (result);
+        }
+    }
+  g_ptr_array_set_size (results, 0);
+}
+
 /**
  * @brief Reset command data.
  *
@@ -793,25 +843,7 @@ create_report_data_reset (create_report_data_t *data)
   free (data->result_threat);
   if (data->results)
     {
-      guint index = data->results->len;
-      while (index--)
-        {
-          create_report_result_t *result;
-          result = (create_report_result_t*) g_ptr_array_index (data->results,
-                                                                index);
-          if (result)
-            {
-              free (result->host);
-              free (result->hostname);
-              free (result->description);
-              free (result->nvt_oid);
-              free (result->port);
-              free (result->qod);
-              free (result->qod_type);
-              free (result->scan_nvt_version);
-              free (result->severity);
-            }
-        }
+      create_report_results_clear (data->results);
       array_free (data->results);
     }
   free (data->scan_end);
@@ -4007,6 +4039,37 @@ buffer_size_t to_client_end = 0;
 static GMarkupParseContext*
 xml_context = NULL;
 
+/**
+ * @brief Session token given in AUTHENTICATE.
+ */
+static gchar *session_token = NULL;
+
+/**
+ * @brief Session token of the connection, for LOGOUT.
+ *
+ * The token that AUTHENTICATE took or returned, if any.
+ */
+static gchar *authenticated_token = NULL;
+
+/**
+ * @brief Whether AUTHENTICATE asked for a session token.
+ */
+static int authenticate_session = 0;
+
+/**
+ * @brief Compression asked for by AUTHENTICATE.
+ *
+ * 0 none, 1 gzip, -1 unsupported method.
+ */
+static int authenticate_compress = 0;
+
+/**
+ * @brief Whether output to the client is gzip compressed.
+ *
+ * Set after the response to an AUTHENTICATE that asked for compression.
+ */
+int client_compress = 0;
+
 /**
  * @brief Client input parser.
  */
@@ -4031,7 +4094,9 @@ typedef enum
   CLIENT_AUTHENTICATE,
   CLIENT_AUTHENTICATE_CREDENTIALS,
   CLIENT_AUTHENTICATE_CREDENTIALS_PASSWORD,
+  CLIENT_AUTHENTICATE_CREDENTIALS_TOKEN,
   CLIENT_AUTHENTICATE_CREDENTIALS_USERNAME,
+  CLIENT_BATCH,
   CLIENT_CREATE_ALERT,
   CLIENT_CREATE_ALERT_ACTIVE,
   CLIENT_CREATE_ALERT_COMMENT,
@@ -4361,6 +4426,7 @@ typedef enum
   CLIENT_GET_VERSION_AUTHENTIC,
   CLIENT_GET_VULNS,
   CLIENT_HELP,
+  CLIENT_LOGOUT,
   CLIENT_MODIFY_ALERT,
   CLIENT_MODIFY_ALERT_ACTIVE,
   CLIENT_MODIFY_ALERT_COMMENT,
@@ -4550,6 +4616,169 @@ typedef enum
  */
 static client_state_t client_state = CLIENT_TOP;
 
+/**
+ * @brief A GMP command name and the client state that starts it.
+ */
+typedef struct
+{
+  const gchar *name;           ///< Command name.
+  client_state_t state;        ///< State set on the start of the command.
+} command_state_t;
+
+/**
+ * @brief Client states of the commands allowed after authentication.
+ *
+ * Must stay sorted by strcasecmp, for bsearch.
+ */
+static const command_state_t command_states[] = {
+  { "AUTHENTICATE", CLIENT_AUTHENTICATE },
+  { "BATCH", CLIENT_BATCH },
+  { "CREATE_ALERT", CLIENT_CREATE_ALERT },
+  { "CREATE_ASSET", CLIENT_CREATE_ASSET },
+  { "CREATE_CONFIG", CLIENT_CREATE_CONFIG },
+  { "CREATE_CREDENTIAL", CLIENT_CREATE_CREDENTIAL },
+  { "CREATE_FILTER", CLIENT_CREATE_FILTER },
+  { "CREATE_GROUP", CLIENT_CREATE_GROUP },
+  { "CREATE_NOTE", CLIENT_CREATE_NOTE },
+  { "CREATE_OVERRIDE", CLIENT_CREATE_OVERRIDE },
+  { "CREATE_PERMISSION", CLIENT_CREATE_PERMISSION },
+  { "CREATE_PORT_LIST", CLIENT_CREATE_PORT_LIST },
+  { "CREATE_PORT_RANGE", CLIENT_CREATE_PORT_RANGE },
+  { "CREATE_REPORT", CLIENT_CREATE_REPORT },
+  { "CREATE_REPORT_FORMAT", CLIENT_CREATE_REPORT_FORMAT },
+  { "CREATE_ROLE", CLIENT_CREATE_ROLE },
+  { "CREATE_SCANNER", CLIENT_CREATE_SCANNER },
+  { "CREATE_SCHEDULE", CLIENT_CREATE_SCHEDULE },
+  { "CREATE_TAG", CLIENT_CREATE_TAG },
+  { "CREATE_TARGET", CLIENT_CREATE_TARGET },
+  { "CREATE_TASK", CLIENT_CREATE_TASK },
+  { "CREATE_TICKET", CLIENT_CREATE_TICKET },
+  { "CREATE_TLS_CERTIFICATE", CLIENT_CREATE_TLS_CERTIFICATE },
+  { "CREATE_USER", CLIENT_CREATE_USER },
+  { "DELETE_ALERT", CLIENT_DELETE_ALERT },
+  { "DELETE_ASSET", CLIENT_DELETE_ASSET },
+  { "DELETE_CONFIG", CLIENT_DELETE_CONFIG },
+  { "DELETE_CREDENTIAL", CLIENT_DELETE_CREDENTIAL },
+  { "DELETE_FILTER", CLIENT_DELETE_FILTER },
+  { "DELETE_GROUP", CLIENT_DELETE_GROUP },
+  { "DELETE_NOTE", CLIENT_DELETE_NOTE },
+  { "DELETE_OVERRIDE", CLIENT_DELETE_OVERRIDE },
+  { "DELETE_PERMISSION", CLIENT_DELETE_PERMISSION },
+  { "DELETE_PORT_LIST", CLIENT_DELETE_PORT_LIST },
+  { "DELETE_PORT_RANGE", CLIENT_DELETE_PORT_RANGE },
+  { "DELETE_REPORT", CLIENT_DELETE_REPORT },
+  { "DELETE_REPORT_FORMAT", CLIENT_DELETE_REPORT_FORMAT },
+  { "DELETE_ROLE", CLIENT_DELETE_ROLE },
+  { "DELETE_SCANNER", CLIENT_DELETE_SCANNER },
+  { "DELETE_SCHEDULE", CLIENT_DELETE_SCHEDULE },
+  { "DELETE_TAG", CLIENT_DELETE_TAG },
+  { "DELETE_TARGET", CLIENT_DELETE_TARGET },
+  { "DELETE_TASK", CLIENT_DELETE_TASK },
+  { "DELETE_TICKET", CLIENT_DELETE_TICKET },
+  { "DELETE_TLS_CERTIFICATE", CLIENT_DELETE_TLS_CERTIFICATE },
+  { "DELETE_USER", CLIENT_DELETE_USER },
+  { "DESCRIBE_AUTH", CLIENT_DESCRIBE_AUTH },
+  { "EMPTY_TRASHCAN", CLIENT_EMPTY_TRASHCAN },
+  { "GET_AGGREGATES", CLIENT_GET_AGGREGATES },
+  { "GET_ALERTS", CLIENT_GET_ALERTS },
+  { "GET_ASSETS", CLIENT_GET_ASSETS },
+  { "GET_CONFIGS", CLIENT_GET_CONFIGS },
+  { "GET_CREDENTIALS", CLIENT_GET_CREDENTIALS },
+  { "GET_FEEDS", CLIENT_GET_FEEDS },
+  { "GET_FILTERS", CLIENT_GET_FILTERS },
+  { "GET_GROUPS", CLIENT_GET_GROUPS },
+  { "GET_INFO", CLIENT_GET_INFO },
+  { "GET_NOTES", CLIENT_GET_NOTES },
+  { "GET_NVT_FAMILIES", CLIENT_GET_NVT_FAMILIES },
+  { "GET_NVTS", CLIENT_GET_NVTS },
+  { "GET_OVERRIDES", CLIENT_GET_OVERRIDES },
+  { "GET_PERMISSIONS", CLIENT_GET_PERMISSIONS },
+  { "GET_PORT_LISTS", CLIENT_GET_PORT_LISTS },
+  { "GET_PREFERENCES", CLIENT_GET_PREFERENCES },
+  { "GET_REPORT_FORMATS", CLIENT_GET_REPORT_FORMATS },
+  { "GET_REPORTS", CLIENT_GET_REPORTS },
+  { "GET_RESULTS", CLIENT_GET_RESULTS },
+  { "GET_ROLES", CLIENT_GET_ROLES },
+  { "GET_SCANNERS", CLIENT_GET_SCANNERS },
+  { "GET_SCHEDULES", CLIENT_GET_SCHEDULES },
+  { "GET_SETTINGS", CLIENT_GET_SETTINGS },
+  { "GET_SYSTEM_REPORTS", CLIENT_GET_SYSTEM_REPORTS },
+  { "GET_TAGS", CLIENT_GET_TAGS },
+  { "GET_TARGETS", CLIENT_GET_TARGETS },
+  { "GET_TASKS", CLIENT_GET_TASKS },
+  { "GET_USERS", CLIENT_GET_USERS },
+  { "GET_VERSION", CLIENT_GET_VERSION_AUTHENTIC },
+  { "GET_VULNS", CLIENT_GET_VULNS },
+  { "HELP", CLIENT_HELP },
+  { "LOGOUT", CLIENT_LOGOUT },
+  { "MODIFY_ALERT", CLIENT_MODIFY_ALERT },
+  { "MODIFY_ASSET", CLIENT_MODIFY_ASSET },
+  { "MODIFY_AUTH", CLIENT_MODIFY_AUTH },
+  { "MODIFY_CONFIG", CLIENT_MODIFY_CONFIG },
+  { "MODIFY_CREDENTIAL", CLIENT_MODIFY_CREDENTIAL },
+  { "MODIFY_FILTER", CLIENT_MODIFY_FILTER },
+  { "MODIFY_GROUP", CLIENT_MODIFY_GROUP },
+  { "MODIFY_NOTE", CLIENT_MODIFY_NOTE },
+  { "MODIFY_OVERRIDE", CLIENT_MODIFY_OVERRIDE },
+  { "MODIFY_PERMISSION", CLIENT_MODIFY_PERMISSION },
+  { "MODIFY_PORT_LIST", CLIENT_MODIFY_PORT_LIST },
+  { "MODIFY_REPORT_FORMAT", CLIENT_MODIFY_REPORT_FORMAT },
+  { "MODIFY_ROLE", CLIENT_MODIFY_ROLE },
+  { "MODIFY_SCANNER", CLIENT_MODIFY_SCANNER },
+  { "MODIFY_SCHEDULE", CLIENT_MODIFY_SCHEDULE },
+  { "MODIFY_SETTING", CLIENT_MODIFY_SETTING },
+  { "MODIFY_TAG", CLIENT_MODIFY_TAG },
+  { "MODIFY_TARGET", CLIENT_MODIFY_TARGET },
+  { "MODIFY_TASK", CLIENT_MODIFY_TASK },
+  { "MODIFY_TICKET", CLIENT_MODIFY_TICKET },
+  { "MODIFY_TLS_CERTIFICATE", CLIENT_MODIFY_TLS_CERTIFICATE },
+  { "MODIFY_USER", CLIENT_MODIFY_USER },
+  { "MOVE_TASK", CLIENT_MOVE_TASK },
+  { "RESTORE", CLIENT_RESTORE },
+  { "RESUME_TASK", CLIENT_RESUME_TASK },
+  { "RUN_WIZARD", CLIENT_RUN_WIZARD },
+  { "START_TASK", CLIENT_START_TASK },
+  { "STOP_TASK", CLIENT_STOP_TASK },
+  { "SYNC_CONFIG", CLIENT_SYNC_CONFIG },
+  { "TEST_ALERT", CLIENT_TEST_ALERT },
+  { "VERIFY_REPORT_FORMAT", CLIENT_VERIFY_REPORT_FORMAT },
+  { "VERIFY_SCANNER", CLIENT_VERIFY_SCANNER },
+};
+
+/**
+ * @brief Compare a command name to a command state entry.
+ *
+ * @param[in]  name   Command name.
+ * @param[in]  entry  Command state entry.
+ *
+ * @return Result of strcasecmp on the names.
+ */
+static int
+command_state_compare (const void *name, const void *entry)
+{
+  return strcasecmp ((const char *) name,
+                     ((const command_state_t *) entry)->name);
+}
+
+/**
+ * @brief Get the client state that starts a command.
+ *
+ * @param[in]  name  Command name.
+ *
+ * @return Client state, or CLIENT_TOP if there is no such command.
+ */
+static client_state_t
+command_client_state (const gchar *name)
+{
+  const command_state_t *entry;
+
+  entry = bsearch (name, command_states,
+                   sizeof (command_states) / sizeof (command_states[0]),
+                   sizeof (command_states[0]),
+                   command_state_compare);
+  return entry ? entry->state : CLIENT_TOP;
+}
+
 /**
  * @brief Set the client state.
  *
@@ -4562,6 +4791,354 @@ set_client_state (client_state_t state)
   g_debug ("   client state set: %i", client_state);
 }
 
+
+/* BATCH. */
+
+/**
+ * @brief The batch command.
+ */
+typedef struct
+{
+  GPtrArray *commands;  ///< Child commands, as XML strings.
+  GString *current;     ///< Child command being collected.
+  int depth;            ///< Element depth below the batch element.
+  int invalid;          ///< Whether a child is not a read-only command.
+} batch_t;
+
+/**
+ * @brief Parser callback data.
+ *
+ * This is initially 0 because it's a global variable.
+ */
+static batch_t batch_data;
+
+/**
+ * @brief Reset command data.
+ */
+static void
+batch_reset ()
+{
+  if (batch_data.commands)
+    g_ptr_array_free (batch_data.commands, TRUE);
+  if (batch_data.current)
+    g_string_free (batch_data.current, TRUE);
+  memset (&batch_data, 0, sizeof (batch_t));
+}
+
+/**
+ * @brief Start a command.
+ */
+static void
+batch_start ()
+{
+  memset (&batch_data, 0, sizeof (batch_t));
+  batch_data.commands = g_ptr_array_new_with_free_func (g_free);
+}
+
+/**
+ * @brief Start element.
+ *
+ * Each child of the batch is collected as a complete command string, for
+ * \ref process_gmp.
+ *
+ * @param[in]  name              Element name.
+ * @param[in]  attribute_names   All attribute names.
+ * @param[in]  attribute_values  All attribute values.
+ */
+static void
+batch_element_start (const gchar *name, const gchar **attribute_names,
+                     const gchar **attribute_values)
+{
+  if (batch_data.depth == 0)
+    {
+      if (read_only_gmp_command (name) == 0)
+        batch_data.invalid = 1;
+      batch_data.current = g_string_new ("");
+    }
+  batch_data.depth++;
+
+  g_string_append_printf (batch_data.current, "<%s", name);
+  while (*attribute_names)
+    {
+      gchar *attribute;
+
+      attribute = g_markup_printf_escaped (" %s=\"%s\"",
+                                           *attribute_names,
+                                           *attribute_values);
+      g_string_append (batch_data.current, attribute);
+      g_free (attribute);
+      attribute_names++;
+      attribute_values++;
+    }
+  g_string_append_c (batch_data.current, '>');
+}
+
+/**
+ * @brief Add text to element.
+ *
+ * @param[in]  text         Text.
+ * @param[in]  text_len     Text length.
+ */
+static void
+batch_element_text (const gchar *text, gsize text_len)
+{
+  if (batch_data.current)
+    {
+      gchar *escaped;
+
+      escaped = g_markup_escape_text (text, text_len);
+      g_string_append (batch_data.current, escaped);
+      g_free (escaped);
+    }
+}
+
+/**
+ * @brief Run the commands of a batch in worker processes.
+ *
+ * Each worker runs a contiguous range of the commands on its own database
+ * connection, and writes the responses to a temporary file.  The responses
+ * are then appended to the buffer in order.
+ *
+ * @param[in]  gmp_parser  GMP parser.
+ * @param[in]  workers     Number of worker processes.
+ * @param[in]  buffer      Buffer for the responses.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+batch_run_parallel (gmp_parser_t *gmp_parser, int workers, GString *buffer)
+{
+  FILE **fragments;
+  pid_t *pids;
+  int index, ret, count;
+
+  count = batch_data.commands->len;
+  fragments = g_malloc0 (workers * sizeof (FILE *));
+  pids = g_malloc0 (workers * sizeof (pid_t));
+  ret = 0;
+
+  for (index = 0; index < workers; index++)
+    {
+      fragments[index] = tmpfile ();
+      if (fragments[index] == NULL)
+        {
+          g_warning ("%s: tmpfile failed: %s",
+                     __func__,
+                     strerror (errno));
+          ret = -1;
+          break;
+        }
+
+      pids[index] = fork ();
+      switch (pids[index])
+        {
+          case 0:
+            {
+              int first, last, command, fail;
+
+              /* Child.  Reopen the database (required after fork) and run
+               * this worker's commands.  Use _exit, so that stdio buffers
+               * shared with the parent are not flushed here. */
+              reinit_manage_worker ();
+              first = (count * index) / workers;
+              last = (count * (index + 1)) / workers;
+              fail = 0;
+              for (command = first; command < last; command++)
+                {
+                  gchar *response;
+
+                  if (process_gmp (gmp_parser,
+                                   g_ptr_array_index (batch_data.commands,
+                                                      command),
+                                   &response))
+                    {
+                      fail = 1;
+                      break;
+                    }
+                  if (fputs (response, fragments[index]) == EOF)
+                    fail = 1;
+                  g_free (response);
+                  if (fail)
+                    break;
+                }
+              if (fail == 0 && fflush (fragments[index]))
+                fail = 1;
+              cleanup_manage_process (TRUE);
+              _exit (fail ? EXIT_FAILURE : EXIT_SUCCESS);
+            }
+          case -1:
+            g_warning ("%s: fork failed: %s",
+                       __func__,
+                       strerror (errno));
+            ret = -1;
+            break;
+          default:
+            g_debug ("%s: %i forked %i", __func__, getpid (), pids[index]);
+            break;
+        }
+      if (ret)
+        break;
+    }
+
+  /* Wait for all the workers that were started. */
+
+  for (index = 0; index < workers; index++)
+    {
+      int status;
+
+      if (pids[index] <= 0)
+        continue;
+
+      while (waitpid (pids[index], &status, 0) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          g_warning ("%s: waitpid: %s",
+                     __func__,
+                     strerror (errno));
+          status = -1;
+          break;
+        }
+
+      if (status == -1
+          || WIFEXITED (status) == 0
+          || WEXITSTATUS (status) != EXIT_SUCCESS)
+        {
+          g_warning ("%s: worker %i failed", __func__, index);
+          ret = -1;
+        }
+    }
+
+  /* Join the responses in order. */
+
+  for (index = 0; index < workers; index++)
+    {
+      char chunk[65536];
+      size_t length;
+
+      if (fragments[index] == NULL)
+        continue;
+
+      if (ret == 0)
+        {
+          rewind (fragments[index]);
+          while ((length = fread (chunk, 1, sizeof (chunk),
+                                  fragments[index])))
+            g_string_append_len (buffer, chunk, length);
+          if (ferror (fragments[index]))
+            {
+              g_warning ("%s: fread failed", __func__);
+              ret = -1;
+            }
+        }
+
+      fclose (fragments[index]);
+    }
+
+  g_free (fragments);
+  g_free (pids);
+  return ret;
+}
+
+/**
+ * @brief Execute command.
+ *
+ * @param[in]  gmp_parser   GMP parser.
+ * @param[in]  error        Error parameter.
+ */
+static void
+batch_run (gmp_parser_t *gmp_parser, GError **error)
+{
+  GString *buffer;
+  int workers, ret;
+  guint index;
+
+  if (batch_data.invalid)
+    {
+      SEND_TO_CLIENT_OR_FAIL
+       (XML_ERROR_SYNTAX ("batch",
+                          "Only GET commands are allowed in a batch"));
+      batch_reset ();
+      return;
+    }
+
+  buffer = g_string_new ("<batch_response"
+                         " status=\"" STATUS_OK "\""
+                         " status_text=\"" STATUS_OK_TEXT "\">");
+
+  /* The children are independent and only read, so they can run on
+   * separate connections, in any order. */
+  workers = MIN (get_gmp_batch_workers (), (int) batch_data.commands->len);
+  if (workers > 1)
+    ret = batch_run_parallel (gmp_parser, workers, buffer);
+  else
+    {
+      ret = 0;
+      for (index = 0; index < batch_data.commands->len; index++)
+        {
+          gchar *response;
+
+          if (process_gmp (gmp_parser,
+                           g_ptr_array_index (batch_data.commands, index),
+                           &response))
+            {
+              ret = -1;
+              break;
+            }
+          g_string_append (buffer, response);
+          g_free (response);
+        }
+    }
+  batch_reset ();
+
+  if (ret)
+    {
+      g_string_free (buffer, TRUE);
+      SEND_TO_CLIENT_OR_FAIL (XML_INTERNAL_ERROR ("batch"));
+      return;
+    }
+
+  g_string_append (buffer, "</batch_response>");
+  if (send_to_client (buffer->str, gmp_parser->client_writer,
+                      gmp_parser->client_writer_data))
+    {
+      g_string_free (buffer, TRUE);
+      error_send_to_client (error);
+      return;
+    }
+  g_string_free (buffer, TRUE);
+}
+
+/**
+ * @brief End element.
+ *
+ * @param[in]  gmp_parser   GMP parser.
+ * @param[in]  error        Error parameter.
+ * @param[in]  name         Element name.
+ *
+ * @return 0 success, 1 command finished.
+ */
+static int
+batch_element_end (gmp_parser_t *gmp_parser, GError **error,
+                   const gchar *name)
+{
+  if (batch_data.depth == 0)
+    {
+      batch_run (gmp_parser, error);
+      return 1;
+    }
+
+  g_string_append_printf (batch_data.current, "</%s>", name);
+  batch_data.depth--;
+  if (batch_data.depth == 0)
+    {
+      g_ptr_array_add (batch_data.commands,
+                       g_string_free (batch_data.current, FALSE));
+      batch_data.current = NULL;
+    }
+  return 0;
+}
+
 
 /* XML parser handlers. */
 
@@ -4681,7 +5258,21 @@ gmp_xml_handle_start_element (/* unused */ GMarkupParseContext* context,
         if (strcasecmp ("GET_VERSION", element_name) == 0)
           set_client_state (CLIENT_GET_VERSION);
         else if (strcasecmp ("AUTHENTICATE", element_name) == 0)
-          set_client_state (CLIENT_AUTHENTICATE);
+          {
+            const gchar* attribute;
+
+            authenticate_session
+             = find_attribute (attribute_names, attribute_values,
+                               "session", &attribute)
+               && strcmp (attribute, "0");
+            if (find_attribute (attribute_names, attribute_values,
+                                "compress", &attribute)
+                && strcmp (attribute, ""))
+              authenticate_compress = strcasecmp (attribute, "gzip") ? -1 : 1;
+            else
+              authenticate_compress = 0;
+            set_client_state (CLIENT_AUTHENTICATE);
+          }
         else
           {
             /** @todo If a real GMP command, return STATUS_ERROR_MUST_AUTH. */
@@ -4701,6 +5292,12 @@ gmp_xml_handle_start_element (/* unused */ GMarkupParseContext* context,
         break;
 
       case CLIENT_AUTHENTIC:
+        result_annotations_xml_clear ();
+        command_timing_start (element_name);
+        if (read_only_gmp_command (element_name))
+          manage_use_replica ();
+        else
+          manage_use_primary ();
         if (command_disabled (gmp_parser, element_name))
           {
             SEND_TO_CLIENT_OR_FAIL
@@ -4711,1249 +5308,1382 @@ gmp_xml_handle_start_element (/* unused */ GMarkupParseContext* context,
                          G_MARKUP_ERROR_UNKNOWN_ELEMENT,
                          "Command Unavailable");
           }
-        else if (strcasecmp ("AUTHENTICATE", element_name) == 0)
-          {
-            free_credentials (&current_credentials);
-            set_client_state (CLIENT_AUTHENTICATE);
-          }
-        else if (strcasecmp ("CREATE_ASSET", element_name) == 0)
-          set_client_state (CLIENT_CREATE_ASSET);
-        else if (strcasecmp ("CREATE_CONFIG", element_name) == 0)
-          {
-            create_config_start (gmp_parser, attribute_names,
-                                 attribute_values);
-            set_client_state (CLIENT_CREATE_CONFIG);
-          }
-        else if (strcasecmp ("CREATE_ALERT", element_name) == 0)
-          {
-            create_alert_data->condition_data = make_array ();
-            create_alert_data->event_data = make_array ();
-            create_alert_data->method_data = make_array ();
-
-            gvm_append_string (&create_alert_data->part_data, "");
-            gvm_append_string (&create_alert_data->part_name, "");
-            gvm_append_string (&create_alert_data->comment, "");
-            gvm_append_string (&create_alert_data->name, "");
-            gvm_append_string (&create_alert_data->condition, "");
-            gvm_append_string (&create_alert_data->method, "");
-            gvm_append_string (&create_alert_data->event, "");
-
-            set_client_state (CLIENT_CREATE_ALERT);
-          }
-        else if (strcasecmp ("CREATE_CREDENTIAL", element_name) == 0)
+        else switch (command_client_state (element_name))
           {
-            gvm_append_string (&create_credential_data->comment, "");
-            gvm_append_string (&create_credential_data->name, "");
-            set_client_state (CLIENT_CREATE_CREDENTIAL);
-          }
-        else if (strcasecmp ("CREATE_FILTER", element_name) == 0)
-          {
-            gvm_append_string (&create_filter_data->comment, "");
-            gvm_append_string (&create_filter_data->term, "");
-            set_client_state (CLIENT_CREATE_FILTER);
-          }
-        else if (strcasecmp ("CREATE_GROUP", element_name) == 0)
-          {
-            gvm_append_string (&create_group_data->users, "");
-            set_client_state (CLIENT_CREATE_GROUP);
-          }
-        else if (strcasecmp ("CREATE_ROLE", element_name) == 0)
-          {
-            gvm_append_string (&create_role_data->users, "");
-            set_client_state (CLIENT_CREATE_ROLE);
-          }
-        else if (strcasecmp ("CREATE_NOTE", element_name) == 0)
-          set_client_state (CLIENT_CREATE_NOTE);
-        else if (strcasecmp ("CREATE_OVERRIDE", element_name) == 0)
-          set_client_state (CLIENT_CREATE_OVERRIDE);
-        else if (strcasecmp ("CREATE_PORT_LIST", element_name) == 0)
-          {
-            create_port_list_start (gmp_parser, attribute_names,
-                                    attribute_values);
-            set_client_state (CLIENT_CREATE_PORT_LIST);
-          }
-        else if (strcasecmp ("CREATE_PORT_RANGE", element_name) == 0)
-          set_client_state (CLIENT_CREATE_PORT_RANGE);
-        else if (strcasecmp ("CREATE_PERMISSION", element_name) == 0)
-          {
-            gvm_append_string (&create_permission_data->comment, "");
-            set_client_state (CLIENT_CREATE_PERMISSION);
-          }
-        else if (strcasecmp ("CREATE_REPORT", element_name) == 0)
-          set_client_state (CLIENT_CREATE_REPORT);
-        else if (strcasecmp ("CREATE_REPORT_FORMAT", element_name) == 0)
-          {
-            create_report_format_start (gmp_parser, attribute_names,
+            case CLIENT_AUTHENTICATE:
+              {
+                const gchar* attribute;
+
+                free_credentials (&current_credentials);
+                authenticate_session
+                 = find_attribute (attribute_names, attribute_values,
+                                   "session", &attribute)
+                   && strcmp (attribute, "0");
+                if (find_attribute (attribute_names, attribute_values,
+                                    "compress", &attribute)
+                    && strcmp (attribute, ""))
+                  authenticate_compress = strcasecmp (attribute, "gzip") ? -1 : 1;
+                else
+                  authenticate_compress = 0;
+                set_client_state (CLIENT_AUTHENTICATE);
+              }
+              break;
+            case CLIENT_BATCH:
+              batch_start ();
+              set_client_state (CLIENT_BATCH);
+              break;
+            case CLIENT_CREATE_ASSET:
+              set_client_state (CLIENT_CREATE_ASSET);
+              break;
+            case CLIENT_CREATE_CONFIG:
+              {
+                create_config_start (gmp_parser, attribute_names,
+                                     attribute_values);
+                set_client_state (CLIENT_CREATE_CONFIG);
+              }
+              break;
+            case CLIENT_CREATE_ALERT:
+              {
+                create_alert_data->condition_data = make_array ();
+                create_alert_data->event_data = make_array ();
+                create_alert_data->method_data = make_array ();
+
+                gvm_append_string (&create_alert_data->part_data, "");
+                gvm_append_string (&create_alert_data->part_name, "");
+                gvm_append_string (&create_alert_data->comment, "");
+                gvm_append_string (&create_alert_data->name, "");
+                gvm_append_string (&create_alert_data->condition, "");
+                gvm_append_string (&create_alert_data->method, "");
+                gvm_append_string (&create_alert_data->event, "");
+
+                set_client_state (CLIENT_CREATE_ALERT);
+              }
+              break;
+            case CLIENT_CREATE_CREDENTIAL:
+              {
+                gvm_append_string (&create_credential_data->comment, "");
+                gvm_append_string (&create_credential_data->name, "");
+                set_client_state (CLIENT_CREATE_CREDENTIAL);
+              }
+              break;
+            case CLIENT_CREATE_FILTER:
+              {
+                gvm_append_string (&create_filter_data->comment, "");
+                gvm_append_string (&create_filter_data->term, "");
+                set_client_state (CLIENT_CREATE_FILTER);
+              }
+              break;
+            case CLIENT_CREATE_GROUP:
+              {
+                gvm_append_string (&create_group_data->users, "");
+                set_client_state (CLIENT_CREATE_GROUP);
+              }
+              break;
+            case CLIENT_CREATE_ROLE:
+              {
+                gvm_append_string (&create_role_data->users, "");
+                set_client_state (CLIENT_CREATE_ROLE);
+              }
+              break;
+            case CLIENT_CREATE_NOTE:
+              set_client_state (CLIENT_CREATE_NOTE);
+              break;
+            case CLIENT_CREATE_OVERRIDE:
+              set_client_state (CLIENT_CREATE_OVERRIDE);
+              break;
+            case CLIENT_CREATE_PORT_LIST:
+              {
+                create_port_list_start (gmp_parser, attribute_names,
                                         attribute_values);
-            set_client_state (CLIENT_CREATE_REPORT_FORMAT);
-          }
-        else if (strcasecmp ("CREATE_SCANNER", element_name) == 0)
-          set_client_state (CLIENT_CREATE_SCANNER);
-        else if (strcasecmp ("CREATE_SCHEDULE", element_name) == 0)
-          set_client_state (CLIENT_CREATE_SCHEDULE);
-        else if (strcasecmp ("CREATE_TAG", element_name) == 0)
-          {
-            create_tag_data->resource_ids = NULL;
-            set_client_state (CLIENT_CREATE_TAG);
-          }
-        else if (strcasecmp ("CREATE_TARGET", element_name) == 0)
-          {
-            gvm_append_string (&create_target_data->comment, "");
-            set_client_state (CLIENT_CREATE_TARGET);
-          }
-        else if (strcasecmp ("CREATE_TASK", element_name) == 0)
-          {
-            create_task_data->task = make_task (NULL, NULL, 1, 1);
-            create_task_data->alerts = make_array ();
-            create_task_data->groups = make_array ();
-            set_client_state (CLIENT_CREATE_TASK);
-          }
-        else if (strcasecmp ("CREATE_TICKET", element_name) == 0)
-          {
-            create_ticket_start (gmp_parser, attribute_names,
-                                 attribute_values);
-            set_client_state (CLIENT_CREATE_TICKET);
-          }
-        else if (strcasecmp ("CREATE_TLS_CERTIFICATE", element_name) == 0)
-          {
-            create_tls_certificate_start (gmp_parser, attribute_names,
-                                          attribute_values);
-            set_client_state (CLIENT_CREATE_TLS_CERTIFICATE);
-          }
-        else if (strcasecmp ("CREATE_USER", element_name) == 0)
-          {
-            set_client_state (CLIENT_CREATE_USER);
-            create_user_data->groups = make_array ();
-            create_user_data->roles = make_array ();
-            create_user_data->hosts_allow = 0;
-            create_user_data->ifaces_allow = 0;
-          }
-        else if (strcasecmp ("DELETE_ASSET", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "asset_id",
-                              &delete_asset_data->asset_id);
-            append_attribute (attribute_names, attribute_values, "report_id",
-                              &delete_asset_data->report_id);
-            set_client_state (CLIENT_DELETE_ASSET);
-          }
-        else if (strcasecmp ("DELETE_CONFIG", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values,
-                              "config_id", &delete_config_data->config_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_config_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_config_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_CONFIG);
-          }
-        else if (strcasecmp ("DELETE_ALERT", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values,
-                              "alert_id",
-                              &delete_alert_data->alert_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_alert_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_alert_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_ALERT);
-          }
-        else if (strcasecmp ("DELETE_CREDENTIAL", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values,
-                              "credential_id",
-                              &delete_credential_data->credential_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_credential_data->ultimate
-               = strcmp (attribute, "0");
-            else
-              delete_credential_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_CREDENTIAL);
-          }
-        else if (strcasecmp ("DELETE_FILTER", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "filter_id",
-                              &delete_filter_data->filter_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_filter_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_filter_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_FILTER);
-          }
-        else if (strcasecmp ("DELETE_GROUP", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "group_id",
-                              &delete_group_data->group_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_group_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_group_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_GROUP);
-          }
-        else if (strcasecmp ("DELETE_NOTE", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "note_id",
-                              &delete_note_data->note_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_note_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_note_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_NOTE);
-          }
-        else if (strcasecmp ("DELETE_OVERRIDE", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "override_id",
-                              &delete_override_data->override_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_override_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_override_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_OVERRIDE);
-          }
-        else if (strcasecmp ("DELETE_PERMISSION", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values,
-                              "permission_id",
-                              &delete_permission_data->permission_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_permission_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_permission_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_PERMISSION);
-          }
-        else if (strcasecmp ("DELETE_PORT_LIST", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "port_list_id",
-                              &delete_port_list_data->port_list_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_port_list_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_port_list_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_PORT_LIST);
-          }
-        else if (strcasecmp ("DELETE_PORT_RANGE", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "port_range_id",
-                              &delete_port_range_data->port_range_id);
-            set_client_state (CLIENT_DELETE_PORT_RANGE);
-          }
-        else if (strcasecmp ("DELETE_REPORT", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "report_id",
-                              &delete_report_data->report_id);
-            set_client_state (CLIENT_DELETE_REPORT);
-          }
-        else if (strcasecmp ("DELETE_REPORT_FORMAT", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "report_format_id",
-                              &delete_report_format_data->report_format_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_report_format_data->ultimate = strcmp (attribute,
-                                                            "0");
-            else
-              delete_report_format_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_REPORT_FORMAT);
-          }
-        else if (strcasecmp ("DELETE_ROLE", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "role_id",
-                              &delete_role_data->role_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_role_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_role_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_ROLE);
-          }
-        else if (strcasecmp ("DELETE_SCANNER", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values,
-                              "scanner_id", &delete_scanner_data->scanner_id);
-            if (find_attribute (attribute_names, attribute_values, "ultimate",
-                                &attribute))
-              delete_scanner_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_scanner_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_SCANNER);
-          }
-        else if (strcasecmp ("DELETE_SCHEDULE", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "schedule_id",
-                              &delete_schedule_data->schedule_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_schedule_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_schedule_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_SCHEDULE);
-          }
-        else if (strcasecmp ("DELETE_TAG", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "tag_id",
-                              &delete_tag_data->tag_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_tag_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_tag_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_TAG);
-          }
-        else if (strcasecmp ("DELETE_TARGET", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "target_id",
-                              &delete_target_data->target_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_target_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_target_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_TARGET);
-          }
-        else if (strcasecmp ("DELETE_TASK", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "task_id",
-                              &delete_task_data->task_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_task_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_task_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_TASK);
-          }
-        else if (strcasecmp ("DELETE_TICKET", element_name) == 0)
-          {
-            delete_start ("ticket", "Ticket",
-                          attribute_names, attribute_values);
-            set_client_state (CLIENT_DELETE_TICKET);
-          }
-        else if (strcasecmp ("DELETE_TLS_CERTIFICATE", element_name) == 0)
-          {
-            delete_start ("tls_certificate", "TLS Certificate",
-                          attribute_names, attribute_values);
-            set_client_state (CLIENT_DELETE_TLS_CERTIFICATE);
-          }
-        else if (strcasecmp ("DELETE_USER", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "name",
-                              &delete_user_data->name);
-            append_attribute (attribute_names, attribute_values, "user_id",
-                              &delete_user_data->user_id);
-            append_attribute (attribute_names, attribute_values,
-                              "inheritor_id",
-                              &delete_user_data->inheritor_id);
-            append_attribute (attribute_names, attribute_values,
-                              "inheritor_name",
-                              &delete_user_data->inheritor_name);
-            if (find_attribute (attribute_names, attribute_values,
-                                "ultimate", &attribute))
-              delete_user_data->ultimate = strcmp (attribute, "0");
-            else
-              delete_user_data->ultimate = 0;
-            set_client_state (CLIENT_DELETE_USER);
-          }
-        else if (strcasecmp ("DESCRIBE_AUTH", element_name) == 0)
-          set_client_state (CLIENT_DESCRIBE_AUTH);
-        else if (strcasecmp ("EMPTY_TRASHCAN", element_name) == 0)
-          set_client_state (CLIENT_EMPTY_TRASHCAN);
-        else if (strcasecmp ("GET_AGGREGATES", element_name) == 0)
-          {
-            gchar *data_column = g_strdup ("");
-            sort_data_t *sort_data;
-            const gchar *attribute;
-            int sort_order_given;
-
-            sort_data = g_malloc0 (sizeof (sort_data_t));
-            sort_data->field = g_strdup ("");
-            sort_data->stat = g_strdup ("");
-
-            append_attribute (attribute_names, attribute_values, "type",
-                              &get_aggregates_data->type);
-
-            if (get_aggregates_data->type
-                && strcasecmp (get_aggregates_data->type, "info") == 0)
-            {
-              append_attribute (attribute_names, attribute_values, "info_type",
-                                &get_aggregates_data->subtype);
-            }
-
-            append_attribute (attribute_names, attribute_values, "data_column",
-                              &data_column);
-            get_aggregates_data->data_columns
-              = g_list_append (get_aggregates_data->data_columns,
-                               data_column);
-
-            append_attribute (attribute_names, attribute_values, "group_column",
-                              &get_aggregates_data->group_column);
-
-            append_attribute (attribute_names, attribute_values,
-                              "subgroup_column",
-                              &get_aggregates_data->subgroup_column);
-
-            append_attribute (attribute_names, attribute_values, "sort_field",
-                              &(sort_data->field));
-            append_attribute (attribute_names, attribute_values, "sort_stat",
-                              &(sort_data->stat));
-            if (find_attribute (attribute_names, attribute_values,
-                                "sort_order", &attribute))
+                set_client_state (CLIENT_CREATE_PORT_LIST);
+              }
+              break;
+            case CLIENT_CREATE_PORT_RANGE:
+              set_client_state (CLIENT_CREATE_PORT_RANGE);
+              break;
+            case CLIENT_CREATE_PERMISSION:
               {
-                sort_data->order = strcmp (attribute, "descending");
-                sort_order_given = 1;
+                gvm_append_string (&create_permission_data->comment, "");
+                set_client_state (CLIENT_CREATE_PERMISSION);
               }
-            else
+              break;
+            case CLIENT_CREATE_REPORT:
+              set_client_state (CLIENT_CREATE_REPORT);
+              break;
+            case CLIENT_CREATE_REPORT_FORMAT:
               {
-                sort_data->order = 1;
-                sort_order_given = 0;
+                create_report_format_start (gmp_parser, attribute_names,
+                                            attribute_values);
+                set_client_state (CLIENT_CREATE_REPORT_FORMAT);
               }
-
-            if (strcmp (sort_data->field, "") || sort_order_given)
+              break;
+            case CLIENT_CREATE_SCANNER:
+              set_client_state (CLIENT_CREATE_SCANNER);
+              break;
+            case CLIENT_CREATE_SCHEDULE:
+              set_client_state (CLIENT_CREATE_SCHEDULE);
+              break;
+            case CLIENT_CREATE_TAG:
               {
-                get_aggregates_data->sort_data
-                  = g_list_append (get_aggregates_data->sort_data,
-                                  sort_data);
+                create_tag_data->resource_ids = NULL;
+                set_client_state (CLIENT_CREATE_TAG);
               }
+              break;
+            case CLIENT_CREATE_TARGET:
+              {
+                gvm_append_string (&create_target_data->comment, "");
+                set_client_state (CLIENT_CREATE_TARGET);
+              }
+              break;
+            case CLIENT_CREATE_TASK:
+              {
+                create_task_data->task = make_task (NULL, NULL, 1, 1);
+                create_task_data->alerts = make_array ();
+                create_task_data->groups = make_array ();
+                set_client_state (CLIENT_CREATE_TASK);
+              }
+              break;
+            case CLIENT_CREATE_TICKET:
+              {
+                create_ticket_start (gmp_parser, attribute_names,
+                                     attribute_values);
+                set_client_state (CLIENT_CREATE_TICKET);
+              }
+              break;
+            case CLIENT_CREATE_TLS_CERTIFICATE:
+              {
+                create_tls_certificate_start (gmp_parser, attribute_names,
+                                              attribute_values);
+                set_client_state (CLIENT_CREATE_TLS_CERTIFICATE);
+              }
+              break;
+            case CLIENT_CREATE_USER:
+              {
+                set_client_state (CLIENT_CREATE_USER);
+                create_user_data->groups = make_array ();
+                create_user_data->roles = make_array ();
+                create_user_data->hosts_allow = 0;
+                create_user_data->ifaces_allow = 0;
+              }
+              break;
+            case CLIENT_DELETE_ASSET:
+              {
+                append_attribute (attribute_names, attribute_values, "asset_id",
+                                  &delete_asset_data->asset_id);
+                append_attribute (attribute_names, attribute_values, "report_id",
+                                  &delete_asset_data->report_id);
+                set_client_state (CLIENT_DELETE_ASSET);
+              }
+              break;
+            case CLIENT_DELETE_CONFIG:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values,
+                                  "config_id", &delete_config_data->config_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_config_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_config_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_CONFIG);
+              }
+              break;
+            case CLIENT_DELETE_ALERT:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values,
+                                  "alert_id",
+                                  &delete_alert_data->alert_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_alert_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_alert_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_ALERT);
+              }
+              break;
+            case CLIENT_DELETE_CREDENTIAL:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values,
+                                  "credential_id",
+                                  &delete_credential_data->credential_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_credential_data->ultimate
+                   = strcmp (attribute, "0");
+                else
+                  delete_credential_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_CREDENTIAL);
+              }
+              break;
+            case CLIENT_DELETE_FILTER:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "filter_id",
+                                  &delete_filter_data->filter_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_filter_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_filter_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_FILTER);
+              }
+              break;
+            case CLIENT_DELETE_GROUP:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "group_id",
+                                  &delete_group_data->group_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_group_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_group_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_GROUP);
+              }
+              break;
+            case CLIENT_DELETE_NOTE:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "note_id",
+                                  &delete_note_data->note_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_note_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_note_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_NOTE);
+              }
+              break;
+            case CLIENT_DELETE_OVERRIDE:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "override_id",
+                                  &delete_override_data->override_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_override_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_override_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_OVERRIDE);
+              }
+              break;
+            case CLIENT_DELETE_PERMISSION:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values,
+                                  "permission_id",
+                                  &delete_permission_data->permission_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_permission_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_permission_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_PERMISSION);
+              }
+              break;
+            case CLIENT_DELETE_PORT_LIST:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "port_list_id",
+                                  &delete_port_list_data->port_list_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_port_list_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_port_list_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_PORT_LIST);
+              }
+              break;
+            case CLIENT_DELETE_PORT_RANGE:
+              {
+                append_attribute (attribute_names, attribute_values, "port_range_id",
+                                  &delete_port_range_data->port_range_id);
+                set_client_state (CLIENT_DELETE_PORT_RANGE);
+              }
+              break;
+            case CLIENT_DELETE_REPORT:
+              {
+                append_attribute (attribute_names, attribute_values, "report_id",
+                                  &delete_report_data->report_id);
+                set_client_state (CLIENT_DELETE_REPORT);
+              }
+              break;
+            case CLIENT_DELETE_REPORT_FORMAT:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "report_format_id",
+                                  &delete_report_format_data->report_format_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_report_format_data->ultimate = strcmp (attribute,
+                                                                "0");
+                else
+                  delete_report_format_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_REPORT_FORMAT);
+              }
+              break;
+            case CLIENT_DELETE_ROLE:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "role_id",
+                                  &delete_role_data->role_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_role_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_role_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_ROLE);
+              }
+              break;
+            case CLIENT_DELETE_SCANNER:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values,
+                                  "scanner_id", &delete_scanner_data->scanner_id);
+                if (find_attribute (attribute_names, attribute_values, "ultimate",
+                                    &attribute))
+                  delete_scanner_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_scanner_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_SCANNER);
+              }
+              break;
+            case CLIENT_DELETE_SCHEDULE:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "schedule_id",
+                                  &delete_schedule_data->schedule_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_schedule_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_schedule_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_SCHEDULE);
+              }
+              break;
+            case CLIENT_DELETE_TAG:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "tag_id",
+                                  &delete_tag_data->tag_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_tag_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_tag_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_TAG);
+              }
+              break;
+            case CLIENT_DELETE_TARGET:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "target_id",
+                                  &delete_target_data->target_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_target_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_target_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_TARGET);
+              }
+              break;
+            case CLIENT_DELETE_TASK:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "task_id",
+                                  &delete_task_data->task_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_task_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_task_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_TASK);
+              }
+              break;
+            case CLIENT_DELETE_TICKET:
+              {
+                delete_start ("ticket", "Ticket",
+                              attribute_names, attribute_values);
+                set_client_state (CLIENT_DELETE_TICKET);
+              }
+              break;
+            case CLIENT_DELETE_TLS_CERTIFICATE:
+              {
+                delete_start ("tls_certificate", "TLS Certificate",
+                              attribute_names, attribute_values);
+                set_client_state (CLIENT_DELETE_TLS_CERTIFICATE);
+              }
+              break;
+            case CLIENT_DELETE_USER:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "name",
+                                  &delete_user_data->name);
+                append_attribute (attribute_names, attribute_values, "user_id",
+                                  &delete_user_data->user_id);
+                append_attribute (attribute_names, attribute_values,
+                                  "inheritor_id",
+                                  &delete_user_data->inheritor_id);
+                append_attribute (attribute_names, attribute_values,
+                                  "inheritor_name",
+                                  &delete_user_data->inheritor_name);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ultimate", &attribute))
+                  delete_user_data->ultimate = strcmp (attribute, "0");
+                else
+                  delete_user_data->ultimate = 0;
+                set_client_state (CLIENT_DELETE_USER);
+              }
+              break;
+            case CLIENT_DESCRIBE_AUTH:
+              set_client_state (CLIENT_DESCRIBE_AUTH);
+              break;
+            case CLIENT_EMPTY_TRASHCAN:
+              set_client_state (CLIENT_EMPTY_TRASHCAN);
+              break;
+            case CLIENT_GET_AGGREGATES:
+              {
+                gchar *data_column = g_strdup ("");
+                sort_data_t *sort_data;
+                const gchar *attribute;
+                int sort_order_given;
 
-            append_attribute (attribute_names, attribute_values, "mode",
-                              &get_aggregates_data->mode);
-
-            if (find_attribute (attribute_names, attribute_values,
-                                "first_group", &attribute))
-              get_aggregates_data->first_group = atoi (attribute) - 1;
-            else
-              get_aggregates_data->first_group = 0;
-
-            if (find_attribute (attribute_names, attribute_values,
-                                "max_groups", &attribute))
-              get_aggregates_data->max_groups = atoi (attribute);
-            else
-              get_aggregates_data->max_groups = -1;
-
-            get_data_parse_attributes (&get_aggregates_data->get,
-                                       get_aggregates_data->type
-                                        ? get_aggregates_data->type
-                                        : "",
-                                       attribute_names,
-                                       attribute_values);
+                sort_data = g_malloc0 (sizeof (sort_data_t));
+                sort_data->field = g_strdup ("");
+                sort_data->stat = g_strdup ("");
 
-            // get_aggregates ignores pagination by default
-            if (find_attribute (attribute_names, attribute_values,
-                                "ignore_pagination", &attribute) == 0)
-              get_aggregates_data->get.ignore_pagination = 1;
+                append_attribute (attribute_names, attribute_values, "type",
+                                  &get_aggregates_data->type);
 
-            // Extra selection attribute for configs and tasks
-            if (find_attribute (attribute_names, attribute_values,
-                                "usage_type", &attribute))
-              {
-                get_data_set_extra (&get_aggregates_data->get,
-                                    "usage_type",
-                                    attribute);
-              }
+                if (get_aggregates_data->type
+                    && strcasecmp (get_aggregates_data->type, "info") == 0)
+                {
+                  append_attribute (attribute_names, attribute_values, "info_type",
+                                    &get_aggregates_data->subtype);
+                }
 
-            set_client_state (CLIENT_GET_AGGREGATES);
-          }
-        else if (strcasecmp ("GET_CONFIGS", element_name) == 0)
-          {
-            const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "data_column",
+                                  &data_column);
+                get_aggregates_data->data_columns
+                  = g_list_append (get_aggregates_data->data_columns,
+                                   data_column);
+
+                append_attribute (attribute_names, attribute_values, "group_column",
+                                  &get_aggregates_data->group_column);
+
+                append_attribute (attribute_names, attribute_values,
+                                  "subgroup_column",
+                                  &get_aggregates_data->subgroup_column);
+
+                append_attribute (attribute_names, attribute_values, "sort_field",
+                                  &(sort_data->field));
+                append_attribute (attribute_names, attribute_values, "sort_stat",
+                                  &(sort_data->stat));
+                if (find_attribute (attribute_names, attribute_values,
+                                    "sort_order", &attribute))
+                  {
+                    sort_data->order = strcmp (attribute, "descending");
+                    sort_order_given = 1;
+                  }
+                else
+                  {
+                    sort_data->order = 1;
+                    sort_order_given = 0;
+                  }
 
-            get_data_parse_attributes (&get_configs_data->get,
-                                       "config",
-                                       attribute_names,
-                                       attribute_values);
+                if (strcmp (sort_data->field, "") || sort_order_given)
+                  {
+                    get_aggregates_data->sort_data
+                      = g_list_append (get_aggregates_data->sort_data,
+                                      sort_data);
+                  }
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "tasks", &attribute))
-              get_configs_data->tasks = strcmp (attribute, "0");
-            else
-              get_configs_data->tasks = 0;
+                append_attribute (attribute_names, attribute_values, "mode",
+                                  &get_aggregates_data->mode);
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "families", &attribute))
-              get_configs_data->families = strcmp (attribute, "0");
-            else
-              get_configs_data->families = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "first_group", &attribute))
+                  get_aggregates_data->first_group = atoi (attribute) - 1;
+                else
+                  get_aggregates_data->first_group = 0;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "preferences", &attribute))
-              get_configs_data->preferences = strcmp (attribute, "0");
-            else
-              get_configs_data->preferences = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "max_groups", &attribute))
+                  get_aggregates_data->max_groups = atoi (attribute);
+                else
+                  get_aggregates_data->max_groups = -1;
+
+                get_data_parse_attributes (&get_aggregates_data->get,
+                                           get_aggregates_data->type
+                                            ? get_aggregates_data->type
+                                            : "",
+                                           attribute_names,
+                                           attribute_values);
+
+                // get_aggregates ignores pagination by default
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ignore_pagination", &attribute) == 0)
+                  get_aggregates_data->get.ignore_pagination = 1;
+
+                // Extra selection attribute for configs and tasks
+                if (find_attribute (attribute_names, attribute_values,
+                                    "usage_type", &attribute))
+                  {
+                    get_data_set_extra (&get_aggregates_data->get,
+                                        "usage_type",
+                                        attribute);
+                  }
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "usage_type", &attribute))
-              {
-                get_data_set_extra (&get_configs_data->get,
-                                    "usage_type",
-                                    attribute);
+                set_client_state (CLIENT_GET_AGGREGATES);
               }
+              break;
+            case CLIENT_GET_CONFIGS:
+              {
+                const gchar* attribute;
 
-            set_client_state (CLIENT_GET_CONFIGS);
-          }
-        else if (strcasecmp ("GET_ALERTS", element_name) == 0)
-          {
-            const gchar* attribute;
+                get_data_parse_attributes (&get_configs_data->get,
+                                           "config",
+                                           attribute_names,
+                                           attribute_values);
 
-            get_data_parse_attributes (&get_alerts_data->get,
-                                       "alert",
-                                       attribute_names,
-                                       attribute_values);
-            if (find_attribute (attribute_names, attribute_values,
-                                "tasks", &attribute))
-              get_alerts_data->tasks = strcmp (attribute, "0");
-            else
-              get_alerts_data->tasks = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "tasks", &attribute))
+                  get_configs_data->tasks = strcmp (attribute, "0");
+                else
+                  get_configs_data->tasks = 0;
 
-            set_client_state (CLIENT_GET_ALERTS);
-          }
-        else if (strcasecmp ("GET_ASSETS", element_name) == 0)
-          {
-            const gchar* typebuf;
-            get_data_parse_attributes (&get_assets_data->get, "asset",
-                                       attribute_names,
-                                       attribute_values);
-            if (find_attribute (attribute_names, attribute_values,
-                                "type", &typebuf))
-              get_assets_data->type = g_ascii_strdown (typebuf, -1);
-            set_client_state (CLIENT_GET_ASSETS);
-          }
-        else if (strcasecmp ("GET_CREDENTIALS", element_name) == 0)
-          {
-            const gchar* attribute;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "families", &attribute))
+                  get_configs_data->families = strcmp (attribute, "0");
+                else
+                  get_configs_data->families = 0;
 
-            get_data_parse_attributes (&get_credentials_data->get,
-                                       "credential",
-                                       attribute_names,
-                                       attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "preferences", &attribute))
+                  get_configs_data->preferences = strcmp (attribute, "0");
+                else
+                  get_configs_data->preferences = 0;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "scanners", &attribute))
-              get_credentials_data->scanners = strcmp (attribute, "0");
-            else
-              get_credentials_data->scanners = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "usage_type", &attribute))
+                  {
+                    get_data_set_extra (&get_configs_data->get,
+                                        "usage_type",
+                                        attribute);
+                  }
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "targets", &attribute))
-              get_credentials_data->targets = strcmp (attribute, "0");
-            else
-              get_credentials_data->targets = 0;
+                set_client_state (CLIENT_GET_CONFIGS);
+              }
+              break;
+            case CLIENT_GET_ALERTS:
+              {
+                const gchar* attribute;
+
+                get_data_parse_attributes (&get_alerts_data->get,
+                                           "alert",
+                                           attribute_names,
+                                           attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "tasks", &attribute))
+                  get_alerts_data->tasks = strcmp (attribute, "0");
+                else
+                  get_alerts_data->tasks = 0;
 
-            append_attribute (attribute_names, attribute_values, "format",
-                              &get_credentials_data->format);
-            set_client_state (CLIENT_GET_CREDENTIALS);
-          }
-        else if (strcasecmp ("GET_FEEDS", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "type",
-                              &get_feeds_data->type);
-            set_client_state (CLIENT_GET_FEEDS);
-          }
-        else if (strcasecmp ("GET_FILTERS", element_name) == 0)
-          {
-            const gchar* attribute;
-            get_data_parse_attributes (&get_filters_data->get, "filter",
-                                       attribute_names,
-                                       attribute_values);
-            if (find_attribute (attribute_names, attribute_values,
-                                "alerts", &attribute))
-              get_filters_data->alerts = strcmp (attribute, "0");
-            else
-              get_filters_data->alerts = 0;
-            set_client_state (CLIENT_GET_FILTERS);
-          }
-        else if (strcasecmp ("GET_GROUPS", element_name) == 0)
-          {
-            get_data_parse_attributes (&get_groups_data->get, "group",
-                                       attribute_names,
-                                       attribute_values);
-            set_client_state (CLIENT_GET_GROUPS);
-          }
-        else if (strcasecmp ("GET_NOTES", element_name) == 0)
-          {
-            const gchar* attribute;
+                set_client_state (CLIENT_GET_ALERTS);
+              }
+              break;
+            case CLIENT_GET_ASSETS:
+              {
+                const gchar* typebuf;
+                get_data_parse_attributes (&get_assets_data->get, "asset",
+                                           attribute_names,
+                                           attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "type", &typebuf))
+                  get_assets_data->type = g_ascii_strdown (typebuf, -1);
+                set_client_state (CLIENT_GET_ASSETS);
+              }
+              break;
+            case CLIENT_GET_CREDENTIALS:
+              {
+                const gchar* attribute;
 
-            get_data_parse_attributes (&get_notes_data->get, "note",
-                                       attribute_names,
-                                       attribute_values);
+                get_data_parse_attributes (&get_credentials_data->get,
+                                           "credential",
+                                           attribute_names,
+                                           attribute_values);
 
-            append_attribute (attribute_names, attribute_values, "note_id",
-                              &get_notes_data->note_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "scanners", &attribute))
+                  get_credentials_data->scanners = strcmp (attribute, "0");
+                else
+                  get_credentials_data->scanners = 0;
 
-            append_attribute (attribute_names, attribute_values, "nvt_oid",
-                              &get_notes_data->nvt_oid);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "targets", &attribute))
+                  get_credentials_data->targets = strcmp (attribute, "0");
+                else
+                  get_credentials_data->targets = 0;
 
-            append_attribute (attribute_names, attribute_values, "task_id",
-                              &get_notes_data->task_id);
+                append_attribute (attribute_names, attribute_values, "format",
+                                  &get_credentials_data->format);
+                set_client_state (CLIENT_GET_CREDENTIALS);
+              }
+              break;
+            case CLIENT_GET_FEEDS:
+              {
+                append_attribute (attribute_names, attribute_values, "type",
+                                  &get_feeds_data->type);
+                set_client_state (CLIENT_GET_FEEDS);
+              }
+              break;
+            case CLIENT_GET_FILTERS:
+              {
+                const gchar* attribute;
+                get_data_parse_attributes (&get_filters_data->get, "filter",
+                                           attribute_names,
+                                           attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "alerts", &attribute))
+                  get_filters_data->alerts = strcmp (attribute, "0");
+                else
+                  get_filters_data->alerts = 0;
+                set_client_state (CLIENT_GET_FILTERS);
+              }
+              break;
+            case CLIENT_GET_GROUPS:
+              {
+                get_data_parse_attributes (&get_groups_data->get, "group",
+                                           attribute_names,
+                                           attribute_values);
+                set_client_state (CLIENT_GET_GROUPS);
+              }
+              break;
+            case CLIENT_GET_NOTES:
+              {
+                const gchar* attribute;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "result", &attribute))
-              get_notes_data->result = strcmp (attribute, "0");
-            else
-              get_notes_data->result = 0;
+                get_data_parse_attributes (&get_notes_data->get, "note",
+                                           attribute_names,
+                                           attribute_values);
 
-            set_client_state (CLIENT_GET_NOTES);
-          }
-        else if (strcasecmp ("GET_NVTS", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "nvt_oid",
-                              &get_nvts_data->nvt_oid);
-            append_attribute (attribute_names, attribute_values, "config_id",
-                              &get_nvts_data->config_id);
-            append_attribute (attribute_names, attribute_values,
-                              "preferences_config_id",
-                              &get_nvts_data->preferences_config_id);
-            if (find_attribute (attribute_names, attribute_values,
-                                "details", &attribute))
-              get_nvts_data->details = strcmp (attribute, "0");
-            else
-              get_nvts_data->details = 0;
-            append_attribute (attribute_names, attribute_values, "family",
-                              &get_nvts_data->family);
-            if (find_attribute (attribute_names, attribute_values,
-                                "preferences", &attribute))
-              get_nvts_data->preferences = strcmp (attribute, "0");
-            else
-              get_nvts_data->preferences = 0;
-            if (find_attribute (attribute_names, attribute_values,
-                                "preference_count", &attribute))
-              get_nvts_data->preference_count = strcmp (attribute, "0");
-            else
-              get_nvts_data->preference_count = 0;
-            if (find_attribute (attribute_names, attribute_values,
-                                "timeout", &attribute))
-              get_nvts_data->timeout = strcmp (attribute, "0");
-            else
-              get_nvts_data->timeout = 0;
-            append_attribute (attribute_names, attribute_values, "sort_field",
-                              &get_nvts_data->sort_field);
-            if (find_attribute (attribute_names, attribute_values,
-                                "sort_order", &attribute))
-              get_nvts_data->sort_order = strcmp (attribute,
-                                                         "descending");
-            else
-              get_nvts_data->sort_order = 1;
-            set_client_state (CLIENT_GET_NVTS);
-          }
-        else if (strcasecmp ("GET_NVT_FAMILIES", element_name) == 0)
-          {
-            const gchar* attribute;
-            if (find_attribute (attribute_names, attribute_values,
-                                "sort_order", &attribute))
-              get_nvt_families_data->sort_order = strcmp (attribute,
-                                                          "descending");
-            else
-              get_nvt_families_data->sort_order = 1;
-            set_client_state (CLIENT_GET_NVT_FAMILIES);
-          }
-        else if (strcasecmp ("GET_OVERRIDES", element_name) == 0)
-          {
-            const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "note_id",
+                                  &get_notes_data->note_id);
 
-            get_data_parse_attributes (&get_overrides_data->get, "override",
-                                       attribute_names,
-                                       attribute_values);
+                append_attribute (attribute_names, attribute_values, "nvt_oid",
+                                  &get_notes_data->nvt_oid);
 
-            append_attribute (attribute_names, attribute_values, "override_id",
-                              &get_overrides_data->override_id);
+                append_attribute (attribute_names, attribute_values, "task_id",
+                                  &get_notes_data->task_id);
 
-            append_attribute (attribute_names, attribute_values, "nvt_oid",
-                              &get_overrides_data->nvt_oid);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "result", &attribute))
+                  get_notes_data->result = strcmp (attribute, "0");
+                else
+                  get_notes_data->result = 0;
 
-            append_attribute (attribute_names, attribute_values, "task_id",
-                              &get_overrides_data->task_id);
+                set_client_state (CLIENT_GET_NOTES);
+              }
+              break;
+            case CLIENT_GET_NVTS:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "nvt_oid",
+                                  &get_nvts_data->nvt_oid);
+                append_attribute (attribute_names, attribute_values, "config_id",
+                                  &get_nvts_data->config_id);
+                append_attribute (attribute_names, attribute_values,
+                                  "preferences_config_id",
+                                  &get_nvts_data->preferences_config_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "details", &attribute))
+                  get_nvts_data->details = strcmp (attribute, "0");
+                else
+                  get_nvts_data->details = 0;
+                append_attribute (attribute_names, attribute_values, "family",
+                                  &get_nvts_data->family);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "preferences", &attribute))
+                  get_nvts_data->preferences = strcmp (attribute, "0");
+                else
+                  get_nvts_data->preferences = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "preference_count", &attribute))
+                  get_nvts_data->preference_count = strcmp (attribute, "0");
+                else
+                  get_nvts_data->preference_count = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "timeout", &attribute))
+                  get_nvts_data->timeout = strcmp (attribute, "0");
+                else
+                  get_nvts_data->timeout = 0;
+                append_attribute (attribute_names, attribute_values, "sort_field",
+                                  &get_nvts_data->sort_field);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "sort_order", &attribute))
+                  get_nvts_data->sort_order = strcmp (attribute,
+                                                             "descending");
+                else
+                  get_nvts_data->sort_order = 1;
+                set_client_state (CLIENT_GET_NVTS);
+              }
+              break;
+            case CLIENT_GET_NVT_FAMILIES:
+              {
+                const gchar* attribute;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "sort_order", &attribute))
+                  get_nvt_families_data->sort_order = strcmp (attribute,
+                                                              "descending");
+                else
+                  get_nvt_families_data->sort_order = 1;
+                set_client_state (CLIENT_GET_NVT_FAMILIES);
+              }
+              break;
+            case CLIENT_GET_OVERRIDES:
+              {
+                const gchar* attribute;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "result", &attribute))
-              get_overrides_data->result = strcmp (attribute, "0");
-            else
-              get_overrides_data->result = 0;
+                get_data_parse_attributes (&get_overrides_data->get, "override",
+                                           attribute_names,
+                                           attribute_values);
+
+                append_attribute (attribute_names, attribute_values, "override_id",
+                                  &get_overrides_data->override_id);
 
-            set_client_state (CLIENT_GET_OVERRIDES);
-          }
-        else if (strcasecmp ("GET_PORT_LISTS", element_name) == 0)
-          {
-            const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "nvt_oid",
+                                  &get_overrides_data->nvt_oid);
 
-            get_data_parse_attributes (&get_port_lists_data->get,
-                                       "port_list",
-                                       attribute_names,
-                                       attribute_values);
-            if (find_attribute (attribute_names, attribute_values,
-                                "targets", &attribute))
-              get_port_lists_data->targets = strcmp (attribute, "0");
-            else
-              get_port_lists_data->targets = 0;
-            set_client_state (CLIENT_GET_PORT_LISTS);
-          }
-        else if (strcasecmp ("GET_PERMISSIONS", element_name) == 0)
-          {
-            get_data_parse_attributes (&get_permissions_data->get, "permission",
-                                       attribute_names,
-                                       attribute_values);
-            append_attribute (attribute_names, attribute_values, "resource_id",
-                              &get_permissions_data->resource_id);
-            set_client_state (CLIENT_GET_PERMISSIONS);
-          }
-        else if (strcasecmp ("GET_PREFERENCES", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "nvt_oid",
-                              &get_preferences_data->nvt_oid);
-            append_attribute (attribute_names, attribute_values, "config_id",
-                              &get_preferences_data->config_id);
-            append_attribute (attribute_names, attribute_values, "preference",
-                              &get_preferences_data->preference);
-            set_client_state (CLIENT_GET_PREFERENCES);
-          }
-        else if (strcasecmp ("GET_REPORTS", element_name) == 0)
-          {
-            const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "task_id",
+                                  &get_overrides_data->task_id);
 
-            get_data_parse_attributes (&get_reports_data->get, "report",
-                                       attribute_names,
-                                       attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "result", &attribute))
+                  get_overrides_data->result = strcmp (attribute, "0");
+                else
+                  get_overrides_data->result = 0;
 
-            get_data_parse_attributes (&get_reports_data->report_get, "report",
-                                       attribute_names,
-                                       attribute_values);
+                set_client_state (CLIENT_GET_OVERRIDES);
+              }
+              break;
+            case CLIENT_GET_PORT_LISTS:
+              {
+                const gchar* attribute;
 
-            g_free (get_reports_data->report_get.filt_id);
-            get_reports_data->report_get.filt_id = NULL;
-            append_attribute (attribute_names, attribute_values,
-                              "report_filt_id",
-                              &get_reports_data->report_get.filt_id);
+                get_data_parse_attributes (&get_port_lists_data->get,
+                                           "port_list",
+                                           attribute_names,
+                                           attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "targets", &attribute))
+                  get_port_lists_data->targets = strcmp (attribute, "0");
+                else
+                  get_port_lists_data->targets = 0;
+                set_client_state (CLIENT_GET_PORT_LISTS);
+              }
+              break;
+            case CLIENT_GET_PERMISSIONS:
+              {
+                get_data_parse_attributes (&get_permissions_data->get, "permission",
+                                           attribute_names,
+                                           attribute_values);
+                append_attribute (attribute_names, attribute_values, "resource_id",
+                                  &get_permissions_data->resource_id);
+                set_client_state (CLIENT_GET_PERMISSIONS);
+              }
+              break;
+            case CLIENT_GET_PREFERENCES:
+              {
+                append_attribute (attribute_names, attribute_values, "nvt_oid",
+                                  &get_preferences_data->nvt_oid);
+                append_attribute (attribute_names, attribute_values, "config_id",
+                                  &get_preferences_data->config_id);
+                append_attribute (attribute_names, attribute_values, "preference",
+                                  &get_preferences_data->preference);
+                set_client_state (CLIENT_GET_PREFERENCES);
+              }
+              break;
+            case CLIENT_GET_REPORTS:
+              {
+                const gchar* attribute;
 
-            g_free (get_reports_data->report_get.filter);
-            get_reports_data->report_get.filter = NULL;
-            append_attribute (attribute_names, attribute_values,
-                              "report_filter",
-                              &get_reports_data->report_get.filter);
+                get_data_parse_attributes (&get_reports_data->get, "report",
+                                           attribute_names,
+                                           attribute_values);
 
-            append_attribute (attribute_names, attribute_values, "report_id",
-                              &get_reports_data->report_id);
+                get_data_parse_attributes (&get_reports_data->report_get, "report",
+                                           attribute_names,
+                                           attribute_values);
 
-            append_attribute (attribute_names, attribute_values,
-                              "delta_report_id",
-                              &get_reports_data->delta_report_id);
+                g_free (get_reports_data->report_get.filt_id);
+                get_reports_data->report_get.filt_id = NULL;
+                append_attribute (attribute_names, attribute_values,
+                                  "report_filt_id",
+                                  &get_reports_data->report_get.filt_id);
 
-            append_attribute (attribute_names, attribute_values, "alert_id",
-                              &get_reports_data->alert_id);
+                g_free (get_reports_data->report_get.filter);
+                get_reports_data->report_get.filter = NULL;
+                append_attribute (attribute_names, attribute_values,
+                                  "report_filter",
+                                  &get_reports_data->report_get.filter);
 
-            append_attribute (attribute_names, attribute_values, "format_id",
-                              &get_reports_data->format_id);
+                append_attribute (attribute_names, attribute_values, "report_id",
+                                  &get_reports_data->report_id);
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "lean", &attribute))
-              get_reports_data->lean = atoi (attribute);
-            else
-              get_reports_data->lean = 0;
+                append_attribute (attribute_names, attribute_values,
+                                  "delta_report_id",
+                                  &get_reports_data->delta_report_id);
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "notes_details", &attribute))
-              get_reports_data->notes_details = strcmp (attribute, "0");
-            else
-              get_reports_data->notes_details = 0;
+                append_attribute (attribute_names, attribute_values, "alert_id",
+                                  &get_reports_data->alert_id);
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "overrides_details", &attribute))
-              get_reports_data->overrides_details = strcmp (attribute, "0");
-            else
-              get_reports_data->overrides_details = 0;
+                append_attribute (attribute_names, attribute_values, "format_id",
+                                  &get_reports_data->format_id);
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "result_tags", &attribute))
-              get_reports_data->result_tags = strcmp (attribute, "0");
-            else
-              get_reports_data->result_tags = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "lean", &attribute))
+                  get_reports_data->lean = atoi (attribute);
+                else
+                  get_reports_data->lean = 0;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "ignore_pagination", &attribute))
-              get_reports_data->ignore_pagination = atoi (attribute);
-            else
-              get_reports_data->ignore_pagination = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "notes_details", &attribute))
+                  get_reports_data->notes_details = strcmp (attribute, "0");
+                else
+                  get_reports_data->notes_details = 0;
 
-            set_client_state (CLIENT_GET_REPORTS);
-          }
-        else if (strcasecmp ("GET_REPORT_FORMATS", element_name) == 0)
-          {
-            const gchar* attribute;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "overrides_details", &attribute))
+                  get_reports_data->overrides_details = strcmp (attribute, "0");
+                else
+                  get_reports_data->overrides_details = 0;
 
-            get_data_parse_attributes (&get_report_formats_data->get,
-                                       "report_format",
-                                       attribute_names,
-                                       attribute_values);
-            if (find_attribute (attribute_names, attribute_values,
-                                "alerts", &attribute))
-              get_report_formats_data->alerts = strcmp (attribute, "0");
-            else
-              get_report_formats_data->alerts = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "result_tags", &attribute))
+                  get_reports_data->result_tags = strcmp (attribute, "0");
+                else
+                  get_reports_data->result_tags = 0;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "params", &attribute))
-              get_report_formats_data->params = strcmp (attribute, "0");
-            else
-              get_report_formats_data->params = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "ignore_pagination", &attribute))
+                  get_reports_data->ignore_pagination = atoi (attribute);
+                else
+                  get_reports_data->ignore_pagination = 0;
 
-            set_client_state (CLIENT_GET_REPORT_FORMATS);
-          }
-        else if (strcasecmp ("GET_RESULTS", element_name) == 0)
-          {
-            const gchar* attribute;
-            get_data_parse_attributes (&get_results_data->get,
-                                       "result",
-                                       attribute_names,
-                                       attribute_values);
+                set_client_state (CLIENT_GET_REPORTS);
+              }
+              break;
+            case CLIENT_GET_REPORT_FORMATS:
+              {
+                const gchar* attribute;
+
+                get_data_parse_attributes (&get_report_formats_data->get,
+                                           "report_format",
+                                           attribute_names,
+                                           attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "alerts", &attribute))
+                  get_report_formats_data->alerts = strcmp (attribute, "0");
+                else
+                  get_report_formats_data->alerts = 0;
 
-            append_attribute (attribute_names, attribute_values, "task_id",
-                              &get_results_data->task_id);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "params", &attribute))
+                  get_report_formats_data->params = strcmp (attribute, "0");
+                else
+                  get_report_formats_data->params = 0;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "notes_details", &attribute))
-              get_results_data->notes_details = strcmp (attribute, "0");
-            else
-              get_results_data->notes_details = 0;
+                set_client_state (CLIENT_GET_REPORT_FORMATS);
+              }
+              break;
+            case CLIENT_GET_RESULTS:
+              {
+                const gchar* attribute;
+                get_data_parse_attributes (&get_results_data->get,
+                                           "result",
+                                           attribute_names,
+                                           attribute_values);
+
+                append_attribute (attribute_names, attribute_values, "task_id",
+                                  &get_results_data->task_id);
+
+                if (find_attribute (attribute_names, attribute_values,
+                                    "notes_details", &attribute))
+                  get_results_data->notes_details = strcmp (attribute, "0");
+                else
+                  get_results_data->notes_details = 0;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "overrides_details", &attribute))
-              get_results_data->overrides_details = strcmp (attribute, "0");
-            else
-              get_results_data->overrides_details = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "overrides_details", &attribute))
+                  get_results_data->overrides_details = strcmp (attribute, "0");
+                else
+                  get_results_data->overrides_details = 0;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "get_counts", &attribute))
-              get_results_data->get_counts = strcmp (attribute, "0");
-            else
-              get_results_data->get_counts = 1;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "get_counts", &attribute))
+                  get_results_data->get_counts = strcmp (attribute, "0");
+                else
+                  get_results_data->get_counts = 1;
 
-            set_client_state (CLIENT_GET_RESULTS);
-          }
-        else if (strcasecmp ("GET_ROLES", element_name) == 0)
-          {
-            get_data_parse_attributes (&get_roles_data->get, "role",
-                                       attribute_names,
-                                       attribute_values);
-            set_client_state (CLIENT_GET_ROLES);
-          }
-        else if (strcasecmp ("GET_SCANNERS", element_name) == 0)
-          {
-            get_data_parse_attributes (&get_scanners_data->get, "scanner",
-                                       attribute_names, attribute_values);
-            set_client_state (CLIENT_GET_SCANNERS);
-          }
-        else if (strcasecmp ("GET_SCHEDULES", element_name) == 0)
-          {
-            const gchar *attribute;
-            get_data_parse_attributes (&get_schedules_data->get, "schedule",
-                                       attribute_names,
-                                       attribute_values);
-            if (find_attribute (attribute_names, attribute_values,
-                                "tasks", &attribute))
-              get_schedules_data->tasks = strcmp (attribute, "0");
-            else
-              get_schedules_data->tasks = 0;
-            set_client_state (CLIENT_GET_SCHEDULES);
-          }
-        else if (strcasecmp ("GET_SETTINGS", element_name) == 0)
-          {
-            const gchar* attribute;
+                set_client_state (CLIENT_GET_RESULTS);
+              }
+              break;
+            case CLIENT_GET_ROLES:
+              {
+                get_data_parse_attributes (&get_roles_data->get, "role",
+                                           attribute_names,
+                                           attribute_values);
+                set_client_state (CLIENT_GET_ROLES);
+              }
+              break;
+            case CLIENT_GET_SCANNERS:
+              {
+                get_data_parse_attributes (&get_scanners_data->get, "scanner",
+                                           attribute_names, attribute_values);
+                set_client_state (CLIENT_GET_SCANNERS);
+              }
+              break;
+            case CLIENT_GET_SCHEDULES:
+              {
+                const gchar *attribute;
+                get_data_parse_attributes (&get_schedules_data->get, "schedule",
+                                           attribute_names,
+                                           attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "tasks", &attribute))
+                  get_schedules_data->tasks = strcmp (attribute, "0");
+                else
+                  get_schedules_data->tasks = 0;
+                set_client_state (CLIENT_GET_SCHEDULES);
+              }
+              break;
+            case CLIENT_GET_SETTINGS:
+              {
+                const gchar* attribute;
 
-            append_attribute (attribute_names, attribute_values, "setting_id",
-                              &get_settings_data->setting_id);
+                append_attribute (attribute_names, attribute_values, "setting_id",
+                                  &get_settings_data->setting_id);
 
-            append_attribute (attribute_names, attribute_values, "filter",
-                              &get_settings_data->filter);
+                append_attribute (attribute_names, attribute_values, "filter",
+                                  &get_settings_data->filter);
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "first", &attribute))
-              /* Subtract 1 to switch from 1 to 0 indexing. */
-              get_settings_data->first = atoi (attribute) - 1;
-            else
-              get_settings_data->first = 0;
-            if (get_settings_data->first < 0)
-              get_settings_data->first = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "first", &attribute))
+                  /* Subtract 1 to switch from 1 to 0 indexing. */
+                  get_settings_data->first = atoi (attribute) - 1;
+                else
+                  get_settings_data->first = 0;
+                if (get_settings_data->first < 0)
+                  get_settings_data->first = 0;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "max", &attribute))
-              get_settings_data->max = atoi (attribute);
-            else
-              get_settings_data->max = -1;
-            if (get_settings_data->max < 1)
-              get_settings_data->max = -1;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "max", &attribute))
+                  get_settings_data->max = atoi (attribute);
+                else
+                  get_settings_data->max = -1;
+                if (get_settings_data->max < 1)
+                  get_settings_data->max = -1;
 
-            append_attribute (attribute_names, attribute_values, "sort_field",
-                              &get_settings_data->sort_field);
+                append_attribute (attribute_names, attribute_values, "sort_field",
+                                  &get_settings_data->sort_field);
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "sort_order", &attribute))
-              get_settings_data->sort_order = strcmp (attribute, "descending");
-            else
-              get_settings_data->sort_order = 1;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "sort_order", &attribute))
+                  get_settings_data->sort_order = strcmp (attribute, "descending");
+                else
+                  get_settings_data->sort_order = 1;
 
-            set_client_state (CLIENT_GET_SETTINGS);
-          }
-        else if (strcasecmp ("GET_TAGS", element_name) == 0)
-          {
-            const gchar* attribute;
-            get_data_parse_attributes (&get_tags_data->get, "tag",
-                                       attribute_names,
-                                       attribute_values);
+                set_client_state (CLIENT_GET_SETTINGS);
+              }
+              break;
+            case CLIENT_GET_TAGS:
+              {
+                const gchar* attribute;
+                get_data_parse_attributes (&get_tags_data->get, "tag",
+                                           attribute_names,
+                                           attribute_values);
+
+                if (find_attribute (attribute_names, attribute_values,
+                                    "names_only", &attribute))
+                  get_tags_data->names_only = strcmp (attribute, "0");
+                else
+                  get_tags_data->names_only = 0;
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "names_only", &attribute))
-              get_tags_data->names_only = strcmp (attribute, "0");
-            else
-              get_tags_data->names_only = 0;
+                set_client_state (CLIENT_GET_TAGS);
+              }
+              break;
+            case CLIENT_GET_SYSTEM_REPORTS:
+              {
+                const gchar* attribute;
+                append_attribute (attribute_names, attribute_values, "name",
+                                  &get_system_reports_data->name);
+                append_attribute (attribute_names, attribute_values, "duration",
+                                  &get_system_reports_data->duration);
+                append_attribute (attribute_names, attribute_values, "end_time",
+                                  &get_system_reports_data->end_time);
+                append_attribute (attribute_names, attribute_values, "slave_id",
+                                  &get_system_reports_data->slave_id);
+                append_attribute (attribute_names, attribute_values, "start_time",
+                                  &get_system_reports_data->start_time);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "brief", &attribute))
+                  get_system_reports_data->brief = strcmp (attribute, "0");
+                else
+                  get_system_reports_data->brief = 0;
+                set_client_state (CLIENT_GET_SYSTEM_REPORTS);
+              }
+              break;
+            case CLIENT_GET_TARGETS:
+              {
+                const gchar *attribute;
+                get_data_parse_attributes (&get_targets_data->get, "target",
+                                           attribute_names,
+                                           attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "tasks", &attribute))
+                  get_targets_data->tasks = strcmp (attribute, "0");
+                else
+                  get_targets_data->tasks = 0;
+                set_client_state (CLIENT_GET_TARGETS);
+              }
+              break;
+            case CLIENT_GET_TASKS:
+              {
+                const gchar *attribute;
+                get_data_parse_attributes (&get_tasks_data->get, "task",
+                                           attribute_names,
+                                           attribute_values);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "schedules_only", &attribute))
+                  get_tasks_data->schedules_only = strcmp (attribute, "0");
+                else
+                  get_tasks_data->schedules_only = 0;
 
-            set_client_state (CLIENT_GET_TAGS);
-          }
-        else if (strcasecmp ("GET_SYSTEM_REPORTS", element_name) == 0)
-          {
-            const gchar* attribute;
-            append_attribute (attribute_names, attribute_values, "name",
-                              &get_system_reports_data->name);
-            append_attribute (attribute_names, attribute_values, "duration",
-                              &get_system_reports_data->duration);
-            append_attribute (attribute_names, attribute_values, "end_time",
-                              &get_system_reports_data->end_time);
-            append_attribute (attribute_names, attribute_values, "slave_id",
-                              &get_system_reports_data->slave_id);
-            append_attribute (attribute_names, attribute_values, "start_time",
-                              &get_system_reports_data->start_time);
-            if (find_attribute (attribute_names, attribute_values,
-                                "brief", &attribute))
-              get_system_reports_data->brief = strcmp (attribute, "0");
-            else
-              get_system_reports_data->brief = 0;
-            set_client_state (CLIENT_GET_SYSTEM_REPORTS);
-          }
-        else if (strcasecmp ("GET_TARGETS", element_name) == 0)
-          {
-            const gchar *attribute;
-            get_data_parse_attributes (&get_targets_data->get, "target",
-                                       attribute_names,
-                                       attribute_values);
-            if (find_attribute (attribute_names, attribute_values,
-                                "tasks", &attribute))
-              get_targets_data->tasks = strcmp (attribute, "0");
-            else
-              get_targets_data->tasks = 0;
-            set_client_state (CLIENT_GET_TARGETS);
-          }
-        else if (strcasecmp ("GET_TASKS", element_name) == 0)
-          {
-            const gchar *attribute;
-            get_data_parse_attributes (&get_tasks_data->get, "task",
-                                       attribute_names,
-                                       attribute_values);
-            if (find_attribute (attribute_names, attribute_values,
-                                "schedules_only", &attribute))
-              get_tasks_data->schedules_only = strcmp (attribute, "0");
-            else
-              get_tasks_data->schedules_only = 0;
+                if (find_attribute (attribute_names, attribute_values,
+                                    "usage_type", &attribute))
+                  {
+                    get_data_set_extra (&get_tasks_data->get,
+                                        "usage_type",
+                                        attribute);
+                  }
 
-            if (find_attribute (attribute_names, attribute_values,
-                                "usage_type", &attribute))
+                set_client_state (CLIENT_GET_TASKS);
+              }
+            ELSE_GET_START (tickets, TICKETS)
+            ELSE_GET_START (tls_certificates, TLS_CERTIFICATES)
+              break;
+            case CLIENT_GET_USERS:
+              {
+                get_data_parse_attributes (&get_users_data->get, "user",
+                                           attribute_names,
+                                           attribute_values);
+                set_client_state (CLIENT_GET_USERS);
+              }
+              break;
+            case CLIENT_GET_INFO:
+              {
+                const gchar* attribute;
+                const gchar* typebuf;
+                get_data_parse_attributes (&get_info_data->get, "info",
+                                           attribute_names,
+                                           attribute_values);
+                append_attribute (attribute_names, attribute_values, "name",
+                                  &get_info_data->name);
+                if (find_attribute (attribute_names, attribute_values,
+                                    "details", &attribute))
+                  get_info_data->details = strcmp (attribute, "0");
+                else
+                  get_info_data->details = 0;
+
+                if (find_attribute (attribute_names, attribute_values,
+                                    "type", &typebuf))
+                  get_info_data->type = g_ascii_strdown (typebuf, -1);
+                set_client_state (CLIENT_GET_INFO);
+              }
+              break;
+            case CLIENT_GET_VERSION_AUTHENTIC:
+              set_client_state (CLIENT_GET_VERSION_AUTHENTIC);
+              break;
+            case CLIENT_GET_VULNS:
+              {
+                get_data_parse_attributes (&get_vulns_data->get, "vuln",
+                                           attribute_names,
+                                           attribute_values);
+                set_client_state (CLIENT_GET_VULNS);
+              }
+              break;
+            case CLIENT_HELP:
+              {
+                append_attribute (attribute_names, attribute_values, "format",
+                                  &help_data->format);
+                append_attribute (attribute_names, attribute_values, "type",
+                                  &help_data->type);
+                set_client_state (CLIENT_HELP);
+              }
+              break;
+            case CLIENT_LOGOUT:
+              set_client_state (CLIENT_LOGOUT);
+              break;
+            case CLIENT_MODIFY_ALERT:
+              {
+                modify_alert_data->event_data = make_array ();
+
+                gvm_append_string (&modify_alert_data->part_data, "");
+                gvm_append_string (&modify_alert_data->part_name, "");
+                gvm_append_string (&modify_alert_data->event, "");
+                modify_alert_data->condition_data = make_array ();
+                gvm_append_string (&modify_alert_data->condition, "");
+                modify_alert_data->method_data = make_array ();
+                gvm_append_string (&modify_alert_data->method, "");
+
+                append_attribute (attribute_names, attribute_values, "alert_id",
+                                  &modify_alert_data->alert_id);
+                set_client_state (CLIENT_MODIFY_ALERT);
+              }
+              break;
+            case CLIENT_MODIFY_ASSET:
+              {
+                append_attribute (attribute_names, attribute_values, "asset_id",
+                                  &modify_asset_data->asset_id);
+                set_client_state (CLIENT_MODIFY_ASSET);
+              }
+              break;
+            case CLIENT_MODIFY_AUTH:
+              set_client_state (CLIENT_MODIFY_AUTH);
+              break;
+            case CLIENT_MODIFY_CONFIG:
+              {
+                modify_config_start (gmp_parser, attribute_names,
+                                     attribute_values);
+                set_client_state (CLIENT_MODIFY_CONFIG);
+              }
+              break;
+            case CLIENT_MODIFY_CREDENTIAL:
+              {
+                append_attribute (attribute_names, attribute_values,
+                                  "credential_id",
+                                  &modify_credential_data->credential_id);
+                set_client_state (CLIENT_MODIFY_CREDENTIAL);
+              }
+              break;
+            case CLIENT_MODIFY_FILTER:
+              {
+                append_attribute (attribute_names, attribute_values, "filter_id",
+                                  &modify_filter_data->filter_id);
+                set_client_state (CLIENT_MODIFY_FILTER);
+              }
+              break;
+            case CLIENT_MODIFY_GROUP:
+              {
+                append_attribute (attribute_names, attribute_values, "group_id",
+                                  &modify_group_data->group_id);
+                set_client_state (CLIENT_MODIFY_GROUP);
+              }
+              break;
+            case CLIENT_MODIFY_PORT_LIST:
+              {
+                append_attribute (attribute_names, attribute_values,
+                                  "port_list_id",
+                                  &modify_port_list_data->port_list_id);
+                set_client_state (CLIENT_MODIFY_PORT_LIST);
+              }
+              break;
+            case CLIENT_MODIFY_NOTE:
+              {
+                append_attribute (attribute_names, attribute_values, "note_id",
+                                  &modify_note_data->note_id);
+                set_client_state (CLIENT_MODIFY_NOTE);
+              }
+              break;
+            case CLIENT_MODIFY_OVERRIDE:
+              {
+                append_attribute (attribute_names, attribute_values, "override_id",
+                                  &modify_override_data->override_id);
+                set_client_state (CLIENT_MODIFY_OVERRIDE);
+              }
+              break;
+            case CLIENT_MODIFY_PERMISSION:
+              {
+                append_attribute (attribute_names, attribute_values,
+                                  "permission_id",
+                                  &modify_permission_data->permission_id);
+                set_client_state (CLIENT_MODIFY_PERMISSION);
+              }
+              break;
+            case CLIENT_MODIFY_REPORT_FORMAT:
+              {
+                append_attribute (attribute_names, attribute_values,
+                                  "report_format_id",
+                                  &modify_report_format_data->report_format_id);
+                set_client_state (CLIENT_MODIFY_REPORT_FORMAT);
+              }
+              break;
+            case CLIENT_MODIFY_ROLE:
+              {
+                append_attribute (attribute_names, attribute_values, "role_id",
+                                  &modify_role_data->role_id);
+                set_client_state (CLIENT_MODIFY_ROLE);
+              }
+              break;
+            case CLIENT_MODIFY_SCANNER:
+              {
+                append_attribute (attribute_names, attribute_values, "scanner_id",
+                                  &modify_scanner_data->scanner_id);
+                set_client_state (CLIENT_MODIFY_SCANNER);
+              }
+              break;
+            case CLIENT_MODIFY_SCHEDULE:
+              {
+                append_attribute (attribute_names, attribute_values, "schedule_id",
+                                  &modify_schedule_data->schedule_id);
+                set_client_state (CLIENT_MODIFY_SCHEDULE);
+              }
+              break;
+            case CLIENT_MODIFY_SETTING:
+              {
+                append_attribute (attribute_names, attribute_values,
+                                  "setting_id",
+                                  &modify_setting_data->setting_id);
+                set_client_state (CLIENT_MODIFY_SETTING);
+              }
+              break;
+            case CLIENT_MODIFY_TAG:
+              {
+                modify_tag_data->resource_ids = NULL;
+                append_attribute (attribute_names, attribute_values, "tag_id",
+                                  &modify_tag_data->tag_id);
+                set_client_state (CLIENT_MODIFY_TAG);
+              }
+              break;
+            case CLIENT_MODIFY_TARGET:
+              {
+                append_attribute (attribute_names, attribute_values, "target_id",
+                                  &modify_target_data->target_id);
+                set_client_state (CLIENT_MODIFY_TARGET);
+              }
+              break;
+            case CLIENT_MODIFY_TASK:
+              {
+                append_attribute (attribute_names, attribute_values, "task_id",
+                                  &modify_task_data->task_id);
+                modify_task_data->alerts = make_array ();
+                modify_task_data->groups = make_array ();
+                set_client_state (CLIENT_MODIFY_TASK);
+              }
+              break;
+            case CLIENT_MODIFY_TICKET:
+              {
+                modify_ticket_start (gmp_parser, attribute_names,
+                                     attribute_values);
+                set_client_state (CLIENT_MODIFY_TICKET);
+              }
+              break;
+            case CLIENT_MODIFY_TLS_CERTIFICATE:
+              {
+                modify_tls_certificate_start (gmp_parser, attribute_names,
+                                              attribute_values);
+                set_client_state (CLIENT_MODIFY_TLS_CERTIFICATE);
+              }
+              break;
+            case CLIENT_MODIFY_USER:
+              {
+                append_attribute (attribute_names, attribute_values, "user_id",
+                                  &modify_user_data->user_id);
+                set_client_state (CLIENT_MODIFY_USER);
+              }
+              break;
+            case CLIENT_MOVE_TASK:
+              {
+                append_attribute (attribute_names, attribute_values, "task_id",
+                                  &move_task_data->task_id);
+                append_attribute (attribute_names, attribute_values, "slave_id",
+                                  &move_task_data->slave_id);
+                set_client_state (CLIENT_MOVE_TASK);
+              }
+              break;
+            case CLIENT_RESTORE:
+              {
+                append_attribute (attribute_names, attribute_values, "id",
+                                  &restore_data->id);
+                set_client_state (CLIENT_RESTORE);
+              }
+              break;
+            case CLIENT_RESUME_TASK:
+              {
+                append_attribute (attribute_names, attribute_values, "task_id",
+                                  &resume_task_data->task_id);
+                set_client_state (CLIENT_RESUME_TASK);
+              }
+              break;
+            case CLIENT_RUN_WIZARD:
+              {
+                append_attribute (attribute_names, attribute_values, "name",
+                                  &run_wizard_data->name);
+                append_attribute (attribute_names, attribute_values, "read_only",
+                                  &run_wizard_data->read_only);
+                set_client_state (CLIENT_RUN_WIZARD);
+              }
+              break;
+            case CLIENT_START_TASK:
+              {
+                append_attribute (attribute_names, attribute_values, "task_id",
+                                  &start_task_data->task_id);
+                set_client_state (CLIENT_START_TASK);
+              }
+              break;
+            case CLIENT_STOP_TASK:
+              {
+                append_attribute (attribute_names, attribute_values, "task_id",
+                                  &stop_task_data->task_id);
+                set_client_state (CLIENT_STOP_TASK);
+              }
+              break;
+            case CLIENT_SYNC_CONFIG:
+              {
+                append_attribute (attribute_names, attribute_values, "config_id",
+                                  &sync_config_data->config_id);
+                set_client_state (CLIENT_SYNC_CONFIG);
+              }
+              break;
+            case CLIENT_TEST_ALERT:
+              {
+                append_attribute (attribute_names, attribute_values,
+                                  "alert_id",
+                                  &test_alert_data->alert_id);
+                set_client_state (CLIENT_TEST_ALERT);
+              }
+              break;
+            case CLIENT_VERIFY_REPORT_FORMAT:
               {
-                get_data_set_extra (&get_tasks_data->get,
-                                    "usage_type",
-                                    attribute);
+                append_attribute (attribute_names, attribute_values, "report_format_id",
+                                  &verify_report_format_data->report_format_id);
+                set_client_state (CLIENT_VERIFY_REPORT_FORMAT);
               }
-
-            set_client_state (CLIENT_GET_TASKS);
-          }
-        ELSE_GET_START (tickets, TICKETS)
-        ELSE_GET_START (tls_certificates, TLS_CERTIFICATES)
-        else if (strcasecmp ("GET_USERS", element_name) == 0)
-          {
-            get_data_parse_attributes (&get_users_data->get, "user",
-                                       attribute_names,
-                                       attribute_values);
-            set_client_state (CLIENT_GET_USERS);
-          }
-        else if (strcasecmp ("GET_INFO", element_name) == 0)
-          {
-            const gchar* attribute;
-            const gchar* typebuf;
-            get_data_parse_attributes (&get_info_data->get, "info",
-                                       attribute_names,
-                                       attribute_values);
-            append_attribute (attribute_names, attribute_values, "name",
-                              &get_info_data->name);
-            if (find_attribute (attribute_names, attribute_values,
-                                "details", &attribute))
-              get_info_data->details = strcmp (attribute, "0");
-            else
-              get_info_data->details = 0;
-
-            if (find_attribute (attribute_names, attribute_values,
-                                "type", &typebuf))
-              get_info_data->type = g_ascii_strdown (typebuf, -1);
-            set_client_state (CLIENT_GET_INFO);
-          }
-        else if (strcasecmp ("GET_VERSION", element_name) == 0)
-          set_client_state (CLIENT_GET_VERSION_AUTHENTIC);
-        else if (strcasecmp ("GET_VULNS", element_name) == 0)
-          {
-            get_data_parse_attributes (&get_vulns_data->get, "vuln",
-                                       attribute_names,
-                                       attribute_values);
-            set_client_state (CLIENT_GET_VULNS);
-          }
-        else if (strcasecmp ("HELP", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "format",
-                              &help_data->format);
-            append_attribute (attribute_names, attribute_values, "type",
-                              &help_data->type);
-            set_client_state (CLIENT_HELP);
-          }
-        else if (strcasecmp ("MODIFY_ALERT", element_name) == 0)
-          {
-            modify_alert_data->event_data = make_array ();
-
-            gvm_append_string (&modify_alert_data->part_data, "");
-            gvm_append_string (&modify_alert_data->part_name, "");
-            gvm_append_string (&modify_alert_data->event, "");
-            modify_alert_data->condition_data = make_array ();
-            gvm_append_string (&modify_alert_data->condition, "");
-            modify_alert_data->method_data = make_array ();
-            gvm_append_string (&modify_alert_data->method, "");
-
-            append_attribute (attribute_names, attribute_values, "alert_id",
-                              &modify_alert_data->alert_id);
-            set_client_state (CLIENT_MODIFY_ALERT);
-          }
-        else if (strcasecmp ("MODIFY_ASSET", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "asset_id",
-                              &modify_asset_data->asset_id);
-            set_client_state (CLIENT_MODIFY_ASSET);
-          }
-        else if (strcasecmp ("MODIFY_AUTH", element_name) == 0)
-          set_client_state (CLIENT_MODIFY_AUTH);
-        else if (strcasecmp ("MODIFY_CONFIG", element_name) == 0)
-          {
-            modify_config_start (gmp_parser, attribute_names,
-                                 attribute_values);
-            set_client_state (CLIENT_MODIFY_CONFIG);
-          }
-        else if (strcasecmp ("MODIFY_CREDENTIAL", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values,
-                              "credential_id",
-                              &modify_credential_data->credential_id);
-            set_client_state (CLIENT_MODIFY_CREDENTIAL);
-          }
-        else if (strcasecmp ("MODIFY_FILTER", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "filter_id",
-                              &modify_filter_data->filter_id);
-            set_client_state (CLIENT_MODIFY_FILTER);
-          }
-        else if (strcasecmp ("MODIFY_GROUP", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "group_id",
-                              &modify_group_data->group_id);
-            set_client_state (CLIENT_MODIFY_GROUP);
-          }
-        else if (strcasecmp ("MODIFY_PORT_LIST", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values,
-                              "port_list_id",
-                              &modify_port_list_data->port_list_id);
-            set_client_state (CLIENT_MODIFY_PORT_LIST);
-          }
-        else if (strcasecmp ("MODIFY_NOTE", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "note_id",
-                              &modify_note_data->note_id);
-            set_client_state (CLIENT_MODIFY_NOTE);
-          }
-        else if (strcasecmp ("MODIFY_OVERRIDE", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "override_id",
-                              &modify_override_data->override_id);
-            set_client_state (CLIENT_MODIFY_OVERRIDE);
-          }
-        else if (strcasecmp ("MODIFY_PERMISSION", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values,
-                              "permission_id",
-                              &modify_permission_data->permission_id);
-            set_client_state (CLIENT_MODIFY_PERMISSION);
-          }
-        else if (strcasecmp ("MODIFY_REPORT_FORMAT", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values,
-                              "report_format_id",
-                              &modify_report_format_data->report_format_id);
-            set_client_state (CLIENT_MODIFY_REPORT_FORMAT);
-          }
-        else if (strcasecmp ("MODIFY_ROLE", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "role_id",
-                              &modify_role_data->role_id);
-            set_client_state (CLIENT_MODIFY_ROLE);
-          }
-        else if (strcasecmp ("MODIFY_SCANNER", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "scanner_id",
-                              &modify_scanner_data->scanner_id);
-            set_client_state (CLIENT_MODIFY_SCANNER);
-          }
-        else if (strcasecmp ("MODIFY_SCHEDULE", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "schedule_id",
-                              &modify_schedule_data->schedule_id);
-            set_client_state (CLIENT_MODIFY_SCHEDULE);
-          }
-        else if (strcasecmp ("MODIFY_SETTING", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values,
-                              "setting_id",
-                              &modify_setting_data->setting_id);
-            set_client_state (CLIENT_MODIFY_SETTING);
-          }
-        else if (strcasecmp ("MODIFY_TAG", element_name) == 0)
-          {
-            modify_tag_data->resource_ids = NULL;
-            append_attribute (attribute_names, attribute_values, "tag_id",
-                              &modify_tag_data->tag_id);
-            set_client_state (CLIENT_MODIFY_TAG);
-          }
-        else if (strcasecmp ("MODIFY_TARGET", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "target_id",
-                              &modify_target_data->target_id);
-            set_client_state (CLIENT_MODIFY_TARGET);
-          }
-        else if (strcasecmp ("MODIFY_TASK", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "task_id",
-                              &modify_task_data->task_id);
-            modify_task_data->alerts = make_array ();
-            modify_task_data->groups = make_array ();
-            set_client_state (CLIENT_MODIFY_TASK);
-          }
-        else if (strcasecmp ("MODIFY_TICKET", element_name) == 0)
-          {
-            modify_ticket_start (gmp_parser, attribute_names,
-                                 attribute_values);
-            set_client_state (CLIENT_MODIFY_TICKET);
-          }
-        else if (strcasecmp ("MODIFY_TLS_CERTIFICATE", element_name) == 0)
-          {
-            modify_tls_certificate_start (gmp_parser, attribute_names,
-                                          attribute_values);
-            set_client_state (CLIENT_MODIFY_TLS_CERTIFICATE);
-          }
-        else if (strcasecmp ("MODIFY_USER", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "user_id",
-                              &modify_user_data->user_id);
-            set_client_state (CLIENT_MODIFY_USER);
-          }
-        else if (strcasecmp ("MOVE_TASK", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "task_id",
-                              &move_task_data->task_id);
-            append_attribute (attribute_names, attribute_values, "slave_id",
-                              &move_task_data->slave_id);
-            set_client_state (CLIENT_MOVE_TASK);
-          }
-        else if (strcasecmp ("RESTORE", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "id",
-                              &restore_data->id);
-            set_client_state (CLIENT_RESTORE);
-          }
-        else if (strcasecmp ("RESUME_TASK", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "task_id",
-                              &resume_task_data->task_id);
-            set_client_state (CLIENT_RESUME_TASK);
-          }
-        else if (strcasecmp ("RUN_WIZARD", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "name",
-                              &run_wizard_data->name);
-            append_attribute (attribute_names, attribute_values, "read_only",
-                              &run_wizard_data->read_only);
-            set_client_state (CLIENT_RUN_WIZARD);
-          }
-        else if (strcasecmp ("START_TASK", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "task_id",
-                              &start_task_data->task_id);
-            set_client_state (CLIENT_START_TASK);
-          }
-        else if (strcasecmp ("STOP_TASK", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "task_id",
-                              &stop_task_data->task_id);
-            set_client_state (CLIENT_STOP_TASK);
-          }
-        else if (strcasecmp ("SYNC_CONFIG", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "config_id",
-                              &sync_config_data->config_id);
-            set_client_state (CLIENT_SYNC_CONFIG);
-          }
-        else if (strcasecmp ("TEST_ALERT", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values,
-                              "alert_id",
-                              &test_alert_data->alert_id);
-            set_client_state (CLIENT_TEST_ALERT);
-          }
-        else if (strcasecmp ("VERIFY_REPORT_FORMAT", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "report_format_id",
-                              &verify_report_format_data->report_format_id);
-            set_client_state (CLIENT_VERIFY_REPORT_FORMAT);
-          }
-        else if (strcasecmp ("VERIFY_SCANNER", element_name) == 0)
-          {
-            append_attribute (attribute_names, attribute_values, "scanner_id",
-                              &verify_scanner_data->scanner_id);
-            set_client_state (CLIENT_VERIFY_SCANNER);
-          }
-        else
-          {
-            if (send_to_client (XML_ERROR_SYNTAX ("gmp", "Bogus command name"),
-                                write_to_client,
-                                write_to_client_data))
+              break;
+            case CLIENT_VERIFY_SCANNER:
               {
-                error_send_to_client (error);
-                return;
+                append_attribute (attribute_names, attribute_values, "scanner_id",
+                                  &verify_scanner_data->scanner_id);
+                set_client_state (CLIENT_VERIFY_SCANNER);
               }
-            g_set_error (error,
-                         G_MARKUP_ERROR,
-                         G_MARKUP_ERROR_UNKNOWN_ELEMENT,
-                         "Error");
+              break;
+            default:
+              {
+                if (send_to_client (XML_ERROR_SYNTAX ("gmp", "Bogus command name"),
+                                    write_to_client,
+                                    write_to_client_data))
+                  {
+                    error_send_to_client (error);
+                    return;
+                  }
+                g_set_error (error,
+                             G_MARKUP_ERROR,
+                             G_MARKUP_ERROR_UNKNOWN_ELEMENT,
+                             "Error");
+              }
+              break;
           }
         break;
 
@@ -5971,6 +6701,12 @@ gmp_xml_handle_start_element (/* unused */ GMarkupParseContext* context,
           set_client_state (CLIENT_AUTHENTICATE_CREDENTIALS_USERNAME);
         else if (strcasecmp ("PASSWORD", element_name) == 0)
           set_client_state (CLIENT_AUTHENTICATE_CREDENTIALS_PASSWORD);
+        else if (strcasecmp ("TOKEN", element_name) == 0)
+          {
+            gvm_free_string_var (&session_token);
+            gvm_append_string (&session_token, "");
+            set_client_state (CLIENT_AUTHENTICATE_CREDENTIALS_TOKEN);
+          }
         ELSE_READ_OVER;
 
       case CLIENT_CREATE_SCANNER:
@@ -6797,6 +7533,11 @@ gmp_xml_handle_start_element (/* unused */ GMarkupParseContext* context,
           set_client_state (CLIENT_CREATE_ASSET_REPORT_FILTER_TERM);
         ELSE_READ_OVER;
 
+      case CLIENT_BATCH:
+        batch_element_start (element_name, attribute_names,
+                             attribute_values);
+        break;
+
       case CLIENT_CREATE_CONFIG:
         create_config_element_start (gmp_parser, element_name,
                                      attribute_names,
@@ -7890,6 +8631,7 @@ gmp_xml_handle_start_element (/* unused */ GMarkupParseContext* context,
  * @param[in]  pref_count  Preference count.  Used if details is true.
  * @param[in]  timeout     Timeout.  Used if details is true.
  * @param[in]  config      Config, used if preferences is true.
+ * @param[in]  batch       Details of the page of NVTs, or NULL.
  * @param[in]  write_to_client       Function to write to client.
  * @param[in]  write_to_client_data  Argument to \p write_to_client.
  *
@@ -7897,14 +8639,14 @@ gmp_xml_handle_start_element (/* unused */ GMarkupParseContext* context,
  */
 static gboolean
 send_nvt (iterator_t *nvts, int details, int preferences, int pref_count,
-          const char *timeout, config_t config,
+          const char *timeout, config_t config, nvt_details_t *batch,
           int (*write_to_client) (const char *, void*),
           void* write_to_client_data)
 {
   gchar *msg;
 
   msg = get_nvt_xml (nvts, details, pref_count, preferences, timeout, config,
-                     0);
+                     0, batch);
   if (send_to_client (msg, write_to_client, write_to_client_data))
     {
       g_free (msg);
@@ -7914,6 +8656,119 @@ send_nvt (iterator_t *nvts, int details, int preferences, int pref_count,
   return FALSE;
 }
 
+/**
+ * @brief Collect the OIDs of the NVTs of an iterator.
+ *
+ * Runs the iterator to the end and cleans it up.
+ *
+ * @param[in]  nvts  NVT iterator.
+ *
+ * @return OIDs.  Free with g_ptr_array_free.
+ */
+static GPtrArray *
+nvt_iterator_oids (iterator_t *nvts)
+{
+  GPtrArray *oids;
+
+  oids = g_ptr_array_new_with_free_func (g_free);
+  while (next (nvts))
+    g_ptr_array_add (oids, g_strdup (nvt_iterator_oid (nvts)));
+  cleanup_iterator (nvts);
+  return oids;
+}
+
+/**
+ * @brief Add the XML of one CVE to a cross-reference hash table.
+ *
+ * @param[in]  table  Hash table of XML by CVE name.
+ * @param[in]  cve    CVE name.  Taken over by the table.
+ * @param[in]  xml    XML.  Taken over by the table.
+ */
+static void
+cve_cross_refs_add (GHashTable *table, gchar *cve, GString *xml)
+{
+  if (cve)
+    g_hash_table_insert (table, cve, g_string_free (xml, FALSE));
+}
+
+/**
+ * @brief Build the NVT and CERT cross-references of a page of CVEs.
+ *
+ * Runs the CVE iterator to the end and cleans it up.
+ *
+ * @param[in]   cves       CVE iterator.
+ * @param[out]  nvts       Hash table of "<nvt>" XML by CVE name.
+ * @param[out]  cert_refs  Hash table of "<cert_ref>" XML by CVE name, or NULL
+ *                         if the CERT database is not loaded.
+ */
+static void
+cve_cross_refs (iterator_t *cves, GHashTable **nvts, GHashTable **cert_refs)
+{
+  GPtrArray *names;
+  iterator_t refs;
+  GString *xml;
+  gchar *current;
+
+  names = g_ptr_array_new_with_free_func (g_free);
+  while (next (cves))
+    g_ptr_array_add (names, g_strdup (get_iterator_name (cves)));
+  cleanup_iterator (cves);
+
+  *nvts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  xml = NULL;
+  current = NULL;
+  init_cves_nvt_iterator (&refs, names);
+  while (next (&refs))
+    {
+      if (current == NULL || strcmp (current, cves_nvt_iterator_cve (&refs)))
+        {
+          cve_cross_refs_add (*nvts, current, xml);
+          current = g_strdup (cves_nvt_iterator_cve (&refs));
+          xml = g_string_new ("");
+        }
+      xml_string_append (xml,
+                         "<nvt oid=\"%s\">"
+                         "<name>%s</name>"
+                         "</nvt>",
+                         cves_nvt_iterator_oid (&refs),
+                         cves_nvt_iterator_name (&refs));
+    }
+  cleanup_iterator (&refs);
+  cve_cross_refs_add (*nvts, current, xml);
+
+  *cert_refs = NULL;
+  if (manage_cert_loaded ())
+    {
+      *cert_refs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                          g_free);
+      xml = NULL;
+      current = NULL;
+      init_cves_cert_adv_iterator (&refs, names);
+      while (next (&refs))
+        {
+          if (current == NULL
+              || strcmp (current, cves_cert_adv_iterator_cve (&refs)))
+            {
+              cve_cross_refs_add (*cert_refs, current, xml);
+              current = g_strdup (cves_cert_adv_iterator_cve (&refs));
+              xml = g_string_new ("");
+            }
+          xml_string_append (xml,
+                             "<cert_ref type=\"%s\">"
+                             "<name>%s</name>"
+                             "<title>%s</title>"
+                             "</cert_ref>",
+                             cves_cert_adv_iterator_type (&refs),
+                             cves_cert_adv_iterator_name (&refs),
+                             cves_cert_adv_iterator_title (&refs));
+        }
+      cleanup_iterator (&refs);
+      cve_cross_refs_add (*cert_refs, current, xml);
+    }
+
+  g_ptr_array_free (names, TRUE);
+}
+
 /**
  * @brief Convert \n's to real newline's.
  *
@@ -7978,7 +8833,7 @@ utf8_substring (const gchar *str, glong start_pos, glong end_pos)
 }
 
 /**
- * @brief Buffer XML for some notes.
+ * @brief Buffer XML for the current note of a notes iterator.
  *
  * @param[in]  buffer                 Buffer into which to buffer notes.
  * @param[in]  notes                  Notes iterator.
@@ -7987,256 +8842,551 @@ utf8_substring (const gchar *str, glong start_pos, glong end_pos)
  * @param[out] count                  Number of notes.
  */
 static void
-buffer_notes_xml (GString *buffer, iterator_t *notes, int include_notes_details,
-                  int include_result, int *count)
+buffer_note_xml (GString *buffer, iterator_t *notes, int include_notes_details,
+                 int include_result, int *count)
 {
-  while (next (notes))
-    {
-      int tag_count;
-      char *uuid_task, *uuid_result;
+  int tag_count;
+  char *uuid_task, *uuid_result;
 
-      tag_count = resource_tag_count ("note",
-                                      get_iterator_resource (notes),
-                                      1);
+  tag_count = resource_tag_count ("note",
+                                  get_iterator_resource (notes),
+                                  1);
 
-      if (count)
-        (*count)++;
+  if (count)
+    (*count)++;
 
-      if (note_iterator_task (notes))
-        task_uuid (note_iterator_task (notes),
-                   &uuid_task);
-      else
-        uuid_task = NULL;
+  if (note_iterator_task (notes))
+    task_uuid (note_iterator_task (notes),
+               &uuid_task);
+  else
+    uuid_task = NULL;
 
-      if (note_iterator_result (notes))
-        result_uuid (note_iterator_result (notes),
-                     &uuid_result);
-      else
-        uuid_result = NULL;
+  if (note_iterator_result (notes))
+    result_uuid (note_iterator_result (notes),
+                 &uuid_result);
+  else
+    uuid_result = NULL;
 
-      buffer_xml_append_printf (buffer,
-                                "<note id=\"%s\">"
-                                "<permissions>",
-                                get_iterator_uuid (notes));
-
-      if (/* The user is the owner. */
-          (current_credentials.username
-           && get_iterator_owner_name (notes)
-           && (strcmp (get_iterator_owner_name (notes),
-                       current_credentials.username)
-              == 0))
-          /* Or the user is effectively the owner. */
-          || acl_user_has_super (current_credentials.uuid,
-                                 get_iterator_owner (notes)))
+  buffer_xml_append_printf (buffer,
+                            "<note id=\"%s\">"
+                            "<permissions>",
+                            get_iterator_uuid (notes));
+
+  if (/* The user is the owner. */
+      (current_credentials.username
+       && get_iterator_owner_name (notes)
+       && (strcmp (get_iterator_owner_name (notes),
+                   current_credentials.username)
+          == 0))
+      /* Or the user is effectively the owner. */
+      || acl_user_has_super (current_credentials.uuid,
+                             get_iterator_owner (notes)))
+    buffer_xml_append_printf (buffer,
+                              "<permission><name>Everything</name></permission>"
+                              "</permissions>");
+  else
+    {
+      iterator_t perms;
+      get_data_t perms_get;
+
+      memset (&perms_get, '\0', sizeof (perms_get));
+      perms_get.filter = g_strdup_printf ("resource_uuid=%s"
+                                          " owner=any"
+                                          " permission=any",
+                                          get_iterator_uuid (notes));
+      init_permission_iterator (&perms, &perms_get);
+      g_free (perms_get.filter);
+      while (next (&perms))
         buffer_xml_append_printf (buffer,
-                                  "<permission><name>Everything</name></permission>"
-                                  "</permissions>");
+                                  "<permission><name>%s</name></permission>",
+                                  get_iterator_name (&perms));
+      cleanup_iterator (&perms);
+
+      buffer_xml_append_printf (buffer, "</permissions>");
+    }
+
+  if (include_notes_details == 0)
+    {
+      const char *text = note_iterator_text (notes);
+      gchar *excerpt = utf8_substring (text, 0, 60);
+      /* This must match send_get_common. */
+      buffer_xml_append_printf (buffer,
+                                "<owner><name>%s</name></owner>"
+                                "<nvt oid=\"%s\">"
+                                "<name>%s</name>"
+                                "<type>%s</type>"
+                                "</nvt>"
+                                "<creation_time>%s</creation_time>"
+                                "<modification_time>%s</modification_time>"
+                                "<writable>1</writable>"
+                                "<in_use>0</in_use>"
+                                "<active>%i</active>"
+                                "<text excerpt=\"%i\">%s</text>"
+                                "<orphan>%i</orphan>",
+                                get_iterator_owner_name (notes)
+                                 ? get_iterator_owner_name (notes)
+                                 : "",
+                                note_iterator_nvt_oid (notes),
+                                note_iterator_nvt_name (notes),
+                                note_iterator_nvt_type (notes),
+                                get_iterator_creation_time (notes),
+                                get_iterator_modification_time (notes),
+                                note_iterator_active (notes),
+                                strlen (excerpt) < strlen (text),
+                                excerpt,
+                                ((note_iterator_task (notes)
+                                  && (uuid_task == NULL))
+                                 || (note_iterator_result (notes)
+                                     && (uuid_result == NULL))));
+
+      if (tag_count)
+        {
+          buffer_xml_append_printf (buffer,
+                                    "<user_tags>"
+                                    "<count>%i</count>"
+                                    "</user_tags>",
+                                    tag_count);
+        }
+
+      g_string_append (buffer, "</note>");
+
+      g_free (excerpt);
+    }
+  else
+    {
+      char *name_task;
+      int trash_task;
+      time_t end_time;
+      iterator_t tags;
+
+      if (uuid_task)
+        {
+          name_task = task_name (note_iterator_task (notes));
+          trash_task = task_in_trash (note_iterator_task (notes));
+        }
       else
         {
-          iterator_t perms;
-          get_data_t perms_get;
-
-          memset (&perms_get, '\0', sizeof (perms_get));
-          perms_get.filter = g_strdup_printf ("resource_uuid=%s"
-                                              " owner=any"
-                                              " permission=any",
-                                              get_iterator_uuid (notes));
-          init_permission_iterator (&perms, &perms_get);
-          g_free (perms_get.filter);
-          while (next (&perms))
-            buffer_xml_append_printf (buffer,
-                                      "<permission><name>%s</name></permission>",
-                                      get_iterator_name (&perms));
-          cleanup_iterator (&perms);
-
-          buffer_xml_append_printf (buffer, "</permissions>");
+          name_task = NULL;
+          trash_task = 0;
         }
 
-      if (include_notes_details == 0)
+      end_time = note_iterator_end_time (notes);
+
+      /* This must match send_get_common. */
+      buffer_xml_append_printf
+       (buffer,
+        "<owner><name>%s</name></owner>"
+        "<nvt oid=\"%s\">"
+        "<name>%s</name>"
+        "<type>%s</type>"
+        "</nvt>"
+        "<creation_time>%s</creation_time>"
+        "<modification_time>%s</modification_time>"
+        "<writable>1</writable>"
+        "<in_use>0</in_use>"
+        "<active>%i</active>"
+        "<end_time>%s</end_time>"
+        "<text>%s</text>"
+        "<hosts>%s</hosts>"
+        "<port>%s</port>"
+        "<severity>%s</severity>"
+        "<task id=\"%s\"><name>%s</name><trash>%i</trash></task>"
+        "<orphan>%i</orphan>",
+        get_iterator_owner_name (notes)
+         ? get_iterator_owner_name (notes)
+         : "",
+        note_iterator_nvt_oid (notes),
+        note_iterator_nvt_name (notes),
+        note_iterator_nvt_type (notes),
+        get_iterator_creation_time (notes),
+        get_iterator_modification_time (notes),
+        note_iterator_active (notes),
+        end_time > 1 ? iso_time (&end_time) : "",
+        note_iterator_text (notes),
+        note_iterator_hosts (notes)
+         ? note_iterator_hosts (notes) : "",
+        note_iterator_port (notes)
+         ? note_iterator_port (notes) : "",
+        note_iterator_severity (notes)
+         ? note_iterator_severity (notes) : "",
+        uuid_task ? uuid_task : "",
+        name_task ? name_task : "",
+        trash_task,
+        ((note_iterator_task (notes) && (uuid_task == NULL))
+         || (note_iterator_result (notes) && (uuid_result == NULL))));
+
+      free (name_task);
+
+      if (include_result && uuid_result && note_iterator_result (notes))
+        {
+          iterator_t results;
+          get_data_t *result_get;
+          result_get = report_results_get_data (1, 1,
+                                                1, /* apply_overrides */
+                                                0  /* min_qod */);
+          result_get->id = g_strdup (uuid_result);
+          init_result_get_iterator (&results, result_get,
+                                    0,     /* No report restriction */
+                                    NULL,  /* No host restriction */
+                                    NULL); /* No extra order SQL. */
+          get_data_reset (result_get);
+          free (result_get);
+
+          while (next (&results))
+            buffer_results_xml (buffer,
+                                &results,
+                                0,
+                                0,  /* Notes. */
+                                0,  /* Note details. */
+                                0,  /* Overrides. */
+                                0,  /* Override details. */
+                                0,  /* Tags. */
+                                0,  /* Tag details. */
+                                0,  /* Result details. */
+                                NULL,
+                                NULL,
+                                0,
+                                -1,
+                                0); /* Lean. */
+          cleanup_iterator (&results);
+        }
+      else
+        buffer_xml_append_printf (buffer,
+                                  "<result id=\"%s\"/>",
+                                  uuid_result ? uuid_result : "");
+      if (tag_count)
         {
-          const char *text = note_iterator_text (notes);
-          gchar *excerpt = utf8_substring (text, 0, 60);
-          /* This must match send_get_common. */
           buffer_xml_append_printf (buffer,
-                                    "<owner><name>%s</name></owner>"
-                                    "<nvt oid=\"%s\">"
-                                    "<name>%s</name>"
-                                    "<type>%s</type>"
-                                    "</nvt>"
-                                    "<creation_time>%s</creation_time>"
-                                    "<modification_time>%s</modification_time>"
-                                    "<writable>1</writable>"
-                                    "<in_use>0</in_use>"
-                                    "<active>%i</active>"
-                                    "<text excerpt=\"%i\">%s</text>"
-                                    "<orphan>%i</orphan>",
-                                    get_iterator_owner_name (notes)
-                                     ? get_iterator_owner_name (notes)
-                                     : "",
-                                    note_iterator_nvt_oid (notes),
-                                    note_iterator_nvt_name (notes),
-                                    note_iterator_nvt_type (notes),
-                                    get_iterator_creation_time (notes),
-                                    get_iterator_modification_time (notes),
-                                    note_iterator_active (notes),
-                                    strlen (excerpt) < strlen (text),
-                                    excerpt,
-                                    ((note_iterator_task (notes)
-                                      && (uuid_task == NULL))
-                                     || (note_iterator_result (notes)
-                                         && (uuid_result == NULL))));
-
-          if (tag_count)
+                                    "<user_tags>"
+                                    "<count>%i</count>",
+                                    tag_count);
+
+          init_resource_tag_iterator (&tags, "note",
+                                      get_iterator_resource (notes),
+                                      1, NULL, 1);
+
+          while (next (&tags))
             {
-              buffer_xml_append_printf (buffer,
-                                        "<user_tags>"
-                                        "<count>%i</count>"
-                                        "</user_tags>",
-                                        tag_count);
+              buffer_xml_append_printf 
+                 (buffer,
+                  "<tag id=\"%s\">"
+                  "<name>%s</name>"
+                  "<value>%s</value>"
+                  "<comment>%s</comment>"
+                  "</tag>",
+                  resource_tag_iterator_uuid (&tags),
+                  resource_tag_iterator_name (&tags),
+                  resource_tag_iterator_value (&tags),
+                  resource_tag_iterator_comment (&tags));
             }
 
-          g_string_append (buffer, "</note>");
+          cleanup_iterator (&tags);
+
+          g_string_append (buffer, "</user_tags>");
+        }
+
+      g_string_append (buffer, "</note>");
+    }
+  free (uuid_task);
+  free (uuid_result);
+}
+
+/**
+ * @brief Buffer XML for some notes.
+ *
+ * @param[in]  buffer                 Buffer into which to buffer notes.
+ * @param[in]  notes                  Notes iterator.
+ * @param[in]  include_notes_details  Whether to include details of notes.
+ * @param[in]  include_result         Whether to include associated result.
+ * @param[out] count                  Number of notes.
+ */
+static void
+buffer_notes_xml (GString *buffer, iterator_t *notes, int include_notes_details,
+                  int include_result, int *count)
+{
+  while (next (notes))
+    buffer_note_xml (buffer, notes, include_notes_details, include_result,
+                     count);
+}
+
+/**
+ * @brief Buffer XML for the current override of an overrides iterator.
+ *
+ * @param[in]  buffer                     Buffer into which to buffer overrides.
+ * @param[in]  overrides                  Overrides iterator.
+ * @param[in]  include_overrides_details  Whether to include details of overrides.
+ * @param[in]  include_result             Whether to include associated result.
+ * @param[out] count                      Number of overrides.
+ */
+static void
+buffer_override_xml (GString *buffer, iterator_t *overrides,
+                     int include_overrides_details, int include_result,
+                     int *count)
+{
+  int tag_count;
+  char *uuid_task, *uuid_result;
+  tag_count = resource_tag_count ("override",
+                                  get_iterator_resource (overrides),
+                                  1);
+
+  if (count)
+    (*count)++;
+
+  if (override_iterator_task (overrides))
+    task_uuid (override_iterator_task (overrides),
+               &uuid_task);
+  else
+    uuid_task = NULL;
+
+  if (override_iterator_result (overrides))
+    result_uuid (override_iterator_result (overrides),
+                 &uuid_result);
+  else
+    uuid_result = NULL;
+
+  buffer_xml_append_printf (buffer,
+                            "<override id=\"%s\">"
+                            "<permissions>",
+                            get_iterator_uuid (overrides));
+
+  if (/* The user is the owner. */
+      (current_credentials.username
+       && get_iterator_owner_name (overrides)
+       && (strcmp (get_iterator_owner_name (overrides),
+                   current_credentials.username)
+          == 0))
+      /* Or the user is effectively the owner. */
+      || acl_user_has_super (current_credentials.uuid,
+                             get_iterator_owner (overrides)))
+    buffer_xml_append_printf (buffer,
+                              "<permission><name>Everything</name></permission>"
+                              "</permissions>");
+  else
+    {
+      iterator_t perms;
+      get_data_t perms_get;
+
+      memset (&perms_get, '\0', sizeof (perms_get));
+      perms_get.filter = g_strdup_printf ("resource_uuid=%s"
+                                          " owner=any"
+                                          " permission=any",
+                                          get_iterator_uuid (overrides));
+      init_permission_iterator (&perms, &perms_get);
+      g_free (perms_get.filter);
+      while (next (&perms))
+        buffer_xml_append_printf (buffer,
+                                  "<permission><name>%s</name></permission>",
+                                  get_iterator_name (&perms));
+      cleanup_iterator (&perms);
+
+      buffer_xml_append_printf (buffer, "</permissions>");
+    }
+
+  if (include_overrides_details == 0)
+    {
+      const char *text = override_iterator_text (overrides);
+      gchar *excerpt = utf8_substring (text, 0, 60);
+      /* This must match send_get_common. */
+      buffer_xml_append_printf (buffer,
+                                "<owner><name>%s</name></owner>"
+                                "<nvt oid=\"%s\">"
+                                "<name>%s</name>"
+                                "<type>%s</type>"
+                                "</nvt>"
+                                "<creation_time>%s</creation_time>"
+                                "<modification_time>%s</modification_time>"
+                                "<writable>1</writable>"
+                                "<in_use>0</in_use>"
+                                "<active>%i</active>"
+                                "<text excerpt=\"%i\">%s</text>"
+                                "<threat>%s</threat>"
+                                "<severity>%s</severity>"
+                                "<new_threat>%s</new_threat>"
+                                "<new_severity>%s</new_severity>"
+                                "<orphan>%i</orphan>",
+                                get_iterator_owner_name (overrides)
+                                 ? get_iterator_owner_name (overrides)
+                                 : "",
+                                override_iterator_nvt_oid (overrides),
+                                override_iterator_nvt_name (overrides),
+                                override_iterator_nvt_type (overrides),
+                                get_iterator_creation_time (overrides),
+                                get_iterator_modification_time (overrides),
+                                override_iterator_active (overrides),
+                                strlen (excerpt) < strlen (text),
+                                excerpt,
+                                override_iterator_threat (overrides)
+                                 ? override_iterator_threat (overrides)
+                                 : "",
+                                override_iterator_severity (overrides)
+                                 ? override_iterator_severity (overrides)
+                                 : "",
+                                override_iterator_new_threat (overrides),
+                                override_iterator_new_severity (overrides),
+                                ((override_iterator_task (overrides)
+                                  && (uuid_task == NULL))
+                                 || (override_iterator_result (overrides)
+                                     && (uuid_result == NULL))));
+
+      if (tag_count)
+        {
+          buffer_xml_append_printf (buffer,
+                                    "<user_tags>"
+                                    "<count>%i</count>"
+                                    "</user_tags>",
+                                    tag_count);
+        }
+
+      g_string_append (buffer, "</override>");
+
+      g_free (excerpt);
+    }
+  else
+    {
+      char *name_task;
+      int trash_task;
+      time_t end_time;
+      iterator_t tags;
+
+      if (uuid_task)
+        {
+          name_task = task_name (override_iterator_task (overrides));
+          trash_task = task_in_trash (override_iterator_task (overrides));
+        }
+      else
+        {
+          name_task = NULL;
+          trash_task = 0;
+        }
+
+      end_time = override_iterator_end_time (overrides);
 
-          g_free (excerpt);
+      /* This must match send_get_common. */
+      buffer_xml_append_printf
+       (buffer,
+        "<owner><name>%s</name></owner>"
+        "<nvt oid=\"%s\">"
+        "<name>%s</name>"
+        "<type>%s</type>"
+        "</nvt>"
+        "<creation_time>%s</creation_time>"
+        "<modification_time>%s</modification_time>"
+        "<writable>1</writable>"
+        "<in_use>0</in_use>"
+        "<active>%i</active>"
+        "<end_time>%s</end_time>"
+        "<text>%s</text>"
+        "<hosts>%s</hosts>"
+        "<port>%s</port>"
+        "<threat>%s</threat>"
+        "<severity>%s</severity>"
+        "<new_threat>%s</new_threat>"
+        "<new_severity>%s</new_severity>"
+        "<task id=\"%s\"><name>%s</name><trash>%i</trash></task>"
+        "<orphan>%i</orphan>",
+        get_iterator_owner_name (overrides)
+         ? get_iterator_owner_name (overrides)
+         : "",
+        override_iterator_nvt_oid (overrides),
+        override_iterator_nvt_name (overrides),
+        override_iterator_nvt_type (overrides),
+        get_iterator_creation_time (overrides),
+        get_iterator_modification_time (overrides),
+        override_iterator_active (overrides),
+        end_time > 1 ? iso_time (&end_time) : "",
+        override_iterator_text (overrides),
+        override_iterator_hosts (overrides)
+         ? override_iterator_hosts (overrides) : "",
+        override_iterator_port (overrides)
+         ? override_iterator_port (overrides) : "",
+        override_iterator_threat (overrides)
+         ? override_iterator_threat (overrides) : "",
+        override_iterator_severity (overrides)
+         ? override_iterator_severity (overrides) : "",
+        override_iterator_new_threat (overrides),
+        override_iterator_new_severity (overrides),
+        uuid_task ? uuid_task : "",
+        name_task ? name_task : "",
+        trash_task,
+        ((override_iterator_task (overrides) && (uuid_task == NULL))
+         || (override_iterator_result (overrides) && (uuid_result == NULL))));
+
+      free (name_task);
+
+      if (include_result && uuid_result
+          && override_iterator_result (overrides))
+        {
+          iterator_t results;
+          get_data_t *result_get;
+          result_get = report_results_get_data (1, 1,
+                                                1, /* apply_overrides */
+                                                0  /* min_qod */);
+          result_get->id = g_strdup (uuid_result);
+          init_result_get_iterator (&results, result_get,
+                                    0,  /* No report restriction */
+                                    NULL, /* No host restriction */
+                                    NULL);  /* No extra order SQL. */
+          get_data_reset (result_get);
+          free (result_get);
+
+          while (next (&results))
+            buffer_results_xml (buffer,
+                                &results,
+                                0,
+                                0,  /* Overrides. */
+                                0,  /* Override details. */
+                                0,  /* Overrides. */
+                                0,  /* Override details. */
+                                0,  /* Tags. */
+                                0,  /* Tag details. */
+                                0,  /* Result details. */
+                                NULL,
+                                NULL,
+                                0,
+                                -1,
+                                0); /* Lean. */
+          cleanup_iterator (&results);
         }
       else
-        {
-          char *name_task;
-          int trash_task;
-          time_t end_time;
-          iterator_t tags;
+        buffer_xml_append_printf (buffer,
+                                  "<result id=\"%s\"/>",
+                                  uuid_result ? uuid_result : "");
 
-          if (uuid_task)
-            {
-              name_task = task_name (note_iterator_task (notes));
-              trash_task = task_in_trash (note_iterator_task (notes));
-            }
-          else
-            {
-              name_task = NULL;
-              trash_task = 0;
-            }
+      if (tag_count)
+        {
+          buffer_xml_append_printf (buffer,
+                                    "<user_tags>"
+                                    "<count>%i</count>",
+                                    tag_count);
 
-          end_time = note_iterator_end_time (notes);
+          init_resource_tag_iterator (&tags, "override",
+                                      get_iterator_resource (overrides),
+                                      1, NULL, 1);
 
-          /* This must match send_get_common. */
-          buffer_xml_append_printf
-           (buffer,
-            "<owner><name>%s</name></owner>"
-            "<nvt oid=\"%s\">"
-            "<name>%s</name>"
-            "<type>%s</type>"
-            "</nvt>"
-            "<creation_time>%s</creation_time>"
-            "<modification_time>%s</modification_time>"
-            "<writable>1</writable>"
-            "<in_use>0</in_use>"
-            "<active>%i</active>"
-            "<end_time>%s</end_time>"
-            "<text>%s</text>"
-            "<hosts>%s</hosts>"
-            "<port>%s</port>"
-            "<severity>%s</severity>"
-            "<task id=\"%s\"><name>%s</name><trash>%i</trash></task>"
-            "<orphan>%i</orphan>",
-            get_iterator_owner_name (notes)
-             ? get_iterator_owner_name (notes)
-             : "",
-            note_iterator_nvt_oid (notes),
-            note_iterator_nvt_name (notes),
-            note_iterator_nvt_type (notes),
-            get_iterator_creation_time (notes),
-            get_iterator_modification_time (notes),
-            note_iterator_active (notes),
-            end_time > 1 ? iso_time (&end_time) : "",
-            note_iterator_text (notes),
-            note_iterator_hosts (notes)
-             ? note_iterator_hosts (notes) : "",
-            note_iterator_port (notes)
-             ? note_iterator_port (notes) : "",
-            note_iterator_severity (notes)
-             ? note_iterator_severity (notes) : "",
-            uuid_task ? uuid_task : "",
-            name_task ? name_task : "",
-            trash_task,
-            ((note_iterator_task (notes) && (uuid_task == NULL))
-             || (note_iterator_result (notes) && (uuid_result == NULL))));
-
-          free (name_task);
-
-          if (include_result && uuid_result && note_iterator_result (notes))
+          while (next (&tags))
             {
-              iterator_t results;
-              get_data_t *result_get;
-              result_get = report_results_get_data (1, 1,
-                                                    1, /* apply_overrides */
-                                                    0  /* min_qod */);
-              result_get->id = g_strdup (uuid_result);
-              init_result_get_iterator (&results, result_get,
-                                        0,     /* No report restriction */
-                                        NULL,  /* No host restriction */
-                                        NULL); /* No extra order SQL. */
-              get_data_reset (result_get);
-              free (result_get);
-
-              while (next (&results))
-                buffer_results_xml (buffer,
-                                    &results,
-                                    0,
-                                    0,  /* Notes. */
-                                    0,  /* Note details. */
-                                    0,  /* Overrides. */
-                                    0,  /* Override details. */
-                                    0,  /* Tags. */
-                                    0,  /* Tag details. */
-                                    0,  /* Result details. */
-                                    NULL,
-                                    NULL,
-                                    0,
-                                    -1,
-                                    0); /* Lean. */
-              cleanup_iterator (&results);
+              buffer_xml_append_printf 
+                 (buffer,
+                  "<tag id=\"%s\">"
+                  "<name>%s</name>"
+                  "<value>%s</value>"
+                  "<comment>%s</comment>"
+                  "</tag>",
+                  resource_tag_iterator_uuid (&tags),
+                  resource_tag_iterator_name (&tags),
+                  resource_tag_iterator_value (&tags),
+                  resource_tag_iterator_comment (&tags));
             }
-          else
-            buffer_xml_append_printf (buffer,
-                                      "<result id=\"%s\"/>",
-                                      uuid_result ? uuid_result : "");
-          if (tag_count)
-            {
-              buffer_xml_append_printf (buffer,
-                                        "<user_tags>"
-                                        "<count>%i</count>",
-                                        tag_count);
-
-              init_resource_tag_iterator (&tags, "note",
-                                          get_iterator_resource (notes),
-                                          1, NULL, 1);
-
-              while (next (&tags))
-                {
-                  buffer_xml_append_printf 
-                     (buffer,
-                      "<tag id=\"%s\">"
-                      "<name>%s</name>"
-                      "<value>%s</value>"
-                      "<comment>%s</comment>"
-                      "</tag>",
-                      resource_tag_iterator_uuid (&tags),
-                      resource_tag_iterator_name (&tags),
-                      resource_tag_iterator_value (&tags),
-                      resource_tag_iterator_comment (&tags));
-                }
-
-              cleanup_iterator (&tags);
 
-              g_string_append (buffer, "</user_tags>");
-            }
+          cleanup_iterator (&tags);
 
-          g_string_append (buffer, "</note>");
+          g_string_append (buffer, "</user_tags>");
         }
-      free (uuid_task);
-      free (uuid_result);
+
+      g_string_append (buffer, "</override>");
     }
+  free (uuid_task);
+  free (uuid_result);
 }
 
 /**
@@ -8254,272 +9404,117 @@ buffer_overrides_xml (GString *buffer, iterator_t *overrides,
                       int *count)
 {
   while (next (overrides))
-    {
-      int tag_count;
-      char *uuid_task, *uuid_result;
-      tag_count = resource_tag_count ("override",
-                                      get_iterator_resource (overrides),
-                                      1);
-
-      if (count)
-        (*count)++;
-
-      if (override_iterator_task (overrides))
-        task_uuid (override_iterator_task (overrides),
-                   &uuid_task);
-      else
-        uuid_task = NULL;
-
-      if (override_iterator_result (overrides))
-        result_uuid (override_iterator_result (overrides),
-                     &uuid_result);
-      else
-        uuid_result = NULL;
-
-      buffer_xml_append_printf (buffer,
-                                "<override id=\"%s\">"
-                                "<permissions>",
-                                get_iterator_uuid (overrides));
-
-      if (/* The user is the owner. */
-          (current_credentials.username
-           && get_iterator_owner_name (overrides)
-           && (strcmp (get_iterator_owner_name (overrides),
-                       current_credentials.username)
-              == 0))
-          /* Or the user is effectively the owner. */
-          || acl_user_has_super (current_credentials.uuid,
-                                 get_iterator_owner (overrides)))
-        buffer_xml_append_printf (buffer,
-                                  "<permission><name>Everything</name></permission>"
-                                  "</permissions>");
-      else
-        {
-          iterator_t perms;
-          get_data_t perms_get;
-
-          memset (&perms_get, '\0', sizeof (perms_get));
-          perms_get.filter = g_strdup_printf ("resource_uuid=%s"
-                                              " owner=any"
-                                              " permission=any",
-                                              get_iterator_uuid (overrides));
-          init_permission_iterator (&perms, &perms_get);
-          g_free (perms_get.filter);
-          while (next (&perms))
-            buffer_xml_append_printf (buffer,
-                                      "<permission><name>%s</name></permission>",
-                                      get_iterator_name (&perms));
-          cleanup_iterator (&perms);
-
-          buffer_xml_append_printf (buffer, "</permissions>");
-        }
+    buffer_override_xml (buffer, overrides, include_overrides_details,
+                         include_result, count);
+}
 
-      if (include_overrides_details == 0)
-        {
-          const char *text = override_iterator_text (overrides);
-          gchar *excerpt = utf8_substring (text, 0, 60);
-          /* This must match send_get_common. */
-          buffer_xml_append_printf (buffer,
-                                    "<owner><name>%s</name></owner>"
-                                    "<nvt oid=\"%s\">"
-                                    "<name>%s</name>"
-                                    "<type>%s</type>"
-                                    "</nvt>"
-                                    "<creation_time>%s</creation_time>"
-                                    "<modification_time>%s</modification_time>"
-                                    "<writable>1</writable>"
-                                    "<in_use>0</in_use>"
-                                    "<active>%i</active>"
-                                    "<text excerpt=\"%i\">%s</text>"
-                                    "<threat>%s</threat>"
-                                    "<severity>%s</severity>"
-                                    "<new_threat>%s</new_threat>"
-                                    "<new_severity>%s</new_severity>"
-                                    "<orphan>%i</orphan>",
-                                    get_iterator_owner_name (overrides)
-                                     ? get_iterator_owner_name (overrides)
-                                     : "",
-                                    override_iterator_nvt_oid (overrides),
-                                    override_iterator_nvt_name (overrides),
-                                    override_iterator_nvt_type (overrides),
-                                    get_iterator_creation_time (overrides),
-                                    get_iterator_modification_time (overrides),
-                                    override_iterator_active (overrides),
-                                    strlen (excerpt) < strlen (text),
-                                    excerpt,
-                                    override_iterator_threat (overrides)
-                                     ? override_iterator_threat (overrides)
-                                     : "",
-                                    override_iterator_severity (overrides)
-                                     ? override_iterator_severity (overrides)
-                                     : "",
-                                    override_iterator_new_threat (overrides),
-                                    override_iterator_new_severity (overrides),
-                                    ((override_iterator_task (overrides)
-                                      && (uuid_task == NULL))
-                                     || (override_iterator_result (overrides)
-                                         && (uuid_result == NULL))));
-
-          if (tag_count)
-            {
-              buffer_xml_append_printf (buffer,
-                                        "<user_tags>"
-                                        "<count>%i</count>"
-                                        "</user_tags>",
-                                        tag_count);
-            }
+/**
+ * @brief XML of the notes and overrides of results, by kind and row.
+ *
+ * A note or override that applies to an NVT matches many results in a
+ * GET_RESULTS or GET_REPORTS page.  Each is rendered only once per command
+ * and then copied from here.  Cleared at the start of every command.
+ */
+static GHashTable *result_annotations_xml = NULL;
 
-          g_string_append (buffer, "</override>");
+/**
+ * @brief Clear the cached XML of result notes and overrides.
+ */
+static void
+result_annotations_xml_clear ()
+{
+  if (result_annotations_xml)
+    g_hash_table_remove_all (result_annotations_xml);
+}
 
-          g_free (excerpt);
-        }
-      else
-        {
-          char *name_task;
-          int trash_task;
-          time_t end_time;
-          iterator_t tags;
+/**
+ * @brief Name of the command being timed, or NULL.
+ */
+static gchar *command_timing_name = NULL;
 
-          if (uuid_task)
-            {
-              name_task = task_name (override_iterator_task (overrides));
-              trash_task = task_in_trash (override_iterator_task (overrides));
-            }
-          else
-            {
-              name_task = NULL;
-              trash_task = 0;
-            }
+/**
+ * @brief Monotonic time at which the timed command started.
+ */
+static gint64 command_timing_start_time = 0;
 
-          end_time = override_iterator_end_time (overrides);
+/**
+ * @brief Start timing a command.
+ *
+ * @param[in]  name  Name of the command element.
+ */
+static void
+command_timing_start (const gchar *name)
+{
+  g_free (command_timing_name);
+  command_timing_name = g_ascii_strdown (name, -1);
+  command_timing_start_time = g_get_monotonic_time ();
+  manage_sql_stats_reset ();
+}
 
-          /* This must match send_get_common. */
-          buffer_xml_append_printf
-           (buffer,
-            "<owner><name>%s</name></owner>"
-            "<nvt oid=\"%s\">"
-            "<name>%s</name>"
-            "<type>%s</type>"
-            "</nvt>"
-            "<creation_time>%s</creation_time>"
-            "<modification_time>%s</modification_time>"
-            "<writable>1</writable>"
-            "<in_use>0</in_use>"
-            "<active>%i</active>"
-            "<end_time>%s</end_time>"
-            "<text>%s</text>"
-            "<hosts>%s</hosts>"
-            "<port>%s</port>"
-            "<threat>%s</threat>"
-            "<severity>%s</severity>"
-            "<new_threat>%s</new_threat>"
-            "<new_severity>%s</new_severity>"
-            "<task id=\"%s\"><name>%s</name><trash>%i</trash></task>"
-            "<orphan>%i</orphan>",
-            get_iterator_owner_name (overrides)
-             ? get_iterator_owner_name (overrides)
-             : "",
-            override_iterator_nvt_oid (overrides),
-            override_iterator_nvt_name (overrides),
-            override_iterator_nvt_type (overrides),
-            get_iterator_creation_time (overrides),
-            get_iterator_modification_time (overrides),
-            override_iterator_active (overrides),
-            end_time > 1 ? iso_time (&end_time) : "",
-            override_iterator_text (overrides),
-            override_iterator_hosts (overrides)
-             ? override_iterator_hosts (overrides) : "",
-            override_iterator_port (overrides)
-             ? override_iterator_port (overrides) : "",
-            override_iterator_threat (overrides)
-             ? override_iterator_threat (overrides) : "",
-            override_iterator_severity (overrides)
-             ? override_iterator_severity (overrides) : "",
-            override_iterator_new_threat (overrides),
-            override_iterator_new_severity (overrides),
-            uuid_task ? uuid_task : "",
-            name_task ? name_task : "",
-            trash_task,
-            ((override_iterator_task (overrides) && (uuid_task == NULL))
-             || (override_iterator_result (overrides) && (uuid_result == NULL))));
-
-          free (name_task);
-
-          if (include_result && uuid_result
-              && override_iterator_result (overrides))
-            {
-              iterator_t results;
-              get_data_t *result_get;
-              result_get = report_results_get_data (1, 1,
-                                                    1, /* apply_overrides */
-                                                    0  /* min_qod */);
-              result_get->id = g_strdup (uuid_result);
-              init_result_get_iterator (&results, result_get,
-                                        0,  /* No report restriction */
-                                        NULL, /* No host restriction */
-                                        NULL);  /* No extra order SQL. */
-              get_data_reset (result_get);
-              free (result_get);
-
-              while (next (&results))
-                buffer_results_xml (buffer,
-                                    &results,
-                                    0,
-                                    0,  /* Overrides. */
-                                    0,  /* Override details. */
-                                    0,  /* Overrides. */
-                                    0,  /* Override details. */
-                                    0,  /* Tags. */
-                                    0,  /* Tag details. */
-                                    0,  /* Result details. */
-                                    NULL,
-                                    NULL,
-                                    0,
-                                    -1,
-                                    0); /* Lean. */
-              cleanup_iterator (&results);
-            }
-          else
-            buffer_xml_append_printf (buffer,
-                                      "<result id=\"%s\"/>",
-                                      uuid_result ? uuid_result : "");
+/**
+ * @brief Log the duration and SQL statistics of the timed command, if any.
+ */
+static void
+command_timing_finish ()
+{
+  gint64 sql_time;
+  int sql_count;
 
-          if (tag_count)
-            {
-              buffer_xml_append_printf (buffer,
-                                        "<user_tags>"
-                                        "<count>%i</count>",
-                                        tag_count);
+  if (command_timing_name == NULL)
+    return;
 
-              init_resource_tag_iterator (&tags, "override",
-                                          get_iterator_resource (overrides),
-                                          1, NULL, 1);
+  manage_sql_stats (&sql_count, &sql_time);
+  g_log (GVMD_PERF_LOG_DOMAIN, G_LOG_LEVEL_INFO,
+         "gmp_command command=%s user=%s ms=%" G_GINT64_FORMAT
+         " sql_count=%i sql_ms=%" G_GINT64_FORMAT,
+         command_timing_name,
+         current_credentials.username ? current_credentials.username : "",
+         (g_get_monotonic_time () - command_timing_start_time) / 1000,
+         sql_count,
+         sql_time / 1000);
+  g_free (command_timing_name);
+  command_timing_name = NULL;
+}
 
-              while (next (&tags))
-                {
-                  buffer_xml_append_printf 
-                     (buffer,
-                      "<tag id=\"%s\">"
-                      "<name>%s</name>"
-                      "<value>%s</value>"
-                      "<comment>%s</comment>"
-                      "</tag>",
-                      resource_tag_iterator_uuid (&tags),
-                      resource_tag_iterator_name (&tags),
-                      resource_tag_iterator_value (&tags),
-                      resource_tag_iterator_comment (&tags));
-                }
+/**
+ * @brief Buffer XML for the current row of a note or override iterator.
+ *
+ * Uses the cached XML if the row has already been rendered.
+ *
+ * @param[in]  buffer   Buffer.
+ * @param[in]  kind     "note" or "override".
+ * @param[in]  rows     Note or override iterator.
+ * @param[in]  details  Whether to include details.
+ * @param[in]  render   Function that buffers the XML of the current row.
+ */
+static void
+buffer_result_annotation_xml (GString *buffer, const char *kind,
+                              iterator_t *rows, int details,
+                              void (*render) (GString *, iterator_t *, int,
+                                              int, int *))
+{
+  gchar *key, *xml;
 
-              cleanup_iterator (&tags);
+  if (result_annotations_xml == NULL)
+    result_annotations_xml = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, g_free);
 
-              g_string_append (buffer, "</user_tags>");
-            }
+  key = g_strdup_printf ("%s %i %llu", kind, details,
+                         get_iterator_resource (rows));
+  xml = g_hash_table_lookup (result_annotations_xml, key);
+  if (xml == NULL)
+    {
+      GString *row_buffer;
 
-          g_string_append (buffer, "</override>");
-        }
-      free (uuid_task);
-      free (uuid_result);
+      row_buffer = g_string_new ("");
+      render (row_buffer, rows, details, 0, NULL);
+      xml = g_string_free (row_buffer, FALSE);
+      g_hash_table_insert (result_annotations_xml, key, xml);
     }
+  else
+    g_free (key);
+
+  g_string_append (buffer, xml);
 }
 
 /* External for manage.c. */
@@ -8789,9 +9784,6 @@ buffer_result_notes_xml (GString *buffer, result_t result, task_t task,
       /* Most recent first. */
       get.filter = "sort-reverse=created owner=any permission=any";
 
-      if (note_count (&get, 0, result, task) == 0)
-        return;
-
       init_note_iterator (&notes,
                           &get,
                           0,
@@ -8799,13 +9791,13 @@ buffer_result_notes_xml (GString *buffer, result_t result, task_t task,
                           task);
 
       temp_buffer = g_string_new ("");
-      buffer_notes_xml (temp_buffer,
-                        &notes,
-                        include_notes_details,
-                        0,
-                        NULL);
+      while (next (&notes))
+        buffer_result_annotation_xml (temp_buffer, "note", &notes,
+                                      include_notes_details,
+                                      buffer_note_xml);
 
-      if (lean == 0 || strlen (temp_buffer->str))
+      /* Like a count of 0, no rows means no notes element at all. */
+      if (temp_buffer->len)
         {
           g_string_append (buffer, "<notes>");
           g_string_append (buffer, temp_buffer->str);
@@ -8840,9 +9832,6 @@ buffer_result_overrides_xml (GString *buffer, result_t result, task_t task,
       /* Most recent first. */
       get.filter = "sort-reverse=created owner=any permission=any";
 
-      if (override_count (&get, 0, result, task) == 0)
-        return;
-
       init_override_iterator (&overrides,
                               &get,
                               0,
@@ -8850,12 +9839,13 @@ buffer_result_overrides_xml (GString *buffer, result_t result, task_t task,
                               task);
 
       temp_buffer = g_string_new ("");
-      buffer_overrides_xml (temp_buffer,
-                            &overrides,
-                            include_overrides_details,
-                            0,
-                            NULL);
-      if (lean == 0 || strlen (temp_buffer->str))
+      while (next (&overrides))
+        buffer_result_annotation_xml (temp_buffer, "override", &overrides,
+                                      include_overrides_details,
+                                      buffer_override_xml);
+
+      /* Like a count of 0, no rows means no overrides element at all. */
+      if (temp_buffer->len)
         {
           g_string_append (buffer, "<overrides>");
           g_string_append (buffer, temp_buffer->str);
@@ -10770,6 +11760,11 @@ handle_get_aggregates (gmp_parser_t *gmp_parser, GError **error)
              (XML_ERROR_SYNTAX ("get_aggregates",
                                 "Permission denied"));
             break;
+          case 2:
+            SEND_TO_CLIENT_OR_FAIL
+             (XML_ERROR_SYNTAX ("get_aggregates",
+                                "Invalid after in filter"));
+            break;
           default:
             internal_error_send_to_client (error);
             return;
@@ -12793,6 +13788,8 @@ handle_get_info (gmp_parser_t *gmp_parser, GError **error)
   int (*info_count) (const get_data_t *get);
   const char *update_time;
   get_data_t *get;
+  nvt_details_t *nvt_details;
+  GHashTable *cve_nvts, *cve_cert_refs;
 
   if (acl_user_may ("get_info") == 0)
     {
@@ -12964,6 +13961,38 @@ handle_get_info (gmp_parser_t *gmp_parser, GError **error)
       return;
     }
 
+  nvt_details = NULL;
+  if (g_strcmp0 ("nvt", get_info_data->type) == 0)
+    {
+      iterator_t page;
+
+      /* Fetch the details of the whole page at once. */
+      if (init_info_iterator (&page, &get_info_data->get,
+                              get_info_data->name)
+          == 0)
+        {
+          GPtrArray *oids;
+
+          oids = nvt_iterator_oids (&page);
+          nvt_details = nvt_details_new (oids, 1, 0, 0);
+          g_ptr_array_free (oids, TRUE);
+        }
+    }
+
+  cve_nvts = NULL;
+  cve_cert_refs = NULL;
+  if (g_strcmp0 ("cve", get_info_data->type) == 0
+      && get_info_data->details == 1)
+    {
+      iterator_t page;
+
+      /* Fetch the cross-references of the whole page at once. */
+      if (init_info_iterator (&page, &get_info_data->get,
+                              get_info_data->name)
+          == 0)
+        cve_cross_refs (&page, &cve_nvts, &cve_cert_refs);
+    }
+
   count = 0;
   manage_filter_controls (get_info_data->get.filter, &first, NULL, NULL, NULL);
   SEND_GET_START ("info");
@@ -13062,55 +14091,22 @@ handle_get_info (gmp_parser_t *gmp_parser, GError **error)
                              cve_info_iterator_products (&info));
           if (get_info_data->details == 1)
             {
-              iterator_t nvts;
-              iterator_t cert_advs;
-              init_cve_nvt_iterator (&nvts, get_iterator_name (&info), 1, NULL);
-              g_string_append (result, "<nvts>");
-              while (next (&nvts))
-                xml_string_append (result,
-                                   "<nvt oid=\"%s\">"
-                                   "<name>%s</name>"
-                                   "</nvt>",
-                                   nvt_iterator_oid (&nvts),
-                                   nvt_iterator_name (&nvts));
-              g_string_append (result, "</nvts>");
-              cleanup_iterator (&nvts);
+              const gchar *xml;
+
+              xml = cve_nvts
+                     ? g_hash_table_lookup (cve_nvts,
+                                            get_iterator_name (&info))
+                     : NULL;
+              g_string_append_printf (result, "<nvts>%s</nvts>",
+                                      xml ? xml : "");
 
               g_string_append (result, "<cert>");
-              if (manage_cert_loaded())
+              if (cve_cert_refs)
                 {
-                  init_cve_cert_bund_adv_iterator (&cert_advs,
-                                                  get_iterator_name (&info),
-                                                  1, NULL);
-                  while (next (&cert_advs))
-                    {
-                      xml_string_append
-                        (result,
-                         "<cert_ref type=\"CERT-Bund\">"
-                         "<name>%s</name>"
-                         "<title>%s</title>"
-                         "</cert_ref>",
-                         get_iterator_name (&cert_advs),
-                         cert_bund_adv_info_iterator_title (&cert_advs));
-                  };
-                  cleanup_iterator (&cert_advs);
-
-                  init_cve_dfn_cert_adv_iterator (&cert_advs,
-                                                  get_iterator_name
-                                                    (&info),
-                                                  1, NULL);
-                  while (next (&cert_advs))
-                    {
-                      xml_string_append (result,
-                                         "<cert_ref type=\"DFN-CERT\">"
-                                         "<name>%s</name>"
-                                         "<title>%s</title>"
-                                         "</cert_ref>",
-                                         get_iterator_name (&cert_advs),
-                                         dfn_cert_adv_info_iterator_title
-                                          (&cert_advs));
-                  };
-                  cleanup_iterator (&cert_advs);
+                  xml = g_hash_table_lookup (cve_cert_refs,
+                                             get_iterator_name (&info));
+                  if (xml)
+                    g_string_append (result, xml);
                 }
               else
                 {
@@ -13149,10 +14145,11 @@ handle_get_info (gmp_parser_t *gmp_parser, GError **error)
                            dfn_cert_adv_info_iterator_cve_refs (&info));
       else if (g_strcmp0 ("nvt", get_info_data->type) == 0)
         {
-          if (send_nvt (&info, 1, 1, -1, NULL, 0,
+          if (send_nvt (&info, 1, 1, -1, NULL, 0, nvt_details,
                         gmp_parser->client_writer,
                         gmp_parser->client_writer_data))
             {
+              nvt_details_free (nvt_details);
               cleanup_iterator (&info);
               error_send_to_client (error);
               return;
@@ -13182,6 +14179,11 @@ handle_get_info (gmp_parser_t *gmp_parser, GError **error)
     }
 
   cleanup_iterator (&info);
+  nvt_details_free (nvt_details);
+  if (cve_nvts)
+    g_hash_table_destroy (cve_nvts);
+  if (cve_cert_refs)
+    g_hash_table_destroy (cve_cert_refs);
 
   if (get_info_data->details == 1)
     SEND_TO_CLIENT_OR_FAIL ("<details>1</details>");
@@ -13425,19 +14427,18 @@ handle_get_nvts (gmp_parser_t *gmp_parser, GError **error)
       else
         {
           iterator_t nvts;
+          config_t nvts_config;
 
           SENDF_TO_CLIENT_OR_FAIL
            ("<get_nvts_response"
             " status=\"" STATUS_OK "\""
             " status_text=\"" STATUS_OK_TEXT "\">");
 
+          /* Presume the NVT is in the config (if a config was given). */
+          nvts_config = get_nvts_data->nvt_oid ? 0 : config;
           init_nvt_iterator (&nvts,
                               nvt,
-                              get_nvts_data->nvt_oid
-                              /* Presume the NVT is in the config (if
-                                * a config was given). */
-                              ? 0
-                              : config,
+                              nvts_config,
                               get_nvts_data->family,
                               NULL,
                               get_nvts_data->sort_order,
@@ -13445,43 +14446,63 @@ handle_get_nvts (gmp_parser_t *gmp_parser, GError **error)
           if (preferences_config)
             config = preferences_config;
           if (get_nvts_data->details)
-            while (next (&nvts))
-              {
-                int pref_count = -1;
-                char *timeout = NULL;
-
-                if (get_nvts_data->timeout)
-                  timeout = config_nvt_timeout (config,
-                                                nvt_iterator_oid (&nvts));
-
-                if (get_nvts_data->preferences && (timeout == NULL))
-                  timeout = config_nvt_timeout
-                              (config,
-                              nvt_iterator_oid (&nvts));
-
-                if (get_nvts_data->preference_count)
-                  {
-                    const char *nvt_oid = nvt_iterator_oid (&nvts);
-                    pref_count = nvt_preference_count (nvt_oid);
-                  }
-                if (send_nvt (&nvts, 1, get_nvts_data->preferences,
-                              pref_count, timeout, config,
-                              gmp_parser->client_writer,
-                              gmp_parser->client_writer_data))
-                  {
-                    free (timeout);
-                    cleanup_iterator (&nvts);
-                    error_send_to_client (error);
-                    return;
-                  }
-                free (timeout);
+            {
+              nvt_details_t *nvt_details;
+              GPtrArray *oids;
+
+              /* Fetch the details of all the NVTs at once. */
+
+              oids = nvt_iterator_oids (&nvts);
+              nvt_details = nvt_details_new
+                             (oids,
+                              get_nvts_data->preferences,
+                              get_nvts_data->preference_count,
+                              (get_nvts_data->timeout
+                               || get_nvts_data->preferences)
+                               ? config
+                               : 0);
+              g_ptr_array_free (oids, TRUE);
+
+              init_nvt_iterator (&nvts,
+                                 nvt,
+                                 nvts_config,
+                                 get_nvts_data->family,
+                                 NULL,
+                                 get_nvts_data->sort_order,
+                                 get_nvts_data->sort_field);
+              while (next (&nvts))
+                {
+                  int pref_count = -1;
+                  char *timeout = NULL;
+                  const char *nvt_oid = nvt_iterator_oid (&nvts);
+
+                  if (get_nvts_data->timeout || get_nvts_data->preferences)
+                    timeout = nvt_details_timeout (nvt_details, nvt_oid);
+
+                  if (get_nvts_data->preference_count)
+                    pref_count = nvt_details_preference_count (nvt_details,
+                                                               nvt_oid);
+                  if (send_nvt (&nvts, 1, get_nvts_data->preferences,
+                                pref_count, timeout, config, nvt_details,
+                                gmp_parser->client_writer,
+                                gmp_parser->client_writer_data))
+                    {
+                      free (timeout);
+                      cleanup_iterator (&nvts);
+                      nvt_details_free (nvt_details);
+                      error_send_to_client (error);
+                      return;
+                    }
+                  free (timeout);
 
-                SEND_TO_CLIENT_OR_FAIL ("</nvt>");
-              }
+                  SEND_TO_CLIENT_OR_FAIL ("</nvt>");
+                }
+              nvt_details_free (nvt_details);
+            }
           else
             while (next (&nvts))
               {
-                if (send_nvt (&nvts, 0, 0, -1, NULL, 0,
+                if (send_nvt (&nvts, 0, 0, -1, NULL, 0, NULL,
                               gmp_parser->client_writer,
                               gmp_parser->client_writer_data))
                   {
@@ -14246,6 +15267,11 @@ handle_get_reports (gmp_parser_t *gmp_parser, GError **error)
                   (XML_ERROR_SYNTAX ("get_reports",
                                      "Permission denied"));
                 break;
+              case 2:
+                SEND_TO_CLIENT_OR_FAIL
+                  (XML_ERROR_SYNTAX ("get_reports",
+                                     "Invalid after in filter"));
+                break;
               default:
                 internal_error_send_to_client (error);
                 return;
@@ -18109,6 +19135,41 @@ modify_scanner_leave:
 
 extern char client_address[];
 
+/**
+ * @brief Add the parsed results of a create_report to the DB.
+ *
+ * Only possible when the TASK came before the REPORT.  The first call
+ * creates the report.  On failure the results stay in memory for
+ * create_report, which then responds with the error.
+ */
+static void
+create_report_stream ()
+{
+  if (create_report_data->stream_failed
+      || create_report_data->task_id == NULL
+      || (create_report_data->type
+          && strcmp (create_report_data->type, "scan")))
+    return;
+
+  if (create_report_data->stream_report == 0
+      && create_report_stream_start (create_report_data->task_id,
+                                     &create_report_data->stream_report))
+    {
+      create_report_data->stream_report = 0;
+      create_report_data->stream_failed = 1;
+      return;
+    }
+
+  if (create_report_stream_add (create_report_data->stream_report,
+                                create_report_data->results))
+    {
+      create_report_data->stream_failed = 1;
+      return;
+    }
+
+  create_report_results_clear (create_report_data->results);
+}
+
 /**
  * @brief Handle create_report_data->results_* for gmp_xml_handle_end_element
  *
@@ -18251,6 +19312,9 @@ gmp_xml_handle_result ()
   create_report_data->result_threat = NULL;
   create_report_data->result_detection = NULL;
   create_report_data->result_detection = make_array ();
+
+  if (create_report_data->results->len >= CREATE_REPORT_STREAM_SIZE)
+    create_report_stream ();
 }
 
 /**
@@ -18301,12 +19365,27 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
         break;
 
       case CLIENT_AUTHENTICATE:
-        switch (authenticate (&current_credentials))
+        if (authenticate_compress == -1)
+          {
+            free_credentials (&current_credentials);
+            SEND_TO_CLIENT_OR_FAIL
+             (XML_ERROR_SYNTAX ("authenticate",
+                                "Unsupported compression method"));
+            gvm_free_string_var (&session_token);
+            authenticate_session = 0;
+            authenticate_compress = 0;
+            set_client_state (CLIENT_TOP);
+            break;
+          }
+        switch (session_token
+                 ? authenticate_token (&current_credentials, session_token)
+                 : authenticate (&current_credentials))
           {
             case 0:   /* Authentication succeeded. */
               {
                 const char *zone;
                 char *pw_warning;
+                gchar *token;
 
                 zone = (current_credentials.timezone
                         && strlen (current_credentials.timezone))
@@ -18327,38 +19406,51 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
 
                 manage_session_set_timezone (zone);
 
-                pw_warning = gvm_validate_password
-                              (current_credentials.password,
-                               current_credentials.username);
+                if (session_token)
+                  {
+                    /* The password was checked when the token was issued. */
+                    pw_warning = NULL;
+                    token = NULL;
+                  }
+                else
+                  {
+                    pw_warning = gvm_validate_password
+                                  (current_credentials.password,
+                                   current_credentials.username);
+                    token = authenticate_session
+                             ? manage_session_token_new (&current_credentials)
+                             : NULL;
+                  }
 
+                SENDF_TO_CLIENT_OR_FAIL
+                 ("<authenticate_response"
+                   " status=\"" STATUS_OK "\""
+                   " status_text=\"" STATUS_OK_TEXT "\">"
+                   "<role>%s</role>"
+                   "<timezone>%s</timezone>",
+                   current_credentials.role
+                     ? current_credentials.role
+                     : "",
+                   zone);
                 if (pw_warning)
                   SENDF_TO_CLIENT_OR_FAIL
-                  ("<authenticate_response"
-                    " status=\"" STATUS_OK "\""
-                    " status_text=\"" STATUS_OK_TEXT "\">"
-                    "<role>%s</role>"
-                    "<timezone>%s</timezone>"
-                    "<password_warning>%s</password_warning>"
-                    "</authenticate_response>",
-                    current_credentials.role
-                      ? current_credentials.role
-                      : "",
-                    zone,
-                    pw_warning ? pw_warning : "");
-                else
-                  SENDF_TO_CLIENT_OR_FAIL
-                  ("<authenticate_response"
-                    " status=\"" STATUS_OK "\""
-                    " status_text=\"" STATUS_OK_TEXT "\">"
-                    "<role>%s</role>"
-                    "<timezone>%s</timezone>"
-                    "</authenticate_response>",
-                    current_credentials.role
-                      ? current_credentials.role
-                      : "",
-                    zone);
+                   ("<password_warning>%s</password_warning>",
+                    pw_warning);
+                if (token)
+                  SENDF_TO_CLIENT_OR_FAIL ("<token>%s</token>", token);
+                SEND_TO_CLIENT_OR_FAIL ("</authenticate_response>");
+
+                /* Everything after the response is compressed. */
+                if (authenticate_compress)
+                  client_compress = 1;
+
+                g_free (authenticated_token);
+                authenticated_token = g_strdup (session_token
+                                                 ? session_token
+                                                 : token);
 
                 free (pw_warning);
+                g_free (token);
                 set_client_state (CLIENT_AUTHENTIC);
 
                 break;
@@ -18387,6 +19479,9 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
               set_client_state (CLIENT_TOP);
               break;
           }
+        gvm_free_string_var (&session_token);
+        authenticate_session = 0;
+        authenticate_compress = 0;
         break;
 
       case CLIENT_AUTHENTICATE_CREDENTIALS:
@@ -18398,6 +19493,7 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
         break;
 
       case CLIENT_AUTHENTICATE_CREDENTIALS_PASSWORD:
+      case CLIENT_AUTHENTICATE_CREDENTIALS_TOKEN:
         set_client_state (CLIENT_AUTHENTICATE_CREDENTIALS);
         break;
 
@@ -19084,6 +20180,14 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
         set_client_state (CLIENT_AUTHENTIC);
         break;
 
+      case CLIENT_LOGOUT:
+        manage_session_token_revoke (authenticated_token);
+        gvm_free_string_var (&authenticated_token);
+        SEND_TO_CLIENT_OR_FAIL (XML_OK ("logout"));
+        free_credentials (&current_credentials);
+        set_client_state (CLIENT_TOP);
+        break;
+
       case CLIENT_CREATE_ASSET:
         {
           resource_t asset;
@@ -19193,6 +20297,11 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
       CLOSE (CLIENT_CREATE_ASSET_REPORT, FILTER);
       CLOSE (CLIENT_CREATE_ASSET_REPORT_FILTER, TERM);
 
+      case CLIENT_BATCH:
+        if (batch_element_end (gmp_parser, error, element_name))
+          set_client_state (CLIENT_AUTHENTIC);
+        break;
+
       case CLIENT_CREATE_CONFIG:
         if (create_config_element_end (gmp_parser, error, element_name))
           set_client_state (CLIENT_AUTHENTIC);
@@ -20761,6 +21870,7 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
                          create_report_data->host_starts,
                          create_report_data->host_ends,
                          create_report_data->details,
+                         create_report_data->stream_report,
                          &uuid))
             {
               case 99:
@@ -20810,10 +21920,14 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
                     uuid);
                   log_event ("report", "Report", uuid, "created");
                   free (uuid);
+                  /* The import owns the streamed report now. */
+                  create_report_data->stream_report = 0;
                   break;
                 }
             }
 
+          if (create_report_data->stream_report)
+            create_report_stream_abort (create_report_data->stream_report);
           create_report_data_reset (create_report_data);
           set_client_state (CLIENT_AUTHENTIC);
           break;
@@ -25634,6 +26748,13 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
         assert (0);
         break;
     }
+
+  /* Back at the top level means the command is done. */
+  if (client_state == CLIENT_AUTHENTIC)
+    {
+      command_timing_finish ();
+      manage_use_primary ();
+    }
 }
 
 /**
@@ -25680,6 +26801,10 @@ gmp_xml_handle_text (/* unused */ GMarkupParseContext* context,
         append_to_credentials_password (&current_credentials, text, text_len);
         break;
 
+      case CLIENT_AUTHENTICATE_CREDENTIALS_TOKEN:
+        gvm_append_text (&session_token, text, text_len);
+        break;
+
 
       case CLIENT_MODIFY_CONFIG:
         modify_config_element_text (text, text_len);
@@ -25901,6 +27026,10 @@ gmp_xml_handle_text (/* unused */ GMarkupParseContext* context,
               &create_alert_data->part_name);
 
 
+      case CLIENT_BATCH:
+        batch_element_text (text, text_len);
+        break;
+
       case CLIENT_CREATE_CONFIG:
         create_config_element_text (text, text_len);
         break;
@@ -26706,6 +27835,31 @@ init_gmp_process (const db_conn_info_t *database,
                   (GDestroyNotify) gmp_parser_free);
 }
 
+/**
+ * @brief Clean up the GMP state of a client that has disconnected.
+ *
+ * For processes that serve one client after another.  Must be called
+ * outside the parser, unlike init_gmp_process.
+ */
+void
+cleanup_gmp_process ()
+{
+  if (xml_context)
+    {
+      g_markup_parse_context_free (xml_context);
+      xml_context = NULL;
+    }
+  to_client_start = 0;
+  to_client_end = 0;
+  client_state = CLIENT_TOP;
+  gvm_free_string_var (&session_token);
+  gvm_free_string_var (&authenticated_token);
+  authenticate_session = 0;
+  authenticate_compress = 0;
+  client_compress = 0;
+  manage_reset_currents ();
+}
+
 /**
  * @brief Process any XML available in \ref from_client.
  *
@@ -26735,10 +27889,13 @@ process_gmp_client_input ()
 
   if (xml_context == NULL) return -1;
 
+  /* Cache ACL decisions while processing the commands in the input. */
+  acl_cache_start ();
   success = g_markup_parse_context_parse (xml_context,
                                           from_client + from_client_start,
                                           from_client_end - from_client_start,
                                           &error);
+  acl_cache_stop ();
   if (success == FALSE)
     {
       int err;
@@ -26773,6 +27930,27 @@ process_gmp_client_input ()
   return 0;
 }
 
+/**
+ * @brief Restore the timing of the outer command after process_gmp.
+ *
+ * Drops any timing left by the inner command, and adds the SQL statistics
+ * of the outer command from before the inner command back in.
+ *
+ * @param[in]  name        Name of the outer command, or NULL.
+ * @param[in]  start_time  Start time of the outer command.
+ * @param[in]  sql_count   SQL statement count of the outer command.
+ * @param[in]  sql_time    SQL statement time of the outer command.
+ */
+static void
+process_gmp_timing_restore (gchar *name, gint64 start_time, int sql_count,
+                            gint64 sql_time)
+{
+  g_free (command_timing_name);
+  command_timing_name = name;
+  command_timing_start_time = start_time;
+  manage_sql_stats_add (sql_count, sql_time);
+}
+
 /**
  * @brief Buffer the response for process_gmp.
  *
@@ -26822,6 +28000,17 @@ process_gmp (gmp_parser_t *parser, const gchar *command, gchar **response)
   GMarkupParseContext *old_xml_context;
   client_state_t old_client_state;
   command_data_t old_command_data;
+  gchar *old_timing_name;
+  gint64 old_timing_start_time, old_sql_time;
+  int old_sql_count;
+
+  /* Keep the timing of the outer command, because the command times
+   * itself and resets the SQL statistics. */
+  old_timing_name = command_timing_name;
+  old_timing_start_time = command_timing_start_time;
+  command_timing_name = NULL;
+  manage_sql_stats (&old_sql_count, &old_sql_time);
+  manage_sql_stats_reset ();
 
   /* Terminate any pending transaction. (force close = TRUE). */
   manage_transaction_stop (TRUE);
@@ -26833,6 +28022,8 @@ process_gmp (gmp_parser_t *parser, const gchar *command, gchar **response)
   if (xml_context == NULL)
     {
       xml_context = old_xml_context;
+      process_gmp_timing_restore (old_timing_name, old_timing_start_time,
+                                  old_sql_count, old_sql_time);
       return -1;
     }
 
@@ -26854,6 +28045,8 @@ process_gmp (gmp_parser_t *parser, const gchar *command, gchar **response)
   xml_context = old_xml_context;
   client_state = old_client_state;
   command_data = old_command_data;
+  process_gmp_timing_restore (old_timing_name, old_timing_start_time,
+                              old_sql_count, old_sql_time);
   if (success == FALSE)
     {
       int err;
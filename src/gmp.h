@@ -55,6 +55,9 @@ void
 init_gmp_process (const db_conn_info_t *, int (*) (const char *, void *),
                   void *, gchar **);
 
+void
+cleanup_gmp_process ();
+
 int
 process_gmp_client_input ();
 
@@ -63,4 +66,6 @@ extern char to_client[];
 extern buffer_size_t to_client_start;
 extern buffer_size_t to_client_end;
 
+extern int client_compress;
+
 #endif /* not _GVMD_MANAGE_H */
@@ -95,13 +95,15 @@ get_data_parse_attributes (get_data_t *data, const gchar *type,
  * @param[in]  setting_name  Type name for setting.
  * @param[out] first         First result, from filter.
  *
- * @return 0 success, -1 error.
+ * @return 0 success, 2 invalid "after" token in filter, 99 permission
+ *         denied, -1 error.
  */
 int
 init_get (gchar *command, get_data_t * get, const gchar *setting_name,
           int *first)
 {
   gchar *filter, *replacement;
+  resource_t after;
 
   if (acl_user_may (command) == 0)
     return 99;
@@ -203,11 +205,65 @@ init_get (gchar *command, get_data_t * get, const gchar *setting_name,
   manage_filter_controls (filter ? filter : get->filter, first, NULL, NULL,
                           NULL);
 
+  if (filter_term_after (filter ? filter : get->filter, &after, NULL) < 0)
+    {
+      g_free (filter);
+      return 2;
+    }
+
   g_free (filter);
 
   return 0;
 }
 
+/**
+ * @brief Check whether a GET uses keyset pagination.
+ *
+ * Keyset pagination is selected by an "after" keyword in the filter.
+ *
+ * @param[in]  get  GET command data.
+ *
+ * @return 1 if keyset pagination, else 0.
+ */
+static int
+get_keyset (get_data_t *get)
+{
+  if (get->keyset == 0)
+    {
+      gchar *filter, *after;
+
+      if (get->filt_id && strcmp (get->filt_id, FILT_ID_NONE))
+        filter = get->filter_replacement
+                  ? g_strdup (get->filter_replacement)
+                  : filter_term (get->filt_id);
+      else
+        filter = g_strdup (get->filter);
+
+      after = filter_term_value (filter, "after");
+      get->keyset = after ? 2 : 1;
+      g_free (after);
+      g_free (filter);
+    }
+  return get->keyset == 2;
+}
+
+/**
+ * @brief Remember the last resource of a keyset paginated GET.
+ *
+ * @param[in]  resources  Resource iterator.
+ * @param[in]  get        GET command data.
+ */
+static void
+get_keyset_note (iterator_t *resources, get_data_t *get)
+{
+  if (get_keyset (get))
+    {
+      g_free (get->keyset_last);
+      get->keyset_last = keyset_token (get_iterator_resource (resources),
+                                       get_iterator_uuid (resources));
+    }
+}
+
 /**
  * @brief Iterate a GET iterator.
  *
@@ -255,6 +311,7 @@ get_next (iterator_t *resources, get_data_t *get, int *first, int *count,
      if (next (resources) == FALSE)
        return 1;
    }
+ get_keyset_note (resources, get);
  return 0;
 }
 
@@ -660,12 +717,16 @@ send_get_end_internal (const char *type, get_data_t *get, int get_counts,
                             "<sort>"
                             "<field>%s<order>%s</order></field>"
                             "</sort>"
-                            "<%s start=\"%i\" max=\"%i\"/>",
+                            "<%s start=\"%i\" max=\"%i\"",
                             sort_field,
                             sort_order ? "ascending" : "descending",
                             type_many->str,
                             first,
                             max);
+  if (get_keyset (get) && get->keyset_last)
+    /* Continuation token, for "after=" in the filter of the next page. */
+    buffer_xml_append_printf (msg, " after=\"%s\"", get->keyset_last);
+  buffer_xml_append_printf (msg, "/>");
   if (get_counts)
     buffer_xml_append_printf (msg,
                               "<%s_count>"
@@ -46,6 +46,10 @@ init_get (gchar *, get_data_t *, const gchar *, int *);
           SEND_TO_CLIENT_OR_FAIL (XML_ERROR_SYNTAX (                       \
             "get_" G_STRINGIFY (type) "s", "Permission denied"));          \
           break;                                                           \
+        case 2:                                                            \
+          SEND_TO_CLIENT_OR_FAIL (XML_ERROR_SYNTAX (                       \
+            "get_" G_STRINGIFY (type) "s", "Invalid after in filter"));    \
+          break;                                                           \
         default:                                                           \
           internal_error_send_to_client (error);                           \
           return;                                                          \
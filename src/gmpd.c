@@ -33,17 +33,20 @@
 
 #include "gmpd.h"
 #include "gmp.h"
+#include "manage_metrics.h"
 
 #include <assert.h>
 #include <dirent.h>
 #include <errno.h>
+#include <poll.h>
 #include <string.h>
-#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <zlib.h>
 
 #include <gvm/util/serverutils.h>
 
@@ -77,6 +80,29 @@ buffer_size_t from_client_start = 0;
  */
 buffer_size_t from_client_end = 0;
 
+/**
+ * @brief Compression stream for output to the client.
+ */
+static z_stream client_zstream;
+
+/**
+ * @brief Whether \ref client_zstream has been initialised.
+ */
+static int client_zstream_ready = 0;
+
+/**
+ * @brief Free the compression stream for output to the client.
+ */
+static void
+compress_end ()
+{
+  if (client_zstream_ready)
+    {
+      deflateEnd (&client_zstream);
+      client_zstream_ready = 0;
+    }
+}
+
 /**
  * @brief Initialise the GMP library for the GMP daemon.
  *
@@ -119,6 +145,20 @@ init_gmpd_process (const db_conn_info_t *database, gchar **disable)
   init_gmp_process (database, NULL, NULL, disable);
 }
 
+/**
+ * @brief Clean up a process in the GMP daemon after serving a client.
+ *
+ * Leaves the database open, so that the process can serve another client.
+ */
+void
+cleanup_gmpd_process ()
+{
+  from_client_start = 0;
+  from_client_end = 0;
+  compress_end ();
+  cleanup_gmp_process ();
+}
+
 /**
  * @brief Read as much from the client as the \ref from_client buffer will hold.
  *
@@ -139,7 +179,7 @@ read_from_client_unix (int client_socket)
       if (count < 0)
         {
           if (errno == EAGAIN)
-            /* Got everything available, return to `select'. */
+            /* Got everything available, return to `poll'. */
             return 0;
           if (errno == EINTR)
             /* Interrupted, try read again. */
@@ -189,7 +229,7 @@ read_from_client_tls (gnutls_session_t* client_session)
       if (count < 0)
         {
           if (count == GNUTLS_E_AGAIN)
-            /* Got everything available, return to `select'. */
+            /* Got everything available, return to `poll'. */
             return 0;
           if (count == GNUTLS_E_INTERRUPTED)
             /* Interrupted, try read again. */
@@ -347,10 +387,190 @@ write_to_client (gvm_connection_t *client_connection)
   return write_to_client_unix (client_connection->socket);
 }
 
+/**
+ * @brief Write \ref to_client and then a message to the client.
+ *
+ * The message is written straight from the memory of the caller, instead
+ * of being copied into \ref to_client first.  On a plain socket the buffer
+ * and the message go out together with writev.
+ *
+ * @param[in]  client_connection  The client connection.
+ * @param[in]  msg                The message.
+ * @param[in]  length             Length of the message.
+ * @param[out] written            Number of bytes of the message written.
+ *
+ * @return 0 wrote everything, -1 error, -2 wrote as much as client accepted.
+ */
+static int
+write_to_client_with (gvm_connection_t *client_connection, const char *msg,
+                      size_t length, size_t *written)
+{
+  *written = 0;
+
+  if (client_connection->tls)
+    {
+      int ret;
+
+      ret = write_to_client_tls (&client_connection->session);
+      if (ret)
+        return ret;
+
+      while (*written < length)
+        {
+          ssize_t count;
+          count = gnutls_record_send (client_connection->session,
+                                      msg + *written,
+                                      length - *written);
+          if (count < 0)
+            {
+              if (count == GNUTLS_E_AGAIN)
+                /* Wrote as much as client would accept. */
+                return -2;
+              if (count == GNUTLS_E_INTERRUPTED)
+                /* Interrupted, try write again. */
+                continue;
+              if (count == GNUTLS_E_REHANDSHAKE)
+                /** @todo Rehandshake. */
+                continue;
+              g_warning ("%s: failed to write to client: %s",
+                         __func__,
+                         gnutls_strerror ((int) count));
+              return -1;
+            }
+          *written += count;
+          g_debug ("=> client  %u bytes", (unsigned int) count);
+        }
+      return 0;
+    }
+
+  while ((to_client_start < to_client_end) || (*written < length))
+    {
+      struct iovec iov[2];
+      int iovcnt;
+      ssize_t count;
+      size_t buffered;
+
+      iovcnt = 0;
+      buffered = to_client_end - to_client_start;
+      if (buffered)
+        {
+          iov[iovcnt].iov_base = to_client + to_client_start;
+          iov[iovcnt].iov_len = buffered;
+          iovcnt++;
+        }
+      if (*written < length)
+        {
+          iov[iovcnt].iov_base = (char *) msg + *written;
+          iov[iovcnt].iov_len = length - *written;
+          iovcnt++;
+        }
+
+      count = writev (client_connection->socket, iov, iovcnt);
+      if (count < 0)
+        {
+          if (errno == EAGAIN)
+            /* Wrote as much as client would accept. */
+            return -2;
+          if (errno == EINTR)
+            /* Interrupted, try write again. */
+            continue;
+          g_warning ("%s: failed to write to client: %s",
+                     __func__,
+                     strerror (errno));
+          return -1;
+        }
+      if ((size_t) count >= buffered)
+        {
+          to_client_start = to_client_end = 0;
+          *written += count - buffered;
+        }
+      else
+        to_client_start += count;
+      g_debug ("=> client  %u bytes", (unsigned int) count);
+    }
+  g_debug ("=> client  done");
+
+  /* Wrote everything. */
+  return 0;
+}
+
+/**
+ * @brief Compress data into \ref to_client.
+ *
+ * Writes \ref to_client to the client whenever it fills up.
+ *
+ * @param[in]  client_connection  The client connection.
+ * @param[in]  msg                The data.
+ * @param[in]  length             Length of the data.
+ * @param[in]  flush              zlib flush mode.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+compress_to_client (gvm_connection_t *client_connection, const char *msg,
+                    size_t length, int flush)
+{
+  if (client_zstream_ready == 0)
+    {
+      memset (&client_zstream, 0, sizeof (client_zstream));
+      /* 16 + MAX_WBITS selects gzip framing. */
+      if (deflateInit2 (&client_zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                        16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY)
+          != Z_OK)
+        {
+          g_warning ("%s: failed to initialise compression", __func__);
+          return -1;
+        }
+      client_zstream_ready = 1;
+    }
+
+  client_zstream.next_in = (Bytef *) msg;
+  client_zstream.avail_in = length;
+
+  while (1)
+    {
+      int ret;
+
+      if (to_client_end == TO_CLIENT_BUFFER_SIZE)
+        switch (write_to_client (client_connection))
+          {
+            case  0:      /* Wrote everything. */
+            case -2:      /* Wrote as much as client was willing to accept. */
+              break;
+            case -1:      /* Error. */
+              return -1;
+            default:      /* Programming error. */
+              assert (0);
+          }
+
+      if (to_client_end == TO_CLIENT_BUFFER_SIZE)
+        continue;
+
+      client_zstream.next_out = (Bytef *) to_client + to_client_end;
+      client_zstream.avail_out = TO_CLIENT_BUFFER_SIZE - to_client_end;
+
+      ret = deflate (&client_zstream, flush);
+      if (ret == Z_STREAM_ERROR)
+        {
+          g_warning ("%s: compression failed", __func__);
+          return -1;
+        }
+      to_client_end = TO_CLIENT_BUFFER_SIZE - client_zstream.avail_out;
+
+      /* Done when zlib had output space left over. */
+      if (client_zstream.avail_out)
+        break;
+    }
+
+  return 0;
+}
+
 /**
  * @brief Send a response message to the client.
  *
- * Queue a message in \ref to_client.
+ * Queue a message in \ref to_client.  If the message does not fit, write
+ * out \ref to_client and as much of the message as possible without copying
+ * it, and queue what remains.
  *
  * @param[in]  msg                   The message, a string.
  * @param[in]  write_to_client_data  Argument to \p write_to_client.
@@ -360,25 +580,38 @@ write_to_client (gvm_connection_t *client_connection)
 static gboolean
 gmpd_send_to_client (const char* msg, void* write_to_client_data)
 {
+  size_t length;
+
   assert (to_client_end <= TO_CLIENT_BUFFER_SIZE);
   assert (msg);
 
-  while (((buffer_size_t) TO_CLIENT_BUFFER_SIZE) - to_client_end
-         < strlen (msg))
+  length = strlen (msg);
+
+  if (client_compress)
     {
-      buffer_size_t length;
+      g_debug ("-> client: %zu bytes compressed", length);
+      return compress_to_client (write_to_client_data, msg, length,
+                                 Z_NO_FLUSH)
+             ? TRUE
+             : FALSE;
+    }
+
+  while (((buffer_size_t) TO_CLIENT_BUFFER_SIZE) - to_client_end < length)
+    {
+      size_t written;
 
       /* Too little space in to_client buffer for message. */
 
-      switch (write_to_client (write_to_client_data))
+      switch (write_to_client_with (write_to_client_data, msg, length,
+                                    &written))
         {
-          case  0:      /* Wrote everything in to_client. */
+          case  0:      /* Wrote everything. */
             break;
           case -1:      /* Error. */
             g_debug ("   %s full (%i < %zu); client write failed",
                     __func__,
                     ((buffer_size_t) TO_CLIENT_BUFFER_SIZE) - to_client_end,
-                    strlen (msg));
+                    length);
             return TRUE;
           case -2:      /* Wrote as much as client was willing to accept. */
             break;
@@ -386,47 +619,22 @@ gmpd_send_to_client (const char* msg, void* write_to_client_data)
             assert (0);
         }
 
-      length = ((buffer_size_t) TO_CLIENT_BUFFER_SIZE) - to_client_end;
-
-      if (length > strlen (msg))
-        break;
-
-      /* length can be 0 if write_to_client returns -2. */
-
-      if (length > 0)
-        {
-          memmove (to_client + to_client_end, msg, length);
-          g_debug ("-> client: %.*s", (int) length, msg);
-          to_client_end += length;
-          msg += length;
-        }
+      /* Log only the size, to avoid formatting a copy of a large message. */
+      g_debug ("-> client: %zu bytes written directly", written);
+      msg += written;
+      length -= written;
     }
 
-  if (strlen (msg))
+  if (length)
     {
-      assert (strlen (msg)
-              <= (((buffer_size_t) TO_CLIENT_BUFFER_SIZE) - to_client_end));
-      memmove (to_client + to_client_end, msg, strlen (msg));
-      g_debug ("-> client: %s", msg);
-      to_client_end += strlen (msg);
+      memcpy (to_client + to_client_end, msg, length);
+      g_debug ("-> client: %.*s", (int) length, msg);
+      to_client_end += length;
     }
 
   return FALSE;
 }
 
-/**
- * @brief Get nfds value.
- *
- * @param[in]  socket  Highest socket number.
- *
- * @return nfds value for select.
- */
-static int
-get_nfds (int socket)
-{
-  return 1 + socket;
-}
-
 /**
  * @brief Serve the Greenbone Management Protocol (GMP).
  *
@@ -455,7 +663,7 @@ int
 serve_gmp (gvm_connection_t *client_connection, const db_conn_info_t *database,
            gchar **disable)
 {
-  int nfds, rc = 0;
+  int rc = 0;
 
   g_debug ("   Serving GMP");
 
@@ -464,11 +672,12 @@ serve_gmp (gvm_connection_t *client_connection, const db_conn_info_t *database,
                     (int (*) (const char*, void*)) gmpd_send_to_client,
                     (void*) client_connection,
                     disable);
+  metrics_add (METRIC_GMP_CONNECTIONS, 1);
 
   /** @todo Confirm and clarify complications, especially last one. */
   /* Loop handling input from the sockets.
    *
-   * That is, select on all the socket fds and then, as necessary
+   * That is, poll on all the socket fds and then, as necessary
    *   - read from the client into buffer from_client
    *   - write to the client from buffer to_client.
    *
@@ -477,11 +686,11 @@ serve_gmp (gvm_connection_t *client_connection, const db_conn_info_t *database,
    * commands and may write to to_client.
    *
    * There are a few complications here
-   *   - the program must read from or write to an fd returned by select
-   *     before selecting on the fd again,
-   *   - the program need only select on the fds for writing if there is
+   *   - the program must read from or write to an fd returned by poll
+   *     before polling the fd again,
+   *   - the program need only poll the fds for writing if there is
    *     something to write,
-   *   - similarly, the program need only select on the fds for reading
+   *   - similarly, the program need only poll the fds for reading
    *     if there is buffer space available,
    *   - the buffer from_client can become full during reading
    *   - a read from the client can be stalled by the to_client buffer
@@ -489,30 +698,28 @@ serve_gmp (gvm_connection_t *client_connection, const db_conn_info_t *database,
    *     write the to_client buffer itself),
    */
 
-  nfds = get_nfds (client_connection->socket);
   while (1)
     {
-      int ret;
-      fd_set readfds, writefds;
+      int ret, readable, writable;
+      struct pollfd fds[1];
 
-      /* Setup for select. */
-
-      /** @todo nfds must only include a socket if it's in >= one set. */
-
-      FD_ZERO (&readfds);
-      FD_ZERO (&writefds);
+      /* Setup for poll. */
 
       /** @todo Shutdown on failure (for example, if a read fails). */
 
+      fds[0].fd = client_connection->socket;
+      fds[0].events = 0;
+      fds[0].revents = 0;
+
       /* See whether to read from the client.  */
       if (from_client_end < from_buffer_size)
-        FD_SET (client_connection->socket, &readfds);
+        fds[0].events |= POLLIN;
       /* See whether to write to the client.  */
       if (to_client_start < to_client_end)
-        FD_SET (client_connection->socket, &writefds);
+        fds[0].events |= POLLOUT;
 
-      /* Select, then handle result.  Due to GNUTLS internal buffering
-       * we test for pending records first and emulate a select call
+      /* Poll, then handle result.  Due to GNUTLS internal buffering
+       * we test for pending records first and emulate a poll call
        * in that case.  Note, that GNUTLS guarantees that writes are
        * not buffered.  Note also that GNUTLS versions < 3 did not
        * exhibit a problem in Scanner due to a different buffering
@@ -520,30 +727,35 @@ serve_gmp (gvm_connection_t *client_connection, const db_conn_info_t *database,
       ret = 0;
       if (client_connection->socket > 0
           && client_connection->tls
-          && FD_ISSET (client_connection->socket, &readfds)
+          && (fds[0].events & POLLIN)
           && gnutls_record_check_pending (client_connection->session))
         {
-          FD_ZERO (&readfds);
-          FD_ZERO (&writefds);
           ret++;
-          FD_SET (client_connection->socket, &readfds);
+          fds[0].revents = POLLIN;
         }
 
       if (!ret)
-        ret = select (nfds, &readfds, &writefds, NULL, NULL);
+        ret = poll (fds, 1, -1);
       if ((ret < 0 && errno == EINTR) || ret == 0)
         continue;
       if (ret < 0)
         {
-          g_warning ("%s: child select failed: %s", __func__,
+          g_warning ("%s: child poll failed: %s", __func__,
                      strerror (errno));
           rc = -1;
           goto client_free;
         }
 
+      /* A hangup or error shows up as readable, so that the read reports
+       * it, as with select. */
+      readable = (fds[0].events & POLLIN)
+                 && (fds[0].revents & (POLLIN | POLLHUP | POLLERR));
+      writable = (fds[0].events & POLLOUT)
+                 && (fds[0].revents & (POLLOUT | POLLERR));
+
       /* Read any data from the client. */
       if (client_connection->socket > 0
-          && FD_ISSET (client_connection->socket, &readfds))
+          && readable)
         {
           buffer_size_t initial_start = from_client_end;
 
@@ -560,7 +772,7 @@ serve_gmp (gvm_connection_t *client_connection, const db_conn_info_t *database,
               case -3:       /* End of file. */
                 g_debug ("   EOF reading from client");
                 if (client_connection->socket > 0
-                    && FD_ISSET (client_connection->socket, &writefds))
+                    && writable)
                   /* Write rest of to_client to client, so that the client gets
                    * any buffered output and the response to the error. */
                   write_to_client (client_connection);
@@ -585,6 +797,13 @@ serve_gmp (gvm_connection_t *client_connection, const db_conn_info_t *database,
             }
 
           ret = process_gmp_client_input ();
+          if (client_compress
+              && compress_to_client (client_connection, "", 0,
+                                     Z_SYNC_FLUSH))
+            {
+              rc = -1;
+              goto client_free;
+            }
           if (ret == 0)
             /* Processed all input. */
             ;
@@ -606,7 +825,7 @@ serve_gmp (gvm_connection_t *client_connection, const db_conn_info_t *database,
 
       /* Write any data to the client. */
       if (client_connection->socket > 0
-          && FD_ISSET (client_connection->socket, &writefds))
+          && writable)
         {
           /* Write as much as possible to the client. */
 
@@ -626,6 +845,8 @@ serve_gmp (gvm_connection_t *client_connection, const db_conn_info_t *database,
     } /* while (1) */
 
 client_free:
+  metrics_add (METRIC_GMP_CONNECTIONS, -1);
+  compress_end ();
   gvm_connection_free (client_connection);
   return rc;
 }
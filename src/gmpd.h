@@ -51,6 +51,9 @@ init_gmpd (GSList *, const db_conn_info_t *, int, int, int, int,
 void
 init_gmpd_process (const db_conn_info_t *, gchar **);
 
+void
+cleanup_gmpd_process ();
+
 int
 serve_gmp (gvm_connection_t *, const db_conn_info_t *, gchar **);
 
@@ -0,0 +1,145 @@
+/* Copyright (C) 2021 Greenbone Networks GmbH
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gmpd.c"
+
+#include <cgreen/cgreen.h>
+
+Describe (gmpd);
+BeforeEach (gmpd)
+{
+  to_client_start = to_client_end = 0;
+}
+AfterEach (gmpd)
+{
+  compress_end ();
+  to_client_start = to_client_end = 0;
+}
+
+/* compress_to_client */
+
+/**
+ * @brief Inflate the data in to_client, and empty to_client.
+ *
+ * @param[in]  stream  Inflate stream, set up for gzip framing.
+ * @param[out] out     Buffer for the inflated data.
+ * @param[in]  size    Size of out, including room for a trailing NUL.
+ *
+ * @return Result of inflate.
+ */
+static int
+inflate_to_client (z_stream *stream, char *out, size_t size)
+{
+  int ret;
+
+  stream->next_in = (Bytef *) to_client + to_client_start;
+  stream->avail_in = to_client_end - to_client_start;
+  stream->next_out = (Bytef *) out;
+  stream->avail_out = size - 1;
+  ret = inflate (stream, Z_SYNC_FLUSH);
+  out[size - 1 - stream->avail_out] = '\0';
+  to_client_start = to_client_end = 0;
+  return ret;
+}
+
+Ensure (gmpd, compress_to_client_writes_gzip_header)
+{
+  assert_that (compress_to_client (NULL, "<a/>", strlen ("<a/>"),
+                                   Z_SYNC_FLUSH),
+               is_equal_to (0));
+
+  assert_that (to_client_end, is_greater_than (10));
+  assert_that ((unsigned char) to_client[0], is_equal_to (0x1f));
+  assert_that ((unsigned char) to_client[1], is_equal_to (0x8b));
+  /* Deflate. */
+  assert_that (to_client[2], is_equal_to (8));
+}
+
+Ensure (gmpd, compress_to_client_output_inflates_at_sync_flush)
+{
+  z_stream stream;
+  char out[64];
+
+  assert_that (compress_to_client (NULL, "<get_version_response>",
+                                   strlen ("<get_version_response>"),
+                                   Z_NO_FLUSH),
+               is_equal_to (0));
+  assert_that (compress_to_client (NULL, "</get_version_response>",
+                                   strlen ("</get_version_response>"),
+                                   Z_NO_FLUSH),
+               is_equal_to (0));
+  assert_that (compress_to_client (NULL, "", 0, Z_SYNC_FLUSH),
+               is_equal_to (0));
+
+  memset (&stream, 0, sizeof (stream));
+  assert_that (inflateInit2 (&stream, 16 + MAX_WBITS), is_equal_to (Z_OK));
+  assert_that (inflate_to_client (&stream, out, sizeof (out)),
+               is_equal_to (Z_OK));
+  assert_that (out,
+               is_equal_to_string ("<get_version_response>"
+                                   "</get_version_response>"));
+  inflateEnd (&stream);
+}
+
+Ensure (gmpd, compress_to_client_continues_stream_across_responses)
+{
+  z_stream stream;
+  char out[64];
+
+  memset (&stream, 0, sizeof (stream));
+  assert_that (inflateInit2 (&stream, 16 + MAX_WBITS), is_equal_to (Z_OK));
+
+  assert_that (compress_to_client (NULL, "<a/>", strlen ("<a/>"),
+                                   Z_SYNC_FLUSH),
+               is_equal_to (0));
+  assert_that (inflate_to_client (&stream, out, sizeof (out)),
+               is_equal_to (Z_OK));
+  assert_that (out, is_equal_to_string ("<a/>"));
+
+  /* The second response has no header of its own. */
+  assert_that (compress_to_client (NULL, "<b/>", strlen ("<b/>"),
+                                   Z_SYNC_FLUSH),
+               is_equal_to (0));
+  assert_that ((unsigned char) to_client[0], is_not_equal_to (0x1f));
+  assert_that (inflate_to_client (&stream, out, sizeof (out)),
+               is_equal_to (Z_OK));
+  assert_that (out, is_equal_to_string ("<b/>"));
+
+  inflateEnd (&stream);
+}
+
+/* Test suite. */
+
+int
+main (int argc, char **argv)
+{
+  TestSuite *suite;
+
+  suite = create_test_suite ();
+
+  add_test_with_context (suite, gmpd, compress_to_client_writes_gzip_header);
+  add_test_with_context (suite, gmpd,
+                         compress_to_client_output_inflates_at_sync_flush);
+  add_test_with_context (suite, gmpd,
+                         compress_to_client_continues_stream_across_responses);
+
+  if (argc > 1)
+    return run_single_test (suite, argv[1], create_text_reporter ());
+
+  return run_test_suite (suite, create_text_reporter ());
+}
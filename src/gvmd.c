@@ -66,6 +66,13 @@
  * \htmlinclude doc/gvmd.html
  */
 
+/**
+ * @brief Enable extra GNU functions.
+ *
+ * ppoll () needs this.
+ */
+#define _GNU_SOURCE
+
 #include <locale.h>
 
 #include <arpa/inet.h>
@@ -83,8 +90,8 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <poll.h>
 #include <string.h>
-#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/types.h>
@@ -100,6 +107,8 @@
 #include <gvm/util/ldaputils.h>
 
 #include "manage.h"
+#include "manage_acl.h"
+#include "manage_metrics.h"
 #include "manage_sql_nvts.h"
 #include "manage_sql_secinfo.h"
 #include "manage_authentication.h"
@@ -187,6 +196,38 @@
  */
 static int client_watch_interval = DEFAULT_CLIENT_WATCH_INTERVAL;
 
+/**
+ * @brief Default number of GMP worker processes, 0 for a process per client.
+ */
+#define GMP_WORKERS_DEFAULT 0
+
+/**
+ * @brief Maximum number of GMP worker processes.
+ */
+#define GMP_WORKERS_MAX 64
+
+/**
+ * @brief Number of clients a GMP worker serves before it is replaced.
+ *
+ * Bounds the growth of the per-process caches of a worker.
+ */
+#define GMP_WORKER_CLIENTS 1000
+
+/**
+ * @brief Number of GMP worker processes, 0 for a process per client.
+ */
+static int gmp_workers = GMP_WORKERS_DEFAULT;
+
+/**
+ * @brief Seconds between writes of the metrics file.
+ */
+#define METRICS_PERIOD 15
+
+/**
+ * @brief File that the main process writes metrics to, or NULL.
+ */
+static gchar *metrics_file = NULL;
+
 /**
  * @brief The socket accepting GMP connections from clients.
  */
@@ -283,6 +324,21 @@ static int update_in_progress = 0;
  */
 static int feed_version_check_in_progress = 0;
 
+/**
+ * @brief PIDs of the OSP scan monitors, 0 where a monitor is not running.
+ */
+static int osp_scan_monitor_pids[OSP_SCAN_MONITORS_MAX];
+
+/**
+ * @brief PIDs of the alert workers, 0 where a worker is not running.
+ */
+static int alert_worker_pids[ALERT_WORKERS_MAX];
+
+/**
+ * @brief PIDs of the GMP workers, 0 where a worker is not running.
+ */
+static int gmp_worker_pids[GMP_WORKERS_MAX];
+
 /**
  * @brief Logging parameters, as passed to setup_log_handlers.
  */
@@ -478,7 +534,7 @@ serve_client (int server_socket, gvm_connection_t *client_connection)
     }
 
   /* The socket must have O_NONBLOCK set, in case an "asynchronous network
-   * error" removes the data between `select' and `read'. */
+   * error" removes the data between `poll' and `read'. */
   if (fcntl (client_connection->socket, F_SETFL, O_NONBLOCK) == -1)
     {
       g_warning ("%s: failed to set real client socket flag: %s",
@@ -554,7 +610,7 @@ accept_and_maybe_fork (int server_socket, sigset_t *sigmask_current)
       if (errno == EINTR)
         continue;
       if (errno == EAGAIN || errno == EWOULDBLOCK)
-        /* The connection is gone, return to select. */
+        /* The connection is gone, return to poll. */
         return;
       g_critical ("%s: failed to accept client connection: %s",
                   __func__,
@@ -584,7 +640,7 @@ accept_and_maybe_fork (int server_socket, sigset_t *sigmask_current)
 
           proctitle_set ("gvmd: Serving client");
 
-          /* Restore the sigmask that was blanked for pselect. */
+          /* Restore the sigmask that was blanked for ppoll. */
           pthread_sigmask (SIG_SETMASK, sigmask_current, NULL);
 
           memset (&action, '\0', sizeof (action));
@@ -601,7 +657,7 @@ accept_and_maybe_fork (int server_socket, sigset_t *sigmask_current)
             }
 
           /* The socket must have O_NONBLOCK set, in case an "asynchronous
-           * network error" removes the data between `select' and `read'.
+           * network error" removes the data between `poll' and `read'.
            */
           if (fcntl (client_socket, F_SETFL, O_NONBLOCK) == -1)
             {
@@ -623,18 +679,198 @@ accept_and_maybe_fork (int server_socket, sigset_t *sigmask_current)
           exit (ret);
         }
       case -1:
-        /* Parent when error, return to select. */
+        /* Parent when error, return to poll. */
         g_warning ("%s: failed to fork child: %s",
                    __func__,
                    strerror (errno));
         close (client_socket);
         break;
       default:
-        /* Parent.  Return to select. */
+        /* Parent.  Return to poll. */
         close (client_socket);
         break;
     }
 }
+/**
+ * @brief Serve clients one after another in a GMP worker process.
+ *
+ * The workers share the manager sockets, so each connection goes to the
+ * worker that accepts it first.  The database stays open from one client
+ * to the next.
+ *
+ * Returns when the parent exits, when serving a client fails, or after
+ * GMP_WORKER_CLIENTS clients, so that the parent starts a fresh worker.
+ */
+static void
+serve_gmp_worker ()
+{
+  pid_t parent;
+  int served;
+
+  parent = getppid ();
+  served = 0;
+  while ((getppid () == parent) && (served < GMP_WORKER_CLIENTS))
+    {
+      int ret, nfds, server_socket, client_socket;
+      struct pollfd fds[2];
+      struct sockaddr_storage addr;
+      socklen_t addrlen;
+      gvm_connection_t client_connection;
+
+      nfds = 0;
+      fds[nfds].fd = manager_socket;
+      fds[nfds++].events = POLLIN;
+      if (manager_socket_2 > -1)
+        {
+          fds[nfds].fd = manager_socket_2;
+          fds[nfds++].events = POLLIN;
+        }
+
+      /* Wake up now and then to notice if the parent has exited. */
+      ret = poll (fds, nfds, 1000);
+      if (ret == -1)
+        {
+          if (errno == EINTR)
+            continue;
+          g_warning ("%s: poll failed: %s", __func__, strerror (errno));
+          return;
+        }
+      if (ret == 0)
+        continue;
+
+      server_socket = (fds[0].revents & POLLIN)
+                       ? manager_socket
+                       : manager_socket_2;
+      addrlen = sizeof (addr);
+      client_socket = accept (server_socket, (struct sockaddr *) &addr,
+                              &addrlen);
+      if (client_socket == -1)
+        {
+          if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+            /* Another worker accepted the connection. */
+            continue;
+          g_warning ("%s: failed to accept client connection: %s",
+                     __func__,
+                     strerror (errno));
+          return;
+        }
+      sockaddr_as_str (&addr, client_address);
+
+      /* The socket must have O_NONBLOCK set, in case an "asynchronous
+       * network error" removes the data between `poll' and `read'. */
+      if (fcntl (client_socket, F_SETFL, O_NONBLOCK) == -1)
+        {
+          g_warning ("%s: failed to set client socket flag: %s",
+                     __func__,
+                     strerror (errno));
+          shutdown (client_socket, SHUT_RDWR);
+          close (client_socket);
+          continue;
+        }
+
+      /* For TLS, create a new session, because the previous client freed
+       * the old one. */
+      if (use_tls)
+        {
+          if (gvm_server_new (GNUTLS_SERVER,
+                              CACERT,
+                              SCANNERCERT,
+                              SCANNERKEY,
+                              &client_session,
+                              &client_credentials))
+            {
+              g_critical ("%s: client server initialisation failed",
+                          __func__);
+              shutdown (client_socket, SHUT_RDWR);
+              close (client_socket);
+              return;
+            }
+          set_gnutls_priority (&client_session, priorities_option);
+          if (dh_params_option
+              && set_gnutls_dhparams (client_credentials, dh_params_option))
+            g_warning ("Couldn't set DH parameters from %s", dh_params_option);
+        }
+
+      memset (&client_connection, 0, sizeof (client_connection));
+      client_connection.tls = use_tls;
+      client_connection.socket = client_socket;
+      client_connection.session = client_session;
+      client_connection.credentials = client_credentials;
+      ret = serve_client (server_socket, &client_connection);
+      cleanup_gmpd_process ();
+      served++;
+      if (ret)
+        return;
+    }
+}
+
+/**
+ * @brief Fork the GMP workers that are not running.
+ *
+ * @param[in]  sigmask_current  Sigmask to restore in child.
+ */
+static void
+fork_gmp_workers (sigset_t *sigmask_current)
+{
+  int index;
+
+  for (index = 0; index < gmp_workers; index++)
+    {
+      int pid;
+
+      if (gmp_worker_pids[index])
+        continue;
+
+      /* Use the default handlers for termination signals in the child,
+       * as in accept_and_maybe_fork. */
+      pid = fork_with_handlers ();
+      switch (pid)
+        {
+          case 0:
+            /* Child. */
+            {
+              struct sigaction action;
+
+              is_parent = 0;
+
+              proctitle_set ("gvmd: GMP worker");
+
+              /* Restore the sigmask that was blanked for ppoll. */
+              pthread_sigmask (SIG_SETMASK, sigmask_current, NULL);
+
+              memset (&action, '\0', sizeof (action));
+              sigemptyset (&action.sa_mask);
+              action.sa_handler = SIG_DFL;
+              if (sigaction (SIGCHLD, &action, NULL) == -1)
+                {
+                  g_critical ("%s: failed to set client SIGCHLD handler: %s",
+                              __func__,
+                              strerror (errno));
+                  exit (EXIT_FAILURE);
+                }
+
+              /* Reopen the database (required after fork). */
+              cleanup_manage_process (FALSE);
+
+              serve_gmp_worker ();
+
+              cleanup_manage_process (FALSE);
+              exit (EXIT_SUCCESS);
+            }
+
+          case -1:
+            /* Parent when error. */
+            g_warning ("%s: fork: %s", __func__, strerror (errno));
+            return;
+
+          default:
+            /* Parent.  Continue. */
+            g_debug ("%s: %i forked %i", __func__, getpid (), pid);
+            gmp_worker_pids[index] = pid;
+            break;
+        }
+    }
+}
 
 
 /* Connection forker for scheduler. */
@@ -687,7 +923,7 @@ fork_connection_internal (gvm_connection_t *client_connection,
    * commands.  The caller must exit this process.
    */
 
-  /* Restore the sigmask that was blanked for pselect. */
+  /* Restore the sigmask that was blanked for ppoll. */
   if (sigmask_normal)
     pthread_sigmask (SIG_SETMASK, sigmask_normal, NULL);
 
@@ -730,7 +966,7 @@ fork_connection_internal (gvm_connection_t *client_connection,
           }
 
         /* The socket must have O_NONBLOCK set, in case an "asynchronous
-         * network error" removes the data between `select' and `read'.
+         * network error" removes the data between `poll' and `read'.
          */
         if (fcntl (parent_client_socket, F_SETFL, O_NONBLOCK) == -1)
           {
@@ -1020,7 +1256,7 @@ handle_sigsegv (/* unused */ int given_signal)
 static void
 handle_sigchld (/* unused */ int given_signal, siginfo_t *info, void *ucontext)
 {
-  int status, pid;
+  int status, pid, index;
   while ((pid = waitpid (-1, &status, WNOHANG)) > 0)
     {
       if (update_in_progress == pid)
@@ -1030,6 +1266,21 @@ handle_sigchld (/* unused */ int given_signal, siginfo_t *info, void *ucontext)
       if (feed_version_check_in_progress == pid)
         /* This was a version check child, so allow version checks again */
         feed_version_check_in_progress = 0;
+
+      for (index = 0; index < OSP_SCAN_MONITORS_MAX; index++)
+        if (osp_scan_monitor_pids[index] == pid)
+          /* This was an OSP scan monitor, so allow it to be restarted. */
+          osp_scan_monitor_pids[index] = 0;
+
+      for (index = 0; index < ALERT_WORKERS_MAX; index++)
+        if (alert_worker_pids[index] == pid)
+          /* This was an alert worker, so allow it to be restarted. */
+          alert_worker_pids[index] = 0;
+
+      for (index = 0; index < GMP_WORKERS_MAX; index++)
+        if (gmp_worker_pids[index] == pid)
+          /* This was a GMP worker, so allow it to be restarted. */
+          gmp_worker_pids[index] = 0;
     }
 }
 
@@ -1306,6 +1557,123 @@ fork_feed_sync ()
     }
 }
 
+/**
+ * @brief Fork the OSP scan monitors that are not running.
+ *
+ * Each child monitors its share of the running OSP scans until the parent
+ * exits.
+ */
+static void
+fork_osp_scan_monitors ()
+{
+  int index;
+
+  for (index = 0; index < get_osp_scan_monitors (); index++)
+    {
+      int pid;
+
+      if (osp_scan_monitor_pids[index])
+        continue;
+
+      pid = fork_with_handlers ();
+      switch (pid)
+        {
+          case 0:
+            /* Child.   */
+
+            proctitle_set ("gvmd: OSP scan monitor");
+
+            /* Clean up the process. */
+
+            if (sigmask_normal)
+              pthread_sigmask (SIG_SETMASK, sigmask_normal, NULL);
+            cleanup_manage_process (FALSE);
+            if (manager_socket > -1) close (manager_socket);
+            if (manager_socket_2 > -1) close (manager_socket_2);
+
+            /* Monitor the scans. */
+
+            manage_osp_scan_monitor (index);
+
+            /* Exit. */
+
+            cleanup_manage_process (FALSE);
+            exit (EXIT_SUCCESS);
+
+            break;
+
+          case -1:
+            /* Parent when error. */
+            g_warning ("%s: fork: %s", __func__, strerror (errno));
+            return;
+
+          default:
+            /* Parent.  Continue. */
+            g_debug ("%s: %i forked %i", __func__, getpid (), pid);
+            osp_scan_monitor_pids[index] = pid;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Fork the alert workers that are not running.
+ *
+ * Each child runs the queued alerts until the parent exits.
+ */
+static void
+fork_alert_workers ()
+{
+  int index;
+
+  for (index = 0; index < get_alert_workers (); index++)
+    {
+      int pid;
+
+      if (alert_worker_pids[index])
+        continue;
+
+      pid = fork_with_handlers ();
+      switch (pid)
+        {
+          case 0:
+            /* Child.   */
+
+            proctitle_set ("gvmd: Alert worker");
+
+            /* Clean up the process. */
+
+            if (sigmask_normal)
+              pthread_sigmask (SIG_SETMASK, sigmask_normal, NULL);
+            cleanup_manage_process (FALSE);
+            if (manager_socket > -1) close (manager_socket);
+            if (manager_socket_2 > -1) close (manager_socket_2);
+
+            /* Run the alerts. */
+
+            manage_alert_worker (index);
+
+            /* Exit. */
+
+            cleanup_manage_process (FALSE);
+            exit (EXIT_SUCCESS);
+
+            break;
+
+          case -1:
+            /* Parent when error. */
+            g_warning ("%s: fork: %s", __func__, strerror (errno));
+            return;
+
+          default:
+            /* Parent.  Continue. */
+            g_debug ("%s: %i forked %i", __func__, getpid (), pid);
+            alert_worker_pids[index] = pid;
+            break;
+        }
+    }
+}
+
 /**
  * @brief Serve incoming connections, scheduling periodically.
  *
@@ -1317,12 +1685,13 @@ fork_feed_sync ()
 static void
 serve_and_schedule ()
 {
-  time_t last_schedule_time, last_sync_time;
+  time_t last_schedule_time, last_sync_time, last_metrics_time;
   sigset_t sigmask_all;
   static sigset_t sigmask_current;
 
   last_schedule_time = 0;
   last_sync_time = 0;
+  last_metrics_time = 0;
 
   if (sigfillset (&sigmask_all))
     {
@@ -1337,22 +1706,22 @@ serve_and_schedule ()
   sigmask_normal = &sigmask_current;
   while (1)
     {
-      int ret, nfds;
-      fd_set readfds, exceptfds;
+      int ret, nfds, index, seconds;
+      struct pollfd fds[2];
       struct timespec timeout;
 
-      FD_ZERO (&readfds);
-      FD_SET (manager_socket, &readfds);
-      if (manager_socket_2 > -1)
-        FD_SET (manager_socket_2, &readfds);
-      FD_ZERO (&exceptfds);
-      FD_SET (manager_socket, &exceptfds);
-      if (manager_socket_2 > -1)
-        FD_SET (manager_socket_2, &exceptfds);
-      if (manager_socket >= manager_socket_2)
-        nfds = manager_socket + 1;
-      else
-        nfds = manager_socket_2 + 1;
+      nfds = 0;
+      if (gmp_workers == 0)
+        {
+          /* Without GMP workers this process accepts the connections. */
+          fds[nfds].fd = manager_socket;
+          fds[nfds++].events = POLLIN;
+          if (manager_socket_2 > -1)
+            {
+              fds[nfds].fd = manager_socket_2;
+              fds[nfds++].events = POLLIN;
+            }
+        }
 
       if (termination_signal)
         {
@@ -1365,7 +1734,7 @@ serve_and_schedule ()
           raise (termination_signal);
         }
 
-      if ((time (NULL) - last_schedule_time) >= SCHEDULE_PERIOD)
+      if (manage_schedule_wait (last_schedule_time) == 0)
         switch (manage_schedule (fork_connection_for_scheduler,
                                  scheduling_enabled,
                                  sigmask_normal))
@@ -1387,42 +1756,57 @@ serve_and_schedule ()
           last_sync_time = time (NULL);
         }
 
-      timeout.tv_sec = SCHEDULE_PERIOD;
+      fork_osp_scan_monitors ();
+
+      fork_alert_workers ();
+
+      fork_gmp_workers (sigmask_normal);
+
+      if (metrics_file
+          && (time (NULL) - last_metrics_time) >= METRICS_PERIOD)
+        {
+          manage_metrics_write (metrics_file);
+          last_metrics_time = time (NULL);
+        }
+
+      /* Sleep until the next scheduled task, feed sync or metrics write is
+       * due, or until a signal or a connection arrives. */
+      seconds = manage_schedule_wait (last_schedule_time);
+      seconds = MIN (seconds,
+                     SCHEDULE_PERIOD - (time (NULL) - last_sync_time));
+      if (metrics_file)
+        seconds = MIN (seconds,
+                       METRICS_PERIOD - (time (NULL) - last_metrics_time));
+      timeout.tv_sec = MAX (seconds, 1);
       timeout.tv_nsec = 0;
-      ret = pselect (nfds, &readfds, NULL, &exceptfds, &timeout,
-                     sigmask_normal);
+      ret = ppoll (fds, nfds, &timeout, sigmask_normal);
 
       if (ret == -1)
         {
-          /* Error occurred while selecting socket. */
+          /* Error occurred while polling sockets. */
           if (errno == EINTR)
             continue;
-          g_critical ("%s: select failed: %s",
+          g_critical ("%s: poll failed: %s",
                       __func__,
                       strerror (errno));
           exit (EXIT_FAILURE);
         }
 
       if (ret > 0)
-        {
-          /* Have an incoming connection. */
-          if (FD_ISSET (manager_socket, &exceptfds))
-            {
-              g_critical ("%s: exception in select", __func__);
-              exit (EXIT_FAILURE);
-            }
-          if ((manager_socket_2 > -1) && FD_ISSET (manager_socket_2, &exceptfds))
-            {
-              g_critical ("%s: exception in select (2)", __func__);
-              exit (EXIT_FAILURE);
-            }
-          if (FD_ISSET (manager_socket, &readfds))
-            accept_and_maybe_fork (manager_socket, sigmask_normal);
-          if ((manager_socket_2 > -1) && FD_ISSET (manager_socket_2, &readfds))
-            accept_and_maybe_fork (manager_socket_2, sigmask_normal);
-        }
+        for (index = 0; index < nfds; index++)
+          {
+            if (fds[index].revents & (POLLERR | POLLNVAL))
+              {
+                g_critical ("%s: exception on socket %i",
+                            __func__, fds[index].fd);
+                exit (EXIT_FAILURE);
+              }
+            /* Have an incoming connection. */
+            if (fds[index].revents & POLLIN)
+              accept_and_maybe_fork (fds[index].fd, sigmask_normal);
+          }
 
-      if ((time (NULL) - last_schedule_time) >= SCHEDULE_PERIOD)
+      if (manage_schedule_wait (last_schedule_time) == 0)
         switch (manage_schedule (fork_connection_for_scheduler,
                                  scheduling_enabled, sigmask_normal))
           {
@@ -1600,7 +1984,7 @@ manager_listen (const char *address_str_unix, const char *address_str_tls,
     return 0;
 
   /* The socket must have O_NONBLOCK set, in case an "asynchronous network
-   * error" removes the connection between `select' and `accept'. */
+   * error" removes the connection between `poll' and `accept'. */
   if (fcntl (*soc, F_SETFL, O_NONBLOCK) == -1)
     {
       g_warning ("Failed to set manager socket flag: %s", strerror (errno));
@@ -1742,6 +2126,7 @@ gvmd (int argc, char** argv)
 {
   /* Process options. */
 
+  static gchar *acl_precompute_types = NULL;
   static gboolean check_alerts = FALSE;
   static gboolean migrate_database = FALSE;
   static gboolean encrypt_all_credentials = FALSE;
@@ -1773,7 +2158,12 @@ gvmd (int argc, char** argv)
   static gchar *scanner_key_priv = NULL;
   static int scanner_connection_retry = SCANNER_CONNECTION_RETRY_DEFAULT;
   static int schedule_timeout = SCHEDULE_TIMEOUT_DEFAULT;
+  static int max_active_scans = MAX_ACTIVE_SCANS_DEFAULT;
+  static int max_active_scans_per_scanner
+    = MAX_ACTIVE_SCANS_PER_SCANNER_DEFAULT;
+  static int max_scan_launches = MAX_SCAN_LAUNCHES_DEFAULT;
   static int secinfo_commit_size = SECINFO_COMMIT_SIZE_DEFAULT;
+  static int scap_workers = SCAP_WORKERS_DEFAULT;
   static gchar *delete_scanner = NULL;
   static gchar *verify_scanner = NULL;
   static gchar *priorities = "NORMAL";
@@ -1785,6 +2175,26 @@ gvmd (int argc, char** argv)
   static gchar *new_password = NULL;
   static gchar *optimize = NULL;
   static gchar *osp_vt_update = NULL;
+  static int osp_result_batch_size = OSP_RESULT_BATCH_SIZE_DEFAULT;
+  static int osp_poll_interval_min = OSP_POLL_INTERVAL_MIN_DEFAULT;
+  static int osp_poll_interval_max = OSP_POLL_INTERVAL_MAX_DEFAULT;
+  static int osp_scan_monitors = OSP_SCAN_MONITORS_DEFAULT;
+  static int alert_workers = ALERT_WORKERS_DEFAULT;
+  static int gmp_session_ttl = GMP_SESSION_TTL_DEFAULT;
+  static int alert_method_workers = ALERT_METHOD_WORKERS_DEFAULT;
+  static int report_cache_workers = REPORT_CACHE_WORKERS_DEFAULT;
+  static int report_deletion_chunk = REPORT_DELETION_CHUNK_DEFAULT;
+  static int report_format_cpu_limit = REPORT_FORMAT_CPU_LIMIT_DEFAULT;
+  static int report_format_memory_limit = REPORT_FORMAT_MEMORY_LIMIT_DEFAULT;
+  static int report_format_workers = REPORT_FORMAT_WORKERS_DEFAULT;
+  static int report_host_workers = REPORT_HOST_WORKERS_DEFAULT;
+  static int gmp_batch_workers = GMP_BATCH_WORKERS_DEFAULT;
+  static int report_render_cache_size = REPORT_RENDER_CACHE_SIZE_DEFAULT;
+  static int slow_query_threshold = SLOW_QUERY_THRESHOLD_DEFAULT;
+  static gchar *db_replica_host = NULL;
+  static gchar *db_replica_port = NULL;
+  static int db_replica_max_lag = DB_REPLICA_MAX_LAG_DEFAULT;
+  static gboolean db_transaction_pooling = FALSE;
   static gchar *password = NULL;
   static gchar *manager_address_string = NULL;
   static gchar *manager_address_string_2 = NULL;
@@ -1807,6 +2217,22 @@ gvmd (int argc, char** argv)
   GOptionContext *option_context;
   static GOptionEntry option_entries[]
     = {
+        { "acl-precompute-types", '\0', 0, G_OPTION_ARG_STRING,
+          &acl_precompute_types,
+          "Check access to comma-separated <types> of resources against"
+          " sets precomputed once per listing, instead of per row.",
+          "<types>" },
+        { "alert-method-workers", '\0', 0, G_OPTION_ARG_INT,
+          &alert_method_workers,
+          "Run at most <number> queued alerts of the same method at once,"
+          " 0 for no limit, default: "
+          G_STRINGIFY (ALERT_METHOD_WORKERS_DEFAULT), "<number>" },
+        { "alert-workers", '\0', 0, G_OPTION_ARG_INT,
+          &alert_workers,
+          "Queue alerts and run them in <number> worker processes,"
+          " 0 to run them in the process that produces the event, at most "
+          G_STRINGIFY (ALERT_WORKERS_MAX) ", default: "
+          G_STRINGIFY (ALERT_WORKERS_DEFAULT), "<number>" },
         { "check-alerts", '\0', 0, G_OPTION_ARG_NONE,
           &check_alerts,
           "Check SecInfo alerts.",
@@ -1837,6 +2263,25 @@ gvmd (int argc, char** argv)
           &(database.port),
           "Use <port> as database port or socket extension for PostgreSQL.",
           "<port>" },
+        { "db-replica-host", '\0', 0, G_OPTION_ARG_STRING,
+          &db_replica_host,
+          "Run read-only GMP commands on the PostgreSQL streaming replica"
+          " at <host> or socket directory.",
+          "<host>" },
+        { "db-replica-max-lag", '\0', 0, G_OPTION_ARG_INT,
+          &db_replica_max_lag,
+          "Use the primary while the replica lags more than <number>"
+          " seconds behind, default: "
+          G_STRINGIFY (DB_REPLICA_MAX_LAG_DEFAULT), "<number>" },
+        { "db-replica-port", '\0', 0, G_OPTION_ARG_STRING,
+          &db_replica_port,
+          "Use <port> as port or socket extension of the replica.",
+          "<port>" },
+        { "db-transaction-pooling", '\0', 0, G_OPTION_ARG_NONE,
+          &db_transaction_pooling,
+          "Keep no state in the database session, so that gvmd can connect"
+          " through a pooler in transaction mode.",
+          NULL },
         { "db-user", '\0', 0, G_OPTION_ARG_STRING,
           &(database.user),
           "Use <user> as database user.",
@@ -1904,6 +2349,23 @@ gvmd (int argc, char** argv)
           &get_users,
           "List users and exit.",
           NULL },
+        { "gmp-batch-workers", '\0', 0, G_OPTION_ARG_INT,
+          &gmp_batch_workers,
+          "Run the commands of a GMP batch in <number> worker processes,"
+          " 0 to run them one after another in the GMP process, at most "
+          G_STRINGIFY (GMP_BATCH_WORKERS_MAX) ", default: "
+          G_STRINGIFY (GMP_BATCH_WORKERS_DEFAULT), "<number>" },
+        { "gmp-session-ttl", '\0', 0, G_OPTION_ARG_INT,
+          &gmp_session_ttl,
+          "Give GMP clients that ask for one a session token that is valid"
+          " for <number> seconds, 0 to disable session tokens, default: "
+          G_STRINGIFY (GMP_SESSION_TTL_DEFAULT), "<number>" },
+        { "gmp-workers", '\0', 0, G_OPTION_ARG_INT,
+          &gmp_workers,
+          "Serve GMP clients from <number> worker processes that each serve"
+          " one client after another, 0 for a process per client, at most "
+          G_STRINGIFY (GMP_WORKERS_MAX) ", default: "
+          G_STRINGIFY (GMP_WORKERS_DEFAULT), "<number>" },
         { "gnutls-priorities", '\0', 0, G_OPTION_ARG_STRING,
           &priorities,
           "Sets the GnuTLS priorities for the Manager socket.",
@@ -1936,6 +2398,18 @@ gvmd (int argc, char** argv)
           &listen_owner,
           "Owner of the unix socket",
           "<string>" },
+        { "max-active-scans", '\0', 0, G_OPTION_ARG_INT,
+          &max_active_scans,
+          "Queue scheduled tasks while <number> scans are active."
+          " Default: " G_STRINGIFY (MAX_ACTIVE_SCANS_DEFAULT)
+          " (no limit).",
+          "<number>" },
+        { "max-active-scans-per-scanner", '\0', 0, G_OPTION_ARG_INT,
+          &max_active_scans_per_scanner,
+          "Queue scheduled tasks while <number> scans are active on their"
+          " scanner.  Default: "
+          G_STRINGIFY (MAX_ACTIVE_SCANS_PER_SCANNER_DEFAULT) " (no limit).",
+          "<number>" },
         { "max-email-attachment-size", '\0', 0, G_OPTION_ARG_INT,
           &max_email_attachment_size,
           "Maximum size of alert email attachments, in bytes.",
@@ -1953,6 +2427,17 @@ gvmd (int argc, char** argv)
           &max_ips_per_target,
           "Maximum number of IPs per target.",
           "<number>" },
+        { "max-scan-launches", '\0', 0, G_OPTION_ARG_INT,
+          &max_scan_launches,
+          "Launch at most <number> queued scheduled tasks per minute."
+          " Default: " G_STRINGIFY (MAX_SCAN_LAUNCHES_DEFAULT)
+          " (no limit).",
+          "<number>" },
+        { "metrics-file", '\0', 0, G_OPTION_ARG_STRING,
+          &metrics_file,
+          "Write metrics to <file> every " G_STRINGIFY (METRICS_PERIOD)
+          " seconds, in the Prometheus text format.",
+          "<file>" },
         { "migrate", 'm', 0, G_OPTION_ARG_NONE,
           &migrate_database,
           "Migrate the database and exit.",
@@ -1974,9 +2459,33 @@ gvmd (int argc, char** argv)
           "Run an optimization: vacuum, analyze, cleanup-config-prefs,"
           " cleanup-port-names, cleanup-report-formats, cleanup-result-encoding,"
           " cleanup-result-nvts, cleanup-result-severities,"
-          " cleanup-schedule-times, migrate-relay-sensors,"
-          " rebuild-report-cache or update-report-cache.",
+          " cleanup-schedule-times, create-result-indexes,"
+          " create-text-search-indexes, deduplicate-host-details,"
+          " dematerialize-vulns, drop-result-indexes, drop-text-search-indexes,"
+          " explain-result-indexes, materialize-vulns, migrate-relay-sensors,"
+          " partition-results, rebuild-report-cache or update-report-cache.",
           "<name>" },
+        { "osp-poll-interval-max", '\0', 0, G_OPTION_ARG_INT,
+          &osp_poll_interval_max,
+          "Wait at most <seconds> between polls of a running OSP scan,"
+          " default: " G_STRINGIFY (OSP_POLL_INTERVAL_MAX_DEFAULT),
+          "<seconds>" },
+        { "osp-poll-interval-min", '\0', 0, G_OPTION_ARG_INT,
+          &osp_poll_interval_min,
+          "Wait at least <seconds> between polls of a running OSP scan,"
+          " default: " G_STRINGIFY (OSP_POLL_INTERVAL_MIN_DEFAULT),
+          "<seconds>" },
+        { "osp-result-batch-size", '\0', 0, G_OPTION_ARG_INT,
+          &osp_result_batch_size,
+          "Insert OSP scan results into the database <number> at a time,"
+          " 0 to insert them one by one, default: "
+          G_STRINGIFY (OSP_RESULT_BATCH_SIZE_DEFAULT), "<number>" },
+        { "osp-scan-monitors", '\0', 0, G_OPTION_ARG_INT,
+          &osp_scan_monitors,
+          "Poll all running OSP scans from <number> monitor processes,"
+          " 0 for a process per scan, at most "
+          G_STRINGIFY (OSP_SCAN_MONITORS_MAX) ", default: "
+          G_STRINGIFY (OSP_SCAN_MONITORS_DEFAULT), "<number>" },
         { "osp-vt-update", '\0', 0, G_OPTION_ARG_STRING,
           &osp_vt_update,
           "Unix socket for OSP NVT update.  Defaults to the path of the"
@@ -2009,6 +2518,45 @@ gvmd (int argc, char** argv)
           " If the option is not given, $PATH is checked for"
           " gvm-relay-mapper.",
           "<file>" },
+        { "report-cache-workers", '\0', 0, G_OPTION_ARG_INT,
+          &report_cache_workers,
+          "Rebuild the report cache for --optimize rebuild-report-cache and"
+          " update-report-cache in <number> worker processes, 0 to rebuild"
+          " it in one process, at most "
+          G_STRINGIFY (REPORT_CACHE_WORKERS_MAX) ", default: "
+          G_STRINGIFY (REPORT_CACHE_WORKERS_DEFAULT), "<number>" },
+        { "report-deletion-chunk", '\0', 0, G_OPTION_ARG_INT,
+          &report_deletion_chunk,
+          "Hide deleted reports at once and remove their data in the"
+          " background, <number> rows per table every schedule period,"
+          " 0 to delete reports immediately, default: "
+          G_STRINGIFY (REPORT_DELETION_CHUNK_DEFAULT), "<number>" },
+        { "report-format-cpu-limit", '\0', 0, G_OPTION_ARG_INT,
+          &report_format_cpu_limit,
+          "Stop report format scripts after <seconds> of CPU time,"
+          " 0 for no limit, default: "
+          G_STRINGIFY (REPORT_FORMAT_CPU_LIMIT_DEFAULT), "<seconds>" },
+        { "report-format-memory-limit", '\0', 0, G_OPTION_ARG_INT,
+          &report_format_memory_limit,
+          "Limit the memory of report format scripts to <size> MiB,"
+          " 0 for no limit, default: "
+          G_STRINGIFY (REPORT_FORMAT_MEMORY_LIMIT_DEFAULT), "<size>" },
+        { "report-format-workers", '\0', 0, G_OPTION_ARG_INT,
+          &report_format_workers,
+          "Run at most <number> report format scripts at once, queueing"
+          " further requests, 0 for no limit, default: "
+          G_STRINGIFY (REPORT_FORMAT_WORKERS_DEFAULT), "<number>" },
+        { "report-host-workers", '\0', 0, G_OPTION_ARG_INT,
+          &report_host_workers,
+          "Render the hosts of reports in <number> worker processes,"
+          " 0 to render them in the GMP process, at most "
+          G_STRINGIFY (REPORT_HOST_WORKERS_MAX) ", default: "
+          G_STRINGIFY (REPORT_HOST_WORKERS_DEFAULT), "<number>" },
+        { "report-render-cache-size", '\0', 0, G_OPTION_ARG_INT,
+          &report_render_cache_size,
+          "Keep formatted reports of finished scans in a cache of at most"
+          " <size> MiB, 0 to format every request, default: "
+          G_STRINGIFY (REPORT_RENDER_CACHE_SIZE_DEFAULT), "<size>" },
         { "role", '\0', 0, G_OPTION_ARG_STRING,
           &role,
           "Role for --create-user and --get-users.",
@@ -2057,6 +2605,12 @@ gvmd (int argc, char** argv)
           " Either 'OpenVAS', 'OSP', 'OSP-Sensor'"
           " or a number as used in GMP.",
           "<scanner-type>" },
+        { "scap-workers", '\0', 0, G_OPTION_ARG_INT,
+          &scap_workers,
+          "During SCAP sync, load the yearly CVE files in <number> worker"
+          " processes, 0 to load them in one process, at most "
+          G_STRINGIFY (SCAP_WORKERS_MAX) ", default: "
+          G_STRINGIFY (SCAP_WORKERS_DEFAULT), "<number>" },
         { "schedule-timeout", '\0', 0, G_OPTION_ARG_INT,
           &schedule_timeout,
           "Time out tasks that are more than <time> minutes overdue."
@@ -2068,6 +2622,11 @@ gvmd (int argc, char** argv)
           "During CERT and SCAP sync, commit updates to the database every"
           " <number> items, 0 for unlimited, default: "
           G_STRINGIFY (SECINFO_COMMIT_SIZE_DEFAULT), "<number>" },
+        { "slow-query-threshold", '\0', 0, G_OPTION_ARG_INT,
+          &slow_query_threshold,
+          "Log SQL statements that take longer than <milliseconds>,"
+          " 0 to disable, default: "
+          G_STRINGIFY (SLOW_QUERY_THRESHOLD_DEFAULT), "<milliseconds>" },
         { "unix-socket", 'c', 0, G_OPTION_ARG_STRING,
           &manager_address_string_unix,
           "Listen on UNIX socket at <filename>.",
@@ -2142,6 +2701,13 @@ gvmd (int argc, char** argv)
       client_watch_interval = 0;
     }
 
+  /* Keep the number of GMP workers in range */
+
+  if (gmp_workers < 0)
+    gmp_workers = 0;
+  else if (gmp_workers > GMP_WORKERS_MAX)
+    gmp_workers = GMP_WORKERS_MAX;
+
   /* Set feed lock path */
   set_feed_lock_path (feed_lock_path);
   
@@ -2152,13 +2718,79 @@ gvmd (int argc, char** argv)
 
   set_schedule_timeout (schedule_timeout);
 
+  /* Set the limits on launching scheduled tasks */
+  set_scan_launch_limits (max_active_scans, max_active_scans_per_scanner,
+                          max_scan_launches);
+
   /* Set the connection auto retry */
   set_scanner_connection_retry (scanner_connection_retry);
 
+  /* Set the OSP scan poll intervals */
+  set_osp_poll_intervals (osp_poll_interval_min, osp_poll_interval_max);
+
+  /* Set the number of OSP scan monitors */
+  set_osp_scan_monitors (osp_scan_monitors);
+
+  /* Set the number of alert workers */
+  set_alert_workers (alert_workers, alert_method_workers);
+
+  /* Set the lifetime of GMP session tokens */
+  set_gmp_session_ttl (gmp_session_ttl);
+
   /* Set SecInfo update commit size */
 
   set_secinfo_commit_size (secinfo_commit_size);
 
+  /* Set the number of SCAP workers */
+
+  set_scap_workers (scap_workers);
+
+  /* Set OSP result batch size */
+
+  set_osp_result_batch_size (osp_result_batch_size);
+
+  /* Set the number of report host workers */
+
+  set_report_host_workers (report_host_workers);
+
+  /* Set the number of GMP batch workers */
+
+  set_gmp_batch_workers (gmp_batch_workers);
+
+  /* Set the number of report cache workers */
+
+  set_report_cache_workers (report_cache_workers);
+
+  /* Set the chunk size for deferred report deletion */
+
+  set_report_deletion_chunk (report_deletion_chunk);
+
+  /* Set the limits of report format scripts */
+
+  set_report_format_workers (report_format_workers);
+  set_report_format_cpu_limit (report_format_cpu_limit);
+  set_report_format_memory_limit (report_format_memory_limit);
+
+  /* Set the threshold for logging slow SQL statements */
+
+  set_slow_query_threshold (slow_query_threshold);
+
+  /* Set the read replica for read-only commands */
+
+  set_db_replica (db_replica_host, db_replica_port, db_replica_max_lag);
+
+  /* Set whether gvmd connects through a transaction pooler */
+
+  set_db_transaction_pooling (db_transaction_pooling);
+
+  /* Set the size of the render cache */
+
+  set_report_render_cache_size (report_render_cache_size);
+
+  /* Set the types that use precomputed access sets */
+
+  set_acl_precompute_types (acl_precompute_types);
+
   /* Check which type of socket to use. */
 
   if (manager_address_string_unix == NULL)
@@ -2447,6 +3079,10 @@ gvmd (int argc, char** argv)
       g_free (password_policy);
     }
 
+  /* Map the metrics shared by all gvmd processes. */
+
+  metrics_init ();
+
   if (optimize)
     {
       int ret;
@@ -2990,6 +3626,7 @@ gvmd (int argc, char** argv)
   /* Initialise the process for manage_schedule. */
 
   init_manage_process (&database);
+  metrics_reset ();
 
   /* Initialize the authentication system. */
 
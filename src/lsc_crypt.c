@@ -29,6 +29,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdint.h>
+#include <sys/mman.h>
 
 #include <gvm/util/gpgmeutils.h>
 
@@ -58,6 +59,19 @@
 #define MAX_VALUE_LENGTH  (128 * 1024)
 
 
+/**
+ * @brief The maximum number of decrypted credentials kept in memory.
+ */
+#define PLAINTEXT_CACHE_SIZE 256
+
+/**
+ * @brief The size of a slot in the plaintext arena.
+ *
+ * Larger plaintexts are not cached.
+ */
+#define PLAINTEXT_SLOT_SIZE (8 * 1024)
+
+
 #ifndef GPG_ERR_AMBIGUOUS
 /**
  * @brief Replacement for an error code in libgpg-error > 1.10.
@@ -95,6 +109,53 @@ struct lsc_crypt_ctx_s
   struct namelist_s *namelist; ///< Info describing PLAINTEXT.
 };
 
+/**
+ * @brief A decrypted credential in the plaintext cache.
+ */
+typedef struct
+{
+  int slot;                    ///< Slot of the data in the plaintext arena.
+  size_t plaintextlen;         ///< Length of data.
+} plaintext_entry_t;
+
+/**
+ * @brief Decrypted credentials, keyed on a hash of the ciphertext.
+ *
+ * Kept across contexts, so that the same credential is only decrypted
+ * once per process.  Any change to a credential changes the ciphertext,
+ * and so the key.
+ */
+static GHashTable *plaintext_cache = NULL;
+
+/**
+ * @brief Keys of \ref plaintext_cache, oldest first.
+ */
+static GQueue *plaintext_cache_keys = NULL;
+
+/**
+ * @brief Memory holding the plaintexts of \ref plaintext_cache.
+ *
+ * One page aligned mapping of PLAINTEXT_CACHE_SIZE slots, locked as a
+ * whole where the memlock limit allows.  munlock works on whole pages
+ * and does not count, so the arena is only unlocked when it is unmapped.
+ */
+static char *plaintext_arena = NULL;
+
+/**
+ * @brief Whether \ref plaintext_arena is locked in memory.
+ */
+static gboolean plaintext_arena_locked = FALSE;
+
+/**
+ * @brief Unused slots of \ref plaintext_arena.
+ */
+static int plaintext_arena_free[PLAINTEXT_CACHE_SIZE];
+
+/**
+ * @brief Number of entries in \ref plaintext_arena_free.
+ */
+static int plaintext_arena_free_count = 0;
+
 
 /* Simple helper functions  */
 
@@ -380,6 +441,178 @@ do_encrypt (lsc_crypt_ctx_t ctx, const void *plaintext, size_t plaintextlen)
 }
 
 
+/**
+ * @brief Overwrite memory in a way the compiler may not remove.
+ *
+ * @param[in]  buffer  Memory.
+ * @param[in]  length  Length of memory.
+ */
+static void
+wipe (void *buffer, size_t length)
+{
+  volatile char *p = buffer;
+
+  while (length--)
+    *p++ = 0;
+}
+
+/**
+ * @brief Get the address of a slot in the plaintext arena.
+ *
+ * @param[in]  slot  Slot.
+ *
+ * @return Start of slot.
+ */
+static char *
+plaintext_arena_slot (int slot)
+{
+  return plaintext_arena + (size_t) slot * PLAINTEXT_SLOT_SIZE;
+}
+
+/**
+ * @brief Map the plaintext arena if it is not mapped yet.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+plaintext_arena_init ()
+{
+  void *arena;
+  int slot;
+
+  if (plaintext_arena)
+    return 0;
+
+  arena = mmap (NULL, PLAINTEXT_CACHE_SIZE * PLAINTEXT_SLOT_SIZE,
+                PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (arena == MAP_FAILED)
+    {
+      g_warning ("%s: failed to map plaintext arena", G_STRFUNC);
+      return -1;
+    }
+  plaintext_arena = arena;
+  /* Keep the plaintexts out of swap where the memlock limit allows. */
+  plaintext_arena_locked
+    = (mlock (plaintext_arena,
+              PLAINTEXT_CACHE_SIZE * PLAINTEXT_SLOT_SIZE) == 0);
+
+  plaintext_arena_free_count = 0;
+  for (slot = PLAINTEXT_CACHE_SIZE - 1; slot >= 0; slot--)
+    plaintext_arena_free[plaintext_arena_free_count++] = slot;
+  return 0;
+}
+
+/**
+ * @brief Wipe, unlock and unmap the plaintext arena.
+ */
+static void
+plaintext_arena_free_all ()
+{
+  if (plaintext_arena == NULL)
+    return;
+
+  explicit_bzero (plaintext_arena,
+                  PLAINTEXT_CACHE_SIZE * PLAINTEXT_SLOT_SIZE);
+  if (plaintext_arena_locked)
+    munlock (plaintext_arena, PLAINTEXT_CACHE_SIZE * PLAINTEXT_SLOT_SIZE);
+  munmap (plaintext_arena, PLAINTEXT_CACHE_SIZE * PLAINTEXT_SLOT_SIZE);
+  plaintext_arena = NULL;
+  plaintext_arena_locked = FALSE;
+  plaintext_arena_free_count = 0;
+}
+
+/**
+ * @brief Free a plaintext cache entry, wiping the plaintext.
+ *
+ * The slot stays locked, and goes back to the free slots.
+ *
+ * @param[in]  data  The entry.
+ */
+static void
+plaintext_entry_free (gpointer data)
+{
+  plaintext_entry_t *entry = data;
+
+  explicit_bzero (plaintext_arena_slot (entry->slot), entry->plaintextlen);
+  plaintext_arena_free[plaintext_arena_free_count++] = entry->slot;
+  g_free (entry);
+}
+
+/**
+ * @brief Get a copy of a decrypted credential from the plaintext cache.
+ *
+ * @param[in]   key             Cache key.
+ * @param[out]  r_plaintextlen  Length of plaintext.
+ *
+ * @return Freshly allocated plaintext, or NULL if not in the cache.
+ */
+static char *
+plaintext_cache_get (const char *key, size_t *r_plaintextlen)
+{
+  plaintext_entry_t *entry;
+
+  if (plaintext_cache == NULL)
+    return NULL;
+
+  entry = g_hash_table_lookup (plaintext_cache, key);
+  if (entry == NULL)
+    return NULL;
+
+  *r_plaintextlen = entry->plaintextlen;
+  return g_memdup (plaintext_arena_slot (entry->slot), entry->plaintextlen);
+}
+
+/**
+ * @brief Add a decrypted credential to the plaintext cache.
+ *
+ * Drops the oldest entry when the cache is full.  Plaintexts larger than
+ * a slot of the arena are not cached.
+ *
+ * @param[in]  key           Cache key.
+ * @param[in]  plaintext     Plaintext.
+ * @param[in]  plaintextlen  Length of plaintext.
+ */
+static void
+plaintext_cache_add (const char *key, const char *plaintext,
+                     size_t plaintextlen)
+{
+  plaintext_entry_t *entry;
+  gchar *key_copy;
+
+  if (plaintextlen > PLAINTEXT_SLOT_SIZE)
+    return;
+
+  if (plaintext_cache == NULL)
+    {
+      if (plaintext_arena_init ())
+        return;
+      plaintext_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, plaintext_entry_free);
+      plaintext_cache_keys = g_queue_new ();
+    }
+
+  if (g_hash_table_contains (plaintext_cache, key))
+    return;
+
+  while (g_queue_get_length (plaintext_cache_keys) >= PLAINTEXT_CACHE_SIZE)
+    {
+      gchar *oldest;
+
+      oldest = g_queue_pop_head (plaintext_cache_keys);
+      g_hash_table_remove (plaintext_cache, oldest);
+    }
+
+  entry = g_malloc (sizeof (*entry));
+  entry->slot = plaintext_arena_free[--plaintext_arena_free_count];
+  entry->plaintextlen = plaintextlen;
+  memcpy (plaintext_arena_slot (entry->slot), plaintext, plaintextlen);
+
+  key_copy = g_strdup (key);
+  g_hash_table_insert (plaintext_cache, key_copy, entry);
+  /* The hash table owns the key. */
+  g_queue_push_tail (plaintext_cache_keys, key_copy);
+}
+
 /**
  * @brief Decrypt data encrypted to the standard key
  *
@@ -505,7 +738,7 @@ lsc_crypt_release (lsc_crypt_ctx_t ctx)
 {
   if (!ctx)
     return;
-  lsc_crypt_flush (ctx);
+  lsc_crypt_reset (ctx);
   if (ctx->encctx) /* Check required for gpgme < 1.3.1 */
     gpgme_release (ctx->encctx);
   g_free (ctx);
@@ -513,17 +746,18 @@ lsc_crypt_release (lsc_crypt_ctx_t ctx)
 
 
 /**
- * @brief Flush an LSC encryption context
+ * @brief Reset an LSC encryption context
  *
- * This function is used to flush the context.  The flushing
- * invalidates returned strings and internal caches.  Basically this
- * is the same as releasing and creating the context but it is
- * optimized to keep some internal state.
+ * This function is used to reset the context, for example before
+ * the next row of an iterator.  The reset invalidates returned strings
+ * and internal caches of the context.  Basically this is the same as
+ * releasing and creating the context but it is optimized to keep some
+ * internal state.  Decrypted credentials kept across contexts stay.
  *
  * @param[in]  ctx  The context or NULL
  */
 void
-lsc_crypt_flush (lsc_crypt_ctx_t ctx)
+lsc_crypt_reset (lsc_crypt_ctx_t ctx)
 {
   if (!ctx)
     return;
@@ -534,10 +768,48 @@ lsc_crypt_flush (lsc_crypt_ctx_t ctx)
       g_free (ctx->namelist);
       ctx->namelist = nl;
     }
+  if (ctx->plaintext)
+    wipe (ctx->plaintext, ctx->plaintextlen);
   g_free (ctx->plaintext);
   ctx->plaintext = NULL;
 }
 
+/**
+ * @brief Flush an LSC encryption context
+ *
+ * Reset the context and drop all decrypted credentials kept across
+ * contexts.
+ *
+ * @param[in]  ctx  The context or NULL
+ */
+void
+lsc_crypt_flush (lsc_crypt_ctx_t ctx)
+{
+  lsc_crypt_reset (ctx);
+  lsc_crypt_flush_cache ();
+}
+
+/**
+ * @brief Drop all decrypted credentials kept across contexts.
+ *
+ * The plaintexts are wiped before the arena is unmapped.
+ */
+void
+lsc_crypt_flush_cache ()
+{
+  if (plaintext_cache_keys)
+    {
+      g_queue_free (plaintext_cache_keys);
+      plaintext_cache_keys = NULL;
+    }
+  if (plaintext_cache)
+    {
+      g_hash_table_destroy (plaintext_cache);
+      plaintext_cache = NULL;
+    }
+  plaintext_arena_free_all ();
+}
+
 
 /**
  * @brief Encrypt a list of name/value pairs
@@ -655,9 +927,19 @@ lsc_crypt_decrypt (lsc_crypt_ctx_t ctx, const char *ciphertext,
 
   if (!ctx->plaintext)
     {
+      gchar *key;
+
       if (!ciphertext)
         return NULL;
-      ctx->plaintext = do_decrypt (ctx, ciphertext, &ctx->plaintextlen);
+      key = g_compute_checksum_for_string (G_CHECKSUM_SHA256, ciphertext, -1);
+      ctx->plaintext = plaintext_cache_get (key, &ctx->plaintextlen);
+      if (!ctx->plaintext)
+        {
+          ctx->plaintext = do_decrypt (ctx, ciphertext, &ctx->plaintextlen);
+          if (ctx->plaintext)
+            plaintext_cache_add (key, ctx->plaintext, ctx->plaintextlen);
+        }
+      g_free (key);
       if (!ctx->plaintext)
         return NULL;
     }
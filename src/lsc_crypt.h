@@ -38,8 +38,12 @@ void lsc_crypt_release (lsc_crypt_ctx_t);
 
 int lsc_crypt_create_key ();
 
+void lsc_crypt_reset (lsc_crypt_ctx_t);
+
 void lsc_crypt_flush (lsc_crypt_ctx_t);
 
+void lsc_crypt_flush_cache ();
+
 char *lsc_crypt_encrypt (lsc_crypt_ctx_t,
                          const char *, ...) G_GNUC_NULL_TERMINATED;
 
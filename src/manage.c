@@ -50,6 +50,7 @@
 #include "manage.h"
 #include "manage_acl.h"
 #include "manage_configs.h"
+#include "manage_metrics.h"
 #include "manage_port_lists.h"
 #include "manage_report_formats.h"
 #include "manage_sql.h"
@@ -191,6 +192,38 @@ static int schedule_timeout = SCHEDULE_TIMEOUT_DEFAULT;
  */
 static int scanner_connection_retry = SCANNER_CONNECTION_RETRY_DEFAULT;
 
+/**
+ * @brief Minimum number of seconds between polls of a running OSP scan.
+ */
+static int osp_poll_interval_min = OSP_POLL_INTERVAL_MIN_DEFAULT;
+
+/**
+ * @brief Maximum number of seconds between polls of a running OSP scan.
+ */
+static int osp_poll_interval_max = OSP_POLL_INTERVAL_MAX_DEFAULT;
+
+/**
+ * @brief Number of results in a pop at which OSP polling is reset to the
+ *        minimum interval.
+ */
+#define OSP_POLL_BURST_RESULTS 100
+
+/**
+ * @brief Change of progress in percent below which an OSP scan counts as
+ *        making no progress, so that polling backs off.
+ */
+#define OSP_POLL_PROGRESS_STEP 5
+
+/**
+ * @brief Number of OSP scan monitor processes, 0 for a process per scan.
+ */
+static int osp_scan_monitors = OSP_SCAN_MONITORS_DEFAULT;
+
+/**
+ * @brief Seconds between checks for new scans in an OSP scan monitor.
+ */
+#define OSP_SCAN_MONITOR_ADOPT_PERIOD 5
+
 
 /* Certificate and key management. */
 
@@ -984,6 +1017,21 @@ report_results_get_data (int first, int rows,
  */
 #define ZERO_SEVERITY_INDEX 4
 
+/**
+ * @brief Number of entries in the severity_data_t.counts array.
+ */
+#define SEVERITY_DATA_BINS \
+  (ZERO_SEVERITY_INDEX + SEVERITY_SUBDIVISIONS * (int) SEVERITY_MAX + 1)
+
+/**
+ * @brief Number of interleaved count arrays in severity_data_add_batch.
+ *
+ * Results often come in runs of the same severity.  Counting neighbouring
+ * severities in separate arrays keeps each increment from waiting for the
+ * previous one to the same bin.
+ */
+#define SEVERITY_DATA_LANES 4
+
 /**
  * @brief Convert a severity value into an index in the counts array.
  *
@@ -995,7 +1043,9 @@ static int
 severity_data_index (double severity)
 {
   int ret;
-  if (severity >= 0.0)
+  if (severity > SEVERITY_MAX)
+    ret = 0;
+  else if (severity >= 0.0)
     ret = (int)(round (severity * SEVERITY_SUBDIVISIONS)) + ZERO_SEVERITY_INDEX;
   else if (severity == SEVERITY_FP || severity == SEVERITY_ERROR)
     ret = (int)(round (severity)) + ZERO_SEVERITY_INDEX;
@@ -1035,10 +1085,7 @@ severity_data_value (int index)
 void
 init_severity_data (severity_data_t* data)
 {
-  int max_i;
-  max_i = ZERO_SEVERITY_INDEX + (SEVERITY_SUBDIVISIONS * SEVERITY_MAX);
-
-  data->counts = g_malloc0 (sizeof (int) * (max_i + 1));
+  data->counts = g_malloc0 (sizeof (int) * SEVERITY_DATA_BINS);
 
   data->total = 0;
   data->max = SEVERITY_MISSING;
@@ -1091,6 +1138,75 @@ severity_data_add_count (severity_data_t* severity_data, double severity,
   (severity_data->total) += count;
 }
 
+/**
+ * @brief Add an array of severities to the counts of a severity_data_t.
+ *
+ * Gives the same counts as calling severity_data_add for each severity.
+ * The bins are worked out in fixed point for a chunk of severities at a
+ * time, in a loop without branches that the compiler can vectorize, and
+ * then counted into SEVERITY_DATA_LANES interleaved arrays.
+ *
+ * @param[in]   severity_data   The severity count struct to add to.
+ * @param[in]   severities      The severities to add.
+ * @param[in]   count           The number of severities.
+ */
+void
+severity_data_add_batch (severity_data_t* severity_data,
+                         const double *severities, int count)
+{
+  int lanes[SEVERITY_DATA_LANES][SEVERITY_DATA_BINS];
+  int bins[SEVERITY_DATA_BATCH];
+  int start, lane, bin;
+  double max;
+
+  if (count <= 0)
+    return;
+
+  memset (lanes, 0, sizeof (lanes));
+  max = severity_data->total ? severity_data->max : severities[0];
+
+  for (start = 0; start < count; start += SEVERITY_DATA_BATCH)
+    {
+      int index, chunk;
+
+      chunk = MIN (count - start, SEVERITY_DATA_BATCH);
+
+      for (index = 0; index < chunk; index++)
+        {
+          double severity;
+          int scaled, whole, special;
+
+          severity = severities[start + index];
+          max = severity > max ? severity : max;
+
+          /* Rounding half away from zero, as round does.  The clamps keep
+           * the conversions in range for any input. */
+          scaled = (int) (CLAMP (severity, 0.0, SEVERITY_MAX)
+                          * SEVERITY_SUBDIVISIONS + 0.5);
+          whole = (int) (CLAMP (severity, SEVERITY_ERROR, 0.0) - 0.5);
+          special = (severity == SEVERITY_FP || severity == SEVERITY_ERROR);
+
+          bins[index] = (severity >= 0.0 && severity <= SEVERITY_MAX)
+                         ? scaled + ZERO_SEVERITY_INDEX
+                         : (special ? whole + ZERO_SEVERITY_INDEX : 0);
+        }
+
+      for (index = 0; index + SEVERITY_DATA_LANES <= chunk;
+           index += SEVERITY_DATA_LANES)
+        for (lane = 0; lane < SEVERITY_DATA_LANES; lane++)
+          lanes[lane][bins[index + lane]]++;
+      for (; index < chunk; index++)
+        lanes[0][bins[index]]++;
+    }
+
+  for (bin = 0; bin < SEVERITY_DATA_BINS; bin++)
+    for (lane = 0; lane < SEVERITY_DATA_LANES; lane++)
+      (severity_data->counts)[bin] += lanes[lane][bin];
+
+  severity_data->max = max;
+  (severity_data->total) += count;
+}
+
 /**
  * @brief Calculate the total of severity counts in a range.
  *
@@ -1506,6 +1622,8 @@ run_status_name (task_status_t status)
 
       case TASK_STATUS_QUEUED:           return "Queued";
 
+      case TASK_STATUS_LAUNCH_QUEUED:    return "Launch Queued";
+
       case TASK_STATUS_STOP_REQUESTED:
       case TASK_STATUS_STOP_WAITING:
         return "Stop Requested";
@@ -1542,6 +1660,8 @@ run_status_name_internal (task_status_t status)
 
       case TASK_STATUS_QUEUED:           return "Queued";
 
+      case TASK_STATUS_LAUNCH_QUEUED:    return "Launch Queued";
+
       case TASK_STATUS_STOP_REQUESTED:
         return "Stop Requested";
 
@@ -1735,14 +1855,18 @@ get_osp_scan_report (const char *scan_id, const char *host, int port,
   osp_connection_t *connection;
   int progress;
   char *error = NULL;
+  gint64 start;
 
   connection = osp_connect_with_data (host, port, ca_pub, key_pub, key_priv);
   if (!connection)
     {
       return -1;
     }
+  start = g_get_monotonic_time ();
   progress = osp_get_scan_pop (connection, scan_id, report_xml, details,
                                pop_results, &error);
+  metrics_add (METRIC_OSP_POLLS, 1);
+  metrics_add (METRIC_OSP_POLL_TIME, g_get_monotonic_time () - start);
   if (progress > 100 || progress < 0)
     {
       g_warning ("OSP get_scan %s: %s", scan_id, error);
@@ -1789,7 +1913,6 @@ get_osp_scan_status (const char *scan_id, const char *host, int port,
     {
       g_warning ("OSP %s %s: %s", __func__, scan_id, error);
       g_free (error);
-      return status;
     }
 
   osp_connection_close (connection);
@@ -1797,186 +1920,331 @@ get_osp_scan_status (const char *scan_id, const char *host, int port,
 }
 
 /**
- * @brief Handle an ongoing OSP scan, until success or failure.
+ * @brief Get the number of seconds to wait before polling an OSP scan again.
+ *
+ * Only results make polling faster.  A clear change of progress keeps the
+ * interval, and otherwise polling backs off, within the configured minimum
+ * and maximum.  A scan that creeps forward by a percent at a time therefore
+ * still settles at a long interval.
+ *
+ * @param[in]  interval        Current interval in seconds.
+ * @param[in]  progress_delta  Change of progress since last poll, in percent.
+ * @param[in]  result_count    Number of results in the last pop.
+ *
+ * @return Interval in seconds.
+ */
+static int
+osp_scan_poll_interval (int interval, int progress_delta, int result_count)
+{
+  if (result_count >= OSP_POLL_BURST_RESULTS)
+    interval = osp_poll_interval_min;
+  else if (result_count > 0)
+    interval = interval / 2;
+  else if (progress_delta < OSP_POLL_PROGRESS_STEP)
+    interval = interval * 2;
+
+  if (interval < osp_poll_interval_min)
+    return osp_poll_interval_min;
+  if (interval > osp_poll_interval_max)
+    return osp_poll_interval_max;
+  return interval;
+}
+
+/**
+ * @brief An OSP scan that is being handled.
+ */
+typedef struct
+{
+  task_t task;                      ///< The task.
+  report_t report;                  ///< The report.
+  gchar *scan_id;                   ///< The UUID of the scan on the scanner.
+  gchar *owner_uuid;                ///< UUID of task owner, for the monitor.
+  gchar *owner_name;                ///< Name of task owner, for the monitor.
+  char *host;                       ///< Scanner host.
+  int port;                         ///< Scanner port.
+  char *ca_pub;                     ///< CA Certificate.
+  char *key_pub;                    ///< Certificate.
+  char *key_priv;                   ///< Private key.
+  gboolean started;                 ///< Whether the scan has started.
+  gboolean queued_status_updated;   ///< Whether the queued status is set.
+  int retry;                        ///< Connection retries left.
+  int poll_interval;                ///< Seconds between polls.
+  int last_progress;                ///< Progress at the last poll.
+  time_t next_poll;                 ///< Time of the next poll.
+} osp_scan_t;
+
+/**
+ * @brief Create the state of an OSP scan.
  *
  * @param[in]   task      The task.
  * @param[in]   report    The report.
  * @param[in]   scan_id   The UUID of the scan on the scanner.
  *
- * @return 0 if success, -1 if error, -2 if scan was stopped,
- *         -3 if the scan was interrupted.
+ * @return OSP scan.  Free with osp_scan_free.
  */
-static int
-handle_osp_scan (task_t task, report_t report, const char *scan_id)
+static osp_scan_t *
+osp_scan_new (task_t task, report_t report, const char *scan_id)
 {
-  char *host, *ca_pub, *key_pub, *key_priv;
-  int rc, port;
+  osp_scan_t *scan;
   scanner_t scanner;
-  gboolean started, queued_status_updated;
-  int retry, connection_retry;
 
+  scan = g_malloc0 (sizeof (*scan));
+  scan->task = task;
+  scan->report = report;
+  scan->scan_id = g_strdup (scan_id);
   scanner = task_scanner (task);
-  host = scanner_host (scanner);
-  port = scanner_port (scanner);
-  ca_pub = scanner_ca_pub (scanner);
-  key_pub = scanner_key_pub (scanner);
-  key_priv = scanner_key_priv (scanner);
-  started = FALSE;
-  queued_status_updated = FALSE;
-  connection_retry = get_scanner_connection_retry ();
+  scan->host = scanner_host (scanner);
+  scan->port = scanner_port (scanner);
+  scan->ca_pub = scanner_ca_pub (scanner);
+  scan->key_pub = scanner_key_pub (scanner);
+  scan->key_priv = scanner_key_priv (scanner);
+  scan->started = FALSE;
+  scan->queued_status_updated = FALSE;
+  scan->retry = get_scanner_connection_retry ();
+  scan->poll_interval = osp_poll_interval_min;
+  scan->last_progress = -1;
+  scan->next_poll = 0;
+  /* The NVT feed may have changed since the last scan of this process. */
+  result_nvt_info_cache_check ();
+  return scan;
+}
+
+/**
+ * @brief Free the state of an OSP scan.
+ *
+ * @param[in]   scan   OSP scan.
+ */
+static void
+osp_scan_free (osp_scan_t *scan)
+{
+  if (scan == NULL)
+    return;
+  g_free (scan->scan_id);
+  g_free (scan->owner_uuid);
+  g_free (scan->owner_name);
+  g_free (scan->host);
+  g_free (scan->ca_pub);
+  g_free (scan->key_pub);
+  g_free (scan->key_priv);
+  g_free (scan);
+}
 
-  retry = connection_retry;
-  rc = -1;
-  while (retry >= 0)
+/**
+ * @brief Handle a lost connection to the scanner of an OSP scan.
+ *
+ * @param[in]   scan   OSP scan.
+ *
+ * @return 1 if the poll should be retried, 0 if out of retries.
+ */
+static int
+osp_scan_retry (osp_scan_t *scan)
+{
+  if (scan->retry > 0)
     {
-      int run_status, progress;
-      osp_scan_status_t osp_scan_status;
+      scan->retry--;
+      g_warning ("Connection lost with the scanner at %s. "
+                 "Trying again in 1 second.", scan->host);
+      scan->next_poll = time (NULL) + 1;
+      return 1;
+    }
+  return 0;
+}
 
-      run_status = task_run_status (task);
-      if (run_status == TASK_STATUS_STOPPED
-          || run_status == TASK_STATUS_STOP_REQUESTED)
-        {
-          rc = -2;
-          break;
-        }
+/**
+ * @brief Poll an ongoing OSP scan once.
+ *
+ * Gets the progress and results of the scan from the scanner, adds the
+ * results to the report, and updates the run status of the task.  Sets
+ * the time that the scan should be polled again.
+ *
+ * @param[in]   scan   OSP scan.
+ *
+ * @return 1 if the scan is still going, 0 if success, -1 if error,
+ *         -2 if scan was stopped, -3 if the scan was interrupted.
+ */
+static int
+osp_scan_poll (osp_scan_t *scan)
+{
+  int run_status, progress, result_count;
+  osp_scan_status_t osp_scan_status;
+  char *report_xml;
+  task_t task;
+  report_t report;
+
+  task = scan->task;
+  report = scan->report;
+
+  run_status = task_run_status (task);
+  if (run_status == TASK_STATUS_STOPPED
+      || run_status == TASK_STATUS_STOP_REQUESTED)
+    return -2;
+
+  /* Get the progress, results and details in one request.  The scanner
+   * serves a single command per connection, so every request costs a new
+   * connection and TLS handshake. */
+  report_ingest_pending (report);
+  report_xml = NULL;
+  progress = get_osp_scan_report (scan->scan_id, scan->host, scan->port,
+                                  scan->ca_pub, scan->key_pub, scan->key_priv,
+                                  1, 1, &report_xml);
+  if (progress < 0 || progress > 100)
+    {
+      result_t result;
 
-      /* Get only the progress, without results and details. */
-      progress = get_osp_scan_report (scan_id, host, port, ca_pub, key_pub,
-                                      key_priv, 0, 0, NULL);
+      g_free (report_xml);
+      if (osp_scan_retry (scan))
+        return 1;
+      result = make_osp_result (task, "", "", "",
+                                threat_message_type ("Error"),
+                                "Erroneous scan progress value", "", "",
+                                QOD_DEFAULT, NULL);
+      report_add_result (report, result);
+      delete_osp_scan (scan->scan_id, scan->host, scan->port, scan->ca_pub,
+                       scan->key_pub, scan->key_priv);
+      return -1;
+    }
 
-      if (progress < 0 || progress > 100)
+  set_report_slave_progress (report, progress);
+  result_count = parse_osp_report (task, report, report_xml);
+  g_free (report_xml);
+  scan->poll_interval = osp_scan_poll_interval (scan->poll_interval,
+                                                scan->last_progress < 0
+                                                 ? 0
+                                                 : abs (progress
+                                                        - scan->last_progress),
+                                                result_count);
+  scan->last_progress = progress;
+
+  osp_scan_status = get_osp_scan_status (scan->scan_id, scan->host, scan->port,
+                                         scan->ca_pub, scan->key_pub,
+                                         scan->key_priv);
+
+  if (osp_scan_status == OSP_SCAN_STATUS_QUEUED)
+    {
+      if (scan->queued_status_updated == FALSE)
         {
-          if (retry > 0)
-            {
-              retry--;
-              g_warning ("Connection lost with the scanner at %s. "
-                         "Trying again in 1 second.", host);
-              gvm_sleep (1);
-              continue;
-            }
-          result_t result = make_osp_result
-                             (task, "", "", "",
-                              threat_message_type ("Error"),
-                              "Erroneous scan progress value", "", "",
-                              QOD_DEFAULT, NULL);
-          report_add_result (report, result);
-          delete_osp_scan (scan_id, host, port, ca_pub, key_pub,
-                           key_priv);
-          rc = -1;
-          break;
+          set_task_run_status (task, TASK_STATUS_QUEUED);
+          set_report_scan_run_status (report, TASK_STATUS_QUEUED);
+          scan->queued_status_updated = TRUE;
         }
-      else
-        {
-          /* Get the full OSP report. */
-          char *report_xml = NULL;
-          progress = get_osp_scan_report (scan_id, host, port, ca_pub, key_pub,
-                                          key_priv, 1, 1, &report_xml);
-          if (progress < 0 || progress > 100)
-            {
-              if (retry > 0)
-                {
-                  retry--;
-                  g_warning ("Connection lost with the scanner at %s. "
-                             "Trying again in 1 second.", host);
-                  gvm_sleep (1);
-                  continue;
-                }
+    }
+  else if (osp_scan_status == OSP_SCAN_STATUS_INTERRUPTED)
+    {
+      result_t result = make_osp_result
+        (task, "", "", "",
+         threat_message_type ("Error"),
+         "Task interrupted unexpectedly", "", "",
+         QOD_DEFAULT, NULL);
+      report_add_result (report, result);
+      delete_osp_scan (scan->scan_id, scan->host, scan->port, scan->ca_pub,
+                       scan->key_pub, scan->key_priv);
+      return -3;
+    }
+  else if (progress >= 0 && progress < 100
+           && osp_scan_status == OSP_SCAN_STATUS_STOPPED)
+    {
+      result_t result;
 
-              g_free (report_xml);
-              result_t result = make_osp_result
-                                 (task, "", "", "",
-                                  threat_message_type ("Error"),
-                                  "Erroneous scan progress value", "", "",
-                                  QOD_DEFAULT, NULL);
-              report_add_result (report, result);
-              rc = -1;
-              break;
-            }
-          else
-            {
-              set_report_slave_progress (report, progress);
-              parse_osp_report (task, report, report_xml);
-              g_free (report_xml);
+      if (osp_scan_retry (scan))
+        return 1;
+
+      result = make_osp_result
+        (task, "", "", "",
+         threat_message_type ("Error"),
+         "Scan stopped unexpectedly by the server", "", "",
+         QOD_DEFAULT, NULL);
+      report_add_result (report, result);
+      delete_osp_scan (scan->scan_id, scan->host, scan->port, scan->ca_pub,
+                       scan->key_pub, scan->key_priv);
+      return -1;
+    }
+  else if (progress == 100
+           && osp_scan_status == OSP_SCAN_STATUS_FINISHED)
+    {
+      delete_osp_scan (scan->scan_id, scan->host, scan->port, scan->ca_pub,
+                       scan->key_pub, scan->key_priv);
+      return 0;
+    }
+  else if (osp_scan_status == OSP_SCAN_STATUS_RUNNING
+           && scan->started == FALSE)
+    {
+      set_task_run_status (task, TASK_STATUS_RUNNING);
+      set_report_scan_run_status (report, TASK_STATUS_RUNNING);
+      scan->started = TRUE;
+    }
 
-              osp_scan_status = get_osp_scan_status (scan_id, host, port,
-                                                     ca_pub, key_pub, key_priv);
+  scan->retry = get_scanner_connection_retry ();
+  scan->next_poll = time (NULL) + scan->poll_interval;
+  return 1;
+}
 
-              if (osp_scan_status == OSP_SCAN_STATUS_QUEUED)
-                {
-                  if (queued_status_updated == FALSE)
-                    {
-                      set_task_run_status (task, TASK_STATUS_QUEUED);
-                      set_report_scan_run_status (global_current_report,
-                                                  TASK_STATUS_QUEUED);
-                      queued_status_updated = TRUE;
-                    }
-                }
-              else if (osp_scan_status == OSP_SCAN_STATUS_INTERRUPTED)
-                {
-                  result_t result = make_osp_result
-                    (task, "", "", "",
-                     threat_message_type ("Error"),
-                     "Task interrupted unexpectedly", "", "",
-                     QOD_DEFAULT, NULL);
-                  report_add_result (report, result);
-                  delete_osp_scan (scan_id, host, port, ca_pub, key_pub,
-                                   key_priv);
-                  rc = -3;
-                  break;
-                }
-              else if (progress >= 0 && progress < 100
-                  && osp_scan_status == OSP_SCAN_STATUS_STOPPED)
-                {
-                  if (retry > 0)
-                    {
-                      retry--;
-                      g_warning ("Connection lost with the scanner at %s. "
-                                 "Trying again in 1 second.", host);
-                      gvm_sleep (1);
-                      continue;
-                    }
+/**
+ * @brief Handle an ongoing OSP scan, until success or failure.
+ *
+ * @param[in]   task      The task.
+ * @param[in]   report    The report.
+ * @param[in]   scan_id   The UUID of the scan on the scanner.
+ *
+ * @return 0 if success, -1 if error, -2 if scan was stopped,
+ *         -3 if the scan was interrupted.
+ */
+static int
+handle_osp_scan (task_t task, report_t report, const char *scan_id)
+{
+  osp_scan_t *scan;
+  int rc;
 
-                  result_t result = make_osp_result
-                    (task, "", "", "",
-                     threat_message_type ("Error"),
-                     "Scan stopped unexpectedly by the server", "", "",
-                     QOD_DEFAULT, NULL);
-                  report_add_result (report, result);
-                  delete_osp_scan (scan_id, host, port, ca_pub, key_pub,
-                                   key_priv);
-                  rc = -1;
-                  break;
-                }
-              else if (progress == 100
-                       && osp_scan_status == OSP_SCAN_STATUS_FINISHED)
-                {
-                  delete_osp_scan (scan_id, host, port, ca_pub, key_pub,
-                                   key_priv);
-                  rc = 0;
-                  break;
-                }
-              else if (osp_scan_status == OSP_SCAN_STATUS_RUNNING
-                       && started == FALSE)
-                {
-                  set_task_run_status (task, TASK_STATUS_RUNNING);
-                  set_report_scan_run_status (global_current_report,
-                                              TASK_STATUS_RUNNING);
-                  started = TRUE;
-                }
-            }
-        }
+  scan = osp_scan_new (task, report, scan_id);
+  /* Keep the report hosts in memory across all pops of the scan. */
+  report_host_cache_init (report);
+
+  while ((rc = osp_scan_poll (scan)) == 1)
+    {
+      time_t now;
 
-      retry = connection_retry;
-      gvm_sleep (5);
+      now = time (NULL);
+      if (scan->next_poll > now)
+        gvm_sleep (scan->next_poll - now);
     }
 
-  g_free (host);
-  g_free (ca_pub);
-  g_free (key_pub);
-  g_free (key_priv);
+  report_host_cache_free ();
+  osp_scan_free (scan);
   return rc;
 }
 
+/**
+ * @brief Set the final status of a task and report after an OSP scan.
+ *
+ * @param[in]   task      The task.
+ * @param[in]   report    The report.
+ * @param[in]   rc        Return of handle_osp_scan.
+ */
+static void
+finish_osp_scan (task_t task, report_t report, int rc)
+{
+  if (rc == 0)
+    {
+      hosts_set_identifiers (report);
+      hosts_set_max_severity (report, NULL, NULL);
+      hosts_set_details (report);
+      set_task_run_status (task, TASK_STATUS_DONE);
+      set_report_scan_run_status (report, TASK_STATUS_DONE);
+    }
+  else if (rc == -1 || rc == -2)
+    {
+      set_task_run_status (task, TASK_STATUS_STOPPED);
+      set_report_scan_run_status (report, TASK_STATUS_STOPPED);
+    }
+  else if (rc == -3)
+    {
+      set_task_run_status (task, TASK_STATUS_INTERRUPTED);
+      set_report_scan_run_status (report, TASK_STATUS_INTERRUPTED);
+    }
+
+  set_task_end_time_epoch (task, time (NULL));
+  set_scan_end_time_epoch (report, time (NULL));
+}
+
 /**
  * @brief Get an OSP Task's scan options.
  *
@@ -2315,6 +2583,41 @@ target_osp_snmp_credential (target_t target)
   return NULL;
 }
 
+/**
+ * @brief Store the results that a stopped OSP scan still holds.
+ *
+ * @param[in]  task     The task of the scan.
+ * @param[in]  scan_id  The scan uuid.
+ */
+static void
+prepare_osp_scan_pop_rest (task_t task, const char *scan_id)
+{
+  osp_connection_t *connection;
+  char *report_xml, *error;
+  int progress;
+
+  connection = osp_scanner_connect (task_scanner (task));
+  if (!connection)
+    return;
+
+  report_ingest_pending (global_current_report);
+  report_xml = NULL;
+  error = NULL;
+  progress = osp_get_scan_pop (connection, scan_id, &report_xml, 1, 1, &error);
+  osp_connection_close (connection);
+  if (progress < 0 || progress > 100)
+    {
+      g_warning ("%s: Failed to get results of scan %s: %s",
+                 __func__, scan_id, error);
+      g_free (error);
+      g_free (report_xml);
+      return;
+    }
+
+  parse_osp_report (task, global_current_report, report_xml);
+  g_free (report_xml);
+}
+
 /**
  * @brief Prepare a report for resuming an OSP scan
  *
@@ -2372,9 +2675,16 @@ prepare_osp_scan_for_resume (task_t task, const char *scan_id, char **error)
            || status == OSP_SCAN_STATUS_FINISHED)
     {
       g_debug ("%s: Scan %s queued, running or finished", __func__, scan_id);
-      /* It would be possible to simply continue getting the results
-       * from the scanner, but gvmd may have crashed while receiving
-       * or storing the results, so some may be missing. */
+      if (report_ingest_complete (global_current_report))
+        {
+          /* Every result popped so far is stored, so simply continue
+           * getting the results from the scanner. */
+          g_debug ("%s: Continuing with scan %s", __func__, scan_id);
+          osp_connection_close (connection);
+          return 0;
+        }
+      /* gvmd may have crashed while receiving or storing the results, so
+       * some may be missing. */
       if (osp_stop_scan (connection, scan_id, error))
         {
           osp_connection_close (connection);
@@ -2393,6 +2703,17 @@ prepare_osp_scan_for_resume (task_t task, const char *scan_id, char **error)
   else if (status == OSP_SCAN_STATUS_STOPPED)
     {
       g_debug ("%s: Scan %s stopped", __func__, scan_id);
+      osp_connection_close (connection);
+      if (report_ingest_complete (global_current_report))
+        /* Store the results that the scanner still holds, so that only the
+         * hosts that are still incomplete after them are scanned again. */
+        prepare_osp_scan_pop_rest (task, scan_id);
+      connection = osp_scanner_connect (task_scanner (task));
+      if (!connection)
+        {
+          *error = g_strdup ("Could not connect to Scanner");
+          return -1;
+        }
       if (osp_delete_scan (connection, scan_id))
         {
           *error = g_strdup ("Failed to delete old report");
@@ -2461,35 +2782,217 @@ add_user_scan_preferences (GHashTable *scanner_options)
 }
 
 /**
- * @brief Launch an OpenVAS via OSP task.
+ * @brief Build the scan bundle of a config.
  *
- * @param[in]   task        The task.
- * @param[in]   target      The target.
- * @param[in]   scan_id     The scan uuid.
- * @param[in]   from        0 start from beginning, 1 continue from stopped,
- *                          2 continue if stopped else start from beginning.
- * @param[out]  error       Error return.
+ * The bundle holds the scanner options, VT groups, VTs and VT preference
+ * values of the config, already converted for OSP, so that launching the
+ * many tasks that share a config only has to read them back.
  *
- * @return 0 success, -1 if scanner is down.
+ * @param[in]  config  Config.
  */
-static int
-launch_osp_openvas_task (task_t task, target_t target, const char *scan_id,
-                         int from, char **error)
+static void
+config_scan_bundle_build (config_t config)
 {
-  osp_connection_t *connection;
-  char *hosts_str, *ports_str, *exclude_hosts_str, *finished_hosts_str;
-  gchar *clean_hosts, *clean_exclude_hosts;
-  int alive_test, reverse_lookup_only, reverse_lookup_unify;
-  osp_target_t *osp_target;
-  GSList *osp_targets, *vts, *vt_groups;
+  iterator_t scanner_prefs_iter, families, prefs;
   GHashTable *vts_hash_table;
-  osp_credential_t *ssh_credential, *smb_credential, *esxi_credential;
-  osp_credential_t *snmp_credential;
+
+  if (config_scan_bundle_begin (config))
+    /* Built meanwhile by the launch of another task. */
+    return;
+
+  /* General scanner preferences */
+  init_preference_iterator (&scanner_prefs_iter, config, "SERVER_PREFS");
+  while (next (&scanner_prefs_iter))
+    {
+      const char *name, *value;
+      name = preference_iterator_name (&scanner_prefs_iter);
+      value = preference_iterator_value (&scanner_prefs_iter);
+      if (name && value)
+        {
+          const char *osp_value;
+
+          // Workaround for boolean scanner preferences
+          if (strcmp (value, "yes") == 0)
+            osp_value = "1";
+          else if (strcmp (value, "no") == 0)
+            osp_value = "0";
+          else
+            osp_value = value;
+          config_scan_bundle_add (config, CONFIG_SCAN_BUNDLE_SCANNER_OPTION,
+                                  name, NULL, osp_value);
+        }
+    }
+  cleanup_iterator (&scanner_prefs_iter);
+
+  /* Vulnerability tests (without preferences) */
+  vts_hash_table
+    = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  init_family_iterator (&families, 0, NULL, 1);
+  while (next (&families))
+    {
+      const char *family = family_iterator_name (&families);
+      if (family && config_family_entire_and_growing (config, family))
+        {
+          gchar *filter;
+
+          filter = g_strdup_printf ("family=%s", family);
+          config_scan_bundle_add (config, CONFIG_SCAN_BUNDLE_VT_GROUP,
+                                  filter, NULL, NULL);
+          g_free (filter);
+        }
+      else if (family)
+        {
+          iterator_t nvts;
+          init_nvt_iterator (&nvts, 0, config, family, NULL, 1, NULL);
+          while (next (&nvts))
+            {
+              const char *oid;
+
+              oid = nvt_iterator_oid (&nvts);
+              config_scan_bundle_add (config, CONFIG_SCAN_BUNDLE_VT,
+                                      oid, NULL, NULL);
+              g_hash_table_add (vts_hash_table, g_strdup (oid));
+            }
+          cleanup_iterator (&nvts);
+        }
+    }
+  cleanup_iterator (&families);
+
+  /* VT preferences */
+  init_preference_iterator (&prefs, config, "PLUGINS_PREFS");
+  while (next (&prefs))
+    {
+      const char *full_name, *value;
+      gchar **split_name;
+
+      full_name = preference_iterator_name (&prefs);
+      value = preference_iterator_value (&prefs);
+      split_name = g_strsplit (full_name, ":", 4);
+
+      if (split_name && split_name[0] && split_name[1] && split_name[2]
+          && g_hash_table_contains (vts_hash_table, split_name[0]))
+        {
+          const char *oid = split_name[0];
+          const char *pref_id = split_name[1];
+          const char *type = split_name[2];
+          gchar *osp_value = NULL;
+
+          if (strcmp (type, "checkbox") == 0)
+            {
+              if (strcmp (value, "yes") == 0)
+                osp_value = g_strdup ("1");
+              else
+                osp_value = g_strdup ("0");
+            }
+          else if (strcmp (type, "radio") == 0)
+            {
+              gchar** split_value;
+              split_value = g_strsplit (value, ";", 2);
+              osp_value = g_strdup (split_value[0]);
+              g_strfreev (split_value);
+            }
+          else if (strcmp (type, "file") == 0)
+            osp_value = g_base64_encode ((guchar*) value, strlen (value));
+
+          config_scan_bundle_add (config, CONFIG_SCAN_BUNDLE_VT_VALUE,
+                                  oid, pref_id,
+                                  osp_value ? osp_value : value);
+          g_free (osp_value);
+        }
+
+      g_strfreev (split_name);
+    }
+  cleanup_iterator (&prefs);
+  g_hash_table_destroy (vts_hash_table);
+
+  config_scan_bundle_commit ();
+}
+
+/**
+ * @brief Set up the OSP scanner options and VTs of a config from its bundle.
+ *
+ * @param[in]   config           Config.
+ * @param[in]   scanner_options  Scanner options to add to.
+ * @param[out]  vts              VTs.
+ * @param[out]  vt_groups        VT groups.
+ */
+static void
+config_scan_bundle_load (config_t config, GHashTable *scanner_options,
+                         GSList **vts, GSList **vt_groups)
+{
+  iterator_t items;
+  GHashTable *vts_hash_table;
+
+  vts_hash_table
+    = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                             /* Value is freed in vts list. */
+                             NULL);
+
+  init_config_scan_bundle_iterator (&items, config);
+  while (next (&items))
+    {
+      const char *name, *value;
+      osp_vt_single_t *osp_vt;
+
+      name = config_scan_bundle_iterator_name (&items);
+      value = config_scan_bundle_iterator_value (&items);
+      switch (config_scan_bundle_iterator_kind (&items))
+        {
+          case CONFIG_SCAN_BUNDLE_SCANNER_OPTION:
+            g_hash_table_replace (scanner_options,
+                                  g_strdup (name),
+                                  g_strdup (value));
+            break;
+          case CONFIG_SCAN_BUNDLE_VT_GROUP:
+            *vt_groups = g_slist_prepend (*vt_groups,
+                                          osp_vt_group_new (name));
+            break;
+          case CONFIG_SCAN_BUNDLE_VT:
+            osp_vt = osp_vt_single_new (name);
+            *vts = g_slist_prepend (*vts, osp_vt);
+            g_hash_table_replace (vts_hash_table, g_strdup (name), osp_vt);
+            break;
+          case CONFIG_SCAN_BUNDLE_VT_VALUE:
+            osp_vt = g_hash_table_lookup (vts_hash_table, name);
+            if (osp_vt)
+              osp_vt_single_add_value
+               (osp_vt, config_scan_bundle_iterator_pref_id (&items), value);
+            break;
+        }
+    }
+  cleanup_iterator (&items);
+  g_hash_table_destroy (vts_hash_table);
+}
+
+/**
+ * @brief Launch an OpenVAS via OSP task.
+ *
+ * @param[in]   task        The task.
+ * @param[in]   target      The target.
+ * @param[in]   scan_id     The scan uuid.
+ * @param[in]   from        0 start from beginning, 1 continue from stopped,
+ *                          2 continue if stopped else start from beginning.
+ * @param[out]  error       Error return.
+ *
+ * @return 0 success, -1 if scanner is down.
+ */
+static int
+launch_osp_openvas_task (task_t task, target_t target, const char *scan_id,
+                         int from, char **error)
+{
+  osp_connection_t *connection;
+  char *hosts_str, *ports_str, *exclude_hosts_str, *finished_hosts_str;
+  gchar *clean_hosts, *clean_exclude_hosts;
+  int alive_test, reverse_lookup_only, reverse_lookup_unify;
+  osp_target_t *osp_target;
+  GSList *osp_targets, *vts, *vt_groups;
+  osp_credential_t *ssh_credential, *smb_credential, *esxi_credential;
+  osp_credential_t *snmp_credential;
   gchar *max_checks, *max_hosts, *hosts_ordering;
   GHashTable *scanner_options;
   int ret;
   config_t config;
-  iterator_t scanner_prefs_iter, families, prefs;
   osp_start_scan_opts_t start_scan_opts;
 
   config = task_config (task);
@@ -2571,32 +3074,14 @@ launch_osp_openvas_task (task_t task, target_t target, const char *scan_id,
   if (snmp_credential)
     osp_target_add_credential (osp_target, snmp_credential);
 
-  /* Setup general scanner preferences */
+  /* Setup general scanner preferences and vulnerability tests */
   scanner_options
     = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-  init_preference_iterator (&scanner_prefs_iter, config, "SERVER_PREFS");
-  while (next (&scanner_prefs_iter))
-    {
-      const char *name, *value;
-      name = preference_iterator_name (&scanner_prefs_iter);
-      value = preference_iterator_value (&scanner_prefs_iter);
-      if (name && value)
-        {
-          const char *osp_value;
-
-          // Workaround for boolean scanner preferences
-          if (strcmp (value, "yes") == 0)
-            osp_value = "1";
-          else if (strcmp (value, "no") == 0)
-            osp_value = "0";
-          else
-            osp_value = value;
-          g_hash_table_replace (scanner_options,
-                                g_strdup (name),
-                                g_strdup (osp_value));
-        }
-    }
-  cleanup_iterator (&scanner_prefs_iter);
+  vts = NULL;
+  vt_groups = NULL;
+  if (config_scan_bundle_current (config) == 0)
+    config_scan_bundle_build (config);
+  config_scan_bundle_load (config, scanner_options, &vts, &vt_groups);
 
   /* Setup user-specific scanner preference */
   add_user_scan_preferences (scanner_options);
@@ -2615,98 +3100,6 @@ launch_osp_openvas_task (task_t task, target_t target, const char *scan_id,
     g_hash_table_insert (scanner_options, g_strdup ("hosts_ordering"),
                          hosts_ordering);
 
-  /* Setup vulnerability tests (without preferences) */
-  vts = NULL;
-  vt_groups = NULL;
-  vts_hash_table
-    = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
-                             /* Value is freed in vts list. */
-                             NULL);
-
-  init_family_iterator (&families, 0, NULL, 1);
-  while (next (&families))
-    {
-      const char *family = family_iterator_name (&families);
-      if (family && config_family_entire_and_growing (config, family))
-        {
-          gchar *filter;
-          osp_vt_group_t *vt_group;
-
-          filter = g_strdup_printf ("family=%s", family);
-          vt_group = osp_vt_group_new (filter);
-          g_free (filter);
-
-          vt_groups = g_slist_prepend (vt_groups, vt_group);
-        }
-      else if (family)
-        {
-          iterator_t nvts;
-          init_nvt_iterator (&nvts, 0, config, family, NULL, 1, NULL);
-          while (next (&nvts))
-            {
-              const char *oid;
-              osp_vt_single_t *new_vt;
-
-              oid = nvt_iterator_oid (&nvts);
-              new_vt = osp_vt_single_new (oid);
-
-              vts = g_slist_prepend (vts, new_vt);
-              g_hash_table_replace (vts_hash_table, g_strdup (oid), new_vt);
-            }
-          cleanup_iterator (&nvts);
-        }
-    }
-  cleanup_iterator (&families);
-
-  /* Setup VT preferences */
-  init_preference_iterator (&prefs, config, "PLUGINS_PREFS");
-  while (next (&prefs))
-    {
-      const char *full_name, *value;
-      osp_vt_single_t *osp_vt;
-      gchar **split_name;
-
-      full_name = preference_iterator_name (&prefs);
-      value = preference_iterator_value (&prefs);
-      split_name = g_strsplit (full_name, ":", 4);
-
-      osp_vt = NULL;
-      if (split_name && split_name[0] && split_name[1] && split_name[2])
-        {
-          const char *oid = split_name[0];
-          const char *pref_id = split_name[1];
-          const char *type = split_name[2];
-          gchar *osp_value = NULL;
-
-          if (strcmp (type, "checkbox") == 0)
-            {
-              if (strcmp (value, "yes") == 0)
-                osp_value = g_strdup ("1");
-              else
-                osp_value = g_strdup ("0");
-            }
-          else if (strcmp (type, "radio") == 0)
-            {
-              gchar** split_value;
-              split_value = g_strsplit (value, ";", 2);
-              osp_value = g_strdup (split_value[0]);
-              g_strfreev (split_value);
-            }
-          else if (strcmp (type, "file") == 0)
-            osp_value = g_base64_encode ((guchar*) value, strlen (value));
-
-          osp_vt = g_hash_table_lookup (vts_hash_table, oid);
-          if (osp_vt)
-            osp_vt_single_add_value (osp_vt, pref_id,
-                                     osp_value ? osp_value : value);
-          g_free (osp_value);
-        }
-
-      g_strfreev (split_name);
-    }
-  cleanup_iterator (&prefs);
-  g_hash_table_destroy (vts_hash_table);
-
   /* Start the scan */
   connection = osp_scanner_connect (task_scanner (task));
   if (!connection)
@@ -2906,35 +3299,152 @@ fork_osp_scan_handler (task_t task, target_t target, int from,
       exit (-1);
     }
 
-  snprintf (title, sizeof (title), "gvmd: OSP: Handling scan %s", report_id);
-  proctitle_set (title);
+  if (osp_scan_monitors > 0)
+    {
+      /* Leave the polling to the OSP scan monitor, which picks up the
+       * scan once the task is queued. */
+      set_task_run_status (task, TASK_STATUS_QUEUED);
+      set_report_scan_run_status (global_current_report, TASK_STATUS_QUEUED);
+      g_free (report_id);
+      global_current_report = 0;
+      current_scanner_task = (task_t) 0;
+      exit (0);
+    }
+
+  snprintf (title, sizeof (title), "gvmd: OSP: Handling scan %s", report_id);
+  proctitle_set (title);
+
+  rc = handle_osp_scan (task, global_current_report, report_id);
+  g_free (report_id);
+  finish_osp_scan (task, global_current_report, rc);
+  global_current_report = 0;
+  current_scanner_task = (task_t) 0;
+  exit (rc);
+}
+
+/**
+ * @brief Add the scans that were handed over to an OSP scan monitor.
+ *
+ * @param[in]  scans   Scans being monitored, keyed on task.
+ * @param[in]  index   Index of the monitor.
+ */
+static void
+osp_scan_monitor_adopt (GHashTable *scans, int index)
+{
+  iterator_t tasks;
+
+  init_active_osp_task_iterator (&tasks, osp_scan_monitors, index);
+  while (next (&tasks))
+    {
+      task_t task;
+      report_t report;
+      char *scan_id;
+      osp_scan_t *scan;
+
+      task = active_osp_task_iterator_task (&tasks);
+      if (g_hash_table_contains (scans, &task))
+        continue;
+
+      report = task_running_report (task);
+      if (report == 0)
+        continue;
+      scan_id = report_uuid (report);
+      if (scan_id == NULL)
+        continue;
+
+      scan = osp_scan_new (task, report, scan_id);
+      scan->owner_uuid = g_strdup (active_osp_task_iterator_owner_uuid
+                                    (&tasks));
+      scan->owner_name = g_strdup (active_osp_task_iterator_owner_name
+                                    (&tasks));
+      if (active_osp_task_iterator_run_status (&tasks) == TASK_STATUS_RUNNING)
+        scan->started = TRUE;
+      else
+        scan->queued_status_updated = TRUE;
+      g_hash_table_insert (scans, &scan->task, scan);
+      g_debug ("%s: monitoring scan %s", __func__, scan_id);
+      g_free (scan_id);
+    }
+  cleanup_iterator (&tasks);
+}
+
+/**
+ * @brief Poll a scan in an OSP scan monitor, as the owner of the task.
+ *
+ * @param[in]  scan   OSP scan.
+ *
+ * @return 1 if the scan is still going, else the scan is finished.
+ */
+static int
+osp_scan_monitor_poll (osp_scan_t *scan)
+{
+  int rc;
+
+  current_credentials.uuid = scan->owner_uuid;
+  current_credentials.username = scan->owner_name;
+  manage_session_init (current_credentials.uuid);
+  current_scanner_task = scan->task;
+  global_current_report = scan->report;
+
+  rc = osp_scan_poll (scan);
+  if (rc != 1)
+    finish_osp_scan (scan->task, scan->report, rc);
+
+  global_current_report = (report_t) 0;
+  current_scanner_task = (task_t) 0;
+  current_credentials.uuid = NULL;
+  current_credentials.username = NULL;
+  return rc;
+}
+
+/**
+ * @brief Monitor the OSP scans that the scan handlers hand over.
+ *
+ * Polls all the scans of the monitor from one process, so that the scans
+ * share a single database connection instead of a process and connection
+ * each.  Returns when the parent process exits.
+ *
+ * @param[in]  index  Index of the monitor, from 0 to the number of monitors
+ *                    less one.
+ */
+void
+manage_osp_scan_monitor (int index)
+{
+  GHashTable *scans;
+  time_t last_adopt;
+  pid_t parent;
+
+  parent = getppid ();
+  reinit_manage_process ();
+  manage_session_init (current_credentials.uuid);
+
+  scans = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL,
+                                 (GDestroyNotify) osp_scan_free);
+  last_adopt = 0;
+  while (getppid () == parent)
+    {
+      GHashTableIter iter;
+      osp_scan_t *scan;
+
+      if ((time (NULL) - last_adopt) >= OSP_SCAN_MONITOR_ADOPT_PERIOD)
+        {
+          osp_scan_monitor_adopt (scans, index);
+          last_adopt = time (NULL);
+        }
+
+      g_hash_table_iter_init (&iter, scans);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &scan))
+        {
+          if (scan->next_poll > time (NULL))
+            continue;
+          if (osp_scan_monitor_poll (scan) != 1)
+            g_hash_table_iter_remove (&iter);
+        }
 
-  rc = handle_osp_scan (task, global_current_report, report_id);
-  g_free (report_id);
-  if (rc == 0)
-    {
-      hosts_set_identifiers (global_current_report);
-      hosts_set_max_severity (global_current_report, NULL, NULL);
-      hosts_set_details (global_current_report);
-      set_task_run_status (task, TASK_STATUS_DONE);
-      set_report_scan_run_status (global_current_report, TASK_STATUS_DONE);
-    }
-  else if (rc == -1 || rc == -2)
-    {
-      set_task_run_status (task, TASK_STATUS_STOPPED);
-      set_report_scan_run_status (global_current_report, TASK_STATUS_STOPPED);
-    }
-  else if (rc == -3)
-    {
-      set_task_run_status (task, TASK_STATUS_INTERRUPTED);
-      set_report_scan_run_status (global_current_report, TASK_STATUS_INTERRUPTED);
+      gvm_sleep (1);
     }
 
-  set_task_end_time_epoch (task, time (NULL));
-  set_scan_end_time_epoch (global_current_report, time (NULL));
-  global_current_report = 0;
-  current_scanner_task = (task_t) 0;
-  exit (rc);
+  g_hash_table_destroy (scans);
 }
 
 /**
@@ -3000,32 +3510,95 @@ set_scanner_connection_retry (int new_retry)
     scanner_connection_retry = new_retry;
 }
 
+/**
+ * @brief Get the minimum number of seconds between polls of an OSP scan.
+ *
+ * @return The minimum poll interval in seconds.
+ */
+int
+get_osp_poll_interval_min ()
+{
+  return osp_poll_interval_min;
+}
+
+/**
+ * @brief Get the maximum number of seconds between polls of an OSP scan.
+ *
+ * @return The maximum poll interval in seconds.
+ */
+int
+get_osp_poll_interval_max ()
+{
+  return osp_poll_interval_max;
+}
+
+/**
+ * @brief Set the range of seconds between polls of an OSP scan.
+ *
+ * @param[in]  new_min  The minimum poll interval, at least 1.
+ * @param[in]  new_max  The maximum poll interval, at least new_min.
+ */
+void
+set_osp_poll_intervals (int new_min, int new_max)
+{
+  osp_poll_interval_min = new_min < 1 ? 1 : new_min;
+  osp_poll_interval_max = new_max < osp_poll_interval_min
+                           ? osp_poll_interval_min
+                           : new_max;
+}
+
+/**
+ * @brief Get the number of OSP scan monitor processes.
+ *
+ * @return The number of monitors, 0 if each scan has its own process.
+ */
+int
+get_osp_scan_monitors ()
+{
+  return osp_scan_monitors;
+}
+
+/**
+ * @brief Set the number of OSP scan monitor processes.
+ *
+ * @param[in]  new_monitors  The number of monitors, 0 for a process per scan.
+ */
+void
+set_osp_scan_monitors (int new_monitors)
+{
+  if (new_monitors < 0)
+    osp_scan_monitors = 0;
+  else if (new_monitors > OSP_SCAN_MONITORS_MAX)
+    osp_scan_monitors = OSP_SCAN_MONITORS_MAX;
+  else
+    osp_scan_monitors = new_monitors;
+}
+
 
 /* CVE tasks. */
 
 /**
- * @brief Perform a CVE "scan" on a host.
+ * @brief Find the report host that a CVE "scan" of a host takes products from.
  *
- * @param[in]  task      Task.
- * @param[in]  report    The report to add the host, results and details to.
- * @param[in]  gvm_host  Host.
+ * @param[in]  gvm_host      Host.
+ * @param[in]  ips           IPs to scan.  The IP of the host is added if the
+ *                           host has a report host.
+ * @param[in]  report_hosts  Report hosts, added in step with ips.
  *
  * @return 0 success, 1 failed to get nthlast report for a host.
  */
 static int
-cve_scan_host (task_t task, report_t report, gvm_host_t *gvm_host)
+cve_scan_host (gvm_host_t *gvm_host, GPtrArray *ips, GArray *report_hosts)
 {
   report_host_t report_host;
   gchar *ip, *host;
 
-  assert (task);
-  assert (report);
-
   host = gvm_host_value_str (gvm_host);
 
   ip = report_host_ip (host);
   if (ip == NULL)
     ip = g_strdup (host);
+  g_free (host);
 
   g_debug ("%s: ip: %s", __func__, ip);
 
@@ -3042,110 +3615,12 @@ cve_scan_host (task_t task, report_t report, gvm_host_t *gvm_host)
 
   if (report_host)
     {
-      iterator_t report_hosts;
-
-      /* Get the report_host for the host. */
-
-      init_report_host_iterator (&report_hosts, 0, NULL, report_host);
-      if (next (&report_hosts))
-        {
-          iterator_t prognosis;
-          int prognosis_report_host, start_time;
-
-          /* Add report_host with prognosis results and host details. */
-
-          start_time = time (NULL);
-          prognosis_report_host = 0;
-          init_host_prognosis_iterator (&prognosis, report_host);
-          while (next (&prognosis))
-            {
-              const char *app, *cve;
-              double severity;
-              gchar *desc;
-              iterator_t locations_iter;
-              GString *locations;
-              result_t result;
-
-              if (prognosis_report_host == 0)
-                prognosis_report_host = manage_report_host_add (report,
-                                                                ip,
-                                                                start_time,
-                                                                0);
-
-              severity = prognosis_iterator_cvss_double (&prognosis);
-
-              app = prognosis_iterator_cpe (&prognosis);
-              cve = prognosis_iterator_cve (&prognosis);
-              locations = g_string_new("");
-
-              insert_report_host_detail (global_current_report, ip, "cve", cve,
-                                         "CVE Scanner", "App", app);
-
-              init_app_locations_iterator (&locations_iter, report_host, app);
-
-              while (next (&locations_iter))
-                {
-                  const char *location;
-                  location = app_locations_iterator_location (&locations_iter);
-
-                  if (locations->len)
-                    g_string_append (locations, ", ");
-                  g_string_append (locations, location);
-
-                  insert_report_host_detail (report, ip, "cve", cve,
-                                             "CVE Scanner", app, location);
-
-                  insert_report_host_detail (report, ip, "cve", cve,
-                                             "CVE Scanner", "detected_at",
-                                             location);
-
-                  insert_report_host_detail (report, ip, "cve", cve,
-                                             "CVE Scanner", "detected_by",
-                                             /* Detected by itself. */
-                                             cve);
-                }
-
-              desc = g_strdup_printf ("The host carries the product: %s\n"
-                                      "It is vulnerable according to: %s.\n"
-                                      "%s%s%s"
-                                      "\n"
-                                      "%s",
-                                      app,
-                                      cve,
-                                      locations->len
-                                       ? "The product was found at: "
-                                       : "",
-                                      locations->len ? locations->str : "",
-                                      locations->len ? ".\n" : "",
-                                      prognosis_iterator_description
-                                       (&prognosis));
-
-              g_debug ("%s: making result with severity %1.1f desc [%s]",
-                       __func__, severity, desc);
-
-              result = make_cve_result (task, ip, cve, severity, desc);
-              g_free (desc);
-
-              report_add_result (report, result);
-
-              g_string_free (locations, TRUE);
-            }
-          cleanup_iterator (&prognosis);
-
-          if (prognosis_report_host)
-            {
-              /* Complete the report_host. */
-
-              report_host_set_end_time (prognosis_report_host, time (NULL));
-              insert_report_host_detail (report, ip, "cve", "",
-                                         "CVE Scanner", "CVE Scan", "1");
-              update_report_modification_time (report);
-            }
-        }
-      cleanup_iterator (&report_hosts);
+      g_ptr_array_add (ips, ip);
+      g_array_append_val (report_hosts, report_host);
     }
+  else
+    g_free (ip);
 
-  g_free (ip);
   return 0;
 }
 
@@ -3166,6 +3641,8 @@ fork_cve_scan_handler (task_t task, target_t target)
   char *report_id, title[128], *hosts;
   gvm_hosts_t *gvm_hosts;
   gvm_host_t *gvm_host;
+  GPtrArray *ips;
+  GArray *report_hosts;
 
   assert (task);
   assert (target);
@@ -3230,22 +3707,31 @@ fork_cve_scan_handler (task_t task, target_t target)
   set_task_start_time_epoch (task, time (NULL));
   set_scan_start_time_epoch (global_current_report, time (NULL));
 
-  /* Add the results. */
+  /* Add the results.  The hosts are collected first, so that the results
+   * of all hosts can be matched and added together. */
 
+  ips = g_ptr_array_new_with_free_func (g_free);
+  report_hosts = g_array_new (FALSE, FALSE, sizeof (report_host_t));
   gvm_hosts = gvm_hosts_new (hosts);
   free (hosts);
   while ((gvm_host = gvm_hosts_next (gvm_hosts)))
-    if (cve_scan_host (task, global_current_report, gvm_host))
+    if (cve_scan_host (gvm_host, ips, report_hosts))
       {
         set_task_interrupted (task,
                               "Failed to get nthlast report."
                               "  Interrupting scan.");
         set_report_scan_run_status (global_current_report, TASK_STATUS_INTERRUPTED);
         gvm_hosts_free (gvm_hosts);
+        g_ptr_array_free (ips, TRUE);
+        g_array_free (report_hosts, TRUE);
         exit (1);
       }
   gvm_hosts_free (gvm_hosts);
 
+  report_add_cve_results (task, global_current_report, ips, report_hosts);
+  g_ptr_array_free (ips, TRUE);
+  g_array_free (report_hosts, TRUE);
+
   /* Set the end states. */
 
   set_scan_end_time_epoch (global_current_report, time (NULL));
@@ -4534,6 +5020,45 @@ int authenticate_allow_all = 0;
  */
 static gchar* schedule_user_uuid = NULL;
 
+/**
+ * @brief Earliest time that a scheduled task is due to start, 0 if none.
+ *
+ * Set by manage_schedule, so that the main loop can wake up for the start.
+ */
+static time_t schedule_next_due = 0;
+
+/**
+ * @brief Maximum number of active scans across all scanners, 0 for no limit.
+ */
+static int max_active_scans = MAX_ACTIVE_SCANS_DEFAULT;
+
+/**
+ * @brief Maximum number of active scans per scanner, 0 for no limit.
+ */
+static int max_active_scans_per_scanner = MAX_ACTIVE_SCANS_PER_SCANNER_DEFAULT;
+
+/**
+ * @brief Maximum number of scheduled task launches per minute, 0 for no limit.
+ */
+static int max_scan_launches = MAX_SCAN_LAUNCHES_DEFAULT;
+
+/**
+ * @brief Start of the current minute of scheduled task launches.
+ */
+static time_t scan_launch_window_start = 0;
+
+/**
+ * @brief Number of scheduled task launches in the current minute.
+ */
+static int scan_launch_window_count = 0;
+
+/**
+ * @brief Whether tasks are waiting in the launch queue.
+ *
+ * Set by manage_schedule, so that the main loop wakes up to launch them.
+ */
+static gboolean launch_queue_pending = FALSE;
+
 /**
  * @brief Ensure that any subsequent authentications succeed.
  *
@@ -4838,6 +5363,112 @@ scheduled_task_start (scheduled_task_t *scheduled_task,
   exit (EXIT_SUCCESS);
 }
 
+/**
+ * @brief Start the tasks in the launch queue that the launch limits allow.
+ *
+ * @param[in]  fork_connection  Function that forks a child which is connected
+ *                              to the Manager.  Must return PID in parent, 0
+ *                              in child, or -1 on error.
+ * @param[in]  sigmask_current  Sigmask to restore in child.
+ */
+static void
+launch_queued_tasks (manage_connection_forker_t fork_connection,
+                     sigset_t *sigmask_current)
+{
+  iterator_t queue;
+  GSList *starts;
+  GHashTable *scanner_active;
+  time_t now;
+  int timeout, active;
+
+  if (schedule_timeout < 0)
+    timeout = -1;
+  else
+    timeout = MAX (schedule_timeout * 60, SCHEDULE_TIMEOUT_MIN_SECS);
+  task_launch_queue_expire (timeout);
+
+  now = time (NULL);
+  if (now - scan_launch_window_start >= 60)
+    {
+      scan_launch_window_start = now;
+      scan_launch_window_count = 0;
+    }
+
+  active = max_active_scans ? task_launch_queue_active (0) : 0;
+  scanner_active = g_hash_table_new (g_direct_hash, g_direct_equal);
+  starts = NULL;
+
+  init_task_launch_queue_iterator (&queue);
+  while (next (&queue))
+    {
+      if (max_scan_launches
+          && scan_launch_window_count >= max_scan_launches)
+        break;
+      if (max_active_scans && active >= max_active_scans)
+        break;
+
+      if (max_active_scans_per_scanner)
+        {
+          scanner_t scanner;
+          gpointer key, value;
+          int scanner_count;
+
+          scanner = task_launch_queue_iterator_scanner (&queue);
+          key = GSIZE_TO_POINTER ((gsize) scanner);
+          if (g_hash_table_lookup_extended (scanner_active, key, NULL, &value))
+            scanner_count = GPOINTER_TO_INT (value);
+          else
+            scanner_count = task_launch_queue_active (scanner);
+
+          if (scanner_count >= max_active_scans_per_scanner)
+            {
+              /* Scanner is full, later tasks may use other scanners. */
+              g_hash_table_insert (scanner_active, key,
+                                   GINT_TO_POINTER (scanner_count));
+              continue;
+            }
+          g_hash_table_insert (scanner_active, key,
+                               GINT_TO_POINTER (scanner_count + 1));
+        }
+
+      active++;
+      scan_launch_window_count++;
+      starts = g_slist_prepend
+                (starts,
+                 scheduled_task_new
+                  (task_launch_queue_iterator_task_uuid (&queue),
+                   task_launch_queue_iterator_owner_uuid (&queue),
+                   task_launch_queue_iterator_owner_name (&queue)));
+    }
+  cleanup_iterator (&queue);
+  g_hash_table_destroy (scanner_active);
+
+  /* Start tasks in forked processes, now that the SQL statement is closed. */
+
+  starts = g_slist_reverse (starts);
+  while (starts)
+    {
+      scheduled_task_t *scheduled_task;
+
+      scheduled_task = starts->data;
+      starts = g_slist_delete_link (starts, starts);
+
+      task_launch_queue_set_launched (scheduled_task->task_uuid);
+      if (scheduled_task_start (scheduled_task,
+                                fork_connection,
+                                sigmask_current))
+        {
+          /* Error.  Restore the status, reschedule and continue to next
+           * task. */
+          task_launch_queue_remove (scheduled_task->task_uuid);
+          reschedule_task (scheduled_task->task_uuid);
+        }
+      scheduled_task_free (scheduled_task);
+    }
+
+  launch_queue_pending = task_launch_queue_count () > 0;
+}
+
 /**
  * @brief Stop a task, for the scheduler.
  *
@@ -4989,9 +5620,14 @@ manage_sync (sigset_t *sigmask_current,
 
   if (try_gvmd_data_sync)
     {
+      gint64 start;
+
+      start = g_get_monotonic_time ();
       manage_sync_configs ();
       manage_sync_port_lists ();
       manage_sync_report_formats ();
+      metrics_set (METRIC_FEED_SYNC_TIME_DATA,
+                   g_get_monotonic_time () - start);
     }
 }
 
@@ -5024,6 +5660,7 @@ manage_schedule (manage_connection_forker_t fork_connection,
   previous_stop_task = 0;
 
   auto_delete_reports ();
+  reap_deleted_reports ();
 
   ret = manage_update_nvti_cache ();
   if (ret)
@@ -5140,14 +5777,23 @@ manage_schedule (manage_connection_forker_t fork_connection,
       starts = starts->next;
       g_slist_free_1 (head);
 
-      if (scheduled_task_start (scheduled_task,
-                                fork_connection,
-                                sigmask_current))
+      if (max_active_scans
+          || max_active_scans_per_scanner
+          || max_scan_launches)
+        /* Leave the start to the launch queue. */
+        task_launch_queue_add (scheduled_task->task_uuid,
+                               scheduled_task->owner_uuid,
+                               scheduled_task->owner_name);
+      else if (scheduled_task_start (scheduled_task,
+                                     fork_connection,
+                                     sigmask_current))
         /* Error.  Reschedule and continue to next task. */
         reschedule_task (scheduled_task->task_uuid);
       scheduled_task_free (scheduled_task);
     }
 
+  launch_queued_tasks (fork_connection, sigmask_current);
+
   /* Stop tasks in forked processes, now that the SQL statement is closed. */
 
   while (stops)
@@ -5179,9 +5825,36 @@ manage_schedule (manage_connection_forker_t fork_connection,
   clear_duration_schedules (0);
   update_duration_schedule_periods (0);
 
+  schedule_next_due = task_schedule_next_due ();
+
   return 0;
 }
 
+/**
+ * @brief Get the seconds until manage_schedule should run again.
+ *
+ * This is when the next scheduled task is due to start, but at most
+ * SCHEDULE_PERIOD after the last run, so that changes to tasks and
+ * schedules are still picked up, and at least a second after the last run.
+ *
+ * @param[in]  last_schedule_time  Time that manage_schedule last ran.
+ *
+ * @return Seconds until manage_schedule is due, 0 if it is due now.
+ */
+int
+manage_schedule_wait (time_t last_schedule_time)
+{
+  time_t now, due;
+
+  now = time (NULL);
+  due = last_schedule_time + SCHEDULE_PERIOD;
+  if (schedule_next_due && (schedule_next_due < due))
+    due = MAX (schedule_next_due, last_schedule_time + 1);
+  if (launch_queue_pending)
+    due = MIN (due, last_schedule_time + 1);
+  return due > now ? due - now : 0;
+}
+
 /**
  * @brief Get the current schedule timeout.
  *
@@ -5207,6 +5880,25 @@ set_schedule_timeout (int new_timeout)
     schedule_timeout = new_timeout;
 }
 
+/**
+ * @brief Set the limits on launching scheduled tasks.
+ *
+ * When any limit is set, scheduled tasks that are due go into a launch
+ * queue and are started as the limits allow.
+ *
+ * @param[in]  active              Max active scans, 0 for no limit.
+ * @param[in]  active_per_scanner  Max active scans per scanner, 0 for no
+ *                                 limit.
+ * @param[in]  launches            Max launches per minute, 0 for no limit.
+ */
+void
+set_scan_launch_limits (int active, int active_per_scanner, int launches)
+{
+  max_active_scans = MAX (active, 0);
+  max_active_scans_per_scanner = MAX (active_per_scanner, 0);
+  max_scan_launches = MAX (launches, 0);
+}
+
 
 /* SecInfo. */
 
@@ -5382,6 +6074,190 @@ xsl_transform (gchar *stylesheet, gchar *xmlfile, gchar **param_names,
   return NULL;
 }
 
+/**
+ * @brief Fetch the details of a page of NVTs, for get_nvt_xml.
+ *
+ * Runs one query per relation for the whole page, instead of one per NVT.
+ *
+ * @param[in]  oids         OIDs of the NVTs.
+ * @param[in]  preferences  Whether to fetch preferences.
+ * @param[in]  counts       Whether to fetch preference counts.
+ * @param[in]  config       Config for preference values and timeouts, or 0.
+ *
+ * @return Details.  Free with nvt_details_free.
+ */
+nvt_details_t *
+nvt_details_new (GPtrArray *oids, int preferences, int counts,
+                 config_t config)
+{
+  nvt_details_t *details;
+  iterator_t rows;
+
+  details = g_malloc0 (sizeof (*details));
+  details->cert_refs = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, g_free);
+  details->severities = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, g_free);
+  details->default_timeouts = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                     g_free, g_free);
+  details->timeouts = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, g_free);
+  details->preferences = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, g_free);
+  details->preference_counts = g_hash_table_new_full (g_str_hash,
+                                                      g_str_equal,
+                                                      g_free, NULL);
+
+  if (manage_cert_loaded ())
+    {
+      init_nvts_cert_adv_iterator (&rows, oids);
+      while (next (&rows))
+        {
+          const char *oid;
+          gchar *refs, *ref;
+
+          oid = nvts_cert_adv_iterator_oid (&rows);
+          ref = g_markup_printf_escaped ("<ref type=\"%s\" id=\"%s\"/>",
+                                         nvts_cert_adv_iterator_type (&rows),
+                                         nvts_cert_adv_iterator_name (&rows));
+          refs = g_hash_table_lookup (details->cert_refs, oid);
+          g_hash_table_insert (details->cert_refs, g_strdup (oid),
+                               g_strconcat (refs ? refs : "", ref, NULL));
+          g_free (ref);
+        }
+      cleanup_iterator (&rows);
+    }
+
+  init_nvts_severity_iterator (&rows, oids);
+  while (next (&rows))
+    {
+      GString *buffer;
+      const char *oid;
+      gchar *xml;
+
+      oid = nvt_severity_iterator_oid (&rows);
+      xml = g_hash_table_lookup (details->severities, oid);
+      buffer = g_string_new (xml ? xml : "");
+      buffer_xml_append_printf
+          (buffer,
+           "<severity type=\"%s\">"
+           "<origin>%s</origin>"
+           "<date>%s</date>"
+           "<score>%0.1f</score>"
+           "<value>%s</value>"
+           "</severity>",
+           nvt_severity_iterator_type (&rows),
+           nvt_severity_iterator_origin (&rows),
+           nvt_severity_iterator_date (&rows),
+           nvt_severity_iterator_score (&rows),
+           nvt_severity_iterator_value (&rows));
+      g_hash_table_insert (details->severities, g_strdup (oid),
+                           g_string_free (buffer, FALSE));
+    }
+  cleanup_iterator (&rows);
+
+  init_nvt_default_timeout_iterator (&rows, oids);
+  while (next (&rows))
+    g_hash_table_insert (details->default_timeouts,
+                         g_strdup (nvt_timeout_iterator_oid (&rows)),
+                         g_strdup (nvt_timeout_iterator_value (&rows)));
+  cleanup_iterator (&rows);
+
+  if (config)
+    {
+      init_config_nvt_timeout_iterator (&rows, config, oids);
+      while (next (&rows))
+        g_hash_table_insert (details->timeouts,
+                             g_strdup (nvt_timeout_iterator_oid (&rows)),
+                             g_strdup (nvt_timeout_iterator_value (&rows)));
+      cleanup_iterator (&rows);
+    }
+
+  if (preferences || counts)
+    {
+      init_nvts_preference_iterator (&rows, oids);
+      while (next (&rows))
+        {
+          char *oid;
+
+          oid = nvt_preference_iterator_oid (&rows);
+          if (oid == NULL)
+            continue;
+
+          if (preferences)
+            {
+              GString *buffer;
+              gchar *xml;
+
+              xml = g_hash_table_lookup (details->preferences, oid);
+              buffer = g_string_new (xml ? xml : "");
+              buffer_config_preference_xml (buffer, &rows, config, 1);
+              g_hash_table_insert (details->preferences, g_strdup (oid),
+                                   g_string_free (buffer, FALSE));
+            }
+          g_hash_table_insert
+           (details->preference_counts,
+            oid,
+            GINT_TO_POINTER
+             (GPOINTER_TO_INT (g_hash_table_lookup
+                                (details->preference_counts, oid))
+              + 1));
+        }
+      cleanup_iterator (&rows);
+    }
+
+  return details;
+}
+
+/**
+ * @brief Free the details of a page of NVTs.
+ *
+ * @param[in]  details  Details.
+ */
+void
+nvt_details_free (nvt_details_t *details)
+{
+  if (details == NULL)
+    return;
+
+  g_hash_table_destroy (details->cert_refs);
+  g_hash_table_destroy (details->severities);
+  g_hash_table_destroy (details->default_timeouts);
+  g_hash_table_destroy (details->timeouts);
+  g_hash_table_destroy (details->preferences);
+  g_hash_table_destroy (details->preference_counts);
+  g_free (details);
+}
+
+/**
+ * @brief Get the config timeout of an NVT from the details of a page.
+ *
+ * @param[in]  details  Details.
+ * @param[in]  oid      OID of NVT.
+ *
+ * @return Newly allocated timeout if set for the NVT, else NULL.
+ */
+char *
+nvt_details_timeout (nvt_details_t *details, const char *oid)
+{
+  return g_strdup (g_hash_table_lookup (details->timeouts, oid));
+}
+
+/**
+ * @brief Get the preference count of an NVT from the details of a page.
+ *
+ * @param[in]  details  Details.
+ * @param[in]  oid      OID of NVT.
+ *
+ * @return Number of possible preferences on NVT.
+ */
+int
+nvt_details_preference_count (nvt_details_t *details, const char *oid)
+{
+  return GPOINTER_TO_INT (g_hash_table_lookup (details->preference_counts,
+                                               oid));
+}
+
 /**
  * @brief Define a code snippet for get_nvti_xml.
  *
@@ -5403,13 +6279,15 @@ xsl_transform (gchar *stylesheet, gchar *xmlfile, gchar **param_names,
  * @param[in]  timeout     Timeout.  Used if details is true.
  * @param[in]  config      Config, used if preferences is true.
  * @param[in]  close_tag   Whether to close the NVT tag or not.
+ * @param[in]  batch       Details of the page of NVTs, or NULL to fetch
+ *                         the details for this NVT alone.
  *
  * @return A dynamically allocated string containing the XML description.
  */
 gchar *
 get_nvt_xml (iterator_t *nvts, int details, int pref_count,
              int preferences, const char *timeout, config_t config,
-             int close_tag)
+             int close_tag, nvt_details_t *batch)
 {
   const char* oid = nvt_iterator_oid (nvts);
   const char* name = nvt_iterator_name (nvts);
@@ -5424,7 +6302,12 @@ get_nvt_xml (iterator_t *nvts, int details, int pref_count,
       GString *refs_str, *tags_str, *buffer, *nvt_tags;
       iterator_t cert_refs_iterator, tags, severities;
       gchar *tag_name_esc, *tag_value_esc, *tag_comment_esc;
-      char *default_timeout = nvt_default_timeout (oid);
+      char *default_timeout;
+
+      default_timeout = batch
+                         ? g_strdup (g_hash_table_lookup
+                                      (batch->default_timeouts, oid))
+                         : nvt_default_timeout (oid);
 
       DEF (family);
       DEF (tag);
@@ -5486,7 +6369,14 @@ get_nvt_xml (iterator_t *nvts, int details, int pref_count,
 
       refs_str = g_string_new ("");
 
-      if (manage_cert_loaded())
+      if (manage_cert_loaded() && batch)
+        {
+          const gchar *cert_refs;
+
+          cert_refs = g_hash_table_lookup (batch->cert_refs, oid);
+          g_string_append (refs_str, cert_refs ? cert_refs : "");
+        }
+      else if (manage_cert_loaded())
         {
           init_nvt_cert_bund_adv_iterator (&cert_refs_iterator, oid);
           while (next (&cert_refs_iterator))
@@ -5591,24 +6481,34 @@ get_nvt_xml (iterator_t *nvts, int details, int pref_count,
                                ? nvt_iterator_cvss_base (nvts)
                                : "");
 
-      init_nvt_severity_iterator (&severities, oid);
-      while (next (&severities))
+      if (batch)
+        {
+          const gchar *severities_xml;
+
+          severities_xml = g_hash_table_lookup (batch->severities, oid);
+          g_string_append (buffer, severities_xml ? severities_xml : "");
+        }
+      else
         {
-          buffer_xml_append_printf
-              (buffer,
-               "<severity type=\"%s\">"
-               "<origin>%s</origin>"
-               "<date>%s</date>"
-               "<score>%0.1f</score>"
-               "<value>%s</value>"
-               "</severity>",
-               nvt_severity_iterator_type (&severities),
-               nvt_severity_iterator_origin (&severities),
-               nvt_severity_iterator_date (&severities),
-               nvt_severity_iterator_score (&severities),
-               nvt_severity_iterator_value (&severities));
+          init_nvt_severity_iterator (&severities, oid);
+          while (next (&severities))
+            {
+              buffer_xml_append_printf
+                  (buffer,
+                   "<severity type=\"%s\">"
+                   "<origin>%s</origin>"
+                   "<date>%s</date>"
+                   "<score>%0.1f</score>"
+                   "<value>%s</value>"
+                   "</severity>",
+                   nvt_severity_iterator_type (&severities),
+                   nvt_severity_iterator_origin (&severities),
+                   nvt_severity_iterator_date (&severities),
+                   nvt_severity_iterator_score (&severities),
+                   nvt_severity_iterator_value (&severities));
+            }
+          cleanup_iterator (&severities);
         }
-      cleanup_iterator (&severities);
 
       g_string_append_printf (buffer,
                               "</severities>"
@@ -5669,10 +6569,22 @@ get_nvt_xml (iterator_t *nvts, int details, int pref_count,
                              timeout ? timeout : "",
                              default_timeout ? default_timeout : "");
 
-          init_nvt_preference_iterator (&prefs, nvt_oid);
-          while (next (&prefs))
-            buffer_config_preference_xml (buffer, &prefs, config, 1);
-          cleanup_iterator (&prefs);
+          if (batch)
+            {
+              const gchar *preferences_xml;
+
+              preferences_xml = g_hash_table_lookup (batch->preferences,
+                                                     nvt_oid);
+              g_string_append (buffer,
+                               preferences_xml ? preferences_xml : "");
+            }
+          else
+            {
+              init_nvt_preference_iterator (&prefs, nvt_oid);
+              while (next (&prefs))
+                buffer_config_preference_xml (buffer, &prefs, config, 1);
+              cleanup_iterator (&prefs);
+            }
 
           xml_string_append (buffer, "</preferences>");
         }
@@ -5811,7 +6723,8 @@ manage_read_info (gchar *type, gchar *uid, gchar *name, gchar **result)
                                    1,    /* Include preferences. */
                                    NULL, /* Timeout. */
                                    0,    /* Config. */
-                                   1);   /* Close tag. */
+                                   1,    /* Close tag. */
+                                   NULL);
 
           cleanup_iterator (&nvts);
         }
@@ -141,6 +141,9 @@ manage_cleanup_process_error (int);
 void
 manage_reset_currents ();
 
+void
+reinit_manage_worker ();
+
 
 /* Commands. */
 
@@ -199,6 +202,24 @@ extern credentials_t current_credentials;
 int
 authenticate (credentials_t*);
 
+/**
+ * @brief Default seconds that a GMP session token stays valid, 0 to disable
+ *        session tokens.
+ */
+#define GMP_SESSION_TTL_DEFAULT 0
+
+int
+authenticate_token (credentials_t*, const gchar *);
+
+gchar *
+manage_session_token_new (const credentials_t*);
+
+void
+manage_session_token_revoke (const gchar *);
+
+void
+set_gmp_session_ttl (int);
+
 
 /* Database. */
 
@@ -241,6 +262,46 @@ manage_transaction_start ();
 void
 manage_transaction_stop (gboolean);
 
+/**
+ * @brief Default time in milliseconds above which SQL statements are logged.
+ */
+#define SLOW_QUERY_THRESHOLD_DEFAULT 0
+
+void
+set_slow_query_threshold (int);
+
+void
+manage_sql_stats_reset ();
+
+void
+manage_sql_stats (int *, gint64 *);
+
+void
+manage_sql_stats_add (int, gint64);
+
+/**
+ * @brief Default replication lag in seconds up to which the replica is used.
+ */
+#define DB_REPLICA_MAX_LAG_DEFAULT 5
+
+void
+set_db_replica (const gchar *, const gchar *, int);
+
+int
+read_only_gmp_command (const char *);
+
+void
+manage_use_replica ();
+
+void
+manage_use_primary ();
+
+void
+set_db_transaction_pooling (int);
+
+int
+manage_metrics_write (const gchar *);
+
 
 /* Task structures. */
 
@@ -265,7 +326,8 @@ typedef enum
   /* 15 was removed (TASK_STATUS_STOP_REQUESTED_GIVEUP). */
   TASK_STATUS_DELETE_WAITING = 16,
   TASK_STATUS_DELETE_ULTIMATE_WAITING = 17,
-  TASK_STATUS_QUEUED = 18
+  TASK_STATUS_QUEUED = 18,
+  TASK_STATUS_LAUNCH_QUEUED = 19
 } task_status_t;
 
 /**
@@ -584,6 +646,32 @@ manage_alert (const char *, const char *, event_t, const void*, gchar **);
 int
 manage_test_alert (const char *, gchar **);
 
+/**
+ * @brief Default number of alert worker processes, 0 to run alerts in the
+ *        process that produces the event.
+ */
+#define ALERT_WORKERS_DEFAULT 0
+
+/**
+ * @brief Maximum number of alert worker processes.
+ */
+#define ALERT_WORKERS_MAX 16
+
+/**
+ * @brief Default number of queued alerts of one method that may run at once,
+ *        0 for no limit.
+ */
+#define ALERT_METHOD_WORKERS_DEFAULT 0
+
+int
+get_alert_workers ();
+
+void
+set_alert_workers (int, int);
+
+void
+manage_alert_worker (int);
+
 int
 alert_in_use (alert_t);
 
@@ -1013,6 +1101,13 @@ typedef struct
   double max;        ///< Max.
 } severity_data_t;
 
+/**
+ * @brief Number of severities that severity_data_add_batch bins at a time.
+ *
+ * Also a good size for callers to collect severities in.
+ */
+#define SEVERITY_DATA_BATCH 256
+
 double
 severity_data_value (int);
 
@@ -1028,6 +1123,9 @@ severity_data_add (severity_data_t*, double);
 void
 severity_data_add_count (severity_data_t*, double, int);
 
+void
+severity_data_add_batch (severity_data_t*, const double*, int);
+
 void
 severity_data_level_counts (const severity_data_t*,
                             int*, int*, int*, int*, int*, int*);
@@ -1143,6 +1241,111 @@ result_detection_reference (result_t, report_t, const char *, const char *,
  */
 #define MIN_QOD_DEFAULT 70
 
+/**
+ * @brief Default number of OSP results inserted per statement.
+ */
+#define OSP_RESULT_BATCH_SIZE_DEFAULT 500
+
+int
+get_osp_result_batch_size ();
+
+void
+set_osp_result_batch_size (int);
+
+/**
+ * @brief Default number of worker processes that render report hosts.
+ */
+#define REPORT_HOST_WORKERS_DEFAULT 0
+
+/**
+ * @brief Maximum number of worker processes that render report hosts.
+ */
+#define REPORT_HOST_WORKERS_MAX 64
+
+int
+get_report_host_workers ();
+
+void
+set_report_host_workers (int);
+
+/**
+ * @brief Default number of worker processes that run batched GMP commands.
+ */
+#define GMP_BATCH_WORKERS_DEFAULT 0
+
+/**
+ * @brief Maximum number of worker processes that run batched GMP commands.
+ */
+#define GMP_BATCH_WORKERS_MAX 64
+
+int
+get_gmp_batch_workers ();
+
+void
+set_gmp_batch_workers (int);
+
+/**
+ * @brief Default number of worker processes that rebuild the report cache.
+ */
+#define REPORT_CACHE_WORKERS_DEFAULT 0
+
+/**
+ * @brief Maximum number of worker processes that rebuild the report cache.
+ */
+#define REPORT_CACHE_WORKERS_MAX 64
+
+int
+get_report_cache_workers ();
+
+void
+set_report_cache_workers (int);
+
+/**
+ * @brief Default chunk size for the deferred deletion of reports.
+ */
+#define REPORT_DELETION_CHUNK_DEFAULT 0
+
+int
+get_report_deletion_chunk ();
+
+void
+set_report_deletion_chunk (int);
+
+/**
+ * @brief Default maximum size in MiB of the cache of rendered reports.
+ */
+#define REPORT_RENDER_CACHE_SIZE_DEFAULT 0
+
+int
+get_report_render_cache_size ();
+
+void
+set_report_render_cache_size (int);
+
+/**
+ * @brief Default maximum number of report format scripts running at once.
+ */
+#define REPORT_FORMAT_WORKERS_DEFAULT 0
+
+/**
+ * @brief Default CPU time limit in seconds of a report format script.
+ */
+#define REPORT_FORMAT_CPU_LIMIT_DEFAULT 0
+
+/**
+ * @brief Default memory limit in MiB of a report format script.
+ */
+#define REPORT_FORMAT_MEMORY_LIMIT_DEFAULT 0
+
+void
+set_report_format_workers (int);
+
+void
+set_report_format_cpu_limit (int);
+
+void
+set_report_format_memory_limit (int);
+
 void
 reports_clear_count_cache_for_override (override_t, int);
 
@@ -1251,7 +1454,16 @@ update_duration_schedule_periods (task_t);
 
 int
 create_report (array_t*, const char *, const char *, const char *, const char *,
-               array_t*, array_t*, array_t*, char **);
+               array_t*, array_t*, array_t*, report_t, char **);
+
+int
+create_report_stream_start (const char *, report_t *);
+
+int
+create_report_stream_add (report_t, array_t *);
+
+void
+create_report_stream_abort (report_t);
 
 void
 report_add_result (report_t, result_t);
@@ -1498,6 +1710,12 @@ collate_message_type (void* data, int, const void*, int, const void*);
 void
 trim_partial_report (report_t);
 
+void
+report_ingest_pending (report_t);
+
+int
+report_ingest_complete (report_t);
+
 int
 report_progress (report_t);
 
@@ -1540,6 +1758,9 @@ prognosis_iterator_cve (iterator_t*);
 const char*
 prognosis_iterator_description (iterator_t*);
 
+void
+report_add_cve_results (task_t, report_t, GPtrArray *, GArray *);
+
 
 /* Targets. */
 
@@ -1797,6 +2018,18 @@ init_nvt_iterator (iterator_t*, nvt_t, config_t, const char*, const char*, int,
 void
 init_cve_nvt_iterator (iterator_t*, const char *, int, const char*);
 
+void
+init_cves_nvt_iterator (iterator_t*, GPtrArray *);
+
+const char*
+cves_nvt_iterator_cve (iterator_t*);
+
+const char*
+cves_nvt_iterator_oid (iterator_t*);
+
+const char*
+cves_nvt_iterator_name (iterator_t*);
+
 const char*
 nvt_iterator_oid (iterator_t*);
 
@@ -1854,6 +2087,15 @@ nvt_iterator_solution_method (iterator_t*);
 char*
 nvt_default_timeout (const char *);
 
+void
+init_nvt_default_timeout_iterator (iterator_t *, GPtrArray *);
+
+const char*
+nvt_timeout_iterator_oid (iterator_t *);
+
+const char*
+nvt_timeout_iterator_value (iterator_t *);
+
 int
 family_nvt_count (const char *);
 
@@ -1922,6 +2164,9 @@ manage_nvt_preferences_enable ();
 void
 init_nvt_preference_iterator (iterator_t*, const char*);
 
+void
+init_nvts_preference_iterator (iterator_t*, GPtrArray *);
+
 const char*
 nvt_preference_iterator_name (iterator_t*);
 
@@ -1949,8 +2194,34 @@ nvt_preference_count (const char *);
 void
 xml_append_nvt_refs (GString *, const char *, int *);
 
+/**
+ * @brief Details of a page of NVTs, fetched together for get_nvt_xml.
+ */
+typedef struct
+{
+  GHashTable *cert_refs;          ///< CERT ref XML per OID.
+  GHashTable *severities;         ///< Severity XML per OID.
+  GHashTable *default_timeouts;   ///< Default timeout per OID.
+  GHashTable *timeouts;           ///< Config timeout per OID.
+  GHashTable *preferences;        ///< Preference XML per OID.
+  GHashTable *preference_counts;  ///< Preference count per OID.
+} nvt_details_t;
+
+nvt_details_t *
+nvt_details_new (GPtrArray *, int, int, config_t);
+
+void
+nvt_details_free (nvt_details_t *);
+
+char*
+nvt_details_timeout (nvt_details_t *, const char *);
+
+int
+nvt_details_preference_count (nvt_details_t *, const char *);
+
 gchar*
-get_nvt_xml (iterator_t*, int, int, int, const char*, config_t, int);
+get_nvt_xml (iterator_t*, int, int, int, const char*, config_t, int,
+             nvt_details_t *);
 
 char*
 task_preference_value (task_t, const char *);
@@ -1980,6 +2251,12 @@ task_role_iterator_uuid (iterator_t*);
 void
 init_nvt_severity_iterator (iterator_t *, const char *);
 
+void
+init_nvts_severity_iterator (iterator_t *, GPtrArray *);
+
+const char *
+nvt_severity_iterator_oid (iterator_t *);
+
 const char *
 nvt_severity_iterator_type (iterator_t *);
 
@@ -2276,6 +2553,9 @@ create_asset_host (const char *, const char *, resource_t* );
 int
 add_assets_from_host_in_report (report_t report, const char *host);
 
+int
+add_assets_from_hosts_in_report (report_t, GPtrArray *);
+
 
 /* Notes. */
 
@@ -2468,6 +2748,27 @@ manage_system_report (const char *, const char *, const char *, const char *,
  */
 #define SCANNER_CONNECTION_RETRY_DEFAULT 3
 
+/**
+ * @brief Default for the minimum seconds between polls of an OSP scan.
+ */
+#define OSP_POLL_INTERVAL_MIN_DEFAULT 5
+
+/**
+ * @brief Default for the maximum seconds between polls of an OSP scan.
+ */
+#define OSP_POLL_INTERVAL_MAX_DEFAULT 30
+
+/**
+ * @brief Default number of OSP scan monitor processes, 0 for a process per
+ *        scan.
+ */
+#define OSP_SCAN_MONITORS_DEFAULT 0
+
+/**
+ * @brief Maximum number of OSP scan monitor processes.
+ */
+#define OSP_SCAN_MONITORS_MAX 16
+
 int
 manage_create_scanner (GSList *, const db_conn_info_t *, const char *,
                        const char *, const char *, const char *, const char *,
@@ -2641,6 +2942,24 @@ get_scanner_connection_retry ();
 void
 set_scanner_connection_retry (int);
 
+int
+get_osp_poll_interval_min ();
+
+int
+get_osp_poll_interval_max ();
+
+void
+set_osp_poll_intervals (int, int);
+
+int
+get_osp_scan_monitors ();
+
+void
+set_osp_scan_monitors (int);
+
+void
+manage_osp_scan_monitor (int);
+
 int
 verify_scanner (const char *, char **);
 
@@ -2719,6 +3038,9 @@ manage_schedule (manage_connection_forker_t,
                  gboolean,
                  sigset_t *);
 
+int
+manage_schedule_wait (time_t);
+
 char *
 schedule_uuid (schedule_t);
 
@@ -2789,6 +3111,24 @@ get_schedule_timeout ();
 void
 set_schedule_timeout (int);
 
+/**
+ * @brief Default for max_active_scans.  0 for no limit.
+ */
+#define MAX_ACTIVE_SCANS_DEFAULT 0
+
+/**
+ * @brief Default for max_active_scans_per_scanner.  0 for no limit.
+ */
+#define MAX_ACTIVE_SCANS_PER_SCANNER_DEFAULT 0
+
+/**
+ * @brief Default for max_scan_launches.  0 for no limit.
+ */
+#define MAX_SCAN_LAUNCHES_DEFAULT 0
+
+void
+set_scan_launch_limits (int, int, int);
+
 
 /* Groups. */
 
@@ -2993,6 +3333,7 @@ struct keyword
   gchar *string;                 ///< The keyword string, outer quotes removed.
   keyword_type_t type;           ///< Type of keyword.
   keyword_relation_t relation;   ///< The relation.
+  int time;                      ///< Whether the value is a date or time.
 };
 
 /**
@@ -3049,6 +3390,12 @@ filter_term_apply_overrides (const char *);
 int
 filter_term_min_qod (const char *);
 
+gchar *
+keyset_token (resource_t, const char *);
+
+int
+filter_term_after (const char *, resource_t *, gchar **);
+
 int
 create_filter (const char*, const char*, const char*, const char*, filter_t*);
 
@@ -3220,6 +3567,18 @@ init_nvt_cert_bund_adv_iterator (iterator_t*, const char*);
 const char*
 nvt_cert_bund_adv_iterator_name (iterator_t*);
 
+void
+init_nvts_cert_adv_iterator (iterator_t*, GPtrArray *);
+
+const char*
+nvts_cert_adv_iterator_name (iterator_t*);
+
+const char*
+nvts_cert_adv_iterator_oid (iterator_t*);
+
+const char*
+nvts_cert_adv_iterator_type (iterator_t*);
+
 /* DFN-CERT */
 
 int
@@ -3243,6 +3602,21 @@ dfn_cert_adv_info_iterator_severity (iterator_t*);
 void
 init_cve_dfn_cert_adv_iterator (iterator_t*, const char*, int, const char*);
 
+void
+init_cves_cert_adv_iterator (iterator_t*, GPtrArray *);
+
+const char*
+cves_cert_adv_iterator_cve (iterator_t*);
+
+const char*
+cves_cert_adv_iterator_type (iterator_t*);
+
+const char*
+cves_cert_adv_iterator_name (iterator_t*);
+
+const char*
+cves_cert_adv_iterator_title (iterator_t*);
+
 void
 init_nvt_dfn_cert_adv_iterator (iterator_t*, const char*);
 
@@ -3315,6 +3689,18 @@ manage_get_users (GSList *, const db_conn_info_t *, const gchar *, int);
 report_host_t
 manage_report_host_add (report_t, const char *, time_t, time_t);
 
+void
+report_host_cache_init (report_t);
+
+void
+report_host_cache_free ();
+
+int
+report_host_cache_active (report_t);
+
+void
+result_nvt_info_cache_check ();
+
 int
 report_host_noticeable (report_t, const gchar *);
 
@@ -30,6 +30,7 @@
 #include "sql.h"
 
 #include <assert.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -39,6 +40,116 @@
  */
 #define G_LOG_DOMAIN "md manage"
 
+/**
+ * @brief Cache of ACL decisions, NULL when caching is off.
+ *
+ * Maps a key built by acl_cache_key to the decision plus one.
+ */
+static GHashTable *acl_cache = NULL;
+
+/**
+ * @brief Start caching ACL decisions.
+ *
+ * Used around the processing of GMP commands, so that the same checks
+ * done over and over for one request only go to the database once.
+ * Processes forked while the cache is on drop it in init_manage_process.
+ */
+void
+acl_cache_start ()
+{
+  if (acl_cache == NULL)
+    acl_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                       NULL);
+}
+
+/**
+ * @brief Stop caching ACL decisions, dropping the cached ones.
+ */
+void
+acl_cache_stop ()
+{
+  if (acl_cache)
+    {
+      g_hash_table_destroy (acl_cache);
+      acl_cache = NULL;
+    }
+}
+
+/**
+ * @brief Drop all cached ACL decisions.
+ *
+ * Must be called whenever permissions, roles, groups or users change.
+ */
+void
+acl_cache_clear ()
+{
+  if (acl_cache)
+    g_hash_table_remove_all (acl_cache);
+}
+
+/**
+ * @brief Build the key of an ACL decision.
+ *
+ * @param[in]  check     Name of check.
+ * @param[in]  user_id   UUID of user.
+ * @param[in]  argument  Further argument of check, or NULL.
+ *
+ * @return Freshly allocated key, or NULL if caching is off.
+ */
+static gchar *
+acl_cache_key (const char *check, const char *user_id, const char *argument)
+{
+  if (acl_cache == NULL || user_id == NULL)
+    return NULL;
+  return g_strdup_printf ("%s %s %s", check, user_id,
+                          argument ? argument : "");
+}
+
+/**
+ * @brief Look up a cached ACL decision.
+ *
+ * @param[in]   key  Key from acl_cache_key, or NULL.
+ * @param[out]  ret  Cached decision.
+ *
+ * @return 1 if found, else 0.
+ */
+static int
+acl_cache_lookup (const gchar *key, int *ret)
+{
+  gpointer value;
+
+  if (key == NULL || acl_cache == NULL)
+    return 0;
+
+  value = g_hash_table_lookup (acl_cache, key);
+  if (value == NULL)
+    return 0;
+
+  *ret = GPOINTER_TO_INT (value) - 1;
+  return 1;
+}
+
+/**
+ * @brief Cache an ACL decision.
+ *
+ * @param[in]  key  Key from acl_cache_key, or NULL.  Freed.
+ * @param[in]  ret  Decision.
+ *
+ * @return The decision.
+ */
+static int
+acl_cache_insert (gchar *key, int ret)
+{
+  if (key == NULL)
+    return ret;
+
+  if (acl_cache)
+    g_hash_table_insert (acl_cache, key, GINT_TO_POINTER (ret + 1));
+  else
+    g_free (key);
+  return ret;
+}
+
 /**
  * @brief Test whether the current user may perform an operation.
  *
@@ -158,15 +269,25 @@ acl_commands (gchar **disabled_commands)
 int
 acl_user_may (const char *operation)
 {
+  gchar *key;
+  int ret;
+
   if (strlen (current_credentials.uuid) == 0)
     /* Allow the dummy user in init_manage to do anything. */
     return 1;
 
+  key = acl_cache_key ("may", current_credentials.uuid, operation);
+  if (acl_cache_lookup (key, &ret))
+    {
+      g_free (key);
+      return ret;
+    }
+
   if (sql_int ("SELECT user_can_everything ('%s');",
                current_credentials.uuid))
-    return 1;
+    return acl_cache_insert (key, 1);
 
-  return user_may_internal (operation);
+  return acl_cache_insert (key, user_may_internal (operation));
 }
 
 /**
@@ -263,9 +384,16 @@ acl_user_can_super_everyone (const char *uuid)
 int
 acl_user_can_everything (const char *user_id)
 {
-  gchar *quoted_user_id;
+  gchar *quoted_user_id, *key;
   int ret;
 
+  key = acl_cache_key ("everything", user_id, NULL);
+  if (acl_cache_lookup (key, &ret))
+    {
+      g_free (key);
+      return ret;
+    }
+
   quoted_user_id = sql_quote (user_id);
   ret = sql_int ("SELECT count(*) > 0 FROM permissions"
                  " WHERE resource = 0"
@@ -296,7 +424,7 @@ acl_user_can_everything (const char *user_id)
                  quoted_user_id,
                  quoted_user_id);
   g_free (quoted_user_id);
-  return ret;
+  return acl_cache_insert (key, ret);
 }
 
 /**
@@ -310,7 +438,17 @@ acl_user_can_everything (const char *user_id)
 int
 acl_user_has_super (const char *super_user_id, user_t other_user)
 {
-  gchar *quoted_super_user_id;
+  gchar *quoted_super_user_id, *key, *other;
+  int ret;
+
+  other = g_strdup_printf ("%llu", other_user);
+  key = acl_cache_key ("super", super_user_id, other);
+  g_free (other);
+  if (acl_cache_lookup (key, &ret))
+    {
+      g_free (key);
+      return ret;
+    }
 
   quoted_super_user_id = sql_quote (super_user_id);
   if (sql_int (" SELECT EXISTS (SELECT * FROM permissions"
@@ -364,10 +502,10 @@ acl_user_has_super (const char *super_user_id, user_t other_user)
                super_user_id))
     {
       g_free (quoted_super_user_id);
-      return 1;
+      return acl_cache_insert (key, 1);
     }
   g_free (quoted_super_user_id);
-  return 0;
+  return acl_cache_insert (key, 0);
 }
 
 /**
@@ -381,7 +519,14 @@ int
 acl_user_is_admin (const char *uuid)
 {
   int ret;
-  gchar *quoted_uuid;
+  gchar *quoted_uuid, *key;
+
+  key = acl_cache_key ("admin", uuid, NULL);
+  if (acl_cache_lookup (key, &ret))
+    {
+      g_free (key);
+      return ret;
+    }
 
   quoted_uuid = sql_quote (uuid);
   ret = sql_int ("SELECT count (*) FROM role_users"
@@ -390,7 +535,7 @@ acl_user_is_admin (const char *uuid)
                  " AND \"user\" = (SELECT id FROM users WHERE uuid = '%s');",
                  quoted_uuid);
   g_free (quoted_uuid);
-  return ret;
+  return acl_cache_insert (key, ret);
 }
 
 /**
@@ -404,7 +549,14 @@ int
 acl_user_is_observer (const char *uuid)
 {
   int ret;
-  gchar *quoted_uuid;
+  gchar *quoted_uuid, *key;
+
+  key = acl_cache_key ("observer", uuid, NULL);
+  if (acl_cache_lookup (key, &ret))
+    {
+      g_free (key);
+      return ret;
+    }
 
   quoted_uuid = sql_quote (uuid);
   ret = sql_int ("SELECT count (*) FROM role_users"
@@ -413,7 +565,7 @@ acl_user_is_observer (const char *uuid)
                  " AND \"user\" = (SELECT id FROM users WHERE uuid = '%s');",
                  quoted_uuid);
   g_free (quoted_uuid);
-  return ret;
+  return acl_cache_insert (key, ret);
 }
 
 /**
@@ -427,7 +579,14 @@ int
 acl_user_is_super_admin (const char *uuid)
 {
   int ret;
-  gchar *quoted_uuid;
+  gchar *quoted_uuid, *key;
+
+  key = acl_cache_key ("super_admin", uuid, NULL);
+  if (acl_cache_lookup (key, &ret))
+    {
+      g_free (key);
+      return ret;
+    }
 
   quoted_uuid = sql_quote (uuid);
   ret = sql_int ("SELECT count (*) FROM role_users"
@@ -436,7 +595,7 @@ acl_user_is_super_admin (const char *uuid)
                  " AND \"user\" = (SELECT id FROM users WHERE uuid = '%s');",
                  quoted_uuid);
   g_free (quoted_uuid);
-  return ret;
+  return acl_cache_insert (key, ret);
 }
 
 /**
@@ -450,7 +609,14 @@ int
 acl_user_is_user (const char *uuid)
 {
   int ret;
-  gchar *quoted_uuid;
+  gchar *quoted_uuid, *key;
+
+  key = acl_cache_key ("user", uuid, NULL);
+  if (acl_cache_lookup (key, &ret))
+    {
+      g_free (key);
+      return ret;
+    }
 
   quoted_uuid = sql_quote (uuid);
   ret = sql_int ("SELECT count (*) FROM role_users"
@@ -459,7 +625,7 @@ acl_user_is_user (const char *uuid)
                  " AND \"user\" = (SELECT id FROM users WHERE uuid = '%s');",
                  quoted_uuid);
   g_free (quoted_uuid);
-  return ret;
+  return acl_cache_insert (key, ret);
 }
 
 /* TODO This is only predicatable for unique fields like "id".  If the field
@@ -981,6 +1147,193 @@ acl_user_has_access_uuid (const char *type, const char *uuid,
   return ret;
 }
 
+/**
+ * @brief Types for which acl_where_owned precomputes the accessible sets.
+ */
+static gchar **acl_precompute_types = NULL;
+
+/**
+ * @brief Set the types for which ownership clauses use precomputed sets.
+ *
+ * For these types the ownership clause matches against the owners and
+ * resources that the user can access, computed once when the clause is
+ * built, instead of checking the permissions for every row.
+ *
+ * @param[in]  types  Comma separated list of types, or NULL for none.
+ */
+void
+set_acl_precompute_types (const gchar *types)
+{
+  g_strfreev (acl_precompute_types);
+  acl_precompute_types = NULL;
+  if (types && strlen (types))
+    acl_precompute_types = g_strsplit (types, ",", 0);
+}
+
+/**
+ * @brief Check whether ownership clauses of a type use precomputed sets.
+ *
+ * @param[in]  type  Type of resource.
+ *
+ * @return 1 if precomputed, else 0.
+ */
+static int
+acl_precompute_type (const char *type)
+{
+  return acl_precompute_types && strv_case_eq (acl_precompute_types, type);
+}
+
+/**
+ * @brief Get the ids in an SQL selection as an SQL array literal.
+ *
+ * @param[in]  format  Format string for SELECT of one id column.
+ * @param[in]  ...     Arguments for format string.
+ *
+ * @return Freshly allocated array literal, like '{1,2}'::integer[].
+ */
+static gchar *
+acl_ids_array (const char *format, ...)
+{
+  va_list args;
+  gchar *select, *ids, *ret;
+
+  va_start (args, format);
+  select = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  ids = sql_string ("SELECT coalesce (array_agg (DISTINCT id)::text, '{}')"
+                    " FROM (%s) AS ids;",
+                    select);
+  g_free (select);
+
+  ret = g_strdup_printf ("'%s'::integer[]", ids ? ids : "{}");
+  g_free (ids);
+  return ret;
+}
+
+/**
+ * @brief Generate the ownership clause from precomputed sets.
+ *
+ * Only for the WITH case of acl_where_owned_user, with the same meaning.
+ *
+ * @param[in]  user_sql        SQL for getting user.
+ * @param[in]  type            Type of resource.
+ * @param[in]  get             GET data.
+ * @param[in]  permission_or   Permission names clause, or NULL to skip the
+ *                             permission checks.
+ *
+ * @return Newly allocated owned clause.
+ */
+static gchar *
+acl_where_owned_precomputed (const char *user_sql, const char *type,
+                             const get_data_t *get,
+                             const char *permission_or)
+{
+  gchar *subject, *owners, *resources, *tasks, *clause;
+  int table_trash;
+
+  subject = g_strdup_printf ("SELECT * FROM permissions"
+                             " WHERE subject_location"
+                             "       = " G_STRINGIFY (LOCATION_TABLE)
+                             " AND ((subject_type = 'user'"
+                             "       AND subject = (%s))"
+                             "      OR (subject_type = 'group'"
+                             "          AND subject"
+                             "              IN (SELECT DISTINCT \"group\""
+                             "                  FROM group_users"
+                             "                  WHERE \"user\" = (%s)))"
+                             "      OR (subject_type = 'role'"
+                             "          AND subject"
+                             "              IN (SELECT DISTINCT role"
+                             "                  FROM role_users"
+                             "                  WHERE \"user\" = (%s))))",
+                             user_sql,
+                             user_sql,
+                             user_sql);
+
+  if (sql_int ("SELECT EXISTS (SELECT * FROM (%s) AS subject"
+               "               WHERE name = 'Super'"
+               "               AND resource = 0);",
+               subject))
+    {
+      /* Super on everyone. */
+      g_free (subject);
+      return g_strdup (" (t ())");
+    }
+
+  /* The user and the users the user has super permission on. */
+  owners = acl_ids_array ("SELECT (%s) AS id"
+                          " UNION"
+                          " SELECT resource FROM (%s) AS subject"
+                          " WHERE name = 'Super'"
+                          " AND resource_type = 'user'"
+                          " UNION"
+                          " SELECT \"user\" FROM role_users"
+                          " WHERE role IN (SELECT resource"
+                          "                FROM (%s) AS subject"
+                          "                WHERE name = 'Super'"
+                          "                AND resource_type = 'role')"
+                          " UNION"
+                          " SELECT \"user\" FROM group_users"
+                          " WHERE \"group\" IN (SELECT resource"
+                          "                   FROM (%s) AS subject"
+                          "                   WHERE name = 'Super'"
+                          "                   AND resource_type = 'group')",
+                          user_sql,
+                          subject,
+                          subject,
+                          subject);
+
+  resources = NULL;
+  tasks = NULL;
+  if (permission_or)
+    {
+      resources = acl_ids_array ("SELECT resource AS id FROM (%s) AS subject"
+                                 " WHERE resource_type = '%s'"
+                                 " AND resource_location = %i"
+                                 " AND (%s)",
+                                 subject,
+                                 type,
+                                 get->trash ? LOCATION_TRASH : LOCATION_TABLE,
+                                 permission_or);
+      if ((strcmp (type, "report") == 0) || (strcmp (type, "result") == 0))
+        tasks = acl_ids_array ("SELECT resource AS id FROM (%s) AS subject"
+                               " WHERE resource_type = 'task'"
+                               " AND (%s)",
+                               subject,
+                               permission_or);
+    }
+  g_free (subject);
+
+  table_trash = get->trash && strcasecmp (type, "task");
+  clause = g_strdup_printf (/* Either the user is the owner, or the user
+                             * has super permission on the owner. */
+                            " ((%ss%s.owner = ANY (%s))"
+                            /* Or the user has permission on the resource. */
+                            "  %s%ss%s%s%s%s"
+                            /* Or on the task of the report or result. */
+                            "  %s%ss%s%s%s%s)",
+                            type,
+                            table_trash ? "_trash" : "",
+                            owners,
+                            resources ? "OR " : "",
+                            resources ? type : "",
+                            resources && table_trash ? "_trash" : "",
+                            resources ? ".id = ANY (" : "",
+                            resources ? resources : "",
+                            resources ? ")" : "",
+                            tasks ? "OR " : "",
+                            tasks ? type : "",
+                            tasks && get->trash ? "_trash" : "",
+                            tasks ? ".task = ANY (" : "",
+                            tasks ? tasks : "",
+                            tasks ? ")" : "");
+  g_free (owners);
+  g_free (resources);
+  g_free (tasks);
+  return clause;
+}
+
 /**
  * @brief Generate the ownership part of an SQL WHERE clause for a given user.
  *
@@ -1106,6 +1459,13 @@ acl_where_owned_user (const char *user_id, const char *user_sql,
   if (resource || (user_id == NULL))
     owned_clause
      = g_strdup (" (t ())");
+  else if (with
+           && with_prefix == NULL
+           && strcmp (type, "permission")
+           && acl_precompute_type (type))
+    owned_clause = acl_where_owned_precomputed (user_sql, type, get,
+                                                index ? permission_or->str
+                                                      : NULL);
   else if (with)
     {
       gchar *permission_clause;
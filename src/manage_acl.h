@@ -125,6 +125,18 @@
   "  OR (owner = (SELECT users.id FROM users"                  \
   "               WHERE users.uuid = '%s')))"
 
+void
+set_acl_precompute_types (const gchar *);
+
+void
+acl_cache_start ();
+
+void
+acl_cache_stop ();
+
+void
+acl_cache_clear ();
+
 command_t *
 acl_commands (gchar **);
 
@@ -135,7 +135,7 @@ create_feed_config_permissions (const gchar *config_id)
  * @param[in]  config  Existing config.
  * @param[in]  path    Full path to config XML.
  *
- * @return 0 success, -1 error.
+ * @return 0 success, 2 skipped for now, -1 error.
  */
 static int
 update_config_from_file (config_t config, const gchar *path)
@@ -165,7 +165,7 @@ update_config_from_file (config_t config, const gchar *path)
         free_entity (entity);
         g_warning ("%s: preference does not exist yet, skipping %s for now",
                    __func__, path);
-        return 0;
+        return 2;
       default:
         free_entity (entity);
         g_warning ("%s: Failed to parse entity", __func__);
@@ -336,10 +336,12 @@ sync_config_with_feed (const gchar *path)
 
       g_debug ("%s: considering %s for update", __func__, path);
 
-      if (config_updated_in_feed (config, full_path))
+      if (config_updated_in_feed (config, full_path)
+          && feed_file_changed (full_path))
         {
           g_debug ("%s: updating %s", __func__, path);
-          update_config_from_file (config, full_path);
+          if (update_config_from_file (config, full_path) == 0)
+            feed_file_record (full_path);
         }
 
       g_free (full_path);
@@ -357,7 +359,8 @@ sync_config_with_feed (const gchar *path)
 
   g_debug ("%s: adding %s", __func__, path);
 
-  create_config_from_file (full_path);
+  if (create_config_from_file (full_path) == 0)
+    feed_file_record (full_path);
 
   g_free (full_path);
 }
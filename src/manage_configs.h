@@ -72,6 +72,9 @@ config_type (config_t);
 char *
 config_nvt_timeout (config_t, const char *);
 
+void
+init_config_nvt_timeout_iterator (iterator_t *, config_t, GPtrArray *);
+
 int
 config_predefined_uuid (const gchar *);
 
@@ -43,6 +43,7 @@ get_data_reset (get_data_t *data)
   free (data->filter_replacement);
   free (data->subtype);
   free (data->type);
+  g_free (data->keyset_last);
   if (data->extra_params)
     g_hash_table_destroy (data->extra_params);
 
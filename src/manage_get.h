@@ -46,6 +46,8 @@ typedef struct
   int ignore_pagination; ///< Whether to ignore the pagination (first and max).
   int minimal;         ///< Whether to respond with minimal information.
   GHashTable *extra_params; ///< Hashtable of type-specific extra parameters.
+  int keyset;          ///< Keyset pagination: 0 unknown, 1 off, 2 on.
+  gchar *keyset_last;  ///< Token of last resource, for keyset pagination.
 } get_data_t;
 
 void
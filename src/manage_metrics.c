@@ -0,0 +1,214 @@
+/* Copyright (C) 2020 Greenbone Networks GmbH
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file manage_metrics.c
+ * @brief Module for Greenbone Vulnerability Manager: Manager metrics.
+ *
+ * Counters and gauges that any gvmd process can update, kept in a small
+ * file mapping in the run directory.  The mapping is shared with every
+ * process forked after metrics_init, and with separate gvmd processes like
+ * the ones that run --optimize, without going through the database, so
+ * that updates are cheap and do not depend on transactions.
+ */
+
+#include "manage_metrics.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#undef G_LOG_DOMAIN
+/**
+ * @brief GLib log domain.
+ */
+#define G_LOG_DOMAIN "md manage"
+
+/**
+ * @brief Description of a metric, for the text exposition format.
+ */
+typedef struct
+{
+  const char *name;     ///< Metric name, with labels.
+  const char *family;   ///< Metric family, for HELP and TYPE, or NULL.
+  const char *type;     ///< "counter" or "gauge".
+  const char *help;     ///< Help text of the family.
+  int microseconds;     ///< Whether the value is a time in microseconds.
+} metric_info_t;
+
+/**
+ * @brief Descriptions of the metrics, in the order of metric_t.
+ *
+ * Metrics of the same family follow each other, with the family given on
+ * the first one only.
+ */
+static const metric_info_t metric_info[METRIC_COUNT] =
+{
+  { "gvmd_gmp_connections", "gvmd_gmp_connections", "gauge",
+    "GMP connections being served.", 0 },
+  { "gvmd_osp_polls_total", "gvmd_osp_polls_total", "counter",
+    "OSP scan polls.", 0 },
+  { "gvmd_osp_poll_seconds_total", "gvmd_osp_poll_seconds_total", "counter",
+    "Time spent in OSP scan polls.", 1 },
+  { "gvmd_results_ingested_total", "gvmd_results_ingested_total", "counter",
+    "Results added from OSP scan reports.", 0 },
+  { "gvmd_feed_sync_seconds{feed=\"nvt\"}", "gvmd_feed_sync_seconds",
+    "gauge", "Duration of the last sync of each feed.", 1 },
+  { "gvmd_feed_sync_seconds{feed=\"scap\"}", NULL, "gauge", NULL, 1 },
+  { "gvmd_feed_sync_seconds{feed=\"cert\"}", NULL, "gauge", NULL, 1 },
+  { "gvmd_feed_sync_seconds{feed=\"data\"}", NULL, "gauge", NULL, 1 },
+  { "gvmd_report_cache_reports_done", "gvmd_report_cache_reports_done",
+    "gauge", "Reports counted by the last report cache rebuild.", 0 },
+  { "gvmd_report_cache_reports_total", "gvmd_report_cache_reports_total",
+    "gauge", "Reports to count in the last report cache rebuild.", 0 }
+};
+
+/**
+ * @brief Shared metric values, or NULL.
+ */
+static gint64 *metrics = NULL;
+
+/**
+ * @brief Map the shared metrics.
+ *
+ * Falls back to a mapping that is only shared with child processes if the
+ * file in the run directory is not available.
+ */
+void
+metrics_init ()
+{
+  gchar *path;
+  size_t size;
+  void *mapping;
+  int fd;
+
+  if (metrics)
+    return;
+
+  size = METRIC_COUNT * sizeof (gint64);
+  mapping = MAP_FAILED;
+  path = g_build_filename (GVM_RUN_DIR, "gvmd-metrics", NULL);
+  fd = open (path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+  if (fd == -1)
+    g_debug ("%s: failed to open %s: %s", __func__, path, strerror (errno));
+  else
+    {
+      struct stat state;
+
+      if (fstat (fd, &state) == 0
+          && (state.st_size >= (off_t) size
+              || ftruncate (fd, size) == 0))
+        mapping = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd, 0);
+      close (fd);
+    }
+  g_free (path);
+
+  if (mapping == MAP_FAILED)
+    mapping = mmap (NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED)
+    {
+      g_warning ("%s: mmap failed: %s", __func__, strerror (errno));
+      return;
+    }
+  metrics = mapping;
+}
+
+/**
+ * @brief Reset all metrics to 0.
+ *
+ * Called when the daemon starts, so that gauges left by processes that
+ * died without updating them start from scratch.
+ */
+void
+metrics_reset ()
+{
+  int index;
+
+  if (metrics == NULL)
+    return;
+  for (index = 0; index < METRIC_COUNT; index++)
+    __atomic_store_n (&metrics[index], 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Add to a metric.
+ *
+ * @param[in]  metric  Metric.
+ * @param[in]  value   Value to add, negative to subtract.
+ */
+void
+metrics_add (metric_t metric, gint64 value)
+{
+  if (metrics)
+    __atomic_add_fetch (&metrics[metric], value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Set a metric.
+ *
+ * @param[in]  metric  Metric.
+ * @param[in]  value   New value.
+ */
+void
+metrics_set (metric_t metric, gint64 value)
+{
+  if (metrics)
+    __atomic_store_n (&metrics[metric], value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Append the metrics in the Prometheus text exposition format.
+ *
+ * @param[in]  buffer  Buffer.
+ */
+void
+metrics_append_text (GString *buffer)
+{
+  int index;
+
+  if (metrics == NULL)
+    return;
+
+  for (index = 0; index < METRIC_COUNT; index++)
+    {
+      const metric_info_t *info;
+      gint64 value;
+
+      info = &metric_info[index];
+      value = __atomic_load_n (&metrics[index], __ATOMIC_RELAXED);
+      if (info->family)
+        g_string_append_printf (buffer,
+                                "# HELP %s %s\n# TYPE %s %s\n",
+                                info->family, info->help,
+                                info->family, info->type);
+      if (info->microseconds)
+        g_string_append_printf (buffer, "%s %" G_GINT64_FORMAT ".%06"
+                                G_GINT64_FORMAT "\n",
+                                info->name,
+                                value / G_USEC_PER_SEC,
+                                value % G_USEC_PER_SEC);
+      else
+        g_string_append_printf (buffer, "%s %" G_GINT64_FORMAT "\n",
+                                info->name, value);
+    }
+}
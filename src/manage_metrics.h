@@ -0,0 +1,64 @@
+/* Copyright (C) 2020 Greenbone Networks GmbH
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @file manage_metrics.h
+ * @brief Headers for Greenbone Vulnerability Manager: Manager metrics.
+ */
+
+#ifndef _GVMD_MANAGE_METRICS_H
+#define _GVMD_MANAGE_METRICS_H
+
+#include <glib.h>
+
+/**
+ * @brief Metrics shared by all gvmd processes.
+ *
+ * Times are kept in microseconds.
+ */
+typedef enum
+{
+  METRIC_GMP_CONNECTIONS,     ///< GMP connections being served.
+  METRIC_OSP_POLLS,           ///< OSP scans polled.
+  METRIC_OSP_POLL_TIME,       ///< Time spent polling OSP scans.
+  METRIC_RESULTS_INGESTED,    ///< Results added from OSP reports.
+  METRIC_FEED_SYNC_TIME_NVT,  ///< Duration of the last NVT sync.
+  METRIC_FEED_SYNC_TIME_SCAP, ///< Duration of the last SCAP sync.
+  METRIC_FEED_SYNC_TIME_CERT, ///< Duration of the last CERT sync.
+  METRIC_FEED_SYNC_TIME_DATA, ///< Duration of the last data objects sync.
+  METRIC_REPORT_CACHE_DONE,   ///< Reports counted by a report cache rebuild.
+  METRIC_REPORT_CACHE_TOTAL,  ///< Reports to count in a report cache rebuild.
+  METRIC_COUNT                ///< Number of metrics.  Must be last.
+} metric_t;
+
+void
+metrics_init ();
+
+void
+metrics_reset ();
+
+void
+metrics_add (metric_t, gint64);
+
+void
+metrics_set (metric_t, gint64);
+
+void
+metrics_append_text (GString *);
+
+#endif /* not _GVMD_MANAGE_METRICS_H */
@@ -50,6 +50,12 @@
  *    for example update_all_config_caches, as these may also change in later
  *    versions of the Manager.
  *
+ *  - Updates of every row of a big table, like results, should rather use
+ *    migrate_update_batched.  The function may then commit the schema
+ *    changes on their own, as long as they can be repeated after an
+ *    interruption, and must clear the checkpoints with
+ *    migrate_checkpoint_clear in the transaction that sets the new version.
+ *
  *  - Remember to ensure that tables exist in the migrator before the migrator
  *    modifies them.  If a migrator modifies a table then the table must either
  *    have existed in database version 0 (listed below), or some earlier
@@ -180,6 +186,109 @@ move (const gchar *table, const gchar *old, const gchar *new)
   sql ("ALTER TABLE %s RENAME COLUMN %s TO %s;", table, old, new);
 }
 
+/**
+ * @brief Number of rows that a batched migration step updates per
+ *        transaction.
+ */
+#define MIGRATE_BATCH_SIZE 50000
+
+/**
+ * @brief Get the meta name of the checkpoint of a batched migration step.
+ *
+ * @param[in]  step  Name of the step.
+ *
+ * @return Freshly allocated meta name.
+ */
+static gchar *
+migrate_checkpoint_name (const gchar *step)
+{
+  return g_strdup_printf ("migrate_checkpoint_%s", step);
+}
+
+/**
+ * @brief Update the rows of a table in batches.
+ *
+ * Each batch of MIGRATE_BATCH_SIZE ids is updated in its own transaction,
+ * together with a checkpoint in meta.  If the migration is interrupted
+ * then running it again continues after the last checkpoint.  The
+ * checkpoint is removed by migrate_checkpoint_clear, which must be called
+ * in the transaction that sets the new database version.
+ *
+ * The caller must not be in a transaction.
+ *
+ * @param[in]  step   Unique name of the step, for the checkpoint.
+ * @param[in]  table  Table to update, which must have an id column.
+ * @param[in]  set    SET clause of the update.
+ * @param[in]  where  Condition for rows to update, or NULL for all rows.
+ */
+static void
+migrate_update_batched (const gchar *step, const gchar *table,
+                        const gchar *set, const gchar *where)
+{
+  resource_t start, max_id;
+  gchar *checkpoint;
+  int last_percent;
+
+  checkpoint = migrate_checkpoint_name (step);
+
+  start = 0;
+  sql_int64 (&start,
+             "SELECT coalesce (max (value::bigint), 0) FROM meta"
+             " WHERE name = '%s';",
+             checkpoint);
+  max_id = 0;
+  sql_int64 (&max_id, "SELECT coalesce (max (id), 0) FROM %s;", table);
+
+  if (start)
+    g_info ("   %s: resuming after id %llu", step, start);
+
+  last_percent = -1;
+  while (start < max_id)
+    {
+      resource_t end;
+      int percent;
+
+      end = MIN (start + MIGRATE_BATCH_SIZE, max_id);
+
+      sql_begin_immediate ();
+      sql ("UPDATE %s SET %s WHERE id > %llu AND id <= %llu%s%s%s;",
+           table, set, start, end,
+           where ? " AND (" : "",
+           where ? where : "",
+           where ? ")" : "");
+      sql ("DELETE FROM meta WHERE name = '%s';", checkpoint);
+      sql ("INSERT INTO meta (name, value) VALUES ('%s', '%llu');",
+           checkpoint, end);
+      sql_commit ();
+
+      start = end;
+
+      percent = (int) ((start * 100) / max_id);
+      if (percent / 10 != last_percent / 10)
+        {
+          g_info ("   %s: %llu of %llu (%i%%)", step, start, max_id, percent);
+          last_percent = percent;
+        }
+    }
+
+  g_free (checkpoint);
+}
+
+/**
+ * @brief Remove the checkpoint of a batched migration step.
+ *
+ * @param[in]  step  Name of the step.
+ */
+static void
+migrate_checkpoint_clear (const gchar *step)
+{
+  gchar *checkpoint;
+
+  checkpoint = migrate_checkpoint_name (step);
+  sql ("DELETE FROM meta WHERE name = '%s';", checkpoint);
+  g_free (checkpoint);
+}
+
 /**
  * @brief Migrate the database from version 204 to version 205.
  *
@@ -2172,13 +2281,30 @@ migrate_231_to_232 ()
 
   /* Update the database. */
 
-  /* Add path field to results and results_trash. */
-  sql ("ALTER TABLE results ADD COLUMN path text;");
-  sql ("ALTER TABLE results_trash ADD COLUMN path text;");
+  /* Add path field to results and results_trash.  This is committed on its
+   * own so that the updates below can run in batches, so it must be safe to
+   * repeat when resuming an interrupted migration. */
+  sql ("ALTER TABLE results ADD COLUMN IF NOT EXISTS path text;");
+  sql ("ALTER TABLE results_trash ADD COLUMN IF NOT EXISTS path text;");
+
+  sql_commit ();
 
   /* Set path to empty string */
-  sql ("UPDATE results SET path = '';");
-  sql ("UPDATE results_trash SET path = '';");
+  migrate_update_batched ("231_to_232_results", "results", "path = ''",
+                          "path IS NULL");
+  migrate_update_batched ("231_to_232_results_trash", "results_trash",
+                          "path = ''", "path IS NULL");
+
+  sql_begin_immediate ();
+
+  if (manage_db_version () != 231)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  migrate_checkpoint_clear ("231_to_232_results");
+  migrate_checkpoint_clear ("231_to_232_results_trash");
 
   /* Set the database version to 231. */
 
@@ -2409,12 +2535,29 @@ migrate_235_to_236 ()
       return -1;
     }
 
+  sql_commit ();
+
   /* Update the database. */
 
   /* Replace any result type "Debug Message" by "Error Message". */
 
-  sql ("UPDATE results SET type = 'Error Message' WHERE type = 'Debug Message';");
-  sql ("UPDATE results_trash SET type = 'Error Message' WHERE type = 'Debug Message';");
+  migrate_update_batched ("235_to_236_results", "results",
+                          "type = 'Error Message'",
+                          "type = 'Debug Message'");
+  migrate_update_batched ("235_to_236_results_trash", "results_trash",
+                          "type = 'Error Message'",
+                          "type = 'Debug Message'");
+
+  sql_begin_immediate ();
+
+  if (manage_db_version () != 235)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  migrate_checkpoint_clear ("235_to_236_results");
+  migrate_checkpoint_clear ("235_to_236_results_trash");
 
   /* Set the database version to 236. */
 
@@ -2745,6 +2888,45 @@ migrate_244_to_245 ()
   return 0;
 }
 
+/**
+ * @brief Migrate the database from version 245 to version 246.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_245_to_246 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 245. */
+
+  if (manage_db_version () != 245)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Replace the B-tree indexes on the result UUIDs with hash indexes.  An
+   * unpartitioned results table has the index of the UNIQUE constraint, a
+   * partitioned one a plain index. */
+
+  sql ("ALTER TABLE results DROP CONSTRAINT IF EXISTS results_uuid_key;");
+  sql ("DROP INDEX IF EXISTS results_by_uuid;");
+  sql ("ALTER TABLE results_trash"
+       " DROP CONSTRAINT IF EXISTS results_trash_uuid_key;");
+  manage_create_result_uuid_indexes ();
+
+  /* Set the database version to 246. */
+
+  set_db_version (246);
+
+  sql_commit ();
+
+  return 0;
+}
+
 
 #undef UPDATE_DASHBOARD_SETTINGS
 
@@ -2797,6 +2979,7 @@ static migrator_t database_migrators[] = {
   {243, migrate_242_to_243},
   {244, migrate_243_to_244},
   {245, migrate_244_to_245},
+  {246, migrate_245_to_246},
   /* End marker. */
   {-1, NULL}};
 
@@ -2919,7 +3102,10 @@ manage_migrate (GSList *log_config, const db_conn_info_t *database)
               return -1;
             }
 
-          g_info ("   Migrating to %i", migrators->version);
+          g_info ("   Migrating to %i (%i of %i)",
+                  migrators->version,
+                  migrators->version - old_version,
+                  new_version - old_version);
 
           if (migrators->function ())
             {
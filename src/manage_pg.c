@@ -48,6 +48,9 @@
 int
 check_db_extensions ();
 
+static gboolean
+db_extension_available (const char *);
+
 
 /* Session. */
 
@@ -59,10 +62,15 @@ check_db_extensions ();
 void
 manage_session_init (const char *uuid)
 {
-  sql ("SET SESSION \"gvmd.user.id\" = %llu;",
-       sql_int64_0 ("SELECT id FROM users WHERE uuid = '%s';",
-                    uuid));
-  sql ("SET SESSION \"gvmd.tz_override\" = '';");
+  gchar *user_id;
+
+  user_id = g_strdup_printf ("%llu",
+                             sql_int64_0 ("SELECT id FROM users"
+                                          " WHERE uuid = '%s';",
+                                          uuid));
+  sql_session_set ("gvmd.user.id", user_id);
+  g_free (user_id);
+  sql_session_set ("gvmd.tz_override", "");
 }
 
 /**
@@ -73,7 +81,7 @@ manage_session_init (const char *uuid)
 void
 manage_session_set_timezone (const char *zone)
 {
-  sql ("SET SESSION TIME ZONE '%s';", zone);
+  sql_session_set ("TimeZone", zone);
   return;
 }
 
@@ -182,6 +190,189 @@ sql_rename_column (const char *old_table, const char *new_table,
  "    LIMIT 1),"                                            \
  "   " severity_sql ")"
 
+/**
+ * @brief Check whether the task_summaries table exists.
+ *
+ * @return 1 if it exists, else 0.
+ */
+static int
+task_summaries_exist ()
+{
+  return sql_int ("SELECT EXISTS (SELECT * FROM information_schema.tables"
+                  "               WHERE table_catalog = '%s'"
+                  "               AND table_schema = 'public'"
+                  "               AND table_name = 'task_summaries')"
+                  " ::integer;",
+                  sql_database ());
+}
+
+/**
+ * @brief Create the functions that read the per-task report summaries.
+ *
+ * These replace the versions that sort all reports of the task.
+ */
+static void
+create_task_summary_functions ()
+{
+  sql ("CREATE OR REPLACE FUNCTION task_summary_update (integer)"
+       " RETURNS void AS $$"
+       /* Recalculate the report summary of a task. */
+       " BEGIN"
+       "   IF NOT EXISTS (SELECT * FROM tasks WHERE id = $1) THEN"
+       "     RETURN;"
+       "   END IF;"
+       "   INSERT INTO task_summaries"
+       "    (task, report_count, finished_report_count, first_report,"
+       "     last_report, second_last_report)"
+       "   SELECT $1,"
+       "          (SELECT count (*) FROM reports WHERE task = $1),"
+       "          (SELECT count (*) FROM reports"
+       "           WHERE task = $1 AND scan_run_status = %u),"
+       "          (SELECT id FROM reports"
+       "           WHERE task = $1 AND scan_run_status = %u"
+       "           ORDER BY creation_time ASC LIMIT 1),"
+       "          (SELECT id FROM reports"
+       "           WHERE task = $1 AND scan_run_status = %u"
+       "           ORDER BY creation_time DESC LIMIT 1),"
+       "          (SELECT id FROM reports"
+       "           WHERE task = $1 AND scan_run_status = %u"
+       "           ORDER BY creation_time DESC LIMIT 1 OFFSET 1)"
+       "   ON CONFLICT (task) DO UPDATE"
+       "   SET report_count = EXCLUDED.report_count,"
+       "       finished_report_count = EXCLUDED.finished_report_count,"
+       "       first_report = EXCLUDED.first_report,"
+       "       last_report = EXCLUDED.last_report,"
+       "       second_last_report = EXCLUDED.second_last_report;"
+       " END;"
+       "$$ LANGUAGE plpgsql;",
+       TASK_STATUS_DONE,
+       TASK_STATUS_DONE,
+       TASK_STATUS_DONE,
+       TASK_STATUS_DONE);
+
+  sql ("CREATE OR REPLACE FUNCTION reports_task_summary ()"
+       " RETURNS TRIGGER AS $$"
+       /* Keep task_summaries in step with the reports of each task. */
+       " BEGIN"
+       "   IF TG_OP != 'INSERT' AND old.task IS NOT NULL THEN"
+       "     PERFORM task_summary_update (old.task);"
+       "   END IF;"
+       "   IF TG_OP != 'DELETE' AND new.task IS NOT NULL"
+       "      AND (TG_OP = 'INSERT' OR new.task IS DISTINCT FROM old.task)"
+       "   THEN"
+       "     PERFORM task_summary_update (new.task);"
+       "   END IF;"
+       "   RETURN NULL;"
+       " END;"
+       "$$ LANGUAGE plpgsql;");
+
+  sql ("CREATE OR REPLACE FUNCTION task_last_report (integer)"
+       " RETURNS integer AS $$"
+       /* Get the report from the most recently completed invocation of task. */
+       "  SELECT last_report FROM task_summaries WHERE task = $1;"
+       "$$ LANGUAGE SQL STABLE;");
+
+  sql ("CREATE OR REPLACE FUNCTION task_second_last_report (integer)"
+       " RETURNS integer AS $$"
+       /* Get report from second most recently completed invocation of task. */
+       "  SELECT second_last_report FROM task_summaries WHERE task = $1;"
+       "$$ LANGUAGE SQL STABLE;");
+}
+
+/**
+ * @brief Create the functions that maintain the latest state of host assets.
+ */
+static void
+create_host_latest_functions ()
+{
+  sql ("CREATE OR REPLACE FUNCTION host_latest_update (integer)"
+       " RETURNS void AS $$"
+       /* Recalculate the latest report host, severity and OS of a host. */
+       " BEGIN"
+       "   IF NOT EXISTS (SELECT * FROM hosts WHERE id = $1) THEN"
+       "     RETURN;"
+       "   END IF;"
+       "   INSERT INTO host_latest"
+       "    (host, report_host, severity, best_os_cpe, best_os_text)"
+       "   SELECT $1,"
+       "          (SELECT max (report_hosts.id)"
+       "           FROM host_identifiers, reports, report_hosts"
+       "           WHERE host_identifiers.host = $1"
+       "           AND host_identifiers.name = 'ip'"
+       "           AND reports.uuid = host_identifiers.source_id"
+       "           AND report_hosts.report = reports.id"
+       "           AND report_hosts.host = host_identifiers.value"
+       "           AND report_hosts.end_time > 0"
+       "           AND NOT EXISTS (SELECT * FROM report_host_details"
+       "                           WHERE report_host = report_hosts.id"
+       "                           AND name = 'CVE Scan')),"
+       "          (SELECT severity FROM host_max_severities"
+       "           WHERE host = $1"
+       "           ORDER BY creation_time DESC LIMIT 1),"
+       "          (SELECT value FROM host_details"
+       "           WHERE host = $1 AND name = 'best_os_cpe'"
+       "           ORDER BY id DESC LIMIT 1),"
+       "          (SELECT value FROM host_details"
+       "           WHERE host = $1 AND name = 'best_os_text'"
+       "           ORDER BY id DESC LIMIT 1)"
+       "   ON CONFLICT (host) DO UPDATE"
+       "   SET report_host = EXCLUDED.report_host,"
+       "       severity = EXCLUDED.severity,"
+       "       best_os_cpe = EXCLUDED.best_os_cpe,"
+       "       best_os_text = EXCLUDED.best_os_text;"
+       " END;"
+       "$$ LANGUAGE plpgsql;");
+
+  sql ("CREATE OR REPLACE FUNCTION host_latest_trigger ()"
+       " RETURNS TRIGGER AS $$"
+       /* Keep host_latest in step with the severities and details. */
+       " BEGIN"
+       "   IF TG_OP = 'DELETE' THEN"
+       "     PERFORM host_latest_update (old.host);"
+       "   ELSE"
+       "     PERFORM host_latest_update (new.host);"
+       "   END IF;"
+       "   RETURN NULL;"
+       " END;"
+       "$$ LANGUAGE plpgsql;");
+}
+
+/**
+ * @brief Check whether the nvt_current_severities table exists.
+ *
+ * @return 1 if it exists, else 0.
+ */
+static int
+nvt_current_severities_exist ()
+{
+  return sql_int ("SELECT EXISTS (SELECT * FROM information_schema.tables"
+                  "               WHERE table_catalog = '%s'"
+                  "               AND table_schema = 'public'"
+                  "               AND table_name = 'nvt_current_severities')"
+                  " ::integer;",
+                  sql_database ());
+}
+
+/**
+ * @brief Create the current_severity function that reads the NVT mapping.
+ *
+ * This replaces the version that casts the cvss_base of the NVT per row.
+ */
+static void
+create_current_severity_function ()
+{
+  sql ("CREATE OR REPLACE FUNCTION current_severity (real, text)"
+       " RETURNS double precision AS $$"
+       "  SELECT coalesce ((CASE WHEN $1 > " G_STRINGIFY (SEVERITY_LOG)
+       "                    THEN (SELECT severity"
+       "                          FROM nvt_current_severities"
+       "                          WHERE nvt = $2)"
+       "                    ELSE $1"
+       "                    END),"
+       "                   $1);"
+       "$$ LANGUAGE SQL STABLE;");
+}
+
 /**
  * @brief Create functions.
  *
@@ -203,7 +394,7 @@ manage_create_sql_functions ()
   
   /* Operators */
 
-  sql ("SET ROLE \"%s\";", DB_SUPERUSER_ROLE);
+  sql_session_set ("role", DB_SUPERUSER_ROLE);
 
   if (sql_int ("SELECT count(*) FROM pg_operator"
                " WHERE oprname = '?~#';")
@@ -213,7 +404,7 @@ manage_create_sql_functions ()
           " (PROCEDURE = regexp, LEFTARG = text, RIGHTARG = text);");
     }
 
-  sql ("RESET role;");
+  sql_session_set ("role", "none");
 
   /* Functions in pl/pgsql. */
 
@@ -347,6 +538,23 @@ manage_create_sql_functions ()
        " END;"
        "$$ language 'plpgsql';");
 
+  /* Get the planner's estimate of the number of rows of a query, which is
+   * much cheaper than counting the rows. */
+  sql ("CREATE OR REPLACE FUNCTION count_estimate (query text)"
+       " RETURNS integer AS $$"
+       " DECLARE"
+       "   plan record;"
+       "   estimate integer;"
+       " BEGIN"
+       "   FOR plan IN EXECUTE 'EXPLAIN ' || query LOOP"
+       "     estimate := substring (plan.\"QUERY PLAN\""
+       "                            FROM ' rows=([[:digit:]]+)');"
+       "     EXIT WHEN estimate IS NOT NULL;"
+       "   END LOOP;"
+       "   RETURN coalesce (estimate, 0);"
+       " END;"
+       " $$ LANGUAGE plpgsql VOLATILE STRICT;");
+
   if (sql_int ("SELECT EXISTS (SELECT * FROM information_schema.tables"
                "               WHERE table_catalog = '%s'"
                "               AND table_schema = 'public'"
@@ -939,17 +1147,20 @@ manage_create_sql_functions ()
            "  ORDER BY coalesce (owner, 0) DESC LIMIT 1;"
            "$$ LANGUAGE SQL;");
 
-      sql ("CREATE OR REPLACE FUNCTION current_severity (real, text)"
-           " RETURNS double precision AS $$"
-           "  SELECT coalesce ((CASE WHEN $1 > " G_STRINGIFY (SEVERITY_LOG)
-           "                    THEN (SELECT CAST (cvss_base"
-           "                                       AS double precision)"
-           "                          FROM nvts"
-           "                          WHERE nvts.oid = $2)"
-           "                    ELSE $1"
-           "                    END),"
-           "                   $1);"
-           "$$ LANGUAGE SQL;");
+      if (nvt_current_severities_exist ())
+        create_current_severity_function ();
+      else
+        sql ("CREATE OR REPLACE FUNCTION current_severity (real, text)"
+             " RETURNS double precision AS $$"
+             "  SELECT coalesce ((CASE WHEN $1 > " G_STRINGIFY (SEVERITY_LOG)
+             "                    THEN (SELECT CAST (cvss_base"
+             "                                       AS double precision)"
+             "                          FROM nvts"
+             "                          WHERE nvts.oid = $2)"
+             "                    ELSE $1"
+             "                    END),"
+             "                   $1);"
+             "$$ LANGUAGE SQL;");
 
       /* result_nvt column (in OVERRIDES_SQL) was added in version 189 */
       if (current_db_version >= 189)
@@ -1113,8 +1324,10 @@ manage_create_sql_functions ()
              "         END;"
              "$$ LANGUAGE SQL;");
 
+      if (task_summaries_exist ())
+        create_task_summary_functions ();
       /* column date in table reports was renamed to creation_time in version 245 */
-      if (current_db_version >= 245)
+      else if (current_db_version >= 245)
         {
           sql ("CREATE OR REPLACE FUNCTION task_last_report (integer)"
                " RETURNS integer AS $$"
@@ -1123,11 +1336,7 @@ manage_create_sql_functions ()
                "  ORDER BY creation_time DESC LIMIT 1;"
                "$$ LANGUAGE SQL;",
                TASK_STATUS_DONE);
-        }
 
-      /* column date in table reports was renamed to creation_time in version 245 */
-      if (current_db_version >= 245)
-        {
           sql ("CREATE OR REPLACE FUNCTION task_second_last_report (integer)"
                " RETURNS integer AS $$"
                /* Get report from second most recently completed invocation of task. */
@@ -1152,14 +1361,9 @@ manage_create_sql_functions ()
                "               FROM tasks WHERE id = $1)"
                "         THEN CAST (NULL AS double precision)"
                "         ELSE"
-               "         (SELECT report_severity ((SELECT id FROM reports"
-               "                                   WHERE task = $1"
-               "                                   AND scan_run_status = %u"
-               "                                   ORDER BY creation_time DESC"
-               "                                   LIMIT 1 OFFSET 0), $2, $3))"
+               "         (SELECT report_severity (task_last_report ($1), $2, $3))"
                "         END;"
-               "$$ LANGUAGE SQL;",
-               TASK_STATUS_DONE);
+               "$$ LANGUAGE SQL;");
         }
 
       sql ("CREATE OR REPLACE FUNCTION task_trend (integer, integer, integer)"
@@ -1181,9 +1385,7 @@ manage_create_sql_functions ()
            " BEGIN"
            "   CASE"
            /*  Ensure there are enough reports. */
-           "   WHEN (SELECT count(*) <= 1 FROM reports"
-           "         WHERE task = $1"
-           "         AND scan_run_status = %u)"
+           "   WHEN task_second_last_report ($1) IS NULL"
            "   THEN RETURN ''::text;"
            /*  Get trend only for authenticated users. */
            "   WHEN gvmd_user () = 0"
@@ -1269,7 +1471,6 @@ manage_create_sql_functions ()
            "   RETURN 'same'::text;"
            " END;"
            "$$ LANGUAGE plpgsql;",
-           TASK_STATUS_DONE,
            TASK_STATUS_RUNNING);
     }
 
@@ -1296,6 +1497,8 @@ manage_create_sql_functions ()
        "         THEN 'Stopped'"
        "         WHEN $1 = %i"
        "         THEN 'Queued'"
+       "         WHEN $1 = %i"
+       "         THEN 'Launch Queued'"
        "         ELSE 'Interrupted'"
        "         END;"
        "$$ LANGUAGE SQL"
@@ -1311,7 +1514,8 @@ manage_create_sql_functions ()
        TASK_STATUS_STOP_REQUESTED,
        TASK_STATUS_STOP_WAITING,
        TASK_STATUS_STOPPED,
-       TASK_STATUS_QUEUED);
+       TASK_STATUS_QUEUED,
+       TASK_STATUS_LAUNCH_QUEUED);
 
   if (sql_int ("SELECT EXISTS (SELECT * FROM information_schema.tables"
                "               WHERE table_catalog = '%s'"
@@ -1607,16 +1811,221 @@ manage_create_result_indexes ()
   sql ("SELECT create_index ('results_by_nvt', 'results', 'nvt');");
   sql ("SELECT create_index ('results_by_task', 'results', 'task');");
   sql ("SELECT create_index ('results_by_date', 'results', 'date');");
+  manage_create_result_uuid_indexes ();
+
+  if (sql_int ("SELECT count (*) FROM meta"
+               " WHERE name = 'result_covering_indexes' AND value = '1';"))
+    manage_create_result_covering_indexes ();
+}
+
+/**
+ * @brief Create the indexes on the UUIDs of results.
+ *
+ * Results are only ever looked up by exact UUID, so a hash index does the
+ * job.  It stores a 4 byte hash code for each result instead of the 36
+ * character UUID, which makes it much smaller than a B-tree index on the
+ * text column.  Hash indexes are only crash safe from Postgres 10, so older
+ * servers get B-tree indexes.
+ */
+void
+manage_create_result_uuid_indexes ()
+{
+  if (sql_int ("SELECT current_setting ('server_version_num')::integer;")
+      >= 100000)
+    {
+      sql ("CREATE INDEX IF NOT EXISTS results_by_uuid"
+           " ON results USING hash (uuid);");
+      sql ("CREATE INDEX IF NOT EXISTS results_trash_by_uuid"
+           " ON results_trash USING hash (uuid);");
+    }
+  else
+    {
+      sql ("SELECT create_index ('results_by_uuid', 'results', 'uuid');");
+      sql ("SELECT create_index ('results_trash_by_uuid',"
+           "                     'results_trash', 'uuid');");
+    }
+}
+
+/**
+ * @brief Create the covering indexes for the result iterators.
+ *
+ * The iterators of the results of a report mostly filter on the report,
+ * the host and the QoD, and count or order by the severity.  With these
+ * columns in the index Postgres can answer the counts from the index
+ * alone.  INCLUDE needs Postgres 11, so older servers get the extra
+ * columns as key columns instead.
+ */
+void
+manage_create_result_covering_indexes ()
+{
+  if (sql_int ("SELECT current_setting ('server_version_num')::integer;")
+      >= 110000)
+    {
+      sql ("CREATE INDEX IF NOT EXISTS results_by_report_and_severity"
+           " ON results (report, severity) INCLUDE (qod, host, nvt);");
+      sql ("CREATE INDEX IF NOT EXISTS results_by_report_and_host"
+           " ON results (report, host) INCLUDE (severity, qod);");
+    }
+  else
+    {
+      sql ("CREATE INDEX IF NOT EXISTS results_by_report_and_severity"
+           " ON results (report, severity, qod, host, nvt);");
+      sql ("CREATE INDEX IF NOT EXISTS results_by_report_and_host"
+           " ON results (report, host, severity, qod);");
+    }
+}
+
+/**
+ * @brief Drop the covering indexes for the result iterators.
+ */
+void
+manage_drop_result_covering_indexes ()
+{
+  sql ("DROP INDEX IF EXISTS results_by_report_and_severity;");
+  sql ("DROP INDEX IF EXISTS results_by_report_and_host;");
+}
+
+/**
+ * @brief Check whether the text search indexes are enabled.
+ *
+ * @return 1 if enabled and pg_trgm is installed, else 0.
+ */
+int
+manage_text_search_indexes_enabled ()
+{
+  return sql_int ("SELECT count (*) FROM meta"
+                  " WHERE name = 'text_search_indexes' AND value = '1';")
+         && sql_int ("SELECT count (*) FROM pg_extension"
+                     " WHERE extname = 'pg_trgm';");
+}
+
+/**
+ * @brief Create the trigram indexes for free text filter terms.
+ *
+ * The filter terms of GMP compile to ILIKE and regular expression matches.
+ * A pg_trgm GIN index on a column lets Postgres answer these for the
+ * column from the index, instead of scanning the whole table.  The
+ * indexes slow down inserts a little, so they are optional.
+ *
+ * @return 0 success, -1 pg_trgm is not available.
+ */
+int
+manage_create_text_search_indexes ()
+{
+  if (db_extension_available ("pg_trgm") == FALSE)
+    return -1;
+
+  sql_session_set ("role", DB_SUPERUSER_ROLE);
+  sql ("CREATE EXTENSION IF NOT EXISTS \"pg_trgm\"");
+  sql_session_set ("role", "none");
+
+  sql ("CREATE INDEX IF NOT EXISTS results_by_description_trgm"
+       " ON results USING gin (description gin_trgm_ops);");
+  sql ("CREATE INDEX IF NOT EXISTS results_by_host_trgm"
+       " ON results USING gin (host gin_trgm_ops);");
+  sql ("CREATE INDEX IF NOT EXISTS hosts_by_name_trgm"
+       " ON hosts USING gin (name gin_trgm_ops);");
+  sql ("CREATE INDEX IF NOT EXISTS nvts_by_name_trgm"
+       " ON nvts USING gin (name gin_trgm_ops);");
+
+  if (sql_int ("SELECT EXISTS (SELECT * FROM information_schema.tables"
+               "               WHERE table_catalog = '%s'"
+               "               AND table_schema = 'scap'"
+               "               AND table_name = 'cves')"
+               " ::integer;",
+               sql_database ()))
+    sql ("CREATE INDEX IF NOT EXISTS cves_by_description_trgm"
+         " ON scap.cves USING gin (description gin_trgm_ops);");
+
+  return 0;
+}
+
+/**
+ * @brief Drop the trigram indexes for free text filter terms.
+ */
+void
+manage_drop_text_search_indexes ()
+{
+  sql ("DROP INDEX IF EXISTS results_by_description_trgm;");
+  sql ("DROP INDEX IF EXISTS results_by_host_trgm;");
+  sql ("DROP INDEX IF EXISTS hosts_by_name_trgm;");
+  sql ("DROP INDEX IF EXISTS nvts_by_name_trgm;");
+  sql ("DROP INDEX IF EXISTS scap.cves_by_description_trgm;");
+}
+
+/**
+ * @brief Create the secondary indexes of the NVT tables.
+ */
+void
+create_indexes_nvt ()
+{
+  sql ("SELECT create_index ('nvts_by_creation_time',"
+       "                     'nvts',"
+       "                     'creation_time');");
+  sql ("SELECT create_index ('nvts_by_family', 'nvts', 'family');");
+  sql ("SELECT create_index ('nvts_by_name', 'nvts', 'name');");
+  sql ("SELECT create_index ('nvts_by_modification_time',"
+       "                     'nvts', 'modification_time');");
+  sql ("SELECT create_index ('nvts_by_cvss_base',"
+       "                     'nvts', 'cvss_base');");
+  sql ("SELECT create_index ('nvts_by_solution_type',"
+       "                     'nvts', 'solution_type');");
+
+  sql ("SELECT create_index ('vt_refs_by_vt_oid',"
+       "                     'vt_refs', 'vt_oid');");
+  sql ("SELECT create_index ('vt_refs_by_type_and_ref_id',"
+       "                     'vt_refs', 'type, ref_id');");
+
+  sql ("SELECT create_index ('vt_severities_by_vt_oid',"
+       "                     'vt_severities', 'vt_oid');");
+
+  if (manage_text_search_indexes_enabled ())
+    sql ("CREATE INDEX IF NOT EXISTS nvts_by_name_trgm"
+         " ON nvts USING gin (name gin_trgm_ops);");
+}
+
+/**
+ * @brief Drop the secondary indexes of the NVT tables.
+ *
+ * Used while bulk loading the NVT tables, after which create_indexes_nvt
+ * builds the indexes again in one pass.
+ */
+void
+drop_indexes_nvt ()
+{
+  sql ("DROP INDEX IF EXISTS nvts_by_creation_time;");
+  sql ("DROP INDEX IF EXISTS nvts_by_family;");
+  sql ("DROP INDEX IF EXISTS nvts_by_name;");
+  sql ("DROP INDEX IF EXISTS nvts_by_modification_time;");
+  sql ("DROP INDEX IF EXISTS nvts_by_cvss_base;");
+  sql ("DROP INDEX IF EXISTS nvts_by_solution_type;");
+  sql ("DROP INDEX IF EXISTS vt_refs_by_vt_oid;");
+  sql ("DROP INDEX IF EXISTS vt_refs_by_type_and_ref_id;");
+  sql ("DROP INDEX IF EXISTS vt_severities_by_vt_oid;");
+  sql ("DROP INDEX IF EXISTS nvts_by_name_trgm;");
 }
 
 /**
  * @brief Create or replace the vulns view.
+ *
+ * When the vulns are materialized the NVTs used by results come from the
+ * vuln_nvts table, which is kept up to date as reports finish, instead of
+ * from a scan of all results.
  */
 void
 create_view_vulns ()
 {
+  const char *used_nvts;
+
   sql ("DROP VIEW IF EXISTS vulns;");
 
+  if (sql_int ("SELECT count (*) FROM meta"
+               " WHERE name = 'vulns_materialized' AND value = '1';"))
+    used_nvts = "SELECT nvt FROM vuln_nvts";
+  else
+    used_nvts = "SELECT DISTINCT nvt FROM results"
+                " WHERE (results.severity != " G_STRINGIFY (SEVERITY_ERROR) ")";
+
   if (sql_int ("SELECT EXISTS (SELECT * FROM information_schema.tables"
                "               WHERE table_catalog = '%s'"
                "               AND table_schema = 'scap'"
@@ -1625,8 +2034,7 @@ create_view_vulns ()
                sql_database ()))
     sql ("CREATE OR REPLACE VIEW vulns AS"
          " WITH used_nvts"
-         " AS (SELECT DISTINCT nvt FROM results"
-         "     WHERE (results.severity != " G_STRINGIFY (SEVERITY_ERROR) "))"
+         " AS (%s)"
          " SELECT id, uuid, name, creation_time, modification_time,"
          "        cvss_base::double precision AS severity, qod, 'nvt' AS type"
          " FROM nvts"
@@ -1636,16 +2044,403 @@ create_view_vulns ()
          G_STRINGIFY (QOD_DEFAULT) " AS qod,"
          "       'cve' AS type"
          " FROM cves"
-         " WHERE uuid in (SELECT * FROM used_nvts)");
+         " WHERE uuid in (SELECT * FROM used_nvts)",
+         used_nvts);
   else
     sql ("CREATE OR REPLACE VIEW vulns AS"
          " WITH used_nvts"
-         " AS (SELECT DISTINCT nvt FROM results"
-         "     WHERE (results.severity != " G_STRINGIFY (SEVERITY_ERROR) "))"
+         " AS (%s)"
          " SELECT id, uuid, name, creation_time, modification_time,"
          "        cvss_base::double precision AS severity, qod, 'nvt' AS type"
          " FROM nvts"
-         " WHERE uuid in (SELECT * FROM used_nvts)");
+         " WHERE uuid in (SELECT * FROM used_nvts)",
+         used_nvts);
+}
+
+/**
+ * @brief Number of consecutive report IDs that share a results partition.
+ */
+#define RESULTS_PARTITION_REPORTS 100
+
+/**
+ * @brief Check whether the results table is partitioned by report.
+ *
+ * @return 1 if partitioned, else 0.
+ */
+int
+results_partitioned ()
+{
+  return sql_int ("SELECT count (*) FROM meta"
+                  " WHERE name = 'results_partitioned' AND value = '1';");
+}
+
+/**
+ * @brief Ensure the results partition that holds a report exists.
+ *
+ * Does nothing if the results table is not partitioned.
+ *
+ * @param[in]  report  Report.
+ */
+void
+results_partition_ensure (report_t report)
+{
+  report_t start;
+
+  if (results_partitioned () == 0)
+    return;
+
+  start = (report / RESULTS_PARTITION_REPORTS) * RESULTS_PARTITION_REPORTS;
+  sql ("CREATE TABLE IF NOT EXISTS results_p%llu PARTITION OF results"
+       " FOR VALUES FROM (%llu) TO (%llu);",
+       start, start, start + RESULTS_PARTITION_REPORTS);
+}
+
+/**
+ * @brief Get the results partition that may be dropped with a report.
+ *
+ * A partition may be dropped once the given report is the only one left in
+ * its range, and the report ID sequence has passed the end of the range so
+ * that no new report can land in it.
+ *
+ * @param[in]  report  Report that is about to be deleted.
+ *
+ * @return Freshly allocated partition name, or NULL if the results of the
+ *         report must be deleted row by row.
+ */
+gchar *
+results_partition_droppable (report_t report)
+{
+  report_t start;
+
+  if (results_partitioned () == 0)
+    return NULL;
+
+  start = (report / RESULTS_PARTITION_REPORTS) * RESULTS_PARTITION_REPORTS;
+
+  if (sql_int ("SELECT EXISTS (SELECT * FROM reports"
+               "               WHERE id >= %llu AND id < %llu"
+               "               AND id != %llu)"
+               " OR (SELECT last_value FROM reports_id_seq) < %llu"
+               " OR NOT EXISTS (SELECT * FROM pg_class"
+               "                WHERE relname = 'results_p%llu'"
+               "                AND relispartition)",
+               start, start + RESULTS_PARTITION_REPORTS, report,
+               start + RESULTS_PARTITION_REPORTS - 1,
+               start))
+    return NULL;
+
+  return g_strdup_printf ("results_p%llu", start);
+}
+
+/**
+ * @brief Detach a results partition from results and drop it.
+ *
+ * Detaching needs an ACCESS EXCLUSIVE lock on results.  DETACH PARTITION
+ * CONCURRENTLY would need less, but it is not allowed while results has a
+ * default partition.  So the lock is only tried, and the detach is given
+ * up if the lock is not free, instead of queuing all readers of results
+ * behind it.  The detached table is dropped in the same transaction, so
+ * that a crash cannot leave it behind outside of results.  Dropping a
+ * table that is no longer a partition is quick, so the lock is still held
+ * only briefly.
+ *
+ * Must be called outside a transaction.
+ *
+ * @param[in]  partition  Name of partition, from results_partition_droppable.
+ *
+ * @return 0 success, 1 results busy, -1 error.
+ */
+int
+results_partition_drop (const gchar *partition)
+{
+  sql_begin_immediate ();
+  if (sql_int ("SELECT try_exclusive_lock ('results');") == 0)
+    {
+      sql_rollback ();
+      return 1;
+    }
+  if (sql_error ("ALTER TABLE results DETACH PARTITION %s;", partition)
+      || sql_error ("DROP TABLE %s;", partition))
+    {
+      sql_rollback ();
+      return -1;
+    }
+  sql_commit ();
+  return 0;
+}
+
+/**
+ * @brief Partition the results table by report.
+ *
+ * The existing results are copied into range partitions of
+ * RESULTS_PARTITION_REPORTS reports each, so that scans of a single report
+ * only touch its partition and deleting the reports of a range drops the
+ * partition instead of deleting each result.  Results without a report go
+ * to a default partition.
+ *
+ * Caller must organise a transaction.
+ *
+ * @return 0 success, 1 already partitioned, 2 database server too old.
+ */
+int
+manage_partition_results ()
+{
+  report_t max_report, start;
+
+  if (results_partitioned ())
+    return 1;
+
+  /* Default partitions were added in PostgreSQL 11. */
+  if (sql_int ("SELECT current_setting ('server_version_num')::integer;")
+      < 110000)
+    return 2;
+
+  sql ("ALTER TABLE results RENAME TO results_unpartitioned;");
+
+  /* Unique constraints on a partitioned table must include the partition
+   * key, and report may be NULL, so id and uuid only get plain indexes. */
+  sql ("CREATE TABLE results"
+       " (id integer NOT NULL DEFAULT nextval ('results_id_seq'),"
+       "  uuid text NOT NULL,"
+       "  task integer REFERENCES tasks (id) ON DELETE RESTRICT,"
+       "  host text,"
+       "  port text,"
+       "  nvt text,"
+       "  result_nvt integer," // REFERENCES result_nvts (id),"
+       "  type text,"
+       "  description text,"
+       "  report integer REFERENCES reports (id) ON DELETE RESTRICT,"
+       "  nvt_version text,"
+       "  severity real,"
+       "  qod integer,"
+       "  qod_type text,"
+       "  owner integer REFERENCES users (id) ON DELETE RESTRICT,"
+       "  date integer,"
+       "  hostname text,"
+       "  path text)"
+       " PARTITION BY RANGE (report);");
+  sql ("CREATE TABLE results_default PARTITION OF results DEFAULT;");
+
+  max_report = 0;
+  sql_int64 (&max_report, "SELECT coalesce (max (id), 0) FROM reports;");
+  for (start = 0; start <= max_report; start += RESULTS_PARTITION_REPORTS)
+    if (sql_int ("SELECT EXISTS (SELECT * FROM reports"
+                 "               WHERE id >= %llu AND id < %llu);",
+                 start, start + RESULTS_PARTITION_REPORTS))
+      sql ("CREATE TABLE results_p%llu PARTITION OF results"
+           " FOR VALUES FROM (%llu) TO (%llu);",
+           start, start, start + RESULTS_PARTITION_REPORTS);
+
+  sql ("INSERT INTO results"
+       " (id, uuid, task, host, port, nvt, result_nvt, type, description,"
+       "  report, nvt_version, severity, qod, qod_type, owner, date,"
+       "  hostname, path)"
+       " SELECT id, uuid, task, host, port, nvt, result_nvt, type,"
+       "        description, report, nvt_version, severity, qod, qod_type,"
+       "        owner, date, hostname, path"
+       " FROM results_unpartitioned;");
+
+  /* Keep the sequence when the old table goes. */
+  sql ("ALTER SEQUENCE results_id_seq OWNED BY results.id;");
+
+  /* This also drops the views on results, which create_tables recreates. */
+  sql ("DROP TABLE results_unpartitioned CASCADE;");
+
+  sql ("DELETE FROM meta WHERE name = 'results_partitioned';");
+  sql ("INSERT INTO meta (name, value) VALUES ('results_partitioned', '1');");
+
+  sql ("SELECT create_index ('results_by_id', 'results', 'id');");
+  manage_create_result_uuid_indexes ();
+  create_tables ();
+
+  return 0;
+}
+
+/**
+ * @brief Check whether report host detail values are deduplicated.
+ *
+ * @return 1 if deduplicated, else 0.
+ */
+int
+report_host_details_deduplicated ()
+{
+  return sql_int ("SELECT count (*) FROM meta"
+                  " WHERE name = 'report_host_details_deduplicated'"
+                  " AND value = '1';");
+}
+
+/**
+ * @brief Create the functions behind the deduplicated report_host_details.
+ *
+ * Once deduplicated, report_host_details is a view that joins the rows in
+ * report_host_detail_refs to their values in report_host_detail_values.
+ * These functions let the existing statements insert into and delete from
+ * the view.
+ */
+static void
+create_report_host_detail_functions ()
+{
+  sql ("CREATE OR REPLACE FUNCTION report_host_detail_value (text)"
+       " RETURNS integer AS $$"
+       /* Get the stored value, adding it if it is new.  The value is
+        * compared too, so that a hash collision only costs a second row. */
+       " DECLARE"
+       "   ret integer;"
+       " BEGIN"
+       "   IF $1 IS NULL THEN"
+       "     RETURN NULL;"
+       "   END IF;"
+       "   SELECT id INTO ret FROM report_host_detail_values"
+       "   WHERE hash = md5 ($1) AND value = $1"
+       "   LIMIT 1;"
+       "   IF ret IS NULL THEN"
+       "     INSERT INTO report_host_detail_values (hash, value)"
+       "     VALUES (md5 ($1), $1)"
+       "     RETURNING id INTO ret;"
+       "   END IF;"
+       "   RETURN ret;"
+       " END;"
+       "$$ LANGUAGE plpgsql;");
+
+  sql ("CREATE OR REPLACE FUNCTION report_host_details_insert ()"
+       " RETURNS TRIGGER AS $$"
+       " BEGIN"
+       "   INSERT INTO report_host_detail_refs"
+       "    (id, report_host, source_type, source_name, source_description,"
+       "     name, value)"
+       "   VALUES (coalesce (new.id, nextval ('report_host_details_id_seq')),"
+       "           new.report_host, new.source_type, new.source_name,"
+       "           new.source_description, new.name,"
+       "           report_host_detail_value (new.value))"
+       "   RETURNING id INTO new.id;"
+       "   RETURN new;"
+       " END;"
+       "$$ LANGUAGE plpgsql;");
+
+  sql ("CREATE OR REPLACE FUNCTION report_host_details_delete ()"
+       " RETURNS TRIGGER AS $$"
+       /* Values are left for the next deduplicate-host-details run. */
+       " BEGIN"
+       "   DELETE FROM report_host_detail_refs WHERE id = old.id;"
+       "   RETURN old;"
+       " END;"
+       "$$ LANGUAGE plpgsql;");
+}
+
+/**
+ * @brief Create the report_host_details view and its triggers.
+ */
+static void
+create_view_report_host_details ()
+{
+  create_report_host_detail_functions ();
+
+  sql ("CREATE OR REPLACE VIEW report_host_details AS"
+       " SELECT refs.id, refs.report_host, refs.source_type,"
+       "        refs.source_name, refs.source_description, refs.name,"
+       "        report_host_detail_values.value"
+       " FROM report_host_detail_refs AS refs"
+       " LEFT JOIN report_host_detail_values"
+       " ON report_host_detail_values.id = refs.value;");
+
+  sql ("DROP TRIGGER IF EXISTS report_host_details_insert"
+       " ON report_host_details;");
+  sql ("CREATE TRIGGER report_host_details_insert"
+       " INSTEAD OF INSERT ON report_host_details"
+       " FOR EACH ROW EXECUTE PROCEDURE report_host_details_insert ();");
+  sql ("DROP TRIGGER IF EXISTS report_host_details_delete"
+       " ON report_host_details;");
+  sql ("CREATE TRIGGER report_host_details_delete"
+       " INSTEAD OF DELETE ON report_host_details"
+       " FOR EACH ROW EXECUTE PROCEDURE report_host_details_delete ();");
+}
+
+/**
+ * @brief Store each distinct report host detail value once.
+ *
+ * Most host details, like OS fingerprints, package lists and certificates,
+ * are the same in every scan of a host.  The values move to
+ * report_host_detail_values, keyed by their hash, and the detail rows move
+ * to report_host_detail_refs, which refers to the values.
+ * report_host_details becomes a view that joins the two, so that all
+ * statements on it keep working.
+ *
+ * When the details are already deduplicated, the values that no detail
+ * refers to any more are removed instead.
+ *
+ * Caller must organise a transaction.
+ *
+ * @param[out]  count  Number of values stored, or number removed.
+ *
+ * @return 0 success, 1 already deduplicated.
+ */
+int
+manage_deduplicate_report_host_details (int *count)
+{
+  if (report_host_details_deduplicated ())
+    {
+      *count = sql_int ("WITH deleted AS"
+                        " (DELETE FROM report_host_detail_values"
+                        "  WHERE NOT EXISTS"
+                        "         (SELECT * FROM report_host_detail_refs"
+                        "          WHERE value"
+                        "                = report_host_detail_values.id)"
+                        "  RETURNING 1)"
+                        " SELECT count (*) FROM deleted;");
+      return 1;
+    }
+
+  sql ("CREATE TABLE report_host_detail_values"
+       " (id SERIAL PRIMARY KEY,"
+       "  hash text NOT NULL,"
+       "  value text NOT NULL);");
+
+  sql ("INSERT INTO report_host_detail_values (hash, value)"
+       " SELECT md5 (value), value"
+       " FROM report_host_details"
+       " WHERE value IS NOT NULL"
+       " GROUP BY value;");
+
+  sql ("CREATE INDEX report_host_detail_values_by_hash"
+       " ON report_host_detail_values (hash);");
+
+  sql ("CREATE TABLE report_host_detail_refs"
+       " (id integer PRIMARY KEY"
+       "     DEFAULT nextval ('report_host_details_id_seq'),"
+       "  report_host integer REFERENCES report_hosts (id) ON DELETE RESTRICT,"
+       "  source_type text,"
+       "  source_name text,"
+       "  source_description text,"
+       "  name text,"
+       "  value integer"
+       "   REFERENCES report_host_detail_values (id) ON DELETE RESTRICT);");
+
+  sql ("INSERT INTO report_host_detail_refs"
+       " (id, report_host, source_type, source_name, source_description,"
+       "  name, value)"
+       " SELECT details.id, details.report_host, details.source_type,"
+       "        details.source_name, details.source_description,"
+       "        details.name, report_host_detail_values.id"
+       " FROM report_host_details AS details"
+       " LEFT JOIN report_host_detail_values"
+       " ON report_host_detail_values.hash = md5 (details.value)"
+       " AND report_host_detail_values.value = details.value;");
+
+  /* Keep the sequence when the old table goes. */
+  sql ("ALTER SEQUENCE report_host_details_id_seq"
+       " OWNED BY report_host_detail_refs.id;");
+
+  sql ("DROP TABLE report_host_details;");
+
+  sql ("DELETE FROM meta WHERE name = 'report_host_details_deduplicated';");
+  sql ("INSERT INTO meta (name, value)"
+       " VALUES ('report_host_details_deduplicated', '1');");
+
+  *count = sql_int ("SELECT count (*) FROM report_host_detail_values;");
+
+  create_tables ();
+
+  return 0;
 }
 
 
@@ -1681,6 +2476,19 @@ create_tables ()
        "  creation_time integer,"
        "  modification_time integer);");
 
+  sql ("CREATE TABLE IF NOT EXISTS gmp_sessions"
+       " (id SERIAL PRIMARY KEY,"
+       "  token_hash text UNIQUE NOT NULL,"
+       "  \"user\" integer REFERENCES users (id) ON DELETE CASCADE,"
+       "  user_modification_time integer,"
+       "  role text,"
+       "  timezone text,"
+       "  severity_class text,"
+       "  dynamic_severity integer,"
+       "  default_severity real,"
+       "  creation_time integer,"
+       "  expiry_time integer);");
+
   sql ("CREATE TABLE IF NOT EXISTS auth_cache"
        " (id SERIAL PRIMARY KEY,"
        "  username text NOT NULL,"
@@ -1753,6 +2561,21 @@ create_tables ()
        "  name text,"
        "  data text);");
 
+  sql ("CREATE TABLE IF NOT EXISTS alert_queue"
+       " (id SERIAL PRIMARY KEY,"
+       "  alert integer REFERENCES alerts (id) ON DELETE CASCADE,"
+       "  method integer,"
+       "  event integer,"
+       "  event_data text,"
+       "  task integer,"
+       "  report integer,"
+       "  owner_uuid text,"
+       "  owner_name text,"
+       "  worker integer,"
+       "  attempts integer,"
+       "  next_time integer,"
+       "  creation_time integer);");
+
   sql ("CREATE TABLE IF NOT EXISTS credentials"
        " (id SERIAL PRIMARY KEY,"
        "  uuid text UNIQUE NOT NULL,"
@@ -1932,6 +2755,31 @@ create_tables ()
        "  role integer REFERENCES roles_trash (id) ON DELETE RESTRICT,"
        "  \"user\" integer REFERENCES users (id) ON DELETE RESTRICT);");
 
+  sql ("CREATE OR REPLACE FUNCTION gmp_sessions_revoke ()"
+       " RETURNS TRIGGER AS $$"
+       /* Sessions keep the role of the user from when they were issued,
+        * and group and role changes do not modify the user. */
+       " BEGIN"
+       "   IF TG_OP != 'INSERT' THEN"
+       "     DELETE FROM gmp_sessions WHERE \"user\" = old.\"user\";"
+       "   END IF;"
+       "   IF TG_OP != 'DELETE' THEN"
+       "     DELETE FROM gmp_sessions WHERE \"user\" = new.\"user\";"
+       "   END IF;"
+       "   RETURN NULL;"
+       " END;"
+       "$$ LANGUAGE plpgsql;");
+
+  sql ("DROP TRIGGER IF EXISTS group_users_gmp_sessions ON group_users;");
+  sql ("CREATE TRIGGER group_users_gmp_sessions"
+       " AFTER INSERT OR DELETE OR UPDATE ON group_users"
+       " FOR EACH ROW EXECUTE PROCEDURE gmp_sessions_revoke ();");
+
+  sql ("DROP TRIGGER IF EXISTS role_users_gmp_sessions ON role_users;");
+  sql ("CREATE TRIGGER role_users_gmp_sessions"
+       " AFTER INSERT OR DELETE OR UPDATE ON role_users"
+       " FOR EACH ROW EXECUTE PROCEDURE gmp_sessions_revoke ();");
+
   sql ("CREATE TABLE IF NOT EXISTS nvt_selectors"
        " (id SERIAL PRIMARY KEY,"
        "  name text,"
@@ -2188,6 +3036,16 @@ create_tables ()
        "  scanner_location integer,"
        "  usage_type text);");
 
+  sql ("CREATE TABLE IF NOT EXISTS config_nvts"
+       " (config integer REFERENCES configs (id) ON DELETE CASCADE,"
+       "  nvt text,"
+       "  family text,"
+       "  PRIMARY KEY (config, nvt));");
+
+  sql ("CREATE TABLE IF NOT EXISTS config_nvts_built"
+       " (config integer PRIMARY KEY REFERENCES configs (id)"
+       "                             ON DELETE CASCADE);");
+
   sql ("CREATE TABLE IF NOT EXISTS config_preferences"
        " (id SERIAL PRIMARY KEY,"
        "  config integer REFERENCES configs (id) ON DELETE RESTRICT,"
@@ -2206,6 +3064,71 @@ create_tables ()
        "  default_value text,"
        "  hr_name text);");
 
+  sql ("CREATE TABLE IF NOT EXISTS config_scan_bundles"
+       " (config integer PRIMARY KEY REFERENCES configs (id) ON DELETE CASCADE,"
+       "  config_modification_time integer,"
+       "  nvts_feed_version text,"
+       "  creation_time integer);");
+
+  sql ("CREATE TABLE IF NOT EXISTS config_scan_bundle_items"
+       " (id SERIAL PRIMARY KEY,"
+       "  config integer REFERENCES config_scan_bundles (config)"
+       "                 ON DELETE CASCADE,"
+       "  kind integer,"
+       "  name text,"
+       "  pref_id text,"
+       "  value text);");
+
+  sql ("CREATE INDEX IF NOT EXISTS config_scan_bundle_items_by_config"
+       " ON config_scan_bundle_items (config);");
+
+  sql ("CREATE OR REPLACE FUNCTION config_scan_bundle_drop ()"
+       " RETURNS TRIGGER AS $$"
+       /* Drop the scan bundles that depend on the changed row.  Not every
+        * preference or selector change updates configs.modification_time. */
+       " BEGIN"
+       "   IF TG_TABLE_NAME = 'nvt_selectors' THEN"
+       "     IF TG_OP != 'INSERT' THEN"
+       "       DELETE FROM config_scan_bundles"
+       "       WHERE config IN (SELECT id FROM configs"
+       "                        WHERE nvt_selector = old.name);"
+       "     END IF;"
+       "     IF TG_OP != 'DELETE' THEN"
+       "       DELETE FROM config_scan_bundles"
+       "       WHERE config IN (SELECT id FROM configs"
+       "                        WHERE nvt_selector = new.name);"
+       "     END IF;"
+       "   ELSIF TG_TABLE_NAME = 'configs' THEN"
+       "     DELETE FROM config_scan_bundles WHERE config = new.id;"
+       "   ELSE"
+       "     IF TG_OP != 'INSERT' THEN"
+       "       DELETE FROM config_scan_bundles WHERE config = old.config;"
+       "     END IF;"
+       "     IF TG_OP != 'DELETE' THEN"
+       "       DELETE FROM config_scan_bundles WHERE config = new.config;"
+       "     END IF;"
+       "   END IF;"
+       "   RETURN NULL;"
+       " END;"
+       "$$ LANGUAGE plpgsql;");
+
+  sql ("DROP TRIGGER IF EXISTS config_preferences_scan_bundle"
+       " ON config_preferences;");
+  sql ("CREATE TRIGGER config_preferences_scan_bundle"
+       " AFTER INSERT OR DELETE OR UPDATE ON config_preferences"
+       " FOR EACH ROW EXECUTE PROCEDURE config_scan_bundle_drop ();");
+
+  sql ("DROP TRIGGER IF EXISTS nvt_selectors_scan_bundle ON nvt_selectors;");
+  sql ("CREATE TRIGGER nvt_selectors_scan_bundle"
+       " AFTER INSERT OR DELETE OR UPDATE ON nvt_selectors"
+       " FOR EACH ROW EXECUTE PROCEDURE config_scan_bundle_drop ();");
+
+  sql ("DROP TRIGGER IF EXISTS configs_scan_bundle ON configs;");
+  sql ("CREATE TRIGGER configs_scan_bundle"
+       " AFTER UPDATE OF nvt_selector, families_growing, nvts_growing"
+       " ON configs"
+       " FOR EACH ROW EXECUTE PROCEDURE config_scan_bundle_drop ();");
+
   sql ("CREATE TABLE IF NOT EXISTS schedules"
        " (id SERIAL PRIMARY KEY,"
        "  uuid text UNIQUE NOT NULL,"
@@ -2318,6 +3241,84 @@ create_tables ()
        "  flags integer,"
        "  modification_time integer);");
 
+  sql ("CREATE TABLE IF NOT EXISTS task_launch_queue"
+       " (task integer PRIMARY KEY REFERENCES tasks (id) ON DELETE CASCADE,"
+       "  owner_uuid text,"
+       "  owner_name text,"
+       "  previous_run_status integer,"
+       "  queued_time integer,"
+       "  launch_time integer);");
+
+  sql ("CREATE TABLE IF NOT EXISTS task_summaries"
+       " (task integer PRIMARY KEY REFERENCES tasks (id) ON DELETE CASCADE,"
+       "  report_count integer,"
+       "  finished_report_count integer,"
+       "  first_report integer,"
+       "  last_report integer,"
+       "  second_last_report integer);");
+
+  create_task_summary_functions ();
+
+  sql ("DROP TRIGGER IF EXISTS reports_task_summary ON reports;");
+  sql ("CREATE TRIGGER reports_task_summary"
+       " AFTER INSERT OR DELETE OR UPDATE OF task, scan_run_status,"
+       "                                     creation_time"
+       " ON reports"
+       " FOR EACH ROW EXECUTE PROCEDURE reports_task_summary ();");
+
+  if (sql_int ("SELECT count (*) FROM meta"
+               " WHERE name = 'task_summaries_built';")
+      == 0)
+    {
+      sql ("SELECT task_summary_update (id) FROM tasks;");
+      sql ("INSERT INTO meta (name, value)"
+           " VALUES ('task_summaries_built', '1');");
+    }
+
+  sql ("CREATE TABLE IF NOT EXISTS host_latest"
+       " (host integer PRIMARY KEY REFERENCES hosts (id) ON DELETE CASCADE,"
+       "  report_host integer,"
+       "  severity real,"
+       "  best_os_cpe text,"
+       "  best_os_text text);");
+
+  create_host_latest_functions ();
+
+  /* Only the details that host_latest holds need to update it. */
+  sql ("DROP TRIGGER IF EXISTS host_max_severities_latest"
+       " ON host_max_severities;");
+  sql ("CREATE TRIGGER host_max_severities_latest"
+       " AFTER INSERT OR DELETE ON host_max_severities"
+       " FOR EACH ROW EXECUTE PROCEDURE host_latest_trigger ();");
+  sql ("DROP TRIGGER IF EXISTS host_details_latest_insert ON host_details;");
+  sql ("CREATE TRIGGER host_details_latest_insert"
+       " AFTER INSERT ON host_details"
+       " FOR EACH ROW"
+       " WHEN (new.name IN ('best_os_cpe', 'best_os_text'))"
+       " EXECUTE PROCEDURE host_latest_trigger ();");
+  sql ("DROP TRIGGER IF EXISTS host_details_latest_delete ON host_details;");
+  sql ("CREATE TRIGGER host_details_latest_delete"
+       " AFTER DELETE ON host_details"
+       " FOR EACH ROW"
+       " WHEN (old.name IN ('best_os_cpe', 'best_os_text'))"
+       " EXECUTE PROCEDURE host_latest_trigger ();");
+
+  if (sql_int ("SELECT count (*) FROM meta"
+               " WHERE name = 'host_latest_built';")
+      == 0)
+    {
+      sql ("SELECT host_latest_update (id) FROM hosts;");
+      sql ("INSERT INTO meta (name, value)"
+           " VALUES ('host_latest_built', '1');");
+    }
+
+  sql ("CREATE TABLE IF NOT EXISTS report_ingest_checkpoints"
+       " (report integer PRIMARY KEY REFERENCES reports (id) ON DELETE CASCADE,"
+       "  pops integer,"
+       "  results integer,"
+       "  pending integer,"
+       "  modification_time integer);");
+
   sql ("CREATE TABLE IF NOT EXISTS report_counts"
        " (id SERIAL PRIMARY KEY,"
        "  report integer REFERENCES reports (id) ON DELETE RESTRICT,"
@@ -2328,9 +3329,20 @@ create_tables ()
        "  end_time integer,"
        "  min_qod integer);");
 
+  sql ("CREATE TABLE IF NOT EXISTS feed_file_hashes"
+       " (path text PRIMARY KEY,"
+       "  hash text,"
+       "  mtime bigint);");
+
+  sql ("CREATE TABLE IF NOT EXISTS report_deletions"
+       " (report integer PRIMARY KEY REFERENCES reports (id)"
+       "                             ON DELETE RESTRICT,"
+       "  task integer REFERENCES tasks (id) ON DELETE RESTRICT,"
+       "  time integer);");
+
   sql ("CREATE TABLE IF NOT EXISTS results"
        " (id SERIAL PRIMARY KEY,"
-       "  uuid text UNIQUE NOT NULL,"
+       "  uuid text NOT NULL,"
        "  task integer REFERENCES tasks (id) ON DELETE RESTRICT,"
        "  host text,"
        "  port text,"
@@ -2350,7 +3362,7 @@ create_tables ()
 
   sql ("CREATE TABLE IF NOT EXISTS results_trash"
        " (id SERIAL PRIMARY KEY,"
-       "  uuid text UNIQUE NOT NULL,"
+       "  uuid text NOT NULL,"
        "  task integer REFERENCES tasks (id) ON DELETE RESTRICT,"
        "  host text,"
        "  port text,"
@@ -2469,14 +3481,18 @@ create_tables ()
        "  current_port integer,"
        "  max_port integer);");
 
-  sql ("CREATE TABLE IF NOT EXISTS report_host_details"
-       " (id SERIAL PRIMARY KEY,"
-       "  report_host integer REFERENCES report_hosts (id) ON DELETE RESTRICT,"
-       "  source_type text,"
-       "  source_name text,"
-       "  source_description text,"
-       "  name text,"
-       "  value text);");
+  if (report_host_details_deduplicated ())
+    create_view_report_host_details ();
+  else
+    sql ("CREATE TABLE IF NOT EXISTS report_host_details"
+         " (id SERIAL PRIMARY KEY,"
+         "  report_host integer"
+         "   REFERENCES report_hosts (id) ON DELETE RESTRICT,"
+         "  source_type text,"
+         "  source_name text,"
+         "  source_description text,"
+         "  name text,"
+         "  value text);");
 
   sql ("CREATE TABLE IF NOT EXISTS vt_refs"
        " (id SERIAL PRIMARY KEY,"
@@ -2494,6 +3510,10 @@ create_tables ()
        "  score double precision,"
        "  value text);");
 
+  sql ("CREATE TABLE IF NOT EXISTS vt_hashes"
+       " (vt_oid text PRIMARY KEY,"
+       "  hash text NOT NULL);");
+
   sql ("CREATE TABLE IF NOT EXISTS nvt_preferences"
        " (id SERIAL PRIMARY KEY,"
        "  name text UNIQUE NOT NULL,"
@@ -2523,6 +3543,24 @@ create_tables ()
        "  qod integer,"
        "  qod_type text);");
 
+  sql ("CREATE TABLE IF NOT EXISTS nvt_current_severities"
+       " (nvt text PRIMARY KEY,"
+       "  severity double precision);");
+
+  create_current_severity_function ();
+
+  if (sql_int ("SELECT count (*) FROM meta"
+               " WHERE name = 'nvt_current_severities_built';")
+      == 0)
+    {
+      sql ("INSERT INTO nvt_current_severities (nvt, severity)"
+           " SELECT oid, CAST (nullif (cvss_base, '') AS double precision)"
+           " FROM nvts"
+           " ON CONFLICT (nvt) DO UPDATE SET severity = EXCLUDED.severity;");
+      sql ("INSERT INTO meta (name, value)"
+           " VALUES ('nvt_current_severities_built', '1');");
+    }
+
   sql ("CREATE TABLE IF NOT EXISTS notes"
        " (id SERIAL PRIMARY KEY,"
        "  uuid text UNIQUE NOT NULL,"
@@ -2757,6 +3795,9 @@ create_tables ()
        "  FROM results, users,"
        "  (SELECT 0 AS dynamic UNION SELECT 1 AS dynamic) AS dynamic_opts;");
 
+  sql ("CREATE TABLE IF NOT EXISTS vuln_nvts"
+       " (nvt text PRIMARY KEY);");
+
   sql ("CREATE OR REPLACE VIEW tls_certificate_source_origins AS"
        " SELECT sources.id AS source_id, tls_certificate,"
        "        origin_id, origin_type, origin_data"
@@ -2787,17 +3828,7 @@ create_tables ()
   sql ("SELECT create_index ('nvt_selectors_by_name',"
        "                     'nvt_selectors',"
        "                     'name');");
-  sql ("SELECT create_index ('nvts_by_creation_time',"
-       "                     'nvts',"
-       "                     'creation_time');");
-  sql ("SELECT create_index ('nvts_by_family', 'nvts', 'family');");
-  sql ("SELECT create_index ('nvts_by_name', 'nvts', 'name');");
-  sql ("SELECT create_index ('nvts_by_modification_time',"
-       "                     'nvts', 'modification_time');");
-  sql ("SELECT create_index ('nvts_by_cvss_base',"
-       "                     'nvts', 'cvss_base');");
-  sql ("SELECT create_index ('nvts_by_solution_type',"
-       "                     'nvts', 'solution_type');");
+  create_indexes_nvt ();
 
   sql ("SELECT create_index ('permissions_by_name',"
        "                     'permissions', 'name');");
@@ -2818,10 +3849,18 @@ create_tables ()
        "                     'resource_type, resource_uuid');");
   sql ("SELECT create_index ('tag_resources_by_tag',"
        "                     'tag_resources', 'tag');");
+  /* Covers the tag filter keywords, which look up the resources of a set
+   * of tags. */
+  sql ("SELECT create_index ('tag_resources_by_tag_and_resource_uuid',"
+       "                     'tag_resources',"
+       "                     'tag, resource_type, resource_uuid');");
 
   sql ("SELECT create_index ('tag_resources_trash_by_tag',"
        "                     'tag_resources_trash', 'tag');");
 
+  sql ("SELECT create_index ('tasks_by_schedule_next_time',"
+       "                     'tasks', 'schedule_next_time');");
+
   sql ("SELECT create_index ('tls_certificate_locations_by_host_ip',"
        "                     'tls_certificate_locations', 'host_ip')");
 
@@ -2829,20 +3868,26 @@ create_tables ()
        "                     'tls_certificate_origins',"
        "                     'origin_id, origin_type')");
 
-  sql ("SELECT create_index ('vt_refs_by_vt_oid',"
-       "                     'vt_refs', 'vt_oid');");
-
-  sql ("SELECT create_index ('vt_severities_by_vt_oid',"
-       "                     'vt_severities', 'vt_oid');");
-
   /* Previously this included the value column but that can be bigger than 8191,
    * the maximum size that Postgres can handle.  For example, this can happen
    * for "ports".  Mostly value is short, like a CPE for the "App" detail,
    * which is what the index is for. */
-  sql ("SELECT create_index"
-       "        ('report_host_details_by_report_host_and_name',"
-       "         'report_host_details',"
-       "         'report_host, name');");
+  if (report_host_details_deduplicated ())
+    {
+      sql ("SELECT create_index"
+           "        ('report_host_detail_refs_by_report_host_and_name',"
+           "         'report_host_detail_refs',"
+           "         'report_host, name');");
+      sql ("SELECT create_index"
+           "        ('report_host_detail_refs_by_value',"
+           "         'report_host_detail_refs',"
+           "         'value');");
+    }
+  else
+    sql ("SELECT create_index"
+         "        ('report_host_details_by_report_host_and_name',"
+         "         'report_host_details',"
+         "         'report_host, name');");
   sql ("SELECT create_index"
        "        ('report_hosts_by_report_and_host',"
        "         'report_hosts',"
@@ -2935,13 +3980,13 @@ check_db_extensions ()
       g_debug ("%s: All required extensions are available.", __func__);
 
       // Switch to superuser role and try to install extensions.
-      sql ("SET ROLE \"%s\";", DB_SUPERUSER_ROLE);
+      sql_session_set ("role", DB_SUPERUSER_ROLE);
       
       sql ("CREATE EXTENSION IF NOT EXISTS \"uuid-ossp\"");
       sql ("CREATE EXTENSION IF NOT EXISTS \"pgcrypto\"");
       sql ("CREATE EXTENSION IF NOT EXISTS \"pg-gvm\"");
 
-      sql ("RESET ROLE;");
+      sql_session_set ("role", "none");
       return 0;
     }
   else
@@ -2953,6 +3998,44 @@ check_db_extensions ()
 
 /* SecInfo. */
 
+/**
+ * @brief Add schemas to the search path of the session.
+ *
+ * @param[in]  suffix  Text to append to the search path, like ",scap".
+ */
+static void
+search_path_append (const char *suffix)
+{
+  gchar *search_path, *new_search_path;
+
+  search_path = sql_string ("SELECT current_setting ('search_path');");
+  new_search_path = g_strdup_printf ("%s%s",
+                                     search_path ? search_path : "",
+                                     suffix);
+  sql_session_set ("search_path", new_search_path);
+  g_free (new_search_path);
+  g_free (search_path);
+}
+
+/**
+ * @brief Add a schema to the front of the search path of the session.
+ *
+ * @param[in]  prefix  Text to prepend to the search path, like "scap2,".
+ */
+static void
+search_path_prepend (const char *prefix)
+{
+  gchar *search_path, *new_search_path;
+
+  search_path = sql_string ("SELECT current_setting ('search_path');");
+  new_search_path = g_strdup_printf ("%s%s",
+                                     prefix,
+                                     search_path ? search_path : "");
+  sql_session_set ("search_path", new_search_path);
+  g_free (new_search_path);
+  g_free (search_path);
+}
+
 /**
  * @brief Attach external databases.
  */
@@ -2960,14 +4043,10 @@ void
 manage_attach_databases ()
 {
   if (manage_scap_loaded ())
-    sql ("SELECT set_config ('search_path',"
-         "                   current_setting ('search_path') || ',scap',"
-         "                   false);");
+    search_path_append (",scap");
 
   if (manage_cert_loaded ())
-    sql ("SELECT set_config ('search_path',"
-         "                   current_setting ('search_path') || ',cert',"
-         "                   false);");
+    search_path_append (",cert");
 }
 
 /**
@@ -3001,9 +4080,7 @@ manage_db_init (const gchar *name)
       sql ("DROP SCHEMA IF EXISTS cert CASCADE;");
       sql ("CREATE SCHEMA cert;");
 
-      sql ("SELECT set_config ('search_path',"
-           "                   current_setting ('search_path') || ',cert',"
-           "                   false);");
+      search_path_append (",cert");
 
       /* Create tables and indexes. */
 
@@ -3106,9 +4183,7 @@ manage_db_init (const gchar *name)
            " END;"
            " $$ LANGUAGE plpgsql;");
 
-      sql ("SELECT set_config ('search_path',"
-           "                   'scap2,' || current_setting ('search_path'),"
-           "                   false);");
+      search_path_prepend ("scap2,");
 
       sql ("SELECT drop_scap2 ();");
       sql ("DROP FUNCTION IF EXISTS drop_scap2 ();");
@@ -3239,6 +4314,10 @@ manage_db_init_indexes (const gchar *name)
            " ON scap2.affected_products (cpe);");
       sql ("CREATE INDEX afp_cve_idx"
            " ON scap2.affected_products (cve);");
+
+      if (manage_text_search_indexes_enabled ())
+        sql ("CREATE INDEX cves_by_description_trgm"
+             " ON scap2.cves USING gin (description gin_trgm_ops);");
     }
   else
     {
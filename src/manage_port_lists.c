@@ -271,10 +271,12 @@ sync_port_list_with_feed (const gchar *path)
 
       g_debug ("%s: considering %s for update", __func__, path);
 
-      if (port_list_updated_in_feed (port_list, full_path))
+      if (port_list_updated_in_feed (port_list, full_path)
+          && feed_file_changed (full_path))
         {
           g_debug ("%s: updating %s", __func__, path);
-          update_port_list_from_file (port_list, full_path);
+          if (update_port_list_from_file (port_list, full_path) == 0)
+            feed_file_record (full_path);
         }
 
       g_free (full_path);
@@ -292,7 +294,8 @@ sync_port_list_with_feed (const gchar *path)
 
   g_debug ("%s: adding %s", __func__, path);
 
-  create_port_list_from_file (full_path);
+  if (create_port_list_from_file (full_path) == 0)
+    feed_file_record (full_path);
 
   g_free (full_path);
 }
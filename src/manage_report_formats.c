@@ -631,10 +631,12 @@ sync_report_format_with_feed (const gchar *path)
 
       g_debug ("%s: considering %s for update", __func__, path);
 
-      if (report_format_updated_in_feed (report_format, full_path))
+      if (report_format_updated_in_feed (report_format, full_path)
+          && feed_file_changed (full_path))
         {
           g_debug ("%s: updating %s", __func__, path);
-          update_report_format_from_file (report_format, full_path);
+          if (update_report_format_from_file (report_format, full_path) == 0)
+            feed_file_record (full_path);
         }
 
       g_free (full_path);
@@ -652,7 +654,8 @@ sync_report_format_with_feed (const gchar *path)
 
   g_debug ("%s: adding %s", __func__, path);
 
-  create_report_format_from_file (full_path);
+  if (create_report_format_from_file (full_path) == 0)
+    feed_file_record (full_path);
 
   g_free (full_path);
 }
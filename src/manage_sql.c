@@ -27,6 +27,7 @@
 #define _GNU_SOURCE
 
 #include "manage_sql.h"
+#include "manage_metrics.h"
 #include "manage_port_lists.h"
 #include "manage_report_formats.h"
 #include "manage_sql_secinfo.h"
@@ -52,10 +53,12 @@
 #include <dirent.h>
 #include <errno.h>
 #include <glib/gstdio.h>
+#include <gnutls/crypto.h>
 #include <gnutls/x509.h>
 #include <malloc.h>
 #include <pwd.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -177,6 +180,9 @@ static void report_severity_data (report_t, const char *, const get_data_t *,
 
 static int cache_report_counts (report_t, int, int, severity_data_t*);
 
+static void
+result_nvt_info_cache_clear ();
+
 static char*
 task_owner_uuid (task_t);
 
@@ -260,6 +266,12 @@ find_trash_report_with_permission (const char *, report_t *, const char *);
 static int
 cleanup_schedule_times ();
 
+static int
+delete_report_user (report_t);
+
+static void
+report_render_cache_remove (report_t);
+
 static char *
 permission_name (permission_t);
 
@@ -272,6 +284,9 @@ cache_all_permissions_for_users (GArray*);
 static void
 report_cache_counts (report_t, int, int, const char*);
 
+static void
+report_add_counts_for_results (report_t, result_t, int);
+
 static int
 report_host_dead (report_host_t);
 
@@ -312,6 +327,9 @@ setting_value_int (const char *, int *);
 static int
 setting_auto_cache_rebuild_int ();
 
+static void
+setting_cache_clear ();
+
 static double
 setting_default_severity_dbl ();
 
@@ -404,10 +422,139 @@ static int max_attach_length = MAX_ATTACH_LENGTH;
  */
 static int max_email_message_length = MAX_EMAIL_MESSAGE_LENGTH;
 
+/**
+ * @brief Number of OSP results to insert per statement.
+ *
+ * A value less or equal to 0 inserts each result individually.
+ */
+static int osp_result_batch_size = OSP_RESULT_BATCH_SIZE_DEFAULT;
+
+/**
+ * @brief Number of worker processes that render the hosts of a report.
+ */
+static int report_host_workers = REPORT_HOST_WORKERS_DEFAULT;
+
+/**
+ * @brief Number of worker processes that run the commands of a GMP batch.
+ */
+static int gmp_batch_workers = GMP_BATCH_WORKERS_DEFAULT;
+
+/**
+ * @brief Number of worker processes that rebuild the report count cache.
+ */
+static int report_cache_workers = REPORT_CACHE_WORKERS_DEFAULT;
+
+/**
+ * @brief Maximum size in MiB of the cache of rendered reports, 0 for none.
+ */
+static int report_render_cache_size = REPORT_RENDER_CACHE_SIZE_DEFAULT;
+
+/**
+ * @brief Rows per table that the reaper removes from a deleted report per
+ *        schedule period, 0 to delete reports immediately.
+ */
+static int report_deletion_chunk = REPORT_DELETION_CHUNK_DEFAULT;
+
+/**
+ * @brief Number of alert worker processes, 0 to run alerts at the event.
+ */
+static int alert_workers = ALERT_WORKERS_DEFAULT;
+
+/**
+ * @brief Number of queued alerts of one method that may run at once.
+ *
+ * A value of 0 leaves the number limited only by the alert workers.
+ */
+static int alert_method_workers = ALERT_METHOD_WORKERS_DEFAULT;
+
+/**
+ * @brief Seconds that a GMP session token stays valid, 0 if disabled.
+ */
+static int gmp_session_ttl = GMP_SESSION_TTL_DEFAULT;
+
+/**
+ * @brief Number of times a queued alert is run before it is given up.
+ */
+#define ALERT_QUEUE_ATTEMPTS 5
+
+/**
+ * @brief Seconds to wait per failed attempt before running an alert again.
+ */
+#define ALERT_QUEUE_RETRY_DELAY 60
+
+/**
+ * @brief NVT in the NVT cache image.
+ */
+typedef struct
+{
+  guint32 oid;        ///< Offset of OID in strings.
+  guint32 refs;       ///< Index of first ref.
+  guint32 ref_count;  ///< Number of refs.
+} nvti_image_nvt_t;
+
+/**
+ * @brief NVT reference in the NVT cache image.
+ */
+typedef struct
+{
+  guint32 type;       ///< Offset of type in strings.
+  guint32 id;         ///< Offset of ID in strings.
+} nvti_image_ref_t;
+
 /**
  * @brief Memory cache of NVT information from the database.
+ *
+ * The cache is a single read-only shared mapping, laid out as this header,
+ * the NVTs sorted by OID, the refs, and then the strings.  The mapping is
+ * never written after it is built, so forked processes share its pages
+ * instead of each getting a copy.
+ */
+typedef struct
+{
+  size_t size;        ///< Size of the whole mapping.
+  guint32 nvt_count;  ///< Number of NVTs.
+  guint32 ref_count;  ///< Number of refs.
+} nvti_image_t;
+
+/**
+ * @brief The NVT cache image of this process.
+ */
+static nvti_image_t *nvti_cache = NULL;
+
+/**
+ * @brief NVT and CVE data used when creating results, cached per process.
+ */
+typedef struct
+{
+  gchar *severity;           ///< Severity, NULL if the NVT was not found.
+  gchar *modification_time;  ///< Modification time, stored as result version.
+} result_nvt_info_t;
+
+/**
+ * @brief Memory cache of result_nvt_info_t's, keyed on NVT OID or CVE name.
+ *
+ * Filled as results are created, so that a scan that gets the same NVT many
+ * times only queries the database once per NVT.
  */
-static nvtis_t* nvti_cache = NULL;
+static GHashTable *result_nvt_info_cache = NULL;
+
+/**
+ * @brief NVT feed version that \ref result_nvt_info_cache was filled from.
+ */
+static gchar *result_nvt_info_cache_version = NULL;
+
+/**
+ * @brief Report whose report hosts are in \ref report_host_cache.
+ */
+static report_t report_host_cache_report = 0;
+
+/**
+ * @brief Memory cache of the report hosts of a report, keyed on host.
+ *
+ * Only active while the report is being filled, see
+ * \ref report_host_cache_init.
+ */
+static GHashTable *report_host_cache = NULL;
 
 /**
  * @brief Name of the database file.
@@ -432,6 +579,7 @@ static struct timeval last_msg;
  */
 command_t gmp_commands[]
  = {{"AUTHENTICATE", "Authenticate with the manager." },
+    {"BATCH", "Run independent GET commands concurrently."},
     {"CREATE_ALERT", "Create an alert."},
     {"CREATE_ASSET", "Create an asset."},
     {"CREATE_CONFIG", "Create a config."},
@@ -511,6 +659,7 @@ command_t gmp_commands[]
     {"GET_VERSION", "Get the Greenbone Management Protocol version."},
     {"GET_VULNS", "Get all vulnerabilities."},
     {"HELP", "Get this help text."},
+    {"LOGOUT", "End the session."},
     {"MODIFY_ALERT", "Modify an existing alert."},
     {"MODIFY_ASSET", "Modify an existing asset."},
     {"MODIFY_AUTH", "Modify the authentication methods."},
@@ -565,6 +714,20 @@ valid_gmp_command (const char* name)
   return 0;
 }
 
+/**
+ * @brief Check whether a GMP command only reads.
+ *
+ * @param[in]  name  Command name.
+ *
+ * @return 1 yes, 0 no.
+ */
+int
+read_only_gmp_command (const char* name)
+{
+  return strncasecmp (name, "GET_", strlen ("GET_")) == 0
+         && valid_gmp_command (name);
+}
+
 /**
  * @brief Get the type associated with a GMP command.
  *
@@ -605,11 +768,13 @@ gmp_command_takes_resource (const char* name)
 {
   assert (name);
   return strcasecmp (name, "AUTHENTICATE")
+         && strcasecmp (name, "BATCH")
          && strcasestr (name, "CREATE_") != name
          && strcasestr (name, "DESCRIBE_") != name
          && strcasecmp (name, "EMPTY_TRASHCAN")
          && strcasecmp (name, "GET_VERSION")
          && strcasecmp (name, "HELP")
+         && strcasecmp (name, "LOGOUT")
          && strcasecmp (name, "RUN_WIZARD")
          && strcasestr (name, "SYNC_") != name;
 }
@@ -1025,6 +1190,124 @@ column_array_set (column_t *columns, const gchar *filter, gchar *select)
     }
 }
 
+/**
+ * @brief Get the modification time and content hash of a feed file.
+ *
+ * @param[in]   path   Full path to the file.
+ * @param[out]  mtime  Modification time.
+ * @param[out]  hash   SHA256 of the contents, or NULL to skip hashing.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+feed_file_state (const gchar *path, time_t *mtime, gchar **hash)
+{
+  GStatBuf state;
+  GError *error;
+  gchar *contents;
+  gsize length;
+
+  if (g_stat (path, &state))
+    {
+      g_warning ("%s: Failed to stat %s: %s",
+                 __func__, path, strerror (errno));
+      return -1;
+    }
+  *mtime = state.st_mtime;
+
+  if (hash == NULL)
+    return 0;
+
+  error = NULL;
+  if (g_file_get_contents (path, &contents, &length, &error) == FALSE)
+    {
+      g_warning ("%s: Failed to read %s: %s",
+                 __func__, path, error->message);
+      g_error_free (error);
+      return -1;
+    }
+  *hash = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                       (guchar *) contents, length);
+  g_free (contents);
+  return 0;
+}
+
+/**
+ * @brief Check whether a feed file has changed since it was last recorded.
+ *
+ * A file whose modification time matches the record is unchanged without
+ * reading it.  Otherwise the contents are hashed, so that a feed sync that
+ * only touches files does not cause them to be parsed again.
+ *
+ * @param[in]  path  Full path to the file.
+ *
+ * @return 1 changed or never recorded, 0 unchanged.
+ */
+int
+feed_file_changed (const gchar *path)
+{
+  gchar *quoted_path, *hash, *recorded_hash;
+  time_t mtime;
+  int changed;
+
+  if (feed_file_state (path, &mtime, NULL))
+    return 1;
+
+  quoted_path = sql_quote (path);
+  if (sql_int ("SELECT count (*) FROM feed_file_hashes"
+               " WHERE path = '%s' AND mtime = %lli;",
+               quoted_path, (long long) mtime))
+    {
+      g_free (quoted_path);
+      return 0;
+    }
+
+  recorded_hash = sql_string ("SELECT hash FROM feed_file_hashes"
+                              " WHERE path = '%s';",
+                              quoted_path);
+  if (recorded_hash == NULL
+      || feed_file_state (path, &mtime, &hash))
+    {
+      g_free (recorded_hash);
+      g_free (quoted_path);
+      return 1;
+    }
+
+  changed = strcmp (hash, recorded_hash);
+  if (changed == 0)
+    sql ("UPDATE feed_file_hashes SET mtime = %lli WHERE path = '%s';",
+         (long long) mtime, quoted_path);
+
+  g_free (hash);
+  g_free (recorded_hash);
+  g_free (quoted_path);
+  return changed ? 1 : 0;
+}
+
+/**
+ * @brief Record the current state of a feed file after syncing it.
+ *
+ * @param[in]  path  Full path to the file.
+ */
+void
+feed_file_record (const gchar *path)
+{
+  gchar *quoted_path, *hash;
+  time_t mtime;
+
+  if (feed_file_state (path, &mtime, &hash))
+    return;
+
+  quoted_path = sql_quote (path);
+  sql ("INSERT INTO feed_file_hashes (path, hash, mtime)"
+       " VALUES ('%s', '%s', %lli)"
+       " ON CONFLICT (path)"
+       " DO UPDATE SET hash = EXCLUDED.hash, mtime = EXCLUDED.mtime;",
+       quoted_path, hash, (long long) mtime);
+  g_free (quoted_path);
+  g_free (hash);
+}
+
 
 /* Filter utilities. */
 
@@ -1178,6 +1461,7 @@ parse_keyword (keyword_t* keyword)
           now = time (NULL);
           keyword->integer_value = now + atoi (keyword->string);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
         }
       else if (next == '\0' && *string == 'm')
         {
@@ -1185,6 +1469,7 @@ parse_keyword (keyword_t* keyword)
           now = time (NULL);
           keyword->integer_value = now + (atoi (keyword->string) * 60);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
         }
       else if (next == '\0' && *string == 'h')
         {
@@ -1192,6 +1477,7 @@ parse_keyword (keyword_t* keyword)
           now = time (NULL);
           keyword->integer_value = now + (atoi (keyword->string) * 3600);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
         }
       else if (next == '\0' && *string == 'd')
         {
@@ -1199,6 +1485,7 @@ parse_keyword (keyword_t* keyword)
           now = time (NULL);
           keyword->integer_value = now + (atoi (keyword->string) * 86400);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
         }
       else if (next == '\0' && *string == 'w')
         {
@@ -1206,6 +1493,7 @@ parse_keyword (keyword_t* keyword)
           now = time (NULL);
           keyword->integer_value = now + atoi (keyword->string) * 604800;
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
         }
       else if (next == '\0' && *string == 'M')
         {
@@ -1213,6 +1501,7 @@ parse_keyword (keyword_t* keyword)
           now = time (NULL);
           keyword->integer_value = add_months (now, atoi (keyword->string));
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
         }
       else if (next == '\0' && *string == 'y')
         {
@@ -1221,6 +1510,7 @@ parse_keyword (keyword_t* keyword)
           keyword->integer_value = add_months (now,
                                                atoi (keyword->string) * 12);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
         }
       // Add cases for t%H:%M although it is incorrect sometimes it is easier
       // to call filter.lower on the frontend then it can happen that the
@@ -1229,6 +1519,7 @@ parse_keyword (keyword_t* keyword)
         {
           keyword->integer_value = mktime (&date);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
           g_debug ("Parsed Y-m-dtH:M %s to timestamp %d.",
                    keyword->string, keyword->integer_value);
         }
@@ -1236,6 +1527,7 @@ parse_keyword (keyword_t* keyword)
         {
           keyword->integer_value = mktime (&date);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
           g_debug ("Parsed Y-m-dtHhM %s to timestamp %d.",
                    keyword->string, keyword->integer_value);
         }
@@ -1243,6 +1535,7 @@ parse_keyword (keyword_t* keyword)
         {
           keyword->integer_value = mktime (&date);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
           g_debug ("Parsed Y-m-dTH:M %s to timestamp %d.",
                    keyword->string, keyword->integer_value);
         }
@@ -1251,6 +1544,7 @@ parse_keyword (keyword_t* keyword)
         {
           keyword->integer_value = mktime (&date);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
           g_debug ("Parsed Y-m-dTHhM %s to timestamp %d.",
                    keyword->string, keyword->integer_value);
         }
@@ -1259,6 +1553,7 @@ parse_keyword (keyword_t* keyword)
         {
           keyword->integer_value = mktime (&date);
           keyword->type = KEYWORD_TYPE_INTEGER;
+          keyword->time = 1;
           g_debug ("Parsed Y-m-d %s to timestamp %d.",
                    keyword->string, keyword->integer_value);
         }
@@ -2572,6 +2867,45 @@ keyword_applies_to_column (keyword_t *keyword, const char* column)
   return 1;
 }
 
+/**
+ * @brief Append a semi-join on the tag membership of a resource.
+ *
+ * The set of tags is independent of the resource, so it is computed once
+ * and then matched against tag_resources, instead of searching the tags
+ * for every row.
+ *
+ * @param[in,out] clause      Buffer for the filter clause to append to.
+ * @param[in]  type           The resource type.
+ * @param[in]  tags_where     Condition on the tags table that selects tags.
+ * @param[in]  first_keyword  Whether keyword is first.
+ * @param[in]  last_was_and   Whether last keyword was "and".
+ * @param[in]  last_was_not   Whether last keyword was "not".
+ */
+static void
+filter_clause_append_tagged (GString *clause, const char *type,
+                             const char *tags_where, int first_keyword,
+                             int last_was_and, int last_was_not)
+{
+  g_string_append_printf
+     (clause,
+      "%s"
+      "(EXISTS"
+      "  (SELECT * FROM tag_resources"
+      "   WHERE tag_resources.resource_uuid = %ss.uuid"
+      "   AND tag_resources.resource_type = '%s'"
+      "   AND tag_resources.tag"
+      "       IN (SELECT tags.id FROM tags"
+      "           WHERE %s"
+      "           AND user_has_access_uuid (CAST ('tag' AS text),"
+      "                                     CAST (tags.uuid AS text),"
+      "                                     CAST ('get_tags' AS text),"
+      "                                     0))))",
+      get_join (first_keyword, last_was_and, last_was_not),
+      type,
+      type,
+      tags_where);
+}
+
 /**
  * @brief Append parts for a "tag" keyword to a filter clause.
  *
@@ -2589,6 +2923,7 @@ filter_clause_append_tag (GString *clause, keyword_t *keyword,
 {
   gchar *quoted_keyword;
   gchar **tag_split, *tag_name, *tag_value;
+  gchar *tags_where;
   int value_given;
 
   quoted_keyword = sql_quote (keyword->string);
@@ -2609,98 +2944,41 @@ filter_clause_append_tag (GString *clause, keyword_t *keyword,
   if (keyword->relation == KEYWORD_RELATION_COLUMN_EQUAL
       || keyword->relation == KEYWORD_RELATION_COLUMN_ABOVE
       || keyword->relation == KEYWORD_RELATION_COLUMN_BELOW)
-    {
-      g_string_append_printf
-         (clause,
-          "%s"
-          "(EXISTS"
-          "  (SELECT * FROM tags"
-          "   WHERE tags.name = '%s'"
-          "   AND tags.active != 0"
-          "   AND user_has_access_uuid (CAST ('tag' AS text),"
-          "                             CAST (tags.uuid AS text),"
-          "                             CAST ('get_tags' AS text),"
-          "                             0)"
-          "   AND EXISTS (SELECT * FROM tag_resources"
-          "                WHERE tag_resources.resource_uuid"
-          "                        = %ss.uuid"
-          "                  AND tag_resources.resource_type"
-          "                        = '%s'"
-          "                  AND tag = tags.id)"
-          "   %s%s%s))",
-          get_join (first_keyword, last_was_and,
-                    last_was_not),
-          tag_name,
-          type,
-          type,
-          (value_given
-            ? "AND tags.value = '"
-            : ""),
-          value_given ? tag_value : "",
-          (value_given
-            ? "'"
-            : ""));
-    }
+    tags_where = g_strdup_printf ("tags.name = '%s'"
+                                  " AND tags.active != 0"
+                                  "%s%s%s",
+                                  tag_name,
+                                  (value_given
+                                    ? " AND tags.value = '"
+                                    : ""),
+                                  value_given ? tag_value : "",
+                                  (value_given
+                                    ? "'"
+                                    : ""));
   else if (keyword->relation == KEYWORD_RELATION_COLUMN_APPROX)
-    {
-      g_string_append_printf
-         (clause,
-          "%s"
-          "(EXISTS"
-          "  (SELECT * FROM tags"
-          "   WHERE tags.name %s '%%%%%s%%%%'"
-          "   AND tags.active != 0"
-          "   AND user_has_access_uuid (CAST ('tag' AS text),"
-          "                             CAST (tags.uuid AS text),"
-          "                             CAST ('get_tags' AS text),"
-          "                             0)"
-          "   AND EXISTS (SELECT * FROM tag_resources"
-          "                WHERE tag_resources.resource_uuid"
-          "                        = %ss.uuid"
-          "                  AND tag_resources.resource_type"
-          "                        = '%s'"
-          "                  AND tag = tags.id)"
-          "   AND tags.value %s '%%%%%s%%%%'))",
-          get_join (first_keyword, last_was_and,
-                    last_was_not),
-          sql_ilike_op (),
-          tag_name,
-          type,
-          type,
-          sql_ilike_op (),
-          tag_value);
-    }
+    tags_where = g_strdup_printf ("tags.name %s '%%%%%s%%%%'"
+                                  " AND tags.active != 0"
+                                  " AND tags.value %s '%%%%%s%%%%'",
+                                  sql_ilike_op (),
+                                  tag_name,
+                                  sql_ilike_op (),
+                                  tag_value);
   else if (keyword->relation == KEYWORD_RELATION_COLUMN_REGEXP)
-    {
-      g_string_append_printf
-         (clause,
-          "%s"
-          "(EXISTS"
-          "  (SELECT * FROM tags"
-          "   WHERE tags.name %s '%s'"
-          "   AND tags.active != 0"
-          "   AND user_has_access_uuid (CAST ('tag' AS text),"
-          "                             CAST (tags.uuid AS text),"
-          "                             CAST ('get_tags' AS text),"
-          "                             0)"
-          "   AND EXISTS (SELECT * FROM tag_resources"
-          "                WHERE tag_resources.resource_uuid"
-          "                        = %ss.uuid"
-          "                  AND tag_resources.resource_type"
-          "                        = '%s'"
-          "                  AND tag = tags.id)"
-          "   AND tags.value"
-          "       %s '%s'))",
-          get_join (first_keyword, last_was_and,
-                    last_was_not),
-          sql_regexp_op (),
-          tag_name,
-          type,
-          type,
-          sql_regexp_op (),
-          tag_value);
-    }
+    tags_where = g_strdup_printf ("tags.name %s '%s'"
+                                  " AND tags.active != 0"
+                                  " AND tags.value %s '%s'",
+                                  sql_regexp_op (),
+                                  tag_name,
+                                  sql_regexp_op (),
+                                  tag_value);
+  else
+    tags_where = NULL;
+
+  if (tags_where)
+    filter_clause_append_tagged (clause, type, tags_where, first_keyword,
+                                 last_was_and, last_was_not);
 
+  g_free (tags_where);
   g_free (quoted_keyword);
   g_strfreev(tag_split);
   g_free(tag_name);
@@ -2722,94 +3000,38 @@ filter_clause_append_tag_id (GString *clause, keyword_t *keyword,
                              const char *type, int first_keyword,
                              int last_was_and, int last_was_not)
 {
-  gchar *quoted_keyword;
+  gchar *quoted_keyword, *tags_where;
 
   quoted_keyword = sql_quote (keyword->string);
 
   if (keyword->relation == KEYWORD_RELATION_COLUMN_EQUAL
       || keyword->relation == KEYWORD_RELATION_COLUMN_ABOVE
       || keyword->relation == KEYWORD_RELATION_COLUMN_BELOW)
-    {
-      g_string_append_printf
-         (clause,
-          "%s"
-          "(EXISTS"
-          "  (SELECT * FROM tags"
-          "   WHERE tags.uuid = '%s'"
-          "   AND user_has_access_uuid (CAST ('tag' AS text),"
-          "                             CAST (tags.uuid AS text),"
-          "                             CAST ('get_tags' AS text),"
-          "                             0)"
-          "   AND EXISTS (SELECT * FROM tag_resources"
-          "                WHERE tag_resources.resource_uuid"
-          "                        = %ss.uuid"
-          "                  AND tag_resources.resource_type"
-          "                        = '%s'"
-          "                  AND tag = tags.id)))",
-          get_join (first_keyword, last_was_and,
-                    last_was_not),
-          quoted_keyword,
-          type,
-          type);
-    }
+    tags_where = g_strdup_printf ("tags.uuid = '%s'",
+                                  quoted_keyword);
   else if (keyword->relation == KEYWORD_RELATION_COLUMN_APPROX)
-    {
-      g_string_append_printf
-         (clause,
-          "%s"
-          "(EXISTS"
-          "  (SELECT * FROM tags"
-          "   WHERE tags.uuid %s '%%%%%s%%%%'"
-          "   AND tags.active != 0"
-          "   AND user_has_access_uuid (CAST ('tag' AS text),"
-          "                             CAST (tags.uuid AS text),"
-          "                             CAST ('get_tags' AS text),"
-          "                             0)"
-          "   AND EXISTS (SELECT * FROM tag_resources"
-          "                WHERE tag_resources.resource_uuid"
-          "                        = %ss.uuid"
-          "                  AND tag_resources.resource_type"
-          "                        = '%s'"
-          "                  AND tag = tags.id)))",
-          get_join (first_keyword, last_was_and,
-                    last_was_not),
-          sql_ilike_op (),
-          quoted_keyword,
-          type,
-          type);
-    }
+    tags_where = g_strdup_printf ("tags.uuid %s '%%%%%s%%%%'"
+                                  " AND tags.active != 0",
+                                  sql_ilike_op (),
+                                  quoted_keyword);
   else if (keyword->relation == KEYWORD_RELATION_COLUMN_REGEXP)
-    {
-      g_string_append_printf
-         (clause,
-          "%s"
-          "(EXISTS"
-          "  (SELECT * FROM tags"
-          "   WHERE tags.uuid %s '%s'"
-          "   AND tags.active != 0"
-          "   AND user_has_access_uuid (CAST ('tag' AS text),"
-          "                             CAST (tags.uuid AS text),"
-          "                             CAST ('get_tags' AS text),"
-          "                             0)"
-          "   AND EXISTS (SELECT * FROM tag_resources"
-          "                WHERE tag_resources.resource_uuid"
-          "                        = %ss.uuid"
-          "                  AND tag_resources.resource_type"
-          "                        = '%s'"
-          "                  AND tag = tags.id)))",
-          get_join (first_keyword, last_was_and,
-                    last_was_not),
-          sql_regexp_op (),
-          quoted_keyword,
-          type,
-          type);
-    }
+    tags_where = g_strdup_printf ("tags.uuid %s '%s'"
+                                  " AND tags.active != 0",
+                                  sql_regexp_op (),
+                                  quoted_keyword);
+  else
+    tags_where = NULL;
+
+  if (tags_where)
+    filter_clause_append_tagged (clause, type, tags_where, first_keyword,
+                                 last_was_and, last_was_not);
 
+  g_free (tags_where);
   g_free (quoted_keyword);
 }
 
 /**
- * @brief Return SQL WHERE clause for restricting a SELECT to a filter term.
+ * @brief Build SQL WHERE clause for restricting a SELECT to a filter term.
  *
  * @param[in]  type     Resource type.
  * @param[in]  filter   Filter term.
@@ -2819,18 +3041,18 @@ filter_clause_append_tag_id (GString *clause, keyword_t *keyword,
  * @param[out] trash           Whether the trash table is being queried.
  * @param[out] order_return  If given then order clause.
  * @param[out] first_return  If given then first row.
- * @param[out] max_return    If given then max rows.
+ * @param[out] max_return    If given then max rows, as given in the filter.
  * @param[out] permissions   When given then permissions string vector.
  * @param[out] owner_filter  When given then value of owner keyword.
  *
  * @return WHERE clause for filter if one is required, else NULL.
  */
-gchar *
-filter_clause (const char* type, const char* filter,
-               const char **filter_columns, column_t *select_columns,
-               column_t *where_columns, int trash, gchar **order_return,
-               int *first_return, int *max_return, array_t **permissions,
-               gchar **owner_filter)
+static gchar *
+filter_clause_build (const char* type, const char* filter,
+                     const char **filter_columns, column_t *select_columns,
+                     column_t *where_columns, int trash, gchar **order_return,
+                     int *first_return, int *max_return,
+                     array_t **permissions, gchar **owner_filter)
 {
   GString *clause, *order;
   keyword_t **point;
@@ -3327,6 +3549,20 @@ filter_clause (const char* type, const char* filter,
           point++;
           continue;
         }
+      else if (keyword->column
+               && (strcasecmp (keyword->column, "after") == 0))
+        {
+          /* Keyset pagination, handled by init_get_iterator2_with. */
+          point++;
+          continue;
+        }
+      else if (keyword->column
+               && (strcasecmp (keyword->column, "count_estimate") == 0))
+        {
+          /* Estimated counts, handled by count2. */
+          point++;
+          continue;
+        }
       else if (keyword->column
                && (strcasecmp (keyword->column, "permission") == 0))
         {
@@ -3797,40 +4033,51 @@ filter_clause (const char* type, const char* filter,
                                           (index ? " AND " : ""));
               }
           else
-            for (index = 0;
-                 (filter_column = filter_columns[index]) != NULL;
-                 index++)
-              {
-                gchar *select_column;
-                keyword_type_t column_type;
-                int column_type_matches = 0;
-
-                select_column = columns_select_column_with_type (select_columns,
-                                                                 where_columns,
-                                                                 filter_column,
-                                                                 &column_type);
-                if (column_type != KEYWORD_TYPE_INTEGER
-                    && column_type != KEYWORD_TYPE_DOUBLE)
-                  column_type_matches = 1;
+            {
+              GHashTable *searched;
 
-                if (keyword_applies_to_column (keyword, filter_column)
-                    && select_column && column_type_matches)
-                  g_string_append_printf (clause,
-                                          "%sCAST (%s AS TEXT)"
-                                          " %s '%s%s%s'",
-                                          (index ? " OR " : ""),
-                                          select_column,
-                                          last_was_re
-                                           ? sql_regexp_op ()
-                                           : sql_ilike_op (),
-                                          last_was_re ? "" : "%%",
-                                          quoted_keyword,
-                                          last_was_re ? "" : "%%");
-                else
-                  g_string_append_printf (clause,
-                                          "%snot t ()",
-                                          (index ? " OR " : ""));
-              }
+              /* Several filter columns may select the same expression, like
+               * the NVT name of a result.  Match each expression once. */
+              searched = g_hash_table_new (g_str_hash, g_str_equal);
+              for (index = 0;
+                   (filter_column = filter_columns[index]) != NULL;
+                   index++)
+                {
+                  gchar *select_column;
+                  keyword_type_t column_type;
+                  int column_type_matches = 0;
+
+                  select_column
+                    = columns_select_column_with_type (select_columns,
+                                                       where_columns,
+                                                       filter_column,
+                                                       &column_type);
+                  if (column_type != KEYWORD_TYPE_INTEGER
+                      && column_type != KEYWORD_TYPE_DOUBLE)
+                    column_type_matches = 1;
+
+                  if (keyword_applies_to_column (keyword, filter_column)
+                      && select_column && column_type_matches
+                      && g_hash_table_add (searched, select_column))
+                    g_string_append_printf
+                     (clause,
+                      "%sCAST (%s AS TEXT)"
+                      " %s '%s%s%s'",
+                      (index ? " OR " : ""),
+                      select_column,
+                      last_was_re
+                       ? sql_regexp_op ()
+                       : sql_ilike_op (),
+                      last_was_re ? "" : "%%",
+                      quoted_keyword,
+                      last_was_re ? "" : "%%");
+                  else
+                    g_string_append_printf (clause,
+                                            "%snot t ()",
+                                            (index ? " OR " : ""));
+                }
+              g_hash_table_destroy (searched);
+            }
         }
 
       if (skip == 0)
@@ -3851,8 +4098,240 @@ filter_clause (const char* type, const char* filter,
   else
     g_string_free (order, TRUE);
 
+  if (strlen (clause->str))
+    return g_string_free (clause, FALSE);
+  g_string_free (clause, TRUE);
+  return NULL;
+}
+
+/**
+ * @brief Maximum number of entries in the filter clause cache.
+ */
+#define FILTER_CLAUSE_CACHE_MAX 64
+
+/**
+ * @brief Cached result of filter_clause_build.
+ */
+typedef struct
+{
+  gchar *clause;         ///< WHERE clause, or NULL.
+  gchar *order;          ///< Order clause.
+  int first;             ///< First row, or -1 if filter had none.
+  int max;               ///< Max rows as given in the filter.
+  array_t *permissions;  ///< Permissions.
+  gchar *owner_filter;   ///< Value of owner keyword.
+} filter_clause_cache_t;
+
+/**
+ * @brief Cache of filter clauses, keyed by filter_clause_cache_key.
+ */
+static GHashTable *filter_clause_cache = NULL;
+
+/**
+ * @brief Free a filter clause cache entry.
+ *
+ * @param[in]  data  Entry.
+ */
+static void
+filter_clause_cache_free (gpointer data)
+{
+  filter_clause_cache_t *entry;
+
+  entry = data;
+  g_free (entry->clause);
+  g_free (entry->order);
+  array_free (entry->permissions);
+  g_free (entry->owner_filter);
+  g_free (entry);
+}
+
+/**
+ * @brief Append columns to a filter clause cache key.
+ *
+ * @param[in]  key      Key.
+ * @param[in]  columns  Columns, or NULL.
+ */
+static void
+filter_clause_cache_key_columns (GString *key, column_t *columns)
+{
+  if (columns)
+    for (; columns->select; columns++)
+      g_string_append_printf (key, "%s\t%s\t%i\n",
+                              columns->select,
+                              columns->filter ? columns->filter : "",
+                              columns->type);
+  g_string_append_c (key, '\f');
+}
+
+/**
+ * @brief Clear the filter clause cache.
+ *
+ * Called when the process starts serving another client, so that nothing
+ * resolved for one user is served to the next.
+ */
+static void
+filter_clause_cache_clear ()
+{
+  if (filter_clause_cache)
+    g_hash_table_remove_all (filter_clause_cache);
+}
+
+/**
+ * @brief Check whether a filter has a date or time keyword.
+ *
+ * Such keywords are resolved against the current time and the time zone of
+ * the session, so their clauses must not be cached.
+ *
+ * @param[in]  filter  Filter term.
+ *
+ * @return 1 if the filter has a date or time keyword, else 0.
+ */
+static int
+filter_has_time_keyword (const char *filter)
+{
+  array_t *split;
+  keyword_t **point;
+  int ret;
+
+  ret = 0;
+  split = split_filter (filter);
+  point = (keyword_t**) split->pdata;
+  while (*point)
+    {
+      if ((*point)->time)
+        {
+          ret = 1;
+          break;
+        }
+      point++;
+    }
+  filter_free (split);
+  return ret;
+}
+
+/**
+ * @brief Build the key of a filter clause.
+ *
+ * The key holds everything that filter_clause_build depends on.  The
+ * columns are included by content, because callers build the same column
+ * arrays on the stack for every call.  The time zone is included too,
+ * although filters with dates are not cached at all.
+ *
+ * @param[in]  type     Resource type.
+ * @param[in]  filter   Filter term.
+ * @param[in]  filter_columns  Filter columns.
+ * @param[in]  select_columns  SELECT columns.
+ * @param[in]  where_columns   Columns in SQL that only appear in WHERE clause.
+ * @param[in]  trash           Whether the trash table is being queried.
+ *
+ * @return Freshly allocated key.
+ */
+static gchar *
+filter_clause_cache_key (const char* type, const char* filter,
+                         const char **filter_columns,
+                         column_t *select_columns, column_t *where_columns,
+                         int trash)
+{
+  GString *key;
+
+  key = g_string_new ("");
+  g_string_append_printf (key, "%s\n%s\n%i %i\n%s\n",
+                          type ? type : "",
+                          filter,
+                          trash,
+                          table_order_if_sort_not_specified,
+                          getenv ("TZ") ? getenv ("TZ") : "");
+  if (filter_columns)
+    for (; *filter_columns; filter_columns++)
+      g_string_append_printf (key, "%s\n", *filter_columns);
+  g_string_append_c (key, '\f');
+  filter_clause_cache_key_columns (key, select_columns);
+  filter_clause_cache_key_columns (key, where_columns);
+  return g_string_free (key, FALSE);
+}
+
+/**
+ * @brief Return SQL WHERE clause for restricting a SELECT to a filter term.
+ *
+ * The parsed and generated clauses are cached, because list requests
+ * repeat the same few filters with the same columns.  Filters with date or
+ * time keywords are built every time, because their clauses depend on the
+ * current time.
+ *
+ * @param[in]  type     Resource type.
+ * @param[in]  filter   Filter term.
+ * @param[in]  filter_columns  Filter columns.
+ * @param[in]  select_columns  SELECT columns.
+ * @param[in]  where_columns   Columns in SQL that only appear in WHERE clause.
+ * @param[out] trash           Whether the trash table is being queried.
+ * @param[out] order_return  If given then order clause.
+ * @param[out] first_return  If given then first row.
+ * @param[out] max_return    If given then max rows.
+ * @param[out] permissions   When given then permissions string vector.
+ * @param[out] owner_filter  When given then value of owner keyword.
+ *
+ * @return WHERE clause for filter if one is required, else NULL.
+ */
+gchar *
+filter_clause (const char* type, const char* filter,
+               const char **filter_columns, column_t *select_columns,
+               column_t *where_columns, int trash, gchar **order_return,
+               int *first_return, int *max_return, array_t **permissions,
+               gchar **owner_filter)
+{
+  filter_clause_cache_t *entry;
+  gchar *key, *clause;
+  int uncached;
+
+  if (filter == NULL)
+    filter = "";
+
+  while (*filter && isspace (*filter)) filter++;
+
+  if (filter_clause_cache == NULL)
+    filter_clause_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free,
+                                                 filter_clause_cache_free);
+
+  key = filter_clause_cache_key (type, filter, filter_columns,
+                                 select_columns, where_columns, trash);
+  entry = g_hash_table_lookup (filter_clause_cache, key);
+  uncached = 0;
+  if (entry)
+    g_free (key);
+  else
+    {
+      entry = g_malloc0 (sizeof (*entry));
+      entry->first = -1;
+      entry->clause = filter_clause_build (type, filter, filter_columns,
+                                           select_columns, where_columns,
+                                           trash, &entry->order,
+                                           &entry->first, &entry->max,
+                                           &entry->permissions,
+                                           &entry->owner_filter);
+      if (filter_has_time_keyword (filter))
+        {
+          g_free (key);
+          uncached = 1;
+        }
+      else
+        {
+          if (g_hash_table_size (filter_clause_cache)
+              >= FILTER_CLAUSE_CACHE_MAX)
+            g_hash_table_remove_all (filter_clause_cache);
+          g_hash_table_insert (filter_clause_cache, key, entry);
+        }
+    }
+
+  if (order_return)
+    *order_return = g_strdup (entry->order);
+
+  if (first_return && entry->first >= 0)
+    *first_return = entry->first;
+
   if (max_return)
     {
+      *max_return = entry->max;
       if (*max_return == -2)
         setting_value_int (SETTING_UUID_ROWS_PER_PAGE, max_return);
       else if (*max_return < 1)
@@ -3861,10 +4340,23 @@ filter_clause (const char* type, const char* filter,
       *max_return = manage_max_rows (*max_return);
     }
 
-  if (strlen (clause->str))
-    return g_string_free (clause, FALSE);
-  g_string_free (clause, TRUE);
-  return NULL;
+  if (permissions)
+    {
+      guint index;
+
+      *permissions = make_array ();
+      for (index = 0; index < entry->permissions->len; index++)
+        array_add (*permissions,
+                   g_strdup (g_ptr_array_index (entry->permissions, index)));
+    }
+
+  if (owner_filter)
+    *owner_filter = g_strdup (entry->owner_filter);
+
+  clause = g_strdup (entry->clause);
+  if (uncached)
+    filter_clause_cache_free (entry);
+  return clause;
 }
 
 
@@ -4108,7 +4600,7 @@ type_trash_in_table (const char *type)
 gboolean
 find_resource (const char* type, const char* uuid, resource_t* resource)
 {
-  gchar *quoted_uuid;
+  gchar *quoted_uuid, *sql;
   quoted_uuid = sql_quote (uuid);
   if (acl_user_owns_uuid (type, quoted_uuid, 0) == 0)
     {
@@ -4116,12 +4608,12 @@ find_resource (const char* type, const char* uuid, resource_t* resource)
       *resource = 0;
       return FALSE;
     }
+  g_free (quoted_uuid);
   // TODO should really check type
-  switch (sql_int64 (resource,
-                     "SELECT id FROM %ss WHERE uuid = '%s'%s;",
-                     type,
-                     quoted_uuid,
-                     strcmp (type, "task") ? "" : " AND hidden < 2"))
+  sql = g_strdup_printf ("SELECT id FROM %ss WHERE uuid = $1%s;",
+                         type,
+                         strcmp (type, "task") ? "" : " AND hidden < 2");
+  switch (sql_int64_ps (resource, sql, SQL_STR_PARAM (uuid), NULL))
     {
       case 0:
         break;
@@ -4131,12 +4623,12 @@ find_resource (const char* type, const char* uuid, resource_t* resource)
       default:       /* Programming error. */
         assert (0);
       case -1:
-        g_free (quoted_uuid);
+        g_free (sql);
         return TRUE;
         break;
     }
 
-  g_free (quoted_uuid);
+  g_free (sql);
   return FALSE;
 }
 
@@ -4756,8 +5248,10 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
 {
   int first, max;
   gchar *clause, *order, *filter, *owned_clause, *with_clause;
+  gchar *keyset_clause, *after_uuid;
+  int keyset;
   array_t *permissions;
-  resource_t resource = 0;
+  resource_t resource = 0, after = 0;
   gchar *owner_filter;
   gchar *columns;
 
@@ -4839,6 +5333,24 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
                           get->trash, &order, &first, &max, &permissions,
                           &owner_filter);
 
+  /* Keyset pagination: "after=" with the token of the last row of the
+   * previous page, or empty for the first page. */
+  after_uuid = NULL;
+  keyset = (resource || get->trash)
+            ? 0
+            : filter_term_after (filter ? filter : get->filter, &after,
+                                 &after_uuid);
+  if (keyset < 0)
+    {
+      g_warning ("%s: invalid after token in filter", __func__);
+      g_free (filter);
+      g_free (clause);
+      g_free (order);
+      g_free (owner_filter);
+      array_free (permissions);
+      return -1;
+    }
+
   g_free (filter);
 
   with_clause = NULL;
@@ -4895,6 +5407,31 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
       order = NULL;
     }
 
+  keyset_clause = NULL;
+  if (keyset)
+    {
+      /* Page in row order, starting after the given row, so that deep
+       * pages do not have to skip over the preceding rows. */
+      g_free (order);
+      order = g_strdup_printf (" ORDER BY %ss.id ASC", type);
+      extra_order = NULL;
+      first = 0;
+      if (after_uuid)
+        {
+          gchar *quoted_uuid;
+
+          /* Go by the row when it still exists.  The row id in the token
+           * only matters if the row was deleted, so that deleting it does
+           * not restart the listing. */
+          quoted_uuid = sql_quote (after_uuid);
+          sql_int64 (&after, "SELECT id FROM %ss WHERE uuid = '%s';",
+                     type, quoted_uuid);
+          g_free (quoted_uuid);
+          g_free (after_uuid);
+          keyset_clause = g_strdup_printf (" AND %ss.id > %llu", type, after);
+        }
+    }
+
   if (resource && get->trash)
     init_iterator (iterator,
                    "%sSELECT %s"
@@ -4952,7 +5489,7 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
                    "%s%sSELECT %s"
                    " FROM %ss %s"
                    " WHERE"
-                   " %s%s%s%s%s%s%s"
+                   " %s%s%s%s%s%s%s%s"
                    " LIMIT %s OFFSET %i%s;",
                    with_clause ? with_clause : "",
                    distinct ? "SELECT DISTINCT * FROM (" : "",
@@ -4964,6 +5501,7 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
                    clause ? clause : "",
                    clause ? ")" : "",
                    extra_where ? extra_where : "",
+                   keyset_clause ? keyset_clause : "",
                    order ? order : "",
                    order ? (extra_order ? extra_order : "") : "",
                    sql_select_limit (max),
@@ -4975,6 +5513,7 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
   g_free (owned_clause);
   g_free (order);
   g_free (clause);
+  g_free (keyset_clause);
   return 0;
 }
 
@@ -5103,6 +5642,191 @@ append_column (GArray *columns, const gchar *column_name,
     }
 }
 
+/**
+ * @brief Check whether a filter only has keywords the rollups support.
+ *
+ * @param[in]  filter  Filter term.
+ *
+ * @return 1 if the filter only selects by QoD and overrides, else 0.
+ */
+static int
+filter_allows_result_rollup (const gchar *filter)
+{
+  static const char *allowed[] = { "apply_overrides", "min_qod", "first",
+                                   "rows", "sort", "sort-reverse", "after",
+                                   "count_estimate", NULL };
+  keyword_t **point;
+  array_t *split;
+  int ret;
+
+  if (filter == NULL)
+    return 1;
+
+  ret = 1;
+  split = split_filter (filter);
+  for (point = (keyword_t**) split->pdata; *point && ret; point++)
+    {
+      keyword_t *keyword;
+      const char **column;
+
+      keyword = *point;
+      if (keyword->column == NULL)
+        {
+          if (strlen (keyword->string))
+            ret = 0;
+          continue;
+        }
+
+      ret = 0;
+      for (column = allowed; *column; column++)
+        if (strcasecmp (keyword->column, *column) == 0)
+          {
+            ret = 1;
+            break;
+          }
+    }
+  filter_free (split);
+  return ret;
+}
+
+/**
+ * @brief Initialise a result severity aggregate from the report counts.
+ *
+ * The report count cache is a rollup of the results of each report by
+ * severity, for each user, override setting and minimum QoD.  When a
+ * GET_AGGREGATES of results only groups by severity and the filter only
+ * selects by QoD and overrides, the aggregate is the sum of these counts
+ * over the reports the user may see, which avoids scanning all results.
+ *
+ * @param[in]  iterator        Iterator.
+ * @param[in]  get             GET data.
+ * @param[in]  sort_data       GArray of sorting data.
+ * @param[in]  first_group     Row number to start iterating from.
+ * @param[in]  max_groups      Maximum number of rows.
+ *
+ * @return 0 iterator initialised, 1 rollup cannot answer the aggregate,
+ *         2 failed to find filter.
+ */
+static int
+init_result_severity_rollup_iterator (iterator_t* iterator,
+                                      const get_data_t *get,
+                                      GArray *sort_data,
+                                      int first_group, int max_groups)
+{
+  gchar *filter, *owned_clause, *with_clause, *quoted_uuid;
+  GString *order_clause;
+  int apply_overrides, min_qod, sort_index;
+
+  if (current_credentials.uuid == NULL
+      || strlen (current_credentials.uuid) == 0
+      || get->trash)
+    return 1;
+
+  if (get->filt_id && strcmp (get->filt_id, FILT_ID_NONE))
+    {
+      filter = filter_term (get->filt_id);
+      if (filter == NULL)
+        return 2;
+    }
+  else
+    filter = g_strdup (get->filter);
+
+  if (filter_allows_result_rollup (filter) == 0)
+    {
+      g_free (filter);
+      return 1;
+    }
+
+  apply_overrides = filter_term_apply_overrides (filter);
+  min_qod = filter_term_min_qod (filter);
+  g_free (filter);
+
+  with_clause = NULL;
+  owned_clause = acl_where_owned ("report", get, 1, NULL, 0, NULL, 0,
+                                  &with_clause);
+  quoted_uuid = sql_quote (current_credentials.uuid);
+
+  /* Fall back to the live query if any of the reports has no counts. */
+  if (sql_int ("%sSELECT EXISTS"
+               " (SELECT * FROM reports"
+               "  WHERE %s"
+               "  AND (SELECT hidden FROM tasks WHERE tasks.id = task) = 0"
+               "  AND NOT EXISTS"
+               "       (SELECT * FROM report_counts"
+               "        WHERE report = reports.id"
+               "        AND \"user\" = (SELECT id FROM users"
+               "                      WHERE uuid = '%s')"
+               "        AND override = %i"
+               "        AND min_qod = %i"
+               "        AND (end_time = 0 OR end_time >= m_now ())));",
+               with_clause ? with_clause : "",
+               owned_clause,
+               quoted_uuid,
+               apply_overrides,
+               min_qod))
+    {
+      g_free (with_clause);
+      g_free (owned_clause);
+      g_free (quoted_uuid);
+      return 1;
+    }
+
+  order_clause = g_string_new ("");
+  for (sort_index = 0;
+       sort_data && sort_index < sort_data->len;
+       sort_index++)
+    {
+      sort_data_t *sort_data_item;
+
+      sort_data_item = g_array_index (sort_data, sort_data_t*, sort_index);
+      g_string_append_printf (order_clause,
+                              "%s %s %s",
+                              sort_index ? "," : " ORDER BY",
+                              (sort_data_item->stat
+                               && strcmp (sort_data_item->stat, "count") == 0)
+                                ? "outer_count"
+                                : "outer_group_column",
+                              sort_data_item->order ? "ASC" : "DESC");
+    }
+  if (sort_data && sort_data->len == 0)
+    g_string_append (order_clause, " ORDER BY outer_group_column ASC");
+
+  init_iterator (iterator,
+                 "%sSELECT sum (count) AS outer_count,"
+                 " severity AS outer_group_column,"
+                 " CAST (NULL AS TEXT) AS outer_subgroup_column"
+                 " FROM report_counts"
+                 " WHERE \"user\" = (SELECT id FROM users WHERE uuid = '%s')"
+                 " AND override = %i"
+                 " AND min_qod = %i"
+                 " AND (end_time = 0 OR end_time >= m_now ())"
+                 " AND severity != " G_STRINGIFY (SEVERITY_MISSING)
+                 " AND severity != " G_STRINGIFY (SEVERITY_ERROR)
+                 " AND report IN (SELECT id FROM reports"
+                 "                WHERE %s"
+                 "                AND (SELECT hidden FROM tasks"
+                 "                     WHERE tasks.id = task)"
+                 "                    = 0)"
+                 " GROUP BY severity"
+                 " HAVING sum (count) > 0"
+                 "%s"
+                 " LIMIT %s OFFSET %d;",
+                 with_clause ? with_clause : "",
+                 quoted_uuid,
+                 apply_overrides,
+                 min_qod,
+                 owned_clause,
+                 order_clause->str,
+                 sql_select_limit (max_groups),
+                 first_group);
+
+  g_string_free (order_clause, TRUE);
+  g_free (with_clause);
+  g_free (owned_clause);
+  g_free (quoted_uuid);
+  return 0;
+}
+
 /**
  * @brief Initialise a GET_AGGREGATES iterator, including observed resources.
  *
@@ -5177,6 +5901,26 @@ init_aggregate_iterator (iterator_t* iterator, const char *type,
   if (get->trash && type_has_trash (type) == 0)
     return 6;
 
+  if (strcmp (type, "result") == 0
+      && group_column
+      && strcmp (group_column, "severity") == 0
+      && (subgroup_column == NULL || strcmp (subgroup_column, "") == 0)
+      && (data_columns == NULL || data_columns->len == 0)
+      && (text_columns == NULL || text_columns->len == 0)
+      && distinct == 0
+      && extra_tables == NULL
+      && given_extra_where == NULL)
+    switch (init_result_severity_rollup_iterator (iterator, get, sort_data,
+                                                  first_group, max_groups))
+      {
+        case 0:
+          return 0;
+        case 2:
+          return 2;
+        default:
+          break;
+      }
+
   if (data_columns && data_columns->len > 0)
     {
       int i;
@@ -5653,9 +6397,39 @@ aggregate_iterator_subgroup_value (iterator_t* iterator)
   return ret;
 }
 
+/**
+ * @brief Check whether a GET asks for estimated counts.
+ *
+ * Estimated counts are selected by "count_estimate=1" in the filter.
+ *
+ * @param[in]  get  GET params.
+ *
+ * @return 1 if counts may be estimated, else 0.
+ */
+static int
+count_estimated (const get_data_t *get)
+{
+  gchar *filter, *value;
+  int ret;
+
+  if (get->filt_id && strcmp (get->filt_id, FILT_ID_NONE))
+    filter = filter_term (get->filt_id);
+  else
+    filter = NULL;
+
+  value = filter_term_value (filter ? filter : get->filter, "count_estimate");
+  ret = value && atoi (value);
+  g_free (value);
+  g_free (filter);
+  return ret;
+}
+
 /**
  * @brief Count number of a particular resource.
  *
+ * With "count_estimate=1" in the filter the count is the planner's
+ * estimate, which avoids scanning the whole filtered set.
+ *
  * @param[in]  type              Type of resource.
  * @param[in]  get               GET params.
  * @param[in]  select_columns    SELECT columns.
@@ -5735,11 +6509,38 @@ count2 (const char *type, const get_data_t *get, column_t *select_columns,
   else
     columns = columns_build_select (select_columns);
 
-  if ((distinct == 0)
-      && (extra_tables == NULL)
-      && (clause == NULL)
-      && (extra_where == NULL)
-      && (strcmp (owned_clause, " t ()") == 0))
+  if (count_estimated (get))
+    {
+      gchar *query, *quoted_query;
+
+      query = g_strdup_printf ("%sSELECT %s%ss%s.id"
+                               " FROM %ss%s%s"
+                               " WHERE %s"
+                               " %s%s%s%s",
+                               with ? with : "",
+                               distinct ? "DISTINCT " : "",
+                               type,
+                               get->trash && strcmp (type, "task")
+                                ? "_trash" : "",
+                               type,
+                               get->trash && strcmp (type, "task")
+                                ? "_trash" : "",
+                               extra_tables ? extra_tables : "",
+                               owned_clause,
+                               clause ? " AND (" : "",
+                               clause ? clause : "",
+                               clause ? ") " : "",
+                               extra_where ? extra_where : "");
+      quoted_query = sql_quote (query);
+      g_free (query);
+      ret = sql_int ("SELECT count_estimate ('%s');", quoted_query);
+      g_free (quoted_query);
+    }
+  else if ((distinct == 0)
+           && (extra_tables == NULL)
+           && (clause == NULL)
+           && (extra_where == NULL)
+           && (strcmp (owned_clause, " t ()") == 0))
     ret = sql_int ("%sSELECT count (*) FROM %ss%s;",
                    with ? with : "", type,
                    get->trash && strcmp (type, "task") ? "_trash" : "");
@@ -6009,7 +6810,7 @@ encrypt_all_credentials (gboolean decrypt_flag)
 
       if (secret)
         {
-          lsc_crypt_flush (iterator.crypt_ctx);
+          lsc_crypt_reset (iterator.crypt_ctx);
           password = lsc_crypt_get_password (iterator.crypt_ctx, secret);
           privkey  = lsc_crypt_get_private_key (iterator.crypt_ctx, secret);
 
@@ -14346,6 +15147,258 @@ condition_met (task_t task, report_t report, alert_t alert,
   return 0;
 }
 
+
+/* Alert queue. */
+
+/**
+ * @brief Queue an alert for the alert workers.
+ *
+ * The report is fixed when the alert is queued, so that the alert sends the
+ * report of the event even if the task has a newer report by the time the
+ * alert runs.
+ *
+ * @param[in]  alert       Alert.
+ * @param[in]  task        Task.
+ * @param[in]  report      Report.  0 for most recent report.
+ * @param[in]  event       Event.
+ * @param[in]  event_data  Event data.
+ */
+static void
+queue_alert (alert_t alert, task_t task, report_t report, event_t event,
+             const void *event_data)
+{
+  gchar *data, *owner_uuid, *owner_name;
+
+  if (event == EVENT_TASK_RUN_STATUS_CHANGED)
+    data = g_strdup_printf ("'%i'", GPOINTER_TO_INT (event_data));
+  else if (event == EVENT_NEW_SECINFO || event == EVENT_UPDATED_SECINFO)
+    data = sql_insert (event_data);
+  else
+    data = g_strdup ("NULL");
+  owner_uuid = sql_insert (current_credentials.uuid);
+  owner_name = sql_insert (current_credentials.username);
+
+  if (report == 0 && task && event == EVENT_TASK_RUN_STATUS_CHANGED)
+    sql_int64 (&report,
+               "SELECT coalesce (max (id), 0) FROM reports WHERE task = %llu;",
+               task);
+
+  sql ("INSERT INTO alert_queue"
+       " (alert, method, event, event_data, task, report, owner_uuid,"
+       "  owner_name, worker, attempts, next_time, creation_time)"
+       " SELECT id, method, %i, %s, %llu, %llu, %s, %s, -1, 0, m_now (),"
+       "        m_now ()"
+       " FROM alerts WHERE id = %llu;",
+       event, data, task, report, owner_uuid, owner_name, alert);
+
+  g_debug ("%s: queued alert %llu for event %i", __func__, alert, event);
+  g_free (data);
+  g_free (owner_uuid);
+  g_free (owner_name);
+}
+
+/**
+ * @brief Take the next due alert from the alert queue.
+ *
+ * Skips alerts whose method already has the maximum number of alerts
+ * running.
+ *
+ * @param[in]  index  Index of the alert worker.
+ *
+ * @return Row ID of the queued alert, 0 if none is due.
+ */
+static resource_t
+alert_queue_take (int index)
+{
+  resource_t job;
+
+  sql_begin_immediate ();
+  /* Serialise the workers, so that the method counts stay accurate. */
+  sql ("LOCK TABLE alert_queue IN SHARE ROW EXCLUSIVE MODE;");
+  job = 0;
+  switch (sql_int64 (&job,
+                     "UPDATE alert_queue"
+                     " SET worker = %i, attempts = attempts + 1"
+                     " WHERE id = (SELECT id FROM alert_queue AS queued"
+                     "             WHERE worker = -1"
+                     "             AND next_time <= m_now ()"
+                     "             AND (%i = 0"
+                     "                  OR (SELECT count (*)"
+                     "                      FROM alert_queue AS running"
+                     "                      WHERE running.worker >= 0"
+                     "                      AND running.method"
+                     "                          = queued.method)"
+                     "                     < %i)"
+                     "             ORDER BY next_time, id"
+                     "             LIMIT 1)"
+                     " RETURNING id;",
+                     index,
+                     alert_method_workers,
+                     alert_method_workers))
+    {
+      case 0:
+        break;
+      case 1:        /* Too few rows in result of query. */
+        job = 0;
+        break;
+      default:       /* Programming error. */
+        assert (0);
+      case -1:
+        job = 0;
+        break;
+    }
+  sql_commit ();
+  return job;
+}
+
+/**
+ * @brief Run an alert from the alert queue, as the user who caused it.
+ *
+ * Removes the alert from the queue when it succeeds, when it fails because
+ * of its configuration, or when it has run out of attempts.  Otherwise
+ * queues it again after a delay that grows with each attempt.
+ *
+ * @param[in]  job  Row ID of the queued alert.
+ */
+static void
+alert_queue_run (resource_t job)
+{
+  iterator_t jobs;
+  alert_t alert;
+  task_t task;
+  report_t report;
+  event_t event;
+  gchar *event_data, *owner_uuid, *owner_name;
+  const void *data;
+  int attempts, ret;
+
+  init_iterator (&jobs,
+                 "SELECT alert, task, report, event, event_data, owner_uuid,"
+                 "       owner_name, attempts"
+                 " FROM alert_queue WHERE id = %llu;",
+                 job);
+  if (next (&jobs) == FALSE)
+    {
+      /* The alert was deleted. */
+      cleanup_iterator (&jobs);
+      return;
+    }
+  alert = iterator_int64 (&jobs, 0);
+  task = iterator_int64 (&jobs, 1);
+  report = iterator_int64 (&jobs, 2);
+  event = iterator_int (&jobs, 3);
+  event_data = g_strdup (iterator_string (&jobs, 4));
+  owner_uuid = g_strdup (iterator_string (&jobs, 5));
+  owner_name = g_strdup (iterator_string (&jobs, 6));
+  attempts = iterator_int (&jobs, 7);
+  cleanup_iterator (&jobs);
+
+  if (event == EVENT_TASK_RUN_STATUS_CHANGED)
+    data = GINT_TO_POINTER (event_data ? atoi (event_data) : 0);
+  else
+    data = event_data;
+
+  current_credentials.uuid = owner_uuid;
+  current_credentials.username = owner_name;
+  manage_session_init (current_credentials.uuid);
+
+  ret = escalate_1 (alert, task, report, event, data, alert_method (alert),
+                    alert_condition (alert), NULL);
+
+  current_credentials.uuid = NULL;
+  current_credentials.username = NULL;
+
+  if (ret == 0)
+    sql ("DELETE FROM alert_queue WHERE id = %llu;", job);
+  else if ((ret == -1 || ret == -5) && attempts < ALERT_QUEUE_ATTEMPTS)
+    {
+      g_info ("%s: alert %llu failed (%i), retrying in %i seconds",
+              __func__, alert, ret, attempts * ALERT_QUEUE_RETRY_DELAY);
+      sql ("UPDATE alert_queue"
+           " SET worker = -1, next_time = m_now () + %i"
+           " WHERE id = %llu;",
+           attempts * ALERT_QUEUE_RETRY_DELAY,
+           job);
+    }
+  else
+    {
+      g_warning ("%s: giving up on alert %llu after %i attempt%s (%i)",
+                 __func__, alert, attempts, attempts == 1 ? "" : "s", ret);
+      sql ("DELETE FROM alert_queue WHERE id = %llu;", job);
+    }
+
+  g_free (event_data);
+  g_free (owner_uuid);
+  g_free (owner_name);
+}
+
+/**
+ * @brief Run the alerts that event queues, until the parent exits.
+ *
+ * Alerts that the worker was running when it last exited are queued
+ * again, so an alert interrupted by a crash runs again.
+ *
+ * @param[in]  index  Index of the worker, from 0 to the number of workers
+ *                    less one.
+ */
+void
+manage_alert_worker (int index)
+{
+  pid_t parent;
+
+  parent = getppid ();
+  reinit_manage_process ();
+  manage_session_init (current_credentials.uuid);
+
+  sql ("UPDATE alert_queue SET worker = -1 WHERE worker = %i;", index);
+
+  while (getppid () == parent)
+    {
+      resource_t job;
+
+      job = alert_queue_take (index);
+      if (job)
+        alert_queue_run (job);
+      else
+        gvm_sleep (1);
+    }
+}
+
+/**
+ * @brief Get the number of alert worker processes.
+ *
+ * @return The number of workers, 0 if alerts run at the event.
+ */
+int
+get_alert_workers ()
+{
+  return alert_workers;
+}
+
+/**
+ * @brief Set the number of alert worker processes.
+ *
+ * @param[in]  new_workers         The number of workers, 0 to run alerts at
+ *                                 the event.
+ * @param[in]  new_method_workers  The number of alerts of one method that
+ *                                 may run at once, 0 for no limit.
+ */
+void
+set_alert_workers (int new_workers, int new_method_workers)
+{
+  if (new_workers < 0)
+    alert_workers = 0;
+  else if (new_workers > ALERT_WORKERS_MAX)
+    alert_workers = ALERT_WORKERS_MAX;
+  else
+    alert_workers = new_workers;
+
+  alert_method_workers = new_method_workers < 0 ? 0 : new_method_workers;
+}
+
+
+/* Events. */
+
 /**
  * @brief Produce an event.
  *
@@ -14397,6 +15450,11 @@ event (event_t event, void* event_data, resource_t resource_1,
       alert_condition_t condition;
 
       alert = g_array_index (alerts_triggered, alert_t, index);
+      if (alert_workers > 0)
+        {
+          queue_alert (alert, resource_1, resource_2, event, event_data);
+          continue;
+        }
       condition = alert_condition (alert);
       escalate_1 (alert,
                   resource_1,
@@ -14579,32 +15637,29 @@ append_to_task_string (task_t task, const char* field, const char* value)
 #define TASK_ITERATOR_COLUMNS_INNER                                         \
    { "run_status", NULL, KEYWORD_TYPE_INTEGER },                            \
    {                                                                        \
-     "(SELECT count(*) FROM reports"                                        \
+     "(SELECT report_count FROM task_summaries"                             \
      " WHERE task = tasks.id)",                                             \
      "total",                                                               \
      KEYWORD_TYPE_INTEGER                                                   \
    },                                                                       \
    {                                                                        \
-     "(SELECT uuid FROM reports WHERE task = tasks.id"                      \
-     /* TODO 1 == TASK_STATUS_DONE */                                       \
-     " AND scan_run_status = 1"                                             \
-     " ORDER BY creation_time ASC LIMIT 1)",                                \
+     "(SELECT uuid FROM reports"                                            \
+     " WHERE id = (SELECT first_report FROM task_summaries"                 \
+     "             WHERE task = tasks.id))",                                \
      "first_report",                                                        \
      KEYWORD_TYPE_STRING                                                    \
    },                                                                       \
    { "run_status_name (run_status)", "status", KEYWORD_TYPE_STRING },       \
    {                                                                        \
-     "(SELECT uuid FROM reports WHERE task = tasks.id"                      \
-     /* TODO 1 == TASK_STATUS_DONE */                                       \
-     " AND scan_run_status = 1"                                             \
-     " ORDER BY creation_time DESC LIMIT 1)",                               \
+     "(SELECT uuid FROM reports"                                            \
+     " WHERE id = (SELECT last_report FROM task_summaries"                  \
+     "             WHERE task = tasks.id))",                                \
      "last_report",                                                         \
      KEYWORD_TYPE_STRING                                                    \
    },                                                                       \
    {                                                                        \
-     "(SELECT count(*) FROM reports"                                        \
-     /* TODO 1 == TASK_STATUS_DONE */                                       \
-     " WHERE task = tasks.id AND scan_run_status = 1)",                     \
+     "(SELECT finished_report_count FROM task_summaries"                    \
+     " WHERE task = tasks.id)",                                             \
      NULL,                                                                  \
      KEYWORD_TYPE_INTEGER                                                   \
    },                                                                       \
@@ -14650,18 +15705,15 @@ append_to_task_string (task_t task, const char* field, const char* value)
      KEYWORD_TYPE_INTEGER                                                    \
    },                                                                        \
    {                                                                         \
-     "(SELECT creation_time FROM reports WHERE task = tasks.id"              \
-     /* TODO 1 == TASK_STATUS_DONE */                                        \
-     " AND scan_run_status = 1"                                              \
-     " ORDER BY creation_time ASC LIMIT 1)",                                 \
+     "(SELECT creation_time FROM reports"                                    \
+     " WHERE id = (SELECT first_report FROM task_summaries"                  \
+     "             WHERE task = tasks.id))",                                 \
      "first",                                                                \
      KEYWORD_TYPE_INTEGER                                                    \
    },                                                                        \
    {                                                                         \
-     "(SELECT creation_time FROM reports WHERE task = tasks.id"              \
-     /* TODO 1 == TASK_STATUS_DONE */                                        \
-     " AND scan_run_status = 1"                                              \
-     " ORDER BY creation_time DESC LIMIT 1)",                                \
+     "(SELECT creation_time FROM reports"                                    \
+     " WHERE id = task_last_report (tasks.id))",                             \
      "last",                                                                 \
      KEYWORD_TYPE_INTEGER                                                    \
    },                                                                        \
@@ -15190,8 +16242,8 @@ init_manage_open_db (const db_conn_info_t *database)
     }
 
   /* Ensure the user session variables always exists. */
-  sql ("SET SESSION \"gvmd.user.id\" = 0;");
-  sql ("SET SESSION \"gvmd.tz_override\" = '';");
+  sql_session_set ("gvmd.user.id", "0");
+  sql_session_set ("gvmd.tz_override", "");
 
   /* Attach the SCAP and CERT databases. */
   manage_attach_databases ();
@@ -15230,6 +16282,12 @@ init_manage_create_functions ()
 void
 init_manage_process (const db_conn_info_t *database)
 {
+  /* The NVTs may have changed since the cache was filled. */
+  result_nvt_info_cache_clear ();
+  /* A forked process must not keep the ACL decisions of its parent, because
+   * it would never see the clears that follow permission changes made in
+   * other processes. */
+  acl_cache_stop ();
   if (init_manage_open_db (database))
     return;
   init_manage_create_functions ();
@@ -15249,16 +16307,136 @@ reinit_manage_process ()
 }
 
 /**
- * @brief Update the memory cache of NVTs.
+ * @brief Reinitialize the manage library for a worker of a GMP process.
+ *
+ * Like reinit_manage_process, and then set up the session of the current
+ * user on the new database connection.
+ */
+void
+reinit_manage_worker ()
+{
+  reinit_manage_process ();
+  manage_session_init (current_credentials.uuid);
+  manage_session_set_timezone (current_credentials.timezone
+                               && strlen (current_credentials.timezone)
+                                ? current_credentials.timezone
+                                : "UTC");
+}
+
+/**
+ * @brief Get the NVTs of the NVT cache image.
+ *
+ * @param[in]  image  Image.
+ *
+ * @return NVTs.
+ */
+static const nvti_image_nvt_t *
+nvti_image_nvts (const nvti_image_t *image)
+{
+  return (const nvti_image_nvt_t *) (image + 1);
+}
+
+/**
+ * @brief Get the refs of the NVT cache image.
+ *
+ * @param[in]  image  Image.
+ *
+ * @return Refs.
+ */
+static const nvti_image_ref_t *
+nvti_image_refs (const nvti_image_t *image)
+{
+  return (const nvti_image_ref_t *) (nvti_image_nvts (image)
+                                     + image->nvt_count);
+}
+
+/**
+ * @brief Get a string from the NVT cache image.
+ *
+ * @param[in]  image   Image.
+ * @param[in]  offset  Offset of string.
+ *
+ * @return String.
+ */
+static const gchar *
+nvti_image_string (const nvti_image_t *image, guint32 offset)
+{
+  return (const gchar *) (nvti_image_refs (image) + image->ref_count)
+         + offset;
+}
+
+/**
+ * @brief Find an NVT in the memory cache of NVTs.
  *
- * @param[in]  nvt  NVT.
+ * @param[in]  oid  OID of NVT.
  *
- * @return NVTi if found, else NULL.
+ * @return NVT if found, else NULL.
  */
-nvti_t *
-lookup_nvti (const gchar *nvt)
+static const nvti_image_nvt_t *
+lookup_nvti (const gchar *oid)
 {
-  return nvtis_lookup (nvti_cache, nvt);
+  const nvti_image_nvt_t *nvts;
+  guint32 low, high;
+
+  if (nvti_cache == NULL || oid == NULL)
+    return NULL;
+
+  nvts = nvti_image_nvts (nvti_cache);
+  low = 0;
+  high = nvti_cache->nvt_count;
+  while (low < high)
+    {
+      guint32 middle;
+      int cmp;
+
+      middle = low + (high - low) / 2;
+      cmp = strcmp (oid, nvti_image_string (nvti_cache, nvts[middle].oid));
+      if (cmp == 0)
+        return &nvts[middle];
+      if (cmp < 0)
+        high = middle;
+      else
+        low = middle + 1;
+    }
+  return NULL;
+}
+
+/**
+ * @brief Add a string to the strings of an NVT cache image being built.
+ *
+ * @param[in]  strings  Strings.
+ * @param[in]  offsets  Offsets of strings already added, for sharing them.
+ * @param[in]  string   String to add.
+ *
+ * @return Offset of string.
+ */
+static guint32
+nvti_image_add_string (GByteArray *strings, GHashTable *offsets,
+                       const gchar *string)
+{
+  gpointer offset;
+
+  if (g_hash_table_lookup_extended (offsets, string, NULL, &offset))
+    return GPOINTER_TO_UINT (offset);
+
+  offset = GUINT_TO_POINTER (strings->len);
+  g_byte_array_append (strings, (const guint8 *) string, strlen (string) + 1);
+  g_hash_table_insert (offsets, g_strdup (string), offset);
+  return GPOINTER_TO_UINT (offset);
+}
+
+/**
+ * @brief Compare two OIDs given as pointers to strings, for sorting.
+ *
+ * @param[in]  one  First.
+ * @param[in]  two  Second.
+ *
+ * @return Result of strcmp on the OIDs.
+ */
+static gint
+compare_oid_pointers (gconstpointer one, gconstpointer two)
+{
+  return strcmp (*(const gchar **) one, *(const gchar **) two);
 }
 
 /**
@@ -15268,49 +16446,120 @@ static void
 update_nvti_cache ()
 {
   iterator_t nvts;
+  GHashTable *refs_by_oid, *offsets;
+  GHashTableIter iter;
+  GPtrArray *oids;
+  gpointer key;
+  GArray *image_nvts, *image_refs;
+  GByteArray *strings;
+  nvti_image_t *image;
+  size_t size;
+  guint index;
 
-  nvtis_free (nvti_cache);
-
-  nvti_cache = nvtis_new ();
+  refs_by_oid = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                       (GDestroyNotify) g_array_unref);
+  offsets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  strings = g_byte_array_new ();
 
   /* Because there are many NVTs and many refs it's slow to query the refs
    * for each NVT.  So this query gets the NVTs and their refs at the same
    * time.
    *
    * The NVT data is duplicated in the result of the query when there are
-   * multiple refs for an NVT, but the loop below uses nvtis_lookup to
+   * multiple refs for an NVT, but the loop below uses a hashtable to
    * check if we've already seen the NVT.  This also means we don't have
-   * to sort the data by NVT, which would make the query too slow. */
+   * to sort the data by NVT, which would make the query too slow.  The
+   * NVTs are sorted afterwards, in memory. */
   init_iterator (&nvts,
-                 "SELECT nvts.oid, vt_refs.type, vt_refs.ref_id,"
-                 "       vt_refs.ref_text"
+                 "SELECT nvts.oid, vt_refs.type, vt_refs.ref_id"
                  " FROM nvts"
                  " LEFT OUTER JOIN vt_refs ON nvts.oid = vt_refs.vt_oid;");
 
   while (next (&nvts))
     {
-      nvti_t *nvti;
+      GArray *refs;
+      const char *oid;
 
-      nvti = nvtis_lookup (nvti_cache, iterator_string (&nvts, 0));
-      if (nvti == NULL)
+      oid = iterator_string (&nvts, 0);
+      refs = g_hash_table_lookup (refs_by_oid, oid);
+      if (refs == NULL)
         {
-          nvti = nvti_new ();
-          nvti_set_oid (nvti, iterator_string (&nvts, 0));
-
-          nvtis_add (nvti_cache, nvti);
+          refs = g_array_new (FALSE, FALSE, sizeof (nvti_image_ref_t));
+          g_hash_table_insert (refs_by_oid, g_strdup (oid), refs);
         }
 
-      if (iterator_null (&nvts, 2))
-        /* No refs. */;
-      else
-        nvti_add_vtref (nvti,
-                        vtref_new (iterator_string (&nvts, 1),
-                                   iterator_string (&nvts, 2),
-                                   iterator_string (&nvts, 3)));
+      if (iterator_null (&nvts, 2) == 0)
+        {
+          nvti_image_ref_t ref;
+
+          ref.type = nvti_image_add_string (strings, offsets,
+                                            iterator_string (&nvts, 1));
+          ref.id = nvti_image_add_string (strings, offsets,
+                                          iterator_string (&nvts, 2));
+          g_array_append_val (refs, ref);
+        }
     }
 
   cleanup_iterator (&nvts);
 
+  oids = g_ptr_array_sized_new (g_hash_table_size (refs_by_oid));
+  g_hash_table_iter_init (&iter, refs_by_oid);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    g_ptr_array_add (oids, key);
+  g_ptr_array_sort (oids, compare_oid_pointers);
+
+  image_nvts = g_array_sized_new (FALSE, FALSE, sizeof (nvti_image_nvt_t),
+                                  oids->len);
+  image_refs = g_array_new (FALSE, FALSE, sizeof (nvti_image_ref_t));
+  for (index = 0; index < oids->len; index++)
+    {
+      nvti_image_nvt_t nvt;
+      GArray *refs;
+
+      refs = g_hash_table_lookup (refs_by_oid, g_ptr_array_index (oids, index));
+      nvt.oid = nvti_image_add_string (strings, offsets,
+                                       g_ptr_array_index (oids, index));
+      nvt.refs = image_refs->len;
+      nvt.ref_count = refs->len;
+      g_array_append_vals (image_refs, refs->data, refs->len);
+      g_array_append_val (image_nvts, nvt);
+    }
+
+  g_ptr_array_free (oids, TRUE);
+  g_hash_table_destroy (refs_by_oid);
+  g_hash_table_destroy (offsets);
+
+  size = sizeof (nvti_image_t)
+         + image_nvts->len * sizeof (nvti_image_nvt_t)
+         + image_refs->len * sizeof (nvti_image_ref_t)
+         + strings->len;
+  image = mmap (NULL, size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (image == MAP_FAILED)
+    g_warning ("%s: failed to map NVT cache: %s", __func__, strerror (errno));
+  else
+    {
+      image->size = size;
+      image->nvt_count = image_nvts->len;
+      image->ref_count = image_refs->len;
+      memcpy ((gpointer) nvti_image_nvts (image), image_nvts->data,
+              image_nvts->len * sizeof (nvti_image_nvt_t));
+      memcpy ((gpointer) nvti_image_refs (image), image_refs->data,
+              image_refs->len * sizeof (nvti_image_ref_t));
+      memcpy ((gpointer) nvti_image_string (image, 0), strings->data,
+              strings->len);
+      mprotect (image, size, PROT_READ);
+
+      /* Processes forked earlier keep their own mapping of the old image. */
+      if (nvti_cache)
+        munmap (nvti_cache, nvti_cache->size);
+      nvti_cache = image;
+    }
+
+  g_array_free (image_nvts, TRUE);
+  g_array_free (image_refs, TRUE);
+  g_byte_array_free (strings, TRUE);
+
   malloc_trim (0);
 }
 
@@ -16597,6 +17846,9 @@ manage_reset_currents ()
   global_current_report = 0;
   current_scanner_task = (task_t) 0;
   free_credentials (&current_credentials);
+  setting_cache_clear ();
+  filter_clause_cache_clear ();
+  lsc_crypt_flush_cache ();
 }
 
 /**
@@ -17074,6 +18326,192 @@ authenticate (credentials_t* credentials)
   return 1;
 }
 
+/**
+ * @brief Authenticate a user with a GMP session token.
+ *
+ * Takes the role and settings that were set up when the token was issued,
+ * instead of verifying the password and setting up the credentials again.
+ * The token only matches while the user is unchanged, so that modifying the
+ * user, including the password, revokes the sessions of the user.  Changes
+ * to the groups and roles of the user delete the sessions of the user in a
+ * trigger, and LOGOUT revokes a single session.
+ *
+ * @param[in]  credentials  Credentials, with the username.
+ * @param[in]  token        Session token from manage_session_token_new.
+ *
+ * @return 0 authentication success, 1 authentication failure, 99 permission
+ *         denied.
+ */
+int
+authenticate_token (credentials_t* credentials, const gchar *token)
+{
+  iterator_t sessions;
+  gchar *hash, *quoted_name;
+  int ret;
+
+  if (gmp_session_ttl <= 0
+      || authenticate_allow_all
+      || credentials->username == NULL
+      || token == NULL
+      || *token == '\0')
+    return 1;
+
+  hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, token, -1);
+  quoted_name = sql_quote (credentials->username);
+  init_iterator (&sessions,
+                 "SELECT users.uuid, gmp_sessions.role,"
+                 "       gmp_sessions.timezone, gmp_sessions.severity_class,"
+                 "       gmp_sessions.dynamic_severity,"
+                 "       gmp_sessions.default_severity"
+                 " FROM gmp_sessions, users"
+                 " WHERE gmp_sessions.token_hash = '%s'"
+                 " AND gmp_sessions.expiry_time > m_now ()"
+                 " AND users.id = gmp_sessions.\"user\""
+                 " AND users.name = '%s'"
+                 " AND users.modification_time IS NOT DISTINCT FROM"
+                 "     gmp_sessions.user_modification_time;",
+                 hash,
+                 quoted_name);
+  g_free (hash);
+  g_free (quoted_name);
+
+  ret = 1;
+  if (next (&sessions))
+    {
+      credentials->uuid = g_strdup (iterator_string (&sessions, 0));
+      credentials->role = g_strdup (iterator_string (&sessions, 1));
+      credentials->timezone = g_strdup (iterator_string (&sessions, 2));
+      credentials->severity_class = g_strdup (iterator_string (&sessions, 3));
+      credentials->dynamic_severity = iterator_int (&sessions, 4);
+      credentials->default_severity = iterator_double (&sessions, 5);
+      ret = 0;
+    }
+  cleanup_iterator (&sessions);
+
+  if (ret)
+    return ret;
+
+  manage_session_init (credentials->uuid);
+
+  /* Permissions may have changed since the token was issued. */
+  if (acl_user_may ("authenticate") == 0)
+    {
+      free (credentials->uuid);
+      credentials->uuid = NULL;
+      g_free (credentials->role);
+      credentials->role = NULL;
+      return 99;
+    }
+
+  return 0;
+}
+
+/**
+ * @brief Issue a GMP session token for an authenticated user.
+ *
+ * Only a hash of the token is stored.  Expired sessions are removed.
+ *
+ * @param[in]  credentials  Credentials of the user, as set by authenticate.
+ *
+ * @return Freshly allocated token, or NULL if session tokens are disabled
+ *         or on error.
+ */
+gchar *
+manage_session_token_new (const credentials_t *credentials)
+{
+  guchar random[32];
+  GString *token;
+  gchar *hash, *quoted_role, *quoted_timezone, *quoted_severity_class;
+  gsize index;
+
+  if (gmp_session_ttl <= 0 || credentials->uuid == NULL)
+    return NULL;
+
+  if (gnutls_rnd (GNUTLS_RND_KEY, random, sizeof (random)))
+    {
+      g_warning ("%s: failed to generate token", __func__);
+      return NULL;
+    }
+  token = g_string_sized_new (2 * sizeof (random));
+  for (index = 0; index < sizeof (random); index++)
+    g_string_append_printf (token, "%02x", random[index]);
+
+  hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, token->str, -1);
+  quoted_role = sql_insert (credentials->role);
+  quoted_timezone = sql_insert (credentials->timezone);
+  quoted_severity_class = sql_insert (credentials->severity_class);
+
+  sql ("DELETE FROM gmp_sessions WHERE expiry_time <= m_now ();");
+  sql ("INSERT INTO gmp_sessions"
+       " (token_hash, \"user\", user_modification_time, role, timezone,"
+       "  severity_class, dynamic_severity, default_severity, creation_time,"
+       "  expiry_time)"
+       " SELECT '%s', id, modification_time, %s, %s, %s, %i, %f, m_now (),"
+       "        m_now () + %i"
+       " FROM users WHERE uuid = '%s';",
+       hash,
+       quoted_role,
+       quoted_timezone,
+       quoted_severity_class,
+       credentials->dynamic_severity,
+       credentials->default_severity,
+       gmp_session_ttl,
+       credentials->uuid);
+
+  g_free (hash);
+  g_free (quoted_role);
+  g_free (quoted_timezone);
+  g_free (quoted_severity_class);
+  return g_string_free (token, FALSE);
+}
+
+/**
+ * @brief Revoke a GMP session of the current user.
+ *
+ * @param[in]  token  Session token from manage_session_token_new.
+ */
+void
+manage_session_token_revoke (const gchar *token)
+{
+  gchar *hash;
+
+  if (token == NULL || current_credentials.uuid == NULL)
+    return;
+
+  hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, token, -1);
+  sql ("DELETE FROM gmp_sessions"
+       " WHERE token_hash = '%s'"
+       " AND \"user\" = (SELECT id FROM users WHERE uuid = '%s');",
+       hash,
+       current_credentials.uuid);
+  g_free (hash);
+}
+
+/**
+ * @brief Revoke the GMP sessions of the current user.
+ *
+ * For changes to the user that the sessions would not pick up.
+ */
+static void
+revoke_current_user_sessions ()
+{
+  if (current_credentials.uuid)
+    sql ("DELETE FROM gmp_sessions"
+         " WHERE \"user\" = (SELECT id FROM users WHERE uuid = '%s');",
+         current_credentials.uuid);
+}
+
+/**
+ * @brief Set the number of seconds that a GMP session token stays valid.
+ *
+ * @param[in]  new_ttl  Seconds, 0 to disable session tokens.
+ */
+void
+set_gmp_session_ttl (int new_ttl)
+{
+  gmp_session_ttl = new_ttl < 0 ? 0 : new_ttl;
+}
+
 /**
  * @brief Return number of resources of a certain type for current user.
  *
@@ -17093,7 +18531,15 @@ resource_count (const char *type, const get_data_t *get)
 
   memset (&count_get, '\0', sizeof (count_get));
   count_get.trash = get->trash;
-  if (type_owned (type))
+  if (count_estimated (get))
+    {
+      if (type_owned (type))
+        count_get.filter = "rows=-1 first=1 permission=any owner=any"
+                           " count_estimate=1";
+      else
+        count_get.filter = "rows=-1 first=1 permission=any count_estimate=1";
+    }
+  else if (type_owned (type))
     count_get.filter = "rows=-1 first=1 permission=any owner=any";
   else
     count_get.filter = "rows=-1 first=1 permission=any";
@@ -17887,11 +19333,9 @@ int
 task_last_report (task_t task, report_t *report)
 {
   switch (sql_int64 (report,
-                     "SELECT id FROM reports WHERE task = %llu"
-                     " AND scan_run_status = %u"
-                     " ORDER BY creation_time DESC LIMIT 1;",
-                     task,
-                     TASK_STATUS_DONE))
+                     "SELECT coalesce (last_report, 0) FROM task_summaries"
+                     " WHERE task = %llu;",
+                     task))
     {
       case 0:
         break;
@@ -18017,11 +19461,11 @@ task_last_resumable_report (task_t task, report_t *report)
 gchar*
 task_second_last_report_id (task_t task)
 {
-  return sql_string ("SELECT uuid FROM reports WHERE task = %llu"
-                     " AND scan_run_status = %u"
-                     " ORDER BY creation_time DESC LIMIT 1 OFFSET 1;",
-                     task,
-                     TASK_STATUS_DONE);
+  return sql_string ("SELECT uuid FROM reports"
+                     " WHERE id = (SELECT second_last_report"
+                     "             FROM task_summaries"
+                     "             WHERE task = %llu);",
+                     task);
 }
 
 /**
@@ -18460,6 +19904,21 @@ set_task_schedule_next_time_uuid (const gchar *task_id, time_t time)
   g_free (quoted_task_id);
 }
 
+/**
+ * @brief Get the earliest time that any scheduled task is due to start.
+ *
+ * @return Earliest next time, or 0 if no scheduled task is waiting to start.
+ */
+time_t
+task_schedule_next_due ()
+{
+  return (time_t) sql_int64_0 ("SELECT coalesce (min (schedule_next_time), 0)"
+                               " FROM tasks"
+                               " WHERE schedule > 0"
+                               " AND hidden = 0"
+                               " AND schedule_next_time > 0;");
+}
+
 /**
  * @brief Return the severity score of a task, taking overrides into account.
  *
@@ -18798,7 +20257,7 @@ auto_delete_reports ()
           assert (report);
 
           g_debug ("%s: delete %llu", __func__, report);
-          ret = delete_report_internal (report);
+          ret = delete_report_user (report);
           if (ret == 2)
             {
               /* Report is in use. */
@@ -18922,6 +20381,152 @@ result_nvt_notice (const gchar *nvt)
        nvt);
 }
 
+/**
+ * @brief Free a result_nvt_info_t.
+ *
+ * @param[in]  data  NVT info.
+ */
+static void
+result_nvt_info_free (gpointer data)
+{
+  result_nvt_info_t *info;
+
+  info = (result_nvt_info_t*) data;
+  g_free (info->severity);
+  g_free (info->modification_time);
+  g_free (info);
+}
+
+/**
+ * @brief Clear the memory cache of NVT data used when creating results.
+ */
+static void
+result_nvt_info_cache_clear ()
+{
+  if (result_nvt_info_cache)
+    {
+      g_hash_table_destroy (result_nvt_info_cache);
+      result_nvt_info_cache = NULL;
+    }
+  g_free (result_nvt_info_cache_version);
+  result_nvt_info_cache_version = NULL;
+}
+
+/**
+ * @brief Clear the memory cache of NVT data if the NVT feed has changed.
+ *
+ * Called when a scan is set up, so that a long running process like an
+ * OSP scan monitor does not give new scans the NVT data of an old feed.
+ */
+void
+result_nvt_info_cache_check ()
+{
+  gchar *version;
+
+  version = nvts_feed_version ();
+  if (g_strcmp0 (version, result_nvt_info_cache_version))
+    {
+      result_nvt_info_cache_clear ();
+      result_nvt_info_cache_version = version;
+    }
+  else
+    g_free (version);
+}
+
+/**
+ * @brief Get the data of an NVT or CVE needed to create a result.
+ *
+ * The data is cached, including when the NVT does not exist.
+ *
+ * @param[in]  nvt  NVT OID or CVE name.
+ *
+ * @return NVT info.  Owned by the cache.
+ */
+static result_nvt_info_t *
+result_nvt_info (const char *nvt)
+{
+  result_nvt_info_t *info;
+  iterator_t iterator;
+  gchar *quoted_nvt;
+
+  assert (nvt);
+
+  if (result_nvt_info_cache == NULL)
+    result_nvt_info_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   g_free,
+                                                   result_nvt_info_free);
+
+  info = g_hash_table_lookup (result_nvt_info_cache, nvt);
+  if (info)
+    return info;
+
+  quoted_nvt = sql_quote (nvt);
+  if (g_str_has_prefix (nvt, "CVE-"))
+    init_iterator (&iterator,
+                   "SELECT severity, iso_time (modification_time)"
+                   " FROM scap.cves WHERE uuid = '%s';",
+                   quoted_nvt);
+  else
+    init_iterator (&iterator,
+                   "SELECT coalesce (cvss_base, '0.0'),"
+                   "       iso_time (modification_time)"
+                   " FROM nvts WHERE uuid = '%s';",
+                   quoted_nvt);
+  g_free (quoted_nvt);
+
+  info = g_malloc0 (sizeof (*info));
+  if (next (&iterator))
+    {
+      info->severity = g_strdup (iterator_string (&iterator, 0));
+      info->modification_time = g_strdup (iterator_string (&iterator, 1));
+    }
+  cleanup_iterator (&iterator);
+
+  g_hash_table_insert (result_nvt_info_cache, g_strdup (nvt), info);
+  return info;
+}
+
+/**
+ * @brief Get the severity to store for an OSP result.
+ *
+ * @param[in]  nvt       NVT OID or CVE of the result.
+ * @param[in]  type      Type of result.  "Alarm", etc.
+ * @param[in]  severity  Severity given by the scanner, or NULL.
+ *
+ * @return Freshly allocated quoted severity, NULL if the result should be
+ *         dropped.
+ */
+static gchar *
+osp_result_severity (const char *nvt, const char *type, const char *severity)
+{
+  gchar *result_severity;
+
+  if (severity && strcmp (severity, ""))
+    return sql_quote (severity);
+
+  if (!strcmp (type, severity_to_type (SEVERITY_ERROR)))
+    return g_strdup (G_STRINGIFY (SEVERITY_ERROR));
+
+  if (nvt && g_str_has_prefix (nvt, "CVE-"))
+    {
+      result_severity = cve_cvss_base (nvt);
+      if (result_severity == NULL || strcmp (result_severity, "") == 0)
+        {
+          g_free (result_severity);
+          result_severity
+            = g_strdup_printf ("%0.1f",
+                               setting_default_severity_dbl ());
+          g_debug ("%s: OSP CVE result without severity for '%s'",
+                   __func__, nvt);
+        }
+      return result_severity;
+    }
+
+  g_warning ("%s: Non-CVE OSP result without severity for test %s",
+             __func__, nvt ? nvt : "(unknown)");
+  return NULL;
+}
+
 /**
  * @brief Make an OSP result.
  *
@@ -18950,58 +20555,21 @@ make_osp_result (task_t task, const char *host, const char *hostname,
   assert (task);
   assert (type);
 
+  result_severity = osp_result_severity (nvt, type, severity);
+  if (result_severity == NULL)
+    return 0;
+
   quoted_desc = sql_quote (description ?: "");
   quoted_nvt = sql_quote (nvt ?: "");
   quoted_port = sql_quote (port ?: "");
   quoted_hostname = sql_quote (hostname ? hostname : "");
   quoted_path = sql_quote (path ? path : "");
 
-  if (nvt)
-    {
-      if (g_str_has_prefix (nvt, "1.3.6.1.4.1.25623."))
-        nvt_revision = sql_string ("SELECT iso_time (modification_time)"
-                                   " FROM nvts WHERE oid='%s'",
-                                   quoted_nvt);
-      else if (g_str_has_prefix (nvt, "CVE-"))
-        nvt_revision = sql_string ("SELECT iso_time (modification_time)"
-                                   " FROM scap.cves WHERE uuid='%s'",
-                                   quoted_nvt);
-    }
-  
-  if (!severity || !strcmp (severity, ""))
-    {
-      if (!strcmp (type, severity_to_type (SEVERITY_ERROR)))
-        result_severity = g_strdup (G_STRINGIFY (SEVERITY_ERROR));
-      else
-        {
-          if (nvt && g_str_has_prefix (nvt, "CVE-"))
-            {
-              result_severity = cve_cvss_base (nvt);
-              if (result_severity == NULL || strcmp (result_severity, "") == 0)
-                {
-                  g_free (result_severity);
-                  result_severity
-                    = g_strdup_printf ("%0.1f",
-                                       setting_default_severity_dbl ());
-                  g_debug ("%s: OSP CVE result without severity for '%s'",
-                           __func__, nvt);
-                }
-            }
-          else
-            {
-              /*
-              result_severity
-                = g_strdup_printf ("%0.1f",
-                                   setting_default_severity_dbl ());
-              */
-              g_warning ("%s: Non-CVE OSP result without severity for test %s",
-                         __func__, nvt ? nvt : "(unknown)");
-              return 0;
-            }
-        }
-    }
-  else
-    result_severity = sql_quote (severity);
+  if (nvt
+      && (g_str_has_prefix (nvt, "1.3.6.1.4.1.25623.")
+          || g_str_has_prefix (nvt, "CVE-")))
+    nvt_revision = g_strdup (result_nvt_info (nvt)->modification_time);
+
   result_nvt_notice (quoted_nvt);
   sql ("INSERT into results"
        " (owner, date, task, host, hostname, port, nvt,"
@@ -19259,8 +20827,7 @@ nvt_severity (const char *nvt_id, const char *type)
   char *severity = NULL;
 
   if (strcasecmp (type, "Alarm") == 0 && nvt_id)
-    severity = sql_string ("SELECT coalesce(cvss_base, '0.0')"
-                           " FROM nvts WHERE uuid = '%s';", nvt_id);
+    severity = g_strdup (result_nvt_info (nvt_id)->severity);
   else if (strcasecmp (type, "Alarm") == 0)
     g_warning ("%s result type requires an NVT", type);
   else if (strcasecmp (type, "Log Message") == 0)
@@ -19389,19 +20956,20 @@ make_cve_result (task_t task, const char* host, const char *nvt, double cvss,
                  const char* description)
 {
   gchar *quoted_descr;
+  const gchar *nvt_revision;
+
   quoted_descr = sql_quote (description ?: "");
+  nvt_revision = result_nvt_info (nvt)->modification_time;
   result_nvt_notice (nvt);
   sql ("INSERT into results"
        " (owner, date, task, host, port, nvt, nvt_version, severity, type,"
        "  description, uuid, qod, qod_type, path, result_nvt)"
        " VALUES"
-       " (NULL, m_now (), %llu, '%s', '', '%s',"
-       "  (SELECT iso_time (modification_time)"
-       "     FROM scap.cves WHERE uuid='%s'),"
+       " (NULL, m_now (), %llu, '%s', '', '%s', '%s',"
        "  '%1.1f', '%s', '%s', make_uuid (), %i, '', '',"
        "  (SELECT id FROM result_nvts WHERE nvt = '%s'));",
-       task, host ?: "", nvt, nvt, cvss, severity_to_type (cvss),
-       quoted_descr, QOD_DEFAULT, nvt);
+       task, host ?: "", nvt, nvt_revision ?: "", cvss,
+       severity_to_type (cvss), quoted_descr, QOD_DEFAULT, nvt);
 
   g_free (quoted_descr);
   return sql_last_insert_id ();
@@ -19680,6 +21248,215 @@ prognosis_iterator_cvss_double (iterator_t* iterator)
 DEF_ACCESS (prognosis_iterator_description, 2);
 DEF_ACCESS (prognosis_iterator_cpe, 3);
 
+/**
+ * @brief Add the CVE "scan" results of many hosts to a report.
+ *
+ * The products of all hosts are matched against the CVEs at once, and the
+ * report hosts, host details and results of all matches are inserted with
+ * one statement each.  This gives the same report as adding the prognosis
+ * of each host one result at a time.
+ *
+ * @param[in]  task          Task of the results.
+ * @param[in]  report        Report to add the hosts, results and details to.
+ * @param[in]  ips           IPs of the hosts.
+ * @param[in]  report_hosts  For each IP, the report host that has the
+ *                           products of the host.
+ */
+void
+report_add_cve_results (task_t task, report_t report, GPtrArray *ips,
+                        GArray *report_hosts)
+{
+  GString *values;
+  result_t last;
+  time_t start_time;
+  guint index;
+
+  assert (ips->len == report_hosts->len);
+
+  if (ips->len == 0)
+    return;
+
+  start_time = time (NULL);
+
+  values = g_string_new ("");
+  for (index = 0; index < ips->len; index++)
+    {
+      gchar *quoted_ip;
+
+      quoted_ip = sql_quote (g_ptr_array_index (ips, index));
+      g_string_append_printf (values,
+                              "%s ('%s', %llu)",
+                              index ? "," : "",
+                              quoted_ip,
+                              g_array_index (report_hosts, report_host_t,
+                                             index));
+      g_free (quoted_ip);
+    }
+
+  sql_begin_immediate ();
+
+  sql ("CREATE TEMPORARY TABLE cve_scan_hosts"
+       " (ip text, source integer);");
+  sql ("INSERT INTO cve_scan_hosts (ip, source) VALUES %s;", values->str);
+  g_string_free (values, TRUE);
+
+  /* Match the products of all hosts against the CVEs, as the prognosis
+   * iterator does for one host. */
+
+  sql ("CREATE TEMPORARY TABLE cve_scan_matches AS"
+       " SELECT hosts.ip, hosts.source,"
+       "        cves.name AS cve,"
+       "        max (cves.severity) AS severity,"
+       "        max (cves.description) AS description,"
+       "        iso_time (max (cves.modification_time)) AS nvt_version,"
+       "        cpes.name AS app,"
+       "        NULL::text AS locations"
+       " FROM cve_scan_hosts AS hosts, report_host_details,"
+       "      scap.cpes, scap.affected_products, scap.cves"
+       " WHERE report_host_details.report_host = hosts.source"
+       " AND report_host_details.name = 'App'"
+       " AND cpes.name = report_host_details.value"
+       " AND cpes.id = affected_products.cpe"
+       " AND cves.id = affected_products.cve"
+       " GROUP BY hosts.ip, hosts.source, cves.id, cves.name, cpes.name;");
+
+  if (sql_int ("SELECT count (*) FROM cve_scan_matches;") == 0)
+    {
+      sql ("DROP TABLE cve_scan_matches;");
+      sql ("DROP TABLE cve_scan_hosts;");
+      sql_commit ();
+      return;
+    }
+
+  /* Get the locations of each product, as init_app_locations_iterator
+   * does. */
+
+  sql ("UPDATE cve_scan_matches"
+       " SET locations = (SELECT string_agg (DISTINCT value, ', ')"
+       "                  FROM report_host_details AS details"
+       "                  WHERE details.report_host = cve_scan_matches.source"
+       "                  AND details.name = cve_scan_matches.app"
+       "                  AND details.source_type = 'nvt'"
+       "                  AND details.source_name"
+       "                      IN (SELECT source_name"
+       "                          FROM report_host_details"
+       "                          WHERE report_host = cve_scan_matches.source"
+       "                          AND source_type = 'nvt'"
+       "                          AND name = 'App'"
+       "                          AND value = cve_scan_matches.app));");
+
+  /* Add the hosts. */
+
+  sql ("INSERT INTO report_hosts"
+       " (report, host, start_time, end_time, current_port, max_port)"
+       " SELECT DISTINCT %llu, ip, %lld, 0, 0, 0"
+       " FROM cve_scan_matches"
+       " WHERE NOT EXISTS (SELECT * FROM report_hosts"
+       "                   WHERE report = %llu"
+       "                   AND host = cve_scan_matches.ip);",
+       report,
+       (long long) start_time,
+       report);
+
+  /* Add the host details. */
+
+  sql ("INSERT INTO report_host_details"
+       " (report_host, source_type, source_name, source_description,"
+       "  name, value)"
+       " SELECT report_hosts.id, 'cve', details.cve, 'CVE Scanner',"
+       "        details.name, details.value"
+       " FROM (SELECT ip, cve, 'App' AS name, app AS value"
+       "       FROM cve_scan_matches"
+       "       UNION ALL"
+       "       SELECT ip, cve, app, locations"
+       "       FROM cve_scan_matches WHERE locations IS NOT NULL"
+       "       UNION ALL"
+       "       SELECT ip, cve, 'detected_at', locations"
+       "       FROM cve_scan_matches WHERE locations IS NOT NULL"
+       "       UNION ALL"
+       "       SELECT ip, cve, 'detected_by', cve"
+       "       FROM cve_scan_matches WHERE locations IS NOT NULL)"
+       "      AS details,"
+       "      report_hosts"
+       " WHERE report_hosts.report = %llu"
+       " AND report_hosts.host = details.ip;",
+       report);
+
+  /* Add the results.  Only this process adds results to the report, so
+   * the results of the report after this one are the new results. */
+
+  last = 0;
+  sql_int64 (&last, "SELECT coalesce (max (id), 0) FROM results;");
+
+  sql ("INSERT INTO result_nvts (nvt)"
+       " SELECT DISTINCT cve FROM cve_scan_matches"
+       " ON CONFLICT DO NOTHING;");
+
+  sql ("INSERT INTO results"
+       " (owner, date, task, host, port, nvt, nvt_version, severity, type,"
+       "  description, uuid, qod, qod_type, path, result_nvt, report)"
+       " SELECT (SELECT owner FROM reports WHERE id = %llu), m_now (), %llu,"
+       "        ip, '', cve, coalesce (nvt_version, ''),"
+       "        round (severity::numeric, 1),"
+       "        CASE WHEN severity > 0.0 THEN 'Alarm' ELSE 'Log Message' END,"
+       "        'The host carries the product: ' || app"
+       "        || E'\\nIt is vulnerable according to: ' || cve || E'.\\n'"
+       "        || CASE WHEN locations IS NULL OR locations = '' THEN ''"
+       "           ELSE 'The product was found at: ' || locations || E'.\\n'"
+       "           END"
+       "        || E'\\n' || coalesce (description, ''),"
+       "        make_uuid (), %i, '', '',"
+       "        (SELECT id FROM result_nvts WHERE nvt = cve),"
+       "        %llu"
+       " FROM cve_scan_matches"
+       " ORDER BY ip, cve;",
+       report,
+       task,
+       QOD_DEFAULT,
+       report);
+
+  sql ("INSERT INTO result_nvt_reports (result_nvt, report)"
+       " SELECT DISTINCT result_nvt, %llu FROM results"
+       " WHERE report = %llu AND id > %llu"
+       " AND NOT EXISTS (SELECT * FROM result_nvt_reports"
+       "                 WHERE result_nvt = results.result_nvt"
+       "                 AND report = %llu);",
+       report,
+       report,
+       last,
+       report);
+
+  report_add_counts_for_results (report, last,
+                                 sql_int ("SELECT EXISTS"
+                                          " (SELECT * FROM overrides"
+                                          "  WHERE nvt IN (SELECT cve"
+                                          "                FROM"
+                                          "                cve_scan_matches));"));
+
+  /* Complete the hosts. */
+
+  sql ("UPDATE report_hosts SET end_time = %lld"
+       " WHERE report = %llu"
+       " AND host IN (SELECT ip FROM cve_scan_matches);",
+       (long long) time (NULL),
+       report);
+
+  sql ("INSERT INTO report_host_details"
+       " (report_host, source_type, source_name, source_description,"
+       "  name, value)"
+       " SELECT id, 'cve', '', 'CVE Scanner', 'CVE Scan', '1'"
+       " FROM report_hosts"
+       " WHERE report = %llu"
+       " AND host IN (SELECT ip FROM cve_scan_matches);",
+       report);
+
+  update_report_modification_time (report);
+
+  sql ("DROP TABLE cve_scan_matches;");
+  sql ("DROP TABLE cve_scan_hosts;");
+  sql_commit ();
+}
+
 
 /* Reports. */
 
@@ -19864,28 +21641,46 @@ reports_clear_count_cache_dynamic ()
 }
 
 /**
- * @brief Rebuild the report count cache for all reports and users.
+ * @brief Number of reports between progress messages of a count cache build.
+ */
+#define REPORTS_BUILD_COUNT_CACHE_PROGRESS 100
+
+/**
+ * @brief Rebuild the report count cache for a share of the reports.
  *
- * @param[in]  clear        Whether to clear the cache before rebuilding.
- * @param[out] changes_out  The number of processed user/report combinations.
+ * @param[in]  clear    Whether to clear the cache before rebuilding.
+ * @param[in]  workers  Number of shares the reports are split into, or 0
+ *                      or 1 for all reports.
+ * @param[in]  index    Which share to rebuild.
+ *
+ * @return The number of processed reports.
  */
-static void
-reports_build_count_cache (int clear, int* changes_out)
+static int
+reports_build_count_cache_share (int clear, int workers, int index)
 {
-  int changes;
+  int changes, total;
   iterator_t reports;
+  gchar *share;
+
   changes = 0;
+  if (workers > 1)
+    share = g_strdup_printf (" AND id %% %i = %i", workers, index);
+  else
+    share = g_strdup ("");
 
-  /* Clear cache of trashcan reports, we won't count them. */
-  sql ("DELETE FROM report_counts"
-       " WHERE (SELECT hidden = 2 FROM tasks"
-       "        WHERE tasks.id = (SELECT task FROM reports"
-       "                          WHERE reports.id = report_counts.report));");
+  total = sql_int ("SELECT count (*) FROM reports"
+                   " WHERE (SELECT hidden = 0 FROM tasks"
+                   "        WHERE tasks.id = task)"
+                   "%s;",
+                   share);
 
   init_iterator (&reports,
                  "SELECT id FROM reports"
                  " WHERE (SELECT hidden = 0 FROM tasks"
-                 "        WHERE tasks.id = task);");
+                 "        WHERE tasks.id = task)"
+                 "%s;",
+                 share);
+  g_free (share);
 
   while (next (&reports))
     {
@@ -19893,12 +21688,144 @@ reports_build_count_cache (int clear, int* changes_out)
 
       report_cache_counts (report, clear, clear, NULL);
       changes ++;
+      metrics_add (METRIC_REPORT_CACHE_DONE, 1);
+
+      if (changes % REPORTS_BUILD_COUNT_CACHE_PROGRESS == 0
+          || changes == total)
+        {
+          if (workers > 1)
+            g_info ("%s: worker %i: counted %i of %i reports",
+                    __func__, index, changes, total);
+          else
+            g_info ("%s: counted %i of %i reports",
+                    __func__, changes, total);
+        }
     }
 
   cleanup_iterator (&reports);
 
+  return changes;
+}
+
+/**
+ * @brief Rebuild the report count cache in worker processes.
+ *
+ * Each worker opens its own database connection and rebuilds the caches of
+ * its share of the reports in its own transaction.
+ *
+ * @param[in]  clear    Whether to clear the cache before rebuilding.
+ * @param[in]  workers  Number of worker processes.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+reports_build_count_cache_parallel (int clear, int workers)
+{
+  pid_t *pids;
+  int index, ret;
+
+  pids = g_malloc0 (workers * sizeof (pid_t));
+  ret = 0;
+
+  for (index = 0; index < workers; index++)
+    {
+      pids[index] = fork ();
+      switch (pids[index])
+        {
+          case 0:
+            /* Child.  Reopen the database (required after fork).  Use
+             * _exit to skip the cleanup of the parent process. */
+            reinit_manage_process ();
+            sql_begin_immediate ();
+            reports_build_count_cache_share (clear, workers, index);
+            sql_commit ();
+            sql_close ();
+            _exit (EXIT_SUCCESS);
+          case -1:
+            g_warning ("%s: fork failed: %s",
+                       __func__,
+                       strerror (errno));
+            ret = -1;
+            break;
+          default:
+            g_debug ("%s: %i forked %i", __func__, getpid (), pids[index]);
+            break;
+        }
+      if (ret)
+        break;
+    }
+
+  for (index = 0; index < workers; index++)
+    {
+      int status;
+
+      if (pids[index] <= 0)
+        continue;
+
+      while (waitpid (pids[index], &status, 0) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          g_warning ("%s: waitpid: %s",
+                     __func__,
+                     strerror (errno));
+          status = -1;
+          break;
+        }
+
+      if (status == -1
+          || WIFEXITED (status) == 0
+          || WEXITSTATUS (status) != EXIT_SUCCESS)
+        {
+          g_warning ("%s: worker %i failed", __func__, index);
+          ret = -1;
+        }
+    }
+
+  g_free (pids);
+  return ret;
+}
+
+/**
+ * @brief Rebuild the report count cache for all reports and users.
+ *
+ * @param[in]  clear        Whether to clear the cache before rebuilding.
+ * @param[out] changes_out  The number of processed user/report combinations.
+ *
+ * @return 0 success, -1 error in a worker process.
+ */
+static int
+reports_build_count_cache (int clear, int* changes_out)
+{
+  int changes, ret;
+
+  /* Clear cache of trashcan reports, we won't count them. */
+  sql ("DELETE FROM report_counts"
+       " WHERE (SELECT hidden = 2 FROM tasks"
+       "        WHERE tasks.id = (SELECT task FROM reports"
+       "                          WHERE reports.id = report_counts.report));");
+
+  metrics_set (METRIC_REPORT_CACHE_DONE, 0);
+  metrics_set (METRIC_REPORT_CACHE_TOTAL,
+               sql_int ("SELECT count (*) FROM reports"
+                        " WHERE (SELECT hidden = 0 FROM tasks"
+                        "        WHERE tasks.id = task);"));
+
+  ret = 0;
+  if (report_cache_workers > 1)
+    {
+      ret = reports_build_count_cache_parallel (clear, report_cache_workers);
+      changes = sql_int ("SELECT count (*) FROM reports"
+                         " WHERE (SELECT hidden = 0 FROM tasks"
+                         "        WHERE tasks.id = task);");
+    }
+  else
+    changes = reports_build_count_cache_share (clear, 0, 0);
+
   if (changes_out)
     *changes_out = changes;
+
+  return ret;
 }
 
 /**
@@ -20134,6 +22061,381 @@ report_clear_count_cache (report_t report,
     }
 }
 
+/**
+ * @brief Add the counts of new results to the count cache of a report.
+ *
+ * This updates the cached counts in place instead of clearing them, so that
+ * the next request does not have to count all results of the report again.
+ * Users with dynamic severity get their caches cleared, because their
+ * counts do not use the stored result severity.
+ *
+ * @param[in]  report      Report.
+ * @param[in]  after       Results of the report with a higher ID than this
+ *                         are the new results.
+ * @param[in]  overridden  Whether overrides may apply to the new results.
+ *                         If so the overridden counts are cleared, otherwise
+ *                         they are updated like the original counts.
+ */
+static void
+report_add_counts_for_results (report_t report, result_t after,
+                               int overridden)
+{
+  sql ("DELETE FROM report_counts"
+       " WHERE report = %llu"
+       " AND coalesce ((SELECT value FROM settings"
+       "                WHERE name = 'Dynamic Severity'"
+       "                AND (owner = report_counts.\"user\" OR owner IS NULL)"
+       "                ORDER BY coalesce (owner, 0) DESC LIMIT 1),"
+       "               '0')"
+       "     = '1';",
+       report);
+
+  if (overridden)
+    report_clear_count_cache (report, 0, 1, NULL);
+
+  /* Add to the severities that are already in the caches. */
+
+  sql ("UPDATE report_counts"
+       " SET count = report_counts.count + new_counts.count"
+       " FROM (SELECT caches.id, count (*) AS count"
+       "       FROM report_counts AS caches, results"
+       "       WHERE caches.report = %llu"
+       "       AND results.report = %llu"
+       "       AND results.id > %llu"
+       "       AND results.qod >= caches.min_qod"
+       "       AND round (results.severity::numeric, 1) = caches.severity"
+       "       GROUP BY caches.id) AS new_counts"
+       " WHERE report_counts.id = new_counts.id;",
+       report,
+       report,
+       after);
+
+  /* Add the severities that are new to the caches. */
+
+  sql ("INSERT INTO report_counts"
+       " (report, \"user\", override, min_qod, severity, count, end_time)"
+       " SELECT %llu, caches.\"user\", caches.override, caches.min_qod,"
+       "        round (results.severity::numeric, 1), count (*),"
+       "        caches.end_time"
+       " FROM (SELECT \"user\", override, min_qod, max (end_time) AS end_time"
+       "       FROM report_counts"
+       "       WHERE report = %llu"
+       "       GROUP BY \"user\", override, min_qod) AS caches,"
+       "      results"
+       " WHERE results.report = %llu"
+       " AND results.id > %llu"
+       " AND results.qod >= caches.min_qod"
+       " AND NOT EXISTS (SELECT * FROM report_counts AS counts"
+       "                 WHERE counts.report = %llu"
+       "                 AND counts.\"user\" = caches.\"user\""
+       "                 AND counts.override = caches.override"
+       "                 AND counts.min_qod = caches.min_qod"
+       "                 AND counts.severity"
+       "                     = round (results.severity::numeric, 1))"
+       " GROUP BY caches.\"user\", caches.override, caches.min_qod,"
+       "          caches.end_time, round (results.severity::numeric, 1);",
+       report,
+       report,
+       report,
+       after,
+       report);
+
+  /* Remove the dummy entries of caches that are no longer empty. */
+
+  sql ("DELETE FROM report_counts"
+       " WHERE report = %llu"
+       " AND severity = " G_STRINGIFY (SEVERITY_MISSING)
+       " AND count = 0"
+       " AND EXISTS (SELECT * FROM report_counts AS counts"
+       "             WHERE counts.report = report_counts.report"
+       "             AND counts.\"user\" = report_counts.\"user\""
+       "             AND counts.override = report_counts.override"
+       "             AND counts.min_qod = report_counts.min_qod"
+       "             AND counts.count > 0);",
+       report);
+}
+
+/**
+ * @brief Add the overridden counts of the results of an NVT to a report cache.
+ *
+ * An override only changes the severity of results of its own NVT.  So the
+ * cached overridden counts of a report can follow a change to an override
+ * by subtracting the counts of the NVT's results before the change, and
+ * adding them again after the change.  Only caches that already exist are
+ * updated.
+ *
+ * @param[in]  report       Report.
+ * @param[in]  nvt          OID of NVT.
+ * @param[in]  sign         1 to add the counts, -1 to subtract them.
+ * @param[in]  users_where  Optional SQL clause to limit users.
+ */
+static void
+report_counts_add_nvt (report_t report, const char *nvt, int sign,
+                       const char *users_where)
+{
+  iterator_t cache_iterator;
+  gchar *old_user_id;
+
+  old_user_id = current_credentials.uuid;
+  init_report_counts_build_iterator (&cache_iterator, report, INT_MAX, 0,
+                                     users_where);
+  while (next (&cache_iterator))
+    {
+      int min_qod = report_counts_build_iterator_min_qod (&cache_iterator);
+      user_t user = report_counts_build_iterator_user (&cache_iterator);
+      severity_data_t severity_data;
+      get_data_t *get;
+      gchar *filter;
+      int index;
+
+      if (report_counts_build_iterator_override (&cache_iterator) == 0)
+        continue;
+
+      current_credentials.uuid
+        = sql_string ("SELECT uuid FROM users WHERE id = %llu",
+                      user);
+      manage_session_init (current_credentials.uuid);
+
+      get = report_results_get_data (1, -1, 1, min_qod);
+      filter = g_strdup_printf ("%s nvt=\"%s\"", get->filter, nvt);
+      g_free (get->filter);
+      get->filter = filter;
+
+      init_severity_data (&severity_data);
+      report_severity_data (report, NULL, get, NULL, &severity_data);
+
+      for (index = 0;
+           severity_data_value (index) != SEVERITY_MISSING;
+           index++)
+        {
+          rowid_t rowid;
+
+          if (severity_data.counts[index] == 0)
+            continue;
+
+          rowid = 0;
+          sql_int64 (&rowid,
+                     "SELECT id FROM report_counts"
+                     " WHERE report = %llu"
+                     " AND \"user\" = %llu"
+                     " AND override = 1"
+                     " AND severity = %1.1f"
+                     " AND min_qod = %d",
+                     report, user, severity_data_value (index), min_qod);
+          if (rowid)
+            sql ("UPDATE report_counts"
+                 " SET count = count + %d"
+                 " WHERE id = %llu;",
+                 sign * severity_data.counts[index],
+                 rowid);
+          else if (sign > 0)
+            sql ("INSERT INTO report_counts"
+                 " (report, \"user\", override, min_qod, severity, count,"
+                 "  end_time)"
+                 " VALUES"
+                 " (%llu, %llu, 1, %d, %1.1f, %d, 0);",
+                 report, user, min_qod, severity_data_value (index),
+                 severity_data.counts[index]);
+        }
+
+      /* Drop emptied severities, keeping a dummy entry if the cache is
+       * empty now, like cache_report_counts. */
+      sql ("DELETE FROM report_counts"
+           " WHERE report = %llu"
+           " AND \"user\" = %llu"
+           " AND override = 1"
+           " AND min_qod = %d"
+           " AND count <= 0;",
+           report, user, min_qod);
+      sql ("INSERT INTO report_counts"
+           " (report, \"user\", override, min_qod, severity, count, end_time)"
+           " SELECT %llu, %llu, 1, %d, " G_STRINGIFY (SEVERITY_MISSING) ","
+           "        0, 0"
+           " WHERE NOT EXISTS (SELECT * FROM report_counts"
+           "                   WHERE report = %llu"
+           "                   AND \"user\" = %llu"
+           "                   AND override = 1"
+           "                   AND min_qod = %d);",
+           report, user, min_qod, report, user, min_qod);
+
+      cleanup_severity_data (&severity_data);
+      get_data_reset (get);
+      g_free (get);
+      g_free (current_credentials.uuid);
+    }
+  cleanup_iterator (&cache_iterator);
+  current_credentials.uuid = old_user_id;
+  manage_session_init (current_credentials.uuid);
+
+  sql ("UPDATE report_counts"
+       " SET end_time = (SELECT coalesce(min(overrides.end_time), 0)"
+       "                 FROM overrides, results"
+       "                 WHERE overrides.nvt = results.nvt"
+       "                 AND results.report = %llu"
+       "                 AND overrides.end_time >= m_now ())"
+       " WHERE report = %llu AND override = 1;",
+       report, report);
+}
+
+/**
+ * @brief Add the overridden counts of the results of an NVT to report caches.
+ *
+ * @param[in]  reports      Reports, as from reports_for_override.
+ * @param[in]  nvt          OID of NVT.
+ * @param[in]  sign         1 to add the counts, -1 to subtract them.
+ * @param[in]  users_where  Optional SQL clause to limit users.
+ */
+static void
+reports_counts_add_nvt (GHashTable *reports, const char *nvt, int sign,
+                        const char *users_where)
+{
+  GHashTableIter reports_iter;
+  report_t *reports_ptr;
+
+  if (nvt == NULL)
+    return;
+
+  g_hash_table_iter_init (&reports_iter, reports);
+  reports_ptr = NULL;
+  while (g_hash_table_iter_next (&reports_iter,
+                                 ((gpointer*)&reports_ptr), NULL))
+    report_counts_add_nvt (*reports_ptr, nvt, sign, users_where);
+}
+
+/**
+ * @brief Advisory lock class for report count cache updates.
+ *
+ * The first key of the locks taken by reports_counts_lock.  The second key
+ * is the report.
+ */
+#define REPORT_COUNTS_LOCK_CLASS 1
+
+/**
+ * @brief Compare two report pointers by report id.
+ *
+ * @param[in]  one  First report.
+ * @param[in]  two  Second report.
+ *
+ * @return Negative, zero or positive, like strcmp.
+ */
+static gint
+compare_report_pointers (gconstpointer one, gconstpointer two)
+{
+  report_t report_one = *((const report_t *) one);
+  report_t report_two = *((const report_t *) two);
+
+  if (report_one < report_two)
+    return -1;
+  return report_one > report_two;
+}
+
+/**
+ * @brief Serialise incremental count cache updates on reports.
+ *
+ * Takes a transaction level advisory lock on each report, so that another
+ * process that adds count deltas to the same reports waits until this
+ * transaction ends, instead of computing its deltas from counts that are
+ * about to change.  The locks are taken in order of report id, so two
+ * updates cannot deadlock.  The caller must be in a transaction.
+ *
+ * @param[in]  reports  Reports, as from reports_for_override.
+ */
+static void
+reports_counts_lock (GHashTable *reports)
+{
+  GList *list, *node;
+
+  list = g_list_sort (g_hash_table_get_keys (reports),
+                      compare_report_pointers);
+  for (node = list; node; node = node->next)
+    sql ("SELECT pg_advisory_xact_lock (%i, %llu);",
+         REPORT_COUNTS_LOCK_CLASS,
+         *((report_t *) node->data));
+  g_list_free (list);
+}
+
+/**
+ * @brief Fork a background process to update report count caches.
+ *
+ * The caller does the update in the child and then calls
+ * report_counts_update_exit, so that a GMP request can return while the
+ * caches are updated.
+ *
+ * @return 0 in the child, 1 in the parent, -1 if the fork failed, in which
+ *         case the caller should do the update itself.
+ */
+static int
+fork_report_counts_update ()
+{
+  pid_t pid;
+
+  pid = fork ();
+  switch (pid)
+    {
+      case 0:
+        /* Child.
+         *
+         * Fork again so the parent can wait on the child, to prevent
+         * zombies. */
+        cleanup_manage_process (FALSE);
+        pid = fork ();
+        switch (pid)
+          {
+            case 0:
+              /* Grandchild.  Reopen the database (required after fork) and
+               * do the update as the user. */
+              reinit_manage_worker ();
+              proctitle_set ("gvmd: Updating report counts");
+              sql_begin_immediate ();
+              return 0;
+            case -1:
+              /* Grandchild's parent when error. */
+              g_warning ("%s: fork: %s", __func__, strerror (errno));
+              exit (EXIT_FAILURE);
+            default:
+              /* Grandchild's parent.  Exit, to close parent's wait. */
+              g_debug ("%s: %i forked %i", __func__, getpid (), pid);
+              exit (EXIT_SUCCESS);
+          }
+        break;
+      case -1:
+        /* Parent when error. */
+        g_warning ("%s: fork: %s", __func__, strerror (errno));
+        return -1;
+      default:
+        {
+          int status;
+
+          /* Parent.  Wait to prevent zombie, then return to respond to
+           * client. */
+          g_debug ("%s: %i forked %i", __func__, getpid (), pid);
+          while (waitpid (pid, &status, 0) < 0)
+            {
+              if (errno == EINTR)
+                continue;
+              g_warning ("%s: waitpid: %s",
+                         __func__,
+                         strerror (errno));
+              break;
+            }
+          return 1;
+        }
+    }
+  return 1;
+}
+
+/**
+ * @brief Finish a background report count cache update.
+ *
+ * Only to be called in the child of fork_report_counts_update.
+ */
+static void
+report_counts_update_exit ()
+{
+  sql_commit ();
+  exit (EXIT_SUCCESS);
+}
+
 /**
  * @brief Make a report.
  *
@@ -20146,13 +22448,17 @@ report_clear_count_cache (report_t report,
 report_t
 make_report (task_t task, const char* uuid, task_status_t status)
 {
+  report_t report;
+
   sql ("INSERT into reports (uuid, owner, task, creation_time, comment,"
        " scan_run_status, slave_progress)"
        " VALUES ('%s',"
        " (SELECT owner FROM tasks WHERE tasks.id = %llu),"
        " %llu, %i, '', %u, 0);",
        uuid, task, task, time (NULL), status);
-  return sql_last_insert_id ();
+  report = sql_last_insert_id ();
+  results_partition_ensure (report);
+  return report;
 }
 
 /**
@@ -20206,6 +22512,102 @@ host_detail_free (host_detail_t *detail)
   g_free (detail->value);
 }
 
+/**
+ * @brief Start caching the report hosts of a report.
+ *
+ * While the cache is active, the report hosts of the report are looked up
+ * in memory instead of with a query for every result.  Only the current
+ * process may add report hosts to the report while the cache is active.
+ *
+ * @param[in]  report  Report.
+ */
+void
+report_host_cache_init (report_t report)
+{
+  report_host_cache_free ();
+  report_host_cache_report = report;
+  report_host_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, g_free);
+}
+
+/**
+ * @brief Stop caching report hosts.
+ */
+void
+report_host_cache_free ()
+{
+  if (report_host_cache)
+    {
+      g_hash_table_destroy (report_host_cache);
+      report_host_cache = NULL;
+    }
+  report_host_cache_report = 0;
+}
+
+/**
+ * @brief Check whether the report hosts of a report are being cached.
+ *
+ * @param[in]  report  Report.
+ *
+ * @return 1 if cached, else 0.
+ */
+int
+report_host_cache_active (report_t report)
+{
+  return report_host_cache && report && report == report_host_cache_report;
+}
+
+/**
+ * @brief Remember a report host in the report host cache.
+ *
+ * @param[in]  host         Host.
+ * @param[in]  report_host  Report host.
+ */
+static void
+report_host_cache_add (const char *host, report_host_t report_host)
+{
+  report_host_t *value;
+
+  value = g_malloc (sizeof (*value));
+  *value = report_host;
+  g_hash_table_insert (report_host_cache, g_strdup (host), value);
+}
+
+/**
+ * @brief Get a report host, using the report host cache.
+ *
+ * @param[in]  report  Report.
+ * @param[in]  host    Host.
+ *
+ * @return Report host, 0 if the cache is not active for the report or the
+ *         report does not have the host.
+ */
+static report_host_t
+report_host_cache_lookup (report_t report, const char *host)
+{
+  report_host_t *value, report_host;
+  gchar *quoted_host;
+
+  if (report_host_cache_active (report) == 0)
+    return 0;
+
+  value = g_hash_table_lookup (report_host_cache, host);
+  if (value)
+    return *value;
+
+  quoted_host = sql_quote (host);
+  report_host = 0;
+  sql_int64 (&report_host,
+             "SELECT id FROM report_hosts"
+             " WHERE report = %llu AND host = '%s';",
+             report, quoted_host);
+  g_free (quoted_host);
+
+  if (report_host)
+    report_host_cache_add (host, report_host);
+  return report_host;
+}
+
 /**
  * @brief Insert a host detail into a report.
  *
@@ -20225,6 +22627,7 @@ insert_report_host_detail (report_t report, const char *host,
 {
   char *quoted_host, *quoted_source_name, *quoted_source_type;
   char *quoted_source_desc, *quoted_name, *quoted_value;
+  report_host_t report_host;
 
   quoted_host = sql_quote (host);
   quoted_source_type = sql_quote (s_type);
@@ -20232,15 +22635,25 @@ insert_report_host_detail (report_t report, const char *host,
   quoted_source_desc = sql_quote (s_desc);
   quoted_name = sql_quote (name);
   quoted_value = sql_quote (value);
-  sql ("INSERT INTO report_host_details"
-       " (report_host, source_type, source_name, source_description,"
-       "  name, value)"
-       " VALUES"
-       " ((SELECT id FROM report_hosts"
-       "   WHERE report = %llu AND host = '%s'),"
-       "  '%s', '%s', '%s', '%s', '%s');",
-       report, quoted_host, quoted_source_type, quoted_source_name,
-       quoted_source_desc, quoted_name, quoted_value);
+  report_host = report_host_cache_lookup (report, host);
+  if (report_host)
+    sql ("INSERT INTO report_host_details"
+         " (report_host, source_type, source_name, source_description,"
+         "  name, value)"
+         " VALUES"
+         " (%llu, '%s', '%s', '%s', '%s', '%s');",
+         report_host, quoted_source_type, quoted_source_name,
+         quoted_source_desc, quoted_name, quoted_value);
+  else
+    sql ("INSERT INTO report_host_details"
+         " (report_host, source_type, source_name, source_description,"
+         "  name, value)"
+         " VALUES"
+         " ((SELECT id FROM report_hosts"
+         "   WHERE report = %llu AND host = '%s'),"
+         "  '%s', '%s', '%s', '%s', '%s');",
+         report, quoted_host, quoted_source_type, quoted_source_name,
+         quoted_source_desc, quoted_name, quoted_value);
 
   g_free (quoted_host);
   g_free (quoted_source_type);
@@ -20266,46 +22679,155 @@ insert_report_host_detail (report_t report, const char *host,
 #define CREATE_REPORT_CHUNK_SLEEP 1000
 
 /**
- * @brief Create a report from an array of results.
+ * @brief Insert results into a report that is being imported.
  *
- * @param[in]   results       Array of create_report_result_t pointers.
- * @param[in]   task_id       UUID of container task, or NULL to create new one.
- * @param[in]   in_assets     Whether to create assets from the report.
- * @param[in]   scan_start    Scan start time text.
- * @param[in]   scan_end      Scan end time text.
- * @param[in]   host_starts   Array of create_report_result_t pointers.  Host
- *                            name in host, time in description.
- * @param[in]   host_ends     Array of create_report_result_t pointers.  Host
- *                            name in host, time in description.
- * @param[in]   details       Array of host_detail_t pointers.
- * @param[out]  report_id     Report ID.
+ * Must be called in a transaction.  Commits after every chunk and leaves a
+ * new transaction open.
  *
- * @return 0 success, 99 permission denied, -1 error, -2 failed to generate ID,
- *         -3 task_id is NULL, -4 failed to find task, -5 task must be
- *         container, -6 permission to create assets denied.
+ * @param[in]  report   Report.
+ * @param[in]  task     Task of report.
+ * @param[in]  owner    Owner of task.
+ * @param[in]  results  Array of create_report_result_t pointers.  May be
+ *                      NULL terminated.
  */
-int
-create_report (array_t *results, const char *task_id, const char *in_assets,
-               const char *scan_start, const char *scan_end,
-               array_t *host_starts, array_t *host_ends, array_t *details,
-               char **report_id)
+static void
+create_report_insert_results (report_t report, task_t task, user_t owner,
+                              array_t *results)
 {
-  int index, in_assets_int, count, insert_count, first, rc;
-  create_report_result_t *result, *end, *start;
-  report_t report;
-  user_t owner;
-  task_t task;
-  pid_t pid;
-  host_detail_t *detail;
+  create_report_result_t *result;
   GString *insert;
+  guint index;
+  int first, insert_count, count;
 
-  in_assets_int
-    = (in_assets && strcmp (in_assets, "") && strcmp (in_assets, "0"));
+  insert = g_string_new ("");
+  first = 1;
+  insert_count = 0;
+  count = 0;
+  for (index = 0; index < results->len; index++)
+    {
+      gchar *quoted_host, *quoted_hostname, *quoted_port, *quoted_nvt_oid;
+      gchar *quoted_description, *quoted_scan_nvt_version, *quoted_severity;
+      gchar *quoted_qod, *quoted_qod_type;
 
-  if (in_assets_int && acl_user_may ("create_asset") == 0)
-    return -6;
+      result = (create_report_result_t*) g_ptr_array_index (results, index);
+      if (result == NULL)
+        break;
+      g_debug ("%s: index: %u", __func__, index);
 
-  g_debug ("%s", __func__);
+      quoted_host = sql_quote (result->host ? result->host : "");
+      quoted_hostname = sql_quote (result->hostname ? result->hostname : "");
+      quoted_port = sql_quote (result->port ? result->port : "");
+      quoted_nvt_oid = sql_quote (result->nvt_oid ? result->nvt_oid : "");
+      quoted_description = sql_quote (result->description
+                                       ? result->description
+                                       : "");
+      quoted_scan_nvt_version = sql_quote (result->scan_nvt_version
+                                       ? result->scan_nvt_version
+                                       : "");
+      quoted_severity =  sql_quote (result->severity ? result->severity : "");
+      if (result->qod && strcmp (result->qod, "") && strcmp (result->qod, "0"))
+        quoted_qod = sql_quote (result->qod);
+      else
+        quoted_qod = g_strdup (G_STRINGIFY (QOD_DEFAULT));
+      quoted_qod_type = sql_quote (result->qod_type ? result->qod_type : "");
+      result_nvt_notice (quoted_nvt_oid);
+
+      if (first)
+        g_string_append (insert,
+                         "INSERT INTO results"
+                         " (uuid, owner, date, task, host, hostname, port,"
+                         "  nvt, type, description,"
+                         "  nvt_version, severity, qod, qod_type,"
+                         "  result_nvt, report)"
+                         " VALUES");
+      else
+        g_string_append (insert, ", ");
+      first = 0;
+      g_string_append_printf (insert,
+                              " (make_uuid (), %llu, m_now (), %llu, '%s',"
+                              "  '%s', '%s', '%s', '%s', '%s', '%s', '%s',"
+                              "  '%s', '%s',"
+                              "  (SELECT id FROM result_nvts WHERE nvt = '%s'),"
+                              "  %llu)",
+                              owner,
+                              task,
+                              quoted_host,
+                              quoted_hostname,
+                              quoted_port,
+                              quoted_nvt_oid,
+                              result->threat
+                               ? threat_message_type (result->threat)
+                               : "Log Message",
+                              quoted_description,
+                              quoted_scan_nvt_version,
+                              quoted_severity,
+                              quoted_qod,
+                              quoted_qod_type,
+                              quoted_nvt_oid,
+                              report);
+
+      /* Limit the number of results inserted at a time. */
+      if (insert_count == CREATE_REPORT_INSERT_SIZE)
+        {
+          sql ("%s", insert->str);
+          g_string_truncate (insert, 0);
+          count++;
+          insert_count = 0;
+          first = 1;
+
+          if (count == CREATE_REPORT_CHUNK_SIZE)
+            {
+              report_cache_counts (report, 1, 1, NULL);
+              sql_commit ();
+              gvm_usleep (CREATE_REPORT_CHUNK_SLEEP);
+              sql_begin_immediate ();
+              count = 0;
+            }
+        }
+      insert_count++;
+
+      g_free (quoted_host);
+      g_free (quoted_hostname);
+      g_free (quoted_port);
+      g_free (quoted_nvt_oid);
+      g_free (quoted_description);
+      g_free (quoted_scan_nvt_version);
+      g_free (quoted_severity);
+      g_free (quoted_qod);
+      g_free (quoted_qod_type);
+    }
+
+  if (first == 0)
+    {
+      sql ("%s", insert->str);
+      report_cache_counts (report, 1, 1, NULL);
+      sql_commit ();
+      gvm_usleep (CREATE_REPORT_CHUNK_SLEEP);
+      sql_begin_immediate ();
+    }
+  g_string_free (insert, TRUE);
+}
+
+/**
+ * @brief Start a report import that adds results while they are parsed.
+ *
+ * Creates the report in the container task, so that results can be added
+ * with \ref create_report_stream_add before \ref create_report finishes
+ * the import.
+ *
+ * @param[in]   task_id  UUID of container task.
+ * @param[out]  report   Report.
+ *
+ * @return 0 success, 99 permission denied, -1 error, -2 failed to generate ID,
+ *         -3 task_id is NULL, -4 failed to find task, -5 task must be
+ *         container.
+ */
+int
+create_report_stream_start (const char *task_id, report_t *report)
+{
+  task_t task;
+  char *uuid;
+  int rc;
 
   if (acl_user_may ("create_report") == 0)
     return 99;
@@ -20315,13 +22837,7 @@ create_report (array_t *results, const char *task_id, const char *in_assets,
 
   sql_begin_immediate ();
 
-  /* Find the task. */
-
   rc = 0;
-
-  /* It's important that the task is not in the trash, because we
-   * are inserting results below.  This find function will fail if
-   * the task is in the trash. */
   if (find_task_with_permission (task_id, &task, "modify_task"))
     rc = -1;
   else if (task == 0)
@@ -20334,35 +22850,202 @@ create_report (array_t *results, const char *task_id, const char *in_assets,
       return rc;
     }
 
-  /* Generate report UUID. */
-
-  *report_id = gvm_uuid_make ();
-  if (*report_id == NULL) return -2;
-
-  /* Create the report. */
-
-  report = make_report (task, *report_id, TASK_STATUS_RUNNING);
-
-  if (scan_start)
+  uuid = gvm_uuid_make ();
+  if (uuid == NULL)
     {
-      sql ("UPDATE reports SET start_time = %i WHERE id = %llu;",
-           parse_iso_time (scan_start),
-           report);
+      sql_rollback ();
+      return -2;
     }
 
-  if (scan_end)
-    {
-      sql ("UPDATE reports SET end_time = %i WHERE id = %llu;",
-           parse_iso_time (scan_end),
-           report);
-    }
-
-  /* Show that the upload has started. */
+  *report = make_report (task, uuid, TASK_STATUS_RUNNING);
+  free (uuid);
 
   set_task_run_status (task, TASK_STATUS_RUNNING);
-  sql ("UPDATE tasks SET upload_result_count = %llu WHERE id = %llu;",
+  sql ("UPDATE tasks SET upload_result_count = 0 WHERE id = %llu;",
+       task);
+  sql_commit ();
+  return 0;
+}
+
+/**
+ * @brief Add results to a report started with \ref create_report_stream_start.
+ *
+ * @param[in]  report   Report.
+ * @param[in]  results  Array of create_report_result_t pointers.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+create_report_stream_add (report_t report, array_t *results)
+{
+  task_t task;
+  user_t owner;
+
+  if (report_task (report, &task) || task == 0)
+    return -1;
+
+  if (sql_int64 (&owner,
+                 "SELECT owner FROM tasks WHERE tasks.id = %llu",
+                 task))
+    {
+      g_warning ("%s: failed to get owner of task", __func__);
+      return -1;
+    }
+
+  sql_begin_immediate ();
+  sql ("UPDATE tasks SET upload_result_count = upload_result_count + %u"
+       " WHERE id = %llu;",
        results->len,
        task);
+  create_report_insert_results (report, task, owner, results);
+  sql_commit ();
+  return 0;
+}
+
+/**
+ * @brief Give up on a report started with \ref create_report_stream_start.
+ *
+ * @param[in]  report  Report.
+ */
+void
+create_report_stream_abort (report_t report)
+{
+  task_t task;
+
+  if (report_task (report, &task) || task == 0)
+    return;
+
+  global_current_report = report;
+  set_task_interrupted (task,
+                        "Report import was not completed."
+                        "  Setting task status to Interrupted.");
+  global_current_report = 0;
+}
+
+/**
+ * @brief Create a report from an array of results.
+ *
+ * @param[in]   results       Array of create_report_result_t pointers.
+ * @param[in]   task_id       UUID of container task, or NULL to create new one.
+ * @param[in]   in_assets     Whether to create assets from the report.
+ * @param[in]   scan_start    Scan start time text.
+ * @param[in]   scan_end      Scan end time text.
+ * @param[in]   host_starts   Array of create_report_result_t pointers.  Host
+ *                            name in host, time in description.
+ * @param[in]   host_ends     Array of create_report_result_t pointers.  Host
+ *                            name in host, time in description.
+ * @param[in]   details       Array of host_detail_t pointers.
+ * @param[in]   stream_report  Report from \ref create_report_stream_start,
+ *                             or 0.  If given, task_id is ignored.
+ * @param[out]  report_id     Report ID.
+ *
+ * @return 0 success, 99 permission denied, -1 error, -2 failed to generate ID,
+ *         -3 task_id is NULL, -4 failed to find task, -5 task must be
+ *         container, -6 permission to create assets denied.
+ */
+int
+create_report (array_t *results, const char *task_id, const char *in_assets,
+               const char *scan_start, const char *scan_end,
+               array_t *host_starts, array_t *host_ends, array_t *details,
+               report_t stream_report, char **report_id)
+{
+  int index, in_assets_int, count, insert_count, first, rc;
+  create_report_result_t *end, *start;
+  report_t report;
+  user_t owner;
+  task_t task;
+  pid_t pid;
+  host_detail_t *detail;
+  GString *insert;
+  GPtrArray *host_end_ips;
+
+  in_assets_int
+    = (in_assets && strcmp (in_assets, "") && strcmp (in_assets, "0"));
+
+  if (in_assets_int && acl_user_may ("create_asset") == 0)
+    return -6;
+
+  g_debug ("%s", __func__);
+
+  if (acl_user_may ("create_report") == 0)
+    return 99;
+
+  if (stream_report)
+    {
+      /* The report was created when the import started. */
+
+      report = stream_report;
+      if (report_task (report, &task) || task == 0)
+        return -1;
+      *report_id = report_uuid (report);
+      if (*report_id == NULL)
+        return -1;
+
+      sql_begin_immediate ();
+    }
+  else
+    {
+      if (task_id == NULL)
+        return -3;
+
+      sql_begin_immediate ();
+
+      /* Find the task. */
+
+      rc = 0;
+
+      /* It's important that the task is not in the trash, because we
+       * are inserting results below.  This find function will fail if
+       * the task is in the trash. */
+      if (find_task_with_permission (task_id, &task, "modify_task"))
+        rc = -1;
+      else if (task == 0)
+        rc = -4;
+      else if (task_target (task))
+        rc = -5;
+      if (rc)
+        {
+          sql_rollback ();
+          return rc;
+        }
+
+      /* Generate report UUID. */
+
+      *report_id = gvm_uuid_make ();
+      if (*report_id == NULL) return -2;
+
+      /* Create the report. */
+
+      report = make_report (task, *report_id, TASK_STATUS_RUNNING);
+    }
+
+  if (scan_start)
+    {
+      sql ("UPDATE reports SET start_time = %i WHERE id = %llu;",
+           parse_iso_time (scan_start),
+           report);
+    }
+
+  if (scan_end)
+    {
+      sql ("UPDATE reports SET end_time = %i WHERE id = %llu;",
+           parse_iso_time (scan_end),
+           report);
+    }
+
+  /* Show that the upload has started. */
+
+  set_task_run_status (task, TASK_STATUS_RUNNING);
+  if (stream_report)
+    /* Results already added are counted by create_report_stream_add. */
+    sql ("UPDATE tasks SET upload_result_count = upload_result_count + %u"
+         " WHERE id = %llu;",
+         results->len,
+         task);
+  else
+    sql ("UPDATE tasks SET upload_result_count = %llu WHERE id = %llu;",
+         results->len,
+         task);
   sql_commit ();
 
   /* Fork a child to import the results while the parent responds to the
@@ -20458,110 +23141,7 @@ create_report (array_t *results, const char *task_id, const char *in_assets,
                               0);
 
   g_debug ("%s: add results", __func__);
-  insert = g_string_new ("");
-  index = 0;
-  first = 1;
-  insert_count = 0;
-  count = 0;
-  while ((result = (create_report_result_t*) g_ptr_array_index (results,
-                                                                index++)))
-    {
-      gchar *quoted_host, *quoted_hostname, *quoted_port, *quoted_nvt_oid;
-      gchar *quoted_description, *quoted_scan_nvt_version, *quoted_severity;
-      gchar *quoted_qod, *quoted_qod_type;
-      g_debug ("%s: add results: index: %i", __func__, index);
-
-      quoted_host = sql_quote (result->host ? result->host : "");
-      quoted_hostname = sql_quote (result->hostname ? result->hostname : "");
-      quoted_port = sql_quote (result->port ? result->port : "");
-      quoted_nvt_oid = sql_quote (result->nvt_oid ? result->nvt_oid : "");
-      quoted_description = sql_quote (result->description
-                                       ? result->description
-                                       : "");
-      quoted_scan_nvt_version = sql_quote (result->scan_nvt_version
-                                       ? result->scan_nvt_version
-                                       : "");
-      quoted_severity =  sql_quote (result->severity ? result->severity : "");
-      if (result->qod && strcmp (result->qod, "") && strcmp (result->qod, "0"))
-        quoted_qod = sql_quote (result->qod);
-      else
-        quoted_qod = g_strdup (G_STRINGIFY (QOD_DEFAULT));
-      quoted_qod_type = sql_quote (result->qod_type ? result->qod_type : "");
-      result_nvt_notice (quoted_nvt_oid);
-
-      if (first)
-        g_string_append (insert,
-                         "INSERT INTO results"
-                         " (uuid, owner, date, task, host, hostname, port,"
-                         "  nvt, type, description,"
-                         "  nvt_version, severity, qod, qod_type,"
-                         "  result_nvt, report)"
-                         " VALUES");
-      else
-        g_string_append (insert, ", ");
-      first = 0;
-      g_string_append_printf (insert,
-                              " (make_uuid (), %llu, m_now (), %llu, '%s',"
-                              "  '%s', '%s', '%s', '%s', '%s', '%s', '%s',"
-                              "  '%s', '%s',"
-                              "  (SELECT id FROM result_nvts WHERE nvt = '%s'),"
-                              "  %llu)",
-                              owner,
-                              task,
-                              quoted_host,
-                              quoted_hostname,
-                              quoted_port,
-                              quoted_nvt_oid,
-                              result->threat
-                               ? threat_message_type (result->threat)
-                               : "Log Message",
-                              quoted_description,
-                              quoted_scan_nvt_version,
-                              quoted_severity,
-                              quoted_qod,
-                              quoted_qod_type,
-                              quoted_nvt_oid,
-                              report);
-
-      /* Limit the number of results inserted at a time. */
-      if (insert_count == CREATE_REPORT_INSERT_SIZE)
-        {
-          sql ("%s", insert->str);
-          g_string_truncate (insert, 0);
-          count++;
-          insert_count = 0;
-          first = 1;
-
-          if (count == CREATE_REPORT_CHUNK_SIZE)
-            {
-              report_cache_counts (report, 1, 1, NULL);
-              sql_commit ();
-              gvm_usleep (CREATE_REPORT_CHUNK_SLEEP);
-              sql_begin_immediate ();
-              count = 0;
-            }
-        }
-      insert_count++;
-
-      g_free (quoted_host);
-      g_free (quoted_hostname);
-      g_free (quoted_port);
-      g_free (quoted_nvt_oid);
-      g_free (quoted_description);
-      g_free (quoted_scan_nvt_version);
-      g_free (quoted_severity);
-      g_free (quoted_qod);
-      g_free (quoted_qod_type);
-    }
-
-  if (first == 0)
-    {
-      sql ("%s", insert->str);
-      report_cache_counts (report, 1, 1, NULL);
-      sql_commit ();
-      gvm_usleep (CREATE_REPORT_CHUNK_SLEEP);
-      sql_begin_immediate ();
-    }
+  create_report_insert_results (report, task, owner, results);
 
   sql ("INSERT INTO result_nvt_reports (result_nvt, report)"
        " SELECT distinct result_nvt, %llu FROM results"
@@ -20609,7 +23189,7 @@ create_report (array_t *results, const char *task_id, const char *in_assets,
   first = 1;
   count = 0;
   insert_count = 0;
-  g_string_truncate (insert, 0);
+  insert = g_string_new ("");
   while ((detail = (host_detail_t*) g_ptr_array_index (details, index++)))
     if (detail->ip && detail->name)
       {
@@ -20671,16 +23251,14 @@ create_report (array_t *results, const char *task_id, const char *in_assets,
   sql_commit ();
 
   index = 0;
-  sql_begin_immediate ();
+  host_end_ips = g_ptr_array_new ();
   while ((end = (create_report_result_t*) g_ptr_array_index (host_ends,
                                                              index++)))
     if (end->host)
-      {
-        sql_commit ();
-        gvm_usleep (CREATE_REPORT_CHUNK_SLEEP);
-        add_assets_from_host_in_report (report, end->host);
-        sql_begin_immediate ();
-      }
+      g_ptr_array_add (host_end_ips, end->host);
+  sql_begin_immediate ();
+  add_assets_from_hosts_in_report (report, host_end_ips);
+  g_ptr_array_free (host_end_ips, TRUE);
 
   if (first == 0)
     sql ("%s", insert->str);
@@ -21235,8 +23813,13 @@ void
 init_report_iterator_task (iterator_t* iterator, task_t task)
 {
   assert (task);
+  /* Include reports waiting for the reaper, because their results still
+   * refer to the task. */
   init_iterator (iterator,
-                 "SELECT id, uuid FROM reports WHERE task = %llu;",
+                 "SELECT id, uuid FROM reports WHERE task = %llu"
+                 " OR id IN (SELECT report FROM report_deletions"
+                 "           WHERE task = %llu);",
+                 task,
                  task);
 }
 
@@ -21859,6 +24442,13 @@ results_extra_where (int trash, report_t report, const gchar* host,
   g_free (levels);
   g_free (new_severity_sql);
 
+  /* Results of reports waiting for the reaper.  A single report can only
+   * be reached while it still exists, so this is only needed without it. */
+  if (report_clause == NULL)
+    report_clause = g_strdup (" AND NOT EXISTS (SELECT * FROM report_deletions"
+                              "                 WHERE report_deletions.report"
+                              "                       = results.report)");
+
   extra_where = g_strdup_printf("%s%s%s%s",
                                 report_clause ? report_clause : "",
                                 host_clause ? host_clause : "",
@@ -21873,6 +24463,25 @@ results_extra_where (int trash, report_t report, const gchar* host,
   return extra_where;
 }
 
+/**
+ * @brief SQL for getting current severity.
+ *
+ * Requires CURRENT_SEVERITY_JOIN in the FROM clause.
+ */
+#define CURRENT_SEVERITY_SQL                                            \
+  "coalesce ((CASE WHEN results.severity > " G_STRINGIFY (SEVERITY_LOG) \
+  "           THEN nvt_current_severities.severity"                     \
+  "           ELSE results.severity"                                    \
+  "           END),"                                                    \
+  "          results.severity)"
+
+/**
+ * @brief Join for CURRENT_SEVERITY_SQL.
+ */
+#define CURRENT_SEVERITY_JOIN                                           \
+  " LEFT OUTER JOIN nvt_current_severities"                             \
+  " ON results.nvt = nvt_current_severities.nvt"
+
 /**
  * @brief Initialise the severity-only result iterator.
  *
@@ -21967,34 +24576,12 @@ init_result_get_iterator_severity (iterator_t* iterator, const get_data_t *get,
             "                OR valid_overrides.port"
             "                   = results.port)"
             "           AND severity_matches_ov"
-            "                (coalesce"
-            "                  ((CASE WHEN results.severity"
-            "                              > " G_STRINGIFY
-                                                             (SEVERITY_LOG)
-            "                    THEN CAST (nvts.cvss_base"
-            "                               AS double precision)"
-            "                    ELSE results.severity"
-            "                    END),"
-            "                   results.severity),"
+            "                (" CURRENT_SEVERITY_SQL ","
             "                 valid_overrides.severity)"
             "           LIMIT 1),"
-            "          coalesce ((CASE WHEN results.severity"
-            "                               > " G_STRINGIFY
-                                                              (SEVERITY_LOG)
-            "                     THEN CAST (nvts.cvss_base"
-            "                                AS double precision)"
-            "                     ELSE results.severity"
-            "                     END),"
-            "                    results.severity))";
+            "          " CURRENT_SEVERITY_SQL ")";
       else
-        lateral
-          = "coalesce ((CASE WHEN results.severity"
-            "                     > " G_STRINGIFY (SEVERITY_LOG)
-            "                THEN CAST (nvts.cvss_base"
-            "                           AS double precision)"
-            "                ELSE results.severity"
-            "                END),"
-            "          results.severity)";
+        lateral = CURRENT_SEVERITY_SQL;
     }
   else
     {
@@ -22037,8 +24624,7 @@ init_result_get_iterator_severity (iterator_t* iterator, const get_data_t *get,
   opts = result_iterator_opts_table (apply_overrides,
                                      dynamic_severity);
   if (dynamic_severity)
-    extra_tables = g_strdup_printf (" LEFT OUTER JOIN nvts"
-                                    " ON results.nvt = nvts.oid,"
+    extra_tables = g_strdup_printf (CURRENT_SEVERITY_JOIN ","
                                     " LATERAL %s AS lateral_severity%s",
                                     lateral, opts);
   else
@@ -22133,16 +24719,6 @@ init_result_get_iterator_severity (iterator_t* iterator, const get_data_t *get,
   return ret;
 }
 
-/**
- * @brief SQL for getting current severity.
- */
-#define CURRENT_SEVERITY_SQL                                            \
-  "coalesce ((CASE WHEN results.severity > " G_STRINGIFY (SEVERITY_LOG) \
-  "           THEN CAST (nvts.cvss_base AS double precision)"           \
-  "           ELSE results.severity"                                    \
-  "           END),"                                                    \
-  "          results.severity)"
-
 /**
  * @brief Get LATERAL clause for result iterator.
  *
@@ -22235,8 +24811,11 @@ init_result_get_iterator (iterator_t* iterator, const get_data_t *get,
 
   opts_tables = result_iterator_opts_table (apply_overrides, dynamic_severity);
   extra_tables = g_strdup_printf (" LEFT OUTER JOIN nvts"
-                                  " ON results.nvt = nvts.oid %s,"
+                                  " ON results.nvt = nvts.oid%s %s,"
                                   " LATERAL %s AS lateral_new_severity",
+                                  dynamic_severity
+                                   ? CURRENT_SEVERITY_JOIN
+                                   : "",
                                   opts_tables,
                                   result_iterator_lateral (apply_overrides,
                                                            dynamic_severity));
@@ -22276,6 +24855,10 @@ init_result_get_iterator (iterator_t* iterator, const get_data_t *get,
   g_free (extra_where);
   g_free (extra_where_single);
 
+  /* A whole report can have millions of results. */
+  if (ret == 0 && get->id == NULL && host == NULL)
+    iterator_use_cursor (iterator);
+
   g_debug ("%s: done", __func__);
 
   return ret;
@@ -22318,8 +24901,11 @@ result_count (const get_data_t *get, report_t report, const char* host)
 
   opts_tables = result_iterator_opts_table (apply_overrides, dynamic_severity);
   extra_tables = g_strdup_printf (" LEFT OUTER JOIN nvts"
-                                  " ON results.nvt = nvts.oid %s,"
+                                  " ON results.nvt = nvts.oid%s %s,"
                                   " LATERAL %s AS lateral_new_severity",
+                                  dynamic_severity
+                                   ? CURRENT_SEVERITY_JOIN
+                                   : "",
                                   opts_tables,
                                   result_iterator_lateral (apply_overrides,
                                                            dynamic_severity));
@@ -22862,24 +25448,25 @@ result_iterator_nvt_solution_method (iterator_t *iterator)
 void
 xml_append_nvt_refs (GString *xml, const char *oid, int *first)
 {
-  nvti_t *nvti = lookup_nvti (oid);
-  int i;
+  const nvti_image_nvt_t *nvti = lookup_nvti (oid);
+  const nvti_image_ref_t *refs;
+  guint32 i;
 
   if (!nvti)
     return;
 
-  for (i = 0; i < nvti_vtref_len (nvti); i++)
+  refs = nvti_image_refs (nvti_cache) + nvti->refs;
+  for (i = 0; i < nvti->ref_count; i++)
     {
-      vtref_t *ref;
-
       if (first && *first)
         {
           xml_string_append (xml, "<refs>");
           *first = 0;
         }
 
-      ref = nvti_vtref (nvti, i);
-      xml_string_append (xml, "<ref type=\"%s\" id=\"%s\"/>", vtref_type (ref), vtref_id (ref));
+      xml_string_append (xml, "<ref type=\"%s\" id=\"%s\"/>",
+                         nvti_image_string (nvti_cache, refs[i].type),
+                         nvti_image_string (nvti_cache, refs[i].id));
     }
 }
 
@@ -23016,6 +25603,8 @@ init_report_host_iterator (iterator_t* iterator, report_t report, const char *ho
                        host ? " AND host = '" : "",
                        host ? host : "",
                        host ? "'" : "");
+      if (host == NULL)
+        iterator_use_cursor (iterator);
     }
   else
     {
@@ -23612,6 +26201,21 @@ set_scan_host_end_time_ctime (report_t report, const char* host,
                             const char* timestamp)
 {
   gchar *quoted_host;
+  report_host_t report_host;
+
+  report_host = report_host_cache_lookup (report, host);
+  if (report_host)
+    {
+      sql ("UPDATE report_hosts SET end_time = %i WHERE id = %llu;",
+           parse_utc_ctime (timestamp), report_host);
+      return;
+    }
+  if (report_host_cache_active (report))
+    {
+      manage_report_host_add (report, host, 0, parse_utc_ctime (timestamp));
+      return;
+    }
+
   quoted_host = sql_quote (host);
   if (sql_int ("SELECT COUNT(*) FROM report_hosts"
                " WHERE report = %llu AND host = '%s';",
@@ -23636,6 +26240,21 @@ set_scan_host_start_time_ctime (report_t report, const char* host,
                               const char* timestamp)
 {
   gchar *quoted_host;
+  report_host_t report_host;
+
+  report_host = report_host_cache_lookup (report, host);
+  if (report_host)
+    {
+      sql ("UPDATE report_hosts SET start_time = %i WHERE id = %llu;",
+           parse_utc_ctime (timestamp), report_host);
+      return;
+    }
+  if (report_host_cache_active (report))
+    {
+      manage_report_host_add (report, host, parse_utc_ctime (timestamp), 0);
+      return;
+    }
+
   quoted_host = sql_quote (host);
   if (sql_int ("SELECT COUNT(*) FROM report_hosts"
                " WHERE report = %llu AND host = '%s';",
@@ -23689,6 +26308,42 @@ report_scan_run_status (report_t report, task_status_t* status)
   return 0;
 }
 
+/**
+ * @brief Add the NVTs of the results of a report to the materialized vulns.
+ *
+ * Stale NVTs are harmless, because vuln listings check that results exist,
+ * so the table only ever grows between refreshes.
+ *
+ * @param[in]  report  Report.
+ */
+static void
+vuln_nvts_add_report (report_t report)
+{
+  if (sql_int ("SELECT count (*) FROM meta"
+               " WHERE name = 'vulns_materialized' AND value = '1';")
+      == 0)
+    return;
+
+  sql ("INSERT INTO vuln_nvts (nvt)"
+       " SELECT DISTINCT nvt FROM results"
+       " WHERE report = %llu"
+       " AND severity != " G_STRINGIFY (SEVERITY_ERROR)
+       " ON CONFLICT (nvt) DO NOTHING;",
+       report);
+}
+
+/**
+ * @brief Refill the materialized vulns from all results.
+ */
+static void
+vuln_nvts_refresh ()
+{
+  sql ("DELETE FROM vuln_nvts;");
+  sql ("INSERT INTO vuln_nvts (nvt)"
+       " SELECT DISTINCT nvt FROM results"
+       " WHERE severity != " G_STRINGIFY (SEVERITY_ERROR) ";");
+}
+
 /**
  * @brief Return the run status of the scan associated with a report.
  *
@@ -23706,6 +26361,10 @@ set_report_scan_run_status (report_t report, task_status_t status)
        report);
   if (setting_auto_cache_rebuild_int ())
     report_cache_counts (report, 0, 0, NULL);
+  if (status == TASK_STATUS_DONE
+      || status == TASK_STATUS_STOPPED
+      || status == TASK_STATUS_INTERRUPTED)
+    vuln_nvts_add_report (report);
   return 0;
 }
 
@@ -23741,6 +26400,8 @@ report_severity_data (report_t report, const char *host,
                       severity_data_t* filtered_severity_data)
 {
   iterator_t results;
+  double severities[SEVERITY_DATA_BATCH];
+  int count;
 
   gchar *filter;
   int apply_overrides;
@@ -23766,17 +26427,17 @@ report_severity_data (report_t report, const char *host,
       ignore_max_rows_per_page = 1;
       init_result_get_iterator_severity (&results, get_all, report, host, NULL);
       ignore_max_rows_per_page = 0;
+      count = 0;
       while (next (&results))
         {
-          double severity;
-
-          if (results.done)
-            severity = 0.0;
-          else
-            severity = iterator_double (&results, 0);
-
-          severity_data_add (severity_data, severity);
+          severities[count++] = iterator_double (&results, 0);
+          if (count == SEVERITY_DATA_BATCH)
+            {
+              severity_data_add_batch (severity_data, severities, count);
+              count = 0;
+            }
         }
+      severity_data_add_batch (severity_data, severities, count);
       cleanup_iterator (&results);
       get_data_reset (get_all);
       free (get_all);
@@ -23796,17 +26457,17 @@ report_severity_data (report_t report, const char *host,
       init_result_get_iterator_severity (&results, &get_filtered, report, host,
                                          NULL);
       ignore_max_rows_per_page = 0;
+      count = 0;
       while (next (&results))
         {
-          double severity;
-
-          if (results.done)
-            severity = 0.0;
-          else
-            severity = iterator_double (&results, 0);
-
-          severity_data_add (filtered_severity_data, severity);
+          severities[count++] = iterator_double (&results, 0);
+          if (count == SEVERITY_DATA_BATCH)
+            {
+              severity_data_add_batch (filtered_severity_data, severities, count);
+              count = 0;
+            }
         }
+      severity_data_add_batch (filtered_severity_data, severities, count);
       cleanup_iterator (&results);
     }
 }
@@ -24247,79 +26908,43 @@ report_severity (report_t report, int overrides, int min_qod)
 }
 
 /**
- * @brief Delete a report.
- *
- * It's up to the caller to provide the transaction.
+ * @brief Check whether a report is in use by a scan.
  *
  * @param[in]  report  Report.
  *
- * @return 0 success, 2 report is in use, -1 error.
+ * @return 1 if in use, else 0.
  */
-int
-delete_report_internal (report_t report)
+static int
+report_busy (report_t report)
 {
-  task_t task;
-
-  if (sql_int ("SELECT count(*) FROM reports WHERE id = %llu"
-               " AND (scan_run_status = %u OR scan_run_status = %u"
-               " OR scan_run_status = %u OR scan_run_status = %u"
-               " OR scan_run_status = %u);",
-               report,
-               TASK_STATUS_RUNNING,
-               TASK_STATUS_QUEUED,
-               TASK_STATUS_REQUESTED,
-               TASK_STATUS_DELETE_REQUESTED,
-               TASK_STATUS_DELETE_ULTIMATE_REQUESTED,
-               TASK_STATUS_STOP_REQUESTED,
-               TASK_STATUS_STOP_WAITING))
-    return 2;
-
-  /* This needs to have exclusive access to reports because otherwise at this
-   * point another process (like a RESUME_TASK handler) could store the report
-   * ID and then start trying to access that report after we've deleted it. */
-
-  if (report_task (report, &task))
-    return -1;
-
-  /* Remove the report data. */
-
-  sql ("DELETE FROM report_host_details WHERE report_host IN"
-       " (SELECT id FROM report_hosts WHERE report = %llu);",
-       report);
-  sql ("DELETE FROM report_hosts WHERE report = %llu;", report);
-
-  sql ("DELETE FROM tag_resources"
-       " WHERE resource_type = 'result'"
-       "   AND resource IN"
-       "         (SELECT id FROM results WHERE report = %llu);",
-       report);
-  sql ("DELETE FROM tag_resources_trash"
-       " WHERE resource_type = 'result'"
-       "   AND resource IN"
-       "         (SELECT id FROM results WHERE report = %llu);",
-       report);
-  sql ("DELETE FROM results WHERE report = %llu;", report);
-  sql ("DELETE FROM results_trash WHERE report = %llu;", report);
-
-  sql ("DELETE FROM tag_resources"
-       " WHERE resource_type = 'report'"
-       "   AND resource = %llu;",
-       report);
-  sql ("DELETE FROM tag_resources_trash"
-       " WHERE resource_type = 'report'"
-       "   AND resource = %llu;",
-       report);
-  sql ("DELETE FROM report_counts WHERE report = %llu;", report);
-  sql ("DELETE FROM result_nvt_reports WHERE report = %llu;", report);
-  sql ("DELETE FROM reports WHERE id = %llu;", report);
-
-  /* Adjust permissions. */
+  return sql_int ("SELECT count(*) FROM reports WHERE id = %llu"
+                  " AND (scan_run_status = %u OR scan_run_status = %u"
+                  " OR scan_run_status = %u OR scan_run_status = %u"
+                  " OR scan_run_status = %u);",
+                  report,
+                  TASK_STATUS_RUNNING,
+                  TASK_STATUS_QUEUED,
+                  TASK_STATUS_REQUESTED,
+                  TASK_STATUS_DELETE_REQUESTED,
+                  TASK_STATUS_DELETE_ULTIMATE_REQUESTED,
+                  TASK_STATUS_STOP_REQUESTED,
+                  TASK_STATUS_STOP_WAITING);
+}
 
-  permissions_set_orphans ("report", report, LOCATION_TABLE);
-  tags_remove_resource ("report", report, LOCATION_TABLE);
-  tickets_remove_report (report);
+/**
+ * @brief Update the run status of a task after one of its reports is gone.
+ *
+ * @param[in]  task  Task.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+task_update_status_after_delete (task_t task)
+{
+  report_t report;
 
-  /* Update the task state. */
+  if (task == 0)
+    return 0;
 
   switch (sql_int64 (&report,
                      "SELECT max (id) FROM reports WHERE task = %llu",
@@ -24352,6 +26977,332 @@ delete_report_internal (report_t report)
   return 0;
 }
 
+/**
+ * @brief Delete a report.
+ *
+ * It's up to the caller to provide the transaction.
+ *
+ * @param[in]  report  Report.
+ *
+ * @return 0 success, 2 report is in use, -1 error.
+ */
+int
+delete_report_internal (report_t report)
+{
+  task_t task;
+  sql_batch_t *batch;
+  gchar *partition;
+
+  if (report_busy (report))
+    return 2;
+
+  report_render_cache_remove (report);
+
+  /* This needs to have exclusive access to reports because otherwise at this
+   * point another process (like a RESUME_TASK handler) could store the report
+   * ID and then start trying to access that report after we've deleted it. */
+
+  if (report_task (report, &task))
+    return -1;
+
+  /* Remove the report data.  None of the statements need results from the
+   * others, so send them in one round trip. */
+
+  batch = sql_batch_begin ();
+  sql_batch_add (batch,
+                 "DELETE FROM report_host_details WHERE report_host IN"
+                 " (SELECT id FROM report_hosts WHERE report = %llu);",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM report_hosts WHERE report = %llu;",
+                 report);
+
+  sql_batch_add (batch,
+                 "DELETE FROM tag_resources"
+                 " WHERE resource_type = 'result'"
+                 "   AND resource IN"
+                 "         (SELECT id FROM results WHERE report = %llu);",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM tag_resources_trash"
+                 " WHERE resource_type = 'result'"
+                 "   AND resource IN"
+                 "         (SELECT id FROM results WHERE report = %llu);",
+                 report);
+  /* When this is the last report of its results partition, dropping the
+   * partition is much cheaper than deleting the results one by one.  The
+   * DROP locks results exclusively until the caller's transaction ends, so
+   * reap_deleted_reports detaches and drops the partition beforehand. */
+  partition = results_partition_droppable (report);
+  if (partition)
+    sql_batch_add (batch, "DROP TABLE %s;", partition);
+  else
+    sql_batch_add (batch,
+                   "DELETE FROM results WHERE report = %llu;",
+                   report);
+  g_free (partition);
+  sql_batch_add (batch,
+                 "DELETE FROM results_trash WHERE report = %llu;",
+                 report);
+
+  sql_batch_add (batch,
+                 "DELETE FROM tag_resources"
+                 " WHERE resource_type = 'report'"
+                 "   AND resource = %llu;",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM tag_resources_trash"
+                 " WHERE resource_type = 'report'"
+                 "   AND resource = %llu;",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM report_counts WHERE report = %llu;",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM result_nvt_reports WHERE report = %llu;",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM report_deletions WHERE report = %llu;",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM reports WHERE id = %llu;",
+                 report);
+  sql_batch_end (batch);
+
+  /* Adjust permissions. */
+
+  permissions_set_orphans ("report", report, LOCATION_TABLE);
+  tags_remove_resource ("report", report, LOCATION_TABLE);
+  tickets_remove_report (report);
+
+  /* Update the task state. */
+
+  return task_update_status_after_delete (task);
+}
+
+/**
+ * @brief Delete a report, leaving the bulk of its data to the reaper.
+ *
+ * The report is detached from its task, which hides it from everything
+ * that looks up reports through their task, and its results are hidden
+ * from the result iterators.  The small parts of the report are removed
+ * immediately, while reap_deleted_reports removes the results and hosts in
+ * chunks.
+ *
+ * It's up to the caller to provide the transaction.
+ *
+ * @param[in]  report  Report.
+ *
+ * @return 0 success, 2 report is in use, -1 error.
+ */
+static int
+delete_report_deferred (report_t report)
+{
+  task_t task;
+  sql_batch_t *batch;
+
+  if (report_busy (report))
+    return 2;
+
+  if (report_task (report, &task))
+    return -1;
+
+  if (task == 0)
+    /* Already waiting for the reaper. */
+    return 0;
+
+  report_render_cache_remove (report);
+
+  batch = sql_batch_begin ();
+  sql_batch_add (batch,
+                 "INSERT INTO report_deletions (report, task, time)"
+                 " VALUES (%llu, %llu, %li);",
+                 report, task, time (NULL));
+  sql_batch_add (batch,
+                 "UPDATE reports SET task = NULL WHERE id = %llu;",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM tag_resources"
+                 " WHERE resource_type = 'report'"
+                 "   AND resource = %llu;",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM tag_resources_trash"
+                 " WHERE resource_type = 'report'"
+                 "   AND resource = %llu;",
+                 report);
+  sql_batch_add (batch,
+                 "DELETE FROM report_counts WHERE report = %llu;",
+                 report);
+  sql_batch_end (batch);
+
+  permissions_set_orphans ("report", report, LOCATION_TABLE);
+  tags_remove_resource ("report", report, LOCATION_TABLE);
+  tickets_remove_report (report);
+
+  return task_update_status_after_delete (task);
+}
+
+/**
+ * @brief Delete a report, deferring the bulk of the work if configured.
+ *
+ * The last report of a results partition is always deferred, so that the
+ * reaper can drop the partition without holding a lock on results for the
+ * whole of the caller's transaction.
+ *
+ * It's up to the caller to provide the transaction.
+ *
+ * @param[in]  report  Report.
+ *
+ * @return 0 success, 2 report is in use, -1 error.
+ */
+static int
+delete_report_user (report_t report)
+{
+  gchar *partition;
+  task_t task;
+
+  if (report_deletion_chunk)
+    return delete_report_deferred (report);
+
+  partition = results_partition_droppable (report);
+  if (partition)
+    {
+      g_free (partition);
+      if (report_task (report, &task))
+        return -1;
+      if (task)
+        return delete_report_deferred (report);
+    }
+
+  return delete_report_internal (report);
+}
+
+/**
+ * @brief Delete one chunk of the data of a deleted report.
+ *
+ * @param[in]  statement  SELECT that deletes the chunk and returns the
+ *                        number of deleted rows.
+ *
+ * @return Number of rows deleted.
+ */
+static int
+reap_deleted_report_chunk (const gchar *statement)
+{
+  int count;
+
+  sql_begin_immediate ();
+  count = sql_int ("%s", statement);
+  sql_commit ();
+  return count;
+}
+
+/**
+ * @brief Remove the data of reports deleted by delete_report_deferred.
+ *
+ * Each call removes at most report_deletion_chunk rows per table of the
+ * oldest deleted report, each chunk in its own short transaction, so that
+ * the work of a big report is spread over the schedule periods.  Once the
+ * results and hosts are gone the report itself is deleted.
+ *
+ * In gvmd, called from manage_schedule.
+ */
+void
+reap_deleted_reports ()
+{
+  report_t report;
+  gchar *statement, *partition;
+  int count;
+
+  if (sql_int64 (&report,
+                 "SELECT report FROM report_deletions"
+                 " ORDER BY time, report LIMIT 1;"))
+    return;
+
+  g_debug ("%s: reaping report %llu", __func__, report);
+
+  /* When this is the last report of its results partition, detach and drop
+   * the partition before deleting the rest, so that results is not locked
+   * for the whole of delete_report_internal.  If results is busy, try again
+   * in the next period. */
+  partition = results_partition_droppable (report);
+  if (partition)
+    {
+      int ret;
+
+      ret = results_partition_drop (partition);
+      g_free (partition);
+      if (ret)
+        return;
+    }
+
+  if (report_deletion_chunk == 0)
+    {
+      /* Deferring was switched off, so finish the job in one go. */
+      sql_begin_immediate ();
+      if (delete_report_internal (report))
+        sql_rollback ();
+      else
+        sql_commit ();
+      return;
+    }
+
+  count = 0;
+
+  statement = g_strdup_printf
+               ("WITH chunk AS (SELECT id FROM results"
+                "               WHERE report = %llu LIMIT %i),"
+                "     tags AS (DELETE FROM tag_resources"
+                "              WHERE resource_type = 'result'"
+                "              AND resource IN (SELECT id FROM chunk)),"
+                "     tags_trash AS (DELETE FROM tag_resources_trash"
+                "                    WHERE resource_type = 'result'"
+                "                    AND resource IN (SELECT id FROM chunk)),"
+                "     deleted AS (DELETE FROM results"
+                "                 WHERE id IN (SELECT id FROM chunk)"
+                "                 RETURNING 1)"
+                " SELECT count (*) FROM deleted;",
+                report, report_deletion_chunk);
+  count += reap_deleted_report_chunk (statement);
+  g_free (statement);
+
+  statement = g_strdup_printf
+               ("WITH deleted AS (DELETE FROM results_trash"
+                "                 WHERE id IN (SELECT id FROM results_trash"
+                "                              WHERE report = %llu"
+                "                              LIMIT %i)"
+                "                 RETURNING 1)"
+                " SELECT count (*) FROM deleted;",
+                report, report_deletion_chunk);
+  count += reap_deleted_report_chunk (statement);
+  g_free (statement);
+
+  statement = g_strdup_printf
+               ("WITH deleted AS (DELETE FROM report_host_details"
+                "                 WHERE id IN (SELECT id"
+                "                              FROM report_host_details"
+                "                              WHERE report_host IN"
+                "                                (SELECT id FROM report_hosts"
+                "                                 WHERE report = %llu)"
+                "                              LIMIT %i)"
+                "                 RETURNING 1)"
+                " SELECT count (*) FROM deleted;",
+                report, report_deletion_chunk);
+  count += reap_deleted_report_chunk (statement);
+  g_free (statement);
+
+  if (count)
+    /* Leave the rest to the following periods. */
+    return;
+
+  /* Only the hosts and the report itself are left. */
+  sql_begin_immediate ();
+  if (delete_report_internal (report))
+    sql_rollback ();
+  else
+    sql_commit ();
+}
+
 /**
  * @brief Delete a report.
  *
@@ -24403,7 +27354,7 @@ delete_report (const char *report_id, int dummy)
         }
     }
 
-  ret = delete_report_internal (report);
+  ret = delete_report_user (report);
   if (ret)
     {
       sql_rollback ();
@@ -24477,6 +27428,66 @@ trim_report (report_t report)
     report_clear_count_cache (report, 1, 1, NULL);
 }
 
+/**
+ * @brief Mark that results are about to be popped from the scanner.
+ *
+ * The mark is committed before the pop, and cleared in the transaction
+ * that stores the popped results, so a mark left over means that popped
+ * results may have been lost.
+ *
+ * @param[in]  report  The report.
+ */
+void
+report_ingest_pending (report_t report)
+{
+  sql ("INSERT INTO report_ingest_checkpoints"
+       " (report, pops, results, pending, modification_time)"
+       " VALUES (%llu, 0, 0, 1, m_now ())"
+       " ON CONFLICT (report) DO UPDATE"
+       " SET pending = 1, modification_time = m_now ();",
+       report);
+}
+
+/**
+ * @brief Record that popped results have been stored.
+ *
+ * Must be called in the transaction that stores the results.
+ *
+ * @param[in]  report   The report.
+ * @param[in]  results  Number of results stored.
+ */
+static void
+report_ingest_checkpoint (report_t report, int results)
+{
+  sql ("INSERT INTO report_ingest_checkpoints"
+       " (report, pops, results, pending, modification_time)"
+       " VALUES (%llu, 1, %i, 0, m_now ())"
+       " ON CONFLICT (report) DO UPDATE"
+       " SET pops = report_ingest_checkpoints.pops + 1,"
+       "     results = report_ingest_checkpoints.results + %i,"
+       "     pending = 0,"
+       "     modification_time = m_now ();",
+       report,
+       results,
+       results);
+}
+
+/**
+ * @brief Check whether every result popped for a report has been stored.
+ *
+ * @param[in]  report  The report.
+ *
+ * @return 1 if the ingestion of the report can simply continue, else 0.
+ */
+int
+report_ingest_complete (report_t report)
+{
+  return sql_int ("SELECT EXISTS (SELECT * FROM report_ingest_checkpoints"
+                  "               WHERE report = %llu AND pending = 0)"
+                  " ::integer;",
+                  report);
+}
+
 /**
  * @brief Prepare a partial report for resumption of the scan.
  *
@@ -24517,11 +27528,101 @@ trim_partial_report (report_t report)
 }
 
 /**
- * @brief Compares two textual port representations, sorting descending
- * @brief by severity
+ * @brief Some result info, for sorting.
+ */
+struct result_buffer
+{
+  const gchar *host;            ///< Host.  Interned in the render.
+  const gchar *port;            ///< Port.  Interned in the render.
+  const gchar *severity;        ///< Severity.  Interned in the render.
+  double severity_double;       ///< Severity.
+};
+
+/**
+ * @brief Buffer host type.
+ */
+typedef struct result_buffer result_buffer_t;
+
+/**
+ * @brief Memory of one report render.
  *
- * @param[in]  arg_one  First threat level.
- * @param[in]  arg_two  Second threat level.
+ * The hosts, ports and severities of a report repeat across most of its
+ * results.  The render interns them in one string arena, so the buffers and
+ * hash tables of the render only hold pointers, and everything is released
+ * at once when the render completes.
+ */
+typedef struct
+{
+  GStringChunk *strings;      ///< Arena of interned strings.
+  GPtrArray *hosts;           ///< Result hosts, in order, interned.
+  GHashTable *hosts_seen;     ///< Set of the hosts in hosts.
+} report_render_t;
+
+/**
+ * @brief Initialise the memory of a report render.
+ *
+ * @param[in]  render  Render.
+ */
+static void
+report_render_init (report_render_t *render)
+{
+  render->strings = g_string_chunk_new (4096);
+  render->hosts = g_ptr_array_new ();
+  render->hosts_seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+}
+
+/**
+ * @brief Intern a string in a report render.
+ *
+ * @param[in]  render  Render.
+ * @param[in]  string  String.
+ *
+ * @return The interned copy of string, which is the same for equal strings.
+ *         Freed by report_render_free.  NULL if string is NULL.
+ */
+static const gchar *
+report_render_intern (report_render_t *render, const gchar *string)
+{
+  if (string == NULL)
+    return NULL;
+  return g_string_chunk_insert_const (render->strings, string);
+}
+
+/**
+ * @brief Add a result host to a report render, if it is not there yet.
+ *
+ * @param[in]  render  Render.
+ * @param[in]  host    Host.
+ */
+static void
+report_render_add_host (report_render_t *render, const gchar *host)
+{
+  const gchar *interned;
+
+  interned = report_render_intern (render, host);
+  if (g_hash_table_add (render->hosts_seen, (gpointer) interned))
+    g_ptr_array_add (render->hosts, (gpointer) interned);
+}
+
+/**
+ * @brief Release the memory of a report render.
+ *
+ * @param[in]  render  Render.
+ */
+static void
+report_render_free (report_render_t *render)
+{
+  g_hash_table_destroy (render->hosts_seen);
+  g_ptr_array_free (render->hosts, TRUE);
+  g_string_chunk_free (render->strings);
+}
+
+/**
+ * @brief Compares two buffered results, sorting by host, severity
+ * @brief descending, then port.
+ *
+ * @param[in]  arg_one  First result.
+ * @param[in]  arg_two  Second result.
  *
  * @return 1, 0 or -1 if first given severity is less than, equal to or greater
  *         than second.
@@ -24529,41 +27630,29 @@ trim_partial_report (report_t report)
 static gint
 compare_severity_desc (gconstpointer arg_one, gconstpointer arg_two)
 {
-  double one_severity, two_severity;
-  gchar *one = *((gchar**) arg_one);
-  gchar *two = *((gchar**) arg_two);
+  const result_buffer_t *one = arg_one;
+  const result_buffer_t *two = arg_two;
   gint host;
 
-  one += strlen (one) + 1;
-  two += strlen (two) + 1;
-  one_severity = g_strtod (one, NULL);
-  two_severity = g_strtod (two, NULL);
-
-  one += strlen (one) + 1;
-  two += strlen (two) + 1;
-  host = strcmp (one, two);
+  host = strcmp (one->host, two->host);
   if (host == 0)
     {
-      if (one_severity > two_severity)
+      if (one->severity_double > two->severity_double)
         return -1;
-      else if (one_severity < two_severity)
+      else if (one->severity_double < two->severity_double)
         return 1;
       else
-        {
-          one = *((gchar**) arg_one);
-          two = *((gchar**) arg_two);
-          return strcmp (two, one);
-        }
+        return strcmp (two->port, one->port);
     }
   return host;
 }
 
 /**
- * @brief Compares two textual port representations, sorting descending
- * @brief by severity
+ * @brief Compares two buffered results, sorting by host, severity
+ * @brief ascending, then port.
  *
- * @param[in]  arg_one  First port.
- * @param[in]  arg_two  Second port.
+ * @param[in]  arg_one  First result.
+ * @param[in]  arg_two  Second result.
  *
  * @return -1, 0 or 1 if first given severity is less than, equal to or greater
  *         than second.
@@ -24571,88 +27660,23 @@ compare_severity_desc (gconstpointer arg_one, gconstpointer arg_two)
 static gint
 compare_severity_asc (gconstpointer arg_one, gconstpointer arg_two)
 {
-  double one_severity, two_severity;
-  gchar *one = *((gchar**) arg_one);
-  gchar *two = *((gchar**) arg_two);
+  const result_buffer_t *one = arg_one;
+  const result_buffer_t *two = arg_two;
   gint host;
 
-  one += strlen (one) + 1;
-  two += strlen (two) + 1;
-  one_severity = g_strtod (one, NULL);
-  two_severity = g_strtod (two, NULL);
-
-  one += strlen (one) + 1;
-  two += strlen (two) + 1;
-  host = strcmp (one, two);
+  host = strcmp (one->host, two->host);
   if (host == 0)
     {
-      if (one_severity < two_severity)
+      if (one->severity_double < two->severity_double)
         return -1;
-      else if (one_severity > two_severity)
+      else if (one->severity_double > two->severity_double)
         return 1;
       else
-        {
-          one = *((gchar**) arg_one);
-          two = *((gchar**) arg_two);
-          return strcmp (one, two);
-        }
+        return strcmp (one->port, two->port);
     }
   return host;
 }
 
-/**
- * @brief Some result info, for sorting.
- */
-struct result_buffer
-{
-  gchar *host;                  ///< Host.
-  gchar *port;                  ///< Port.
-  gchar *severity;              ///< Severity.
-  double severity_double;       ///< Severity.
-};
-
-/**
- * @brief Buffer host type.
- */
-typedef struct result_buffer result_buffer_t;
-
-/**
- * @brief Create a result buffer.
- *
- * @param[in]  host      Host.
- * @param[in]  port      Port.
- * @param[in]  severity  Severity.
- * @param[in]  severity_double  Severity.
- *
- * @return Freshly allocated result buffer.
- */
-static result_buffer_t*
-result_buffer_new (const gchar *host, const gchar *port, const gchar *severity,
-                   double severity_double)
-{
-  result_buffer_t *result_buffer;
-  result_buffer = g_malloc (sizeof (result_buffer_t));
-  result_buffer->host = g_strdup (host);
-  result_buffer->port = g_strdup (port);
-  result_buffer->severity = g_strdup (severity);
-  result_buffer->severity_double = severity_double;
-  return result_buffer;
-}
-
-/**
- * @brief Free a result buffer.
- *
- * @param[in]  result_buffer  Result buffer.
- */
-static void
-result_buffer_free (result_buffer_t *result_buffer)
-{
-  g_free (result_buffer->host);
-  g_free (result_buffer->port);
-  g_free (result_buffer->severity);
-  g_free (result_buffer);
-}
-
 /**
  * @brief Compares two buffered results, sorting by host, port then severity.
  *
@@ -24666,10 +27690,8 @@ static gint
 compare_port_severity (gconstpointer arg_one, gconstpointer arg_two)
 {
   int host;
-  result_buffer_t *one, *two;
-
-  one = *((result_buffer_t**) arg_one);
-  two = *((result_buffer_t**) arg_two);
+  const result_buffer_t *one = arg_one;
+  const result_buffer_t *two = arg_two;
 
   host = strcmp (one->host, two->host);
   if (host == 0)
@@ -24709,32 +27731,74 @@ typedef enum
   COMPARE_RESULTS_SAME
 } compare_results_t;
 
+/**
+ * @brief Fields that a delta report can be sorted on.
+ */
+typedef enum
+{
+  DELTA_SORT_DESCRIPTION,
+  DELTA_SORT_HOST,
+  DELTA_SORT_NAME,
+  DELTA_SORT_NVT,
+  DELTA_SORT_ORIGINAL_TYPE,
+  DELTA_SORT_PORT,
+  DELTA_SORT_SEVERITY,
+  DELTA_SORT_TYPE
+} delta_sort_field_t;
+
+/**
+ * @brief Get the delta sort field of a sort field name.
+ *
+ * This is done once per report, so that comparing results does not have
+ * to compare sort field names.
+ *
+ * @param[in]  sort_field  Field to sort on, or NULL for "type".
+ *
+ * @return Delta sort field.
+ */
+static delta_sort_field_t
+delta_sort_field (const char *sort_field)
+{
+  if (sort_field == NULL || strcmp (sort_field, "type") == 0)
+    return DELTA_SORT_TYPE;
+  if (strcmp (sort_field, "host") == 0)
+    return DELTA_SORT_HOST;
+  if (strcmp (sort_field, "port") == 0
+      || strcmp (sort_field, "location") == 0)
+    return DELTA_SORT_PORT;
+  if (strcmp (sort_field, "severity") == 0)
+    return DELTA_SORT_SEVERITY;
+  if (strcmp (sort_field, "nvt") == 0)
+    return DELTA_SORT_NVT;
+  if (strcmp (sort_field, "description") == 0)
+    return DELTA_SORT_DESCRIPTION;
+  if (strcmp (sort_field, "original_type") == 0)
+    return DELTA_SORT_ORIGINAL_TYPE;
+  /* Default to "vulnerability" (a.k.a "name") for unknown sort fields.
+   *
+   * Also done in print_report_xml_start, so this is just a safety check. */
+  return DELTA_SORT_NAME;
+}
+
 /**
  * @brief Return the sort order of two results.
  *
  * @param[in]  results        Iterator containing first result.
  * @param[in]  delta_results  Iterator containing second result.
  * @param[in]  sort_order     Whether to sort ascending or descending.
- * @param[in]  sort_field     Field to sort on, or NULL for "type".
+ * @param[in]  sort_field     Field to sort on.
  *
  * @return < 0 if first comes before second, 0 if equal, > 0 if first comes
  *         after second.
  */
-static compare_results_t
+static int
 result_cmp (iterator_t *results, iterator_t *delta_results, int sort_order,
-            const char* sort_field)
+            delta_sort_field_t sort_field)
 {
-  const char *host, *delta_host, *port, *delta_port;
-  const char *nvt, *delta_nvt, *name, *delta_name, *descr, *delta_descr;
+  const char *host, *delta_host, *port, *delta_port, *nvt, *delta_nvt;
   int ret;
   double severity, delta_severity;
 
-  if (sort_field == NULL)
-    sort_field = "type";
-
-  g_debug ("   delta: %s: sort_order: %i", __func__, sort_order);
-  g_debug ("   delta: %s: sort_field: %s", __func__, sort_field);
-
   host = result_iterator_host (results);
   delta_host = result_iterator_host (delta_results);
 
@@ -24747,12 +27811,6 @@ result_cmp (iterator_t *results, iterator_t *delta_results, int sort_order,
   nvt = result_iterator_nvt_oid (results);
   delta_nvt = result_iterator_nvt_oid (delta_results);
 
-  name = result_iterator_nvt_name (results);
-  delta_name = result_iterator_nvt_name (delta_results);
-
-  descr = result_iterator_descr (results);
-  delta_descr = result_iterator_descr (delta_results);
-
   /* For delta reports to work correctly, the order must be the same as in
    * init_delta_iterators, except that description should not be checked
    * unless it is the sort_field.
@@ -24761,148 +27819,92 @@ result_cmp (iterator_t *results, iterator_t *delta_results, int sort_order,
    * in compare_results. */
 
   /* Check sort_field first, also using sort_order (0 is descending). */
-  if (strcmp (sort_field, "host") == 0)
-    {
-      ret = collate_ip (NULL,
-                        strlen (host), host, strlen (delta_host), delta_host);
-      if (sort_order == 0)
-        ret = -ret;
-      g_debug ("   delta: %s: host (%s): %s VS %s (%i)",
-               __func__, sort_order ? "desc" : "asc",
-               host, delta_host, ret);
-      if (ret)
-        return ret;
-    }
-  else if (strcmp (sort_field, "port") == 0
-           || strcmp (sort_field, "location") == 0)
-    {
-      ret = strcmp (port, delta_port);
-      if (sort_order == 0)
-        ret = -ret;
-      g_debug ("   delta: %s: port (%s): %s VS %s (%i)",
-               __func__, sort_order ? "desc" : "asc",
-               port, delta_port, ret);
-      if (ret)
-        return ret;
-    }
-  else if (strcmp (sort_field, "severity") == 0)
-    {
-      if (severity > delta_severity)
-        ret = sort_order ? 1 : -1;
-      else if (severity < delta_severity)
-        ret = sort_order ? -1 : 1;
-      else
-        ret = 0;
-      g_debug ("   delta: %s: severity (%s): %f VS %f (%i)",
-               __func__, sort_order ? "desc" : "asc",
-               severity, delta_severity, ret);
-      if (ret)
-        return ret;
-    }
-  /* NVT OID, not name/vulnerability. */
-  else if (strcmp (sort_field, "nvt") == 0)
-    {
-      ret = strcmp (nvt, delta_nvt);
-      if (sort_order)
-        ret = -ret;
-      g_debug ("   delta: %s: nvt (%s): %s VS %s (%i)",
-               __func__, sort_order ? "desc" : "asc",
-               nvt, delta_nvt, ret);
-      if (ret)
-        return ret;
-    }
-  else if (strcmp (sort_field, "description") == 0)
-    {
-      ret = strcmp (descr, delta_descr);
-      if (sort_order == 0)
-        ret = -ret;
-      g_debug ("   delta: %s: description (%s): %s VS %s (%i)",
-               __func__, sort_order ? "desc" : "asc",
-               descr, delta_descr, ret);
-      if (ret)
-        return ret;
-    }
-  else if (strcmp (sort_field, "type") == 0)
-    {
-      const char *type, *delta_type;
-
-      type = result_iterator_type (results);
-      delta_type = result_iterator_type (delta_results);
-
-      ret = strcmp (type, delta_type);
-      if (sort_order == 0)
-        ret = -ret;
-      g_debug ("   delta: %s: type (%s): %s VS %s (%i)",
-               __func__, sort_order ? "desc" : "asc",
-               descr, delta_descr, ret);
-      if (ret)
-        return ret;
-    }
-  else if (strcmp (sort_field, "original_type") == 0)
-    {
-      const char *type, *delta_type;
-
-      type = result_iterator_original_type (results);
-      delta_type = result_iterator_original_type (delta_results);
+  switch (sort_field)
+    {
+      case DELTA_SORT_HOST:
+        ret = collate_ip (NULL,
+                          strlen (host), host, strlen (delta_host),
+                          delta_host);
+        if (sort_order == 0)
+          ret = -ret;
+        break;
+      case DELTA_SORT_PORT:
+        ret = strcmp (port, delta_port);
+        if (sort_order == 0)
+          ret = -ret;
+        break;
+      case DELTA_SORT_SEVERITY:
+        if (severity > delta_severity)
+          ret = sort_order ? 1 : -1;
+        else if (severity < delta_severity)
+          ret = sort_order ? -1 : 1;
+        else
+          ret = 0;
+        break;
+      case DELTA_SORT_NVT:
+        /* NVT OID, not name/vulnerability. */
+        ret = strcmp (nvt, delta_nvt);
+        if (sort_order)
+          ret = -ret;
+        break;
+      case DELTA_SORT_DESCRIPTION:
+        ret = strcmp (result_iterator_descr (results),
+                      result_iterator_descr (delta_results));
+        if (sort_order == 0)
+          ret = -ret;
+        break;
+      case DELTA_SORT_TYPE:
+        ret = strcmp (result_iterator_type (results),
+                      result_iterator_type (delta_results));
+        if (sort_order == 0)
+          ret = -ret;
+        break;
+      case DELTA_SORT_ORIGINAL_TYPE:
+        ret = strcmp (result_iterator_original_type (results),
+                      result_iterator_original_type (delta_results));
+        if (sort_order == 0)
+          ret = -ret;
+        break;
+      case DELTA_SORT_NAME:
+      default:
+        {
+          const char *name, *delta_name;
 
-      ret = strcmp (type, delta_type);
-      if (sort_order == 0)
-        ret = -ret;
-      g_debug ("   delta: %s: original_type (%s): %s VS %s (%i)",
-               __func__, sort_order ? "desc" : "asc",
-               descr, delta_descr, ret);
-      if (ret)
-        return ret;
-    }
-  else
-    {
-      /* Default to "vulnerability" (a.k.a "name") for unknown sort fields.
-       *
-       * Also done in print_report_xml_start, so this is just a safety check. */
-      ret = strcmp (name ? name : "", delta_name ? delta_name : "");
-      if (sort_order == 0)
-        ret = -ret;
-      if (ret)
-        return ret;
+          name = result_iterator_nvt_name (results);
+          delta_name = result_iterator_nvt_name (delta_results);
+          ret = strcmp (name ? name : "", delta_name ? delta_name : "");
+          if (sort_order == 0)
+            ret = -ret;
+          break;
+        }
     }
+  if (ret)
+    return ret;
 
   /* Check remaining fields */
-  if (strcmp (sort_field, "host"))
+  if (sort_field != DELTA_SORT_HOST)
     {
       ret = collate_ip (NULL,
                         strlen (host), host, strlen (delta_host), delta_host);
-      g_debug ("   delta: %s: host: %s VS %s (%i)",
-               __func__, host, delta_host, ret);
       if (ret)
         return ret;
     }
-  if (strcmp (sort_field, "port")
-      && strcmp (sort_field, "location"))
+  if (sort_field != DELTA_SORT_PORT)
     {
       ret = strcmp (port, delta_port);
-      g_debug ("   delta: %s: port: %s VS %s (%i)",
-               __func__, port, delta_port, ret);
       if (ret)
         return ret;
     }
-  if (strcmp (sort_field, "severity"))
+  if (sort_field != DELTA_SORT_SEVERITY)
     {
       if (severity > delta_severity)
-        ret = 1;
-      else if (severity < delta_severity)
-        ret = -1;
-      else
-        ret = 0;
-      g_debug ("   delta: %s: severity: %f VS %f (%i)",
-               __func__, severity, delta_severity, ret);
-      if (ret)
-        return ret;
+        return 1;
+      if (severity < delta_severity)
+        return -1;
     }
-  if (strcmp (sort_field, "nvt"))
+  if (sort_field != DELTA_SORT_NVT)
     {
       ret = strcmp (nvt, delta_nvt);
-      g_debug ("   delta: %s: nvt: %s VS %s (%i)",
-               __func__, nvt, delta_nvt, ret);
       if (ret)
         return ret;
     }
@@ -24959,19 +27961,17 @@ streq_ignore_ws (const gchar *one, const gchar *two)
  * @param[in]  results        Iterator containing first result.
  * @param[in]  delta_results  Iterator containing second result.
  * @param[in]  sort_order     Whether to sort ascending or descending.
- * @param[in]  sort_field     Field to sort on, or NULL for "type".
+ * @param[in]  sort_field     Field to sort on.
  *
  * @return Result of comparison.
  */
 static compare_results_t
 compare_results (iterator_t *results, iterator_t *delta_results, int sort_order,
-                 const char* sort_field)
+                 delta_sort_field_t sort_field)
 {
   int ret;
   const char *descr, *delta_descr;
 
-  g_debug ("   delta: %s", __func__);
-
   ret = result_cmp (results, delta_results, sort_order, sort_field);
   if (ret > 0)
     /* The delta result sorts first, so it is new. */
@@ -24983,12 +27983,6 @@ compare_results (iterator_t *results, iterator_t *delta_results, int sort_order,
   descr = result_iterator_descr (results);
   delta_descr = result_iterator_descr (delta_results);
 
-  g_debug ("   delta: %s: descr: %s VS %s (%i)",
-          __func__,
-          descr ? descr : "NULL",
-          delta_descr ? delta_descr : "NULL",
-          (descr && delta_descr) ? strcmp (descr, delta_descr) : 0);
-
   /* This comparison ignores whitespace to match the diff output created by
    * strdiff in gmp.c.  The down side of this is that the comparison may be
    * affected by the locale.
@@ -25020,7 +28014,7 @@ compare_results (iterator_t *results, iterator_t *delta_results, int sort_order,
  * @param[in]  overrides          Whether to include overrides.
  * @param[in]  overrides_details  If overrides, Whether to include details.
  * @param[in]  sort_order     Whether to sort ascending or descending.
- * @param[in]  sort_field     Field to sort on, or NULL for "type".
+ * @param[in]  sort_field     Field to sort on.
  * @param[in]  changed        Whether to include changed results.
  * @param[in]  gone           Whether to include gone results.
  * @param[in]  new            Whether to include new results.
@@ -25037,7 +28031,8 @@ compare_and_buffer_results (GString *buffer, iterator_t *results,
                             iterator_t *delta_results, task_t task, int notes,
                             int notes_details, int overrides,
                             int overrides_details, int sort_order,
-                            const char* sort_field, int changed, int gone,
+                            delta_sort_field_t sort_field, int changed,
+                            int gone,
                             int new, int same, int *max_results,
                             int *first_result, int *used, int *would_use)
 {
@@ -25201,12 +28196,13 @@ compare_and_buffer_results (GString *buffer, iterator_t *results,
  *
  * @param[in]  ports    The tree.
  * @param[in]  results  Result iterator on result whose port to add.
+ * @param[in]  render   Render, for the host and port keys.
  */
 static void
-add_port (GTree *ports, iterator_t *results)
+add_port (GTree *ports, iterator_t *results, report_render_t *render)
 {
   const char *port, *host;
-  double *old_severity, *severity;
+  double *old_severity, severity;
   GTree *host_ports;
 
   /* Ensure there's an inner tree for the host. */
@@ -25215,31 +28211,31 @@ add_port (GTree *ports, iterator_t *results)
   host_ports = g_tree_lookup (ports, host);
   if (host_ports == NULL)
     {
-      host_ports = g_tree_new_full ((GCompareDataFunc) strcmp, NULL, g_free,
+      host_ports = g_tree_new_full ((GCompareDataFunc) strcmp, NULL, NULL,
                                     g_free);
-      g_tree_insert (ports, g_strdup (host), host_ports);
+      g_tree_insert (ports, (gpointer) report_render_intern (render, host),
+                     host_ports);
     }
 
   /* Ensure the highest threat is recorded for the port in the inner tree. */
 
   port = result_iterator_port (results);
-  severity = g_malloc (sizeof (double));
-  *severity = result_iterator_severity_double (results);
+  severity = result_iterator_severity_double (results);
 
   old_severity = g_tree_lookup (host_ports, port);
   g_debug ("   delta: %s: adding %s severity %1.1f on host %s", __func__,
-          port, *severity, host);
+          port, severity, host);
   if (old_severity == NULL)
-    g_tree_insert (host_ports, g_strdup (port), severity);
-  else if (severity > old_severity)
-    {
-      *old_severity = *severity;
-      g_free (severity);
-    }
-  else
     {
-      g_free (severity);
+      double *new_severity;
+
+      new_severity = g_malloc (sizeof (double));
+      *new_severity = severity;
+      g_tree_insert (host_ports, (gpointer) report_render_intern (render, port),
+                     new_severity);
     }
+  else if (severity > *old_severity)
+    *old_severity = severity;
 }
 
 /**
@@ -25509,31 +28505,24 @@ free_host_ports (GTree *host_ports, gpointer dummy)
 }
 
 /**
- * @brief Get N'th last report_host given a host.
+ * @brief Get N'th last report_host given a host, within a set of candidates.
  *
- * The last report_host is at position 1, the second last at position 2, and
- * so on.
- *
- * @param[in]  host         Host.
+ * @param[in]  quoted_host  Host, SQL quoted.
  * @param[in]  report_host  Report host.
- * @param[in]  position     Position from end.
+ * @param[in]  position     Position from end, 1 or greater.
+ * @param[in]  candidates   Extra SQL condition on the report host id.
  *
- * @return N'th last report_host.
+ * @return TRUE on error, else FALSE.
  */
-gboolean
-host_nthlast_report_host (const char *host, report_host_t *report_host,
-                          int position)
+static gboolean
+host_nthlast_report_host_where (const char *quoted_host,
+                                report_host_t *report_host,
+                                int position,
+                                const char *candidates)
 {
-  gchar *quoted_host;
-
-  assert (current_credentials.uuid);
-
-  if (position == 0)
-    position = 1;
-
-  quoted_host = sql_quote (host);
   switch (sql_int64 (report_host,
                      "SELECT id FROM report_hosts WHERE host = '%s'"
+                     "%s"
                      " AND user_owns ('task',"
                      "                (SELECT reports.task FROM reports"
                      "                 WHERE reports.id"
@@ -25555,6 +28544,7 @@ host_nthlast_report_host (const char *host, report_host_t *report_host,
                      "                 AND name = 'CVE Scan')"
                      " ORDER BY id DESC LIMIT 1 OFFSET %i;",
                      quoted_host,
+                     candidates,
                      position - 1))
     {
       case 0:
@@ -25568,6 +28558,67 @@ host_nthlast_report_host (const char *host, report_host_t *report_host,
         return TRUE;
         break;
     }
+  return FALSE;
+}
+
+/**
+ * @brief Get N'th last report_host given a host.
+ *
+ * The last report_host is at position 1, the second last at position 2, and
+ * so on.
+ *
+ * The last report_host is first looked up in host_latest, which holds the
+ * latest report host of each asset host.  All report hosts of the host are
+ * only searched if that one no longer qualifies, for example because its
+ * task is in the trashcan, or if the host has no asset.
+ *
+ * @param[in]  host         Host.
+ * @param[in]  report_host  Report host.
+ * @param[in]  position     Position from end.
+ *
+ * @return TRUE on error, else FALSE.
+ */
+gboolean
+host_nthlast_report_host (const char *host, report_host_t *report_host,
+                          int position)
+{
+  gchar *quoted_host;
+
+  assert (current_credentials.uuid);
+
+  if (position == 0)
+    position = 1;
+
+  quoted_host = sql_quote (host);
+
+  if (position == 1)
+    {
+      gchar *latest;
+      gboolean error;
+
+      latest = g_strdup_printf
+                (" AND id IN (SELECT report_host FROM host_latest"
+                 "            WHERE host IN (SELECT id FROM hosts"
+                 "                           WHERE name = '%s'"
+                 "                           AND owner = (SELECT id FROM users"
+                 "                                        WHERE uuid = '%s')))",
+                 quoted_host,
+                 current_credentials.uuid);
+      error = host_nthlast_report_host_where (quoted_host, report_host, 1,
+                                              latest);
+      g_free (latest);
+      if (error || *report_host)
+        {
+          g_free (quoted_host);
+          return error;
+        }
+    }
+
+  if (host_nthlast_report_host_where (quoted_host, report_host, position, ""))
+    {
+      g_free (quoted_host);
+      return TRUE;
+    }
 
   g_free (quoted_host);
   return FALSE;
@@ -25945,6 +28996,7 @@ print_report_errors_xml (report_t report, FILE *stream)
  * @param[in]  sort_field       Field to sort on.
  * @param[out] host_ports       Hash table for counting ports per host.
  * @param[in,out] results       Result iterator.  For caller to reuse.
+ * @param[in]  render           Render, for the buffered strings.
  *
  * @return 0 on success, -1 error.
  */
@@ -25952,10 +29004,12 @@ static int
 print_report_port_xml (report_t report, FILE *out, const get_data_t *get,
                        int first_result, int max_results,
                        int sort_order, const char *sort_field,
-                       GHashTable *host_ports, iterator_t *results)
+                       GHashTable *host_ports, iterator_t *results,
+                       report_render_t *render)
 {
   result_buffer_t *last_item;
-  GArray *ports = g_array_new (TRUE, FALSE, sizeof (gchar*));
+  GArray *ports = g_array_new (FALSE, FALSE, sizeof (result_buffer_t));
+  guint index;
 
   init_result_get_iterator (results, get, report, NULL, NULL);
 
@@ -25976,13 +29030,14 @@ print_report_port_xml (report_t report, FILE *out, const get_data_t *get,
           && last_item->severity_double <= cvss_double)
         {
           last_item->severity_double = cvss_double;
-          g_free (last_item->severity);
-          last_item->severity = g_strdup (result_iterator_severity (results));
+          last_item->severity
+            = report_render_intern (render,
+                                    result_iterator_severity (results));
         }
       else
         {
           const char *cvss;
-          result_buffer_t *item;
+          result_buffer_t item;
 
           cvss = result_iterator_severity (results);
           if (cvss == NULL)
@@ -25990,9 +29045,12 @@ print_report_port_xml (report_t report, FILE *out, const get_data_t *get,
               cvss_double = 0.0;
               cvss = "0.0";
             }
-          item = result_buffer_new (host, port, cvss, cvss_double);
+          item.host = report_render_intern (render, host);
+          item.port = report_render_intern (render, port);
+          item.severity = report_render_intern (render, cvss);
+          item.severity_double = cvss_double;
           g_array_append_val (ports, item);
-          last_item = item;
+          last_item = &g_array_index (ports, result_buffer_t, ports->len - 1);
         }
 
     }
@@ -26001,7 +29059,7 @@ print_report_port_xml (report_t report, FILE *out, const get_data_t *get,
 
   if (sort_field == NULL || strcmp (sort_field, "port"))
     {
-      int index, length;
+      guint kept;
 
       /** @todo Sort by ROWID if was requested. */
 
@@ -26009,33 +29067,26 @@ print_report_port_xml (report_t report, FILE *out, const get_data_t *get,
 
       g_array_sort (ports, compare_port_severity);
 
-      /* Remove duplicates. */
+      /* Remove duplicates, keeping the first of each host and port, which
+       * has the highest severity. */
 
       last_item = NULL;
-      for (index = 0, length = ports->len; index < length; index++)
+      kept = 0;
+      for (index = 0; index < ports->len; index++)
         {
           result_buffer_t *item;
 
-          item = g_array_index (ports, result_buffer_t*, index);
+          item = &g_array_index (ports, result_buffer_t, index);
           if (last_item
-              && (strcmp (item->port, last_item->port) == 0)
-              && (strcmp (item->host, last_item->host) == 0))
-            {
-              if (item->severity_double > last_item->severity_double)
-                {
-                  gchar *severity;
-                  severity = last_item->severity;
-                  last_item->severity = item->severity;
-                  item->severity = severity;
-                  last_item->severity_double = item->severity_double;
-                }
-              g_array_remove_index (ports, index);
-              length = ports->len;
-              index--;
-            }
-          else
-            last_item = item;
+              && item->port == last_item->port
+              && item->host == last_item->host)
+            continue;
+          if (kept != index)
+            g_array_index (ports, result_buffer_t, kept) = *item;
+          last_item = &g_array_index (ports, result_buffer_t, kept);
+          kept++;
         }
+      g_array_set_size (ports, kept);
 
       /* Sort by severity. */
 
@@ -26056,37 +29107,34 @@ print_report_port_xml (report_t report, FILE *out, const get_data_t *get,
            first_result + 1,
            max_results,
            report_port_count (report));
-  {
-    result_buffer_t *item;
-    int index = 0;
 
-    while ((item = g_array_index (ports, result_buffer_t*, index++)))
-      {
-        int host_port_count
-              = GPOINTER_TO_INT (g_hash_table_lookup (host_ports, item->host));
+  for (index = 0; index < ports->len; index++)
+    {
+      result_buffer_t *item;
+      int host_port_count;
 
-        PRINT (out,
-               "<port>"
-               "<host>%s</host>"
-               "%s"
-               "<severity>%1.1f</severity>"
-               "<threat>%s</threat>"
-               "</port>",
-               item->host,
-               item->port,
-               item->severity_double,
-               severity_to_level (g_strtod (item->severity, NULL), 0));
+      item = &g_array_index (ports, result_buffer_t, index);
+      host_port_count
+        = GPOINTER_TO_INT (g_hash_table_lookup (host_ports, item->host));
 
-        if (g_str_has_prefix(item->port, "general/") == FALSE)
-          {
-            g_hash_table_replace (host_ports,
-                                  g_strdup (item->host),
-                                  GINT_TO_POINTER (host_port_count + 1));
-          }
-        result_buffer_free (item);
-      }
-    g_array_free (ports, TRUE);
-  }
+      PRINT (out,
+             "<port>"
+             "<host>%s</host>"
+             "%s"
+             "<severity>%1.1f</severity>"
+             "<threat>%s</threat>"
+             "</port>",
+             item->host,
+             item->port,
+             item->severity_double,
+             severity_to_level (g_strtod (item->severity, NULL), 0));
+
+      if (g_str_has_prefix (item->port, "general/") == FALSE)
+        g_hash_table_replace (host_ports,
+                              (gpointer) item->host,
+                              GINT_TO_POINTER (host_port_count + 1));
+    }
+  g_array_free (ports, TRUE);
   PRINT (out, "</ports>");
 
   return 0;
@@ -26123,7 +29171,6 @@ tz_revert (gchar *zone, char *tz, char *old_tz_override)
 {
   if (zone && strlen (zone))
     {
-      gchar *quoted_old_tz_override;
       /* Revert to stored TZ. */
       if (tz)
         {
@@ -26139,10 +29186,8 @@ tz_revert (gchar *zone, char *tz, char *old_tz_override)
       else
         unsetenv ("TZ");
 
-      quoted_old_tz_override = sql_insert (old_tz_override);
-      sql ("SET SESSION \"gvmd.tz_override\" = %s;",
-           quoted_old_tz_override);
-      g_free (quoted_old_tz_override);
+      sql_session_set ("gvmd.tz_override",
+                       old_tz_override ? old_tz_override : "");
 
       free (old_tz_override);
       g_free (tz);
@@ -26215,6 +29260,290 @@ host_summary_append (GString *host_summary_buffer, const char *host,
     }
 }
 
+/**
+ * @brief Hash tables of per host counts, for printing report hosts.
+ */
+typedef struct
+{
+  GHashTable *ports;            ///< Port counts.
+  GHashTable *holes;            ///< High result counts.
+  GHashTable *warnings;         ///< Medium result counts.
+  GHashTable *infos;            ///< Low result counts.
+  GHashTable *logs;             ///< Log result counts.
+  GHashTable *false_positives;  ///< False positive result counts.
+} report_host_counts_t;
+
+/**
+ * @brief Print the XML for a report host to a file stream.
+ *
+ * @param[in]  stream  File stream to write to.
+ * @param[in]  hosts   Report host iterator.
+ * @param[in]  counts  Per host counts.
+ * @param[in]  lean    Whether to print lean XML.
+ *
+ * @return 0 on success, -1 error.
+ */
+static int
+print_report_host_xml (FILE *stream, iterator_t *hosts,
+                       report_host_counts_t *counts, int lean)
+{
+  const char *current_host;
+  int ports_count;
+  int holes_count, warnings_count, infos_count;
+  int logs_count, false_positives_count;
+
+  current_host = host_iterator_host (hosts);
+
+  ports_count
+    = GPOINTER_TO_INT (g_hash_table_lookup (counts->ports, current_host));
+  holes_count
+    = GPOINTER_TO_INT (g_hash_table_lookup (counts->holes, current_host));
+  warnings_count
+    = GPOINTER_TO_INT (g_hash_table_lookup (counts->warnings, current_host));
+  infos_count
+    = GPOINTER_TO_INT (g_hash_table_lookup (counts->infos, current_host));
+  logs_count
+    = GPOINTER_TO_INT (g_hash_table_lookup (counts->logs, current_host));
+  false_positives_count
+    = GPOINTER_TO_INT (g_hash_table_lookup (counts->false_positives,
+                                            current_host));
+
+  PRINT (stream,
+         "<host>"
+         "<ip>%s</ip>",
+         current_host);
+
+  if (host_iterator_asset_uuid (hosts)
+      && strlen (host_iterator_asset_uuid (hosts)))
+    PRINT (stream,
+           "<asset asset_id=\"%s\"/>",
+           host_iterator_asset_uuid (hosts));
+  else if (lean == 0)
+    PRINT (stream,
+           "<asset asset_id=\"\"/>");
+
+  PRINT (stream,
+         "<start>%s</start>"
+         "<end>%s</end>"
+         "<port_count><page>%d</page></port_count>"
+         "<result_count>"
+         "<page>%d</page>"
+         "<hole><page>%d</page></hole>"
+         "<warning><page>%d</page></warning>"
+         "<info><page>%d</page></info>"
+         "<log><page>%d</page></log>"
+         "<false_positive><page>%d</page></false_positive>"
+         "</result_count>",
+         host_iterator_start_time (hosts),
+         host_iterator_end_time (hosts)
+           ? host_iterator_end_time (hosts)
+           : "",
+         ports_count,
+         (holes_count + warnings_count + infos_count
+          + logs_count + false_positives_count),
+         holes_count,
+         warnings_count,
+         infos_count,
+         logs_count,
+         false_positives_count);
+
+  if (print_report_host_details_xml (host_iterator_report_host (hosts),
+                                     stream, lean))
+    return -1;
+
+  PRINT (stream,
+         "</host>");
+
+  return 0;
+}
+
+/**
+ * @brief Print the XML for a range of the hosts of a report.
+ *
+ * @param[in]  stream  File stream to write to.
+ * @param[in]  report  Report.
+ * @param[in]  first   Index of first host to print.
+ * @param[in]  last    Index of host after the last host to print.
+ * @param[in]  counts  Per host counts.
+ * @param[in]  lean    Whether to print lean XML.
+ *
+ * @return 0 on success, -1 error.
+ */
+static int
+print_report_hosts_range_xml (FILE *stream, report_t report, int first,
+                              int last, report_host_counts_t *counts,
+                              int lean)
+{
+  iterator_t hosts;
+  int index;
+
+  index = 0;
+  init_report_host_iterator (&hosts, report, NULL, 0);
+  while (index < last && next (&hosts))
+    {
+      if (index >= first
+          && print_report_host_xml (stream, &hosts, counts, lean))
+        {
+          cleanup_iterator (&hosts);
+          return -1;
+        }
+      index++;
+    }
+  cleanup_iterator (&hosts);
+  return 0;
+}
+
+/**
+ * @brief Print the XML for the hosts of a report, using worker processes.
+ *
+ * Each worker renders a disjoint range of the hosts to a temporary file on
+ * its own database connection.  The fragments are then copied to the
+ * stream in order.
+ *
+ * The connection of each worker gets the session of the current user and
+ * the timezone of the report, so that the hosts are printed exactly as
+ * print_report_hosts_range_xml would print them.
+ *
+ * @param[in]  stream      File stream to write to.
+ * @param[in]  report      Report.
+ * @param[in]  host_count  Number of hosts in the report.
+ * @param[in]  workers     Number of worker processes.
+ * @param[in]  counts      Per host counts.
+ * @param[in]  lean        Whether to print lean XML.
+ * @param[in]  zone        Timezone override of the report, NULL or "" for
+ *                         none.
+ *
+ * @return 0 on success, -1 error.
+ */
+static int
+print_report_hosts_xml_parallel (FILE *stream, report_t report,
+                                 int host_count, int workers,
+                                 report_host_counts_t *counts, int lean,
+                                 const gchar *zone)
+{
+  FILE **fragments;
+  pid_t *pids;
+  int index, ret;
+
+  fragments = g_malloc0 (workers * sizeof (FILE *));
+  pids = g_malloc0 (workers * sizeof (pid_t));
+  ret = 0;
+
+  for (index = 0; index < workers; index++)
+    {
+      fragments[index] = tmpfile ();
+      if (fragments[index] == NULL)
+        {
+          g_warning ("%s: tmpfile failed: %s",
+                     __func__,
+                     strerror (errno));
+          ret = -1;
+          break;
+        }
+
+      pids[index] = fork ();
+      switch (pids[index])
+        {
+          case 0:
+            {
+              int first, last, fail;
+
+              /* Child.  Reopen the database (required after fork) and
+               * render this worker's hosts.  Use _exit, so that stdio
+               * buffers shared with the parent are not flushed here. */
+              reinit_manage_worker ();
+              if (zone && strlen (zone))
+                sql_session_set ("gvmd.tz_override", zone);
+              first = (int) (((long long) host_count * index) / workers);
+              last = (int) (((long long) host_count * (index + 1)) / workers);
+              fail = print_report_hosts_range_xml (fragments[index], report,
+                                                   first, last, counts, lean);
+              if (fail == 0 && fflush (fragments[index]))
+                fail = 1;
+              sql_close ();
+              _exit (fail ? EXIT_FAILURE : EXIT_SUCCESS);
+            }
+          case -1:
+            g_warning ("%s: fork failed: %s",
+                       __func__,
+                       strerror (errno));
+            ret = -1;
+            break;
+          default:
+            g_debug ("%s: %i forked %i", __func__, getpid (), pids[index]);
+            break;
+        }
+      if (ret)
+        break;
+    }
+
+  /* Wait for all the workers that were started. */
+
+  for (index = 0; index < workers; index++)
+    {
+      int status;
+
+      if (pids[index] <= 0)
+        continue;
+
+      while (waitpid (pids[index], &status, 0) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          g_warning ("%s: waitpid: %s",
+                     __func__,
+                     strerror (errno));
+          status = -1;
+          break;
+        }
+
+      if (status == -1
+          || WIFEXITED (status) == 0
+          || WEXITSTATUS (status) != EXIT_SUCCESS)
+        {
+          g_warning ("%s: worker %i failed", __func__, index);
+          ret = -1;
+        }
+    }
+
+  /* Stitch the fragments together in order. */
+
+  for (index = 0; index < workers; index++)
+    {
+      char buffer[65536];
+      size_t count;
+
+      if (fragments[index] == NULL)
+        continue;
+
+      if (ret == 0)
+        {
+          rewind (fragments[index]);
+          while ((count = fread (buffer, 1, sizeof (buffer),
+                                 fragments[index])))
+            if (fwrite (buffer, 1, count, stream) != count)
+              {
+                g_warning ("%s: fwrite failed: %s",
+                           __func__,
+                           strerror (errno));
+                ret = -1;
+                break;
+              }
+          if (ferror (fragments[index]))
+            {
+              g_warning ("%s: fread failed", __func__);
+              ret = -1;
+            }
+        }
+
+      fclose (fragments[index]);
+    }
+
+  g_free (fragments);
+  g_free (pids);
+  return ret;
+}
+
 /**
  * @brief Init delta iterators for print_report_xml.
  *
@@ -26354,7 +29683,7 @@ init_delta_iterators (report_t report, iterator_t *results, report_t delta,
  * @param[in]  f_warnings       Result count.
  * @param[in]  orig_f_false_positives  Result count.
  * @param[in]  f_false_positives       Result count.
- * @param[in]  result_hosts   Result hosts.
+ * @param[in]  render         Render, for the result hosts and ports.
  *
  * @return 0 on success, -1 error.
  */
@@ -26372,7 +29701,7 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                         int *orig_f_logs, int *f_logs,
                         int *orig_f_warnings, int *f_warnings,
                         int *orig_f_false_positives, int *f_false_positives,
-                        array_t *result_hosts)
+                        report_render_t *render)
 {
   gboolean done, delta_done;
   int changed, gone, new, same;
@@ -26380,6 +29709,9 @@ print_report_delta_xml (FILE *out, iterator_t *results,
    * of port, threat pairs. */
   GTree *ports;
   gchar *msg;
+  /* Reused for the XML of each result, to avoid an allocation per result. */
+  GString *buffer;
+  delta_sort_field_t delta_sort;
 
   *orig_f_holes = *f_holes;
   *orig_f_infos = *f_infos;
@@ -26393,9 +29725,12 @@ print_report_delta_xml (FILE *out, iterator_t *results,
   new = (strchr (delta_states, 'n') != NULL);
   same = (strchr (delta_states, 's') != NULL);
 
-  ports = g_tree_new_full ((GCompareDataFunc) strcmp, NULL, g_free,
+  ports = g_tree_new_full ((GCompareDataFunc) strcmp, NULL, NULL,
                            (GDestroyNotify) free_host_ports);
 
+  delta_sort = delta_sort_field (sort_field);
+  buffer = g_string_new ("");
+
   /* Compare the results in the two iterators, which are sorted. */
 
   g_debug ("   delta: %s: start", __func__);
@@ -26406,7 +29741,6 @@ print_report_delta_xml (FILE *out, iterator_t *results,
   delta_done = !next (delta_results);
   while (1)
     {
-      GString *buffer;
       compare_results_t state;
       int used, would_use;
 
@@ -26467,7 +29801,7 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                 g_debug ("   delta: %s: extra from report 2: %s",
                         __func__,
                         result_iterator_nvt_oid (delta_results));
-                buffer = g_string_new ("");
+                g_string_truncate (buffer, 0);
                 buffer_results_xml (buffer,
                                     delta_results,
                                     task,
@@ -26485,11 +29819,10 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                                     0);
                 if (fprintf (out, "%s", buffer->str) < 0)
                   return -1;
-                g_string_free (buffer, TRUE);
                 if (result_hosts_only)
-                  array_add_new_string (result_hosts,
-                                        result_iterator_host (delta_results));
-                add_port (ports, delta_results);
+                  report_render_add_host (render,
+                                          result_iterator_host (delta_results));
+                add_port (ports, delta_results, render);
                 max_results--;
                 if (max_results == 0)
                   break;
@@ -26514,7 +29847,7 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                     first_result--;
                     continue;
                   }
-                buffer = g_string_new ("");
+                g_string_truncate (buffer, 0);
                 buffer_results_xml (buffer,
                                     results,
                                     task,
@@ -26532,11 +29865,10 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                                     0);
                 if (fprintf (out, "%s", buffer->str) < 0)
                   return -1;
-                g_string_free (buffer, TRUE);
                 if (result_hosts_only)
-                  array_add_new_string (result_hosts,
-                                        result_iterator_host (results));
-                add_port (ports, results);
+                  report_render_add_host (render,
+                                          result_iterator_host (results));
+                add_port (ports, results, render);
                 max_results--;
                 if (max_results == 0)
                   break;
@@ -26584,7 +29916,7 @@ print_report_delta_xml (FILE *out, iterator_t *results,
 
       /* Compare the two results. */
 
-      buffer = g_string_new ("");
+      g_string_truncate (buffer, 0);
       state = compare_and_buffer_results (buffer,
                                           results,
                                           delta_results,
@@ -26594,7 +29926,7 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                                           overrides,
                                           overrides_details,
                                           sort_order,
-                                          sort_field,
+                                          delta_sort,
                                           changed,
                                           gone,
                                           new,
@@ -26611,7 +29943,6 @@ print_report_delta_xml (FILE *out, iterator_t *results,
         }
       if (fprintf (out, "%s", buffer->str) < 0)
         return -1;
-      g_string_free (buffer, TRUE);
 
       if ((used == 0)
           && ((state == COMPARE_RESULTS_GONE)
@@ -26685,9 +30016,9 @@ print_report_delta_xml (FILE *out, iterator_t *results,
           if (used)
             {
               if (result_hosts_only)
-                array_add_new_string (result_hosts,
-                                      result_iterator_host (results));
-              add_port (ports, results);
+                report_render_add_host (render,
+                                        result_iterator_host (results));
+              add_port (ports, results, render);
             }
           done = !next (results);
         }
@@ -26698,9 +30029,9 @@ print_report_delta_xml (FILE *out, iterator_t *results,
           if (used)
             {
               if (result_hosts_only)
-                array_add_new_string (result_hosts,
-                                      result_iterator_host (results));
-              add_port (ports, results);
+                report_render_add_host (render,
+                                        result_iterator_host (results));
+              add_port (ports, results, render);
             }
           done = !next (results);
           delta_done = !next (delta_results);
@@ -26770,11 +30101,10 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                 }
 
               if (result_hosts_only)
-                array_add_new_string (result_hosts,
-                                      result_iterator_host
-                                       (delta_results));
+                report_render_add_host (render,
+                                        result_iterator_host (delta_results));
 
-              add_port (ports, delta_results);
+              add_port (ports, delta_results, render);
             }
           delta_done = !next (delta_results);
         }
@@ -26782,6 +30112,8 @@ print_report_delta_xml (FILE *out, iterator_t *results,
         assert (0);
     }
 
+  g_string_free (buffer, TRUE);
+
   /* Compare remaining results, for the filtered report counts. */
 
   g_debug ("   delta: %s: counting rest", __func__);
@@ -26889,7 +30221,7 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                                           overrides,
                                           overrides_details,
                                           sort_order,
-                                          sort_field,
+                                          delta_sort,
                                           changed,
                                           gone,
                                           new,
@@ -27042,12 +30374,14 @@ print_report_delta_xml (FILE *out, iterator_t *results,
 }
 
 /**
- * @brief Print the main XML content for a report to a file.
+ * @brief Print the main XML content for a report to a stream.
  *
  * @param[in]  report      The report.
  * @param[in]  delta       Report to compare with the report.
  * @param[in]  task        Task associated with report.
- * @param[in]  xml_start   File name.
+ * @param[in]  out         Stream to print to.  Left open on success, so that
+ *                         the caller can add to the report.  Some errors
+ *                         close it.
  * @param[in]  get         GET command data.
  * @param[in]  notes_details      If notes, Whether to include details.
  * @param[in]  overrides_details  If overrides, Whether to include details.
@@ -27061,26 +30395,25 @@ print_report_delta_xml (FILE *out, iterator_t *results,
  * @return 0 on success, -1 error, 2 failed to find filter (before any printing).
  */
 static int
-print_report_xml_start (report_t report, report_t delta, task_t task,
-                        gchar* xml_start, const get_data_t *get,
-                        int notes_details, int overrides_details,
-                        int result_tags, int ignore_pagination, int lean,
-                        gchar **filter_term_return, gchar **zone_return,
-                        gchar **host_summary)
+print_report_xml_start_stream (report_t report, report_t delta, task_t task,
+                               FILE *out, const get_data_t *get,
+                               int notes_details, int overrides_details,
+                               int result_tags, int ignore_pagination,
+                               int lean, gchar **filter_term_return,
+                               gchar **zone_return, gchar **host_summary)
 {
   int result_hosts_only;
   int notes, overrides;
 
   int first_result, max_results, sort_order;
 
-  FILE *out;
   gchar *clean, *term, *sort_field, *levels, *search_phrase;
   gchar *min_qod;
   gchar *delta_states, *timestamp;
   int min_qod_int;
   char *uuid, *tsk_uuid = NULL, *start_time, *end_time;
   int total_result_count, filtered_result_count;
-  array_t *result_hosts;
+  report_render_t render;
   int reuse_result_iterator;
   iterator_t results, delta_results;
   int holes, infos, logs, warnings, false_positives;
@@ -27130,16 +30463,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
   if (report == 0)
     {
       assert (0);
-      return -1;
-    }
-
-  out = fopen (xml_start, "w");
-
-  if (out == NULL)
-    {
-      g_warning ("%s: fopen failed: %s",
-                 __func__,
-                 strerror (errno));
+      fclose (out);
       return -1;
     }
 
@@ -27200,7 +30524,6 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
 
   if (zone && strlen (zone))
     {
-      gchar *quoted_zone;
       /* Store current TZ. */
       tz = getenv ("TZ") ? g_strdup (getenv ("TZ")) : NULL;
 
@@ -27217,9 +30540,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
       old_tz_override = sql_string ("SELECT current_setting"
                                     "        ('gvmd.tz_override');");
 
-      quoted_zone = sql_insert (zone);
-      sql ("SET SESSION \"gvmd.tz_override\" = %s;", quoted_zone);
-      g_free (quoted_zone);
+      sql_session_set ("gvmd.tz_override", zone);
 
       tzset ();
     }
@@ -27688,19 +31009,22 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
 
   /* Port summary. */
 
-  f_host_ports = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                        g_free, NULL);
+  /* The hosts in the count tables are interned in the render. */
+  report_render_init (&render);
+  f_host_ports = g_hash_table_new (g_str_hash, g_str_equal);
 
   reuse_result_iterator = 0;
   if (get->details && (delta == 0))
     {
       reuse_result_iterator = 1;
       if (print_report_port_xml (report, out, get, first_result, max_results,
-                                 sort_order, sort_field, f_host_ports, &results))
+                                 sort_order, sort_field, f_host_ports, &results,
+                                 &render))
         {
           g_free (term);
           tz_revert (zone, tz, old_tz_override);
           g_hash_table_destroy (f_host_ports);
+          report_render_free (&render);
           return -1;
         }
     }
@@ -27738,6 +31062,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
         {
           g_free (term);
           g_hash_table_destroy (f_host_ports);
+          report_render_free (&render);
           return -1;
         }
       g_free (term);
@@ -27754,6 +31079,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
           if (res)
             {
               g_hash_table_destroy (f_host_ports);
+              report_render_free (&render);
               return -1;
             }
         }
@@ -27769,22 +31095,11 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
              /* Add 1 for 1 indexing. */
              ignore_pagination ? 1 : first_result + 1,
              ignore_pagination ? -1 : max_results);
-  if (get->details && result_hosts_only)
-    result_hosts = make_array ();
-  else
-    /* Quiet erroneous compiler warning. */
-    result_hosts = NULL;
-
-  f_host_holes = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                        g_free, NULL);
-  f_host_warnings = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                           g_free, NULL);
-  f_host_infos = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                      g_free, NULL);
-  f_host_logs = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                      g_free, NULL);
-  f_host_false_positives = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                  g_free, NULL);
+  f_host_holes = g_hash_table_new (g_str_hash, g_str_equal);
+  f_host_warnings = g_hash_table_new (g_str_hash, g_str_equal);
+  f_host_infos = g_hash_table_new (g_str_hash, g_str_equal);
+  f_host_logs = g_hash_table_new (g_str_hash, g_str_equal);
+  f_host_false_positives = g_hash_table_new (g_str_hash, g_str_equal);
 
   if (delta && get->details)
     {
@@ -27801,7 +31116,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
                                   &orig_f_logs, &f_logs,
                                   &orig_f_warnings, &f_warnings,
                                   &orig_f_false_positives, &f_false_positives,
-                                  result_hosts))
+                                  &render))
         {
           fclose (out);
           g_free (sort_field);
@@ -27818,6 +31133,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
           g_hash_table_destroy (f_host_infos);
           g_hash_table_destroy (f_host_logs);
           g_hash_table_destroy (f_host_false_positives);
+          report_render_free (&render);
 
           return -1;
         }
@@ -27852,8 +31168,8 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
           PRINT_XML (out, buffer->str);
           g_string_free (buffer, TRUE);
           if (result_hosts_only)
-            array_add_new_string (result_hosts,
-                                  result_iterator_host (&results));
+            report_render_add_host (&render,
+                                    result_iterator_host (&results));
 
           result_severity = result_iterator_severity_double (&results);
           if (result_severity > f_severity)
@@ -27901,7 +31217,8 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
                         (g_hash_table_lookup (f_host_result_counts, result_host));
 
               g_hash_table_replace (f_host_result_counts,
-                                    g_strdup (result_host),
+                                    (gpointer) report_render_intern
+                                                (&render, result_host),
                                     GINT_TO_POINTER (result_count + 1));
             }
 
@@ -27989,13 +31306,15 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
 
   if (get->details && result_hosts_only)
     {
-      gchar *result_host;
-      int index = 0;
-      array_terminate (result_hosts);
-      while ((result_host = g_ptr_array_index (result_hosts, index++)))
+      guint index;
+
+      for (index = 0; index < render.hosts->len; index++)
         {
+          const gchar *result_host;
           gboolean present;
           iterator_t hosts;
+
+          result_host = g_ptr_array_index (render.hosts, index);
           init_report_host_iterator (&hosts, report, result_host, 0);
           present = next (&hosts);
           if (delta && (present == FALSE))
@@ -28087,6 +31406,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
                   g_hash_table_destroy (f_host_infos);
                   g_hash_table_destroy (f_host_logs);
                   g_hash_table_destroy (f_host_false_positives);
+                  report_render_free (&render);
                   return -1;
                 }
 
@@ -28095,102 +31415,78 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
             }
           cleanup_iterator (&hosts);
         }
-      array_free (result_hosts);
     }
   else if (get->details)
     {
       iterator_t hosts;
+      report_host_counts_t counts;
+      int host_count, workers, fail;
+
+      counts.ports = f_host_ports;
+      counts.holes = f_host_holes;
+      counts.warnings = f_host_warnings;
+      counts.infos = f_host_infos;
+      counts.logs = f_host_logs;
+      counts.false_positives = f_host_false_positives;
+
+      fail = 0;
+      workers = report_host_workers;
       init_report_host_iterator (&hosts, report, NULL, 0);
-      while (next (&hosts))
-        {
-          const char *current_host;
-          int ports_count;
-          int holes_count, warnings_count, infos_count;
-          int logs_count, false_positives_count;
-
-          current_host = host_iterator_host (&hosts);
-
-          ports_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_ports, current_host));
-          holes_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_holes, current_host));
-          warnings_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_warnings, current_host));
-          infos_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_infos, current_host));
-          logs_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_logs, current_host));
-          false_positives_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_false_positives, current_host));
-
-          host_summary_append (host_summary_buffer,
-                               host_iterator_host (&hosts),
-                               host_iterator_start_time (&hosts),
-                               host_iterator_end_time (&hosts));
-          PRINT (out,
-                 "<host>"
-                 "<ip>%s</ip>",
-                 host_iterator_host (&hosts));
-
-          if (host_iterator_asset_uuid (&hosts)
-              && strlen (host_iterator_asset_uuid (&hosts)))
-            PRINT (out,
-                   "<asset asset_id=\"%s\"/>",
-                   host_iterator_asset_uuid (&hosts));
-          else if (lean == 0)
-            PRINT (out,
-                   "<asset asset_id=\"\"/>");
+      if (workers > 1)
+        {
+          /* Only collect the summary here, the workers print the hosts. */
+          host_count = 0;
+          while (next (&hosts))
+            {
+              host_summary_append (host_summary_buffer,
+                                   host_iterator_host (&hosts),
+                                   host_iterator_start_time (&hosts),
+                                   host_iterator_end_time (&hosts));
+              host_count++;
+            }
+          cleanup_iterator (&hosts);
 
-          PRINT (out,
-                 "<start>%s</start>"
-                 "<end>%s</end>"
-                 "<port_count><page>%d</page></port_count>"
-                 "<result_count>"
-                 "<page>%d</page>"
-                 "<hole><page>%d</page></hole>"
-                 "<warning><page>%d</page></warning>"
-                 "<info><page>%d</page></info>"
-                 "<log><page>%d</page></log>"
-                 "<false_positive><page>%d</page></false_positive>"
-                 "</result_count>",
-                 host_iterator_start_time (&hosts),
-                 host_iterator_end_time (&hosts)
-                   ? host_iterator_end_time (&hosts)
-                   : "",
-                 ports_count,
-                 (holes_count + warnings_count + infos_count
-                  + logs_count + false_positives_count),
-                 holes_count,
-                 warnings_count,
-                 infos_count,
-                 logs_count,
-                 false_positives_count);
-
-          if (print_report_host_details_xml
-               (host_iterator_report_host (&hosts), out, lean))
-            {
-              tz_revert (zone, tz, old_tz_override);
-              if (host_summary_buffer)
-                g_string_free (host_summary_buffer, TRUE);
-              g_hash_table_destroy (f_host_ports);
-              g_hash_table_destroy (f_host_holes);
-              g_hash_table_destroy (f_host_warnings);
-              g_hash_table_destroy (f_host_infos);
-              g_hash_table_destroy (f_host_logs);
-              g_hash_table_destroy (f_host_false_positives);
-              return -1;
+          if (host_count < workers)
+            workers = host_count;
+          if (workers > 1)
+            fail = print_report_hosts_xml_parallel (out, report, host_count,
+                                                    workers, &counts, lean,
+                                                    zone);
+          else if (workers == 1)
+            fail = print_report_hosts_range_xml (out, report, 0, host_count,
+                                                 &counts, lean);
+        }
+      else
+        {
+          while (next (&hosts))
+            {
+              host_summary_append (host_summary_buffer,
+                                   host_iterator_host (&hosts),
+                                   host_iterator_start_time (&hosts),
+                                   host_iterator_end_time (&hosts));
+              if (print_report_host_xml (out, &hosts, &counts, lean))
+                {
+                  fail = 1;
+                  break;
+                }
             }
+          cleanup_iterator (&hosts);
+        }
 
-          PRINT (out,
-                 "</host>");
+      if (fail)
+        {
+          tz_revert (zone, tz, old_tz_override);
+          if (host_summary_buffer)
+            g_string_free (host_summary_buffer, TRUE);
+          g_hash_table_destroy (f_host_ports);
+          g_hash_table_destroy (f_host_holes);
+          g_hash_table_destroy (f_host_warnings);
+          g_hash_table_destroy (f_host_infos);
+          g_hash_table_destroy (f_host_logs);
+          g_hash_table_destroy (f_host_false_positives);
+          report_render_free (&render);
+          return -1;
         }
-      cleanup_iterator (&hosts);
     }
 
   g_hash_table_destroy (f_host_ports);
@@ -28199,6 +31495,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
   g_hash_table_destroy (f_host_infos);
   g_hash_table_destroy (f_host_logs);
   g_hash_table_destroy (f_host_false_positives);
+  report_render_free (&render);
 
   end_time = scan_end_time (report);
   PRINT (out,
@@ -28223,6 +31520,57 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
   if (host_summary && host_summary_buffer)
     *host_summary = g_string_free (host_summary_buffer, FALSE);
 
+  return 0;
+}
+
+/**
+ * @brief Print the main XML content for a report to a file.
+ *
+ * @param[in]  report      The report.
+ * @param[in]  delta       Report to compare with the report.
+ * @param[in]  task        Task associated with report.
+ * @param[in]  xml_start   File name.
+ * @param[in]  get         GET command data.
+ * @param[in]  notes_details      If notes, Whether to include details.
+ * @param[in]  overrides_details  If overrides, Whether to include details.
+ * @param[in]  result_tags        Whether to include tags in results.
+ * @param[in]  ignore_pagination   Whether to ignore pagination data.
+ * @param[in]  lean                Whether to return lean report.
+ * @param[out] filter_term_return  Filter term used in report.
+ * @param[out] zone_return         Actual timezone used in report.
+ * @param[out] host_summary    Summary of results per host.
+ *
+ * @return 0 on success, -1 error, 2 failed to find filter (before any printing).
+ */
+static int
+print_report_xml_start (report_t report, report_t delta, task_t task,
+                        gchar* xml_start, const get_data_t *get,
+                        int notes_details, int overrides_details,
+                        int result_tags, int ignore_pagination, int lean,
+                        gchar **filter_term_return, gchar **zone_return,
+                        gchar **host_summary)
+{
+  FILE *out;
+  int ret;
+
+  out = fopen (xml_start, "w");
+
+  if (out == NULL)
+    {
+      g_warning ("%s: fopen failed: %s",
+                 __func__,
+                 strerror (errno));
+      return -1;
+    }
+
+  ret = print_report_xml_start_stream (report, delta, task, out, get,
+                                       notes_details, overrides_details,
+                                       result_tags, ignore_pagination, lean,
+                                       filter_term_return, zone_return,
+                                       host_summary);
+  if (ret)
+    return ret;
+
   if (fclose (out))
     {
       g_warning ("%s: fclose failed: %s",
@@ -28403,6 +31751,612 @@ manage_report (report_t report, report_t delta_report, const get_data_t *get,
  */
 #define MANAGE_SEND_REPORT_CHUNK_SIZE (MANAGE_SEND_REPORT_CHUNK64_SIZE * 3 / 4)
 
+/**
+ * @brief Sink that sends report XML to the client while it is generated.
+ *
+ * The sink belongs to its stream, and is freed when the stream is closed.
+ */
+typedef struct
+{
+  char *chunk;              ///< Buffer of MANAGE_SEND_REPORT_CHUNK_SIZE + 1.
+  size_t used;              ///< Number of bytes used in chunk.
+  int base64;               ///< Whether to base64 encode the report.
+  int discard;              ///< Whether to drop output, after an error.
+  int finish;               ///< Whether to send the rest of chunk on close.
+  int *closed;              ///< Set to 1 when the stream is closed.
+  int failed;               ///< Whether sending to the client failed.
+  const gchar *prefix;      ///< Text to send before the report, or NULL.
+  gboolean (*send) (const char *,
+                    int (*) (const char *, void*),
+                    void*); ///< Function to write to client.
+  int (*send_data_1) (const char *, void*); ///< Second argument to send.
+  void *send_data_2;        ///< Third argument to send.
+} report_send_sink_t;
+
+/**
+ * @brief Send the buffered chunk of a report send sink to the client.
+ *
+ * @param[in]  sink  Sink.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+report_send_sink_flush (report_send_sink_t *sink)
+{
+  if (sink->failed)
+    return -1;
+
+  if (sink->prefix)
+    {
+      const gchar *prefix;
+
+      prefix = sink->prefix;
+      sink->prefix = NULL;
+      if (sink->send (prefix, sink->send_data_1, sink->send_data_2))
+        {
+          g_warning ("%s: send prefix error", __func__);
+          sink->failed = 1;
+          return -1;
+        }
+    }
+
+  if (sink->used == 0)
+    return 0;
+
+  if (sink->base64)
+    {
+      gchar *chunk64;
+
+      chunk64 = g_base64_encode ((guchar*) sink->chunk, sink->used);
+      if (sink->send (chunk64, sink->send_data_1, sink->send_data_2))
+        {
+          g_free (chunk64);
+          g_warning ("%s: send error", __func__);
+          sink->failed = 1;
+          return -1;
+        }
+      g_free (chunk64);
+    }
+  else
+    {
+      sink->chunk[sink->used] = '\0';
+      if (sink->send (sink->chunk, sink->send_data_1, sink->send_data_2))
+        {
+          g_warning ("%s: send error", __func__);
+          sink->failed = 1;
+          return -1;
+        }
+    }
+
+  sink->used = 0;
+  return 0;
+}
+
+/**
+ * @brief Write callback of the report send sink stream.
+ *
+ * Buffers the data and sends it to the client in chunks of
+ * MANAGE_SEND_REPORT_CHUNK_SIZE, so that base64 encoded chunks can be
+ * concatenated.
+ *
+ * @param[in]  cookie  Sink.
+ * @param[in]  buf     Data to write.
+ * @param[in]  size    Size of data.
+ *
+ * @return Number of bytes written on success, -1 on error.
+ */
+static ssize_t
+report_send_sink_write (void *cookie, const char *buf, size_t size)
+{
+  report_send_sink_t *sink;
+  size_t done;
+
+  sink = cookie;
+
+  /* Drop the output that is flushed when the stream is closed after an
+   * error. */
+  if (sink->discard)
+    return size;
+
+  done = 0;
+  while (done < size)
+    {
+      size_t count;
+
+      count = MIN (size - done, MANAGE_SEND_REPORT_CHUNK_SIZE - sink->used);
+      memcpy (sink->chunk + sink->used, buf + done, count);
+      sink->used += count;
+      done += count;
+
+      if (sink->used == MANAGE_SEND_REPORT_CHUNK_SIZE
+          && report_send_sink_flush (sink))
+        return -1;
+    }
+
+  return size;
+}
+
+/**
+ * @brief Close callback of the report send sink stream.
+ *
+ * Sends the rest of the report if the report is finished, and frees the
+ * sink.
+ *
+ * @param[in]  cookie  Sink.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+report_send_sink_close (void *cookie)
+{
+  report_send_sink_t *sink;
+  int ret;
+
+  sink = cookie;
+  ret = 0;
+  if (sink->finish && sink->discard == 0)
+    ret = report_send_sink_flush (sink);
+  if (sink->closed)
+    *sink->closed = 1;
+  g_free (sink->chunk);
+  g_free (sink);
+  return ret;
+}
+
+/**
+ * @brief Generate a report in the native XML format, streaming to the client.
+ *
+ * The XML is sent to the client as it is generated, instead of going
+ * through a file.  Memory use is bounded by the chunk size.
+ *
+ * @param[in]  report             Report.
+ * @param[in]  delta_report       Report to compare with.
+ * @param[in]  task               Task associated with report.
+ * @param[in]  get                GET command data.
+ * @param[in]  notes_details      If notes, Whether to include details.
+ * @param[in]  overrides_details  If overrides, Whether to include details.
+ * @param[in]  result_tags        Whether to include tags in results.
+ * @param[in]  ignore_pagination  Whether to ignore pagination.
+ * @param[in]  lean               Whether to send lean report.
+ * @param[in]  base64             Whether to base64 encode the report.
+ * @param[in]  send               Function to write to client.
+ * @param[in]  send_data_1        Second argument to \p send.
+ * @param[in]  send_data_2        Third argument to \p send.
+ * @param[in]  prefix             Text to send to client before the report.
+ *
+ * @return 0 success, -1 error, 2 failed to find filter (before anything sent
+ *         to client).
+ */
+static int
+manage_stream_report (report_t report, report_t delta_report, task_t task,
+                      const get_data_t *get, int notes_details,
+                      int overrides_details, int result_tags,
+                      int ignore_pagination, int lean, int base64,
+                      gboolean (*send) (const char *,
+                                        int (*) (const char *, void*),
+                                        void*),
+                      int (*send_data_1) (const char *, void*),
+                      void *send_data_2, const gchar* prefix)
+{
+  report_send_sink_t *sink;
+  cookie_io_functions_t functions;
+  FILE *out;
+  int ret, closed;
+
+  memset (&functions, 0, sizeof (functions));
+  functions.write = report_send_sink_write;
+  functions.close = report_send_sink_close;
+
+  sink = g_malloc0 (sizeof (*sink));
+  sink->chunk = g_malloc (MANAGE_SEND_REPORT_CHUNK_SIZE + 1);
+  sink->base64 = base64;
+  sink->prefix = prefix;
+  sink->send = send;
+  sink->send_data_1 = send_data_1;
+  sink->send_data_2 = send_data_2;
+  closed = 0;
+  sink->closed = &closed;
+
+  out = fopencookie (sink, "w", functions);
+  if (out == NULL)
+    {
+      g_warning ("%s: fopencookie failed: %s",
+                 __func__,
+                 strerror (errno));
+      g_free (sink->chunk);
+      g_free (sink);
+      return -1;
+    }
+
+  ret = print_report_xml_start_stream (report, delta_report, task, out, get,
+                                       notes_details, overrides_details,
+                                       result_tags, ignore_pagination, lean,
+                                       NULL, NULL, NULL);
+  if (ret)
+    {
+      /* Some errors close the stream, which frees the sink. */
+      if (closed == 0)
+        {
+          sink->discard = 1;
+          fclose (out);
+        }
+      return ret;
+    }
+
+  sink->finish = 1;
+  if (fputs ("</report>", out) == EOF)
+    {
+      sink->discard = 1;
+      fclose (out);
+      return -1;
+    }
+
+  /* Closing sends the rest of the report and frees the sink. */
+  if (fclose (out))
+    return -1;
+  return 0;
+}
+
+/**
+ * @brief Get the directory of the render cache.
+ *
+ * @return Freshly allocated path.
+ */
+static gchar *
+report_render_cache_dir ()
+{
+  return g_build_filename (GVMD_STATE_DIR, "report_render_cache", NULL);
+}
+
+/**
+ * @brief Append the state of a table that affects rendered reports.
+ *
+ * @param[in]  key    Key being built.
+ * @param[in]  table  Table with a modification_time column.
+ */
+static void
+report_render_cache_key_table (GString *key, const char *table)
+{
+  gchar *state;
+
+  state = sql_string ("SELECT coalesce (max (modification_time), 0)"
+                      "       || '/' || count (*)"
+                      " FROM %s;",
+                      table);
+  g_string_append_printf (key, "%s=%s\n", table, state ? state : "");
+  g_free (state);
+}
+
+/**
+ * @brief Get the render cache file for a report.
+ *
+ * The name of the file is the report UUID followed by a hash of
+ * everything that goes into the rendered report: the report format and
+ * its params, the filter and options, the user with their severity and
+ * time settings, the modification state of the notes, overrides, tags
+ * and permissions, the groups and roles of the user, and the NVT feed.  A
+ * change to any of these gives a new file, and old files are removed by
+ * report_render_cache_prune.
+ *
+ * @param[in]  report             Report.
+ * @param[in]  report_format      Report format.
+ * @param[in]  get                GET command data.
+ * @param[in]  notes_details      If notes, Whether to include details.
+ * @param[in]  overrides_details  If overrides, Whether to include details.
+ * @param[in]  result_tags        Whether to include tags in results.
+ * @param[in]  ignore_pagination  Whether to ignore pagination.
+ * @param[in]  lean               Whether to send lean report.
+ *
+ * @return Freshly allocated path, or NULL if the report may not be cached.
+ */
+static gchar *
+report_render_cache_file (report_t report, report_format_t report_format,
+                          const get_data_t *get, int notes_details,
+                          int overrides_details, int result_tags,
+                          int ignore_pagination, int lean)
+{
+  GString *key;
+  task_status_t status;
+  gchar *value, *hash, *name, *dir, *file, *uuid;
+
+  if (report_render_cache_size == 0)
+    return NULL;
+
+  /* Only finished reports stay the same. */
+  if (report_scan_run_status (report, &status)
+      || status != TASK_STATUS_DONE)
+    return NULL;
+
+  uuid = report_uuid (report);
+  if (uuid == NULL)
+    return NULL;
+
+  key = g_string_new ("");
+
+  value = sql_string ("SELECT modification_time FROM reports"
+                      " WHERE id = %llu;",
+                      report);
+  g_string_append_printf (key, "report=%s/%s\n", uuid, value ? value : "");
+  g_free (value);
+
+  value = sql_string ("SELECT uuid || '/' || modification_time"
+                      " FROM report_formats WHERE id = %llu;",
+                      report_format);
+  g_string_append_printf (key, "format=%s\n", value ? value : "");
+  g_free (value);
+  value = sql_string ("SELECT string_agg (name || '=' || coalesce (value, ''),"
+                      "                   ',' ORDER BY name)"
+                      " FROM report_format_params"
+                      " WHERE report_format = %llu;",
+                      report_format);
+  g_string_append_printf (key, "params=%s\n", value ? value : "");
+  g_free (value);
+
+  if (get->filt_id && strcmp (get->filt_id, FILT_ID_NONE))
+    {
+      value = filter_term (get->filt_id);
+      g_string_append_printf (key, "filt_id=%s\n", value ? value : "");
+      g_free (value);
+    }
+  value = manage_clean_filter (get->filter ? get->filter : "");
+  g_string_append_printf (key,
+                          "filter=%s\nreplace=%s/%s\n"
+                          "options=%i,%i,%i,%i,%i,%i,%i,%i\n",
+                          value,
+                          get->filter_replace ? get->filter_replace : "",
+                          get->filter_replacement
+                           ? get->filter_replacement : "",
+                          get->details, get->ignore_pagination,
+                          get->ignore_max_rows_per_page, notes_details,
+                          overrides_details, result_tags, ignore_pagination,
+                          lean);
+  g_free (value);
+
+  if (get->extra_params)
+    {
+      GList *names, *point;
+
+      names = g_list_sort (g_hash_table_get_keys (get->extra_params),
+                           (GCompareFunc) strcmp);
+      for (point = names; point; point = point->next)
+        g_string_append_printf (key, "extra:%s=%s\n",
+                                (gchar *) point->data,
+                                (gchar *) g_hash_table_lookup
+                                           (get->extra_params, point->data));
+      g_list_free (names);
+    }
+
+  g_string_append_printf (key, "user=%s\ntimezone=%s\ndynamic=%i\n",
+                          current_credentials.uuid
+                           ? current_credentials.uuid : "",
+                          current_credentials.timezone
+                           ? current_credentials.timezone : "",
+                          setting_dynamic_severity_int ());
+
+  report_render_cache_key_table (key, "notes");
+  report_render_cache_key_table (key, "overrides");
+  report_render_cache_key_table (key, "tags");
+
+  /* Access to the report and to notes, overrides and tags depends on the
+   * permissions, and on the groups and roles of the user. */
+  report_render_cache_key_table (key, "permissions");
+  value = sql_string ("SELECT coalesce ((SELECT string_agg (\"group\"::text,"
+                      "                                     ','"
+                      "                                     ORDER BY \"group\")"
+                      "                  FROM group_users"
+                      "                  WHERE \"user\" = users.id),"
+                      "                 '')"
+                      "       || '/'"
+                      "       || coalesce ((SELECT string_agg (role::text, ','"
+                      "                                        ORDER BY role)"
+                      "                     FROM role_users"
+                      "                     WHERE \"user\" = users.id),"
+                      "                    '')"
+                      " FROM users WHERE uuid = '%s';",
+                      current_credentials.uuid ? current_credentials.uuid : "");
+  g_string_append_printf (key, "membership=%s\n", value ? value : "");
+  g_free (value);
+
+  /* A feed update changes the names, solutions, references and severities
+   * of the NVTs in the report. */
+  value = nvts_feed_version ();
+  g_string_append_printf (key, "nvts_feed=%s\n", value ? value : "");
+  g_free (value);
+  report_render_cache_key_table (key, "nvts");
+
+  hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, key->str, -1);
+  g_string_free (key, TRUE);
+
+  name = g_strdup_printf ("%s-%s", uuid, hash);
+  dir = report_render_cache_dir ();
+  file = g_build_filename (dir, name, NULL);
+  g_free (dir);
+  g_free (name);
+  g_free (hash);
+  free (uuid);
+
+  return file;
+}
+
+/**
+ * @brief A file in the render cache.
+ */
+typedef struct
+{
+  gchar *path;      ///< Path of file.
+  time_t time;      ///< Time of last use.
+  off_t size;       ///< Size of file.
+} report_render_cache_entry_t;
+
+/**
+ * @brief Compare render cache entries by time of last use.
+ *
+ * @param[in]  one  First entry.
+ * @param[in]  two  Second entry.
+ *
+ * @return Less than, equal to, or greater than 0.
+ */
+static gint
+report_render_cache_entry_compare (gconstpointer one, gconstpointer two)
+{
+  const report_render_cache_entry_t *entry_one = one, *entry_two = two;
+
+  if (entry_one->time < entry_two->time)
+    return -1;
+  return entry_one->time > entry_two->time;
+}
+
+/**
+ * @brief Remove the least recently used renders beyond the cache size.
+ */
+static void
+report_render_cache_prune ()
+{
+  GDir *dir;
+  gchar *dir_path;
+  const gchar *name;
+  GSList *entries, *point;
+  off_t total;
+
+  dir_path = report_render_cache_dir ();
+  dir = g_dir_open (dir_path, 0, NULL);
+  if (dir == NULL)
+    {
+      g_free (dir_path);
+      return;
+    }
+
+  entries = NULL;
+  total = 0;
+  while ((name = g_dir_read_name (dir)))
+    {
+      report_render_cache_entry_t *entry;
+      GStatBuf state;
+      gchar *path;
+
+      path = g_build_filename (dir_path, name, NULL);
+      if (g_stat (path, &state))
+        {
+          g_free (path);
+          continue;
+        }
+      entry = g_malloc (sizeof (*entry));
+      entry->path = path;
+      entry->time = state.st_mtime;
+      entry->size = state.st_size;
+      total += entry->size;
+      entries = g_slist_prepend (entries, entry);
+    }
+  g_dir_close (dir);
+  g_free (dir_path);
+
+  entries = g_slist_sort (entries, report_render_cache_entry_compare);
+  for (point = entries; point; point = point->next)
+    {
+      report_render_cache_entry_t *entry = point->data;
+
+      if (total > (off_t) report_render_cache_size * 1024 * 1024)
+        {
+          g_unlink (entry->path);
+          total -= entry->size;
+        }
+      g_free (entry->path);
+      g_free (entry);
+    }
+  g_slist_free (entries);
+}
+
+/**
+ * @brief Add a rendered report to the render cache.
+ *
+ * @param[in]  output_file  Rendered report.
+ * @param[in]  cache_file   Render cache file for the report.
+ */
+static void
+report_render_cache_store (const gchar *output_file, const gchar *cache_file)
+{
+  gchar *dir, *temp_file;
+
+  dir = report_render_cache_dir ();
+  if (g_mkdir_with_parents (dir, 0700))
+    {
+      g_warning ("%s: failed to create %s: %s",
+                 __func__, dir, strerror (errno));
+      g_free (dir);
+      return;
+    }
+  g_free (dir);
+
+  /* Copy to a temporary name first, so that other processes never serve a
+   * partial file. */
+  temp_file = g_strdup_printf ("%s.%i", cache_file, (int) getpid ());
+  if (gvm_file_copy (output_file, temp_file)
+      && g_rename (temp_file, cache_file) == 0)
+    report_render_cache_prune ();
+  else
+    g_unlink (temp_file);
+  g_free (temp_file);
+}
+
+/**
+ * @brief Remove the renders of a report from the render cache.
+ *
+ * @param[in]  report  Report.
+ */
+static void
+report_render_cache_remove (report_t report)
+{
+  GDir *dir;
+  gchar *dir_path, *uuid;
+  const gchar *name;
+
+  if (report_render_cache_size == 0)
+    return;
+
+  dir_path = report_render_cache_dir ();
+  dir = g_dir_open (dir_path, 0, NULL);
+  uuid = report_uuid (report);
+  if (dir && uuid)
+    while ((name = g_dir_read_name (dir)))
+      if (g_str_has_prefix (name, uuid))
+        {
+          gchar *path;
+
+          path = g_build_filename (dir_path, name, NULL);
+          g_unlink (path);
+          g_free (path);
+        }
+  if (dir)
+    g_dir_close (dir);
+  free (uuid);
+  g_free (dir_path);
+}
+
+/**
+ * @brief Get the maximum size of the render cache.
+ *
+ * @return Size in MiB, 0 when renders are not cached.
+ */
+int
+get_report_render_cache_size ()
+{
+  return report_render_cache_size;
+}
+
+/**
+ * @brief Set the maximum size of the render cache.
+ *
+ * @param[in]  new_size  Size in MiB, 0 to disable the cache.
+ */
+void
+set_report_render_cache_size (int new_size)
+{
+  if (new_size < 0)
+    report_render_cache_size = 0;
+  else
+    report_render_cache_size = new_size;
+}
+
 /**
  * @brief Generate a report.
  *
@@ -28445,7 +32399,7 @@ manage_send_report (report_t report, report_t delta_report,
   char xml_dir[] = "/tmp/gvmd_XXXXXX";
   int ret;
   GList *used_rfps;
-  gchar *output_file;
+  gchar *output_file, *report_format_id, *cache_file;
   char chunk[MANAGE_SEND_REPORT_CHUNK_SIZE + 1];
   FILE *stream;
 
@@ -28483,10 +32437,17 @@ manage_send_report (report_t report, report_t delta_report,
       return 0;
     }
 
+  /* Stream the report if there is no report format to apply. */
+
+  if (report_format <= 0)
+    return manage_stream_report (report, delta_report, task, get,
+                                 notes_details, overrides_details,
+                                 result_tags, ignore_pagination, lean, base64,
+                                 send, send_data_1, send_data_2, prefix);
+
   /* Print the report as XML to a file. */
 
-  if ((report_format > 0)
-      && (report_format_predefined (report_format) == 0)
+  if ((report_format_predefined (report_format) == 0)
       && (report_format_trust (report_format) != TRUST_YES))
     return -1;
 
@@ -28496,40 +32457,54 @@ manage_send_report (report_t report, report_t delta_report,
       return -1;
     }
 
-  xml_start = g_strdup_printf ("%s/report-start.xml", xml_dir);
-  ret = print_report_xml_start (report, delta_report, task, xml_start, get,
-                                notes_details, overrides_details, result_tags,
-                                ignore_pagination, lean, NULL, NULL, NULL);
-  if (ret)
+  /* Use an earlier render of the same report if there is one. */
+
+  cache_file = delta_report
+                ? NULL
+                : report_render_cache_file (report, report_format, get,
+                                            notes_details, overrides_details,
+                                            result_tags, ignore_pagination,
+                                            lean);
+  if (cache_file && g_file_test (cache_file, G_FILE_TEST_IS_REGULAR))
     {
-      g_free (xml_start);
-      gvm_file_remove_recurse (xml_dir);
-      if (ret == 2)
-        return 2;
-      return -1;
+      g_debug ("%s: sending cached render %s", __func__, cache_file);
+      g_utime (cache_file, NULL);
+      output_file = cache_file;
     }
+  else
+    {
+      xml_start = g_strdup_printf ("%s/report-start.xml", xml_dir);
+      ret = print_report_xml_start (report, delta_report, task, xml_start,
+                                    get, notes_details, overrides_details,
+                                    result_tags, ignore_pagination, lean, NULL,
+                                    NULL, NULL);
+      if (ret)
+        {
+          g_free (xml_start);
+          g_free (cache_file);
+          gvm_file_remove_recurse (xml_dir);
+          if (ret == 2)
+            return 2;
+          return -1;
+        }
 
-  xml_file = g_strdup_printf ("%s/report.xml", xml_dir);
+      xml_file = g_strdup_printf ("%s/report.xml", xml_dir);
 
-  if (report_format > 0)
-    {
       /* Apply report format(s). */
-      gchar* report_format_id = report_format_uuid (report_format);
 
+      report_format_id = report_format_uuid (report_format);
       output_file = apply_report_format (report_format_id,
                                          xml_start, xml_file, xml_dir,
                                          &used_rfps);
       g_free (report_format_id);
-    }
-  else
-    {
-      print_report_xml_end(xml_start, xml_file, -1);
-      output_file = g_strdup(xml_file);
-    }
 
-  if (output_file == NULL)
-    {
-      g_warning ("%s: No file returned for report format", __func__);
+      if (output_file == NULL)
+        {
+          g_warning ("%s: No file returned for report format", __func__);
+        }
+      else if (cache_file)
+        report_render_cache_store (output_file, cache_file);
+      g_free (cache_file);
     }
 
   /* Send the report. */
@@ -28681,171 +32656,681 @@ report_host_noticeable (report_t report, const gchar *host)
 }
 
 /**
- * @brief Parse an OSP report.
+ * @brief Get the number of OSP results inserted per statement.
  *
- * @param[in]  task        Task.
- * @param[in]  report      Report.
- * @param[in]  report_xml  Report XML.
+ * @return The batch size, 0 when results are inserted individually.
+ */
+int
+get_osp_result_batch_size ()
+{
+  return osp_result_batch_size;
+}
+
+/**
+ * @brief Set the number of OSP results inserted per statement.
+ *
+ * @param[in]  new_size  The new batch size, 0 to insert results individually.
  */
 void
-parse_osp_report (task_t task, report_t report, const char *report_xml)
+set_osp_result_batch_size (int new_size)
 {
-  entity_t entity, child;
-  entities_t results;
-  const char *str;
-  char *defs_file = NULL;
-  time_t start_time, end_time;
-  gboolean has_results = FALSE;
+  if (new_size < 0)
+    osp_result_batch_size = 0;
+  else
+    osp_result_batch_size = new_size;
+}
 
-  assert (task);
-  assert (report);
-  assert (report_xml);
+/**
+ * @brief Get the number of worker processes that render report hosts.
+ *
+ * @return The number of workers, 0 to render hosts in the GMP process.
+ */
+int
+get_report_host_workers ()
+{
+  return report_host_workers;
+}
+
+/**
+ * @brief Set the number of worker processes that render report hosts.
+ *
+ * @param[in]  new_workers  The new number of workers, 0 to render hosts in
+ *                          the GMP process.
+ */
+void
+set_report_host_workers (int new_workers)
+{
+  if (new_workers < 0)
+    report_host_workers = 0;
+  else if (new_workers > REPORT_HOST_WORKERS_MAX)
+    report_host_workers = REPORT_HOST_WORKERS_MAX;
+  else
+    report_host_workers = new_workers;
+}
+
+/**
+ * @brief Get the number of worker processes that run batched GMP commands.
+ *
+ * @return The number of workers, 0 to run the commands in the GMP process.
+ */
+int
+get_gmp_batch_workers ()
+{
+  return gmp_batch_workers;
+}
+
+/**
+ * @brief Set the number of worker processes that run batched GMP commands.
+ *
+ * @param[in]  new_workers  The new number of workers, 0 to run the commands
+ *                          in the GMP process.
+ */
+void
+set_gmp_batch_workers (int new_workers)
+{
+  if (new_workers < 0)
+    gmp_batch_workers = 0;
+  else if (new_workers > GMP_BATCH_WORKERS_MAX)
+    gmp_batch_workers = GMP_BATCH_WORKERS_MAX;
+  else
+    gmp_batch_workers = new_workers;
+}
+
+/**
+ * @brief Get the number of worker processes that rebuild the report cache.
+ *
+ * @return The number of workers, 0 to rebuild in the calling process.
+ */
+int
+get_report_cache_workers ()
+{
+  return report_cache_workers;
+}
+
+/**
+ * @brief Set the number of worker processes that rebuild the report cache.
+ *
+ * @param[in]  new_workers  The new number of workers, 0 to rebuild in the
+ *                          calling process.
+ */
+void
+set_report_cache_workers (int new_workers)
+{
+  if (new_workers < 0)
+    report_cache_workers = 0;
+  else if (new_workers > REPORT_CACHE_WORKERS_MAX)
+    report_cache_workers = REPORT_CACHE_WORKERS_MAX;
+  else
+    report_cache_workers = new_workers;
+}
+
+/**
+ * @brief Get the chunk size for the deferred deletion of reports.
+ *
+ * @return Rows per table and schedule period, 0 to delete immediately.
+ */
+int
+get_report_deletion_chunk ()
+{
+  return report_deletion_chunk;
+}
+
+/**
+ * @brief Set the chunk size for the deferred deletion of reports.
+ *
+ * @param[in]  new_chunk  Rows per table and schedule period, 0 to delete
+ *                        reports immediately.
+ */
+void
+set_report_deletion_chunk (int new_chunk)
+{
+  if (new_chunk < 0)
+    report_deletion_chunk = 0;
+  else
+    report_deletion_chunk = new_chunk;
+}
+
+/**
+ * @brief A batch of OSP results waiting to be inserted into a report.
+ */
+typedef struct
+{
+  task_t task;            ///< Task of the results.
+  report_t report;        ///< Report of the results.
+  user_t owner;           ///< Owner of the report.
+  GString *insert;        ///< VALUES of the multi-row results INSERT.
+  GString *nvts;          ///< Quoted distinct NVTs of the batch, as a list.
+  GHashTable *nvts_seen;  ///< Distinct NVTs of the batch.
+  int count;              ///< Number of results in the batch.
+  int size;               ///< Number of results at which to flush.
+} osp_result_batch_t;
+
+/**
+ * @brief Initialise an OSP result batch.
+ *
+ * @param[in]  batch   Batch.
+ * @param[in]  task    Task of the results.
+ * @param[in]  report  Report to add the results to.
+ * @param[in]  size    Number of results at which to flush.
+ */
+static void
+osp_result_batch_init (osp_result_batch_t *batch, task_t task,
+                       report_t report, int size)
+{
+  batch->task = task;
+  batch->report = report;
+  batch->owner = 0;
+  sql_int64 (&batch->owner,
+             "SELECT owner FROM reports WHERE id = %llu;",
+             report);
+  batch->insert = g_string_new ("");
+  batch->nvts = g_string_new ("");
+  batch->nvts_seen = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            g_free, NULL);
+  batch->count = 0;
+  batch->size = size;
+}
 
-  if (parse_entity (report_xml, &entity))
+/**
+ * @brief Insert all results of an OSP result batch.
+ *
+ * The result_nvts and result_nvt_reports rows for the whole batch are
+ * inserted with one statement each, and the counts of the batch are added
+ * to the report counts cache.
+ *
+ * @param[in]  batch  Batch.
+ */
+static void
+osp_result_batch_flush (osp_result_batch_t *batch)
+{
+  result_t last;
+
+  if (batch->count == 0)
+    return;
+
+  /* Only this process adds results to the report, so the results of the
+   * report after this one are the batch. */
+  last = 0;
+  sql_int64 (&last, "SELECT coalesce (max (id), 0) FROM results;");
+
+  sql ("INSERT INTO result_nvts (nvt)"
+       " SELECT unnest (ARRAY[%s])"
+       " ON CONFLICT DO NOTHING;",
+       batch->nvts->str);
+
+  sql ("INSERT INTO results"
+       " (owner, date, task, host, hostname, port, nvt,"
+       "  nvt_version, severity, type, qod, qod_type, description,"
+       "  path, uuid, result_nvt, report)"
+       " VALUES %s;",
+       batch->insert->str);
+
+  sql ("INSERT INTO result_nvt_reports (result_nvt, report)"
+       " SELECT id, %llu FROM result_nvts"
+       " WHERE nvt IN (%s)"
+       " AND NOT EXISTS (SELECT * FROM result_nvt_reports"
+       "                 WHERE result_nvt = result_nvts.id"
+       "                 AND report = %llu);",
+       batch->report,
+       batch->nvts->str,
+       batch->report);
+
+  report_add_counts_for_results (batch->report, last,
+                                 sql_int ("SELECT EXISTS"
+                                          " (SELECT * FROM overrides"
+                                          "  WHERE nvt IN (%s));",
+                                          batch->nvts->str));
+
+  g_string_truncate (batch->insert, 0);
+  g_string_truncate (batch->nvts, 0);
+  g_hash_table_remove_all (batch->nvts_seen);
+  batch->count = 0;
+}
+
+/**
+ * @brief Add an OSP result to a batch, flushing the batch when it is full.
+ *
+ * Takes the same arguments as \ref make_osp_result.
+ *
+ * @param[in]  batch        Batch.
+ * @param[in]  host         Target host of result.
+ * @param[in]  hostname     Hostname of the result.
+ * @param[in]  nvt          A title for the result.
+ * @param[in]  type         Type of result.  "Alarm", etc.
+ * @param[in]  description  Description of the result.
+ * @param[in]  port         Result port.
+ * @param[in]  severity     Result severity.
+ * @param[in]  qod          Quality of detection.
+ * @param[in]  path         Result path, e.g. file location of a product.
+ */
+static void
+osp_result_batch_add (osp_result_batch_t *batch, const char *host,
+                      const char *hostname, const char *nvt,
+                      const char *type, const char *description,
+                      const char *port, const char *severity, int qod,
+                      const char *path)
+{
+  gchar *quoted_desc, *quoted_nvt, *quoted_port, *quoted_hostname;
+  gchar *quoted_path, *quoted_host, *quoted_type, *result_severity;
+  gchar *nvt_revision;
+
+  assert (type);
+
+  result_severity = osp_result_severity (nvt, type, severity);
+  if (result_severity == NULL)
+    return;
+
+  quoted_desc = sql_quote (description ?: "");
+  quoted_nvt = sql_quote (nvt ?: "");
+  quoted_port = sql_quote (port ?: "");
+  quoted_host = sql_quote (host ?: "");
+  quoted_hostname = sql_quote (hostname ?: "");
+  quoted_path = sql_quote (path ?: "");
+  quoted_type = sql_quote (type);
+
+  if (nvt
+      && (g_str_has_prefix (nvt, "1.3.6.1.4.1.25623.")
+          || g_str_has_prefix (nvt, "CVE-")))
+    nvt_revision = sql_quote (result_nvt_info (nvt)->modification_time ?: "");
+  else
+    nvt_revision = g_strdup ("");
+
+  if (g_hash_table_contains (batch->nvts_seen, quoted_nvt) == FALSE)
+    {
+      g_string_append_printf (batch->nvts, "%s'%s'",
+                              batch->nvts->len ? ", " : "",
+                              quoted_nvt);
+      g_hash_table_add (batch->nvts_seen, g_strdup (quoted_nvt));
+    }
+
+  g_string_append_printf (batch->insert,
+                          "%s (%llu, m_now (), %llu, '%s', '%s', '%s', '%s',"
+                          "  '%s', '%s', '%s', %d, '', '%s',"
+                          "  '%s', make_uuid (),"
+                          "  (SELECT id FROM result_nvts WHERE nvt = '%s'),"
+                          "  %llu)",
+                          batch->count ? "," : "",
+                          batch->owner,
+                          batch->task,
+                          quoted_host,
+                          quoted_hostname,
+                          quoted_port,
+                          quoted_nvt,
+                          nvt_revision,
+                          result_severity,
+                          quoted_type,
+                          qod,
+                          quoted_desc,
+                          quoted_path,
+                          quoted_nvt,
+                          batch->report);
+  batch->count++;
+
+  g_free (result_severity);
+  g_free (nvt_revision);
+  g_free (quoted_desc);
+  g_free (quoted_nvt);
+  g_free (quoted_port);
+  g_free (quoted_host);
+  g_free (quoted_hostname);
+  g_free (quoted_path);
+  g_free (quoted_type);
+
+  if (batch->count >= batch->size)
     {
-      g_warning ("Couldn't parse %s OSP scan report", report_xml);
+      osp_result_batch_flush (batch);
+      /* Give other processes a chance at the report. */
+      sql_commit ();
+      sql_begin_immediate ();
+    }
+}
+
+/**
+ * @brief Free an OSP result batch, inserting any remaining results.
+ *
+ * @param[in]  batch  Batch.
+ */
+static void
+osp_result_batch_cleanup (osp_result_batch_t *batch)
+{
+  osp_result_batch_flush (batch);
+  g_string_free (batch->insert, TRUE);
+  g_string_free (batch->nvts, TRUE);
+  g_hash_table_destroy (batch->nvts_seen);
+}
+
+/**
+ * @brief State of the parser of an OSP report.
+ */
+typedef struct
+{
+  task_t task;                 ///< Task.
+  report_t report;             ///< Report.
+  time_t start_time;           ///< Scan start time, from the scan element.
+  time_t end_time;             ///< Scan end time, from the scan element.
+  int depth;                   ///< Element depth, 1 inside the scan element.
+  gboolean results_seen;       ///< Whether the results element was seen.
+  gboolean has_results;        ///< Whether there were any results.
+  int result_count;            ///< Number of result elements.
+  gboolean in_result;          ///< Whether inside a result element.
+  GHashTable *attributes;      ///< Attributes of the current result.
+  GString *text;               ///< Text of the current result.
+  int batched;                 ///< Whether results are batched.
+  osp_result_batch_t batch;    ///< Batch of results, if batched.
+  GPtrArray *host_ends;        ///< Hosts that ended, to add to assets.
+} osp_report_parser_t;
+
+/**
+ * @brief Add a result from an OSP report to the report.
+ *
+ * @param[in]  parser  OSP report parser.
+ */
+static void
+osp_report_parser_add_result (osp_report_parser_t *parser)
+{
+  task_t task;
+  report_t report;
+  result_t result;
+  const char *type, *name, *severity, *host, *hostname, *test_id, *port;
+  const char *qod, *path;
+  char *desc = NULL, *nvt_id = NULL, *severity_str = NULL;
+  int qod_int;
+
+  task = parser->task;
+  report = parser->report;
+
+  type = g_hash_table_lookup (parser->attributes, "type");
+  name = g_hash_table_lookup (parser->attributes, "name");
+  severity = g_hash_table_lookup (parser->attributes, "severity");
+  test_id = g_hash_table_lookup (parser->attributes, "test_id");
+  host = g_hash_table_lookup (parser->attributes, "host");
+  hostname = g_hash_table_lookup (parser->attributes, "hostname");
+  port = g_hash_table_lookup (parser->attributes, "port") ?: "";
+  qod = g_hash_table_lookup (parser->attributes, "qod") ?: "";
+  path = g_hash_table_lookup (parser->attributes, "uri") ?: "";
+
+  if (!name || !type || !severity || !test_id || !host)
+    {
+      g_warning ("Erroneous attribute in OSP result (name %s, type %s,"
+                 " severity %s, test_id %s, host %s)",
+                 name ?: "missing", type ?: "missing",
+                 severity ?: "missing", test_id ?: "missing",
+                 host ?: "missing");
       return;
     }
 
-  sql_begin_immediate ();
-  /* Set the report's start and end times. */
-  start_time = 0;
-  str = entity_attribute (entity, "start_time");
-  if (str)
+  /* Add report host if it doesn't exist. */
+  manage_report_host_add (report, host, parser->start_time,
+                          parser->end_time);
+  if (!strcmp (type, "Host Detail"))
     {
-      start_time = atoi (str);
-      set_scan_start_time_epoch (report, start_time);
+      insert_report_host_detail (report, host, "osp", "", "OSP Host Detail",
+                                 name, parser->text->str);
+      return;
     }
-
-  end_time = 0;
-  str = entity_attribute (entity, "end_time");
-  if (str)
+  else if (g_str_has_prefix (test_id, "1.3.6.1.4.1.25623.1."))
     {
-      end_time = atoi (str);
-      set_scan_end_time_epoch (report, end_time);
+      nvt_id = g_strdup (test_id);
+      severity_str = nvt_severity (test_id, type);
+      desc = g_strdup (parser->text->str);
+    }
+  else
+    {
+      nvt_id = g_strdup (name);
+      desc = g_strdup (parser->text->str);
     }
 
-  /* Insert results. */
-  child = entity_child (entity, "results");
-  if (!child)
+  qod_int = atoi (qod);
+  if (qod_int <= 0 || qod_int > 100)
+    qod_int = QOD_DEFAULT;
+  if (port && strcmp (port, "general/Host_Details") == 0)
     {
-      g_warning ("Missing results element in OSP report %s", report_xml);
-      goto end_parse_osp_report;
+      /* TODO: This should probably be handled by the "Host Detail"
+       *        result type with extra source info in OSP.
+       */
+      if (manage_report_host_detail (report, host, desc))
+        g_warning ("%s: Failed to add report detail for host '%s': %s",
+                  __func__,
+                  host,
+                  desc);
+    }
+  else if (host && nvt_id && desc && (strcmp (nvt_id, "HOST_START") == 0))
+    {
+      set_scan_host_start_time_ctime (report, host, desc);
+    }
+  else if (host && nvt_id && desc && (strcmp (nvt_id, "HOST_END") == 0))
+    {
+      /* Assets are created from the results of the host, once all
+       * results of the report are in. */
+      set_scan_host_end_time_ctime (report, host, desc);
+      g_ptr_array_add (parser->host_ends, g_strdup (host));
+    }
+  else if (parser->batched)
+    osp_result_batch_add (&parser->batch,
+                          host,
+                          hostname,
+                          nvt_id,
+                          type,
+                          desc,
+                          port ?: "",
+                          severity_str ?: severity,
+                          qod_int,
+                          path);
+  else
+    {
+      result = make_osp_result (task,
+                                host,
+                                hostname,
+                                nvt_id,
+                                type,
+                                desc,
+                                port ?: "",
+                                severity_str ?: severity,
+                                qod_int,
+                                path);
+      report_add_result (report, result);
     }
-  results = child->entities;
-  if (results)
-    has_results = TRUE;
+  g_free (nvt_id);
+  g_free (desc);
+  g_free (severity_str);
+}
 
-  defs_file = task_definitions_file (task);
-  while (results)
+/**
+ * @brief Handle the start of an element in an OSP report.
+ *
+ * @param[in]  context           Parser context.
+ * @param[in]  element_name      XML element name.
+ * @param[in]  attribute_names   XML attribute names.
+ * @param[in]  attribute_values  XML attribute values.
+ * @param[in]  user_data         OSP report parser.
+ * @param[in]  error             Error parameter.
+ */
+static void
+osp_report_handle_start_element (/* unused */ GMarkupParseContext *context,
+                                 const gchar *element_name,
+                                 const gchar **attribute_names,
+                                 const gchar **attribute_values,
+                                 gpointer user_data,
+                                 /* unused */ GError **error)
+{
+  osp_report_parser_t *parser = (osp_report_parser_t*) user_data;
+
+  parser->depth++;
+
+  if (parser->depth == 1)
     {
-      result_t result;
-      const char *type, *name, *severity, *host, *hostname, *test_id, *port;
-      const char *qod, *path;
-      char *desc = NULL, *nvt_id = NULL, *severity_str = NULL;
-      entity_t r_entity = results->data;
-      int qod_int;
+      /* The scan element.  Set the report's start and end times. */
+      const gchar **name, **value;
 
-      if (strcmp (entity_name (r_entity), "result"))
+      for (name = attribute_names, value = attribute_values;
+           *name;
+           name++, value++)
+        if (strcmp (*name, "start_time") == 0)
+          {
+            parser->start_time = atoi (*value);
+            set_scan_start_time_epoch (parser->report, parser->start_time);
+          }
+        else if (strcmp (*name, "end_time") == 0)
+          {
+            parser->end_time = atoi (*value);
+            set_scan_end_time_epoch (parser->report, parser->end_time);
+          }
+    }
+  else if (parser->depth == 2 && strcmp (element_name, "results") == 0)
+    parser->results_seen = TRUE;
+  else if (parser->depth == 3 && parser->results_seen)
+    {
+      if (strcmp (element_name, "result"))
         {
-          g_warning ("Erroneous entry in OSP results %s",
-                     entity_name (r_entity));
-          results = next_entities (results);
-          continue;
+          g_warning ("Erroneous entry in OSP results %s", element_name);
+          return;
         }
-      type = entity_attribute (r_entity, "type");
-      name = entity_attribute (r_entity, "name");
-      severity = entity_attribute (r_entity, "severity");
-      test_id = entity_attribute (r_entity, "test_id");
-      host = entity_attribute (r_entity, "host");
-      hostname = entity_attribute (r_entity, "hostname");
-      port = entity_attribute (r_entity, "port") ?: "";
-      qod = entity_attribute (r_entity, "qod") ?: "";
-      path = entity_attribute (r_entity, "uri") ?: "";
 
-      if (!name || !type || !severity || !test_id || !host)
-        {
-          GString *string = g_string_new ("");
+      parser->has_results = TRUE;
+      parser->result_count++;
+      parser->in_result = TRUE;
+      while (*attribute_names)
+        g_hash_table_insert (parser->attributes,
+                             g_strdup (*attribute_names++),
+                             g_strdup (*attribute_values++));
+    }
+}
 
-          print_entity_to_string (r_entity, string);
-          g_warning ("Erroneous attribute in OSP result %s", string->str);
-          g_string_free (string, TRUE);
-          results = next_entities (results);
-          continue;
-        }
+/**
+ * @brief Handle the end of an element in an OSP report.
+ *
+ * The result is added to the report as soon as its element ends, so that
+ * only one result is held in memory at a time.
+ *
+ * @param[in]  context           Parser context.
+ * @param[in]  element_name      XML element name.
+ * @param[in]  user_data         OSP report parser.
+ * @param[in]  error             Error parameter.
+ */
+static void
+osp_report_handle_end_element (/* unused */ GMarkupParseContext *context,
+                               /* unused */ const gchar *element_name,
+                               gpointer user_data,
+                               /* unused */ GError **error)
+{
+  osp_report_parser_t *parser = (osp_report_parser_t*) user_data;
 
-      /* Add report host if it doesn't exist. */
-      manage_report_host_add (report, host, start_time, end_time);
-      if (!strcmp (type, "Host Detail"))
-        {
-          insert_report_host_detail (report, host, "osp", "", "OSP Host Detail",
-                                     name, entity_text (r_entity));
-          results = next_entities (results);
-          continue;
-        }
-      else if (g_str_has_prefix (test_id, "1.3.6.1.4.1.25623.1."))
-        {
-          nvt_id = g_strdup (test_id);
-          severity_str = nvt_severity (test_id, type);
-          desc = g_strdup (entity_text (r_entity));
-        }
-      else
-        {
-          nvt_id = g_strdup (name);
-          desc = g_strdup (entity_text (r_entity));
-        }
+  if (parser->depth == 3 && parser->in_result)
+    {
+      osp_report_parser_add_result (parser);
+      g_hash_table_remove_all (parser->attributes);
+      g_string_truncate (parser->text, 0);
+      parser->in_result = FALSE;
+    }
+  parser->depth--;
+}
+
+/**
+ * @brief Handle text in an OSP report.
+ *
+ * @param[in]  context           Parser context.
+ * @param[in]  text              The text.
+ * @param[in]  text_len          Length of the text.
+ * @param[in]  user_data         OSP report parser.
+ * @param[in]  error             Error parameter.
+ */
+static void
+osp_report_handle_text (/* unused */ GMarkupParseContext *context,
+                        const gchar *text,
+                        gsize text_len,
+                        gpointer user_data,
+                        /* unused */ GError **error)
+{
+  osp_report_parser_t *parser = (osp_report_parser_t*) user_data;
+
+  if (parser->depth == 3 && parser->in_result)
+    g_string_append_len (parser->text, text, text_len);
+}
+
+/**
+ * @brief Parse an OSP report.
+ *
+ * The report is parsed incrementally, adding each result as soon as it
+ * has been read, instead of building an entity tree of the whole report.
+ *
+ * When the OSP result batch size is greater than 0, results are collected
+ * and inserted with multi-row INSERTs instead of one by one.
+ *
+ * @param[in]  task        Task.
+ * @param[in]  report      Report.
+ * @param[in]  report_xml  Report XML.
+ *
+ * @return Number of result elements in the report.
+ */
+int
+parse_osp_report (task_t task, report_t report, const char *report_xml)
+{
+  GMarkupParser xml_parser;
+  GMarkupParseContext *xml_context;
+  osp_report_parser_t parser;
+  GError *error;
+  int own_host_cache;
+
+  assert (task);
+  assert (report);
+  assert (report_xml);
+
+  memset (&xml_parser, 0, sizeof (xml_parser));
+  xml_parser.start_element = osp_report_handle_start_element;
+  xml_parser.end_element = osp_report_handle_end_element;
+  xml_parser.text = osp_report_handle_text;
+
+  memset (&parser, 0, sizeof (parser));
+  parser.task = task;
+  parser.report = report;
+  parser.attributes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, g_free);
+  parser.text = g_string_new ("");
+  parser.batched = osp_result_batch_size > 0;
+  parser.host_ends = g_ptr_array_new_with_free_func (g_free);
+
+  /* The caller may keep the cache across several reports of a scan. */
+  own_host_cache = report_host_cache_active (report) == 0;
+  if (own_host_cache)
+    report_host_cache_init (report);
+
+  sql_begin_immediate ();
+  if (parser.batched)
+    osp_result_batch_init (&parser.batch, task, report,
+                           osp_result_batch_size);
+
+  error = NULL;
+  xml_context = g_markup_parse_context_new (&xml_parser, 0, &parser, NULL);
+  if (g_markup_parse_context_parse (xml_context, report_xml, -1, &error) == 0
+      || g_markup_parse_context_end_parse (xml_context, &error) == 0)
+    {
+      g_warning ("Couldn't parse OSP scan report: %s",
+                 error ? error->message : "unknown error");
+      g_clear_error (&error);
+    }
+  else if (parser.results_seen == FALSE)
+    g_warning ("Missing results element in OSP report %s", report_xml);
+  g_markup_parse_context_free (xml_context);
+
+  if (parser.batched)
+    osp_result_batch_cleanup (&parser.batch);
+
+  add_assets_from_hosts_in_report (report, parser.host_ends);
+  g_ptr_array_free (parser.host_ends, TRUE);
+
+  if (parser.has_results)
+    sql ("UPDATE reports SET modification_time = m_now() WHERE id = %llu;",
+         report);
+
+  report_ingest_checkpoint (report, parser.result_count);
 
-      qod_int = atoi (qod);
-      if (qod_int <= 0 || qod_int > 100)
-        qod_int = QOD_DEFAULT;
-      if (port && strcmp (port, "general/Host_Details") == 0)
-        {
-          /* TODO: This should probably be handled by the "Host Detail"
-           *        result type with extra source info in OSP.
-           */
-          if (manage_report_host_detail (report, host, desc))
-            g_warning ("%s: Failed to add report detail for host '%s': %s",
-                      __func__,
-                      host,
-                      desc);
-        }
-      else if (host && nvt_id && desc && (strcmp (nvt_id, "HOST_START") == 0))
-        {
-          set_scan_host_start_time_ctime (report, host, desc);
-        }
-      else if (host && nvt_id && desc && (strcmp (nvt_id, "HOST_END") == 0))
-        {
-          set_scan_host_end_time_ctime (report, host, desc);
-          add_assets_from_host_in_report (report, host);
-        }
-      else
-        {
-          result = make_osp_result (task,
-                                    host,
-                                    hostname,
-                                    nvt_id,
-                                    type,
-                                    desc,
-                                    port ?: "",
-                                    severity_str ?: severity,
-                                    qod_int,
-                                    path);
-          report_add_result (report, result);
-        }
-      g_free (nvt_id);
-      g_free (desc);
-      g_free (severity_str);
-      results = next_entities (results);
-    }
-
-  if (has_results)
-    sql ("UPDATE reports SET modification_time = m_now() WHERE id = %llu;", 
-	 report);
-
- end_parse_osp_report:
   sql_commit ();
-  g_free (defs_file);
-  free_entity (entity);
+  metrics_add (METRIC_RESULTS_INGESTED, parser.result_count);
+  if (own_host_cache)
+    report_host_cache_free ();
+  g_hash_table_destroy (parser.attributes);
+  g_string_free (parser.text, TRUE);
+  return parser.result_count;
 }
 
 
@@ -30295,6 +34780,159 @@ manage_transaction_stop (gboolean force_commit)
     }
 }
 
+/**
+ * @brief Set the time above which SQL statements are logged as slow.
+ *
+ * @param[in]  threshold  Threshold in milliseconds, 0 to disable.
+ */
+void
+set_slow_query_threshold (int threshold)
+{
+  sql_set_slow_query_threshold (threshold);
+}
+
+/**
+ * @brief Reset the count and time of the SQL statements of the process.
+ */
+void
+manage_sql_stats_reset ()
+{
+  sql_stats_reset ();
+}
+
+/**
+ * @brief Get the count and time of the SQL statements since the last reset.
+ *
+ * @param[out]  count  Number of statements.
+ * @param[out]  time   Time spent in the statements, in microseconds.
+ */
+void
+manage_sql_stats (int *count, gint64 *time)
+{
+  sql_stats (count, time);
+}
+
+/**
+ * @brief Add to the count and time of the SQL statements of the process.
+ *
+ * @param[in]  count  Number of statements.
+ * @param[in]  time   Time spent in the statements, in microseconds.
+ */
+void
+manage_sql_stats_add (int count, gint64 time)
+{
+  sql_stats_add (count, time);
+}
+
+/**
+ * @brief Set the read replica for read-only GMP commands.
+ *
+ * @param[in]  host     Host or socket directory of the replica, NULL for none.
+ * @param[in]  port     Port or socket extension of the replica.
+ * @param[in]  max_lag  Replication lag in seconds up to which the replica
+ *                      is used.
+ */
+void
+set_db_replica (const gchar *host, const gchar *port, int max_lag)
+{
+  sql_set_replica (host, port, max_lag);
+}
+
+/**
+ * @brief Run the SQL of the current command on the read replica, if possible.
+ *
+ * Transactions and writes still go to the primary.
+ */
+void
+manage_use_replica ()
+{
+  sql_use_replica ();
+}
+
+/**
+ * @brief Run SQL on the primary database.
+ */
+void
+manage_use_primary ()
+{
+  sql_use_primary ();
+}
+
+/**
+ * @brief Set whether the database is reached through a transaction pooler.
+ *
+ * @param[in]  pooling  Whether a pooler like PgBouncer in transaction mode
+ *                      sits between gvmd and PostgreSQL.
+ */
+void
+set_db_transaction_pooling (int pooling)
+{
+  sql_set_transaction_pooling (pooling);
+}
+
+/**
+ * @brief Write the metrics of the manager to a file.
+ *
+ * Writes the shared metrics of the gvmd processes and gauges taken from
+ * the database, in the Prometheus text exposition format.  The file is
+ * replaced atomically, so that it can be read by a textfile collector at
+ * any time.
+ *
+ * @param[in]  path  Path of file.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+manage_metrics_write (const gchar *path)
+{
+  GString *buffer;
+  GError *error;
+  int ret;
+
+  buffer = g_string_new ("");
+  metrics_append_text (buffer);
+
+  g_string_append_printf
+   (buffer,
+    "# HELP gvmd_scans_active Tasks with an active scan.\n"
+    "# TYPE gvmd_scans_active gauge\n"
+    "gvmd_scans_active %i\n",
+    sql_int ("SELECT count (*) FROM tasks"
+             " WHERE run_status IN (%u, %u, %u, %u, %u);",
+             TASK_STATUS_REQUESTED,
+             TASK_STATUS_QUEUED,
+             TASK_STATUS_RUNNING,
+             TASK_STATUS_STOP_REQUESTED,
+             TASK_STATUS_STOP_WAITING));
+
+  g_string_append_printf
+   (buffer,
+    "# HELP gvmd_alert_queue_depth Alerts waiting in the alert queue.\n"
+    "# TYPE gvmd_alert_queue_depth gauge\n"
+    "gvmd_alert_queue_depth %i\n",
+    sql_int ("SELECT count (*) FROM alert_queue;"));
+
+  g_string_append_printf
+   (buffer,
+    "# HELP gvmd_db_connections Connections to the gvmd database.\n"
+    "# TYPE gvmd_db_connections gauge\n"
+    "gvmd_db_connections %i\n",
+    sql_int ("SELECT count (*) FROM pg_stat_activity"
+             " WHERE datname = current_database ();"));
+
+  error = NULL;
+  ret = 0;
+  if (g_file_set_contents (path, buffer->str, buffer->len, &error) == FALSE)
+    {
+      g_warning ("%s: failed to write %s: %s",
+                 __func__, path, error->message);
+      g_error_free (error);
+      ret = -1;
+    }
+  g_string_free (buffer, TRUE);
+  return ret;
+}
+
 /**
  * @brief Validate a single port.
  *
@@ -32376,51 +37014,33 @@ target_port_list (target_t target)
 char*
 target_port_range (target_t target)
 {
-  GString *range;
-  iterator_t ranges;
-  range = g_string_new ("");
-  init_port_range_iterator (&ranges, target_port_list (target), 0, 1,
+  array_t *ranges;
+  iterator_t port_ranges;
+  gchar *string;
+
+  ranges = make_array ();
+  init_port_range_iterator (&port_ranges, target_port_list (target), 0, 1,
                             "type, CAST (start AS INTEGER)");
-  if (next (&ranges))
+  while (next (&port_ranges))
     {
-      const char *start, *end;
-      int type;
-
-      start = port_range_iterator_start (&ranges);
-      end = port_range_iterator_end (&ranges);
-      type = port_range_iterator_type_int (&ranges);
+      range_t *range;
+      const char *end;
 
-      /* Scanner can only handle: T:1-3,5-6,9,U:1-2 */
-
-      if (end && strcmp (end, "0") && strcmp (end, start))
-        g_string_append_printf (range, "%s%s-%s",
-                                (type == PORT_PROTOCOL_UDP ? "U:" : "T:"),
-                                start, end);
-      else
-        g_string_append_printf (range, "%s%s",
-                                (type == PORT_PROTOCOL_UDP ? "U:" : "T:"),
-                                start);
-      while (next (&ranges))
-        {
-          int tcp;
-
-          start = port_range_iterator_start (&ranges);
-          end = port_range_iterator_end (&ranges);
-          tcp = (type == PORT_PROTOCOL_TCP);
-          type = port_range_iterator_type_int (&ranges);
-
-          if (end && strcmp (end, "0") && strcmp (end, start))
-            g_string_append_printf (range, ",%s%s-%s",
-                                    (tcp && type == PORT_PROTOCOL_UDP ? "U:" : ""),
-                                    start, end);
-          else
-            g_string_append_printf (range, ",%s%s",
-                                    (tcp && type == PORT_PROTOCOL_UDP ? "U:" : ""),
-                                    start);
-        }
+      range = g_malloc0 (sizeof (range_t));
+      range->type = port_range_iterator_type_int (&port_ranges);
+      range->start = atoi (port_range_iterator_start (&port_ranges));
+      end = port_range_iterator_end (&port_ranges);
+      range->end = end ? atoi (end) : 0;
+      if (range->end == 0)
+        range->end = range->start;
+      array_add (ranges, range);
     }
-  cleanup_iterator (&ranges);
-  return g_string_free (range, FALSE);
+  cleanup_iterator (&port_ranges);
+
+  ranges_sort_merge (ranges);
+  string = ranges_scanner_string (ranges);
+  array_free (ranges);
+  return string;
 }
 
 /**
@@ -36771,6 +41391,40 @@ find_override_with_permission (const char* uuid, override_t* override,
                                         0);
 }
 
+/**
+ * @brief Add the effect of a new override to report count caches.
+ *
+ * @param[in]  override  Override.
+ * @param[in]  nvt       OID of overridden NVT.
+ */
+static void
+create_override_counts (override_t override, const char *nvt)
+{
+  GHashTable *reports;
+  gchar *override_id, *users_where;
+  int end_time;
+
+  override_uuid (override, &override_id);
+  users_where = acl_users_with_access_where ("override", override_id, NULL,
+                                             "id");
+  reports = reports_for_override (override);
+  reports_counts_lock (reports);
+
+  /* Move the caches from the counts without the override to the counts
+   * with the override, by briefly deactivating it. */
+  end_time = sql_int ("SELECT end_time FROM overrides WHERE id = %llu;",
+                      override);
+  sql ("UPDATE overrides SET end_time = 1 WHERE id = %llu;", override);
+  reports_counts_add_nvt (reports, nvt, -1, users_where);
+  sql ("UPDATE overrides SET end_time = %i WHERE id = %llu;",
+       end_time, override);
+  reports_counts_add_nvt (reports, nvt, 1, users_where);
+
+  g_hash_table_destroy (reports);
+  g_free (override_id);
+  g_free (users_where);
+}
+
 /**
  * @brief Create an override.
  *
@@ -36803,7 +41457,6 @@ create_override (const char* active, const char* nvt, const char* text,
   GHashTableIter reports_iter;
   report_t *reports_ptr;
   gchar *override_id, *users_where;
-  int auto_cache_rebuild;
   override_t new_override;
 
   if (acl_user_may ("create_override") == 0)
@@ -36934,25 +41587,40 @@ create_override (const char* active, const char* nvt, const char* text,
     *override = sql_last_insert_id ();
   new_override = sql_last_insert_id ();
 
-  override_uuid (new_override, &override_id);
-  users_where = acl_users_with_access_where ("override", override_id, NULL,
-                                             "id");
-
-  reports = reports_for_override (new_override);
-  reports_ptr = NULL;
-  g_hash_table_iter_init (&reports_iter, reports);
-  auto_cache_rebuild = setting_auto_cache_rebuild_int ();
-  while (g_hash_table_iter_next (&reports_iter,
-                                 ((gpointer*)&reports_ptr), NULL))
+  if (setting_auto_cache_rebuild_int ())
     {
-      if (auto_cache_rebuild)
-        report_cache_counts (*reports_ptr, 0, 1, users_where);
-      else
+      /* Update the caches in the background, so that the client gets a
+       * response without waiting for the counts. */
+      switch (fork_report_counts_update ())
+        {
+          case 0:
+            create_override_counts (new_override, nvt);
+            report_counts_update_exit ();
+            break;
+          case -1:
+            sql_begin_immediate ();
+            create_override_counts (new_override, nvt);
+            sql_commit ();
+            break;
+          default:
+            break;
+        }
+    }
+  else
+    {
+      override_uuid (new_override, &override_id);
+      users_where = acl_users_with_access_where ("override", override_id,
+                                                 NULL, "id");
+      reports = reports_for_override (new_override);
+      reports_ptr = NULL;
+      g_hash_table_iter_init (&reports_iter, reports);
+      while (g_hash_table_iter_next (&reports_iter,
+                                     ((gpointer*)&reports_ptr), NULL))
         report_clear_count_cache (*reports_ptr, 0, 1, users_where);
+      g_hash_table_destroy (reports);
+      g_free (override_id);
+      g_free (users_where);
     }
-  g_hash_table_destroy (reports);
-  g_free (override_id);
-  g_free (users_where);
 
   return 0;
 }
@@ -37006,7 +41674,7 @@ delete_override (const char *override_id, int ultimate)
   GHashTable *reports;
   GHashTableIter reports_iter;
   report_t *reports_ptr;
-  gchar *users_where;
+  gchar *users_where, *nvt;
   int auto_cache_rebuild;
 
   sql_begin_immediate ();
@@ -37057,6 +41725,18 @@ delete_override (const char *override_id, int ultimate)
   users_where = acl_users_with_access_where ("override", override_id, NULL,
                                              "id");
 
+  /* Take the counts of the override's NVT out of the caches, to add them
+   * back without the override below. */
+  auto_cache_rebuild = setting_auto_cache_rebuild_int ();
+  nvt = NULL;
+  if (auto_cache_rebuild)
+    {
+      reports_counts_lock (reports);
+      nvt = sql_string ("SELECT nvt FROM overrides WHERE id = %llu;",
+                        override);
+      reports_counts_add_nvt (reports, nvt, -1, users_where);
+    }
+
   if (ultimate == 0)
     {
       sql ("INSERT INTO overrides_trash"
@@ -37083,22 +41763,216 @@ delete_override (const char *override_id, int ultimate)
 
   sql ("DELETE FROM overrides WHERE id = %llu;", override);
 
-  g_hash_table_iter_init (&reports_iter, reports);
-  reports_ptr = NULL;
+  if (auto_cache_rebuild)
+    reports_counts_add_nvt (reports, nvt, 1, users_where);
+  else
+    {
+      g_hash_table_iter_init (&reports_iter, reports);
+      reports_ptr = NULL;
+      while (g_hash_table_iter_next (&reports_iter,
+                                     ((gpointer*)&reports_ptr), NULL))
+        report_clear_count_cache (*reports_ptr, 0, 1, users_where);
+    }
+  g_hash_table_destroy (reports);
+  g_free (users_where);
+  g_free (nvt);
+
+  sql_commit ();
+  return 0;
+}
+
+/**
+ * @brief Take the counts of an override's NVTs out of report count caches.
+ *
+ * Called before an override is modified.  The counts are added back by
+ * modify_override_counts_end once the override has been changed.
+ *
+ * @param[in]   override     Override.
+ * @param[in]   override_id  UUID of override.
+ * @param[in]   nvt          New NVT of override, or NULL if unchanged.
+ * @param[out]  old_nvt      Return for the current NVT of the override.
+ *
+ * @return Reports affected by the override before the change.
+ */
+static GHashTable *
+modify_override_counts_begin (override_t override, const char *override_id,
+                              const char *nvt, gchar **old_nvt)
+{
+  GHashTable *reports;
+  gchar *users_where;
+
+  reports = reports_for_override (override);
+  *old_nvt = sql_string ("SELECT nvt FROM overrides WHERE id = %llu;",
+                         override);
+
+  if (setting_auto_cache_rebuild_int () == 0)
+    return reports;
+
+  users_where = acl_users_with_access_where ("override", override_id, NULL,
+                                             "id");
+  reports_counts_add_nvt (reports, *old_nvt, -1, users_where);
+  if (nvt && *old_nvt && strcmp (nvt, *old_nvt))
+    reports_counts_add_nvt (reports, nvt, -1, users_where);
+  g_free (users_where);
+
+  return reports;
+}
+
+/**
+ * @brief Update report count caches after an override was modified.
+ *
+ * The reports that the override affected before the change get the counts
+ * taken out by modify_override_counts_begin added back.  Reports that are
+ * only affected after the change have their caches rebuilt or cleared.
+ *
+ * @param[in]  reports      Reports from modify_override_counts_begin.
+ * @param[in]  override     Override.
+ * @param[in]  override_id  UUID of override.
+ * @param[in]  nvt          New NVT of override, or NULL if unchanged.
+ * @param[in]  old_nvt      NVT of the override before the change.
+ */
+static void
+modify_override_counts_end (GHashTable *reports, override_t override,
+                            const char *override_id, const char *nvt,
+                            const gchar *old_nvt)
+{
+  GHashTable *new_reports;
+  GHashTableIter reports_iter;
+  report_t *reports_ptr;
+  gchar *users_where;
+  int auto_cache_rebuild;
+
+  users_where = acl_users_with_access_where ("override", override_id, NULL,
+                                             "id");
   auto_cache_rebuild = setting_auto_cache_rebuild_int ();
+
+  if (auto_cache_rebuild)
+    {
+      reports_counts_add_nvt (reports, old_nvt, 1, users_where);
+      if (nvt && old_nvt && strcmp (nvt, old_nvt))
+        reports_counts_add_nvt (reports, nvt, 1, users_where);
+    }
+  else
+    {
+      g_hash_table_iter_init (&reports_iter, reports);
+      reports_ptr = NULL;
+      while (g_hash_table_iter_next (&reports_iter,
+                                     ((gpointer*)&reports_ptr), NULL))
+        report_clear_count_cache (*reports_ptr, 0, 1, users_where);
+    }
+
+  new_reports = reports_for_override (override);
+  g_hash_table_iter_init (&reports_iter, new_reports);
+  reports_ptr = NULL;
   while (g_hash_table_iter_next (&reports_iter,
                                  ((gpointer*)&reports_ptr), NULL))
     {
+      if (g_hash_table_contains (reports, reports_ptr))
+        continue;
       if (auto_cache_rebuild)
         report_cache_counts (*reports_ptr, 0, 1, users_where);
       else
         report_clear_count_cache (*reports_ptr, 0, 1, users_where);
     }
-  g_hash_table_destroy (reports);
+  g_hash_table_destroy (new_reports);
   g_free (users_where);
+}
 
-  sql_commit ();
-  return 0;
+/**
+ * @brief Get the columns of an override that affect report counts.
+ *
+ * @param[in]  override  Override.
+ *
+ * @return SQL assignments that set the columns to their current values.
+ */
+static gchar *
+override_count_columns (override_t override)
+{
+  return sql_string ("SELECT 'nvt = ' || quote_nullable (nvt)"
+                     "       || ', hosts = ' || quote_nullable (hosts)"
+                     "       || ', port = ' || quote_nullable (port)"
+                     "       || ', severity = ' || quote_nullable (severity)"
+                     "       || ', new_severity = '"
+                     "       || quote_nullable (new_severity)"
+                     "       || ', task = ' || quote_nullable (task)"
+                     "       || ', result = ' || quote_nullable (result)"
+                     "       || ', end_time = ' || quote_nullable (end_time)"
+                     "       || ', result_nvt = '"
+                     "       || quote_nullable (result_nvt)"
+                     " FROM overrides WHERE id = %llu;",
+                     override);
+}
+
+/**
+ * @brief Update report count caches after an override was modified.
+ *
+ * Briefly puts the override back into its state before the change, to take
+ * out the old counts, and then adds the new counts.  If the override was
+ * changed again in the meantime the caches of all affected reports are
+ * cleared instead.
+ *
+ * All reports the override affects in any of these states are locked
+ * first, with reports_counts_lock.
+ *
+ * @param[in]  override     Override.
+ * @param[in]  override_id  UUID of override.
+ * @param[in]  nvt          New NVT of override, or NULL if unchanged.
+ * @param[in]  old_columns  Override columns before the change, from
+ *                          override_count_columns.
+ * @param[in]  new_columns  Override columns after the change.
+ */
+static void
+modify_override_counts (override_t override, const char *override_id,
+                        const char *nvt, const gchar *old_columns,
+                        const gchar *new_columns)
+{
+  GHashTable *locked, *reports;
+  gchar *current_columns, *old_nvt;
+
+  /* Keep other modifications out until the columns are restored. */
+  sql ("SELECT id FROM overrides WHERE id = %llu FOR UPDATE;", override);
+  current_columns = override_count_columns (override);
+  if (current_columns == NULL)
+    return;
+
+  locked = reports_for_override (override);
+  sql ("UPDATE overrides SET %s WHERE id = %llu;", old_columns, override);
+  reports_add_for_override (locked, override);
+  sql ("UPDATE overrides SET %s WHERE id = %llu;", new_columns, override);
+  reports_add_for_override (locked, override);
+  sql ("UPDATE overrides SET %s WHERE id = %llu;", current_columns,
+       override);
+  reports_counts_lock (locked);
+
+  if (strcmp (current_columns, new_columns))
+    {
+      GHashTableIter reports_iter;
+      report_t *reports_ptr;
+      gchar *users_where;
+
+      users_where = acl_users_with_access_where ("override", override_id,
+                                                 NULL, "id");
+      g_hash_table_iter_init (&reports_iter, locked);
+      reports_ptr = NULL;
+      while (g_hash_table_iter_next (&reports_iter,
+                                     ((gpointer*)&reports_ptr), NULL))
+        report_clear_count_cache (*reports_ptr, 0, 1, users_where);
+      g_hash_table_destroy (locked);
+      g_free (users_where);
+      g_free (current_columns);
+      return;
+    }
+
+  sql ("UPDATE overrides SET %s WHERE id = %llu;", old_columns, override);
+  reports = modify_override_counts_begin (override, override_id, nvt,
+                                          &old_nvt);
+  sql ("UPDATE overrides SET %s WHERE id = %llu;", new_columns, override);
+  modify_override_counts_end (reports, override, override_id, nvt, old_nvt);
+
+  g_hash_table_destroy (reports);
+  g_hash_table_destroy (locked);
+  g_free (current_columns);
+  g_free (old_nvt);
 }
 
 /**
@@ -37133,15 +42007,14 @@ modify_override (const gchar *override_id, const char *active, const char *nvt,
 {
   gchar *quoted_text, *quoted_hosts, *quoted_port, *quoted_severity;
   double severity_dbl, new_severity_dbl;
-  gchar *quoted_nvt;
-  GHashTable *reports;
+  gchar *quoted_nvt, *old_columns;
   GString *cache_invalidated_sql;
   int cache_invalidated;
   override_t override;
   task_t task;
   result_t result;
 
-  reports = NULL;
+  old_columns = NULL;
   cache_invalidated = 0;
 
   override = 0;
@@ -37309,7 +42182,7 @@ modify_override (const gchar *override_id, const char *active, const char *nvt,
   if ((active == NULL) || (strcmp (active, "-2") == 0))
     {
       if (cache_invalidated)
-        reports = reports_for_override (override);
+        old_columns = override_count_columns (override);
 
       sql ("UPDATE overrides SET"
            " modification_time = %i,"
@@ -37367,7 +42240,7 @@ modify_override (const gchar *override_id, const char *active, const char *nvt,
         cache_invalidated = 1;
 
       if (cache_invalidated)
-        reports = reports_for_override (override);
+        old_columns = override_count_columns (override);
 
       sql ("UPDATE overrides SET"
            " end_time = %i,"
@@ -37406,34 +42279,32 @@ modify_override (const gchar *override_id, const char *active, const char *nvt,
   g_free (quoted_severity);
   g_free (quoted_nvt);
 
-  if (cache_invalidated)
+  if (cache_invalidated && old_columns)
     {
-      GHashTableIter reports_iter;
-      report_t *reports_ptr;
-      gchar *users_where;
-      int auto_cache_rebuild;
-
-      users_where = acl_users_with_access_where ("override", override_id, NULL,
-                                                 "id");
+      gchar *new_columns;
 
-      reports_add_for_override (reports, override);
-
-      g_hash_table_iter_init (&reports_iter, reports);
-      reports_ptr = NULL;
-      auto_cache_rebuild = setting_auto_cache_rebuild_int ();
-      while (g_hash_table_iter_next (&reports_iter,
-                                    ((gpointer*)&reports_ptr), NULL))
+      /* Update the caches in the background, so that the client gets a
+       * response without waiting for the counts. */
+      new_columns = override_count_columns (override);
+      switch (fork_report_counts_update ())
         {
-          if (auto_cache_rebuild)
-            report_cache_counts (*reports_ptr, 0, 1, users_where);
-          else
-            report_clear_count_cache (*reports_ptr, 0, 1, users_where);
+          case 0:
+            modify_override_counts (override, override_id, nvt, old_columns,
+                                    new_columns);
+            report_counts_update_exit ();
+            break;
+          case -1:
+            sql_begin_immediate ();
+            modify_override_counts (override, override_id, nvt, old_columns,
+                                    new_columns);
+            sql_commit ();
+            break;
+          default:
+            break;
         }
-      g_free (users_where);
+      g_free (new_columns);
     }
-
-  if (reports)
-    g_hash_table_destroy (reports);
+  g_free (old_columns);
 
   return 0;
 }
@@ -40764,6 +45635,9 @@ DEF_ACCESS (schedule_iterator_icalendar, GET_ITERATOR_COLUMN_COUNT + 5);
  *
  * Lock the database before initialising.
  *
+ * Only covers the tasks that may be due to start or stop, so that the
+ * scheduler does not check every scheduled task on every run.
+ *
  * @param[in]  iterator        Iterator.
  *
  * @return 0 success, 1 failed to get lock, -1 error.
@@ -40782,15 +45656,29 @@ init_task_schedule_iterator (iterator_t* iterator)
                  " schedules.id, tasks.schedule_next_time,"
                  " schedules.icalendar, schedules.timezone,"
                  " schedules.duration,"
-                 " users.uuid, users.name"
+                 " users.uuid, users.name, tasks.run_status"
                  " FROM tasks, schedules, users"
                  " WHERE tasks.schedule = schedules.id"
                  " AND tasks.hidden = 0"
                  " AND (tasks.owner = (users.id))"
+                 /* Start may be due. */
+                 " AND ((tasks.schedule_next_time > 0"
+                 "       AND tasks.schedule_next_time <= m_now ()"
+                 "       AND tasks.run_status IN (%i, %i, %i, %i))"
+                 /* Stop may be due. */
+                 "      OR (schedules.duration > 0"
+                 "          AND tasks.run_status IN (%i, %i, %i)))"
                  /* Sort by task and prefer owner of task or schedule as user */
                  " ORDER BY tasks.id,"
                  "          (users.id = tasks.owner) DESC,"
-                 "          (users.id = schedules.owner) DESC;");
+                 "          (users.id = schedules.owner) DESC;",
+                 TASK_STATUS_DONE,
+                 TASK_STATUS_INTERRUPTED,
+                 TASK_STATUS_NEW,
+                 TASK_STATUS_STOPPED,
+                 TASK_STATUS_RUNNING,
+                 TASK_STATUS_REQUESTED,
+                 TASK_STATUS_QUEUED);
 
   return 0;
 }
@@ -40898,6 +45786,20 @@ DEF_ACCESS (task_schedule_iterator_owner_uuid, 7);
  */
 DEF_ACCESS (task_schedule_iterator_owner_name, 8);
 
+/**
+ * @brief Get the task run status from a task schedule iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Run status of the task.
+ */
+static task_status_t
+task_schedule_iterator_run_status (iterator_t* iterator)
+{
+  if (iterator->done) return TASK_STATUS_INTERRUPTED;
+  return (task_status_t) iterator_int (iterator, 9);
+}
+
 /**
  * @brief Get the start due state from a task schedule iterator.
  *
@@ -40916,7 +45818,7 @@ task_schedule_iterator_start_due (iterator_t* iterator)
   if (task_schedule_iterator_next_time (iterator) == 0)
     return FALSE;
 
-  run_status = task_run_status (task_schedule_iterator_task (iterator));
+  run_status = task_schedule_iterator_run_status (iterator);
   start_time = task_schedule_iterator_next_time (iterator);
 
   if ((run_status == TASK_STATUS_DONE
@@ -40958,7 +45860,7 @@ task_schedule_iterator_stop_due (iterator_t* iterator)
       if (report && (report_scheduled (report) == 0))
         return FALSE;
 
-      run_status = task_run_status (task_schedule_iterator_task (iterator));
+      run_status = task_schedule_iterator_run_status (iterator);
 
       if (run_status == TASK_STATUS_RUNNING
           || run_status == TASK_STATUS_REQUESTED
@@ -41006,7 +45908,7 @@ task_schedule_iterator_timed_out (iterator_t* iterator)
   if (schedule_timeout_secs < SCHEDULE_TIMEOUT_MIN_SECS)
     schedule_timeout_secs = SCHEDULE_TIMEOUT_MIN_SECS;
 
-  run_status = task_run_status (task_schedule_iterator_task (iterator));
+  run_status = task_schedule_iterator_run_status (iterator);
   duration = task_schedule_iterator_duration (iterator);
 
   if (duration && (duration < schedule_timeout_secs))
@@ -41024,6 +45926,352 @@ task_schedule_iterator_timed_out (iterator_t* iterator)
   return FALSE;
 }
 
+/**
+ * @brief Seconds a launched task may stay in the launch queue.
+ *
+ * If the task has not left the launch queued status by then, the launch
+ * is considered failed and the task gets its previous status back.
+ */
+#define TASK_LAUNCH_TIMEOUT 120
+
+/**
+ * @brief Add a scheduled task to the launch queue.
+ *
+ * @param[in]  task_uuid   UUID of task.
+ * @param[in]  owner_uuid  UUID of user to start the task as.
+ * @param[in]  owner_name  Name of user to start the task as.
+ */
+void
+task_launch_queue_add (const gchar *task_uuid, const gchar *owner_uuid,
+                       const gchar *owner_name)
+{
+  gchar *quoted_task_uuid, *quoted_owner_uuid, *quoted_owner_name;
+
+  quoted_task_uuid = sql_quote (task_uuid);
+  quoted_owner_uuid = sql_quote (owner_uuid);
+  quoted_owner_name = sql_quote (owner_name);
+
+  sql_begin_immediate ();
+  sql ("INSERT INTO task_launch_queue"
+       " (task, owner_uuid, owner_name, previous_run_status, queued_time,"
+       "  launch_time)"
+       " SELECT id, '%s', '%s', run_status, m_now (), 0"
+       " FROM tasks WHERE uuid = '%s' AND hidden = 0"
+       " ON CONFLICT (task) DO NOTHING;",
+       quoted_owner_uuid,
+       quoted_owner_name,
+       quoted_task_uuid);
+  sql ("UPDATE tasks SET run_status = %i"
+       " WHERE uuid = '%s'"
+       " AND id IN (SELECT task FROM task_launch_queue);",
+       TASK_STATUS_LAUNCH_QUEUED,
+       quoted_task_uuid);
+  sql_commit ();
+
+  g_free (quoted_task_uuid);
+  g_free (quoted_owner_uuid);
+  g_free (quoted_owner_name);
+}
+
+/**
+ * @brief Remove entries from the launch queue, restoring the task status.
+ *
+ * @param[in]  where  SQL condition on task_launch_queue selecting entries.
+ */
+static void
+task_launch_queue_drop (const gchar *where)
+{
+  sql ("UPDATE tasks"
+       " SET run_status = task_launch_queue.previous_run_status"
+       " FROM task_launch_queue"
+       " WHERE tasks.id = task_launch_queue.task"
+       " AND tasks.run_status = %i"
+       " AND (%s);",
+       TASK_STATUS_LAUNCH_QUEUED,
+       where);
+  sql ("DELETE FROM task_launch_queue WHERE %s;", where);
+}
+
+/**
+ * @brief Tidy the launch queue.
+ *
+ * Removes the entries of tasks that have started, of tasks whose launch
+ * failed and of tasks that were moved to the trashcan.  Also removes
+ * tasks that waited longer than the schedule timeout.
+ *
+ * @param[in]  timeout  Seconds a task may wait in the queue, -1 for ever.
+ */
+void
+task_launch_queue_expire (int timeout)
+{
+  gchar *where;
+
+  sql_begin_immediate ();
+
+  /* Tasks that have started, from the queue or otherwise. */
+  sql ("DELETE FROM task_launch_queue"
+       " WHERE task NOT IN (SELECT id FROM tasks WHERE run_status = %i);",
+       TASK_STATUS_LAUNCH_QUEUED);
+
+  /* Launches that failed. */
+  where = g_strdup_printf ("launch_time > 0 AND launch_time < m_now () - %i",
+                           TASK_LAUNCH_TIMEOUT);
+  task_launch_queue_drop (where);
+  g_free (where);
+
+  task_launch_queue_drop ("task IN (SELECT id FROM tasks WHERE hidden != 0)");
+
+  if (timeout >= 0)
+    {
+      if (sql_int ("SELECT count (*) FROM task_launch_queue"
+                   " WHERE launch_time = 0"
+                   " AND queued_time < m_now () - %i;",
+                   timeout))
+        g_message ("%s: Tasks timed out in launch queue", __func__);
+      where = g_strdup_printf ("launch_time = 0"
+                               " AND queued_time < m_now () - %i",
+                               timeout);
+      task_launch_queue_drop (where);
+      g_free (where);
+    }
+
+  sql_commit ();
+}
+
+/**
+ * @brief Remove a task from the launch queue, restoring its status.
+ *
+ * @param[in]  task_uuid  UUID of task.
+ */
+void
+task_launch_queue_remove (const gchar *task_uuid)
+{
+  gchar *quoted_task_uuid, *where;
+
+  quoted_task_uuid = sql_quote (task_uuid);
+  where = g_strdup_printf ("task = (SELECT id FROM tasks WHERE uuid = '%s')",
+                           quoted_task_uuid);
+  g_free (quoted_task_uuid);
+
+  sql_begin_immediate ();
+  task_launch_queue_drop (where);
+  sql_commit ();
+  g_free (where);
+}
+
+/**
+ * @brief Mark a task in the launch queue as launched.
+ *
+ * @param[in]  task_uuid  UUID of task.
+ */
+void
+task_launch_queue_set_launched (const gchar *task_uuid)
+{
+  gchar *quoted_task_uuid;
+
+  quoted_task_uuid = sql_quote (task_uuid);
+  sql ("UPDATE task_launch_queue SET launch_time = m_now ()"
+       " WHERE task = (SELECT id FROM tasks WHERE uuid = '%s');",
+       quoted_task_uuid);
+  g_free (quoted_task_uuid);
+}
+
+/**
+ * @brief Count the tasks waiting in the launch queue.
+ *
+ * @return Number of tasks that are queued but not launched yet.
+ */
+int
+task_launch_queue_count ()
+{
+  return sql_int ("SELECT count (*) FROM task_launch_queue"
+                  " WHERE launch_time = 0;");
+}
+
+/**
+ * @brief Count the active scans, for launch admission.
+ *
+ * Includes tasks that were launched from the queue but have not reached
+ * an active status yet.
+ *
+ * @param[in]  scanner  Scanner to count for, 0 for all scanners.
+ *
+ * @return Number of active scans.
+ */
+int
+task_launch_queue_active (scanner_t scanner)
+{
+  gchar *clause;
+  int count;
+
+  clause = scanner ? g_strdup_printf (" AND scanner = %llu", scanner)
+                   : g_strdup ("");
+  count = sql_int ("SELECT"
+                   " (SELECT count (*) FROM tasks"
+                   "  WHERE run_status IN (%u, %u, %u, %u, %u)"
+                   "  %s)"
+                   " + (SELECT count (*) FROM task_launch_queue, tasks"
+                   "    WHERE task_launch_queue.task = tasks.id"
+                   "    AND launch_time > 0"
+                   "    AND run_status = %u"
+                   "    %s);",
+                   TASK_STATUS_REQUESTED,
+                   TASK_STATUS_QUEUED,
+                   TASK_STATUS_RUNNING,
+                   TASK_STATUS_STOP_REQUESTED,
+                   TASK_STATUS_STOP_WAITING,
+                   clause,
+                   TASK_STATUS_LAUNCH_QUEUED,
+                   clause);
+  g_free (clause);
+  return count;
+}
+
+/**
+ * @brief Initialise an iterator over the tasks waiting in the launch queue.
+ *
+ * Tasks are returned in the order they were queued.
+ *
+ * @param[in]  iterator  Iterator.
+ */
+void
+init_task_launch_queue_iterator (iterator_t *iterator)
+{
+  init_iterator (iterator,
+                 "SELECT tasks.uuid, task_launch_queue.owner_uuid,"
+                 "       task_launch_queue.owner_name, tasks.scanner"
+                 " FROM task_launch_queue, tasks"
+                 " WHERE task_launch_queue.task = tasks.id"
+                 " AND task_launch_queue.launch_time = 0"
+                 " ORDER BY task_launch_queue.queued_time,"
+                 "          task_launch_queue.task;");
+}
+
+/**
+ * @brief Get the task UUID from a launch queue iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Task UUID, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (task_launch_queue_iterator_task_uuid, 0);
+
+/**
+ * @brief Get the owner UUID from a launch queue iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Owner UUID, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (task_launch_queue_iterator_owner_uuid, 1);
+
+/**
+ * @brief Get the owner name from a launch queue iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Owner name, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (task_launch_queue_iterator_owner_name, 2);
+
+/**
+ * @brief Get the scanner from a launch queue iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Scanner of the task.
+ */
+scanner_t
+task_launch_queue_iterator_scanner (iterator_t *iterator)
+{
+  if (iterator->done)
+    return 0;
+  return iterator_int64 (iterator, 3);
+}
+
+/**
+ * @brief Initialise an iterator over the active tasks of OSP scanners.
+ *
+ * Covers the tasks that are queued or running on an OSP based scanner,
+ * for the OSP scan monitors.  The tasks are shared out between the
+ * monitors by ID.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  count     Number of monitors.
+ * @param[in]  index     Index of the monitor, from 0 to count - 1.
+ */
+void
+init_active_osp_task_iterator (iterator_t* iterator, int count, int index)
+{
+  init_iterator (iterator,
+                 "SELECT tasks.id, tasks.run_status, users.uuid, users.name"
+                 " FROM tasks, scanners, users"
+                 " WHERE tasks.scanner = scanners.id"
+                 " AND tasks.owner = users.id"
+                 " AND tasks.hidden = 0"
+                 " AND tasks.run_status IN (%i, %i)"
+                 " AND scanners.type IN (%i, %i, %i)"
+                 " AND tasks.id %% %i = %i;",
+                 TASK_STATUS_QUEUED,
+                 TASK_STATUS_RUNNING,
+                 SCANNER_TYPE_OSP,
+                 SCANNER_TYPE_OPENVAS,
+                 SCANNER_TYPE_OSP_SENSOR,
+                 count > 0 ? count : 1,
+                 count > 0 ? index : 0);
+}
+
+/**
+ * @brief Get the task from an active OSP task iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Task.
+ */
+task_t
+active_osp_task_iterator_task (iterator_t* iterator)
+{
+  if (iterator->done) return 0;
+  return (task_t) iterator_int64 (iterator, 0);
+}
+
+/**
+ * @brief Get the run status from an active OSP task iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Run status.
+ */
+task_status_t
+active_osp_task_iterator_run_status (iterator_t* iterator)
+{
+  if (iterator->done) return TASK_STATUS_INTERRUPTED;
+  return (task_status_t) iterator_int (iterator, 1);
+}
+
+/**
+ * @brief Get the task owner UUID from an active OSP task iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Owner UUID, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (active_osp_task_iterator_owner_uuid, 2);
+
+/**
+ * @brief Get the task owner name from an active OSP task iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Owner name, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (active_osp_task_iterator_owner_name, 3);
+
 /**
  * @brief Initialise a schedule task iterator.
  *
@@ -41310,6 +46558,7 @@ copy_group (const char *name, const char *comment, const char *group_id,
        " WHERE \"group\" = %llu;",
        new,
        old);
+  acl_cache_clear ();
 
   sql_commit ();
   if (new_group_return)
@@ -41448,6 +46697,7 @@ add_users (const gchar *type, resource_t resource, const char *users)
                type,
                resource,
                user);
+          acl_cache_clear ();
 
           point++;
         }
@@ -42451,6 +47701,7 @@ create_permission_internal (int check_access, const char *name_arg,
     *permission = sql_last_insert_id ();
 
   /* Update Permissions cache */
+  acl_cache_clear ();
   if (strcasecmp (quoted_name, "super") == 0)
     cache_all_permissions_for_users (NULL);
   else if (resource_type && resource)
@@ -42639,6 +47890,7 @@ copy_permission (const char* comment, const char *permission_id,
       return ret;
     }
 
+  acl_cache_clear ();
   sql_commit ();
   if (new_permission) *new_permission = new;
   return 0;
@@ -43375,6 +48627,7 @@ delete_permission (const char *permission_id, int ultimate)
   sql ("DELETE FROM permissions WHERE id = %llu;", permission);
 
   /* Update Permissions cache */
+  acl_cache_clear ();
   if (strcasecmp (name, "super") == 0)
     cache_all_permissions_for_users (NULL);
   else if (resource_type && resource)
@@ -43643,6 +48896,7 @@ modify_permission (const char *permission_id, const char *name_arg,
 
   /* Update permission caches according to the modifications. */
 
+  acl_cache_clear ();
   if (strcasecmp (name, "super") == 0 || strcasecmp (old_name, "super") == 0)
     cache_all_permissions_for_users (NULL);
   else
@@ -43804,6 +49058,7 @@ copy_role (const char *name, const char *comment, const char *role_id,
        current_credentials.uuid,
        new_role,
        old_role);
+  acl_cache_clear ();
 
   sql_commit ();
   if (new_role_return)
@@ -44591,6 +49846,118 @@ filter_term_min_qod (const char *term)
     return MIN_QOD_DEFAULT;
 }
 
+/**
+ * @brief Make a keyset pagination token.
+ *
+ * The token encodes the row id and the UUID of the last resource of a
+ * page.  Clients must treat it as opaque, and only pass it back in the
+ * "after" keyword of the filter for the next page.  It is URL safe base64
+ * without padding, so that it is a single filter value.
+ *
+ * @param[in]  resource  Row id of resource.
+ * @param[in]  uuid      UUID of resource.
+ *
+ * @return Freshly allocated token.
+ */
+gchar *
+keyset_token (resource_t resource, const char *uuid)
+{
+  gchar *plain, *token, *point;
+
+  plain = g_strdup_printf ("%llu:%s", resource, uuid ? uuid : "");
+  token = g_base64_encode ((guchar *) plain, strlen (plain));
+  g_free (plain);
+
+  for (point = token; *point; point++)
+    if (*point == '+')
+      *point = '-';
+    else if (*point == '/')
+      *point = '_';
+    else if (*point == '=')
+      {
+        *point = '\0';
+        break;
+      }
+  return token;
+}
+
+/**
+ * @brief Get the keyset pagination token of a filter term.
+ *
+ * The token in the "after" keyword comes from keyset_token, for the last
+ * resource of the previous page.  An empty token selects the first page.
+ *
+ * @param[in]   term        Filter term.
+ * @param[out]  after       Row id from token, 0 for the first page.
+ * @param[out]  after_uuid  UUID from token, NULL for the first page.  NULL
+ *                          to skip.
+ *
+ * @return 1 keyset pagination, 0 no "after" keyword, -1 invalid token.
+ */
+int
+filter_term_after (const char *term, resource_t *after, gchar **after_uuid)
+{
+  gchar *after_str, *padded, *plain, *end;
+  gsize length, index;
+  unsigned long long id;
+
+  *after = 0;
+  if (after_uuid)
+    *after_uuid = NULL;
+  after_str = filter_term_value (term, "after");
+  if (after_str == NULL)
+    return 0;
+
+  if (strlen (after_str) == 0)
+    {
+      g_free (after_str);
+      return 1;
+    }
+
+  if (strspn (after_str,
+              "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+              "0123456789-_")
+      != strlen (after_str))
+    {
+      g_free (after_str);
+      return -1;
+    }
+
+  /* Undo the URL safe alphabet and the dropped padding. */
+  length = strlen (after_str);
+  padded = g_malloc0 (length + 4);
+  for (index = 0; index < length; index++)
+    padded[index] = after_str[index] == '-'
+                     ? '+'
+                     : (after_str[index] == '_' ? '/' : after_str[index]);
+  while (index % 4)
+    padded[index++] = '=';
+  g_free (after_str);
+
+  plain = (gchar *) g_base64_decode (padded, &length);
+  g_free (padded);
+  plain = g_realloc (plain, length + 1);
+  plain[length] = '\0';
+
+  errno = 0;
+  id = strtoull (plain, &end, 10);
+  if (errno
+      || !g_ascii_isdigit (plain[0])
+      || *end != ':'
+      || strlen (end + 1) == 0
+      || !is_uuid (end + 1))
+    {
+      g_free (plain);
+      return -1;
+    }
+
+  *after = id;
+  if (after_uuid)
+    *after_uuid = g_strdup (end + 1);
+  g_free (plain);
+  return 1;
+}
+
 
 /**
  * @brief Create a filter.
@@ -46034,6 +51401,7 @@ manage_restore (const char *id)
 
       tags_set_locations ("permission", resource, permission, LOCATION_TABLE);
 
+      acl_cache_clear ();
       if (strcasecmp (name, "super") == 0)
         cache_all_permissions_for_users (NULL);
       else if (perm_resource != 0
@@ -46750,8 +52118,29 @@ report_host_t
 manage_report_host_add (report_t report, const char *host, time_t start,
                         time_t end)
 {
-  char *quoted_host = sql_quote (host);
+  char *quoted_host;
+  report_host_t report_host;
 
+  if (report_host_cache_active (report))
+    {
+      report_host = report_host_cache_lookup (report, host);
+      if (report_host)
+        return report_host;
+
+      quoted_host = sql_quote (host);
+      sql_int64 (&report_host,
+                 "INSERT INTO report_hosts"
+                 " (report, host, start_time, end_time, current_port,"
+                 "  max_port)"
+                 " VALUES (%llu, '%s', %lld, %lld, 0, 0)"
+                 " RETURNING id;",
+                 report, quoted_host, (long long) start, (long long) end);
+      g_free (quoted_host);
+      report_host_cache_add (host, report_host);
+      return report_host;
+    }
+
+  quoted_host = sql_quote (host);
   sql ("INSERT INTO report_hosts"
        " (report, host, start_time, end_time, current_port, max_port)"
        " SELECT %llu, '%s', %lld, %lld, 0, 0"
@@ -47707,10 +53096,8 @@ DEF_ACCESS (host_identifier_iterator_os_title,
    },                                                                 \
    {                                                                  \
      "(SELECT round (CAST (severity AS numeric), 1)"                  \
-     " FROM host_max_severities"                                      \
-     " WHERE host = hosts.id"                                         \
-     " ORDER by creation_time DESC"                                   \
-     " LIMIT 1)",                                                     \
+     " FROM host_latest"                                              \
+     " WHERE host = hosts.id)",                                       \
      "severity",                                                      \
      KEYWORD_TYPE_DOUBLE                                              \
    },                                                                 \
@@ -47722,23 +53109,11 @@ DEF_ACCESS (host_identifier_iterator_os_title,
      "        THEN '[unknown]'"                                       \
      "        ELSE best_os_cpe"                                       \
      "        END"                                                    \
-     " FROM (SELECT (SELECT value"                                    \
-     "               FROM (SELECT max (id) AS id"                     \
-     "                     FROM host_details"                         \
-     "                     WHERE host = hosts.id"                     \
-     "                     AND name = 'best_os_cpe')"                 \
-     "                     AS sub,"                                   \
-     "                    host_details"                               \
-     "               WHERE sub.id = host_details.id)"                 \
+     " FROM (SELECT (SELECT best_os_cpe FROM host_latest"             \
+     "               WHERE host = hosts.id)"                          \
      "              AS best_os_cpe,"                                  \
-     "              (SELECT value"                                    \
-     "               FROM (SELECT max (id) AS id"                     \
-     "                     FROM host_details"                         \
-     "                     WHERE host = hosts.id"                     \
-     "                     AND name = 'best_os_text')"                \
-     "                     AS sub,"                                   \
-     "                    host_details"                               \
-     "               WHERE sub.id = host_details.id)"                 \
+     "              (SELECT best_os_text FROM host_latest"            \
+     "               WHERE host = hosts.id)"                          \
      "              AS best_os_text)"                                 \
      "      AS vars)",                                                \
      "os",                                                            \
@@ -47781,10 +53156,8 @@ DEF_ACCESS (host_identifier_iterator_os_title,
  {                                                                    \
    {                                                                  \
      "(SELECT severity_to_level (CAST (severity AS numeric), 0)"      \
-     " FROM host_max_severities"                                      \
-     " WHERE host = hosts.id"                                         \
-     " ORDER by creation_time DESC"                                   \
-     " LIMIT 1)",                                                     \
+     " FROM host_latest"                                              \
+     " WHERE host = hosts.id)",                                       \
      "severity_level",                                                \
      KEYWORD_TYPE_STRING                                              \
    },                                                                 \
@@ -47917,28 +53290,18 @@ asset_host_count (const get_data_t *get)
    },                                                                         \
    {                                                                          \
      "(SELECT count(*)"                                                       \
-     " FROM (SELECT inner_cpes[1] AS cpe, host"                               \
-     "       FROM (SELECT array_agg (host_details.value"                      \
-     "                               ORDER BY host_details.id DESC)"          \
-     "                    AS inner_cpes,"                                     \
-     "                    host"                                               \
-     "             FROM host_details, hosts"                                  \
-     "             WHERE host_details.name = 'best_os_cpe'"                   \
-     "             AND hosts.id = host_details.host"                          \
-     "             AND (" ACL_USER_MAY_OPTS ("hosts") ")"                     \
-     "             GROUP BY host)"                                            \
-     "            AS host_details_subselect)"                                 \
-     "      AS array_removal_subselect"                                       \
-     " WHERE cpe = oss.name)",                                                \
+     " FROM host_latest, hosts"                                               \
+     " WHERE host_latest.best_os_cpe = oss.name"                              \
+     " AND hosts.id = host_latest.host"                                       \
+     " AND (" ACL_USER_MAY_OPTS ("hosts") "))",                               \
      "hosts",                                                                 \
      KEYWORD_TYPE_INTEGER                                                     \
    },                                                                         \
    {                                                                          \
-     "(SELECT round (CAST (severity AS numeric), 1) FROM host_max_severities" \
+     "(SELECT round (CAST (severity AS numeric), 1) FROM host_latest"         \
      " WHERE host = (SELECT host FROM host_oss"                               \
      "               WHERE os = oss.id"                                       \
-     "               ORDER BY creation_time DESC LIMIT 1)"                    \
-     " ORDER BY creation_time DESC LIMIT 1)",                                 \
+     "               ORDER BY creation_time DESC LIMIT 1))",                  \
      "latest_severity",                                                       \
      KEYWORD_TYPE_DOUBLE                                                      \
    },                                                                         \
@@ -47952,9 +53315,8 @@ asset_host_count (const get_data_t *get)
    },                                                                         \
    {                                                                          \
      "(SELECT round (CAST (avg (severity) AS numeric), 2)"                    \
-     " FROM (SELECT (SELECT severity FROM host_max_severities"                \
-     "               WHERE host = hosts.host"                                 \
-     "               ORDER BY creation_time DESC LIMIT 1)"                    \
+     " FROM (SELECT (SELECT severity FROM host_latest"                        \
+     "               WHERE host = hosts.host)"                                \
      "              AS severity"                                              \
      "       FROM (SELECT distinct host FROM host_oss WHERE os = oss.id)"     \
      "       AS hosts)"                                                       \
@@ -47974,9 +53336,8 @@ asset_host_count (const get_data_t *get)
      "(SELECT round (CAST (avg (severity) AS numeric)"                        \
      "               * (SELECT count (distinct host)"                         \
      "                  FROM host_oss WHERE os = oss.id), 2)"                 \
-     " FROM (SELECT (SELECT severity FROM host_max_severities"                \
-     "               WHERE host = hosts.host"                                 \
-     "               ORDER BY creation_time DESC LIMIT 1)"                    \
+     " FROM (SELECT (SELECT severity FROM host_latest"                        \
+     "               WHERE host = hosts.host)"                                \
      "              AS severity"                                              \
      "       FROM (SELECT distinct host FROM host_oss WHERE os = oss.id)"     \
      "       AS hosts)"                                                       \
@@ -47986,9 +53347,8 @@ asset_host_count (const get_data_t *get)
    },                                                                         \
    {                                                                          \
      "(SELECT round (CAST (avg (severity) AS numeric), 2)"                    \
-     " FROM (SELECT (SELECT severity FROM host_max_severities"                \
-     "               WHERE host = hosts.host"                                 \
-     "               ORDER BY creation_time DESC LIMIT 1)"                    \
+     " FROM (SELECT (SELECT severity FROM host_latest"                        \
+     "               WHERE host = hosts.host)"                                \
      "              AS severity"                                              \
      "       FROM (SELECT distinct host FROM host_oss WHERE os = oss.id)"     \
      "       AS hosts)"                                                       \
@@ -48156,10 +53516,8 @@ init_os_host_iterator (iterator_t* iterator, resource_t os)
                  "       iso_time (modification_time), creation_time,"
                  "       modification_time, owner, owner,"
                  "       (SELECT round (CAST (severity AS numeric), 1)"
-                 "        FROM host_max_severities"
-                 "        WHERE host = hosts.id"
-                 "        ORDER by creation_time DESC"
-                 "        LIMIT 1)"
+                 "        FROM host_latest"
+                 "        WHERE host = hosts.id)"
                  " FROM hosts"
                  " WHERE id IN (SELECT DISTINCT host FROM host_oss"
                  "              WHERE os = %llu)"
@@ -48834,6 +54192,8 @@ delete_asset (const char *asset_id, const char *report_id, int dummy)
 /**
  * @brief Generates and adds assets from report host details
  *
+ * Must be called within a transaction.
+ *
  * @param[in]  report   The report to get host details from.
  * @param[in]  host_ip  IP address of the host to get details from.
  *
@@ -48842,10 +54202,45 @@ delete_asset (const char *asset_id, const char *report_id, int dummy)
 int
 add_assets_from_host_in_report (report_t report, const char *host_ip)
 {
+  GPtrArray *host_ips;
   int ret;
-  gchar *quoted_host;
+
+  host_ips = g_ptr_array_new ();
+  g_ptr_array_add (host_ips, (gpointer) host_ip);
+  ret = add_assets_from_hosts_in_report (report, host_ips);
+  g_ptr_array_free (host_ips, TRUE);
+  return ret;
+}
+
+/**
+ * @brief Generates and adds assets from the report host details of hosts.
+ *
+ * The asset hosts of all the hosts are identified, and the new hosts and
+ * host identifiers added, with one statement each, following the same
+ * rules as \ref host_notice.
+ *
+ * Must be called within a transaction, because the hosts are collected in
+ * a temporary table, and with transaction pooling only a transaction is
+ * sure to stay on one database session.
+ *
+ * @param[in]  report    The report to get host details from.
+ * @param[in]  host_ips  IP addresses of the hosts to get details from.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+add_assets_from_hosts_in_report (report_t report, GPtrArray *host_ips)
+{
+  GString *values;
+  GArray *report_hosts;
+  GPtrArray *ips;
+  iterator_t hosts;
   char *report_id;
-  report_host_t report_host = 0;
+  guint index;
+  int ret;
+
+  if (host_ips->len == 0)
+    return 0;
 
   /* Get report UUID */
   report_id = report_uuid (report);
@@ -48856,40 +54251,162 @@ add_assets_from_host_in_report (report_t report, const char *host_ip)
       return -1;
     }
 
-  /* Find report_host */
-  quoted_host = sql_quote (host_ip);
-  sql_int64 (&report_host,
-             "SELECT id FROM report_hosts"
-             " WHERE host = '%s' AND report = %llu",
-             quoted_host,
-             report);
-  g_free (quoted_host);
-  if (report_host == 0)
+  values = g_string_new ("");
+  for (index = 0; index < host_ips->len; index++)
     {
-      g_warning ("%s: report_host for host '%s' and report '%s' not found.",
-                 __func__, host_ip, report_id);
-      free (report_id);
-      return -1;
+      gchar *quoted_host;
+
+      quoted_host = sql_quote (g_ptr_array_index (host_ips, index));
+      g_string_append_printf (values, "%s ('%s')",
+                              index ? "," : "", quoted_host);
+      g_free (quoted_host);
     }
 
-  /* Create assets */
-  if (report_host_noticeable (report, host_ip))
+  /* Find the report_hosts. */
+
+  sql ("CREATE TEMPORARY TABLE asset_hosts"
+       " (ip text, report_host integer, host integer, noticeable boolean)"
+       " ON COMMIT DROP;");
+  sql ("INSERT INTO asset_hosts (ip, report_host, noticeable)"
+       " SELECT DISTINCT ips.ip,"
+       "        (SELECT id FROM report_hosts"
+       "         WHERE host = ips.ip AND report = %llu"
+       "         LIMIT 1),"
+       "        FALSE"
+       " FROM (VALUES %s) AS ips (ip);",
+       report,
+       values->str);
+  g_string_free (values, TRUE);
+
+  if (sql_int ("SELECT count (*) FROM asset_hosts"
+               " WHERE report_host IS NULL;"))
     {
-      host_notice (host_ip, "ip", host_ip, "Report Host", report_id, 1, 1);
+      g_warning ("%s: report_hosts for %i hosts of report '%s' not found.",
+                 __func__,
+                 sql_int ("SELECT count (*) FROM asset_hosts"
+                          " WHERE report_host IS NULL;"),
+                 report_id);
+      sql ("DELETE FROM asset_hosts WHERE report_host IS NULL;");
     }
 
-  ret = add_tls_certificates_from_report_host (report_host,
-                                               report_id,
-                                               host_ip);
-  if (ret)
+  /* Create assets, if "Add to Assets" is set on the task.  As in
+   * report_host_noticeable, only alive hosts with results are added. */
+
+  if (sql_int ("SELECT value = 'no' FROM task_preferences"
+               " WHERE task = (SELECT task FROM reports WHERE id = %llu)"
+               " AND name = 'in_assets';",
+               report)
+      == 0)
     {
-      free (report_id);
-      return ret;
+      sql ("UPDATE asset_hosts"
+           " SET noticeable = TRUE"
+           " WHERE NOT EXISTS (SELECT * FROM report_host_details"
+           "                   WHERE report_host = asset_hosts.report_host"
+           "                   AND name = 'Host dead'"
+           "                   AND value != '0')"
+           " AND EXISTS (SELECT * FROM results"
+           "             WHERE report = %llu"
+           "             AND host = asset_hosts.ip);",
+           report);
+
+      /* Identify the hosts, as host_identify does. */
+
+      sql ("UPDATE asset_hosts"
+           " SET host = (SELECT id FROM hosts"
+           "             WHERE name = asset_hosts.ip"
+           "             AND owner = (SELECT id FROM users"
+           "                          WHERE uuid = '%s')"
+           "             AND (EXISTS (SELECT * FROM host_identifiers"
+           "                          WHERE host = hosts.id"
+           "                          AND owner = hosts.owner"
+           "                          AND name = 'ip'"
+           "                          AND value = asset_hosts.ip)"
+           "                  OR NOT EXISTS (SELECT * FROM host_identifiers"
+           "                                 WHERE host = hosts.id"
+           "                                 AND owner = hosts.owner"
+           "                                 AND name = 'ip'))"
+           "             LIMIT 1)"
+           " WHERE noticeable;",
+           current_credentials.uuid);
+
+      /* Add the hosts that were not identified. */
+
+      sql ("WITH new_hosts AS"
+           " (INSERT INTO hosts"
+           "  (uuid, owner, name, comment, creation_time, modification_time)"
+           "  SELECT make_uuid (), (SELECT id FROM users WHERE uuid = '%s'),"
+           "         ip, '', m_now (), m_now ()"
+           "  FROM asset_hosts"
+           "  WHERE noticeable AND host IS NULL"
+           "  RETURNING id, name)"
+           " UPDATE asset_hosts SET host = new_hosts.id"
+           " FROM new_hosts"
+           " WHERE asset_hosts.ip = new_hosts.name"
+           " AND asset_hosts.noticeable"
+           " AND asset_hosts.host IS NULL;",
+           current_credentials.uuid);
+
+      /* Add the IP identifiers that the hosts do not have yet. */
+
+      sql ("WITH new_identifiers AS"
+           " (INSERT INTO host_identifiers"
+           "  (uuid, host, owner, name, comment, value, source_type,"
+           "   source_id, source_data, creation_time, modification_time)"
+           "  SELECT make_uuid (), host,"
+           "         (SELECT id FROM users WHERE uuid = '%s'), 'ip', '', ip,"
+           "         'Report Host', '%s', '', m_now (), m_now ()"
+           "  FROM asset_hosts"
+           "  WHERE noticeable"
+           "  AND NOT EXISTS (SELECT * FROM host_identifiers"
+           "                  WHERE host = asset_hosts.host"
+           "                  AND owner = (SELECT id FROM users"
+           "                               WHERE uuid = '%s')"
+           "                  AND name = 'ip'"
+           "                  AND value = asset_hosts.ip"
+           "                  AND source_type = 'Report Host'"
+           "                  AND source_id = '%s')"
+           "  RETURNING host, modification_time)"
+           " UPDATE hosts"
+           " SET modification_time = new_identifiers.modification_time"
+           " FROM new_identifiers"
+           " WHERE hosts.id = new_identifiers.host;",
+           current_credentials.uuid,
+           report_id,
+           current_credentials.uuid,
+           report_id);
+
+      /* The report hosts are now the latest of their hosts. */
+
+      sql ("SELECT host_latest_update (host)"
+           " FROM (SELECT DISTINCT host FROM asset_hosts"
+           "       WHERE noticeable AND host IS NOT NULL)"
+           "      AS noticed;");
     }
 
-  return 0;
-}
+  /* Add the TLS certificates of all the hosts together. */
 
+  report_hosts = g_array_new (FALSE, FALSE, sizeof (report_host_t));
+  ips = g_ptr_array_new_with_free_func (g_free);
+  init_iterator (&hosts, "SELECT report_host, ip FROM asset_hosts;");
+  while (next (&hosts))
+    {
+      report_host_t report_host;
+
+      report_host = iterator_int64 (&hosts, 0);
+      g_array_append_val (report_hosts, report_host);
+      g_ptr_array_add (ips, g_strdup (iterator_string (&hosts, 1)));
+    }
+  cleanup_iterator (&hosts);
+
+  ret = add_tls_certificates_from_report_hosts (report_hosts, ips,
+                                                report_id);
+  g_array_free (report_hosts, TRUE);
+  g_ptr_array_free (ips, TRUE);
+
+  sql ("DROP TABLE asset_hosts;");
+  free (report_id);
+  return ret;
+}
 
 /* Settings. */
 
@@ -48969,6 +54486,102 @@ setting_filter (const char *resource)
                      current_credentials.uuid);
 }
 
+/**
+ * @brief Settings of the current user, by setting UUID.
+ *
+ * Loaded on the first setting lookup of a session.
+ */
+static GHashTable *setting_cache = NULL;
+
+/**
+ * @brief User that \ref setting_cache belongs to.
+ */
+static gchar *setting_cache_user = NULL;
+
+/**
+ * @brief Timezone of the user that \ref setting_cache belongs to.
+ */
+static gchar *setting_cache_timezone = NULL;
+
+/**
+ * @brief Auto Cache Rebuild setting of the user of \ref setting_cache.
+ */
+static int setting_cache_auto_cache_rebuild = 1;
+
+/**
+ * @brief Empty the settings cache.
+ *
+ * Called when the user modifies a setting, and between sessions.
+ */
+static void
+setting_cache_clear ()
+{
+  if (setting_cache)
+    {
+      g_hash_table_destroy (setting_cache);
+      setting_cache = NULL;
+    }
+  g_free (setting_cache_user);
+  setting_cache_user = NULL;
+  g_free (setting_cache_timezone);
+  setting_cache_timezone = NULL;
+  setting_cache_auto_cache_rebuild = 1;
+}
+
+/**
+ * @brief Ensure the settings cache holds the settings of the current user.
+ *
+ * @return TRUE if the cache can be used, FALSE if there is no current user.
+ */
+static gboolean
+setting_cache_ensure ()
+{
+  iterator_t settings;
+
+  if (current_credentials.uuid == NULL)
+    return FALSE;
+
+  if (setting_cache
+      && strcmp (setting_cache_user, current_credentials.uuid) == 0)
+    return TRUE;
+
+  setting_cache_clear ();
+  setting_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                         g_free);
+  setting_cache_user = g_strdup (current_credentials.uuid);
+
+  /* Take the setting of the user where there is one, else the default. */
+  init_ps_iterator (&settings,
+                    "SELECT DISTINCT ON (uuid) uuid, value,"
+                    "       CAST (owner IS NOT NULL AS integer)"
+                    " FROM settings"
+                    " WHERE owner IS NULL"
+                    " OR owner = (SELECT id FROM users WHERE uuid = $1)"
+                    " ORDER BY uuid, coalesce (owner, 0) DESC;",
+                    SQL_STR_PARAM (current_credentials.uuid),
+                    NULL);
+  while (next (&settings))
+    {
+      const char *uuid, *value;
+
+      uuid = iterator_string (&settings, 0);
+      value = iterator_string (&settings, 1);
+      g_hash_table_insert (setting_cache, g_strdup (uuid), g_strdup (value));
+      /* Only the user's own Auto Cache Rebuild setting counts. */
+      if (iterator_int (&settings, 2)
+          && strcmp (uuid, "a09285b0-2d47-49b6-a4ef-946ee71f1d5c") == 0)
+        setting_cache_auto_cache_rebuild = value ? atoi (value) : 0;
+    }
+  cleanup_iterator (&settings);
+
+  setting_cache_timezone = sql_string_ps ("SELECT timezone FROM users"
+                                          " WHERE uuid = $1;",
+                                          SQL_STR_PARAM
+                                           (current_credentials.uuid),
+                                          NULL);
+  return TRUE;
+}
+
 /**
  * @brief Return the Default Severity user setting as a double.
  *
@@ -49000,6 +54613,8 @@ setting_dynamic_severity_int ()
 static char *
 setting_timezone ()
 {
+  if (setting_cache_ensure ())
+    return g_strdup (setting_cache_timezone);
   return sql_string ("SELECT timezone FROM users WHERE uuid = '%s'",
                      current_credentials.uuid);
 }
@@ -49012,6 +54627,8 @@ setting_timezone ()
 static int
 setting_auto_cache_rebuild_int ()
 {
+  if (setting_cache_ensure ())
+    return setting_cache_auto_cache_rebuild;
   return sql_int ("SELECT coalesce"
                   "        ((SELECT value FROM settings"
                   "          WHERE uuid = 'a09285b0-2d47-49b6-a4ef-946ee71f1d5c'"
@@ -49149,37 +54766,51 @@ DEF_ACCESS (setting_iterator_value, 4);
 int
 setting_value (const char *uuid, char **value)
 {
-  gchar *quoted_uuid;
+  const gchar *cached;
 
   if (value == NULL || uuid == NULL)
     return -1;
 
-  quoted_uuid = sql_quote (uuid);
+  if (setting_cache_ensure ())
+    {
+      if (g_hash_table_lookup_extended (setting_cache, uuid, NULL,
+                                        (gpointer *) &cached)
+          == FALSE)
+        {
+          *value = NULL;
+          return -1;
+        }
+      *value = g_strdup (cached);
+      return 0;
+    }
 
-  if (sql_int ("SELECT count (*)"
-               " FROM settings"
-               " WHERE uuid = '%s'"
-               " AND " ACL_GLOBAL_OR_USER_OWNS () ";",
-               quoted_uuid,
-               current_credentials.uuid)
+  if (sql_int_ps ("SELECT count (*)"
+                  " FROM settings"
+                  " WHERE uuid = $1"
+                  " AND ((owner IS NULL)"
+                  "      OR (owner = (SELECT users.id FROM users"
+                  "                   WHERE users.uuid = $2)));",
+                  SQL_STR_PARAM (uuid),
+                  SQL_STR_PARAM (current_credentials.uuid),
+                  NULL)
       == 0)
     {
       *value = NULL;
-      g_free (quoted_uuid);
       return -1;
     }
 
-  *value = sql_string
+  *value = sql_string_ps
              ("SELECT value"
               " FROM settings"
-              " WHERE uuid = '%s'"
-              " AND " ACL_GLOBAL_OR_USER_OWNS ()
+              " WHERE uuid = $1"
+              " AND ((owner IS NULL)"
+              "      OR (owner = (SELECT users.id FROM users"
+              "                   WHERE users.uuid = $2)))"
               /* Force the user's setting to come before the default. */
               " ORDER BY coalesce (owner, 0) DESC;",
-              quoted_uuid,
-              current_credentials.uuid);
-
-  g_free (quoted_uuid);
+              SQL_STR_PARAM (uuid),
+              SQL_STR_PARAM (current_credentials.uuid),
+              NULL);
 
   return 0;
 }
@@ -49195,36 +54826,51 @@ setting_value (const char *uuid, char **value)
 static int
 setting_value_int (const char *uuid, int *value)
 {
-  gchar *quoted_uuid;
+  const gchar *cached;
 
   if (value == NULL || uuid == NULL)
     return -1;
 
-  quoted_uuid = sql_quote (uuid);
+  if (setting_cache_ensure ())
+    {
+      if (g_hash_table_lookup_extended (setting_cache, uuid, NULL,
+                                        (gpointer *) &cached)
+          == FALSE)
+        {
+          *value = -1;
+          return -1;
+        }
+      *value = cached ? atoi (cached) : 0;
+      return 0;
+    }
 
-  if (sql_int ("SELECT count (*)"
-               " FROM settings"
-               " WHERE uuid = '%s'"
-               " AND " ACL_GLOBAL_OR_USER_OWNS () ";",
-               quoted_uuid,
-               current_credentials.uuid)
+  if (sql_int_ps ("SELECT count (*)"
+                  " FROM settings"
+                  " WHERE uuid = $1"
+                  " AND ((owner IS NULL)"
+                  "      OR (owner = (SELECT users.id FROM users"
+                  "                   WHERE users.uuid = $2)));",
+                  SQL_STR_PARAM (uuid),
+                  SQL_STR_PARAM (current_credentials.uuid),
+                  NULL)
       == 0)
     {
       *value = -1;
-      g_free (quoted_uuid);
       return -1;
     }
 
-  *value = sql_int ("SELECT value"
-                    " FROM settings"
-                    " WHERE uuid = '%s'"
-                    " AND " ACL_GLOBAL_OR_USER_OWNS ()
-                    /* Force the user's setting to come before the default. */
-                    " ORDER BY coalesce (owner, 0) DESC;",
-                    quoted_uuid,
-                    current_credentials.uuid);
-
-  g_free (quoted_uuid);
+  *value = sql_int_ps ("SELECT value"
+                       " FROM settings"
+                       " WHERE uuid = $1"
+                       " AND ((owner IS NULL)"
+                       "      OR (owner = (SELECT users.id FROM users"
+                       "                   WHERE users.uuid = $2)))"
+                       /* Force the user's setting to come before the
+                        * default. */
+                       " ORDER BY coalesce (owner, 0) DESC;",
+                       SQL_STR_PARAM (uuid),
+                       SQL_STR_PARAM (current_credentials.uuid),
+                       NULL);
 
   return 0;
 }
@@ -49256,6 +54902,10 @@ modify_setting (const gchar *uuid, const gchar *name,
   if (r_errdesc)
     *r_errdesc = NULL;
 
+  /* The sessions of the user hold the timezone and severity settings. */
+  revoke_current_user_sessions ();
+  setting_cache_clear ();
+
   if (name && (strcmp (name, "Timezone") == 0))
     {
       gsize value_size;
@@ -51433,6 +57083,9 @@ delete_user (const char *user_id_arg, const char *name_arg, int ultimate,
   sql ("DELETE FROM result_nvt_reports"
        " WHERE report IN (SELECT id FROM reports WHERE owner = %llu);",
        user);
+  sql ("DELETE FROM report_deletions"
+       " WHERE report IN (SELECT id FROM reports WHERE owner = %llu);",
+       user);
   sql ("DELETE FROM reports WHERE owner = %llu;", user);
 
   /* Delete tasks (not directly referenced). */
@@ -51650,6 +57303,7 @@ delete_user (const char *user_id_arg, const char *name_arg, int ultimate,
   sql ("DELETE FROM group_users_trash WHERE \"user\" = %llu;", user);
   sql ("DELETE FROM role_users WHERE \"user\" = %llu;", user);
   sql ("DELETE FROM role_users_trash WHERE \"user\" = %llu;", user);
+  acl_cache_clear ();
 
   /* Delete report formats. */
 
@@ -54879,8 +60533,9 @@ type_build_select (const char *type, const char *columns_str,
       original = opts_table;
 
       opts_table = g_strdup_printf (" LEFT OUTER JOIN nvts"
-                                    " ON results.nvt = nvts.oid %s,"
+                                    " ON results.nvt = nvts.oid%s %s,"
                                     " LATERAL %s AS lateral_new_severity",
+                                    dynamic ? CURRENT_SEVERITY_JOIN : "",
                                     original,
                                     result_iterator_lateral (overrides,
                                                              dynamic));
@@ -55044,6 +60699,90 @@ all_users_array ()
   return ret;
 }
 
+/**
+ * @brief Update permissions cache of a user.
+ *
+ * Computes the permissions of all resources in one statement, and only
+ * writes the cache rows that are missing or have changed.
+ *
+ * Caller must switch the session to the user.
+ *
+ * @param[in]  type      Resource type.
+ * @param[in]  user      The user to update the cache for.
+ * @param[in]  resource  The resource to update the cache for, 0 for all.
+ */
+static void
+cache_permissions_for_user (const char *type, user_t user,
+                            resource_t resource)
+{
+  gchar *resource_clause;
+
+  if (resource)
+    resource_clause = g_strdup_printf (" WHERE id = %llu", resource);
+  else
+    resource_clause = NULL;
+
+  sql ("INSERT INTO permissions_get_%ss (\"user\", %s, has_permission)"
+       " SELECT %llu, id,"
+       "        user_has_access_uuid (cast ('%s' as text),"
+       "                              uuid,"
+       "                              cast ('get_%ss' as text),"
+       "                              0)"
+       " FROM %ss%s"
+       " ON CONFLICT (\"user\", %s)"
+       " DO UPDATE SET has_permission = EXCLUDED.has_permission"
+       " WHERE permissions_get_%ss.has_permission"
+       "       IS DISTINCT FROM EXCLUDED.has_permission;",
+       type,
+       type,
+       user,
+       type,
+       type,
+       type,
+       resource_clause ? resource_clause : "",
+       type,
+       type);
+
+  g_free (resource_clause);
+}
+
+/**
+ * @brief Update permissions cache for a resource or all resources of a type.
+ *
+ * @param[in]  type         Resource type.
+ * @param[in]  resource     The resource to update the cache for, 0 for all.
+ * @param[in]  cache_users  GArray of users to create cache for.
+ */
+static void
+cache_permissions_for_users_resource (const char *type, resource_t resource,
+                                      GArray *cache_users)
+{
+  char* old_current_user_id;
+  int user_index;
+
+  old_current_user_id = current_credentials.uuid;
+
+  for (user_index = 0; user_index < cache_users->len; user_index++)
+    {
+      user_t user;
+      gchar *user_id;
+
+      user = g_array_index (cache_users, user_t, user_index);
+      user_id = user_uuid (user);
+
+      current_credentials.uuid = user_id;
+      manage_session_init (user_id);
+
+      cache_permissions_for_user (type, user, resource);
+
+      g_free (user_id);
+      current_credentials.uuid = NULL;
+    }
+
+  current_credentials.uuid = old_current_user_id;
+  manage_session_init (old_current_user_id);
+}
+
 /**
  * @brief Update permissions cache for a resource.
  *
@@ -55057,6 +60796,8 @@ cache_permissions_for_resource (const char *type, resource_t resource,
 {
   int free_users;
 
+  acl_cache_clear ();
+
   if (type == NULL || resource == 0 || resource == -1)
     return;
 
@@ -55071,77 +60812,10 @@ cache_permissions_for_resource (const char *type, resource_t resource,
 
   if (strcmp (type, "task") == 0)
     {
-      char* old_current_user_id;
-      gchar *resource_id;
-      int user_index;
-
-      old_current_user_id = current_credentials.uuid;
-      resource_id = resource_uuid (type, resource);
-
-      g_debug ("%s: Caching permissions on %s \"%s\" for %d user(s)",
-               __func__, type, resource_id, cache_users->len);
-
-      for (user_index = 0; user_index < cache_users->len; user_index++)
-        {
-          user_t user;
-          gchar *user_id;
-
-          user = g_array_index (cache_users, user_t, user_index);
-          user_id = user_uuid (user);
-
-          current_credentials.uuid = user_id;
-          manage_session_init (user_id);
-
-          if (sql_int ("SELECT count(*) FROM permissions_get_%ss"
-                       " WHERE \"user\" = %llu"
-                       "   AND %s = %llu;",
-                       type,
-                       user,
-                       type,
-                       resource))
-            {
-              sql ("UPDATE permissions_get_%ss"
-                   "  SET has_permission"
-                   "       = user_has_access_uuid (cast ('%s' as text),"
-                   "                               cast ('%s' as text),"
-                   "                               cast ('get_%ss' as text),"
-                   "                               0)"
-                   " WHERE \"user\" = %llu"
-                   "   AND %s = %llu;",
-                   type,
-                   type,
-                   resource_id,
-                   type,
-                   user,
-                   type,
-                   resource);
-            }
-          else
-            {
-              sql ("INSERT INTO permissions_get_%ss"
-                   "              (\"user\", %s, has_permission)"
-                   "  SELECT %llu, %llu,"
-                   "         user_has_access_uuid (cast ('%s' as text),"
-                   "                               cast ('%s' as text),"
-                   "                               cast ('get_%ss' as text),"
-                   "                               0);",
-                   type,
-                   type,
-                   user,
-                   resource,
-                   type,
-                   resource_id,
-                   type);
-            }
+      g_debug ("%s: Caching permissions on %s %llu for %d user(s)",
+               __func__, type, resource, cache_users->len);
 
-          g_free (user_id);
-          current_credentials.uuid = NULL;
-        }
-
-      current_credentials.uuid = old_current_user_id;
-      manage_session_init (old_current_user_id);
-
-      g_free (resource_id);
+      cache_permissions_for_users_resource (type, resource, cache_users);
     }
 
   if (free_users)
@@ -55159,6 +60833,8 @@ cache_permissions_for_users (const char *type, GArray *cache_users)
 {
   int free_users;
 
+  acl_cache_clear ();
+
   if (type == NULL)
     return;
 
@@ -55173,17 +60849,10 @@ cache_permissions_for_users (const char *type, GArray *cache_users)
 
   if (strcmp (type, "task") == 0)
     {
-      iterator_t resources;
+      g_debug ("%s: Caching permissions on all %ss for %d user(s)",
+               __func__, type, cache_users->len);
 
-      init_iterator (&resources, "SELECT id FROM %ss;", type);
-
-      while (next (&resources))
-        {
-          resource_t resource = iterator_int64 (&resources, 0);
-          cache_permissions_for_resource (type, resource, cache_users);
-        }
-
-      cleanup_iterator (&resources);
+      cache_permissions_for_users_resource (type, 0, cache_users);
     }
 
   if (free_users)
@@ -55225,6 +60894,8 @@ cache_all_permissions_for_users (GArray *cache_users)
 void
 delete_permissions_cache_for_resource (const char* type, resource_t resource)
 {
+  acl_cache_clear ();
+
   if (type == NULL || resource == 0)
     return;
 
@@ -55243,12 +60914,126 @@ delete_permissions_cache_for_resource (const char* type, resource_t resource)
 void
 delete_permissions_cache_for_user (user_t user)
 {
+  acl_cache_clear ();
   sql ("DELETE FROM permissions_get_tasks WHERE \"user\" = %llu;", user);
 }
 
 
 /* Optimize. */
 
+/**
+ * @brief Describe how the planner runs the typical queries on results.
+ *
+ * Each query has the shape that the named GMP commands use for the
+ * results of a single report.  The queries are run with EXPLAIN against the
+ * report with the most results, and the description lists the indexes
+ * that each plan uses, or notes a sequential scan.
+ *
+ * @return Freshly allocated description.
+ */
+static gchar *
+explain_result_indexes ()
+{
+  struct
+  {
+    const char *commands;    ///< GMP commands that run the query.
+    const char *query;       ///< Query, with %llu for the report.
+  } queries[] = {
+    { "GET_REPORTS and GET_TASKS (severity counts)",
+      "SELECT severity, count (*) FROM results"
+      " WHERE report = %llu AND qod >= " G_STRINGIFY (MIN_QOD_DEFAULT)
+      " GROUP BY severity;" },
+    { "GET_REPORTS (hosts)",
+      "SELECT host, max (severity), count (*) FROM results"
+      " WHERE report = %llu AND qod >= " G_STRINGIFY (MIN_QOD_DEFAULT)
+      " GROUP BY host;" },
+    { "GET_RESULTS and GET_REPORTS (results of a report)",
+      "SELECT id FROM results"
+      " WHERE report = %llu AND qod >= " G_STRINGIFY (MIN_QOD_DEFAULT)
+      " AND severity > 0.0"
+      " ORDER BY severity DESC LIMIT 100;" },
+    { "GET_RESULTS (results of a host)",
+      "SELECT count (*) FROM results"
+      " WHERE report = %llu"
+      " AND host = (SELECT host FROM results WHERE report = %llu LIMIT 1)"
+      " AND qod >= " G_STRINGIFY (MIN_QOD_DEFAULT) ";" },
+    { NULL, NULL }
+  };
+  GString *text;
+  report_t report;
+  int index;
+
+  report = 0;
+  sql_int64 (&report,
+             "SELECT report FROM results"
+             " GROUP BY report ORDER BY count (*) DESC LIMIT 1;");
+  if (report == 0)
+    return g_strdup ("Optimized: explain-result-indexes."
+                     " There are no results to explain.");
+
+  text = g_string_new ("Optimized: explain-result-indexes.");
+  g_string_append_printf (text,
+                          " Plans for report %llu with %i results:",
+                          report,
+                          sql_int ("SELECT count (*) FROM results"
+                                   " WHERE report = %llu;",
+                                   report));
+
+  for (index = 0; queries[index].commands; index++)
+    {
+      iterator_t plan;
+      gchar *query;
+      GString *used;
+      gboolean seq_scan;
+
+      query = g_strdup_printf (queries[index].query, report, report);
+      init_iterator (&plan, "EXPLAIN %s", query);
+      g_free (query);
+
+      used = g_string_new ("");
+      seq_scan = FALSE;
+      while (next (&plan))
+        {
+          const char *line, *name;
+
+          line = iterator_string (&plan, 0);
+          if (line == NULL)
+            continue;
+
+          if (strstr (line, "Seq Scan"))
+            seq_scan = TRUE;
+
+          name = strstr (line, " using ");
+          if (name)
+            name += strlen (" using ");
+          else if ((name = strstr (line, "Bitmap Index Scan on ")))
+            name += strlen ("Bitmap Index Scan on ");
+
+          if (name)
+            {
+              gchar *index_name;
+
+              index_name = g_strndup (name, strcspn (name, " "));
+              if (strstr (used->str, index_name) == NULL)
+                g_string_append_printf (used, "%s%s",
+                                        used->len ? ", " : "",
+                                        index_name);
+              g_free (index_name);
+            }
+        }
+      cleanup_iterator (&plan);
+
+      g_string_append_printf (text, "\n  %s: %s%s%s",
+                              queries[index].commands,
+                              used->len ? used->str : "no index",
+                              seq_scan && used->len ? ", " : "",
+                              seq_scan ? "sequential scan" : "");
+      g_string_free (used, TRUE);
+    }
+
+  return g_string_free (text, FALSE);
+}
+
 /**
  * @brief Run one of the optimizations.
  *
@@ -55503,6 +61288,151 @@ manage_optimize (GSList *log_config, const db_conn_info_t *database,
                                       " Due date updated for %d tasks.",
                                       changes);
     }
+  else if (strcasecmp (name, "materialize-vulns") == 0)
+    {
+      sql_begin_immediate ();
+
+      sql ("DELETE FROM meta WHERE name = 'vulns_materialized';");
+      sql ("INSERT INTO meta (name, value)"
+           " VALUES ('vulns_materialized', '1');");
+      vuln_nvts_refresh ();
+      create_view_vulns ();
+
+      sql_commit ();
+
+      success_text = g_strdup_printf ("Optimized: materialize-vulns."
+                                      " Vulns refreshed from %d NVTs.",
+                                      sql_int ("SELECT count (*)"
+                                               " FROM vuln_nvts;"));
+    }
+  else if (strcasecmp (name, "create-result-indexes") == 0)
+    {
+      sql_begin_immediate ();
+
+      sql ("DELETE FROM meta WHERE name = 'result_covering_indexes';");
+      sql ("INSERT INTO meta (name, value)"
+           " VALUES ('result_covering_indexes', '1');");
+      manage_create_result_covering_indexes ();
+
+      sql_commit ();
+
+      sql ("ANALYZE results;");
+
+      success_text = explain_result_indexes ();
+    }
+  else if (strcasecmp (name, "drop-result-indexes") == 0)
+    {
+      sql_begin_immediate ();
+
+      sql ("DELETE FROM meta WHERE name = 'result_covering_indexes';");
+      manage_drop_result_covering_indexes ();
+
+      sql_commit ();
+
+      success_text = g_strdup ("Optimized: drop-result-indexes."
+                               " Covering result indexes dropped.");
+    }
+  else if (strcasecmp (name, "create-text-search-indexes") == 0)
+    {
+      sql_begin_immediate ();
+
+      if (manage_create_text_search_indexes ())
+        {
+          sql_rollback ();
+          fprintf (stderr, "The pg_trgm extension is not available.\n");
+          manage_option_cleanup ();
+          return 1;
+        }
+      sql ("DELETE FROM meta WHERE name = 'text_search_indexes';");
+      sql ("INSERT INTO meta (name, value)"
+           " VALUES ('text_search_indexes', '1');");
+
+      sql_commit ();
+
+      success_text = g_strdup ("Optimized: create-text-search-indexes."
+                               " Trigram indexes created for free text"
+                               " filter terms.");
+    }
+  else if (strcasecmp (name, "drop-text-search-indexes") == 0)
+    {
+      sql_begin_immediate ();
+
+      sql ("DELETE FROM meta WHERE name = 'text_search_indexes';");
+      manage_drop_text_search_indexes ();
+
+      sql_commit ();
+
+      success_text = g_strdup ("Optimized: drop-text-search-indexes."
+                               " Trigram indexes dropped.");
+    }
+  else if (strcasecmp (name, "explain-result-indexes") == 0)
+    {
+      success_text = explain_result_indexes ();
+    }
+  else if (strcasecmp (name, "dematerialize-vulns") == 0)
+    {
+      sql_begin_immediate ();
+
+      sql ("DELETE FROM meta WHERE name = 'vulns_materialized';");
+      sql ("DELETE FROM vuln_nvts;");
+      create_view_vulns ();
+
+      sql_commit ();
+
+      success_text = g_strdup ("Optimized: dematerialize-vulns."
+                               " Vulns are calculated from results.");
+    }
+  else if (strcasecmp (name, "deduplicate-host-details") == 0)
+    {
+      int count;
+
+      sql_begin_immediate ();
+
+      if (manage_deduplicate_report_host_details (&count))
+        success_text = g_strdup_printf ("Optimized: deduplicate-host-details."
+                                        " Removed %d unused host detail"
+                                        " values.",
+                                        count);
+      else
+        success_text = g_strdup_printf ("Optimized: deduplicate-host-details."
+                                        " Host details share %d distinct"
+                                        " values.",
+                                        count);
+
+      sql_commit ();
+    }
+  else if (strcasecmp (name, "partition-results") == 0)
+    {
+      sql_begin_immediate ();
+
+      switch (manage_partition_results ())
+        {
+          case 0:
+            sql_commit ();
+            success_text = g_strdup_printf ("Optimized: partition-results."
+                                            " Results partitioned by report"
+                                            " into %d partitions.",
+                                            sql_int ("SELECT count (*)"
+                                                     " FROM pg_inherits"
+                                                     " WHERE inhparent"
+                                                     "       = 'results'"
+                                                     "         ::regclass;"));
+            break;
+          case 1:
+            sql_rollback ();
+            success_text = g_strdup ("Optimized: partition-results."
+                                     " Results are already partitioned.");
+            break;
+          default:
+            sql_rollback ();
+            fprintf (stderr,
+                     "Partitioning results requires PostgreSQL 11"
+                     " or newer.\n");
+            success_text = NULL;
+            ret = -1;
+            break;
+        }
+    }
   else if (strcasecmp (name, "migrate-relay-sensors") == 0)
     {
       if (get_relay_mapper_path ())
@@ -55541,14 +61471,22 @@ manage_optimize (GSList *log_config, const db_conn_info_t *database,
 
       sql_begin_immediate ();
 
-      reports_build_count_cache (1, &changes);
-
-      sql_commit ();
+      if (reports_build_count_cache (1, &changes))
+        {
+          sql_rollback ();
+          fprintf (stderr, "Failed to rebuild some report caches.\n");
+          success_text = NULL;
+          ret = -1;
+        }
+      else
+        {
+          sql_commit ();
 
-      success_text = g_strdup_printf ("Optimized: rebuild-report-cache."
-                                      " Result counts recalculated for %d"
-                                      " reports.",
-                                      changes);
+          success_text = g_strdup_printf ("Optimized: rebuild-report-cache."
+                                          " Result counts recalculated for %d"
+                                          " reports.",
+                                          changes);
+        }
     }
   else if (strcasecmp (name, "update-report-cache") == 0)
     {
@@ -55556,14 +61494,22 @@ manage_optimize (GSList *log_config, const db_conn_info_t *database,
 
       sql_begin_immediate ();
 
-      reports_build_count_cache (0, &changes);
-
-      sql_commit ();
+      if (reports_build_count_cache (0, &changes))
+        {
+          sql_rollback ();
+          fprintf (stderr, "Failed to update some report caches.\n");
+          success_text = NULL;
+          ret = -1;
+        }
+      else
+        {
+          sql_commit ();
 
-      success_text = g_strdup_printf ("Optimized: update-report-cache."
-                                      " Result counts calculated for %d"
-                                      " reports.",
-                                      changes);
+          success_text = g_strdup_printf ("Optimized: update-report-cache."
+                                          " Result counts calculated for %d"
+                                          " reports.",
+                                          changes);
+        }
     }
   else
     {
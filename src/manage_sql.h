@@ -308,10 +308,36 @@ void set_task_schedule_next_time (task_t, time_t);
 
 void set_task_schedule_next_time_uuid (const gchar *, time_t);
 
+time_t task_schedule_next_due ();
+
 void init_preference_iterator (iterator_t *, config_t, const char *);
 const char *preference_iterator_name (iterator_t *);
 const char *preference_iterator_value (iterator_t *);
 
+/**
+ * @brief Kinds of item in the scan bundle of a config.
+ */
+typedef enum
+{
+  CONFIG_SCAN_BUNDLE_SCANNER_OPTION = 0,
+  CONFIG_SCAN_BUNDLE_VT_GROUP = 1,
+  CONFIG_SCAN_BUNDLE_VT = 2,
+  CONFIG_SCAN_BUNDLE_VT_VALUE = 3
+} config_scan_bundle_kind_t;
+
+gchar *nvt_oid_list_sql (GPtrArray *);
+
+int config_scan_bundle_current (config_t);
+int config_scan_bundle_begin (config_t);
+void config_scan_bundle_add (config_t, config_scan_bundle_kind_t,
+                             const char *, const char *, const char *);
+void config_scan_bundle_commit ();
+void init_config_scan_bundle_iterator (iterator_t *, config_t);
+config_scan_bundle_kind_t config_scan_bundle_iterator_kind (iterator_t *);
+const char *config_scan_bundle_iterator_name (iterator_t *);
+const char *config_scan_bundle_iterator_pref_id (iterator_t *);
+const char *config_scan_bundle_iterator_value (iterator_t *);
+
 port_list_t target_port_list (target_t);
 credential_t target_ssh_credential (target_t);
 credential_t target_smb_credential (target_t);
@@ -350,6 +376,16 @@ time_t task_schedule_iterator_initial_offset (iterator_t *);
 
 int set_task_schedule_uuid (const gchar*, schedule_t, int);
 
+void init_active_osp_task_iterator (iterator_t *, int, int);
+
+task_t active_osp_task_iterator_task (iterator_t *);
+
+task_status_t active_osp_task_iterator_run_status (iterator_t *);
+
+const char *active_osp_task_iterator_owner_uuid (iterator_t *);
+
+const char *active_osp_task_iterator_owner_name (iterator_t *);
+
 void reinit_manage_process ();
 
 int manage_update_nvti_cache ();
@@ -370,6 +406,8 @@ void check_generate_scripts ();
 
 void auto_delete_reports ();
 
+void reap_deleted_reports ();
+
 int parse_iso_time (const char *);
 
 void set_report_scheduled (report_t);
@@ -382,10 +420,22 @@ gboolean find_resource_with_permission (const char *, const char *,
 int
 resource_predefined (const gchar *, resource_t);
 
-void parse_osp_report (task_t, report_t, const char *);
+int parse_osp_report (task_t, report_t, const char *);
 
 void reschedule_task (const gchar *);
 
+void task_launch_queue_add (const gchar *, const gchar *, const gchar *);
+void task_launch_queue_expire (int);
+void task_launch_queue_remove (const gchar *);
+void task_launch_queue_set_launched (const gchar *);
+int task_launch_queue_count ();
+int task_launch_queue_active (scanner_t);
+void init_task_launch_queue_iterator (iterator_t *);
+const char *task_launch_queue_iterator_task_uuid (iterator_t *);
+const char *task_launch_queue_iterator_owner_uuid (iterator_t *);
+const char *task_launch_queue_iterator_owner_name (iterator_t *);
+scanner_t task_launch_queue_iterator_scanner (iterator_t *);
+
 void insert_port_range (port_list_t, port_protocol_t, int, int);
 
 int manage_cert_db_exists ();
@@ -458,9 +508,6 @@ int
 copy_resource_lock (const char *, const char *, const char *, const char *,
                     const char *, int, resource_t *, resource_t *);
 
-nvti_t *
-lookup_nvti (const gchar *);
-
 int
 setting_value (const char *, char **);
 
@@ -474,10 +521,61 @@ add_role_permission_resource (const gchar *, const gchar *, const gchar *,
 void
 create_view_vulns ();
 
+void
+manage_create_result_uuid_indexes ();
+
+void
+manage_create_result_covering_indexes ();
+
+void
+manage_drop_result_covering_indexes ();
+
+int
+manage_text_search_indexes_enabled ();
+
+int
+manage_create_text_search_indexes ();
+
+void
+manage_drop_text_search_indexes ();
+
+int
+results_partitioned ();
+
+void
+results_partition_ensure (report_t);
+
+gchar *
+results_partition_droppable (report_t);
+
+int
+results_partition_drop (const gchar *);
+
+int
+manage_partition_results ();
+
+int
+report_host_details_deduplicated ();
+
+int
+manage_deduplicate_report_host_details (int *);
+
+void
+create_indexes_nvt ();
+
+void
+drop_indexes_nvt ();
+
 int
 config_family_entire_and_growing (config_t, const char*);
 
 void
 reports_clear_count_cache_dynamic ();
 
+int
+feed_file_changed (const gchar *);
+
+void
+feed_file_record (const gchar *);
+
 #endif /* not _GVMD_MANAGE_SQL_H */
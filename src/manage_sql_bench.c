@@ -0,0 +1,743 @@
+/* Copyright (C) 2020 Greenbone Networks GmbH
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file manage_sql_bench.c
+ * @brief Benchmarks of the hot paths of the manage library.
+ *
+ * Seeds a database with a synthetic dataset and times result ingestion,
+ * report generation, result listing, the report count cache and the
+ * permission caches.  Each benchmark prints one JSON object per line.
+ *
+ * The database must already have been initialised by gvmd.  Use a
+ * database of its own, because the count cache and permission cache
+ * benchmarks work on every report and user in it.  The seeded rows are
+ * named with a "bench_" prefix and removed at the end, unless --keep is
+ * given.
+ *
+ * Before the benchmarks, the report host workers are checked against the
+ * serial path, for a user in a timezone other than UTC, and the revocation
+ * of GMP sessions is checked.  A failed check makes the run fail.
+ */
+
+#include "manage_sql.c"
+
+/**
+ * @brief Number of tasks to seed.
+ */
+static int bench_tasks = 20;
+
+/**
+ * @brief Number of reports to seed for each task.
+ */
+static int bench_reports = 5;
+
+/**
+ * @brief Number of results to seed for each report.
+ */
+static int bench_results = 1000;
+
+/**
+ * @brief Number of hosts that the results of each report are spread over.
+ */
+static int bench_hosts = 20;
+
+/**
+ * @brief Number of users to seed.  The tasks are shared out between them.
+ */
+static int bench_users = 5;
+
+/**
+ * @brief Number of times to run each benchmark.
+ */
+static int bench_iterations = 5;
+
+/**
+ * @brief Number of results per page of the result listing benchmark.
+ */
+static int bench_page_size = 100;
+
+/**
+ * @brief User that runs the benchmarks.
+ */
+static user_t bench_user = 0;
+
+/**
+ * @brief Task of the benchmark user.
+ */
+static task_t bench_task = 0;
+
+/**
+ * @brief Report of the benchmark user.
+ */
+static report_t bench_report = 0;
+
+/**
+ * @brief XML report format, or 0 if the database has none.
+ */
+static report_format_t bench_report_format = 0;
+
+/**
+ * @brief OSP report for the ingestion benchmark.
+ */
+static gchar *bench_osp_report = NULL;
+
+/**
+ * @brief Remove the seeded dataset.
+ */
+static void
+bench_cleanup ()
+{
+  sql_begin_immediate ();
+  sql ("CREATE TEMPORARY TABLE bench_reports AS"
+       " SELECT id FROM reports"
+       " WHERE task IN (SELECT id FROM tasks"
+       "                WHERE name LIKE 'bench\\_task\\_%%');");
+  sql ("DELETE FROM report_counts"
+       " WHERE report IN (SELECT id FROM bench_reports);");
+  sql ("DELETE FROM result_nvt_reports"
+       " WHERE report IN (SELECT id FROM bench_reports);");
+  sql ("DELETE FROM results"
+       " WHERE report IN (SELECT id FROM bench_reports);");
+  sql ("DELETE FROM report_host_details"
+       " WHERE report_host IN (SELECT id FROM report_hosts"
+       "                       WHERE report IN (SELECT id"
+       "                                        FROM bench_reports));");
+  sql ("DELETE FROM report_hosts"
+       " WHERE report IN (SELECT id FROM bench_reports);");
+  sql ("DELETE FROM reports WHERE id IN (SELECT id FROM bench_reports);");
+  sql ("DROP TABLE bench_reports;");
+  sql ("DELETE FROM permissions_get_tasks"
+       " WHERE task IN (SELECT id FROM tasks"
+       "                WHERE name LIKE 'bench\\_task\\_%%')"
+       " OR \"user\" IN (SELECT id FROM users"
+       "                 WHERE name LIKE 'bench\\_user\\_%%');");
+  sql ("DELETE FROM tasks WHERE name LIKE 'bench\\_task\\_%%';");
+  sql ("DELETE FROM role_users"
+       " WHERE \"user\" IN (SELECT id FROM users"
+       "                    WHERE name LIKE 'bench\\_user\\_%%');");
+  sql ("DELETE FROM users WHERE name LIKE 'bench\\_user\\_%%';");
+  sql_commit ();
+}
+
+/**
+ * @brief Seed the synthetic dataset.
+ *
+ * The rows are added with a few set based statements, so that seeding
+ * stays fast for large datasets.
+ */
+static void
+bench_seed ()
+{
+  sql_begin_immediate ();
+
+  sql ("INSERT INTO users"
+       " (uuid, owner, name, comment, password, timezone, hosts, hosts_allow,"
+       "  ifaces, ifaces_allow, method, creation_time, modification_time)"
+       " SELECT make_uuid (), NULL, 'bench_user_' || n, '', NULL, NULL, '', 0,"
+       "        '', 0, 'file', m_now (), m_now ()"
+       " FROM generate_series (1, %i) AS n;",
+       bench_users);
+
+  sql ("INSERT INTO role_users (role, \"user\")"
+       " SELECT (SELECT id FROM roles WHERE uuid = '" ROLE_UUID_ADMIN "'), id"
+       " FROM users WHERE name LIKE 'bench\\_user\\_%%';");
+
+  sql ("INSERT INTO tasks"
+       " (uuid, owner, name, hidden, comment, run_status, start_time,"
+       "  end_time, config, target, schedule, schedule_next_time,"
+       "  schedule_periods, scanner, config_location, target_location,"
+       "  schedule_location, scanner_location, upload_result_count,"
+       "  hosts_ordering, alterable, creation_time, modification_time,"
+       "  usage_type)"
+       " SELECT make_uuid (),"
+       "        (SELECT id FROM users"
+       "         WHERE name = 'bench_user_' || (n %% %i + 1)),"
+       "        'bench_task_' || n, 0, '', %u, m_now (), m_now (), 0, 0, 0,"
+       "        0, 0, 0, 0, 0, 0, 0, -1, '', 0, m_now (), m_now (), 'scan'"
+       " FROM generate_series (0, %i) AS n;",
+       bench_users,
+       TASK_STATUS_DONE,
+       bench_tasks - 1);
+
+  sql ("INSERT INTO reports"
+       " (uuid, owner, task, creation_time, start_time, end_time, comment,"
+       "  scan_run_status, slave_progress, flags, modification_time)"
+       " SELECT make_uuid (), tasks.owner, tasks.id, m_now () - r * 3600,"
+       "        m_now () - r * 3600, m_now () - r * 3600 + 600, '', %u, 0, 0,"
+       "        m_now ()"
+       " FROM tasks, generate_series (1, %i) AS r"
+       " WHERE tasks.name LIKE 'bench\\_task\\_%%';",
+       TASK_STATUS_DONE,
+       bench_reports);
+
+  sql ("INSERT INTO report_hosts"
+       " (report, host, start_time, end_time, current_port, max_port)"
+       " SELECT reports.id, '10.0.' || (h / 256) || '.' || (h %% 256),"
+       "        reports.start_time, reports.end_time, 0, 0"
+       " FROM reports, generate_series (1, %i) AS h"
+       " WHERE reports.task IN (SELECT id FROM tasks"
+       "                        WHERE name LIKE 'bench\\_task\\_%%');",
+       bench_hosts);
+
+  sql ("INSERT INTO result_nvts (nvt)"
+       " SELECT '1.3.6.1.4.1.25623.1.0.' || (900000 + n)"
+       " FROM generate_series (0, 999) AS n"
+       " ON CONFLICT DO NOTHING;");
+
+  sql ("INSERT INTO results"
+       " (uuid, task, host, port, nvt, result_nvt, type, description, report,"
+       "  nvt_version, severity, qod, qod_type, owner, date, hostname, path)"
+       " SELECT make_uuid (), reports.task,"
+       "        '10.0.' || ((n %% %i + 1) / 256) || '.'"
+       "        || ((n %% %i + 1) %% 256),"
+       "        (n %% 1000 + 1) || '/tcp',"
+       "        '1.3.6.1.4.1.25623.1.0.' || (900000 + n %% 1000),"
+       "        (SELECT id FROM result_nvts"
+       "         WHERE nvt = '1.3.6.1.4.1.25623.1.0.' || (900000 + n %% 1000)),"
+       "        'Alarm', 'Benchmark result ' || n, reports.id, '',"
+       "        (n %% 101) / 10.0, 75, '', reports.owner, reports.end_time,"
+       "        '', ''"
+       " FROM reports, generate_series (0, %i) AS n"
+       " WHERE reports.task IN (SELECT id FROM tasks"
+       "                        WHERE name LIKE 'bench\\_task\\_%%');",
+       bench_hosts,
+       bench_hosts,
+       bench_results - 1);
+
+  sql ("INSERT INTO result_nvt_reports (result_nvt, report)"
+       " SELECT DISTINCT result_nvt, report FROM results"
+       " WHERE report IN (SELECT id FROM reports"
+       "                  WHERE task IN (SELECT id FROM tasks"
+       "                                 WHERE name"
+       "                                       LIKE 'bench\\_task\\_%%'));");
+
+  sql_commit ();
+
+  sql_int64 (&bench_user,
+             "SELECT id FROM users WHERE name = 'bench_user_1';");
+  sql_int64 (&bench_task,
+             "SELECT id FROM tasks WHERE owner = %llu ORDER BY id LIMIT 1;",
+             bench_user);
+  sql_int64 (&bench_report,
+             "SELECT id FROM reports WHERE task = %llu ORDER BY id LIMIT 1;",
+             bench_task);
+  if (sql_int64 (&bench_report_format,
+                 "SELECT id FROM report_formats"
+                 " WHERE uuid = 'a994b278-1f62-11e1-96ac-406186ea4fc5';"))
+    bench_report_format = 0;
+}
+
+/**
+ * @brief Build the OSP report for the ingestion benchmark.
+ *
+ * @return Freshly allocated OSP report.
+ */
+static gchar *
+bench_osp_report_xml ()
+{
+  GString *xml;
+  int index;
+
+  xml = g_string_new ("<scan start_time=\"1600000000\""
+                      " end_time=\"1600000600\"><results>");
+  for (index = 0; index < bench_results; index++)
+    g_string_append_printf (xml,
+                            "<result name=\"Benchmark NVT %i\" type=\"Alarm\""
+                            " severity=\"%i.%i\" host=\"10.0.%i.%i\""
+                            " hostname=\"\""
+                            " test_id=\"1.3.6.1.4.1.25623.1.0.%i\""
+                            " port=\"%i/tcp\" qod=\"75\" uri=\"\">"
+                            "Benchmark result %i</result>",
+                            index % 1000,
+                            (index % 101) / 10,
+                            (index % 101) % 10,
+                            (index % bench_hosts + 1) / 256,
+                            (index % bench_hosts + 1) % 256,
+                            900000 + index % 1000,
+                            index % 1000 + 1,
+                            index);
+  g_string_append (xml, "</results></scan>");
+  return g_string_free (xml, FALSE);
+}
+
+/**
+ * @brief Benchmark: add an OSP report to a new report of the task.
+ */
+static void
+bench_parse_osp_report ()
+{
+  report_t report;
+
+  sql_int64 (&report,
+             "INSERT INTO reports"
+             " (uuid, owner, task, creation_time, start_time, end_time,"
+             "  comment, scan_run_status, slave_progress, flags,"
+             "  modification_time)"
+             " VALUES (make_uuid (), %llu, %llu, m_now (), m_now (), m_now (),"
+             "         '', %u, 0, 0, m_now ())"
+             " RETURNING id;",
+             bench_user,
+             bench_task,
+             TASK_STATUS_DONE);
+  parse_osp_report (bench_task, report, bench_osp_report);
+}
+
+/**
+ * @brief Benchmark: generate a report with the XML report format.
+ */
+static void
+bench_manage_report ()
+{
+  get_data_t get;
+  gchar *output;
+
+  memset (&get, 0, sizeof (get));
+  get.type = "report";
+  get.filter = "apply_overrides=0 min_qod=0 levels=hmlgdf first=1 rows=-1";
+  output = manage_report (bench_report, 0, &get, bench_report_format, 0, 0,
+                          NULL, NULL, NULL, NULL, NULL, NULL);
+  if (output == NULL)
+    g_warning ("%s: manage_report failed", __func__);
+  g_free (output);
+}
+
+/**
+ * @brief Benchmark: list all results of the user, a page at a time.
+ */
+static void
+bench_result_pages ()
+{
+  int first, rows;
+
+  first = 1;
+  do
+    {
+      get_data_t get;
+      iterator_t results;
+
+      memset (&get, 0, sizeof (get));
+      get.type = "result";
+      get.filter = g_strdup_printf ("apply_overrides=0 min_qod=0"
+                                    " sort=created first=%i rows=%i",
+                                    first, bench_page_size);
+      rows = 0;
+      if (init_result_get_iterator (&results, &get, 0, NULL, NULL) == 0)
+        {
+          while (next (&results))
+            rows++;
+          cleanup_iterator (&results);
+        }
+      g_free (get.filter);
+      first += bench_page_size;
+    }
+  while (rows == bench_page_size);
+}
+
+/**
+ * @brief Benchmark: rebuild the report count cache.
+ */
+static void
+bench_reports_build_count_cache ()
+{
+  int changes;
+
+  sql_begin_immediate ();
+  reports_build_count_cache (1, &changes);
+  sql_commit ();
+}
+
+/**
+ * @brief Benchmark: rebuild the permission caches of all users.
+ */
+static void
+bench_cache_all_permissions_for_users ()
+{
+  cache_all_permissions_for_users (NULL);
+}
+
+/**
+ * @brief Print the hosts of the benchmark report to a string.
+ *
+ * @param[in]  workers  Number of worker processes, 0 for the serial path.
+ * @param[in]  zone     Timezone override of the report, "" for none.
+ *
+ * @return Freshly allocated XML of the hosts, NULL on error.
+ */
+static gchar *
+bench_report_hosts_xml (int workers, const gchar *zone)
+{
+  report_host_counts_t counts;
+  FILE *stream;
+  GString *xml;
+  char buffer[4096];
+  size_t count;
+  int host_count, fail;
+
+  counts.ports = g_hash_table_new (g_str_hash, g_str_equal);
+  counts.holes = g_hash_table_new (g_str_hash, g_str_equal);
+  counts.warnings = g_hash_table_new (g_str_hash, g_str_equal);
+  counts.infos = g_hash_table_new (g_str_hash, g_str_equal);
+  counts.logs = g_hash_table_new (g_str_hash, g_str_equal);
+  counts.false_positives = g_hash_table_new (g_str_hash, g_str_equal);
+
+  host_count = sql_int ("SELECT count (*) FROM report_hosts"
+                        " WHERE report = %llu;",
+                        bench_report);
+
+  stream = tmpfile ();
+  if (stream == NULL)
+    fail = -1;
+  else if (workers)
+    fail = print_report_hosts_xml_parallel (stream, bench_report, host_count,
+                                            workers, &counts, 0, zone);
+  else
+    fail = print_report_hosts_range_xml (stream, bench_report, 0, host_count,
+                                         &counts, 0);
+
+  g_hash_table_destroy (counts.ports);
+  g_hash_table_destroy (counts.holes);
+  g_hash_table_destroy (counts.warnings);
+  g_hash_table_destroy (counts.infos);
+  g_hash_table_destroy (counts.logs);
+  g_hash_table_destroy (counts.false_positives);
+
+  if (stream == NULL)
+    return NULL;
+
+  xml = g_string_new ("");
+  rewind (stream);
+  while ((count = fread (buffer, 1, sizeof (buffer), stream)))
+    g_string_append_len (xml, buffer, count);
+  fclose (stream);
+
+  if (fail)
+    {
+      g_string_free (xml, TRUE);
+      return NULL;
+    }
+  return g_string_free (xml, FALSE);
+}
+
+/**
+ * @brief Check that the report host workers print the same XML as the
+ *        serial path, in the timezone of the user and in a report timezone.
+ *
+ * @return 0 if the XML is the same, else -1.
+ */
+static int
+bench_check_report_hosts_parallel ()
+{
+  const gchar *zones[] = { "", "America/New_York", NULL };
+  const gchar **zone;
+  int ret;
+
+  current_credentials.timezone = "Asia/Kolkata";
+  manage_session_set_timezone (current_credentials.timezone);
+
+  ret = 0;
+  for (zone = zones; *zone && ret == 0; zone++)
+    {
+      gchar *tz, *serial, *parallel;
+
+      tz = getenv ("TZ") ? g_strdup (getenv ("TZ")) : NULL;
+      if (strlen (*zone))
+        {
+          setenv ("TZ", *zone, 1);
+          tzset ();
+        }
+      sql_session_set ("gvmd.tz_override", *zone);
+
+      serial = bench_report_hosts_xml (0, *zone);
+      parallel = bench_report_hosts_xml (4, *zone);
+
+      if (serial == NULL || parallel == NULL)
+        {
+          g_warning ("%s: failed to print hosts", __func__);
+          ret = -1;
+        }
+      else if (strcmp (serial, parallel))
+        {
+          g_warning ("%s: parallel hosts differ from serial hosts"
+                     " (zone \"%s\"): %s vs %s",
+                     __func__, *zone, parallel, serial);
+          ret = -1;
+        }
+      g_free (serial);
+      g_free (parallel);
+
+      sql_session_set ("gvmd.tz_override", "");
+      if (tz)
+        setenv ("TZ", tz, 1);
+      else
+        unsetenv ("TZ");
+      tzset ();
+      g_free (tz);
+    }
+
+  manage_session_set_timezone ("UTC");
+  current_credentials.timezone = NULL;
+  return ret;
+}
+
+/**
+ * @brief Authenticate the benchmark user with a session token.
+ *
+ * @param[in]  token  Session token.
+ *
+ * @return Result of authenticate_token.
+ */
+static int
+bench_authenticate_token (const gchar *token)
+{
+  credentials_t credentials;
+  int ret;
+
+  memset (&credentials, 0, sizeof (credentials));
+  credentials.username = g_strdup ("bench_user_1");
+  ret = authenticate_token (&credentials, token);
+  free_credentials (&credentials);
+  return ret;
+}
+
+/**
+ * @brief Check that GMP sessions end on logout and on role changes.
+ *
+ * @return 0 if the sessions ended, else -1.
+ */
+static int
+bench_check_sessions ()
+{
+  gchar *token;
+  int ret, ttl;
+
+  ttl = gmp_session_ttl;
+  set_gmp_session_ttl (60);
+  ret = 0;
+
+  token = manage_session_token_new (&current_credentials);
+  if (token == NULL || bench_authenticate_token (token))
+    {
+      g_warning ("%s: new session is not valid", __func__);
+      ret = -1;
+    }
+  else
+    {
+      manage_session_token_revoke (token);
+      if (bench_authenticate_token (token) != 1)
+        {
+          g_warning ("%s: session is valid after revoke", __func__);
+          ret = -1;
+        }
+    }
+  g_free (token);
+
+  token = manage_session_token_new (&current_credentials);
+  if (ret == 0 && (token == NULL || bench_authenticate_token (token)))
+    {
+      g_warning ("%s: new session is not valid", __func__);
+      ret = -1;
+    }
+  else if (ret == 0)
+    {
+      sql ("INSERT INTO role_users (role, \"user\")"
+           " SELECT id, %llu FROM roles WHERE uuid = '" ROLE_UUID_OBSERVER "';",
+           bench_user);
+      if (bench_authenticate_token (token) != 1)
+        {
+          g_warning ("%s: session is valid after role change", __func__);
+          ret = -1;
+        }
+      sql ("DELETE FROM role_users"
+           " WHERE \"user\" = %llu"
+           " AND role = (SELECT id FROM roles"
+           "             WHERE uuid = '" ROLE_UUID_OBSERVER "');",
+           bench_user);
+    }
+  g_free (token);
+
+  set_gmp_session_ttl (ttl);
+  return ret;
+}
+
+/**
+ * @brief Run a benchmark and print its timings as a line of JSON.
+ *
+ * @param[in]  name  Name of benchmark.
+ * @param[in]  run   Function that runs the benchmark once.
+ */
+static void
+bench_run (const char *name, void (*run) ())
+{
+  gint64 min, max, total, sql_total;
+  int index, sql_count_total;
+
+  min = G_MAXINT64;
+  max = 0;
+  total = 0;
+  sql_total = 0;
+  sql_count_total = 0;
+  for (index = 0; index < bench_iterations; index++)
+    {
+      gint64 start, elapsed, sql_time;
+      int sql_count;
+
+      sql_stats_reset ();
+      start = g_get_monotonic_time ();
+      run ();
+      elapsed = g_get_monotonic_time () - start;
+      sql_stats (&sql_count, &sql_time);
+
+      min = MIN (min, elapsed);
+      max = MAX (max, elapsed);
+      total += elapsed;
+      sql_total += sql_time;
+      sql_count_total += sql_count;
+    }
+
+  printf ("{\"benchmark\": \"%s\", \"iterations\": %i,"
+          " \"min_ms\": %.3f, \"mean_ms\": %.3f, \"max_ms\": %.3f,"
+          " \"sql_statements\": %.1f, \"sql_mean_ms\": %.3f,"
+          " \"tasks\": %i, \"reports_per_task\": %i,"
+          " \"results_per_report\": %i, \"hosts_per_report\": %i,"
+          " \"users\": %i}\n",
+          name,
+          bench_iterations,
+          min / 1000.0,
+          total / 1000.0 / bench_iterations,
+          max / 1000.0,
+          (double) sql_count_total / bench_iterations,
+          sql_total / 1000.0 / bench_iterations,
+          bench_tasks,
+          bench_reports,
+          bench_results,
+          bench_hosts,
+          bench_users);
+  fflush (stdout);
+}
+
+/**
+ * @brief Entry point of the benchmarks.
+ *
+ * @param[in]  argc  Number of arguments.
+ * @param[in]  argv  Arguments.
+ *
+ * @return EXIT_SUCCESS on success, else EXIT_FAILURE.
+ */
+int
+main (int argc, char **argv)
+{
+  static gchar *database_name = "gvmd_bench";
+  static gboolean keep = FALSE;
+  db_conn_info_t database = { NULL, NULL, NULL, NULL };
+  GOptionContext *option_context;
+  GError *error;
+  gchar *uuid;
+
+  static GOptionEntry option_entries[]
+    = {
+        { "database", 'd', 0, G_OPTION_ARG_STRING, &database_name,
+          "Use <name> as database, default: gvmd_bench.", "<name>" },
+        { "hosts", '\0', 0, G_OPTION_ARG_INT, &bench_hosts,
+          "Spread the results of each report over <number> hosts.",
+          "<number>" },
+        { "iterations", 'n', 0, G_OPTION_ARG_INT, &bench_iterations,
+          "Run each benchmark <number> times.", "<number>" },
+        { "keep", '\0', 0, G_OPTION_ARG_NONE, &keep,
+          "Keep the seeded dataset.", NULL },
+        { "page-size", '\0', 0, G_OPTION_ARG_INT, &bench_page_size,
+          "List results <number> at a time.", "<number>" },
+        { "reports", '\0', 0, G_OPTION_ARG_INT, &bench_reports,
+          "Seed <number> reports for each task.", "<number>" },
+        { "results", '\0', 0, G_OPTION_ARG_INT, &bench_results,
+          "Seed <number> results for each report.", "<number>" },
+        { "tasks", '\0', 0, G_OPTION_ARG_INT, &bench_tasks,
+          "Seed <number> tasks.", "<number>" },
+        { "users", '\0', 0, G_OPTION_ARG_INT, &bench_users,
+          "Seed <number> users.", "<number>" },
+        { NULL }
+      };
+
+  option_context = g_option_context_new ("- Benchmark the Manager");
+  g_option_context_add_main_entries (option_context, option_entries, NULL);
+  error = NULL;
+  if (!g_option_context_parse (option_context, &argc, &argv, &error))
+    {
+      g_option_context_free (option_context);
+      g_critical ("%s: %s", __func__, error->message);
+      return EXIT_FAILURE;
+    }
+  g_option_context_free (option_context);
+
+  if (bench_tasks < 1 || bench_reports < 1 || bench_results < 1
+      || bench_hosts < 1 || bench_hosts > 65535 || bench_users < 1
+      || bench_iterations < 1 || bench_page_size < 1)
+    {
+      g_critical ("%s: counts must be at least 1, and there can be at most"
+                  " 65535 hosts",
+                  __func__);
+      return EXIT_FAILURE;
+    }
+
+  database.name = database_name;
+  if (manage_option_setup (NULL, &database))
+    return EXIT_FAILURE;
+
+  bench_cleanup ();
+  bench_seed ();
+  bench_osp_report = bench_osp_report_xml ();
+
+  uuid = user_uuid (bench_user);
+  current_credentials.uuid = uuid;
+  current_credentials.username = "bench_user_1";
+  manage_session_init (uuid);
+
+  if (bench_check_report_hosts_parallel () || bench_check_sessions ())
+    {
+      current_credentials.uuid = NULL;
+      current_credentials.username = NULL;
+      g_free (uuid);
+      g_free (bench_osp_report);
+      if (keep == FALSE)
+        bench_cleanup ();
+      manage_option_cleanup ();
+      return EXIT_FAILURE;
+    }
+
+  bench_run ("parse_osp_report", bench_parse_osp_report);
+  if (bench_report_format)
+    bench_run ("manage_report_xml", bench_manage_report);
+  else
+    g_warning ("%s: no XML report format, skipping manage_report_xml",
+               __func__);
+  bench_run ("init_result_get_iterator_pages", bench_result_pages);
+  bench_run ("reports_build_count_cache", bench_reports_build_count_cache);
+  bench_run ("cache_all_permissions_for_users",
+             bench_cache_all_permissions_for_users);
+
+  current_credentials.uuid = NULL;
+  current_credentials.username = NULL;
+  g_free (uuid);
+  g_free (bench_osp_report);
+
+  if (keep == FALSE)
+    bench_cleanup ();
+
+  manage_option_cleanup ();
+  return EXIT_SUCCESS;
+}
@@ -59,6 +59,9 @@ switch_representation (config_t, int);
 static void
 update_config_caches (config_t);
 
+static void
+config_nvts_invalidate (config_t);
+
 
 /* Helpers. */
 
@@ -974,6 +977,7 @@ manage_set_config_families (config_t config,
     {
       return 0;
     }
+  config_nvts_invalidate (config);
   constraining = config_families_growing (config);
 
   if (constraining + grow_families == 1)
@@ -1774,6 +1778,29 @@ init_nvt_preference_iterator (iterator_t* iterator, const char *oid)
                    sql_ilike_op ());
 }
 
+/**
+ * @brief Initialise an NVT preference iterator over some NVTs.
+ *
+ * The NVT preference iterator accessors work on this iterator too.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  oids      OIDs of NVTs.
+ */
+void
+init_nvts_preference_iterator (iterator_t* iterator, GPtrArray *oids)
+{
+  gchar *list;
+
+  list = nvt_oid_list_sql (oids);
+  init_iterator (iterator,
+                 "SELECT name, value FROM nvt_preferences"
+                 " WHERE split_part (name, ':', 1) IN (%s)"
+                 " AND name NOT LIKE '%%:0:entry:Timeout'"
+                 " ORDER BY name ASC;",
+                 list);
+  g_free (list);
+}
+
 /**
  * @brief Get the name from an NVT preference iterator.
  *
@@ -2955,6 +2982,33 @@ config_nvt_timeout (config_t config, const char *oid)
                      oid);
 }
 
+/**
+ * @brief Initialise an iterator over the timeouts of some NVTs in a config.
+ *
+ * The NVT timeout iterator accessors work on this iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  config    Config.
+ * @param[in]  oids      OIDs of NVTs.
+ */
+void
+init_config_nvt_timeout_iterator (iterator_t *iterator, config_t config,
+                                  GPtrArray *oids)
+{
+  gchar *list;
+
+  list = nvt_oid_list_sql (oids);
+  init_iterator (iterator,
+                 "SELECT substr (name, 9), value FROM config_preferences"
+                 " WHERE config = %llu"
+                 " AND type = 'SERVER_PREFS'"
+                 " AND name LIKE 'timeout.%%'"
+                 " AND substr (name, 9) IN (%s);",
+                 config,
+                 list);
+  g_free (list);
+}
+
 /**
  * @brief Check scanner and config values match for a task.
  *
@@ -3941,6 +3995,216 @@ config_nvt_selector (config_t config)
                      config);
 }
 
+/**
+ * @brief Number of bundle items to insert per statement.
+ */
+#define CONFIG_SCAN_BUNDLE_CHUNK 500
+
+/**
+ * @brief Pending VALUES of bundle items, for config_scan_bundle_add.
+ */
+static GString *config_scan_bundle_values = NULL;
+
+/**
+ * @brief Number of items in config_scan_bundle_values.
+ */
+static int config_scan_bundle_value_count = 0;
+
+/**
+ * @brief Check whether the scan bundle of a config is current.
+ *
+ * The bundle is current if it was built for the current modification time
+ * of the config and the current NVT feed version.  Changes to the
+ * preferences or NVT selector of the config remove the bundle via triggers.
+ *
+ * @param[in]  config  Config.
+ *
+ * @return 1 if current, else 0.
+ */
+int
+config_scan_bundle_current (config_t config)
+{
+  return sql_int ("SELECT count (*) FROM config_scan_bundles, configs"
+                  " WHERE config_scan_bundles.config = %llu"
+                  " AND configs.id = config_scan_bundles.config"
+                  " AND config_scan_bundles.config_modification_time"
+                  "     = configs.modification_time"
+                  " AND config_scan_bundles.nvts_feed_version"
+                  "     IS NOT DISTINCT FROM"
+                  "     (SELECT value FROM %s.meta"
+                  "      WHERE name = 'nvts_feed_version');",
+                  config,
+                  sql_schema ())
+         > 0;
+}
+
+/**
+ * @brief Start building the scan bundle of a config.
+ *
+ * Locks the config, so that concurrent launches of tasks that share the
+ * config wait for one build instead of all building.
+ *
+ * @param[in]  config  Config.
+ *
+ * @return 0 caller must add items and call config_scan_bundle_commit, 1 the
+ *         bundle was built meanwhile by another process.
+ */
+int
+config_scan_bundle_begin (config_t config)
+{
+  sql_begin_immediate ();
+  sql ("SELECT id FROM configs WHERE id = %llu FOR UPDATE;", config);
+  if (config_scan_bundle_current (config))
+    {
+      sql_commit ();
+      return 1;
+    }
+
+  sql ("DELETE FROM config_scan_bundles WHERE config = %llu;", config);
+  sql ("INSERT INTO config_scan_bundles"
+       " (config, config_modification_time, nvts_feed_version, creation_time)"
+       " SELECT id, modification_time,"
+       "        (SELECT value FROM %s.meta"
+       "         WHERE name = 'nvts_feed_version'),"
+       "        m_now ()"
+       " FROM configs WHERE id = %llu;",
+       sql_schema (),
+       config);
+
+  if (config_scan_bundle_values == NULL)
+    config_scan_bundle_values = g_string_new ("");
+  g_string_truncate (config_scan_bundle_values, 0);
+  config_scan_bundle_value_count = 0;
+  return 0;
+}
+
+/**
+ * @brief Insert the pending items of the scan bundle being built.
+ */
+static void
+config_scan_bundle_flush ()
+{
+  if (config_scan_bundle_value_count == 0)
+    return;
+
+  sql ("INSERT INTO config_scan_bundle_items"
+       " (config, kind, name, pref_id, value)"
+       " VALUES %s;",
+       config_scan_bundle_values->str);
+  g_string_truncate (config_scan_bundle_values, 0);
+  config_scan_bundle_value_count = 0;
+}
+
+/**
+ * @brief Add an item to the scan bundle being built.
+ *
+ * @param[in]  config   Config.
+ * @param[in]  kind     Kind of item.
+ * @param[in]  name     Scanner option name, VT group filter or VT OID.
+ * @param[in]  pref_id  VT preference ID, for CONFIG_SCAN_BUNDLE_VT_VALUE.
+ * @param[in]  value    Value of scanner option or VT preference.
+ */
+void
+config_scan_bundle_add (config_t config, config_scan_bundle_kind_t kind,
+                        const char *name, const char *pref_id,
+                        const char *value)
+{
+  gchar *quoted_name, *quoted_pref_id, *quoted_value;
+
+  quoted_name = sql_quote (name ? name : "");
+  quoted_pref_id = sql_quote (pref_id ? pref_id : "");
+  quoted_value = sql_quote (value ? value : "");
+
+  g_string_append_printf (config_scan_bundle_values,
+                          "%s(%llu, %i, '%s', '%s', '%s')",
+                          config_scan_bundle_value_count ? ", " : "",
+                          config,
+                          kind,
+                          quoted_name,
+                          quoted_pref_id,
+                          quoted_value);
+  g_free (quoted_name);
+  g_free (quoted_pref_id);
+  g_free (quoted_value);
+
+  if (++config_scan_bundle_value_count >= CONFIG_SCAN_BUNDLE_CHUNK)
+    config_scan_bundle_flush ();
+}
+
+/**
+ * @brief Finish building the scan bundle of a config.
+ */
+void
+config_scan_bundle_commit ()
+{
+  config_scan_bundle_flush ();
+  sql_commit ();
+}
+
+/**
+ * @brief Initialise an iterator over the items of a config's scan bundle.
+ *
+ * Items are returned in the order they were added.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  config    Config.
+ */
+void
+init_config_scan_bundle_iterator (iterator_t *iterator, config_t config)
+{
+  init_iterator (iterator,
+                 "SELECT kind, name, pref_id, value"
+                 " FROM config_scan_bundle_items"
+                 " WHERE config = %llu"
+                 " ORDER BY id;",
+                 config);
+}
+
+/**
+ * @brief Get the kind from a config scan bundle iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Kind of item.
+ */
+config_scan_bundle_kind_t
+config_scan_bundle_iterator_kind (iterator_t *iterator)
+{
+  if (iterator->done)
+    return CONFIG_SCAN_BUNDLE_SCANNER_OPTION;
+  return iterator_int (iterator, 0);
+}
+
+/**
+ * @brief Get the name from a config scan bundle iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Name, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (config_scan_bundle_iterator_name, 1);
+
+/**
+ * @brief Get the VT preference ID from a config scan bundle iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return VT preference ID, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (config_scan_bundle_iterator_pref_id, 2);
+
+/**
+ * @brief Get the value from a config scan bundle iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Value, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (config_scan_bundle_iterator_value, 3);
+
 /**
  * @brief Update a preference of a config.
  *
@@ -4276,6 +4540,8 @@ manage_set_config_nvts (config_t config, const char* family,
 
   quoted_selector = sql_quote (selector);
 
+  config_nvts_invalidate (config);
+
   /* If the family is growing, then exclude all no's, otherwise the family
    * is static, so include all yes's. */
 
@@ -4679,6 +4945,81 @@ update_config_preference (const char *config_id,
   g_free (quoted_value);
 }
 
+/**
+ * @brief Drop the materialized NVT membership of a config.
+ *
+ * The membership is rebuilt by config_nvts_ensure when it is next needed.
+ *
+ * @param[in]  config  Config.
+ */
+static void
+config_nvts_invalidate (config_t config)
+{
+  sql ("DELETE FROM config_nvts_built WHERE config = %llu;", config);
+  sql ("DELETE FROM config_nvts WHERE config = %llu;", config);
+}
+
+/**
+ * @brief Materialize the NVT membership of a config, if it is missing.
+ *
+ * The membership is expanded from the NVT selector in a single statement:
+ * NVT includes always select, otherwise NVT and family excludes drop, and
+ * otherwise a family include or the "all" selector selects.
+ *
+ * @param[in]  config  Config.
+ */
+void
+config_nvts_ensure (config_t config)
+{
+  char *selector;
+  gchar *quoted_selector;
+
+  if (sql_int ("SELECT count (*) FROM config_nvts_built"
+               " WHERE config = %llu;",
+               config))
+    return;
+
+  selector = config_nvt_selector (config);
+  if (selector == NULL)
+    return;
+  quoted_selector = sql_quote (selector);
+  free (selector);
+
+  sql ("DELETE FROM config_nvts WHERE config = %llu;", config);
+  sql ("INSERT INTO config_nvts (config, nvt, family)"
+       " SELECT %llu, oid, family FROM nvts"
+       " WHERE EXISTS (SELECT * FROM nvt_selectors"
+       "               WHERE name = '%s'"
+       "               AND type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
+       "               AND exclude = 0"
+       "               AND family_or_nvt = nvts.oid)"
+       " OR (NOT EXISTS (SELECT * FROM nvt_selectors"
+       "                 WHERE name = '%s'"
+       "                 AND exclude = 1"
+       "                 AND ((type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
+       "                       AND family_or_nvt = nvts.oid)"
+       "                      OR (type = "
+       G_STRINGIFY (NVT_SELECTOR_TYPE_FAMILY)
+       "                          AND family_or_nvt = nvts.family)))"
+       "     AND EXISTS (SELECT * FROM nvt_selectors"
+       "                 WHERE name = '%s'"
+       "                 AND exclude = 0"
+       "                 AND (type = " G_STRINGIFY (NVT_SELECTOR_TYPE_ALL)
+       "                      OR (type = "
+       G_STRINGIFY (NVT_SELECTOR_TYPE_FAMILY)
+       "                          AND family_or_nvt = nvts.family))))"
+       " ON CONFLICT DO NOTHING;",
+       config,
+       quoted_selector,
+       quoted_selector,
+       quoted_selector);
+  sql ("INSERT INTO config_nvts_built (config) VALUES (%llu)"
+       " ON CONFLICT DO NOTHING;",
+       config);
+
+  g_free (quoted_selector);
+}
+
 /**
  * @brief Update the cached count and growing information in a config.
  *
@@ -4693,6 +5034,8 @@ update_config_cache (iterator_t *configs)
   gchar *quoted_selector, *quoted_name;
   int families_growing;
 
+  config_nvts_invalidate (get_iterator_resource (configs));
+
   if (config_iterator_type (configs) > 0)
     return;
 
@@ -4915,6 +5258,8 @@ update_config (config_t config, const gchar *type, const gchar *name,
       free (selector_uuid);
     }
 
+  config_nvts_invalidate (config);
+
   /* Replace the preferences. */
 
   sql ("DELETE FROM config_preferences WHERE config = %llu;", config);
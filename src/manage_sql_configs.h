@@ -93,6 +93,9 @@ migrate_predefined_configs ();
 int
 config_updated_in_feed (config_t, const gchar *);
 
+void
+config_nvts_ensure (config_t);
+
 void
 update_config (config_t, const gchar *, const gchar *, const gchar *,
                const gchar *, int, const array_t*, const array_t*);
@@ -38,6 +38,7 @@
 #include <gvm/base/cvss.h>
 
 #include "manage_sql_nvts.h"
+#include "manage_metrics.h"
 #include "manage_preferences.h"
 #include "manage_sql.h"
 #include "manage_sql_configs.h"
@@ -116,6 +117,11 @@ check_osp_vt_update_socket ()
 
 /* NVT's. */
 
+/**
+ * @brief Whether a full rebuild has dropped the NVT indexes.
+ */
+static int nvt_indexes_dropped = 0;
+
 /**
  * @brief Ensures the sanity of nvts cache in DB.
  */
@@ -441,6 +447,8 @@ init_nvt_info_iterator (iterator_t* iterator, get_data_t *get, const char *name)
                            clause,
                            0);
 
+  if (ret == 0 && get->id == NULL && name == NULL)
+    iterator_use_cursor (iterator);
   g_free (clause);
   return ret;
 }
@@ -460,21 +468,6 @@ nvt_iterator_columns ()
   return columns;
 }
 
-/**
- * @brief Get NVT iterator SELECT columns.
- *
- * @return SELECT columns
- */
-static gchar *
-nvt_iterator_columns_nvts ()
-{
-  static column_t select_columns[] = NVT_ITERATOR_COLUMNS_NVTS;
-  static gchar *columns = NULL;
-  if (columns == NULL)
-    columns = columns_build_select (select_columns);
-  return columns;
-}
-
 /**
  * @brief Count number of nvt.
  *
@@ -539,193 +532,28 @@ static gchar *
 select_config_nvts (const config_t config, const char* family, int ascending,
                     const char* sort_field)
 {
-  gchar *quoted_selector, *quoted_family, *sql;
-  char *selector;
+  gchar *quoted_family, *sql;
 
-  selector = config_nvt_selector (config);
-  if (selector == NULL)
-    /* The config should always have a selector. */
-    return NULL;
-
-  quoted_selector = sql_quote (selector);
-  free (selector);
+  config_nvts_ensure (config);
 
   quoted_family = sql_quote (family);
 
-  if (config_nvts_growing (config))
-    {
-      int constraining;
-
-      /* The number of NVT's can increase. */
-
-      constraining = config_families_growing (config);
-
-      if (constraining)
-        {
-          /* Constraining the universe. */
-
-          if (sql_int ("SELECT COUNT(*) FROM nvt_selectors WHERE name = '%s';",
-                       quoted_selector)
-              == 1)
-            /* There is one selector, it should be the all selector. */
-            sql = g_strdup_printf
-                   ("SELECT %s"
-                    " FROM nvts WHERE family = '%s'"
-                    " ORDER BY %s %s;",
-                    nvt_iterator_columns (),
-                    quoted_family,
-                    sort_field ? sort_field : "name",
-                    ascending ? "ASC" : "DESC");
-          else
-            {
-              /* There are multiple selectors. */
-
-              if (sql_int ("SELECT COUNT(*) FROM nvt_selectors"
-                           " WHERE name = '%s' AND exclude = 1"
-                           " AND type = "
-                           G_STRINGIFY (NVT_SELECTOR_TYPE_FAMILY)
-                           " AND family_or_nvt = '%s'"
-                           ";",
-                           quoted_selector,
-                           quoted_family))
-                /* The family is excluded, just iterate the NVT includes. */
-                sql = g_strdup_printf
-                       ("SELECT %s"
-                        " FROM nvts, nvt_selectors"
-                        " WHERE"
-                        " nvts.family = '%s'"
-                        " AND nvt_selectors.name = '%s'"
-                        " AND nvt_selectors.family = '%s'"
-                        " AND nvt_selectors.type = "
-                        G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
-                        " AND nvt_selectors.exclude = 0"
-                        " AND nvts.oid = nvt_selectors.family_or_nvt"
-                        " ORDER BY %s %s;",
-                        nvt_iterator_columns_nvts (),
-                        quoted_family,
-                        quoted_selector,
-                        quoted_family,
-                        sort_field ? sort_field : "nvts.name",
-                        ascending ? "ASC" : "DESC");
-              else
-                /* The family is included.
-                 *
-                 * Iterate all NVT's minus excluded NVT's. */
-                sql = g_strdup_printf
-                       ("SELECT %s"
-                        " FROM nvts"
-                        " WHERE family = '%s'"
-                        " EXCEPT"
-                        " SELECT %s"
-                        " FROM nvt_selectors, nvts"
-                        " WHERE"
-                        " nvts.family = '%s'"
-                        " AND nvt_selectors.name = '%s'"
-                        " AND nvt_selectors.family = '%s'"
-                        " AND nvt_selectors.type = "
-                        G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
-                        " AND nvt_selectors.exclude = 1"
-                        " AND nvts.oid = nvt_selectors.family_or_nvt"
-                        " ORDER BY %s %s;",
-                        nvt_iterator_columns (),
-                        quoted_family,
-                        nvt_iterator_columns_nvts (),
-                        quoted_family,
-                        quoted_selector,
-                        quoted_family,
-                        /* This works around "ERROR: missing FROM-clause" from
-                         * Postgres when using nvts.name. */
-                        sort_field && strcmp (sort_field, "nvts.name")
-                         ? sort_field : "3", /* 3 is nvts.name. */
-                        ascending ? "ASC" : "DESC");
-            }
-        }
-      else
-        {
-          int all;
-
-          /* Generating from empty. */
-
-          all = sql_int ("SELECT COUNT(*) FROM nvt_selectors"
-                         " WHERE name = '%s' AND exclude = 0"
-                         " AND type = "
-                         G_STRINGIFY (NVT_SELECTOR_TYPE_FAMILY)
-                         " AND family_or_nvt = '%s';",
-                         quoted_selector,
-                         quoted_family);
-
-          if (all)
-            /* There is a family include for this family. */
-            sql = g_strdup_printf
-                   ("SELECT %s"
-                    " FROM nvts"
-                    " WHERE family = '%s'"
-                    " EXCEPT"
-                    " SELECT %s"
-                    " FROM nvt_selectors, nvts"
-                    " WHERE"
-                    " nvts.family = '%s'"
-                    " AND nvt_selectors.name = '%s'"
-                    " AND nvt_selectors.family = '%s'"
-                    " AND nvt_selectors.type = "
-                    G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
-                    " AND nvt_selectors.exclude = 1"
-                    " AND nvts.oid = nvt_selectors.family_or_nvt"
-                    " ORDER BY %s %s;",
-                    nvt_iterator_columns (),
-                    quoted_family,
-                    nvt_iterator_columns_nvts (),
-                    quoted_family,
-                    quoted_selector,
-                    quoted_family,
-                    /* This works around "ERROR: missing FROM-clause" from
-                     * Postgres when using nvts.name. */
-                    sort_field && strcmp (sort_field, "nvts.name")
-                     ? sort_field : "3", /* 3 is nvts.name. */
-                    ascending ? "ASC" : "DESC");
-          else
-            sql = g_strdup_printf
-                   (" SELECT %s"
-                    " FROM nvt_selectors, nvts"
-                    " WHERE"
-                    " nvts.family = '%s'"
-                    " AND nvt_selectors.name = '%s'"
-                    " AND nvt_selectors.family = '%s'"
-                    " AND nvt_selectors.type = "
-                    G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
-                    " AND nvt_selectors.exclude = 0"
-                    " AND nvts.oid = nvt_selectors.family_or_nvt"
-                    " ORDER BY %s %s;",
-                    nvt_iterator_columns_nvts (),
-                    quoted_family,
-                    quoted_selector,
-                    quoted_family,
-                    sort_field ? sort_field : "nvts.name",
-                    ascending ? "ASC" : "DESC");
-        }
-    }
-  else
-    {
-      /* The number of NVT's is static.  Assume a simple list of NVT
-       * includes. */
-
-      sql = g_strdup_printf
-             ("SELECT %s"
-              " FROM nvt_selectors, nvts"
-              " WHERE nvts.family = '%s'"
-              " AND nvt_selectors.exclude = 0"
-              " AND nvt_selectors.type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
-              " AND nvt_selectors.name = '%s'"
-              " AND nvts.oid = nvt_selectors.family_or_nvt"
-              " ORDER BY %s %s;",
-              nvt_iterator_columns_nvts (),
-              quoted_family,
-              quoted_selector,
-              sort_field ? sort_field : "nvts.id",
-              ascending ? "ASC" : "DESC");
-    }
+  sql = g_strdup_printf
+         ("SELECT %s"
+          " FROM nvts"
+          " WHERE family = '%s'"
+          " AND EXISTS (SELECT * FROM config_nvts"
+          "             WHERE config = %llu"
+          "             AND nvt = nvts.oid)"
+          " ORDER BY %s %s;",
+          nvt_iterator_columns (),
+          quoted_family,
+          config,
+          sort_field
+           ? sort_field
+           : (config_nvts_growing (config) ? "name" : "nvts.id"),
+          ascending ? "ASC" : "DESC");
 
-  g_free (quoted_selector);
   g_free (quoted_family);
 
   return sql;
@@ -843,6 +671,61 @@ init_cve_nvt_iterator (iterator_t* iterator, const char *cve, int ascending,
                  ascending ? "ASC" : "DESC");
 }
 
+/**
+ * @brief Initialise an iterator over the NVTs of some CVEs.
+ *
+ * Sorted by CVE, and by NVT name within each CVE.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  cves      Names of the CVEs.
+ */
+void
+init_cves_nvt_iterator (iterator_t *iterator, GPtrArray *cves)
+{
+  gchar *list;
+
+  list = nvt_oid_list_sql (cves);
+  init_iterator (iterator,
+                 "SELECT DISTINCT vt_refs.ref_id, nvts.oid, nvts.name"
+                 " FROM vt_refs, nvts"
+                 " WHERE vt_refs.type = 'cve'"
+                 " AND vt_refs.ref_id IN (%s)"
+                 " AND nvts.oid = vt_refs.vt_oid"
+                 " ORDER BY 1, 3 ASC;",
+                 list);
+  g_free (list);
+}
+
+/**
+ * @brief Get the CVE name from a CVEs NVT iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return CVE name, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (cves_nvt_iterator_cve, 0);
+
+/**
+ * @brief Get the NVT OID from a CVEs NVT iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return OID, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (cves_nvt_iterator_oid, 1);
+
+/**
+ * @brief Get the NVT name from a CVEs NVT iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Name, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (cves_nvt_iterator_name, 2);
+
 /**
  * @brief Get the OID from an NVT iterator.
  *
@@ -1024,6 +907,75 @@ nvt_default_timeout (const char* oid)
                      oid);
 }
 
+/**
+ * @brief Get a list of NVT OIDs for use in an SQL "IN" clause.
+ *
+ * @param[in]  oids  OIDs.
+ *
+ * @return Newly allocated comma separated list of quoted OIDs.
+ */
+gchar *
+nvt_oid_list_sql (GPtrArray *oids)
+{
+  GString *list;
+  guint index;
+
+  if (oids == NULL || oids->len == 0)
+    return g_strdup ("NULL");
+
+  list = g_string_new ("");
+  for (index = 0; index < oids->len; index++)
+    {
+      gchar *quoted_oid;
+
+      quoted_oid = sql_quote (g_ptr_array_index (oids, index));
+      g_string_append_printf (list, "%s'%s'", index ? ", " : "", quoted_oid);
+      g_free (quoted_oid);
+    }
+  return g_string_free (list, FALSE);
+}
+
+/**
+ * @brief Initialise an iterator over the default timeouts of some NVTs.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  oids      OIDs of NVTs.
+ */
+void
+init_nvt_default_timeout_iterator (iterator_t *iterator, GPtrArray *oids)
+{
+  gchar *list;
+
+  list = nvt_oid_list_sql (oids);
+  init_iterator (iterator,
+                 "SELECT split_part (name, ':', 1), value"
+                 " FROM nvt_preferences"
+                 " WHERE name LIKE '%%:0:entry:Timeout'"
+                 " AND split_part (name, ':', 1) IN (%s);",
+                 list);
+  g_free (list);
+}
+
+/**
+ * @brief Get the NVT OID from an NVT timeout iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return OID, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (nvt_timeout_iterator_oid, 0);
+
+/**
+ * @brief Get the timeout from an NVT timeout iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Timeout, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (nvt_timeout_iterator_value, 1);
+
 /**
  * @brief Get the family of an NVT.
  *
@@ -1084,25 +1036,6 @@ family_count ()
                   " WHERE family != 'Credentials';");
 }
 
-/**
- * @brief Insert a NVT preferences.
- *
- * @param[in] nvt_preference  Preference.
- * @param[in] dummy           Dummy arg for g_list_foreach.
- *
- */
-static void
-insert_nvt_preference (gpointer nvt_preference, gpointer dummy)
-{
-  preference_t *preference;
-
-  if (nvt_preference == NULL)
-    return;
-
-  preference = (preference_t*) nvt_preference;
-  manage_nvt_preference_add (preference->name, preference->value);
-}
-
 /**
  * @brief Inserts NVT preferences in DB from a list of nvt_preference_t structures.
  *
@@ -1111,7 +1044,35 @@ insert_nvt_preference (gpointer nvt_preference, gpointer dummy)
 static void
 insert_nvt_preferences_list (GList *nvt_preferences_list)
 {
-  g_list_foreach (nvt_preferences_list, insert_nvt_preference, NULL);
+  sql_batch_t *batch;
+  GList *point;
+
+  /* Send the preferences in batches instead of a round trip each. */
+  batch = sql_batch_begin ();
+  for (point = nvt_preferences_list; point; point = point->next)
+    {
+      preference_t *preference;
+      gchar *quoted_name, *quoted_value;
+
+      preference = (preference_t*) point->data;
+      if (preference == NULL
+          || preference->name == NULL
+          || strcmp (preference->name, "port_range") == 0)
+        continue;
+
+      quoted_name = sql_quote (preference->name);
+      quoted_value = sql_quote (preference->value ? preference->value : "");
+      sql_batch_add (batch,
+                     "DELETE FROM nvt_preferences WHERE name = '%s';",
+                     quoted_name);
+      sql_batch_add (batch,
+                     "INSERT into nvt_preferences (name, value)"
+                     " VALUES ('%s', '%s');",
+                     quoted_name, quoted_value);
+      g_free (quoted_name);
+      g_free (quoted_value);
+    }
+  sql_batch_end (batch);
 }
 
 /**
@@ -1478,37 +1439,258 @@ nvti_from_vt (entity_t vt)
 }
 
 /**
- * @brief Update NVTs from VTs XML.
+ * @brief Get the hash of a VT element, for detecting unchanged VTs.
  *
- * @param[in]  get_vts_response      OSP GET_VTS response.
- * @param[in]  scanner_feed_version  Version of feed from scanner.
+ * @param[in]  vt  OSP GET_VTS VT element.
  *
- * @return 0 success, 1 VT integrity check failed, -1 error
+ * @return Freshly allocated SHA256 hex string.
+ */
+static gchar *
+vt_hash (entity_t vt)
+{
+  GString *xml;
+  gchar *hash;
+
+  xml = g_string_new ("");
+  print_entity_to_string (vt, xml);
+  hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, xml->str, xml->len);
+  g_string_free (xml, TRUE);
+  return hash;
+}
+
+/**
+ * @brief Check whether a VT is already in the database as given.
+ *
+ * @param[in]  oid   OID of VT.
+ * @param[in]  hash  Hash of VT element, from vt_hash.
+ *
+ * @return 1 if the NVT exists with the same hash, else 0.
  */
 static int
-update_nvts_from_vts (entity_t *get_vts_response,
-                      const gchar *scanner_feed_version)
+vt_unchanged (const gchar *oid, const gchar *hash)
+{
+  gchar *quoted_oid;
+  int ret;
+
+  quoted_oid = sql_quote (oid);
+  ret = sql_int ("SELECT EXISTS (SELECT * FROM vt_hashes"
+                 "               WHERE vt_oid = '%s'"
+                 "               AND hash = '%s'"
+                 "               AND EXISTS (SELECT * FROM nvts"
+                 "                           WHERE oid = '%s'));",
+                 quoted_oid, hash, quoted_oid);
+  g_free (quoted_oid);
+  return ret;
+}
+
+/**
+ * @brief Record the hash of a VT after it has been written.
+ *
+ * @param[in]  oid   OID of VT.
+ * @param[in]  hash  Hash of VT element, from vt_hash.
+ */
+static void
+set_vt_hash (const gchar *oid, const gchar *hash)
+{
+  gchar *quoted_oid;
+
+  quoted_oid = sql_quote (oid);
+  sql ("INSERT INTO vt_hashes (vt_oid, hash) VALUES ('%s', '%s')"
+       " ON CONFLICT (vt_oid) DO UPDATE SET hash = EXCLUDED.hash;",
+       quoted_oid, hash);
+  g_free (quoted_oid);
+}
+
+/**
+ * @brief Update NVTs from one OSP GET_VTS response.
+ *
+ * @param[in]  get_vts_response     OSP GET_VTS response.
+ * @param[in]  skip_unchanged       Whether to skip VTs with an unchanged hash.
+ * @param[in]  feed_version_epoch   Old feed version, for counting new VTs.
+ * @param[out] count_new_vts        Incremented for each new VT.
+ * @param[out] count_modified_vts   Incremented for each modified VT.
+ * @param[out] count_unchanged_vts  Incremented for each skipped VT.
+ * @param[out] osp_vt_hash          VTs hash from the response, if any.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+update_nvts_from_vts_chunk (entity_t get_vts_response,
+                            gboolean skip_unchanged,
+                            time_t feed_version_epoch,
+                            int *count_new_vts,
+                            int *count_modified_vts,
+                            int *count_unchanged_vts,
+                            gchar **osp_vt_hash)
 {
   entity_t vts, vt;
   entities_t children;
   GList *preferences;
-  int count_modified_vts, count_new_vts;
-  time_t feed_version_epoch;
-  const char *osp_vt_hash;
-
-  count_modified_vts = 0;
-  count_new_vts = 0;
-
-  feed_version_epoch = nvts_feed_version_epoch();
+  const char *hash_attribute;
 
-  vts = entity_child (*get_vts_response, "vts");
+  vts = entity_child (get_vts_response, "vts");
   if (vts == NULL)
     {
       g_warning ("%s: VTS missing", __func__);
       return -1;
     }
 
-  osp_vt_hash = entity_attribute (vts, "sha256_hash");
+  hash_attribute = entity_attribute (vts, "sha256_hash");
+  if (hash_attribute)
+    {
+      g_free (*osp_vt_hash);
+      *osp_vt_hash = g_strdup (hash_attribute);
+    }
+
+  children = vts->entities;
+  while ((vt = first_entity (children)))
+    {
+      nvti_t *nvti = nvti_from_vt (vt);
+      gchar *hash;
+
+      if (nvti == NULL)
+        continue;
+
+      hash = vt_hash (vt);
+      if (skip_unchanged && vt_unchanged (nvti_oid (nvti), hash))
+        {
+          *count_unchanged_vts += 1;
+          g_free (hash);
+          nvti_free (nvti);
+          children = next_entities (children);
+          continue;
+        }
+
+      if (nvti_creation_time (nvti) > feed_version_epoch)
+        *count_new_vts += 1;
+      else
+        *count_modified_vts += 1;
+
+      insert_nvt (nvti);
+
+      preferences = NULL;
+      if (update_preferences_from_vt (vt, nvti_oid (nvti), &preferences))
+        {
+          g_free (hash);
+          nvti_free (nvti);
+          return -1;
+        }
+      sql ("DELETE FROM nvt_preferences WHERE name LIKE '%s:%%';",
+           nvti_oid (nvti));
+      insert_nvt_preferences_list (preferences);
+      g_list_free_full (preferences, g_free);
+
+      set_vt_hash (nvti_oid (nvti), hash);
+      g_free (hash);
+
+      nvti_free (nvti);
+      children = next_entities (children);
+    }
+
+  return 0;
+}
+
+/**
+ * @brief Get one chunk of VTs from the scanner.
+ *
+ * @param[in]  update_socket  Socket to use to contact scanner.
+ * @param[in]  filter         OSP VT filter, or NULL for all VTs.
+ * @param[out] vts            GET_VTS response.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+get_vts_chunk (const gchar *update_socket, const gchar *filter, entity_t *vts)
+{
+  osp_connection_t *connection;
+  osp_get_vts_opts_t get_vts_opts;
+  int ret;
+
+  connection = osp_connection_new (update_socket, 0, NULL, NULL, NULL);
+  if (!connection)
+    {
+      g_warning ("%s: failed to connect to %s", __func__, update_socket);
+      return -1;
+    }
+
+  g_debug ("%s: filter: %s", __func__, filter ? filter : "");
+
+  get_vts_opts = osp_get_vts_opts_default;
+  get_vts_opts.filter = (gchar *) filter;
+  ret = osp_get_vts_ext (connection, get_vts_opts, vts);
+  osp_connection_close (connection);
+  if (ret)
+    {
+      g_warning ("%s: failed to get VTs", __func__);
+      return -1;
+    }
+  return 0;
+}
+
+/**
+ * @brief Refresh the current severity mapping of the NVTs.
+ *
+ * Result queries with Dynamic Severity read the current severity of each
+ * NVT from this table instead of casting the cvss_base of the NVT per
+ * result.  Only rows where the severity changed are written.
+ */
+static void
+update_nvt_current_severities ()
+{
+  sql ("INSERT INTO nvt_current_severities (nvt, severity)"
+       " SELECT oid, CAST (nullif (cvss_base, '') AS double precision)"
+       " FROM nvts"
+       " ON CONFLICT (nvt) DO UPDATE SET severity = EXCLUDED.severity"
+       " WHERE nvt_current_severities.severity"
+       "       IS DISTINCT FROM EXCLUDED.severity;");
+
+  sql ("DELETE FROM nvt_current_severities"
+       " WHERE NOT EXISTS (SELECT * FROM nvts"
+       "                   WHERE nvts.oid = nvt_current_severities.nvt);");
+}
+
+/**
+ * @brief First year of the yearly VT chunks of a full update.
+ *
+ * VTs modified before this year are fetched together in the first chunk.
+ */
+#define VT_CHUNK_FIRST_YEAR 2008
+
+/**
+ * @brief Update NVTs from VTs via OSP.
+ *
+ * The VTs are fetched in chunks by modification year, so that only one
+ * chunk of the VT collection is held in memory at a time.
+ *
+ * Each VT is hashed, and VTs that are unchanged since they were last
+ * written are skipped, so that only changed NVT and preference rows are
+ * touched.
+ *
+ * @param[in]  update_socket         Socket to use to contact scanner.
+ * @param[in]  db_feed_version       Feed version from meta table.
+ * @param[in]  scanner_feed_version  Version of feed from scanner.
+ *
+ * @return 0 success, 1 VT integrity check failed, -1 error
+ */
+static int
+update_nvts_from_vts (const gchar *update_socket,
+                      const gchar *db_feed_version,
+                      const gchar *scanner_feed_version)
+{
+  int count_modified_vts, count_new_vts, count_unchanged_vts;
+  int year, first_year, last_year;
+  time_t feed_version_epoch, now;
+  struct tm tm;
+  gchar *osp_vt_hash, *lower;
+  gboolean skip_unchanged;
+
+  count_modified_vts = 0;
+  count_new_vts = 0;
+  count_unchanged_vts = 0;
+  skip_unchanged = TRUE;
+  osp_vt_hash = NULL;
+
+  feed_version_epoch = nvts_feed_version_epoch();
 
   sql_begin_immediate ();
 
@@ -1529,37 +1711,75 @@ update_nvts_from_vts (entity_t *get_vts_response,
      * duplicate when the name of the old version was corrected.
      *
      * To solve both cases, we remove all nvt_preferences. */
-    sql ("TRUNCATE nvt_preferences;");
-
-  children = vts->entities;
-  while ((vt = first_entity (children)))
     {
-      nvti_t *nvti = nvti_from_vt (vt);
+      sql ("TRUNCATE nvt_preferences;");
+      skip_unchanged = FALSE;
+    }
 
-      if (nvti == NULL)
-        continue;
+  /* Chunk boundaries are the starts of years, in the same format as the
+   * feed version.  Each chunk covers the VTs modified after its lower
+   * boundary, up to and including its upper boundary. */
 
-      if (nvti_creation_time (nvti) > feed_version_epoch)
-        count_new_vts += 1;
+  now = time (NULL);
+  localtime_r (&now, &tm);
+  last_year = tm.tm_year + 1900;
+
+  if (db_feed_version)
+    {
+      lower = g_strdup_printf ("modification_time>%s", db_feed_version);
+      if (sscanf (db_feed_version, "%4d", &first_year) == 1)
+        first_year++;
       else
-        count_modified_vts += 1;
+        first_year = VT_CHUNK_FIRST_YEAR;
+    }
+  else
+    {
+      lower = NULL;
+      first_year = VT_CHUNK_FIRST_YEAR;
+    }
+  if (first_year < VT_CHUNK_FIRST_YEAR)
+    first_year = VT_CHUNK_FIRST_YEAR;
 
-      insert_nvt (nvti);
+  for (year = first_year; year <= last_year + 1; year++)
+    {
+      entity_t vts;
+      gchar *filter;
+      int ret;
+
+      if (year > last_year)
+        /* Last chunk, open ended. */
+        filter = g_strdup (lower);
+      else if (lower)
+        filter = g_strdup_printf ("%s;modification_time<%04d0101000001",
+                                  lower, year);
+      else
+        filter = g_strdup_printf ("modification_time<%04d0101000001", year);
 
-      preferences = NULL;
-      if (update_preferences_from_vt (vt, nvti_oid (nvti), &preferences))
+      vts = NULL;
+      ret = get_vts_chunk (update_socket, filter, &vts);
+      g_free (filter);
+      if (ret == 0)
+        {
+          ret = update_nvts_from_vts_chunk (vts, skip_unchanged,
+                                            feed_version_epoch,
+                                            &count_new_vts,
+                                            &count_modified_vts,
+                                            &count_unchanged_vts,
+                                            &osp_vt_hash);
+          free_entity (vts);
+        }
+      if (ret)
         {
+          g_free (lower);
+          g_free (osp_vt_hash);
           sql_rollback ();
           return -1;
         }
-      sql ("DELETE FROM nvt_preferences WHERE name LIKE '%s:%%';",
-           nvti_oid (nvti));
-      insert_nvt_preferences_list (preferences);
-      g_list_free_full (preferences, g_free);
 
-      nvti_free (nvti);
-      children = next_entities (children);
+      g_free (lower);
+      lower = g_strdup_printf ("modification_time>%04d0101000000", year);
     }
+  g_free (lower);
 
   set_nvts_check_time (count_new_vts, count_modified_vts);
 
@@ -1571,8 +1791,20 @@ update_nvts_from_vts (entity_t *get_vts_response,
                __func__);
   update_all_config_caches ();
 
-  g_info ("Updating VTs in database ... %i new VTs, %i changed VTs",
-          count_new_vts, count_modified_vts);
+  if (nvt_indexes_dropped)
+    {
+      create_indexes_nvt ();
+      sql ("ANALYZE nvts;");
+      sql ("ANALYZE vt_refs;");
+      sql ("ANALYZE vt_severities;");
+      nvt_indexes_dropped = 0;
+    }
+
+  update_nvt_current_severities ();
+
+  g_info ("Updating VTs in database ... %i new VTs, %i changed VTs,"
+          " %i unchanged VTs skipped",
+          count_new_vts, count_modified_vts, count_unchanged_vts);
 
   sql_commit ();
 
@@ -1631,6 +1863,7 @@ update_nvts_from_vts (entity_t *get_vts_response,
                      __func__, db_vts_hash, osp_vt_hash);
 
           g_free (db_vts_hash);
+          g_free (osp_vt_hash);
           return 1;
         }
 
@@ -1640,6 +1873,7 @@ update_nvts_from_vts (entity_t *get_vts_response,
     g_warning ("%s: No SHA-256 hash received from scanner, skipping check.",
                __func__);
 
+  g_free (osp_vt_hash);
   return 0;
 }
 
@@ -1758,6 +1992,38 @@ init_nvt_severity_iterator (iterator_t* iterator, const char *oid)
   g_free (quoted_oid);
 }
 
+/**
+ * @brief Initialise an NVT severity iterator over some NVTs.
+ *
+ * The NVT severity iterator accessors work on this iterator too.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  oids      OIDs of NVTs.
+ */
+void
+init_nvts_severity_iterator (iterator_t* iterator, GPtrArray *oids)
+{
+  gchar *list;
+
+  list = nvt_oid_list_sql (oids);
+  init_iterator (iterator,
+                 "SELECT type, origin, iso_time(date), score, value, vt_oid"
+                 " FROM vt_severities"
+                 " WHERE vt_oid IN (%s)"
+                 " ORDER BY vt_oid;",
+                 list);
+  g_free (list);
+}
+
+/**
+ * @brief Gets the NVT OID from an NVT severity iterator over some NVTs.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return The OID of the NVT.
+ */
+DEF_ACCESS (nvt_severity_iterator_oid, 5);
+
 /**
  * @brief Gets the type from an NVT severity iterator.
  *
@@ -1822,8 +2088,6 @@ update_nvt_cache_osp (const gchar *update_socket, gchar *db_feed_version,
 {
   osp_connection_t *connection;
   GSList *scanner_prefs;
-  entity_t vts;
-  osp_get_vts_opts_t get_vts_opts;
   time_t old_nvts_last_modified;
   int ret;
 
@@ -1835,30 +2099,8 @@ update_nvt_cache_osp (const gchar *update_socket, gchar *db_feed_version,
     old_nvts_last_modified
       = (time_t) sql_int64_0 ("SELECT max(modification_time) FROM nvts");
 
-  connection = osp_connection_new (update_socket, 0, NULL, NULL, NULL);
-  if (!connection)
-    {
-      g_warning ("%s: failed to connect to %s (2)", __func__,
-                 update_socket);
-      return -1;
-    }
-
-  get_vts_opts = osp_get_vts_opts_default;
-  if (db_feed_version)
-    get_vts_opts.filter = g_strdup_printf ("modification_time>%s", db_feed_version);
-  else
-    get_vts_opts.filter = NULL;
-  if (osp_get_vts_ext (connection, get_vts_opts, &vts))
-    {
-      g_warning ("%s: failed to get VTs", __func__);
-      g_free (get_vts_opts.filter);
-      return -1;
-    }
-  g_free (get_vts_opts.filter);
-
-  osp_connection_close (connection);
-  ret = update_nvts_from_vts (&vts, scanner_feed_version);
-  free_entity (vts);
+  ret = update_nvts_from_vts (update_socket, db_feed_version,
+                              scanner_feed_version);
   if (ret)
     return ret;
 
@@ -2080,13 +2322,19 @@ manage_update_nvt_cache_osp (const gchar *update_socket)
                                            &scanner_feed_version);
   if (ret == 1)
     {
+      gint64 start;
+
       g_info ("OSP service has different VT status (version %s)"
               " from database (version %s, %i VTs). Starting update ...",
               scanner_feed_version, db_feed_version,
               sql_int ("SELECT count (*) FROM nvts;"));
 
+      start = g_get_monotonic_time ();
       ret = update_nvt_cache_osp (update_socket, db_feed_version,
                                   scanner_feed_version);
+      if (ret == 0)
+        metrics_set (METRIC_FEED_SYNC_TIME_NVT,
+                     g_get_monotonic_time () - start);
 
       g_free (db_feed_version);
       g_free (scanner_feed_version);
@@ -2163,12 +2411,18 @@ update_or_rebuild_nvts (int update)
 
   if (update == 0)
     {
-      sql ("TRUNCATE nvts;");
-      sql ("TRUNCATE nvt_preferences;");
+      /* Loading into empty tables without the indexes and building them
+       * afterwards is much faster than maintaining the indexes row by row.
+       * update_nvts_from_vts rebuilds them before it commits the new NVTs. */
+      sql ("TRUNCATE nvts, vt_refs, vt_severities, nvt_preferences,"
+           "         vt_hashes;");
+      drop_indexes_nvt ();
+      nvt_indexes_dropped = 1;
       set_nvts_feed_version ("0");
     }
 
   ret = update_nvt_cache_osp (osp_update_socket, NULL, scanner_feed_version);
+  nvt_indexes_dropped = 0;
   if (ret)
     {
       return -1;
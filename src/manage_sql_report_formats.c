@@ -39,9 +39,15 @@
 #include <pwd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <libxml/parser.h>
+#include <libxslt/security.h>
+#include <libxslt/transform.h>
+#include <libxslt/xsltInternals.h>
+#include <libxslt/xsltutils.h>
 
 #include <gvm/base/proctitle.h>
 #include <gvm/util/uuidutils.h>
@@ -3275,6 +3281,342 @@ verify_report_format (const char *report_format_id)
   return 0;
 }
 
+/**
+ * @brief Maximum number of report format scripts running at once across
+ *        all Manager processes, 0 for no limit.
+ */
+static int report_format_workers = REPORT_FORMAT_WORKERS_DEFAULT;
+
+/**
+ * @brief CPU time limit in seconds for a report format script, 0 for none.
+ */
+static int report_format_cpu_limit = REPORT_FORMAT_CPU_LIMIT_DEFAULT;
+
+/**
+ * @brief Memory limit in MiB for a report format script, 0 for none.
+ */
+static int report_format_memory_limit = REPORT_FORMAT_MEMORY_LIMIT_DEFAULT;
+
+/**
+ * @brief Set the maximum number of report format scripts running at once.
+ *
+ * @param[in]  new_workers  Number of scripts, 0 for no limit.
+ */
+void
+set_report_format_workers (int new_workers)
+{
+  if (new_workers < 0)
+    report_format_workers = 0;
+  else
+    report_format_workers = new_workers;
+}
+
+/**
+ * @brief Set the CPU time limit of report format scripts.
+ *
+ * @param[in]  new_limit  Limit in seconds, 0 for none.
+ */
+void
+set_report_format_cpu_limit (int new_limit)
+{
+  if (new_limit < 0)
+    report_format_cpu_limit = 0;
+  else
+    report_format_cpu_limit = new_limit;
+}
+
+/**
+ * @brief Set the memory limit of report format scripts.
+ *
+ * @param[in]  new_limit  Limit in MiB, 0 for none.
+ */
+void
+set_report_format_memory_limit (int new_limit)
+{
+  if (new_limit < 0)
+    report_format_memory_limit = 0;
+  else
+    report_format_memory_limit = new_limit;
+}
+
+/**
+ * @brief Wait for a free report format slot.
+ *
+ * The slots are lock files shared by all Manager processes, so at most
+ * report_format_workers scripts run at once.  Others wait here in turn.
+ *
+ * @param[out]  slot  Lock of the slot, to be released with lockfile_unlock.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+report_format_slot_lock (lockfile_t *slot)
+{
+  gboolean waiting;
+
+  slot->name = NULL;
+  if (report_format_workers == 0)
+    return 0;
+
+  waiting = FALSE;
+  while (1)
+    {
+      int index;
+
+      for (index = 0; index < report_format_workers; index++)
+        {
+          gchar *name;
+          int ret;
+
+          name = g_strdup_printf ("gvm-report-format-%i", index);
+          ret = lockfile_lock_nb (slot, name);
+          g_free (name);
+          if (ret == 0)
+            {
+              if (waiting)
+                g_debug ("%s: got slot %i", __func__, index);
+              return 0;
+            }
+          if (ret == -1)
+            return -1;
+        }
+
+      if (waiting == FALSE)
+        {
+          g_debug ("%s: all %i slots are busy, waiting",
+                   __func__, report_format_workers);
+          waiting = TRUE;
+        }
+      g_usleep (G_USEC_PER_SEC / 4);
+    }
+}
+
+/**
+ * @brief A report format stylesheet, compiled for in-process use.
+ */
+typedef struct
+{
+  gchar *modification_time;     ///< Modification time of report format.
+  time_t file_time;             ///< Modification time of generate script.
+  xsltStylesheetPtr stylesheet; ///< Stylesheet, NULL if not plain XSL.
+} report_format_xsl_t;
+
+/**
+ * @brief Compiled stylesheets of report formats, keyed by report format UUID.
+ */
+static GHashTable *report_format_xsl_cache = NULL;
+
+/**
+ * @brief Free a cached report format stylesheet.
+ *
+ * @param[in]  data  Cached stylesheet.
+ */
+static void
+report_format_xsl_free (gpointer data)
+{
+  report_format_xsl_t *xsl = data;
+
+  g_free (xsl->modification_time);
+  if (xsl->stylesheet)
+    xsltFreeStylesheet (xsl->stylesheet);
+  g_free (xsl);
+}
+
+/**
+ * @brief Get the stylesheet of a generate script that only runs xsltproc.
+ *
+ * Many report formats have a generate script of the form
+ *
+ *     xsltproc FORMAT.xsl "$1"
+ *
+ * which can be run in the process instead of in a shell.
+ *
+ * @param[in]  script      Path of generate script.
+ * @param[in]  script_dir  Directory of the script.
+ *
+ * @return Freshly allocated path of the stylesheet, or NULL if the script
+ *         does more than that.
+ */
+static gchar *
+report_format_script_stylesheet (const gchar *script, const gchar *script_dir)
+{
+  gchar *contents, **lines, **line, *stylesheet;
+
+  if (g_file_get_contents (script, &contents, NULL, NULL) == FALSE)
+    return NULL;
+
+  stylesheet = NULL;
+  lines = g_strsplit (contents, "\n", 0);
+  g_free (contents);
+  for (line = lines; *line; line++)
+    {
+      gchar **argv;
+      gint argc;
+
+      g_strstrip (*line);
+      if (**line == '\0' || **line == '#')
+        continue;
+
+      if (stylesheet
+          || g_shell_parse_argv (*line, &argc, &argv, NULL) == FALSE)
+        {
+          /* More than one command, or something the shell would have to
+           * interpret. */
+          g_free (stylesheet);
+          stylesheet = NULL;
+          break;
+        }
+
+      if (argc == 3
+          && strcmp (argv[0], "xsltproc") == 0
+          && g_str_has_suffix (argv[1], ".xsl")
+          && strcmp (argv[2], "$1") == 0)
+        stylesheet = g_path_is_absolute (argv[1])
+                      ? g_strdup (argv[1])
+                      : g_build_filename (script_dir, argv[1], NULL);
+      g_strfreev (argv);
+
+      if (stylesheet == NULL)
+        break;
+    }
+  g_strfreev (lines);
+
+  return stylesheet;
+}
+
+/**
+ * @brief Get the compiled stylesheet of a report format.
+ *
+ * The stylesheet is compiled once per process, and recompiled when the
+ * report format or its generate script changes.
+ *
+ * @param[in]  report_format_id   UUID of the report format.
+ * @param[in]  modification_time  Modification time of the report format.
+ * @param[in]  script             Path of the generate script.
+ * @param[in]  script_dir         Directory of the script.
+ *
+ * @return Stylesheet, or NULL if the report format must run its script.
+ */
+static xsltStylesheetPtr
+report_format_xsl (const gchar *report_format_id,
+                   const gchar *modification_time,
+                   const gchar *script,
+                   const gchar *script_dir)
+{
+  report_format_xsl_t *xsl;
+  struct stat state;
+  gchar *stylesheet_file;
+
+  if (g_stat (script, &state))
+    return NULL;
+
+  if (report_format_xsl_cache == NULL)
+    report_format_xsl_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                     g_free,
+                                                     report_format_xsl_free);
+
+  xsl = g_hash_table_lookup (report_format_xsl_cache, report_format_id);
+  if (xsl
+      && xsl->file_time == state.st_mtime
+      && g_strcmp0 (xsl->modification_time, modification_time) == 0)
+    return xsl->stylesheet;
+
+  xsl = g_malloc0 (sizeof (*xsl));
+  xsl->modification_time = g_strdup (modification_time);
+  xsl->file_time = state.st_mtime;
+
+  stylesheet_file = report_format_script_stylesheet (script, script_dir);
+  if (stylesheet_file)
+    {
+      xsl->stylesheet = xsltParseStylesheetFile
+                         ((const xmlChar *) stylesheet_file);
+      if (xsl->stylesheet == NULL)
+        g_warning ("%s: Failed to parse stylesheet %s, running script",
+                   __func__, stylesheet_file);
+      g_free (stylesheet_file);
+    }
+
+  g_hash_table_replace (report_format_xsl_cache,
+                        g_strdup (report_format_id),
+                        xsl);
+  return xsl->stylesheet;
+}
+
+/**
+ * @brief Apply a compiled report format stylesheet to a report.
+ *
+ * The transformation may read files, for example for xsl:include, but
+ * may not write files or use the network.
+ *
+ * @param[in]  stylesheet   Stylesheet.
+ * @param[in]  xml_file     Path of the report XML.
+ * @param[in]  output_file  Path to write the report to.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+report_format_xsl_apply (xsltStylesheetPtr stylesheet,
+                         const gchar *xml_file,
+                         const gchar *output_file)
+{
+  static xsltSecurityPrefsPtr security = NULL;
+  xmlDocPtr doc, result;
+  xsltTransformContextPtr context;
+  int ret;
+
+  if (security == NULL)
+    {
+      security = xsltNewSecurityPrefs ();
+      xsltSetSecurityPrefs (security, XSLT_SECPREF_WRITE_FILE,
+                            xsltSecurityForbid);
+      xsltSetSecurityPrefs (security, XSLT_SECPREF_CREATE_DIRECTORY,
+                            xsltSecurityForbid);
+      xsltSetSecurityPrefs (security, XSLT_SECPREF_READ_NETWORK,
+                            xsltSecurityForbid);
+      xsltSetSecurityPrefs (security, XSLT_SECPREF_WRITE_NETWORK,
+                            xsltSecurityForbid);
+    }
+
+  doc = xmlReadFile (xml_file, NULL, XML_PARSE_HUGE | XML_PARSE_NONET);
+  if (doc == NULL)
+    {
+      g_warning ("%s: Failed to parse %s", __func__, xml_file);
+      return -1;
+    }
+
+  context = xsltNewTransformContext (stylesheet, doc);
+  if (context == NULL
+      || xsltSetCtxtSecurityPrefs (security, context))
+    {
+      g_warning ("%s: Failed to set up transform", __func__);
+      if (context)
+        xsltFreeTransformContext (context);
+      xmlFreeDoc (doc);
+      return -1;
+    }
+
+  result = xsltApplyStylesheetUser (stylesheet, doc, NULL, NULL, NULL,
+                                    context);
+  if (result == NULL || context->state != XSLT_STATE_OK)
+    {
+      g_warning ("%s: Failed to transform %s", __func__, xml_file);
+      ret = -1;
+    }
+  else if (xsltSaveResultToFilename (output_file, result, stylesheet, 0) < 0)
+    {
+      g_warning ("%s: Failed to write %s", __func__, output_file);
+      ret = -1;
+    }
+  else
+    ret = 0;
+
+  if (result)
+    xmlFreeDoc (result);
+  xsltFreeTransformContext (context);
+  xmlFreeDoc (doc);
+  return ret;
+}
+
 /**
  * @brief Runs the script of a report format.
  *
@@ -3295,10 +3637,12 @@ run_report_format_script (gchar *report_format_id,
 {
   iterator_t formats;
   report_format_t report_format;
-  gchar *script, *script_dir, *owner;
+  gchar *script, *script_dir, *owner, *modification_time;
   get_data_t report_format_get;
+  xsltStylesheetPtr stylesheet;
 
   gchar *command;
+  GString *limits;
   char *previous_dir;
   int ret;
 
@@ -3315,6 +3659,7 @@ run_report_format_script (gchar *report_format_id,
     }
 
   report_format = get_iterator_resource (&formats);
+  modification_time = g_strdup (get_iterator_modification_time (&formats));
 
   owner = sql_string ("SELECT uuid FROM users"
                       " WHERE id = (SELECT owner FROM"
@@ -3335,6 +3680,7 @@ run_report_format_script (gchar *report_format_id,
     {
       g_warning ("%s: No generate script found at %s",
                  __func__, script);
+      g_free (modification_time);
       g_free (script);
       g_free (script_dir);
       return -1;
@@ -3343,11 +3689,19 @@ run_report_format_script (gchar *report_format_id,
     {
       g_warning ("%s: script %s is not executable",
                  __func__, script);
+      g_free (modification_time);
       g_free (script);
       g_free (script_dir);
       return -1;
     }
 
+  /* Scripts that only run xsltproc are applied in the process, with the
+   * stylesheet compiled once. */
+
+  stylesheet = report_format_xsl (report_format_id, modification_time,
+                                  script, script_dir);
+  g_free (modification_time);
+
   /* Change into the script directory. */
 
   previous_dir = getcwd (NULL, 0);
@@ -3376,12 +3730,22 @@ run_report_format_script (gchar *report_format_id,
 
   /* Call the script. */
 
-  command = g_strdup_printf ("%s %s '%s' > %s"
+  limits = g_string_new ("");
+  if (report_format_cpu_limit)
+    g_string_append_printf (limits, "ulimit -t %i; ",
+                            report_format_cpu_limit);
+  if (report_format_memory_limit)
+    g_string_append_printf (limits, "ulimit -v %lli; ",
+                            (long long) report_format_memory_limit * 1024);
+
+  command = g_strdup_printf ("%s%s %s '%s' > %s"
                              " 2> /dev/null",
+                             limits->str,
                              script,
                              xml_file,
                              report_format_extra,
                              output_file);
+  g_string_free (limits, TRUE);
   g_free (script);
 
   g_debug ("   command: %s", command);
@@ -3438,6 +3802,14 @@ run_report_format_script (gchar *report_format_id,
                   exit (EXIT_FAILURE);
                 }
 
+              if (stylesheet)
+                {
+                  if (report_format_xsl_apply (stylesheet, xml_file,
+                                               output_file))
+                    exit (EXIT_FAILURE);
+                  exit (EXIT_SUCCESS);
+                }
+
               ret = system (command);
               /* Report scripts should return 0 since version 21.04 */
               if (ret == -1 || WIFEXITED(ret) == 0 || WEXITSTATUS(ret))
@@ -3539,7 +3911,10 @@ run_report_format_script (gchar *report_format_id,
     {
       /* Just run the command as the current user. */
 
-      ret = system (command);
+      if (stylesheet)
+        ret = report_format_xsl_apply (stylesheet, xml_file, output_file);
+      else
+        ret = system (command);
       /* Report scripts should return 0 since version 21.04 */
       if (ret == -1 || WIFEXITED(ret) == 0 || WEXITSTATUS(ret))
         {
@@ -3658,6 +4033,7 @@ apply_report_format (gchar *report_format_id,
   gchar *rf_dependencies_string, *output_file, *out_file_part, *out_file_ext;
   gchar *files_xml;
   int output_fd;
+  lockfile_t slot;
 
   assert (report_format_id);
   assert (xml_start);
@@ -3839,8 +4215,12 @@ apply_report_format (gchar *report_format_id,
       goto cleanup;
     }
 
-  run_report_format_script (report_format_id,
-                            xml_file, xml_dir, files_xml, output_file);
+  if (report_format_slot_lock (&slot) == 0)
+    {
+      run_report_format_script (report_format_id,
+                                xml_file, xml_dir, files_xml, output_file);
+      lockfile_unlock (&slot);
+    }
 
   /* Clean up and return filename. */
  cleanup:
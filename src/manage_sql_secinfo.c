@@ -28,6 +28,7 @@
  */
 #define _GNU_SOURCE
 
+#include "manage_metrics.h"
 #include "manage_sql.h"
 #include "manage_sql_secinfo.h"
 #include "sql.h"
@@ -40,16 +41,20 @@
 #include <ftw.h>
 #include <glib/gstdio.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/file.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <gvm/base/proctitle.h>
 #include <gvm/util/fileutils.h>
 
+#include <libxml/xmlreader.h>
+
 #undef G_LOG_DOMAIN
 /**
  * @brief GLib log domain.
@@ -69,6 +74,28 @@
  */
 static int secinfo_commit_size = SECINFO_COMMIT_SIZE_DEFAULT;
 
+/**
+ * @brief Number of worker processes that load SCAP files.
+ */
+static int scap_workers = SCAP_WORKERS_DEFAULT;
+
+/**
+ * @brief Whether CVE products go to the staging table.
+ *
+ * Set while CVE files are loaded by parallel workers, because inserting
+ * the products straight into scap2.cpes from several workers could
+ * deadlock on the CPE rows.
+ */
+static gboolean cve_products_staged = FALSE;
+
+/**
+ * @brief Modification times of the CVEs carried over from the previous data.
+ *
+ * Set while the CVE files are loaded during an incremental SCAP update, so
+ * that entries that have not changed can be skipped.  NULL otherwise.
+ */
+static GHashTable *previous_cves = NULL;
+
 
 /* Headers. */
 
@@ -184,124 +211,130 @@ increment_transaction_size (int* current_size)
 }
 
 /**
- * @brief Split a file.
- *
- * @param[in]  path  Path to file.
- * @param[in]  size  Approx size of split files.  In same format that
- *                   xml_split accepts, eg "200Kb".
- * @param[in]  tail  Text to replace last line of split files.
+ * @brief Reader for the entries of a SecInfo XML file.
  *
- * @return Temp dir holding split files.
+ * Reads the file as a stream, expanding one entry at a time, so memory use
+ * does not depend on the size of the file.
  */
-static const gchar *
-split_xml_file (gchar *path, const gchar *size, const gchar *tail)
+typedef struct
 {
-  int ret;
-  static gchar dir[] = "/tmp/gvmd-split-xml-file-XXXXXX";
-  gchar *previous_dir, *command;
+  xmlTextReaderPtr reader;  ///< libxml2 reader.
+  const gchar *root_name;   ///< Expected name of root element, or NULL.
+  const gchar *entry_name;  ///< Name of entry elements.
+  gboolean in_entry;        ///< Whether the reader is on an entry.
+  gboolean error;           ///< Whether reading failed.
+} entry_reader_t;
 
-  if (mkdtemp (dir) == NULL)
+/**
+ * @brief Open an entry reader on a file.
+ *
+ * @param[in]  reader      Reader.
+ * @param[in]  path        Path to file.
+ * @param[in]  root_name   Expected name of root element, or NULL.
+ * @param[in]  entry_name  Name of entry elements, the children of the root.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+entry_reader_open (entry_reader_t *reader, const gchar *path,
+                   const gchar *root_name, const gchar *entry_name)
+{
+  memset (reader, 0, sizeof (*reader));
+  reader->reader = xmlReaderForFile (path, NULL, XML_PARSE_HUGE);
+  if (reader->reader == NULL)
     {
-      g_warning ("%s: Failed to make temp dir: %s",
-                 __func__,
-                 strerror (errno));
-      return NULL;
+      g_warning ("%s: Failed to open %s", __func__, path);
+      return -1;
     }
+  reader->root_name = root_name;
+  reader->entry_name = entry_name;
+  return 0;
+}
 
-  previous_dir = getcwd (NULL, 0);
-  if (previous_dir == NULL)
-    {
-      g_warning ("%s: Failed to getcwd: %s",
-                 __func__,
-                 strerror (errno));
-      return NULL;
-    }
+/**
+ * @brief Get the next entry from an entry reader.
+ *
+ * The entry is only valid until the next call.
+ *
+ * @param[in]  reader  Reader.
+ *
+ * @return Next entry, or NULL when done or on error (see reader->error).
+ */
+static element_t
+entry_reader_next (entry_reader_t *reader)
+{
+  int ret;
 
-  if (chdir (dir))
-    {
-      g_warning ("%s: Failed to chdir: %s",
-                 __func__,
-                 strerror (errno));
-      g_free (previous_dir);
-      return NULL;
-    }
+  /* Skip the previous entry, so that the reader frees it. */
+  if (reader->in_entry)
+    ret = xmlTextReaderNext (reader->reader);
+  else
+    ret = xmlTextReaderRead (reader->reader);
+  reader->in_entry = FALSE;
 
-  if (gvm_file_copy (path, "split.xml") == FALSE)
+  while (ret == 1)
     {
-      g_free (previous_dir);
-      return NULL;
-    }
+      if (xmlTextReaderNodeType (reader->reader) == XML_READER_TYPE_ELEMENT)
+        {
+          const char *name;
+          int depth;
 
-  /* xml_split will chop split.xml into files that are roughly 'size' big.
-   *
-   * The generated files are always put in the directory that holds
-   * split.xml, as follows:
-   *
-   * split.xml      Source XML.
-   * split-00.xml   Master generated XML.  No content, just includes other
-   *                files.  The include statements are wrapped in the
-   *                root element from split.xml.
-   * split-01.xml   Generated XML content.  Wrapped in an <xml_split:root>
-   *                element.
-   * split-02.xml   Second generated content file.
-   * ...
-   * split-112.xml  Last content, for example.
-   *
-   * Parsing the generated files independently will only work if the files
-   * contain the original root element (for example, because the parser
-   * requires the namespace definitions to be present).
-   *
-   * So the command below needs to mess around a little bit to replace the
-   * wrapper XML element in split-01.xml, split-02.xml, etc with the root
-   * element from split-00.xml.
-   *
-   * Using tail and head is not super robust, but it's simple and it will
-   * work as long as xml_split keeps the opening of the wrapper element
-   * in split-00.xml on a dedicated line.  (It doesn't do this for the
-   * closing element, so we use the tail argument instead.)
-   */
-
-  command = g_strdup_printf
-             ("xml_split -s%s split.xml"
-              " && head -n 2 split-00.xml > head.xml"
-              " && echo '%s' > tail.xml"
-              " && for F in split-*.xml; do"
-              /*   Remove the first two lines and last line. */
-              "    awk 'NR>3 {print last} {last=$0}' $F > body.xml"
-              /*   Combine with new start and end. */
-              "    && cat head.xml body.xml tail.xml > $F;"
-              "    done",
-              size,
-              tail);
-
-  g_debug ("%s: command: %s", __func__, command);
-  ret = system (command);
-  if ((ret == -1) || WIFEXITED(ret) == 0 || WEXITSTATUS (ret))
-    {
-      g_warning ("%s: system failed with ret %i, %i (%i), %s",
-                 __func__,
-                 ret,
-                 WIFEXITED (ret),
-                 WIFEXITED (ret) ? WEXITSTATUS (ret) : 0,
-                 command);
-      g_free (command);
+          name = (const char *) xmlTextReaderConstLocalName (reader->reader);
+          depth = xmlTextReaderDepth (reader->reader);
 
-      if (chdir (previous_dir))
-        g_warning ("%s: and failed to chdir back", __func__);
-      g_free (previous_dir);
+          if (depth == 0
+              && reader->root_name
+              && strcmp (name, reader->root_name))
+            {
+              g_warning ("%s: Root element is %s instead of %s",
+                         __func__, name, reader->root_name);
+              reader->error = TRUE;
+              return NULL;
+            }
 
-      return NULL;
-    }
+          if (depth == 1)
+            {
+              xmlNodePtr node;
 
-  g_free (command);
+              if (strcmp (name, reader->entry_name))
+                {
+                  ret = xmlTextReaderNext (reader->reader);
+                  continue;
+                }
 
-  if (chdir (previous_dir))
-    g_warning ("%s: Failed to chdir back (will continue anyway)",
-               __func__);
+              node = xmlTextReaderExpand (reader->reader);
+              if (node == NULL)
+                {
+                  g_warning ("%s: Failed to expand %s", __func__, name);
+                  reader->error = TRUE;
+                  return NULL;
+                }
+              reader->in_entry = TRUE;
+              return (element_t) node;
+            }
+        }
+      ret = xmlTextReaderRead (reader->reader);
+    }
 
-  g_free (previous_dir);
+  if (ret < 0)
+    {
+      g_warning ("%s: Failed to parse XML", __func__);
+      reader->error = TRUE;
+    }
+  return NULL;
+}
 
-  return dir;
+/**
+ * @brief Close an entry reader.
+ *
+ * @param[in]  reader  Reader.
+ */
+static void
+entry_reader_close (entry_reader_t *reader)
+{
+  if (reader->reader)
+    xmlFreeTextReader (reader->reader);
+  reader->reader = NULL;
 }
 
 
@@ -309,15 +342,20 @@ split_xml_file (gchar *path, const gchar *size, const gchar *tail)
 
 /**
  * @brief Buffer for INSERT statements.
+ *
+ * In COPY mode the buffer holds rows in COPY text format instead, which
+ * are sent with COPY FROM STDIN whenever a chunk is full.
  */
 typedef struct
 {
   array_t *statements;     ///< Buffered statements.
-  GString *statement;      ///< Current statement.
+  GString *statement;      ///< Current statement, or rows in COPY mode.
   int current_chunk_size;  ///< Number of rows in current statement.
   int max_chunk_size;      ///< Max number of rows per INSERT.
   gchar *open_sql;         ///< SQL to open each statement.
   gchar *close_sql;        ///< SQL to close each statement.
+  gchar *copy_sql;         ///< COPY statement in COPY mode, else NULL.
+  gchar *merge_sql;        ///< SQL to run after the last COPY.
 } inserts_t;
 
 /**
@@ -338,6 +376,46 @@ inserts_init (inserts_t *inserts, int max_chunk_size, const gchar *open_sql,
   inserts->max_chunk_size = max_chunk_size;
   inserts->open_sql = open_sql ? g_strdup (open_sql) : NULL;
   inserts->close_sql = close_sql ? g_strdup (close_sql) : NULL;
+  inserts->copy_sql = NULL;
+  inserts->merge_sql = NULL;
+}
+
+/**
+ * @brief Initialise an insert buffer that loads rows with COPY.
+ *
+ * COPY cannot resolve conflicts, so the COPY usually targets a temporary
+ * table and the merge SQL moves the rows from there into the real table.
+ *
+ * @param[in]  inserts         Insert buffer.
+ * @param[in]  max_chunk_size  Max number of rows per COPY.
+ * @param[in]  copy_sql        COPY ... FROM STDIN statement.
+ * @param[in]  merge_sql       SQL to run after the last COPY, or NULL.
+ */
+static void
+inserts_init_copy (inserts_t *inserts, int max_chunk_size,
+                   const gchar *copy_sql, const gchar *merge_sql)
+{
+  inserts_init (inserts, max_chunk_size, NULL, NULL);
+  inserts->copy_sql = g_strdup (copy_sql);
+  inserts->merge_sql = merge_sql ? g_strdup (merge_sql) : NULL;
+}
+
+/**
+ * @brief Send the buffered rows of an insert buffer in COPY mode.
+ *
+ * @param[in]  inserts  Insert buffer.
+ */
+static void
+inserts_copy_flush (inserts_t *inserts)
+{
+  if (inserts->statement == NULL)
+    return;
+
+  sql_copy_in (inserts->copy_sql, inserts->statement->str,
+               inserts->statement->len);
+  g_string_free (inserts->statement, TRUE);
+  inserts->statement = NULL;
+  inserts->current_chunk_size = 0;
 }
 
 /**
@@ -370,6 +448,18 @@ inserts_check_size (inserts_t *inserts)
 
   first = 0;
 
+  if (inserts->copy_sql)
+    {
+      if (inserts->current_chunk_size >= inserts->max_chunk_size)
+        inserts_copy_flush (inserts);
+      if (inserts->statement == NULL)
+        {
+          inserts->statement = g_string_new ("");
+          first = 1;
+        }
+      return first;
+    }
+
   if (inserts->statement
       && inserts->current_chunk_size >= inserts->max_chunk_size)
     {
@@ -402,11 +492,91 @@ inserts_free (inserts_t *inserts)
   for (index = 0; index < inserts->statements->len; index++)
     g_string_free (g_ptr_array_index (inserts->statements, index), TRUE);
   g_ptr_array_free (inserts->statements, TRUE);
+  if (inserts->copy_sql && inserts->statement)
+    g_string_free (inserts->statement, TRUE);
   g_free (inserts->open_sql);
   g_free (inserts->close_sql);
+  g_free (inserts->copy_sql);
+  g_free (inserts->merge_sql);
   bzero (inserts, sizeof (*inserts));
 }
 
+/**
+ * @brief Add a row to an insert buffer.
+ *
+ * @param[in]  inserts  Insert buffer.
+ * @param[in]  count    Number of values.
+ * @param[in]  values   Values, NULL for SQL NULL.  Unquoted.
+ */
+static void
+inserts_add_row (inserts_t *inserts, int count, const gchar **values)
+{
+  int first, index;
+
+  first = inserts_check_size (inserts);
+
+  if (inserts->copy_sql)
+    {
+      for (index = 0; index < count; index++)
+        {
+          const gchar *point;
+
+          if (index)
+            g_string_append_c (inserts->statement, '\t');
+
+          if (values[index] == NULL)
+            {
+              g_string_append (inserts->statement, "\\N");
+              continue;
+            }
+
+          for (point = values[index]; *point; point++)
+            switch (*point)
+              {
+                case '\\':
+                  g_string_append (inserts->statement, "\\\\");
+                  break;
+                case '\t':
+                  g_string_append (inserts->statement, "\\t");
+                  break;
+                case '\n':
+                  g_string_append (inserts->statement, "\\n");
+                  break;
+                case '\r':
+                  g_string_append (inserts->statement, "\\r");
+                  break;
+                default:
+                  g_string_append_c (inserts->statement, *point);
+                  break;
+              }
+        }
+      g_string_append_c (inserts->statement, '\n');
+    }
+  else
+    {
+      g_string_append (inserts->statement, first ? " (" : ", (");
+      for (index = 0; index < count; index++)
+        {
+          if (index)
+            g_string_append (inserts->statement, ", ");
+
+          if (values[index] == NULL)
+            g_string_append (inserts->statement, "NULL");
+          else
+            {
+              gchar *quoted;
+
+              quoted = sql_quote (values[index]);
+              g_string_append_printf (inserts->statement, "'%s'", quoted);
+              g_free (quoted);
+            }
+        }
+      g_string_append_c (inserts->statement, ')');
+    }
+
+  inserts->current_chunk_size++;
+}
+
 /**
  * @brief Run the INSERT SQL, freeing the buffers.
  *
@@ -417,6 +587,15 @@ inserts_run (inserts_t *inserts)
 {
   guint index;
 
+  if (inserts->copy_sql)
+    {
+      inserts_copy_flush (inserts);
+      if (inserts->merge_sql)
+        sql ("%s", inserts->merge_sql);
+      inserts_free (inserts);
+      return;
+    }
+
   if (inserts->statement)
     {
       inserts_statement_close (inserts);
@@ -436,6 +615,107 @@ inserts_run (inserts_t *inserts)
   inserts_free (inserts);
 }
 
+
+/* Helper: feed file hashes. */
+
+/**
+ * @brief Compute the SHA256 hash of a feed file.
+ *
+ * @param[in]  full_path  Full path of file.
+ *
+ * @return Freshly allocated hash, or NULL on error.
+ */
+static gchar *
+feed_file_hash (const gchar *full_path)
+{
+  GChecksum *checksum;
+  FILE *file;
+  guchar buffer[8192];
+  size_t count;
+  gchar *hash;
+
+  file = fopen (full_path, "r");
+  if (file == NULL)
+    {
+      g_warning ("%s: Failed to open %s: %s",
+                 __func__, full_path, strerror (errno));
+      return NULL;
+    }
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  while ((count = fread (buffer, 1, sizeof (buffer), file)) > 0)
+    g_checksum_update (checksum, buffer, count);
+
+  if (ferror (file))
+    {
+      g_warning ("%s: Failed to read %s", __func__, full_path);
+      g_checksum_free (checksum);
+      fclose (file);
+      return NULL;
+    }
+  fclose (file);
+
+  hash = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+  return hash;
+}
+
+/**
+ * @brief Check if a feed file is the same as when it was last loaded.
+ *
+ * @param[in]  schema  Schema whose meta table holds the file hashes.
+ * @param[in]  name    Name of file.
+ * @param[in]  hash    Hash of file, from feed_file_hash.
+ *
+ * @return 1 if unchanged, else 0.
+ */
+static int
+feed_file_unchanged (const gchar *schema, const gchar *name,
+                     const gchar *hash)
+{
+  gchar *quoted_name;
+  int ret;
+
+  if (hash == NULL)
+    return 0;
+
+  quoted_name = sql_quote (name);
+  ret = sql_int ("SELECT count (*) FROM %s.meta"
+                 " WHERE name = 'file_hash:%s'"
+                 " AND value = '%s';",
+                 schema,
+                 quoted_name,
+                 hash);
+  g_free (quoted_name);
+  return ret > 0;
+}
+
+/**
+ * @brief Record the hash of a feed file that has been loaded.
+ *
+ * @param[in]  schema  Schema whose meta table holds the file hashes.
+ * @param[in]  name    Name of file.
+ * @param[in]  hash    Hash of file, from feed_file_hash.  NULL to do nothing.
+ */
+static void
+set_feed_file_hash (const gchar *schema, const gchar *name,
+                    const gchar *hash)
+{
+  gchar *quoted_name;
+
+  if (hash == NULL)
+    return;
+
+  quoted_name = sql_quote (name);
+  sql ("INSERT INTO %s.meta (name, value)"
+       " VALUES ('file_hash:%s', '%s')"
+       " ON CONFLICT (name) DO UPDATE SET value = EXCLUDED.value;",
+       schema,
+       quoted_name,
+       hash);
+  g_free (quoted_name);
+}
+
 
 /* CPE data. */
 
@@ -732,6 +1012,8 @@ init_cve_info_iterator (iterator_t* iterator, get_data_t *get, const char *name)
                            NULL,
                            clause,
                            FALSE);
+  if (ret == 0 && get->id == NULL && name == NULL)
+    iterator_use_cursor (iterator);
   g_free (clause);
   return ret;
 }
@@ -994,6 +1276,70 @@ init_nvt_cert_bund_adv_iterator (iterator_t *iterator, const char *oid)
  */
 DEF_ACCESS (nvt_cert_bund_adv_iterator_name, 0);
 
+/**
+ * @brief Initialise an iterator over the CERT advisories of some NVTs.
+ *
+ * Covers CERT-Bund and DFN-CERT advisories.  For each NVT the CERT-Bund
+ * advisories come first.
+ *
+ * @param[in]  iterator    Iterator.
+ * @param[in]  oids        OIDs of the NVTs.
+ */
+void
+init_nvts_cert_adv_iterator (iterator_t *iterator, GPtrArray *oids)
+{
+  gchar *list;
+
+  list = nvt_oid_list_sql (oids);
+  init_iterator (iterator,
+                 "SELECT DISTINCT cert_bund_advs.name, vt_refs.vt_oid,"
+                 "                'cert-bund' AS type"
+                 " FROM vt_refs, cert_bund_cves, cert_bund_advs"
+                 " WHERE vt_refs.vt_oid IN (%s)"
+                 " AND vt_refs.type = 'cve'"
+                 " AND cert_bund_cves.cve_name = vt_refs.ref_id"
+                 " AND cert_bund_advs.id = cert_bund_cves.adv_id"
+                 " UNION"
+                 " SELECT DISTINCT dfn_cert_advs.name, vt_refs.vt_oid,"
+                 "                 'dfn-cert' AS type"
+                 " FROM vt_refs, dfn_cert_cves, dfn_cert_advs"
+                 " WHERE vt_refs.vt_oid IN (%s)"
+                 " AND vt_refs.type = 'cve'"
+                 " AND dfn_cert_cves.cve_name = vt_refs.ref_id"
+                 " AND dfn_cert_advs.id = dfn_cert_cves.adv_id"
+                 " ORDER BY 2, 3, 1 DESC;",
+                 list,
+                 list);
+  g_free (list);
+}
+
+/**
+ * @brief Get the advisory name from an NVTs CERT advisory iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Name of the advisory or NULL if iteration is complete.
+ */
+DEF_ACCESS (nvts_cert_adv_iterator_name, 0);
+
+/**
+ * @brief Get the NVT OID from an NVTs CERT advisory iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return OID of the NVT or NULL if iteration is complete.
+ */
+DEF_ACCESS (nvts_cert_adv_iterator_oid, 1);
+
+/**
+ * @brief Get the advisory type from an NVTs CERT advisory iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return "cert-bund" or "dfn-cert", or NULL if iteration is complete.
+ */
+DEF_ACCESS (nvts_cert_adv_iterator_type, 2);
+
 
 /* DFN-CERT data. */
 
@@ -1166,6 +1512,77 @@ init_cve_dfn_cert_adv_iterator (iterator_t *iterator, const char *cve,
   g_free (columns);
 }
 
+/**
+ * @brief Initialise an iterator over the CERT advisories of some CVEs.
+ *
+ * Covers CERT-Bund and DFN-CERT advisories.  Sorted by CVE, then type
+ * with CERT-Bund first, then advisory name.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  cves      Names of the CVEs.
+ */
+void
+init_cves_cert_adv_iterator (iterator_t *iterator, GPtrArray *cves)
+{
+  gchar *list;
+
+  list = nvt_oid_list_sql (cves);
+  init_iterator (iterator,
+                 "SELECT DISTINCT cert_bund_cves.cve_name::text,"
+                 "                'CERT-Bund' AS type,"
+                 "                cert_bund_advs.name, cert_bund_advs.title"
+                 " FROM cert_bund_cves, cert_bund_advs"
+                 " WHERE cert_bund_cves.cve_name IN (%s)"
+                 " AND cert_bund_advs.id = cert_bund_cves.adv_id"
+                 " UNION"
+                 " SELECT DISTINCT dfn_cert_cves.cve_name,"
+                 "                 'DFN-CERT' AS type,"
+                 "                 dfn_cert_advs.name, dfn_cert_advs.title"
+                 " FROM dfn_cert_cves, dfn_cert_advs"
+                 " WHERE dfn_cert_cves.cve_name IN (%s)"
+                 " AND dfn_cert_advs.id = dfn_cert_cves.adv_id"
+                 " ORDER BY 1, 2, 3 ASC;",
+                 list,
+                 list);
+  g_free (list);
+}
+
+/**
+ * @brief Get the CVE name from a CVEs CERT advisory iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Name of the CVE or NULL if iteration is complete.
+ */
+DEF_ACCESS (cves_cert_adv_iterator_cve, 0);
+
+/**
+ * @brief Get the advisory type from a CVEs CERT advisory iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return "CERT-Bund" or "DFN-CERT", or NULL if iteration is complete.
+ */
+DEF_ACCESS (cves_cert_adv_iterator_type, 1);
+
+/**
+ * @brief Get the advisory name from a CVEs CERT advisory iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Name of the advisory or NULL if iteration is complete.
+ */
+DEF_ACCESS (cves_cert_adv_iterator_name, 2);
+
+/**
+ * @brief Get the advisory title from a CVEs CERT advisory iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Title of the advisory or NULL if iteration is complete.
+ */
+DEF_ACCESS (cves_cert_adv_iterator_title, 3);
+
 /**
  * @brief Initialise an DFN-CERT iterator, for advisories relevant to a NVT.
  *
@@ -1280,10 +1697,10 @@ static int
 update_dfn_xml (const gchar *xml_path, int last_cert_update,
                 int last_dfn_update)
 {
-  GError *error;
-  element_t element, child;
-  gchar *xml, *full_path;
-  gsize xml_len;
+  entry_reader_t reader;
+  element_t child;
+  gchar *full_path;
+  gchar *hash;
   GStatBuf state;
   int updated_dfn_cert;
   int transaction_size = 0;
@@ -1309,31 +1726,27 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
       return 0;
     }
 
-  g_info ("Updating %s", full_path);
-
-  error = NULL;
-  g_file_get_contents (full_path, &xml, &xml_len, &error);
-  if (error)
+  hash = feed_file_hash (full_path);
+  if (feed_file_unchanged ("cert", xml_path, hash))
     {
-      g_warning ("%s: Failed to get contents: %s",
-                 __func__,
-                 error->message);
-      g_error_free (error);
+      g_info ("Skipping %s, file is unchanged since last update",
+              full_path);
+      g_free (hash);
       g_free (full_path);
-      return -1;
+      return 0;
     }
 
-  if (parse_element (xml, &element))
+  g_info ("Updating %s", full_path);
+
+  if (entry_reader_open (&reader, full_path, NULL, "entry"))
     {
-      g_free (xml);
-      g_warning ("%s: Failed to parse element", __func__);
+      g_free (hash);
       g_free (full_path);
       return -1;
     }
-  g_free (xml);
 
   sql_begin_immediate ();
-  child = element_first_child (element);
+  child = entry_reader_next (&reader);
   while (child)
     {
       if (strcmp (element_name (child), "entry") == 0)
@@ -1345,7 +1758,6 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
           if (updated == NULL)
             {
               g_warning ("%s: UPDATED missing", __func__);
-              element_free (element);
               goto fail;
             }
 
@@ -1360,7 +1772,6 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
               if (refnum == NULL)
                 {
                   g_warning ("%s: REFNUM missing", __func__);
-                  element_free (element);
                   g_free (updated_text);
                   goto fail;
                 }
@@ -1369,7 +1780,6 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
               if (published == NULL)
                 {
                   g_warning ("%s: PUBLISHED missing", __func__);
-                  element_free (element);
                   g_free (updated_text);
                   goto fail;
                 }
@@ -1378,7 +1788,6 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
               if (title == NULL)
                 {
                   g_warning ("%s: TITLE missing", __func__);
-                  element_free (element);
                   g_free (updated_text);
                   goto fail;
                 }
@@ -1387,7 +1796,6 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
               if (summary == NULL)
                 {
                   g_warning ("%s: SUMMARY missing", __func__);
-                  element_free (element);
                   g_free (updated_text);
                   goto fail;
                 }
@@ -1428,6 +1836,13 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
               g_free (quoted_title);
               g_free (quoted_summary);
 
+              /* Replace the CVE refs, in case the advisory was updated. */
+              sql ("DELETE FROM dfn_cert_cves"
+                   " WHERE adv_id = (SELECT id FROM dfn_cert_advs"
+                   "                 WHERE name = '%s');",
+                   quoted_refnum);
+              increment_transaction_size (&transaction_size);
+
               cve = element_first_child (child);
               while (cve)
                 {
@@ -1480,17 +1895,23 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
 
           g_free (updated_text);
         }
-      child = element_next (child);
+      child = entry_reader_next (&reader);
     }
 
-  element_free (element);
+  if (reader.error)
+    goto fail;
+  entry_reader_close (&reader);
+  set_feed_file_hash ("cert", xml_path, hash);
+  g_free (hash);
   g_free (full_path);
   sql_commit ();
   return updated_dfn_cert;
 
  fail:
+  entry_reader_close (&reader);
   g_warning ("Update of DFN-CERT Advisories failed at file '%s'",
              full_path);
+  g_free (hash);
   g_free (full_path);
   sql_commit ();
   return -1;
@@ -1502,14 +1923,15 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
  * Assume that the databases are attached.
  *
  * @param[in]  last_cert_update  Time of last CERT update from meta.
+ * @param[in]  last_dfn_update   Latest modification time of the advisories.
  *
  * @return 0 nothing to do, 1 updated, -1 error.
  */
 static int
-update_dfn_cert_advisories (int last_cert_update)
+update_dfn_cert_advisories (int last_cert_update, int last_dfn_update)
 {
   GError *error;
-  int count, last_dfn_update, updated_dfn_cert;
+  int count, updated_dfn_cert;
   GDir *dir;
   const gchar *xml_path;
 
@@ -1523,9 +1945,6 @@ update_dfn_cert_advisories (int last_cert_update)
       return -1;
     }
 
-  last_dfn_update = sql_int ("SELECT max (modification_time)"
-                             " FROM cert.dfn_cert_advs;");
-
   g_debug ("%s: VS: " GVM_CERT_DATA_DIR "/dfn-cert-*.xml", __func__);
   count = 0;
   updated_dfn_cert = 0;
@@ -1569,10 +1988,10 @@ static int
 update_bund_xml (const gchar *xml_path, int last_cert_update,
                  int last_bund_update)
 {
-  GError *error;
-  element_t element, child;
-  gchar *xml, *full_path;
-  gsize xml_len;
+  entry_reader_t reader;
+  element_t child;
+  gchar *full_path;
+  gchar *hash;
   GStatBuf state;
   int updated_cert_bund;
   int transaction_size = 0;
@@ -1596,31 +2015,27 @@ update_bund_xml (const gchar *xml_path, int last_cert_update,
       return 0;
     }
 
-  g_info ("Updating %s", full_path);
-
-  error = NULL;
-  g_file_get_contents (full_path, &xml, &xml_len, &error);
-  if (error)
+  hash = feed_file_hash (full_path);
+  if (feed_file_unchanged ("cert", xml_path, hash))
     {
-      g_warning ("%s: Failed to get contents: %s",
-                 __func__,
-                 error->message);
-      g_error_free (error);
+      g_info ("Skipping %s, file is unchanged since last update",
+              full_path);
+      g_free (hash);
       g_free (full_path);
-      return -1;
+      return 0;
     }
 
-  if (parse_element (xml, &element))
+  g_info ("Updating %s", full_path);
+
+  if (entry_reader_open (&reader, full_path, NULL, "Advisory"))
     {
-      g_free (xml);
-      g_warning ("%s: Failed to parse element", __func__);
+      g_free (hash);
       g_free (full_path);
       return -1;
     }
-  g_free (xml);
 
   sql_begin_immediate ();
-  child = element_first_child (element);
+  child = entry_reader_next (&reader);
   while (child)
     {
       if (strcmp (element_name (child), "Advisory") == 0)
@@ -1631,7 +2046,6 @@ update_bund_xml (const gchar *xml_path, int last_cert_update,
           if (date == NULL)
             {
               g_warning ("%s: Date missing", __func__);
-              element_free (element);
               goto fail;
             }
           if (parse_iso_time_element_text (date) > last_bund_update)
@@ -1645,7 +2059,6 @@ update_bund_xml (const gchar *xml_path, int last_cert_update,
               if (refnum == NULL)
                 {
                   g_warning ("%s: Ref_Num missing", __func__);
-                  element_free (element);
                   goto fail;
                 }
 
@@ -1653,7 +2066,6 @@ update_bund_xml (const gchar *xml_path, int last_cert_update,
               if (title == NULL)
                 {
                   g_warning ("%s: Title missing", __func__);
-                  element_free (element);
                   goto fail;
                 }
 
@@ -1724,6 +2136,13 @@ update_bund_xml (const gchar *xml_path, int last_cert_update,
               g_free (quoted_title);
               g_free (quoted_summary);
 
+              /* Replace the CVE refs, in case the advisory was updated. */
+              sql ("DELETE FROM cert_bund_cves"
+                   " WHERE adv_id = (SELECT id FROM cert_bund_advs"
+                   "                 WHERE name = '%s');",
+                   quoted_refnum);
+              increment_transaction_size (&transaction_size);
+
               cve_list = element_child (child, "CVEList");
               if (cve_list)
                 {
@@ -1764,17 +2183,23 @@ update_bund_xml (const gchar *xml_path, int last_cert_update,
               g_free (quoted_refnum);
             }
         }
-      child = element_next (child);
+      child = entry_reader_next (&reader);
     }
 
-  element_free (element);
+  if (reader.error)
+    goto fail;
+  entry_reader_close (&reader);
+  set_feed_file_hash ("cert", xml_path, hash);
+  g_free (hash);
   g_free (full_path);
   sql_commit ();
   return updated_cert_bund;
 
  fail:
+  entry_reader_close (&reader);
   g_warning ("Update of CERT-Bund Advisories failed at file '%s'",
              full_path);
+  g_free (hash);
   g_free (full_path);
   sql_commit ();
   return -1;
@@ -1786,14 +2211,15 @@ update_bund_xml (const gchar *xml_path, int last_cert_update,
  * Assume that the databases are attached.
  *
  * @param[in]  last_cert_update  Time of last CERT update from meta.
+ * @param[in]  last_bund_update   Latest modification time of the advisories.
  *
  * @return 0 nothing to do, 1 updated, -1 error.
  */
 static int
-update_cert_bund_advisories (int last_cert_update)
+update_cert_bund_advisories (int last_cert_update, int last_bund_update)
 {
   GError *error;
-  int count, last_bund_update, updated_cert_bund;
+  int count, updated_cert_bund;
   GDir *dir;
   const gchar *xml_path;
 
@@ -1807,9 +2233,6 @@ update_cert_bund_advisories (int last_cert_update)
       return -1;
     }
 
-  last_bund_update = sql_int ("SELECT max (modification_time)"
-                              " FROM cert.cert_bund_advs;");
-
   count = 0;
   updated_cert_bund = 0;
   while ((xml_path = g_dir_read_name (dir)))
@@ -1836,6 +2259,98 @@ update_cert_bund_advisories (int last_cert_update)
   return updated_cert_bund;
 }
 
+
+/* SCAP update: workers. */
+
+/**
+ * @brief Load SCAP files in parallel worker processes.
+ *
+ * Each worker opens its own database connection and loads every
+ * scap_workers'th file, committing per file as in the serial update.
+ *
+ * @param[in]  paths        Paths of files.
+ * @param[in]  update_file  Function that loads one file.
+ * @param[in]  data         Data for update_file.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+update_scap_files_parallel (GPtrArray *paths,
+                            int (*update_file) (const gchar *, gpointer),
+                            gpointer data)
+{
+  pid_t *pids;
+  int index, ret;
+
+  pids = g_malloc0 (scap_workers * sizeof (pid_t));
+  ret = 0;
+
+  for (index = 0; index < scap_workers; index++)
+    {
+      pids[index] = fork ();
+      switch (pids[index])
+        {
+          case 0:
+            {
+              guint file;
+
+              /* Child.  Reopen the database (required after fork).  Use
+               * _exit to skip the cleanup of the parent process. */
+              reinit_manage_process ();
+              for (file = index; file < paths->len; file += scap_workers)
+                if (update_file (g_ptr_array_index (paths, file), data))
+                  {
+                    sql_close ();
+                    _exit (EXIT_FAILURE);
+                  }
+              sql_close ();
+              _exit (EXIT_SUCCESS);
+            }
+          case -1:
+            g_warning ("%s: fork failed: %s",
+                       __func__,
+                       strerror (errno));
+            ret = -1;
+            break;
+          default:
+            g_debug ("%s: %i forked %i", __func__, getpid (), pids[index]);
+            break;
+        }
+      if (ret)
+        break;
+    }
+
+  for (index = 0; index < scap_workers; index++)
+    {
+      int status;
+
+      if (pids[index] <= 0)
+        continue;
+
+      while (waitpid (pids[index], &status, 0) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          g_warning ("%s: waitpid: %s",
+                     __func__,
+                     strerror (errno));
+          status = -1;
+          break;
+        }
+
+      if (status == -1
+          || WIFEXITED (status) == 0
+          || WEXITSTATUS (status) != EXIT_SUCCESS)
+        {
+          g_warning ("%s: worker %i failed", __func__, index);
+          ret = -1;
+        }
+    }
+
+  g_free (pids);
+  return ret;
+}
+
 
 /* SCAP update: CPEs. */
 
@@ -1853,11 +2368,10 @@ static int
 insert_scap_cpe (inserts_t *inserts, element_t cpe_item, element_t item_metadata,
                  int modification_time)
 {
-  gchar *name, *status, *deprecated, *nvd_id;
-  gchar *quoted_name, *quoted_title, *quoted_status, *quoted_nvd_id;
+  gchar *name, *status, *deprecated, *nvd_id, *title_text, *time_string;
   gchar *name_decoded, *name_tilde;
+  const gchar *values[8];
   element_t title;
-  int first;
 
   assert (inserts);
 
@@ -1901,7 +2415,7 @@ insert_scap_cpe (inserts_t *inserts, element_t cpe_item, element_t item_metadata
     }
 
   title = element_first_child (cpe_item);
-  quoted_title = g_strdup ("");
+  title_text = g_strdup ("");
   while (title)
     {
       if (strcmp (element_name (title), "title") == 0)
@@ -1911,12 +2425,8 @@ insert_scap_cpe (inserts_t *inserts, element_t cpe_item, element_t item_metadata
           lang = element_attribute (title, "xml:lang");
           if (lang && strcmp (lang, "en-US") == 0)
             {
-              gchar *title_text;
-
-              title_text = element_text (title);
-              g_free (quoted_title);
-              quoted_title = sql_quote (title_text);
               g_free (title_text);
+              title_text = element_text (title);
 
               g_free (lang);
               break;
@@ -1931,33 +2441,23 @@ insert_scap_cpe (inserts_t *inserts, element_t cpe_item, element_t item_metadata
   name_tilde = string_replace (name_decoded,
                                "~", "%7E", "%7e", NULL);
   g_free (name_decoded);
-  quoted_name = sql_quote (name_tilde);
+  time_string = g_strdup_printf ("%i", modification_time);
+
+  values[0] = name_tilde;
+  values[1] = name_tilde;
+  values[2] = title_text;
+  values[3] = time_string;
+  values[4] = time_string;
+  values[5] = status;
+  values[6] = deprecated;
+  values[7] = nvd_id;
+  inserts_add_row (inserts, 8, values);
+
   g_free (name_tilde);
-  quoted_status = sql_quote (status);
+  g_free (title_text);
+  g_free (time_string);
   g_free (status);
-  quoted_nvd_id = sql_quote (nvd_id);
   g_free (nvd_id);
-
-  first = inserts_check_size (inserts);
-
-  g_string_append_printf (inserts->statement,
-                          "%s ('%s', '%s', '%s', %i, %i, '%s', %s, '%s')",
-                          first ? "" : ",",
-                          quoted_name,
-                          quoted_name,
-                          quoted_title,
-                          modification_time,
-                          modification_time,
-                          quoted_status,
-                          deprecated ? deprecated : "NULL",
-                          quoted_nvd_id);
-
-  inserts->current_chunk_size++;
-
-  g_free (quoted_title);
-  g_free (quoted_name);
-  g_free (quoted_status);
-  g_free (quoted_nvd_id);
   g_free (deprecated);
 
   return 0;
@@ -1973,59 +2473,57 @@ insert_scap_cpe (inserts_t *inserts, element_t cpe_item, element_t item_metadata
 static int
 update_scap_cpes_from_file (const gchar *path)
 {
-  GError *error;
-  element_t element, cpe_list, cpe_item;
-  gchar *xml;
-  gsize xml_len;
+  entry_reader_t reader;
+  element_t cpe_item;
   inserts_t inserts;
 
   g_debug ("%s: parsing %s", __func__, path);
 
-  error = NULL;
-  g_file_get_contents (path, &xml, &xml_len, &error);
-  if (error)
-    {
-      g_warning ("%s: Failed to get contents: %s",
-                 __func__,
-                 error->message);
-      g_error_free (error);
-      return -1;
-    }
-
-  if (parse_element (xml, &element))
-    {
-      g_free (xml);
-      g_warning ("%s: Failed to parse element", __func__);
-      return -1;
-    }
-  g_free (xml);
-
-  cpe_list = element;
-  if (strcmp (element_name (cpe_list), "cpe-list"))
-    {
-      element_free (element);
-      g_warning ("%s: CPE dictionary missing CPE-LIST", __func__);
-      return -1;
-    }
+  if (entry_reader_open (&reader, path, "cpe-list", "cpe-item"))
+    return -1;
 
   sql_begin_immediate ();
 
-  inserts_init (&inserts,
-                CPE_MAX_CHUNK_SIZE,
-                "INSERT INTO scap2.cpes"
-                " (uuid, name, title, creation_time,"
-                "  modification_time, status, deprecated_by_id,"
-                "  nvd_id)"
-                " VALUES",
-                " ON CONFLICT (uuid) DO UPDATE"
-                " SET name = EXCLUDED.name,"
-                "     title = EXCLUDED.title,"
-                "     creation_time = EXCLUDED.creation_time,"
-                "     modification_time = EXCLUDED.modification_time,"
-                "     status = EXCLUDED.status,"
-                "     deprecated_by_id = EXCLUDED.deprecated_by_id,"
-                "     nvd_id = EXCLUDED.nvd_id");
-  cpe_item = element_first_child (cpe_list);
+  /* COPY the CPEs into a temporary table, then merge them into the real
+   * table, because COPY cannot update the CPEs that exist already.  The
+   * last copy of a duplicate CPE wins, as it would with INSERTs. */
+  sql ("DROP TABLE IF EXISTS cpes_copy;");
+  sql ("CREATE TEMPORARY TABLE cpes_copy"
+       " (copy_order SERIAL,"
+       "  uuid text,"
+       "  name text,"
+       "  title text,"
+       "  creation_time integer,"
+       "  modification_time integer,"
+       "  status text,"
+       "  deprecated_by_id integer,"
+       "  nvd_id text);");
+  inserts_init_copy (&inserts,
+                     CPE_MAX_CHUNK_SIZE,
+                     "COPY cpes_copy"
+                     " (uuid, name, title, creation_time,"
+                     "  modification_time, status, deprecated_by_id,"
+                     "  nvd_id)"
+                     " FROM STDIN;",
+                     "INSERT INTO scap2.cpes"
+                     " (uuid, name, title, creation_time,"
+                     "  modification_time, status, deprecated_by_id,"
+                     "  nvd_id)"
+                     " SELECT DISTINCT ON (uuid)"
+                     "        uuid, name, title, creation_time,"
+                     "        modification_time, status, deprecated_by_id,"
+                     "        nvd_id"
+                     " FROM cpes_copy"
+                     " ORDER BY uuid, copy_order DESC"
+                     " ON CONFLICT (uuid) DO UPDATE"
+                     " SET name = EXCLUDED.name,"
+                     "     title = EXCLUDED.title,"
+                     "     creation_time = EXCLUDED.creation_time,"
+                     "     modification_time = EXCLUDED.modification_time,"
+                     "     status = EXCLUDED.status,"
+                     "     deprecated_by_id = EXCLUDED.deprecated_by_id,"
+                     "     nvd_id = EXCLUDED.nvd_id;");
+  cpe_item = entry_reader_next (&reader);
   while (cpe_item)
     {
       gchar *modification_date;
@@ -2034,7 +2532,7 @@ update_scap_cpes_from_file (const gchar *path)
 
       if (strcmp (element_name (cpe_item), "cpe-item"))
         {
-          cpe_item = element_next (cpe_item);
+          cpe_item = entry_reader_next (&reader);
           continue;
         }
 
@@ -2059,140 +2557,302 @@ update_scap_cpes_from_file (const gchar *path)
       if (insert_scap_cpe (&inserts, cpe_item, item_metadata,
                            modification_time))
         goto fail;
-      cpe_item = element_next (cpe_item);
+      cpe_item = entry_reader_next (&reader);
     }
 
-  element_free (element);
+  if (reader.error)
+    goto fail;
+  entry_reader_close (&reader);
 
   inserts_run (&inserts);
+  sql ("DROP TABLE cpes_copy;");
 
   sql_commit ();
   return 0;
 
  fail:
   inserts_free (&inserts);
-  element_free (element);
+  entry_reader_close (&reader);
+  sql ("DROP TABLE IF EXISTS cpes_copy;");
   g_warning ("Update of CPEs failed");
   sql_commit ();
   return -1;
 }
 
 /**
- * @brief Update SCAP CPEs.
+ * @brief Update SCAP CPEs.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+update_scap_cpes ()
+{
+  gchar *full_path, *hash;
+  GStatBuf state;
+  int ret;
+
+  full_path = g_build_filename (GVM_SCAP_DATA_DIR,
+                                "official-cpe-dictionary_v2.2.xml",
+                                NULL);
+
+  if (g_stat (full_path, &state))
+    {
+      g_warning ("%s: No CPE dictionary found at %s",
+                 __func__,
+                 full_path);
+      g_free (full_path);
+      return -1;
+    }
+
+  hash = feed_file_hash (full_path);
+  if (feed_file_unchanged ("scap2", "official-cpe-dictionary_v2.2.xml", hash))
+    {
+      g_info ("Skipping CPEs, %s is unchanged since last update", full_path);
+      g_free (hash);
+      g_free (full_path);
+      return 0;
+    }
+
+  g_info ("Updating CPEs");
+
+  ret = update_scap_cpes_from_file (full_path);
+  if (ret == 0)
+    set_feed_file_hash ("scap2", "official-cpe-dictionary_v2.2.xml", hash);
+  g_free (hash);
+  g_free (full_path);
+  return ret;
+}
+
+
+/* SCAP update: CVEs. */
+
+/**
+ * @brief A slot of a CPE index.
+ */
+typedef struct
+{
+  gsize name;  ///< Offset of the name in the arena plus one, 0 if empty.
+  int id;      ///< ID of the CPE.
+} cpe_index_slot_t;
+
+/**
+ * @brief Index of CPE names to CPE IDs, for loading CVEs.
+ *
+ * The names are interned one after the other in a single arena, and the
+ * slots of the open addressing table refer to them by offset.  The index
+ * is built once per SCAP update and shared by all CVE files, including by
+ * the parallel workers.
+ */
+typedef struct
+{
+  GString *names;           ///< Arena of NUL terminated names.
+  cpe_index_slot_t *slots;  ///< Slots.
+  guint mask;               ///< Number of slots minus one.
+  guint count;              ///< Number of CPEs in the index.
+} cpe_index_t;
+
+/**
+ * @brief Add a CPE to a CPE index.
  *
- * @return 0 success, -1 error.
+ * @param[in]  index  Index.
+ * @param[in]  name   Name of CPE.
+ * @param[in]  id     ID of CPE.
  */
-static int
-update_scap_cpes ()
+static void
+cpe_index_add (cpe_index_t *index, const gchar *name, int id)
 {
-  gchar *full_path;
-  const gchar *split_dir;
-  GStatBuf state;
-  int index;
-
-  full_path = g_build_filename (GVM_SCAP_DATA_DIR,
-                                "official-cpe-dictionary_v2.2.xml",
-                                NULL);
+  guint slot;
 
-  if (g_stat (full_path, &state))
+  if (index->count >= index->mask)
     {
-      g_warning ("%s: No CPE dictionary found at %s",
-                 __func__,
-                 full_path);
-      g_free (full_path);
-      return -1;
+      g_warning ("%s: CPE index full, skipping %s", __func__, name);
+      return;
     }
 
-  g_info ("Updating CPEs");
-
-  split_dir = split_xml_file (full_path, "40Mb", "</cpe-list>");
-  if (split_dir == NULL)
+  slot = g_str_hash (name) & index->mask;
+  while (index->slots[slot].name)
     {
-      int ret;
-
-      g_warning ("%s: Failed to split CPEs, attempting with full file",
-                 __func__);
-      ret = update_scap_cpes_from_file (full_path);
-      g_free (full_path);
-      return ret;
+      if (strcmp (index->names->str + index->slots[slot].name - 1, name)
+          == 0)
+        return;
+      slot = (slot + 1) & index->mask;
     }
-  g_free (full_path);
 
-  for (index = 1; 1; index++)
-    {
-      int ret;
-      gchar *path, *name;
+  index->slots[slot].name = index->names->len + 1;
+  index->slots[slot].id = id;
+  g_string_append_len (index->names, name, strlen (name) + 1);
+  index->count++;
+}
 
-      name = g_strdup_printf ("split-%02i.xml", index);
-      path = g_build_filename (split_dir, name, NULL);
-      g_free (name);
+/**
+ * @brief Build an index of all CPEs in scap2.
+ *
+ * @param[out]  index  Index.
+ */
+static void
+cpe_index_init (cpe_index_t *index)
+{
+  iterator_t cpes;
+  guint count, slots;
 
-      if (g_stat (path, &state))
-        {
-          g_free (path);
-          break;
-        }
+  count = sql_int ("SELECT count (*) FROM scap2.cpes;");
 
-      ret = update_scap_cpes_from_file (path);
-      g_free (path);
-      if (ret < 0)
-        {
-          gvm_file_remove_recurse (split_dir);
-          return -1;
-        }
-    }
+  /* Keep the table at most half full. */
+  slots = 1024;
+  while (slots < 2 * count)
+    slots *= 2;
+
+  index->names = g_string_sized_new (count * 48);
+  index->slots = g_new0 (cpe_index_slot_t, slots);
+  index->mask = slots - 1;
+  index->count = 0;
+
+  init_iterator (&cpes, "SELECT uuid, id FROM scap2.cpes;");
+  while (next (&cpes))
+    cpe_index_add (index, iterator_string (&cpes, 0), iterator_int (&cpes, 1));
+  cleanup_iterator (&cpes);
+}
 
-  gvm_file_remove_recurse (split_dir);
+/**
+ * @brief Get the ID of a CPE from a CPE index.
+ *
+ * @param[in]  index  Index.
+ * @param[in]  name   Name of CPE.
+ *
+ * @return ID of CPE, 0 if the CPE is not in the index.
+ */
+static int
+cpe_index_lookup (cpe_index_t *index, const gchar *name)
+{
+  guint slot;
 
+  slot = g_str_hash (name) & index->mask;
+  while (index->slots[slot].name)
+    {
+      if (strcmp (index->names->str + index->slots[slot].name - 1, name)
+          == 0)
+        return index->slots[slot].id;
+      slot = (slot + 1) & index->mask;
+    }
   return 0;
 }
 
-
-/* SCAP update: CVEs. */
+/**
+ * @brief Free a CPE index.
+ *
+ * @param[in]  index  Index.
+ */
+static void
+cpe_index_free (cpe_index_t *index)
+{
+  g_string_free (index->names, TRUE);
+  g_free (index->slots);
+}
 
 /**
- * @brief Check if this is the last appearance of a product in its siblings.
+ * @brief Insert products for a CVE into the staging table.
  *
- * @param[in]  product  Product.
+ * merge_cve_products_staged adds the CPEs and affected products from the
+ * staging table after parallel CVE workers have finished.
  *
- * @return 1 if last appearance of product, else 0.
+ * @param[in]  product           First product element.
+ * @param[in]  cve               CVE.
+ * @param[in]  time_modified     Time modified.
+ * @param[in]  time_published    Time published.
+ * @param[in]  transaction_size  Statement counter for batching.
  */
-static int
-last_appearance (element_t product)
+static void
+insert_cve_products_staged (element_t product, resource_t cve,
+                            int time_modified, int time_published,
+                            int *transaction_size)
 {
-  element_t product2;
+  GString *sql_staged;
+  int first;
+
+  sql_staged = g_string_new ("INSERT INTO scap2.affected_products_staging"
+                             " (cve, cpe, creation_time, modification_time)"
+                             " VALUES");
+  first = 1;
 
-  product2 = element_next (product);
-  while (product2)
+  while (product)
     {
-      gchar *product_text, *product2_text;
-      int cmp;
+      gchar *product_text;
+
+      if (strcmp (element_name (product), "product"))
+        {
+          product = element_next (product);
+          continue;
+        }
 
       product_text = element_text (product);
-      product2_text = element_text (product2);
+      if (strlen (product_text))
+        {
+          gchar *quoted_product, *product_decoded;
+          gchar *product_tilde;
+
+          product_decoded = g_uri_unescape_string
+                             (element_text (product), NULL);
+          product_tilde = string_replace (product_decoded,
+                                          "~", "%7E", "%7e",
+                                          NULL);
+          g_free (product_decoded);
+          quoted_product = sql_quote (product_tilde);
+
+          /* Same times as the CPEs inserted by insert_cve_products. */
+          g_string_append_printf (sql_staged,
+                                  "%s (%llu, '%s', %i, %i)",
+                                  first ? "" : ",", cve, quoted_product,
+                                  time_published, time_modified);
+          first = 0;
+
+          g_free (product_tilde);
+          g_free (quoted_product);
+        }
 
-      cmp = strcmp (product_text, product2_text);
       g_free (product_text);
-      g_free (product2_text);
-      if (cmp == 0)
-        break;
-      product2 = element_next (product2);
+
+      product = element_next (product);
     }
-  return product2 == NULL;
+
+  if (first == 0)
+    {
+      sql ("%s;", sql_staged->str);
+      increment_transaction_size (transaction_size);
+    }
+
+  g_string_free (sql_staged, TRUE);
 }
 
 /**
- * @brief Get the ID of a CPE from a hashtable.
- *
- * @param[in]  hashed_cpes    CPEs.
- * @param[in]  product_tilde  UUID/Name.
- *
- * @return ID of CPE from hashtable.
+ * @brief Add the staged CVE products to the CPEs and affected products.
  */
-static int
-hashed_cpes_cpe_id (GHashTable *hashed_cpes, const gchar *product_tilde)
+static void
+merge_cve_products_staged ()
 {
-  return GPOINTER_TO_INT (g_hash_table_lookup (hashed_cpes, product_tilde));
+  sql_begin_immediate ();
+
+  /* As in insert_cve_products, a CPE that is only named by CVEs gets
+   * the times of a CVE that names it. */
+  sql ("INSERT INTO scap2.cpes"
+       " (uuid, name, creation_time, modification_time)"
+       " SELECT DISTINCT ON (staged.cpe)"
+       "        staged.cpe, staged.cpe, staged.creation_time,"
+       "        staged.modification_time"
+       " FROM scap2.affected_products_staging AS staged"
+       " WHERE NOT EXISTS (SELECT * FROM scap2.cpes"
+       "                   WHERE cpes.uuid = staged.cpe)"
+       " ORDER BY staged.cpe, staged.creation_time"
+       " ON CONFLICT (uuid) DO NOTHING;");
+
+  sql ("INSERT INTO scap2.affected_products (cve, cpe)"
+       " SELECT DISTINCT staged.cve, cpes.id"
+       " FROM scap2.affected_products_staging AS staged"
+       " JOIN scap2.cpes ON cpes.uuid = staged.cpe"
+       " ON CONFLICT DO NOTHING;");
+
+  sql ("DROP TABLE scap2.affected_products_staging;");
+
+  sql_commit ();
 }
 
 /**
@@ -2202,17 +2862,18 @@ hashed_cpes_cpe_id (GHashTable *hashed_cpes, const gchar *product_tilde)
  * @param[in]  cve               CVE.
  * @param[in]  time_published    Time published.
  * @param[in]  time_modified     Time modified.
- * @param[in]  hashed_cpes       Hashed CPEs.
+ * @param[in]  cpe_index         Index of CPEs.
  * @param[in]  transaction_size  Statement counter for batching.
  */
 static void
 insert_cve_products (element_t list, resource_t cve,
                      int time_modified, int time_published,
-                     GHashTable *hashed_cpes, int *transaction_size)
+                     cpe_index_t *cpe_index, int *transaction_size)
 {
   element_t product;
   int first_product, first_affected;
   GString *sql_cpes, *sql_affected;
+  GHashTable *new_products;
 
   if (list == NULL)
     return;
@@ -2222,6 +2883,13 @@ insert_cve_products (element_t list, resource_t cve,
   if (product == NULL)
     return;
 
+  if (cve_products_staged)
+    {
+      insert_cve_products_staged (product, cve, time_modified, time_published,
+                                  transaction_size);
+      return;
+    }
+
   sql_cpes = g_string_new ("INSERT INTO scap2.cpes"
                            " (uuid, name, creation_time,"
                            "  modification_time)"
@@ -2233,6 +2901,8 @@ insert_cve_products (element_t list, resource_t cve,
   /* Buffer the SQL. */
 
   first_product = first_affected = 1;
+  new_products = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                        NULL);
 
   while (product)
     {
@@ -2249,26 +2919,27 @@ insert_cve_products (element_t list, resource_t cve,
         {
           gchar *quoted_product, *product_decoded;
           gchar *product_tilde;
+          int cpe;
 
-          product_decoded = g_uri_unescape_string
-                             (element_text (product), NULL);
+          product_decoded = g_uri_unescape_string (product_text, NULL);
           product_tilde = string_replace (product_decoded,
                                           "~", "%7E", "%7e",
                                           NULL);
           g_free (product_decoded);
           quoted_product = sql_quote (product_tilde);
 
-          if (g_hash_table_contains (hashed_cpes, product_tilde) == 0)
+          cpe = cpe_index_lookup (cpe_index, product_tilde);
+          if (cpe == 0)
             {
               /* The product was not in the db.
                *
-               * Only insert the product if this is its last appearance
-               * in the current CVE's XML, to avoid errors from Postgres
-               * ON CONFLICT DO UPDATE. */
+               * Only insert the product at its first appearance in the
+               * current CVE's XML, to avoid errors from Postgres ON
+               * CONFLICT DO UPDATE. */
 
-              if (last_appearance (product))
+              if (g_hash_table_add (new_products, g_strdup (product_tilde)))
                 {
-                  /* The CPE does not appear later in this CVE's XML. */
+                  /* The CPE did not appear earlier in this CVE's XML. */
 
                   g_string_append_printf
                    (sql_cpes,
@@ -2277,10 +2948,6 @@ insert_cve_products (element_t list, resource_t cve,
                     time_published, time_modified);
 
                   first_product = 0;
-
-                  /* We could add product_tilde to the hashtable but then we
-                   * would have to worry about memory management in the
-                   * hashtable. */
                 }
 
               /* We don't know the db id of the CPE right now. */
@@ -2294,14 +2961,10 @@ insert_cve_products (element_t list, resource_t cve,
             }
           else
             {
-              int cpe;
-
               /* The product is in the db.
                *
                * So we don't need to insert it. */
 
-              cpe = hashed_cpes_cpe_id (hashed_cpes, product_tilde);
-
               g_string_append_printf
                (sql_affected,
                 "%s (%llu, %i)",
@@ -2319,6 +2982,8 @@ insert_cve_products (element_t list, resource_t cve,
       product = element_next (product);
     }
 
+  g_hash_table_destroy (new_products);
+
   /* Run the SQL. */
 
   if (first_product == 0)
@@ -2350,13 +3015,13 @@ insert_cve_products (element_t list, resource_t cve,
  * @param[in]  entry             XML entry.
  * @param[in]  last_modified     XML last_modified element.
  * @param[in]  transaction_size  Statement counter for batching.
- * @param[in]  hashed_cpes       Hashed CPEs.
+ * @param[in]  cpe_index         Index of CPEs.
  *
  * @return 0 success, -1 error.
  */
 static int
 insert_cve_from_entry (element_t entry, element_t last_modified,
-                       GHashTable *hashed_cpes, int *transaction_size)
+                       cpe_index_t *cpe_index, int *transaction_size)
 {
   gboolean cvss_is_v3;
   element_t published, summary, cvss, score, base_metrics, cvss_vector, list;
@@ -2502,28 +3167,64 @@ insert_cve_from_entry (element_t entry, element_t last_modified,
   g_free (quoted_summary);
   g_free (quoted_cvss_vector);
 
+  /* An updated CVE may no longer affect some of its previous products. */
+  if (previous_cves)
+    {
+      sql ("DELETE FROM scap2.affected_products WHERE cve = %llu;", cve);
+      increment_transaction_size (transaction_size);
+    }
+
   insert_cve_products (list, cve, time_published, time_modified,
-                       hashed_cpes, transaction_size);
+                       cpe_index, transaction_size);
 
   g_free (quoted_id);
   return 0;
 }
 
+/**
+ * @brief Check if a CVE entry is the same as in the previous SCAP data.
+ *
+ * @param[in]  entry          XML entry.
+ * @param[in]  last_modified  XML last_modified element.
+ *
+ * @return 1 if unchanged, else 0.
+ */
+static int
+cve_unchanged (element_t entry, element_t last_modified)
+{
+  gchar *id;
+  gpointer time_modified;
+  int ret;
+
+  if (previous_cves == NULL)
+    return 0;
+
+  id = element_attribute (entry, "id");
+  if (id == NULL)
+    return 0;
+
+  ret = g_hash_table_lookup_extended (previous_cves, id, NULL,
+                                      &time_modified)
+        && (GPOINTER_TO_INT (time_modified)
+            == parse_iso_time_element_text (last_modified));
+  g_free (id);
+  return ret;
+}
+
 /**
  * @brief Update CVE info from a single XML feed file.
  *
  * @param[in]  xml_path          XML path.
- * @param[in]  hashed_cpes       Hashed CPEs.
+ * @param[in]  cpe_index         Index of CPEs.
  *
  * @return 0 success, -1 error.
  */
 static int
-update_cve_xml (const gchar *xml_path, GHashTable *hashed_cpes)
+update_cve_xml (const gchar *xml_path, cpe_index_t *cpe_index)
 {
-  GError *error;
-  element_t element, entry;
-  gchar *xml, *full_path;
-  gsize xml_len;
+  entry_reader_t reader;
+  element_t entry;
+  gchar *full_path, *hash;
   GStatBuf state;
   int transaction_size = 0;
 
@@ -2537,31 +3238,27 @@ update_cve_xml (const gchar *xml_path, GHashTable *hashed_cpes)
       return -1;
     }
 
-  g_info ("Updating %s", full_path);
-
-  error = NULL;
-  g_file_get_contents (full_path, &xml, &xml_len, &error);
-  if (error)
+  hash = feed_file_hash (full_path);
+  if (feed_file_unchanged ("scap2", xml_path, hash))
     {
-      g_warning ("%s: Failed to get contents: %s",
-                 __func__,
-                 error->message);
-      g_error_free (error);
+      g_info ("Skipping %s, file is unchanged since last update",
+              full_path);
+      g_free (hash);
       g_free (full_path);
-      return -1;
+      return 0;
     }
 
-  if (parse_element (xml, &element))
+  g_info ("Updating %s", full_path);
+
+  if (entry_reader_open (&reader, full_path, NULL, "entry"))
     {
-      g_free (xml);
-      g_warning ("%s: Failed to parse element", __func__);
+      g_free (hash);
       g_free (full_path);
       return -1;
     }
-  g_free (xml);
 
   sql_begin_immediate ();
-  entry = element_first_child (element);
+  entry = entry_reader_next (&reader);
   while (entry)
     {
       if (strcmp (element_name (entry), "entry") == 0)
@@ -2576,43 +3273,77 @@ update_cve_xml (const gchar *xml_path, GHashTable *hashed_cpes)
               goto fail;
             }
 
-          if (insert_cve_from_entry (entry, last_modified, hashed_cpes,
-                                     &transaction_size))
+          if (cve_unchanged (entry, last_modified) == 0
+              && insert_cve_from_entry (entry, last_modified, cpe_index,
+                                        &transaction_size))
             goto fail;
         }
-      entry = element_next (entry);
+      entry = entry_reader_next (&reader);
     }
 
-  element_free (element);
+  if (reader.error)
+    goto fail;
+  entry_reader_close (&reader);
+  set_feed_file_hash ("scap2", xml_path, hash);
+  g_free (hash);
   g_free (full_path);
   sql_commit ();
   return 0;
 
  fail:
-  element_free (element);
+  entry_reader_close (&reader);
   g_warning ("Update of CVEs failed at file '%s'",
              full_path);
+  g_free (hash);
   g_free (full_path);
   sql_commit ();
   return -1;
 }
 
+/**
+ * @brief Update CVE info from a file, for update_scap_files_parallel.
+ *
+ * @param[in]  xml_path     XML path.
+ * @param[in]  cpe_index    Index of CPEs.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+update_cve_xml_from_path (const gchar *xml_path, gpointer cpe_index)
+{
+  return update_cve_xml (xml_path, cpe_index);
+}
+
+/**
+ * @brief Free the modification times of the previous CVEs.
+ */
+static void
+free_previous_cves ()
+{
+  if (previous_cves)
+    {
+      g_hash_table_destroy (previous_cves);
+      previous_cves = NULL;
+    }
+}
+
 /**
  * @brief Update SCAP CVEs.
  *
  * Assume that the databases are attached.
  *
+ * @param[in]  incremental  Whether scap2 holds a copy of the previous data.
+ *
  * @return 0 success, -1 error.
  */
 static int
-update_scap_cves ()
+update_scap_cves (gboolean incremental)
 {
   GError *error;
   int count;
   GDir *dir;
   const gchar *xml_path;
-  GHashTable *hashed_cpes;
-  iterator_t cpes;
+  cpe_index_t cpe_index;
 
   error = NULL;
   dir = g_dir_open (GVM_SCAP_DATA_DIR, 0, &error);
@@ -2624,22 +3355,68 @@ update_scap_cves ()
       return -1;
     }
 
-  hashed_cpes = g_hash_table_new (g_str_hash, g_str_equal);
-  init_iterator (&cpes, "SELECT uuid, id FROM scap2.cpes;");
-  while (next (&cpes))
-    g_hash_table_insert (hashed_cpes,
-                         (gpointer*) iterator_string (&cpes, 0),
-                         GINT_TO_POINTER (iterator_int (&cpes, 1)));
+  cpe_index_init (&cpe_index);
+
+  if (incremental)
+    {
+      iterator_t cves;
+
+      previous_cves = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, NULL);
+      init_iterator (&cves,
+                     "SELECT name, modification_time FROM scap2.cves;");
+      while (next (&cves))
+        g_hash_table_insert (previous_cves,
+                             g_strdup (iterator_string (&cves, 0)),
+                             GINT_TO_POINTER (iterator_int (&cves, 1)));
+      cleanup_iterator (&cves);
+    }
+
+  if (scap_workers > 1)
+    {
+      GPtrArray *paths;
+      int ret;
+
+      paths = g_ptr_array_new_with_free_func (g_free);
+      while ((xml_path = g_dir_read_name (dir)))
+        if (fnmatch ("nvdcve-2.0-*.xml", xml_path, 0) == 0)
+          g_ptr_array_add (paths, g_strdup (xml_path));
+      g_dir_close (dir);
+
+      if (paths->len == 0)
+        g_warning ("No CVEs found in %s", GVM_SCAP_DATA_DIR);
+
+      sql ("CREATE UNLOGGED TABLE scap2.affected_products_staging"
+           " (cve INTEGER,"
+           "  cpe text,"
+           "  creation_time INTEGER,"
+           "  modification_time INTEGER);");
+
+      cve_products_staged = TRUE;
+      ret = update_scap_files_parallel (paths, update_cve_xml_from_path,
+                                        &cpe_index);
+      cve_products_staged = FALSE;
+
+      g_ptr_array_free (paths, TRUE);
+      cpe_index_free (&cpe_index);
+      free_previous_cves ();
+
+      if (ret == 0)
+        merge_cve_products_staged ();
+      else
+        sql ("DROP TABLE scap2.affected_products_staging;");
+      return ret;
+    }
 
   count = 0;
   while ((xml_path = g_dir_read_name (dir)))
     if (fnmatch ("nvdcve-2.0-*.xml", xml_path, 0) == 0)
       {
-        if (update_cve_xml (xml_path, hashed_cpes))
+        if (update_cve_xml (xml_path, &cpe_index))
           {
             g_dir_close (dir);
-            g_hash_table_destroy (hashed_cpes);
-            cleanup_iterator (&cpes);
+            cpe_index_free (&cpe_index);
+            free_previous_cves ();
             return -1;
           }
         count++;
@@ -2649,8 +3426,8 @@ update_scap_cves ()
     g_warning ("No CVEs found in %s", GVM_SCAP_DATA_DIR);
 
   g_dir_close (dir);
-  g_hash_table_destroy (hashed_cpes);
-  cleanup_iterator (&cpes);
+  cpe_index_free (&cpe_index);
+  free_previous_cves ();
   return 0;
 }
 
@@ -2682,12 +3459,14 @@ manage_db_reinit (const gchar *name)
  * @param[in]  sigmask_current    Sigmask to restore in child.
  * @param[in]  update             Function to do the sync.
  * @param[in]  process_title      Process title.
+ * @param[in]  metric             Metric for the duration of the sync.
  */
 static void
 sync_secinfo (sigset_t *sigmask_current, int (*update) (void),
-              const gchar *process_title)
+              const gchar *process_title, metric_t metric)
 {
   int pid;
+  gint64 start;
 
   /* Fork a child to sync the db, so that the parent can return to the main
    * loop. */
@@ -2730,8 +3509,10 @@ sync_secinfo (sigset_t *sigmask_current, int (*update) (void),
 
   proctitle_set (process_title);
 
+  start = g_get_monotonic_time ();
   if (update () == 0)
     {
+      metrics_set (metric, g_get_monotonic_time () - start);
       check_alerts ();
     }
 
@@ -2940,20 +3721,70 @@ update_cert_timestamp ()
   return 0;
 }
 
+/**
+ * @brief Get the clause that limits a Max CVSS update to changed advisories.
+ *
+ * @param[in]  type        Advisory type: "dfn_cert" or "cert_bund".
+ * @param[in]  advs_since  Update advisories modified after this time.  0 to
+ *                         update all advisories, -1 to skip this check.
+ * @param[in]  cves_since  Update advisories that refer to CVEs modified after
+ *                         this time.  0 to update all advisories, -1 to skip
+ *                         this check.
+ *
+ * @return Freshly allocated WHERE clause, or NULL if nothing changed.
+ */
+static gchar *
+cvss_cert_clause (const gchar *type, int advs_since, int cves_since)
+{
+  if (advs_since == -1 && cves_since == -1)
+    return NULL;
+
+  if (advs_since == 0 || cves_since == 0)
+    return g_strdup ("");
+
+  if (cves_since == -1)
+    return g_strdup_printf (" WHERE modification_time > %i", advs_since);
+
+  if (advs_since == -1)
+    return g_strdup_printf (" WHERE id IN (SELECT adv_id FROM cert.%s_cves"
+                            "              WHERE cve_name"
+                            "                    IN (SELECT name"
+                            "                        FROM scap.cves"
+                            "                        WHERE modification_time"
+                            "                              > %i))",
+                            type,
+                            cves_since);
+
+  return g_strdup_printf (" WHERE modification_time > %i"
+                          " OR id IN (SELECT adv_id FROM cert.%s_cves"
+                          "           WHERE cve_name"
+                          "                 IN (SELECT name"
+                          "                     FROM scap.cves"
+                          "                     WHERE modification_time"
+                          "                           > %i))",
+                          advs_since,
+                          type,
+                          cves_since);
+}
+
 /**
  * @brief Update DFN-CERT Max CVSS.
  *
- * @param[in]  updated_dfn_cert  Whether CERT-Bund updated.
- * @param[in]  last_cert_update  Time of last CERT update.
- * @param[in]  last_scap_update  Time of last SCAP update.
+ * @param[in]  advs_since  Update advisories modified after this time.  0 to
+ *                         update all advisories, -1 to skip this check.
+ * @param[in]  cves_since  Update advisories that refer to CVEs modified after
+ *                         this time.  0 to update all advisories, -1 to skip
+ *                         this check.
  */
 static void
-update_cvss_dfn_cert (int updated_dfn_cert, int last_cert_update,
-                      int last_scap_update)
+update_cvss_dfn_cert (int advs_since, int cves_since)
 {
+  gchar *clause;
+
   /* TODO greenbone-certdata-sync did retries. */
 
-  if (updated_dfn_cert || (last_scap_update > last_cert_update))
+  clause = cvss_cert_clause ("dfn_cert", advs_since, cves_since);
+  if (clause)
     {
       g_info ("Updating Max CVSS for DFN-CERT");
       sql ("UPDATE cert.dfn_cert_advs"
@@ -2963,7 +3794,10 @@ update_cvss_dfn_cert (int updated_dfn_cert, int last_cert_update,
            "                  IN (SELECT cve_name"
            "                      FROM cert.dfn_cert_cves"
            "                      WHERE adv_id = dfn_cert_advs.id)"
-           "                  AND severity != 0);");
+           "                  AND severity != 0)"
+           "%s;",
+           clause);
+      g_free (clause);
 
       g_info ("Updating DFN-CERT CVSS max succeeded.");
     }
@@ -2974,17 +3808,21 @@ update_cvss_dfn_cert (int updated_dfn_cert, int last_cert_update,
 /**
  * @brief Update CERT-Bund Max CVSS.
  *
- * @param[in]  updated_cert_bund  Whether CERT-Bund updated.
- * @param[in]  last_cert_update  Time of last CERT update.
- * @param[in]  last_scap_update  Time of last SCAP update.
+ * @param[in]  advs_since  Update advisories modified after this time.  0 to
+ *                         update all advisories, -1 to skip this check.
+ * @param[in]  cves_since  Update advisories that refer to CVEs modified after
+ *                         this time.  0 to update all advisories, -1 to skip
+ *                         this check.
  */
 static void
-update_cvss_cert_bund (int updated_cert_bund, int last_cert_update,
-                       int last_scap_update)
+update_cvss_cert_bund (int advs_since, int cves_since)
 {
+  gchar *clause;
+
   /* TODO greenbone-certdata-sync did retries. */
 
-  if (updated_cert_bund || (last_scap_update > last_cert_update))
+  clause = cvss_cert_clause ("cert_bund", advs_since, cves_since);
+  if (clause)
     {
       g_info ("Updating Max CVSS for CERT-Bund");
       sql ("UPDATE cert.cert_bund_advs"
@@ -2994,7 +3832,10 @@ update_cvss_cert_bund (int updated_cert_bund, int last_cert_update,
            "                     IN (SELECT cve_name"
            "                         FROM cert.cert_bund_cves"
            "                         WHERE adv_id = cert_bund_advs.id)"
-           "                  AND severity != 0);");
+           "                  AND severity != 0)"
+           "%s;",
+           clause);
+      g_free (clause);
 
       g_info ("Updating CERT-Bund CVSS max succeeded.");
     }
@@ -3012,7 +3853,7 @@ sync_cert ()
 {
   int scap_db_version;
   int last_feed_update, last_cert_update, updated_dfn_cert;
-  int updated_cert_bund;
+  int updated_cert_bund, last_dfn_update, last_bund_update;
 
   if (manage_cert_db_exists ())
     {
@@ -3060,13 +3901,21 @@ sync_cert ()
 
   g_debug ("%s: update dfn", __func__);
 
-  updated_dfn_cert = update_dfn_cert_advisories (last_cert_update);
+  last_dfn_update = sql_int ("SELECT max (modification_time)"
+                             " FROM cert.dfn_cert_advs;");
+
+  updated_dfn_cert = update_dfn_cert_advisories (last_cert_update,
+                                                 last_dfn_update);
   if (updated_dfn_cert == -1)
     goto fail;
 
   g_debug ("%s: update bund", __func__);
 
-  updated_cert_bund = update_cert_bund_advisories (last_cert_update);
+  last_bund_update = sql_int ("SELECT max (modification_time)"
+                              " FROM cert.cert_bund_advs;");
+
+  updated_cert_bund = update_cert_bund_advisories (last_cert_update,
+                                                   last_bund_update);
   if (updated_cert_bund == -1)
     goto fail;
 
@@ -3086,7 +3935,7 @@ sync_cert ()
                " skipping CERT severity score update");
   else
     {
-      int last_scap_update;
+      int last_scap_update, cves_since;
 
       last_scap_update
         = sql_int ("SELECT coalesce ((SELECT value FROM scap.meta"
@@ -3095,12 +3944,17 @@ sync_cert ()
       g_debug ("%s: last_scap_update: %i", __func__, last_scap_update);
       g_debug ("%s: last_cert_update: %i", __func__, last_cert_update);
 
-      update_cvss_dfn_cert (updated_dfn_cert,
-                            last_cert_update,
-                            last_scap_update);
-      update_cvss_cert_bund (updated_cert_bund,
-                             last_cert_update,
-                             last_scap_update);
+      /* Only the advisories that changed, and the advisories that refer to
+       * CVEs that changed since the last CERT update, need new scores. */
+      if (last_scap_update > last_cert_update)
+        cves_since = last_cert_update;
+      else
+        cves_since = -1;
+
+      update_cvss_dfn_cert (updated_dfn_cert ? last_dfn_update : -1,
+                            cves_since);
+      update_cvss_cert_bund (updated_cert_bund ? last_bund_update : -1,
+                             cves_since);
     }
 
   g_debug ("%s: update timestamp", __func__);
@@ -3126,7 +3980,8 @@ manage_sync_cert (sigset_t *sigmask_current)
 {
   sync_secinfo (sigmask_current,
                 sync_cert,
-                "gvmd: Syncing CERT");
+                "gvmd: Syncing CERT",
+                METRIC_FEED_SYNC_TIME_CERT);
 }
 
 
@@ -3256,10 +4111,13 @@ update_scap_placeholders ()
 /**
  * @brief Finish scap update.
  *
+ * @param[in]  previous_update  Time of the SCAP data that the update started
+ *                              from, 0 if rebuilt from scratch.
+ *
  * @return 0 success, -1 error.
  */
 static int
-update_scap_end ()
+update_scap_end (int previous_update)
 {
   int cert_db_version;
 
@@ -3298,23 +4156,13 @@ update_scap_end ()
                " skipping CERT severity score update");
   else
     {
-      int last_cert_update, last_scap_update;
-
-      last_cert_update = sql_int ("SELECT"
-                                  " coalesce ((SELECT value FROM cert.meta"
-                                  "            WHERE name = 'last_update'),"
-                                  "           '0');");
+      /* Only advisories that refer to CVEs that changed since the previous
+       * SCAP data need new scores. */
 
-      last_scap_update = sql_int ("SELECT"
-                                  " coalesce ((SELECT value FROM scap.meta"
-                                  "            WHERE name = 'last_update'),"
-                                  "           '0');");
+      g_debug ("%s: previous_update: %i", __func__, previous_update);
 
-      g_debug ("%s: last_scap_update: %i", __func__, last_scap_update);
-      g_debug ("%s: last_cert_update: %i", __func__, last_cert_update);
-
-      update_cvss_dfn_cert (1, last_cert_update, last_scap_update);
-      update_cvss_cert_bund (1, last_cert_update, last_scap_update);
+      update_cvss_dfn_cert (-1, previous_update);
+      update_cvss_cert_bund (-1, previous_update);
     }
 
   /* Analyze. */
@@ -3329,6 +4177,49 @@ update_scap_end ()
   return 0;
 }
 
+/**
+ * @brief Copy the data of the current SCAP schema into scap2.
+ *
+ * The IDs are kept, so the copied affected products stay valid.
+ */
+static void
+copy_scap_previous ()
+{
+  g_info ("%s: Copying previous SCAP data", __func__);
+
+  sql_begin_immediate ();
+
+  sql ("INSERT INTO scap2.cpes"
+       " (id, uuid, name, comment, creation_time, modification_time, title,"
+       "  status, deprecated_by_id, severity, cve_refs, nvd_id)"
+       " SELECT id, uuid, name, comment, creation_time, modification_time,"
+       "        title, status, deprecated_by_id, severity, cve_refs, nvd_id"
+       " FROM scap.cpes;");
+
+  sql ("INSERT INTO scap2.cves"
+       " (id, uuid, name, comment, description, creation_time,"
+       "  modification_time, cvss_vector, products, severity)"
+       " SELECT id, uuid, name, comment, description, creation_time,"
+       "        modification_time, cvss_vector, products, severity"
+       " FROM scap.cves;");
+
+  sql ("INSERT INTO scap2.affected_products (cve, cpe)"
+       " SELECT cve, cpe FROM scap.affected_products;");
+
+  sql ("SELECT setval ('scap2.cpes_id_seq',"
+       "               coalesce ((SELECT max (id) FROM scap2.cpes), 0) + 1,"
+       "               false);");
+  sql ("SELECT setval ('scap2.cves_id_seq',"
+       "               coalesce ((SELECT max (id) FROM scap2.cves), 0) + 1,"
+       "               false);");
+
+  sql ("INSERT INTO scap2.meta (name, value)"
+       " SELECT name, value FROM scap.meta"
+       " WHERE name LIKE 'file_hash:%%';");
+
+  sql_commit ();
+}
+
 /**
  * @brief Try load the feed from feed CSV files.
  *
@@ -3388,7 +4279,7 @@ try_load_csv ()
           return -1;
         }
 
-      return update_scap_end ();
+      return update_scap_end (0);
     }
   return 1;
 }
@@ -3403,6 +4294,9 @@ try_load_csv ()
 static int
 update_scap (gboolean reset_scap_db)
 {
+  int previous_update;
+
+  previous_update = 0;
   if (reset_scap_db)
     g_warning ("%s: Full rebuild requested, resetting SCAP db",
                __func__);
@@ -3443,6 +4337,8 @@ update_scap (gboolean reset_scap_db)
                          __func__);
               return -1;
             }
+
+          previous_update = last_scap_update;
         }
     }
 
@@ -3476,6 +4372,15 @@ update_scap (gboolean reset_scap_db)
       return -1;
     }
 
+  /* Start from the previous data, so that unchanged files and entries can
+   * be skipped. */
+
+  if (previous_update)
+    {
+      proctitle_set ("gvmd: Syncing SCAP: Copying previous data");
+      copy_scap_previous ();
+    }
+
   /* Update into the new schema. */
 
   g_debug ("%s: sync", __func__);
@@ -3491,7 +4396,7 @@ update_scap (gboolean reset_scap_db)
   g_debug ("%s: update cves", __func__);
   proctitle_set ("gvmd: Syncing SCAP: Updating CVEs");
 
-  if (update_scap_cves () == -1)
+  if (update_scap_cves (previous_update > 0) == -1)
     return -1;
 
   g_debug ("%s: updating user defined data", __func__);
@@ -3509,7 +4414,7 @@ update_scap (gboolean reset_scap_db)
 
   update_scap_placeholders ();
 
-  return update_scap_end ();
+  return update_scap_end (previous_update);
 }
 
 /**
@@ -3533,7 +4438,8 @@ manage_sync_scap (sigset_t *sigmask_current)
 {
   sync_secinfo (sigmask_current,
                 sync_scap,
-                "gvmd: Syncing SCAP");
+                "gvmd: Syncing SCAP",
+                METRIC_FEED_SYNC_TIME_SCAP);
 }
 
 /**
@@ -3616,3 +4522,30 @@ set_secinfo_commit_size (int new_commit_size)
   else
     secinfo_commit_size = new_commit_size;
 }
+
+/**
+ * @brief Get the number of SCAP worker processes.
+ *
+ * @return Number of SCAP worker processes.
+ */
+int
+get_scap_workers ()
+{
+  return scap_workers;
+}
+
+/**
+ * @brief Set the number of SCAP worker processes.
+ *
+ * @param[in]  new_workers  New number of worker processes.
+ */
+void
+set_scap_workers (int new_workers)
+{
+  if (new_workers < 0)
+    scap_workers = 0;
+  else if (new_workers > SCAP_WORKERS_MAX)
+    scap_workers = SCAP_WORKERS_MAX;
+  else
+    scap_workers = new_workers;
+}
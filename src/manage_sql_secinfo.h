@@ -168,6 +168,16 @@
  */
 #define SECINFO_COMMIT_SIZE_DEFAULT 0
 
+/**
+ * @brief Default number of worker processes that load SCAP files.
+ */
+#define SCAP_WORKERS_DEFAULT 0
+
+/**
+ * @brief Maximum number of worker processes that load SCAP files.
+ */
+#define SCAP_WORKERS_MAX 64
+
 int
 secinfo_feed_version_status ();
 
@@ -192,4 +202,10 @@ get_secinfo_commit_size ();
 void
 set_secinfo_commit_size (int);
 
+int
+get_scap_workers ();
+
+void
+set_scap_workers (int);
+
 #endif /* not _GVMD_MANAGE_SQL_SECINFO_H */
@@ -0,0 +1,147 @@
+/* Copyright (C) 2021 Greenbone Networks GmbH
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "manage_sql_secinfo.c"
+
+#include <cgreen/cgreen.h>
+
+Describe (manage_sql_secinfo);
+BeforeEach (manage_sql_secinfo) {}
+AfterEach (manage_sql_secinfo) {}
+
+/* cpe_index */
+
+/**
+ * @brief Set up an empty CPE index without the database.
+ *
+ * @param[out]  index  Index.
+ * @param[in]   slots  Number of slots, a power of two.
+ */
+static void
+cpe_index_init_empty (cpe_index_t *index, guint slots)
+{
+  index->names = g_string_new ("");
+  index->slots = g_new0 (cpe_index_slot_t, slots);
+  index->mask = slots - 1;
+  index->count = 0;
+}
+
+Ensure (manage_sql_secinfo, cpe_index_lookup_finds_added_cpes)
+{
+  cpe_index_t index;
+
+  cpe_index_init_empty (&index, 16);
+  cpe_index_add (&index, "cpe:/a:apache:http_server:2.4.1", 1);
+  cpe_index_add (&index, "cpe:/o:linux:linux_kernel:5.10", 2);
+  cpe_index_add (&index, "cpe:/a:openbsd:openssh:8.4", 3);
+
+  assert_that (index.count, is_equal_to (3));
+  assert_that (cpe_index_lookup (&index, "cpe:/a:apache:http_server:2.4.1"),
+               is_equal_to (1));
+  assert_that (cpe_index_lookup (&index, "cpe:/o:linux:linux_kernel:5.10"),
+               is_equal_to (2));
+  assert_that (cpe_index_lookup (&index, "cpe:/a:openbsd:openssh:8.4"),
+               is_equal_to (3));
+
+  cpe_index_free (&index);
+}
+
+Ensure (manage_sql_secinfo, cpe_index_lookup_returns_0_for_missing_cpe)
+{
+  cpe_index_t index;
+
+  cpe_index_init_empty (&index, 16);
+  assert_that (cpe_index_lookup (&index, "cpe:/a:apache:http_server"),
+               is_equal_to (0));
+
+  cpe_index_add (&index, "cpe:/a:apache:http_server:2.4.1", 1);
+  assert_that (cpe_index_lookup (&index, "cpe:/a:apache:http_server"),
+               is_equal_to (0));
+  assert_that (cpe_index_lookup (&index, ""), is_equal_to (0));
+
+  cpe_index_free (&index);
+}
+
+Ensure (manage_sql_secinfo, cpe_index_add_ignores_duplicates)
+{
+  cpe_index_t index;
+  gsize length;
+
+  cpe_index_init_empty (&index, 16);
+  cpe_index_add (&index, "cpe:/a:openbsd:openssh:8.4", 3);
+  length = index.names->len;
+  cpe_index_add (&index, "cpe:/a:openbsd:openssh:8.4", 4);
+
+  assert_that (index.count, is_equal_to (1));
+  assert_that (index.names->len, is_equal_to (length));
+  assert_that (cpe_index_lookup (&index, "cpe:/a:openbsd:openssh:8.4"),
+               is_equal_to (3));
+
+  cpe_index_free (&index);
+}
+
+Ensure (manage_sql_secinfo, cpe_index_add_skips_cpes_when_full)
+{
+  cpe_index_t index;
+  int id;
+
+  /* A full table keeps one slot free, so that lookups terminate. */
+  cpe_index_init_empty (&index, 4);
+  for (id = 1; id <= 4; id++)
+    {
+      gchar *name;
+
+      name = g_strdup_printf ("cpe:/a:vendor:product:%i", id);
+      cpe_index_add (&index, name, id);
+      g_free (name);
+    }
+
+  assert_that (index.count, is_equal_to (3));
+  assert_that (cpe_index_lookup (&index, "cpe:/a:vendor:product:1"),
+               is_equal_to (1));
+  assert_that (cpe_index_lookup (&index, "cpe:/a:vendor:product:3"),
+               is_equal_to (3));
+  assert_that (cpe_index_lookup (&index, "cpe:/a:vendor:product:4"),
+               is_equal_to (0));
+
+  cpe_index_free (&index);
+}
+
+/* Test suite. */
+
+int
+main (int argc, char **argv)
+{
+  TestSuite *suite;
+
+  suite = create_test_suite ();
+
+  add_test_with_context (suite, manage_sql_secinfo,
+                         cpe_index_lookup_finds_added_cpes);
+  add_test_with_context (suite, manage_sql_secinfo,
+                         cpe_index_lookup_returns_0_for_missing_cpe);
+  add_test_with_context (suite, manage_sql_secinfo,
+                         cpe_index_add_ignores_duplicates);
+  add_test_with_context (suite, manage_sql_secinfo,
+                         cpe_index_add_skips_cpes_when_full);
+
+  if (argc > 1)
+    return run_single_test (suite, argv[1], create_text_reporter ());
+
+  return run_test_suite (suite, create_text_reporter ());
+}
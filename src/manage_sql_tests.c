@@ -158,6 +158,353 @@ Ensure (manage_sql, streq_ignore_ws_handles_null)
   DIFF ("abc", NULL);
 }
 
+/* filter_clause cache */
+
+Ensure (manage_sql, filter_has_time_keyword_finds_dates)
+{
+  assert_that (filter_has_time_keyword ("modified>-1d"), is_equal_to (1));
+  assert_that (filter_has_time_keyword ("name=x created<2w"), is_equal_to (1));
+  assert_that (filter_has_time_keyword ("modified>2021-01-31"),
+               is_equal_to (1));
+  assert_that (filter_has_time_keyword ("modified>2021-01-31T10:20"),
+               is_equal_to (1));
+}
+
+Ensure (manage_sql, filter_has_time_keyword_ignores_other_keywords)
+{
+  assert_that (filter_has_time_keyword (""), is_equal_to (0));
+  assert_that (filter_has_time_keyword ("name=x rows=10 first=1"),
+               is_equal_to (0));
+  assert_that (filter_has_time_keyword ("severity>5.5 sort=name"),
+               is_equal_to (0));
+}
+
+Ensure (manage_sql, filter_clause_cache_key_includes_time_zone)
+{
+  gchar *berlin, *utc;
+
+  setenv ("TZ", "Europe/Berlin", 1);
+  berlin = filter_clause_cache_key ("task", "name=x", NULL, NULL, NULL, 0);
+  setenv ("TZ", "UTC", 1);
+  utc = filter_clause_cache_key ("task", "name=x", NULL, NULL, NULL, 0);
+
+  assert_that (berlin, is_not_equal_to_string (utc));
+
+  g_free (berlin);
+  g_free (utc);
+}
+
+Ensure (manage_sql, filter_clause_cache_key_includes_trash)
+{
+  gchar *trash, *live;
+
+  trash = filter_clause_cache_key ("task", "name=x", NULL, NULL, NULL, 1);
+  live = filter_clause_cache_key ("task", "name=x", NULL, NULL, NULL, 0);
+
+  assert_that (trash, is_not_equal_to_string (live));
+
+  g_free (trash);
+  g_free (live);
+}
+
+/* keyset_token, filter_term_after */
+
+Ensure (manage_sql, keyset_token_is_opaque)
+{
+  gchar *token;
+
+  token = keyset_token (1234, "5b6f8d4e-2c5e-4f9e-8b5f-0e6c2c1d9a7f");
+  assert_that (token,
+               is_equal_to_string
+                ("MTIzNDo1YjZmOGQ0ZS0yYzVlLTRmOWUtOGI1Zi0wZTZjMmMxZDlhN2Y"));
+  assert_that (strstr (token, "1234"), is_null);
+  assert_that (strstr (token, "5b6f8d4e"), is_null);
+  g_free (token);
+}
+
+Ensure (manage_sql, filter_term_after_gets_token)
+{
+  resource_t after;
+  gchar *after_uuid, *token, *term;
+
+  after = 1;
+  after_uuid = NULL;
+  assert_that (filter_term_after ("rows=10 after=", &after, &after_uuid),
+               is_equal_to (1));
+  assert_that (after, is_equal_to (0));
+  assert_that (after_uuid, is_null);
+
+  token = keyset_token (1234, "5b6f8d4e-2c5e-4f9e-8b5f-0e6c2c1d9a7f");
+  term = g_strdup_printf ("rows=10 after=%s", token);
+  assert_that (filter_term_after (term, &after, &after_uuid),
+               is_equal_to (1));
+  assert_that (after, is_equal_to (1234));
+  assert_that (after_uuid,
+               is_equal_to_string ("5b6f8d4e-2c5e-4f9e-8b5f-0e6c2c1d9a7f"));
+  g_free (after_uuid);
+  g_free (term);
+  g_free (token);
+}
+
+Ensure (manage_sql, filter_term_after_handles_missing_keyword)
+{
+  resource_t after;
+  gchar *after_uuid;
+
+  after = 1;
+  after_uuid = NULL;
+  assert_that (filter_term_after ("rows=10 first=11", &after, &after_uuid),
+               is_equal_to (0));
+  assert_that (after, is_equal_to (0));
+  assert_that (after_uuid, is_null);
+}
+
+Ensure (manage_sql, filter_term_after_rejects_invalid_token)
+{
+  resource_t after;
+
+  /* Bare row ids and UUIDs are not tokens. */
+  assert_that (filter_term_after ("after=1234", &after, NULL),
+               is_equal_to (-1));
+  assert_that (filter_term_after ("after=5b6f8d4e-2c5e-4f9e-8b5f-0e6c2c1d9a7f",
+                                  &after, NULL),
+               is_equal_to (-1));
+  assert_that (filter_term_after ("after=-5", &after, NULL), is_equal_to (-1));
+  assert_that (filter_term_after ("after=12x", &after, NULL),
+               is_equal_to (-1));
+  /* Encodes "1234:not a uuid". */
+  assert_that (filter_term_after ("after=MTIzNDpub3QgYSB1dWlk", &after, NULL),
+               is_equal_to (-1));
+  assert_that (filter_term_after ("after=MTIz+NDo", &after, NULL),
+               is_equal_to (-1));
+}
+
+/* osp_report_handle_start_element, osp_report_handle_end_element */
+
+/**
+ * @brief Parse an OSP report with the report handlers, in chunks.
+ *
+ * The results in the report must lack the host attribute, so that
+ * they are counted but never reach the database.
+ *
+ * @param[in]  parser  Parser.
+ * @param[in]  xml     Report XML.
+ * @param[in]  chunk   Number of bytes to pass to the parser at a time.
+ */
+static void
+parse_osp_report_in_chunks (osp_report_parser_t *parser, const char *xml,
+                            gsize chunk)
+{
+  GMarkupParser xml_parser;
+  GMarkupParseContext *xml_context;
+  gsize offset, length;
+
+  memset (&xml_parser, 0, sizeof (xml_parser));
+  xml_parser.start_element = osp_report_handle_start_element;
+  xml_parser.end_element = osp_report_handle_end_element;
+  xml_parser.text = osp_report_handle_text;
+
+  memset (parser, 0, sizeof (*parser));
+  parser->attributes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, g_free);
+  parser->text = g_string_new ("");
+  parser->host_ends = g_ptr_array_new_with_free_func (g_free);
+
+  xml_context = g_markup_parse_context_new (&xml_parser, 0, parser, NULL);
+  length = strlen (xml);
+  for (offset = 0; offset < length; offset += chunk)
+    assert_that (g_markup_parse_context_parse (xml_context, xml + offset,
+                                               MIN (chunk, length - offset),
+                                               NULL),
+                 is_true);
+  assert_that (g_markup_parse_context_end_parse (xml_context, NULL), is_true);
+  g_markup_parse_context_free (xml_context);
+}
+
+/**
+ * @brief Free the state of an OSP report parser.
+ *
+ * @param[in]  parser  Parser.
+ */
+static void
+osp_report_parser_free (osp_report_parser_t *parser)
+{
+  g_hash_table_destroy (parser->attributes);
+  g_string_free (parser->text, TRUE);
+  g_ptr_array_free (parser->host_ends, TRUE);
+}
+
+Ensure (manage_sql, osp_report_parser_counts_results_across_chunks)
+{
+  osp_report_parser_t parser;
+
+  parse_osp_report_in_chunks (&parser,
+                              "<scan>"
+                              "<results>"
+                              "<result type=\"Alarm\" name=\"a\">one</result>"
+                              "<result type=\"Log Message\">two</result>"
+                              "<result/>"
+                              "</results>"
+                              "</scan>",
+                              7);
+
+  assert_that (parser.results_seen, is_true);
+  assert_that (parser.has_results, is_true);
+  assert_that (parser.result_count, is_equal_to (3));
+  assert_that (parser.in_result, is_false);
+  assert_that (parser.depth, is_equal_to (0));
+  assert_that (parser.host_ends->len, is_equal_to (0));
+
+  osp_report_parser_free (&parser);
+}
+
+Ensure (manage_sql, osp_report_parser_clears_result_after_each_result)
+{
+  osp_report_parser_t parser;
+
+  parse_osp_report_in_chunks (&parser,
+                              "<scan>"
+                              "<results>"
+                              "<result type=\"Alarm\" qod=\"70\">"
+                              "some <x>nested</x> text"
+                              "</result>"
+                              "</results>"
+                              "</scan>",
+                              1);
+
+  assert_that (parser.result_count, is_equal_to (1));
+  assert_that (g_hash_table_size (parser.attributes), is_equal_to (0));
+  assert_that (parser.text->len, is_equal_to (0));
+
+  osp_report_parser_free (&parser);
+}
+
+Ensure (manage_sql, osp_report_parser_skips_other_entries)
+{
+  osp_report_parser_t parser;
+
+  parse_osp_report_in_chunks (&parser,
+                              "<scan>"
+                              "<results><status/><result/></results>"
+                              "</scan>",
+                              64);
+
+  assert_that (parser.results_seen, is_true);
+  assert_that (parser.result_count, is_equal_to (1));
+  assert_that (parser.in_result, is_false);
+
+  osp_report_parser_free (&parser);
+}
+
+Ensure (manage_sql, osp_report_parser_needs_results_element)
+{
+  osp_report_parser_t parser;
+
+  parse_osp_report_in_chunks (&parser,
+                              "<scan>"
+                              "<status><result/></status>"
+                              "<result/>"
+                              "</scan>",
+                              64);
+
+  assert_that (parser.results_seen, is_false);
+  assert_that (parser.has_results, is_false);
+  assert_that (parser.result_count, is_equal_to (0));
+
+  osp_report_parser_free (&parser);
+}
+
+/* report_render */
+
+Ensure (manage_sql, report_render_intern_shares_equal_strings)
+{
+  report_render_t render;
+  gchar *copy;
+  const gchar *one, *two;
+
+  report_render_init (&render);
+  copy = g_strdup ("general/tcp");
+
+  one = report_render_intern (&render, "general/tcp");
+  two = report_render_intern (&render, copy);
+  assert_that (one, is_equal_to_string ("general/tcp"));
+  assert_that (two, is_equal_to (one));
+  assert_that (two, is_not_equal_to (copy));
+  assert_that (report_render_intern (&render, "80/tcp"),
+               is_not_equal_to (one));
+  assert_that (report_render_intern (&render, NULL), is_null);
+
+  g_free (copy);
+  report_render_free (&render);
+}
+
+Ensure (manage_sql, report_render_add_host_keeps_first_of_each_host)
+{
+  report_render_t render;
+  gchar *copy;
+
+  report_render_init (&render);
+  copy = g_strdup ("192.168.0.1");
+
+  report_render_add_host (&render, "192.168.0.2");
+  report_render_add_host (&render, "192.168.0.1");
+  report_render_add_host (&render, copy);
+  report_render_add_host (&render, "192.168.0.2");
+
+  assert_that (render.hosts->len, is_equal_to (2));
+  assert_that (g_ptr_array_index (render.hosts, 0),
+               is_equal_to_string ("192.168.0.2"));
+  assert_that (g_ptr_array_index (render.hosts, 1),
+               is_equal_to_string ("192.168.0.1"));
+  assert_that (g_ptr_array_index (render.hosts, 1),
+               is_equal_to (report_render_intern (&render, copy)));
+
+  g_free (copy);
+  report_render_free (&render);
+}
+
+Ensure (manage_sql, report_render_strings_sort_results)
+{
+  report_render_t render;
+  GArray *results;
+  result_buffer_t item;
+
+  report_render_init (&render);
+  results = g_array_new (FALSE, FALSE, sizeof (result_buffer_t));
+
+  item.host = report_render_intern (&render, "192.168.0.2");
+  item.port = report_render_intern (&render, "80/tcp");
+  item.severity = report_render_intern (&render, "5.0");
+  item.severity_double = 5.0;
+  g_array_append_val (results, item);
+
+  item.host = report_render_intern (&render, "192.168.0.1");
+  item.port = report_render_intern (&render, "22/tcp");
+  item.severity = report_render_intern (&render, "2.0");
+  item.severity_double = 2.0;
+  g_array_append_val (results, item);
+
+  item.host = report_render_intern (&render, "192.168.0.1");
+  item.port = report_render_intern (&render, "443/tcp");
+  item.severity = report_render_intern (&render, "7.5");
+  item.severity_double = 7.5;
+  g_array_append_val (results, item);
+
+  g_array_sort (results, compare_severity_desc);
+
+  assert_that (g_array_index (results, result_buffer_t, 0).port,
+               is_equal_to_string ("443/tcp"));
+  assert_that (g_array_index (results, result_buffer_t, 1).port,
+               is_equal_to_string ("22/tcp"));
+  assert_that (g_array_index (results, result_buffer_t, 2).port,
+               is_equal_to_string ("80/tcp"));
+  assert_that (g_array_index (results, result_buffer_t, 1).host,
+               is_equal_to (g_array_index (results, result_buffer_t, 0).host));
+
+  g_array_free (results, TRUE);
+  report_render_free (&render);
+}
+
 /* Test suite. */
 
 int
@@ -175,6 +522,38 @@ main (int argc, char **argv)
   add_test_with_context (suite, manage_sql, streq_ignore_ws_finds_diff_incl_ws);
   add_test_with_context (suite, manage_sql, streq_ignore_ws_handles_null);
 
+  add_test_with_context (suite, manage_sql,
+                         filter_has_time_keyword_finds_dates);
+  add_test_with_context (suite, manage_sql,
+                         filter_has_time_keyword_ignores_other_keywords);
+  add_test_with_context (suite, manage_sql,
+                         filter_clause_cache_key_includes_time_zone);
+  add_test_with_context (suite, manage_sql,
+                         filter_clause_cache_key_includes_trash);
+
+  add_test_with_context (suite, manage_sql, keyset_token_is_opaque);
+  add_test_with_context (suite, manage_sql, filter_term_after_gets_token);
+  add_test_with_context (suite, manage_sql,
+                         filter_term_after_handles_missing_keyword);
+  add_test_with_context (suite, manage_sql,
+                         filter_term_after_rejects_invalid_token);
+
+  add_test_with_context (suite, manage_sql,
+                         osp_report_parser_counts_results_across_chunks);
+  add_test_with_context (suite, manage_sql,
+                         osp_report_parser_clears_result_after_each_result);
+  add_test_with_context (suite, manage_sql,
+                         osp_report_parser_skips_other_entries);
+  add_test_with_context (suite, manage_sql,
+                         osp_report_parser_needs_results_element);
+
+  add_test_with_context (suite, manage_sql,
+                         report_render_intern_shares_equal_strings);
+  add_test_with_context (suite, manage_sql,
+                         report_render_add_host_keeps_first_of_each_host);
+  add_test_with_context (suite, manage_sql,
+                         report_render_strings_sort_results);
+
   if (argc > 1)
     return run_single_test (suite, argv[1], create_text_reporter ());
 
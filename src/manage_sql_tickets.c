@@ -1456,6 +1456,9 @@ empty_trashcan_tickets ()
 /**
  * @brief Check if tickets have been resolved.
  *
+ * All the resolved tickets of the task are marked as fix verified with a
+ * single UPDATE, instead of one ticket at a time.
+ *
  * @param[in]  task  Task.
  */
 void
@@ -1463,6 +1466,7 @@ check_tickets (task_t task)
 {
   report_t report;
   iterator_t tickets;
+  int open, fixed;
 
   if (task_last_report (task, &report))
     {
@@ -1474,35 +1478,49 @@ check_tickets (task_t task)
     }
 
   init_iterator (&tickets,
-                 "SELECT id FROM tickets"
-                 " WHERE task = %llu"
-                 " AND (status = %i"
-                 "      OR status = %i)"
+                 "UPDATE tickets"
+                 " SET status = %i,"
+                 "     fix_verified_time = m_now (),"
+                 "     fix_verified_report = %llu"
+                 " FROM (SELECT id, status FROM tickets AS resolved"
+                 "       WHERE task = %llu"
+                 "       AND (status = %i"
+                 "            OR status = %i)"
                  /* Only if the same host was scanned. */
-                 " AND EXISTS (SELECT * FROM report_hosts"
+                 "       AND EXISTS (SELECT * FROM report_hosts"
+                 "                   WHERE report = %llu"
+                 "                   AND report_hosts.host = resolved.host)"
+                 /* Only if the problem result is gone from the host. */
+                 "       AND NOT EXISTS"
+                 "            (SELECT * FROM results"
                  "             WHERE report = %llu"
-                 "             AND report_hosts.host = tickets.host)"
-                 /* Only if the problem result is gone. */
-                 " AND NOT EXISTS (SELECT * FROM results"
-                 "                 WHERE report = %llu"
-                 "                 AND nvt = (SELECT nvt FROM results"
-                 "                            WHERE id = (SELECT result"
-                 "                                        FROM ticket_results"
-                 "                                        WHERE ticket = tickets.id"
-                 "                                        AND result_location = %i"
-                 "                                        LIMIT 1)))"
+                 "             AND results.host = resolved.host"
+                 "             AND nvt = coalesce"
+                 "                        (resolved.nvt,"
+                 "                         (SELECT nvt FROM results"
+                 "                          WHERE id = (SELECT result"
+                 "                                      FROM ticket_results"
+                 "                                      WHERE ticket"
+                 "                                            = resolved.id"
+                 "                                      AND result_location"
+                 "                                          = %i"
+                 "                                      LIMIT 1))))"
                  /* Only if there were no login failures on the host. */
-                 " AND NOT EXISTS (SELECT * FROM report_host_details"
-                 "                 WHERE report_host = (SELECT id"
-                 "                                      FROM report_hosts"
-                 "                                      WHERE report = %llu"
-                 "                                      AND report_hosts.host"
-                 "                                          = tickets.host"
-                 "                                      LIMIT 1)"
-                 "                 AND (name = 'Auth-SSH-Failure'"
-                 "                      OR name = 'Auth-SMB-Failure'"
-                 "                      OR name = 'Auth-SNMP-Failure'"
-                 "                      OR name = 'Auth-ESXi-Failure'));",
+                 "       AND NOT EXISTS"
+                 "            (SELECT * FROM report_host_details, report_hosts"
+                 "             WHERE report_hosts.report = %llu"
+                 "             AND report_hosts.host = resolved.host"
+                 "             AND report_host_details.report_host"
+                 "                 = report_hosts.id"
+                 "             AND (name = 'Auth-SSH-Failure'"
+                 "                  OR name = 'Auth-SMB-Failure'"
+                 "                  OR name = 'Auth-SNMP-Failure'"
+                 "                  OR name = 'Auth-ESXi-Failure')))"
+                 "      AS resolved"
+                 " WHERE tickets.id = resolved.id"
+                 " RETURNING tickets.id, resolved.status;",
+                 TICKET_STATUS_FIX_VERIFIED,
+                 report,
                  task,
                  TICKET_STATUS_OPEN,
                  TICKET_STATUS_FIXED,
@@ -1510,25 +1528,28 @@ check_tickets (task_t task)
                  report,
                  LOCATION_TABLE,
                  report);
+  open = fixed = 0;
   while (next (&tickets))
     {
       ticket_t ticket;
 
       ticket = iterator_int64 (&tickets, 0);
-
-      sql ("UPDATE tickets"
-           " SET status = %i,"
-           "     fix_verified_time = m_now (),"
-           "     fix_verified_report = %llu"
-           " WHERE id = %llu;",
-           TICKET_STATUS_FIX_VERIFIED,
-           report,
-           ticket);
+      if (iterator_int (&tickets, 1) == TICKET_STATUS_OPEN)
+        open++;
+      else
+        fixed++;
 
       event (EVENT_OWNED_TICKET_CHANGED, NULL, ticket, 0);
       event (EVENT_ASSIGNED_TICKET_CHANGED, NULL, ticket, 0);
     }
   cleanup_iterator (&tickets);
+
+  if (open || fixed)
+    g_info ("%s: task %llu: verified fix of %i open and %i fixed tickets",
+            __func__,
+            task,
+            open,
+            fixed);
 }
 
 /**
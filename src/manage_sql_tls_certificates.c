@@ -30,6 +30,7 @@
 #include "utils.h"
 #include "sql.h"
 
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -1495,200 +1496,342 @@ add_tls_certificates_from_report_host (report_host_t report_host,
                                        const char *report_id,
                                        const char *host_ip)
 {
-  iterator_t tls_certs;
+  GArray *report_hosts;
+  GPtrArray *host_ips;
+  int ret;
+
+  report_hosts = g_array_new (FALSE, FALSE, sizeof (report_host_t));
+  g_array_append_val (report_hosts, report_host);
+  host_ips = g_ptr_array_new ();
+  g_ptr_array_add (host_ips, (gpointer) host_ip);
+
+  ret = add_tls_certificates_from_report_hosts (report_hosts, host_ips,
+                                                report_id);
+
+  g_array_free (report_hosts, TRUE);
+  g_ptr_array_free (host_ips, TRUE);
+  return ret;
+}
+
+/**
+ * @brief Get or create the TLS certificate for a certificate host detail.
+ *
+ * @param[in] report_host        The report host that has the certificate.
+ * @param[in] certificate_b64    Base64 encoded certificate.
+ * @param[in] scanner_fpr        Fingerprint given by the scanner.
+ * @param[in] quoted_scanner_fpr SQL quoted scanner_fpr.
+ *
+ * @return The TLS certificate, 0 on error.
+ */
+static tls_certificate_t
+report_host_tls_certificate (report_host_t report_host,
+                             const char *certificate_b64,
+                             const char *scanner_fpr,
+                             const char *quoted_scanner_fpr)
+{
   time_t activation_time, expiration_time;
   gchar *md5_fingerprint, *sha256_fingerprint, *subject, *issuer, *serial;
   gnutls_x509_crt_fmt_t certificate_format;
+  gsize certificate_size;
+  unsigned char *certificate;
+  char *ssldetails;
+  tls_certificate_t tls_certificate;
 
-  /* host_ip and report_id are expected to avoid possibly redundant
-   *  SQL queries to get them */
-  if (report_host == 0
-      || host_ip == NULL
-      || report_id == NULL
-      || strcmp (host_ip, "") == 0
-      || strcmp (report_id, "") == 0)
-    return -1;
-
-  init_iterator (&tls_certs,
-                 "SELECT rhd.value, rhd.name, rhd.source_name"
-                 " FROM report_host_details AS rhd"
-                 " WHERE rhd.report_host = %llu"
-                 "   AND (source_description = 'SSL/TLS Certificate'"
-                 "        OR source_description = 'SSL Certificate')",
-                 report_host);
+  certificate = g_base64_decode (certificate_b64, &certificate_size);
 
-  while (next (&tls_certs))
+  tls_certificate = 0;
+  activation_time = -1;
+  expiration_time = -1;
+  md5_fingerprint = NULL;
+  sha256_fingerprint = NULL;
+  subject = NULL;
+  issuer = NULL;
+  serial = NULL;
+  certificate_format = 0;
+
+  get_certificate_info ((gchar*)certificate,
+                        certificate_size,
+                        &activation_time,
+                        &expiration_time,
+                        &md5_fingerprint,
+                        &sha256_fingerprint,
+                        &subject,
+                        &issuer,
+                        &serial,
+                        &certificate_format);
+
+  if (sha256_fingerprint == NULL)
+    sha256_fingerprint = g_strdup (scanner_fpr);
+
+  ssldetails
+    = sql_string ("SELECT rhd.value"
+                  " FROM report_host_details AS rhd"
+                  " WHERE report_host = %llu"
+                  "   AND name = 'SSLDetails:%s'"
+                  " LIMIT 1;",
+                  report_host,
+                  quoted_scanner_fpr);
+
+  if (ssldetails)
+    parse_ssldetails (ssldetails,
+                      &activation_time,
+                      &expiration_time,
+                      &issuer,
+                      &serial);
+  else
+    g_warning ("%s: No SSLDetails found for fingerprint %s",
+               __func__,
+               scanner_fpr);
+
+  free (ssldetails);
+
+  if (make_tls_certificate (sha256_fingerprint, /* name */
+                            "", /* comment */
+                            certificate_b64,
+                            activation_time,
+                            expiration_time,
+                            md5_fingerprint,
+                            sha256_fingerprint,
+                            subject,
+                            issuer,
+                            serial,
+                            certificate_format,
+                            0,
+                            1,
+                            &tls_certificate)
+      || tls_certificate == 0)
     {
-      const char *certificate_prefixed, *certificate_b64;
-      gsize certificate_size;
-      unsigned char *certificate;
-      const char *scanner_fpr_prefixed, *scanner_fpr;
-      gchar *quoted_scanner_fpr;
-      const char *source_name;
-      char *ssldetails;
-      tls_certificate_t tls_certificate;
+      g_warning ("%s: Could not create TLS certificate"
+                 " or get existing one for fingerprint '%s'.",
+                 __func__, scanner_fpr);
+      tls_certificate = 0;
+    }
 
-      iterator_t ports;
-      gboolean has_ports;
+  g_free (certificate);
+  g_free (md5_fingerprint);
+  g_free (sha256_fingerprint);
+  g_free (subject);
+  g_free (issuer);
+  g_free (serial);
 
-      certificate_prefixed = iterator_string (&tls_certs, 0);
-      certificate_b64 = g_strrstr (certificate_prefixed, ":") + 1;
+  return tls_certificate;
+}
 
-      certificate = g_base64_decode (certificate_b64, &certificate_size);
+/**
+ * @brief Add the TLS certificate sources collected from report hosts.
+ *
+ * The missing locations and sources are each added with one statement.
+ * The statements read the sources from VALUES instead of a temporary
+ * table, so that they work when each runs on another database session.
+ *
+ * @param[in] sources  VALUES of the sources: certificate, host IP, port and
+ *                     origin.
+ */
+static void
+add_tls_certificate_sources (GString *sources)
+{
+  if (sources->len == 0)
+    return;
+
+  sql ("INSERT INTO tls_certificate_locations (uuid, host_ip, port)"
+       " SELECT make_uuid (), host_ip, port"
+       " FROM (SELECT DISTINCT host_ip, port"
+       "       FROM (VALUES %s)"
+       "            AS batch (tls_certificate, host_ip, port, origin))"
+       "      AS new"
+       " WHERE NOT EXISTS (SELECT * FROM tls_certificate_locations"
+       "                   WHERE host_ip = new.host_ip"
+       "                   AND port = new.port);",
+       sources->str);
+
+  sql ("INSERT INTO tls_certificate_sources"
+       " (uuid, tls_certificate, location, origin, timestamp)"
+       " SELECT make_uuid (), tls_certificate, location, origin, m_now ()"
+       " FROM (SELECT DISTINCT"
+       "              batch.tls_certificate,"
+       "              (SELECT min (id) FROM tls_certificate_locations"
+       "               WHERE host_ip = batch.host_ip"
+       "               AND port = batch.port)"
+       "              AS location,"
+       "              batch.origin"
+       "       FROM (VALUES %s)"
+       "            AS batch (tls_certificate, host_ip, port, origin))"
+       "      AS new"
+       " WHERE NOT EXISTS (SELECT * FROM tls_certificate_sources"
+       "                   WHERE tls_certificate = new.tls_certificate"
+       "                   AND location = new.location"
+       "                   AND origin = new.origin);",
+       sources->str);
+}
 
-      scanner_fpr_prefixed = iterator_string (&tls_certs, 1);
-      scanner_fpr = g_strrstr (scanner_fpr_prefixed, ":") + 1;
+/**
+ * @brief Collects and add TLS certificates from the details of report hosts.
+ *
+ * Each certificate is parsed and looked up only once, even if several of
+ * the hosts have it, and the sources of all hosts are added together at
+ * the end.
+ *
+ * @param[in] report_hosts  The report hosts to get certificates from.
+ * @param[in] host_ips      The IP address of each report host.
+ * @param[in] report_id     UUID of the report
+ *
+ * @return 0: success, -1: error
+ */
+int
+add_tls_certificates_from_report_hosts (GArray *report_hosts,
+                                        GPtrArray *host_ips,
+                                        const char *report_id)
+{
+  GHashTable *certificates, *origins;
+  GString *sources;
+  guint index;
+  int ret;
 
-      quoted_scanner_fpr = sql_quote (scanner_fpr);
+  /* host_ip and report_id are expected to avoid possibly redundant
+   *  SQL queries to get them */
+  if (report_id == NULL || strcmp (report_id, "") == 0)
+    return -1;
 
-      source_name = iterator_string (&tls_certs, 2);
+  assert (report_hosts->len == host_ips->len);
 
-      g_debug ("%s: Handling certificate %s on %s in report %s",
-               __func__, scanner_fpr, host_ip, report_id);
+  /* Certificates by scanner fingerprint and origins by source name. */
+  certificates = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                        g_free);
+  origins = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  sources = g_string_new ("");
 
-      tls_certificate = 0;
-      activation_time = -1;
-      expiration_time = -1;
-      md5_fingerprint = NULL;
-      sha256_fingerprint = NULL;
-      subject = NULL;
-      issuer = NULL;
-      serial = NULL;
-      certificate_format = 0;
-
-      get_certificate_info ((gchar*)certificate,
-                            certificate_size,
-                            &activation_time,
-                            &expiration_time,
-                            &md5_fingerprint,
-                            &sha256_fingerprint,
-                            &subject,
-                            &issuer,
-                            &serial,
-                            &certificate_format);
-
-      if (sha256_fingerprint == NULL)
-        sha256_fingerprint = g_strdup (scanner_fpr);
-
-      ssldetails
-        = sql_string ("SELECT rhd.value"
-                      " FROM report_host_details AS rhd"
-                      " WHERE report_host = %llu"
-                      "   AND name = 'SSLDetails:%s'"
-                      " LIMIT 1;",
-                      report_host,
-                      quoted_scanner_fpr);
-
-      if (ssldetails)
-        parse_ssldetails (ssldetails,
-                          &activation_time,
-                          &expiration_time,
-                          &issuer,
-                          &serial);
-      else
-        g_warning ("%s: No SSLDetails found for fingerprint %s",
-                   __func__,
-                   scanner_fpr);
-
-      free (ssldetails);
-
-      if (make_tls_certificate (sha256_fingerprint, /* name */
-                                "", /* comment */
-                                certificate_b64,
-                                activation_time,
-                                expiration_time,
-                                md5_fingerprint,
-                                sha256_fingerprint,
-                                subject,
-                                issuer,
-                                serial,
-                                certificate_format,
-                                0,
-                                1,
-                                &tls_certificate)
-          || tls_certificate == 0)
+  ret = 0;
+  for (index = 0; index < report_hosts->len; index++)
+    {
+      report_host_t report_host;
+      const char *host_ip;
+      gchar *quoted_host_ip;
+      iterator_t tls_certs;
+
+      report_host = g_array_index (report_hosts, report_host_t, index);
+      host_ip = g_ptr_array_index (host_ips, index);
+      if (report_host == 0
+          || host_ip == NULL
+          || strcmp (host_ip, "") == 0)
         {
-          g_warning ("%s: Could not create TLS certificate"
-                     " or get existing one for fingerprint '%s'.",
-                     __func__, scanner_fpr);
-
-          g_free (certificate);
-          g_free (md5_fingerprint);
-          g_free (sha256_fingerprint);
-          g_free (subject);
-          g_free (issuer);
-          g_free (serial);
+          ret = -1;
           continue;
         }
 
-      init_iterator (&ports,
-                     "SELECT value FROM report_host_details"
-                     " WHERE report_host = %llu"
-                     "   AND name = 'SSLInfo'"
-                     "   AND value LIKE '%%:%%:%s'",
-                     report_host,
-                     quoted_scanner_fpr);
+      quoted_host_ip = sql_quote (host_ip);
 
-      has_ports = FALSE;
-      while (next (&ports))
+      init_iterator (&tls_certs,
+                     "SELECT rhd.value, rhd.name, rhd.source_name"
+                     " FROM report_host_details AS rhd"
+                     " WHERE rhd.report_host = %llu"
+                     "   AND (source_description = 'SSL/TLS Certificate'"
+                     "        OR source_description = 'SSL Certificate')",
+                     report_host);
+
+      while (next (&tls_certs))
         {
-          const char *value;
-          gchar *port, *quoted_port;
-          GString *versions;
-          iterator_t versions_iter;
+          const char *certificate_prefixed, *certificate_b64;
+          const char *scanner_fpr_prefixed, *scanner_fpr;
+          gchar *quoted_scanner_fpr;
+          const char *source_name;
+          tls_certificate_t *tls_certificate;
+          resource_t *origin;
+          iterator_t ports;
+          gboolean has_ports;
+
+          certificate_prefixed = iterator_string (&tls_certs, 0);
+          certificate_b64 = g_strrstr (certificate_prefixed, ":") + 1;
+
+          scanner_fpr_prefixed = iterator_string (&tls_certs, 1);
+          scanner_fpr = g_strrstr (scanner_fpr_prefixed, ":") + 1;
 
-          value = iterator_string (&ports, 0);
-          port = g_strndup (value, g_strrstr (value, ":") - value - 1);
-          quoted_port = sql_quote (port);
+          quoted_scanner_fpr = sql_quote (scanner_fpr);
 
-          has_ports = TRUE;
+          source_name = iterator_string (&tls_certs, 2);
 
-          versions = g_string_new ("");
-          init_iterator (&versions_iter,
+          g_debug ("%s: Handling certificate %s on %s in report %s",
+                   __func__, scanner_fpr, host_ip, report_id);
+
+          tls_certificate = g_hash_table_lookup (certificates, scanner_fpr);
+          if (tls_certificate == NULL)
+            {
+              tls_certificate = g_malloc (sizeof (*tls_certificate));
+              *tls_certificate
+                = report_host_tls_certificate (report_host,
+                                               certificate_b64,
+                                               scanner_fpr,
+                                               quoted_scanner_fpr);
+              g_hash_table_insert (certificates, g_strdup (scanner_fpr),
+                                   tls_certificate);
+            }
+
+          if (*tls_certificate == 0)
+            {
+              g_free (quoted_scanner_fpr);
+              continue;
+            }
+
+          origin = g_hash_table_lookup (origins, source_name ?: "");
+          if (origin == NULL)
+            {
+              origin = g_malloc (sizeof (*origin));
+              *origin = get_or_make_tls_certificate_origin ("Report",
+                                                            report_id,
+                                                            source_name);
+              g_hash_table_insert (origins, g_strdup (source_name ?: ""),
+                                   origin);
+            }
+
+          init_iterator (&ports,
                          "SELECT value FROM report_host_details"
                          " WHERE report_host = %llu"
-                         "   AND name = 'TLS/%s'",
+                         "   AND name = 'SSLInfo'"
+                         "   AND value LIKE '%%:%%:%s'",
                          report_host,
-                         quoted_port);
-          while (next (&versions_iter))
+                         quoted_scanner_fpr);
+
+          has_ports = FALSE;
+          while (next (&ports))
             {
-              gchar *quoted_version;
-              quoted_version = sql_quote (iterator_string (&versions_iter, 0));
+              const char *value;
+              gchar *port, *quoted_port;
 
-              if (versions->len)
-                g_string_append (versions, ", ");
-              g_string_append (versions, quoted_version);
-            }
-          cleanup_iterator (&versions_iter);
-
-          get_or_make_tls_certificate_source (tls_certificate,
-                                              host_ip,
-                                              port,
-                                              "Report",
-                                              report_id,
-                                              source_name);
-
-          g_free (port);
-          g_free (quoted_port);
-          g_string_free (versions, TRUE);
-        }
+              value = iterator_string (&ports, 0);
+              port = g_strndup (value, g_strrstr (value, ":") - value - 1);
+              quoted_port = sql_quote (port);
 
-      if (has_ports == FALSE)
-        g_warning ("Certificate without ports: %s report:%s host:%s",
-                   quoted_scanner_fpr, report_id, host_ip);
+              has_ports = TRUE;
 
-      cleanup_iterator (&ports);
+              g_string_append_printf (sources,
+                                      "%s (%llu, '%s', '%s', %llu)",
+                                      sources->len ? "," : "",
+                                      *tls_certificate,
+                                      quoted_host_ip,
+                                      quoted_port,
+                                      *origin);
 
-      g_free (certificate);
-      g_free (md5_fingerprint);
-      g_free (sha256_fingerprint);
-      g_free (subject);
-      g_free (issuer);
-      g_free (serial);
+              g_free (port);
+              g_free (quoted_port);
+            }
+
+          if (has_ports == FALSE)
+            g_warning ("Certificate without ports: %s report:%s host:%s",
+                       quoted_scanner_fpr, report_id, host_ip);
+
+          cleanup_iterator (&ports);
+          g_free (quoted_scanner_fpr);
+        }
+      cleanup_iterator (&tls_certs);
+      g_free (quoted_host_ip);
     }
-  cleanup_iterator (&tls_certs);
 
-  return 0;
+  add_tls_certificate_sources (sources);
+
+  g_string_free (sources, TRUE);
+  g_hash_table_destroy (certificates);
+  g_hash_table_destroy (origins);
+
+  return ret;
 }
 
 /**
@@ -52,4 +52,7 @@ add_tls_certificates_from_report_host (report_host_t,
                                        const char*,
                                        const char*);
 
+int
+add_tls_certificates_from_report_hosts (GArray *, GPtrArray *, const char*);
+
 #endif /* not _GVMD_MANAGE_SQL_TLS_CERTIFICATES_H */
@@ -136,6 +136,108 @@ Ensure (manage, truncate_text_preserves_xml)
   g_free (given);
 }
 
+/* osp_scan_poll_interval */
+
+Ensure (manage, osp_scan_poll_interval_backs_off_when_idle)
+{
+  set_osp_poll_intervals (1, 30);
+  assert_that (osp_scan_poll_interval (1, 0, 0), is_equal_to (2));
+  assert_that (osp_scan_poll_interval (2, 0, 0), is_equal_to (4));
+  assert_that (osp_scan_poll_interval (16, 0, 0), is_equal_to (30));
+  assert_that (osp_scan_poll_interval (30, 0, 0), is_equal_to (30));
+}
+
+Ensure (manage, osp_scan_poll_interval_speeds_up_on_results)
+{
+  set_osp_poll_intervals (1, 30);
+  assert_that (osp_scan_poll_interval (8, 1, 0), is_equal_to (4));
+  assert_that (osp_scan_poll_interval (8, 0, 5), is_equal_to (4));
+  assert_that (osp_scan_poll_interval (1, 1, 5), is_equal_to (1));
+  assert_that (osp_scan_poll_interval (30, 0, OSP_POLL_BURST_RESULTS),
+               is_equal_to (1));
+}
+
+Ensure (manage, set_osp_poll_intervals_clamps)
+{
+  set_osp_poll_intervals (0, -5);
+  assert_that (get_osp_poll_interval_min (), is_equal_to (1));
+  assert_that (get_osp_poll_interval_max (), is_equal_to (1));
+  set_osp_poll_intervals (5, 2);
+  assert_that (get_osp_poll_interval_min (), is_equal_to (5));
+  assert_that (get_osp_poll_interval_max (), is_equal_to (5));
+}
+
+/* severity_data_add_batch */
+
+Ensure (manage, severity_data_add_batch_matches_severity_data_add)
+{
+  severity_data_t one, batch;
+  double severities[SEVERITY_DATA_BATCH * 2 + 3];
+  int index, count;
+
+  count = sizeof (severities) / sizeof (severities[0]);
+  for (index = 0; index < count; index++)
+    switch (index % 7)
+      {
+        case 0: severities[index] = SEVERITY_FP; break;
+        case 1: severities[index] = SEVERITY_ERROR; break;
+        case 2: severities[index] = 0.0; break;
+        case 3: severities[index] = SEVERITY_MAX; break;
+        case 4: severities[index] = SEVERITY_MISSING; break;
+        default: severities[index] = (index % 101) / 10.0; break;
+      }
+
+  init_severity_data (&one);
+  init_severity_data (&batch);
+  for (index = 0; index < count; index++)
+    severity_data_add (&one, severities[index]);
+  severity_data_add_batch (&batch, severities, 5);
+  severity_data_add_batch (&batch, severities + 5, count - 5);
+
+  assert_that (batch.total, is_equal_to (one.total));
+  assert_that_double (batch.max, is_equal_to_double (one.max));
+  for (index = 0; index < SEVERITY_DATA_BINS; index++)
+    assert_that (batch.counts[index], is_equal_to (one.counts[index]));
+
+  cleanup_severity_data (&one);
+  cleanup_severity_data (&batch);
+}
+
+Ensure (manage, severity_data_add_batch_counts_levels)
+{
+  severity_data_t data;
+  double severities[] = { 0.0, 0.0, 2.0, 5.0, 5.5, 9.8, 10.0, SEVERITY_FP };
+  int false_positives, logs, lows, mediums, highs;
+
+  init_severity_data (&data);
+  severity_data_add_batch (&data, severities, 8);
+  severity_data_level_counts (&data, NULL, &false_positives, &logs, &lows,
+                              &mediums, &highs);
+
+  assert_that (data.total, is_equal_to (8));
+  assert_that_double (data.max, is_equal_to_double (10.0));
+  assert_that (false_positives, is_equal_to (1));
+  assert_that (logs, is_equal_to (2));
+  assert_that (lows, is_equal_to (1));
+  assert_that (mediums, is_equal_to (2));
+  assert_that (highs, is_equal_to (2));
+
+  cleanup_severity_data (&data);
+}
+
+Ensure (manage, severity_data_add_batch_ignores_empty_batch)
+{
+  severity_data_t data;
+
+  init_severity_data (&data);
+  severity_data_add_batch (&data, NULL, 0);
+
+  assert_that (data.total, is_equal_to (0));
+  assert_that_double (data.max, is_equal_to_double (SEVERITY_MISSING));
+
+  cleanup_severity_data (&data);
+}
+
 /* delete_reports */
 
 // TODO
@@ -167,6 +269,18 @@ main (int argc, char **argv)
   add_test_with_context (suite, manage, truncate_text_skips_suffix);
   add_test_with_context (suite, manage, truncate_text_preserves_xml);
 
+  add_test_with_context (suite, manage,
+                         osp_scan_poll_interval_backs_off_when_idle);
+  add_test_with_context (suite, manage,
+                         osp_scan_poll_interval_speeds_up_on_results);
+  add_test_with_context (suite, manage, set_osp_poll_intervals_clamps);
+
+  add_test_with_context (suite, manage,
+                         severity_data_add_batch_matches_severity_data_add);
+  add_test_with_context (suite, manage, severity_data_add_batch_counts_levels);
+  add_test_with_context (suite, manage,
+                         severity_data_add_batch_ignores_empty_batch);
+
   if (argc > 1)
     return run_single_test (suite, argv[1], create_text_reporter ());
 
@@ -23,6 +23,7 @@
 
 #include "manage_utils.h"
 
+#include <arpa/inet.h> /* for inet_pton */
 #include <assert.h> /* for assert */
 #include <ctype.h>
 #include <stdlib.h> /* for getenv */
@@ -141,9 +142,273 @@ add_months (time_t time, int months)
   return mktime (broken);
 }
 
+/**
+ * @brief An inclusive interval of IPv4 addresses, in host byte order.
+ */
+typedef struct
+{
+  guint32 first;  ///< First address.
+  guint32 last;   ///< Last address.
+} ipv4_interval_t;
+
+/**
+ * @brief Compare two IPv4 intervals by first address.
+ *
+ * @param[in]  one  First interval.
+ * @param[in]  two  Second interval.
+ *
+ * @return 0 equal, 1 one greater, -1 two greater.
+ */
+static gint
+ipv4_interval_compare (gconstpointer one, gconstpointer two)
+{
+  const ipv4_interval_t *interval_one = one, *interval_two = two;
+
+  if (interval_one->first > interval_two->first)
+    return 1;
+  if (interval_one->first < interval_two->first)
+    return -1;
+  return 0;
+}
+
+/**
+ * @brief Parse one IPv4 host expression into an interval.
+ *
+ * Mirrors the gvm_hosts rules: CIDR blocks shorter than /31 leave out
+ * the network and broadcast addresses.
+ *
+ * @param[in]   item      Host expression, already stripped.
+ * @param[out]  interval  Interval.
+ *
+ * @return 0 success, 1 not a plain IPv4 expression.
+ */
+static int
+ipv4_interval_parse (const char *item, ipv4_interval_t *interval)
+{
+  struct in_addr address;
+  gchar **split;
+  int ret;
+
+  ret = 1;
+  switch (gvm_get_host_type (item))
+    {
+      case HOST_TYPE_IPV4:
+        if (inet_pton (AF_INET, item, &address) != 1)
+          return 1;
+        interval->first = interval->last = ntohl (address.s_addr);
+        return 0;
+
+      case HOST_TYPE_CIDR_BLOCK:
+        split = g_strsplit (item, "/", 2);
+        if (split[1] && inet_pton (AF_INET, split[0], &address) == 1)
+          {
+            int block;
+            guint32 mask;
+
+            block = atoi (split[1]);
+            if (block >= 1 && block <= 32)
+              {
+                mask = block == 32 ? 0xffffffff : ~(0xffffffff >> block);
+                interval->first = ntohl (address.s_addr) & mask;
+                interval->last = interval->first | ~mask;
+                if (block < 31)
+                  {
+                    interval->first++;
+                    interval->last--;
+                  }
+                ret = 0;
+              }
+          }
+        g_strfreev (split);
+        return ret;
+
+      case HOST_TYPE_RANGE_LONG:
+        split = g_strsplit (item, "-", 2);
+        if (split[1] && inet_pton (AF_INET, split[0], &address) == 1)
+          {
+            struct in_addr last;
+
+            if (inet_pton (AF_INET, split[1], &last) == 1
+                && ntohl (address.s_addr) <= ntohl (last.s_addr))
+              {
+                interval->first = ntohl (address.s_addr);
+                interval->last = ntohl (last.s_addr);
+                ret = 0;
+              }
+          }
+        g_strfreev (split);
+        return ret;
+
+      case HOST_TYPE_RANGE_SHORT:
+        split = g_strsplit (item, "-", 2);
+        if (split[1] && inet_pton (AF_INET, split[0], &address) == 1)
+          {
+            int end;
+
+            end = atoi (split[1]);
+            interval->first = ntohl (address.s_addr);
+            if (end >= (int) (interval->first & 0xff) && end <= 255)
+              {
+                interval->last = (interval->first & 0xffffff00) | end;
+                ret = 0;
+              }
+          }
+        g_strfreev (split);
+        return ret;
+
+      default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Parse a hosts string into sorted, disjoint IPv4 intervals.
+ *
+ * @param[in]   hosts      Hosts string, already cleaned.
+ * @param[out]  intervals  Intervals.  Caller must free.
+ * @param[out]  count      Number of addresses in the intervals.
+ *
+ * @return 0 success, 1 contains something other than IPv4 expressions.
+ */
+static int
+ipv4_intervals_parse (const char *hosts, GArray **intervals, guint64 *count)
+{
+  gchar **split, **item;
+  guint index, last;
+
+  *intervals = g_array_new (FALSE, FALSE, sizeof (ipv4_interval_t));
+  *count = 0;
+
+  split = g_strsplit (hosts, ",", 0);
+  for (item = split; *item; item++)
+    {
+      ipv4_interval_t interval;
+
+      g_strstrip (*item);
+      if (ipv4_interval_parse (*item, &interval))
+        {
+          g_strfreev (split);
+          g_array_free (*intervals, TRUE);
+          *intervals = NULL;
+          return 1;
+        }
+      g_array_append_val (*intervals, interval);
+    }
+  g_strfreev (split);
+
+  if ((*intervals)->len == 0)
+    return 0;
+
+  /* Sort, then merge overlaps in one pass, which also drops duplicates. */
+
+  g_array_sort (*intervals, ipv4_interval_compare);
+  last = 0;
+  for (index = 1; index < (*intervals)->len; index++)
+    {
+      ipv4_interval_t *current, *previous;
+
+      current = &g_array_index (*intervals, ipv4_interval_t, index);
+      previous = &g_array_index (*intervals, ipv4_interval_t, last);
+      if (current->first <= previous->last)
+        {
+          if (current->last > previous->last)
+            previous->last = current->last;
+        }
+      else
+        g_array_index (*intervals, ipv4_interval_t, ++last) = *current;
+    }
+  g_array_set_size (*intervals, last + 1);
+
+  for (index = 0; index < (*intervals)->len; index++)
+    {
+      ipv4_interval_t *interval;
+
+      interval = &g_array_index (*intervals, ipv4_interval_t, index);
+      *count += (guint64) interval->last - interval->first + 1;
+    }
+  return 0;
+}
+
+/**
+ * @brief Count IPv4 hosts arithmetically, without expanding them.
+ *
+ * @param[in]   hosts      Hosts string, already cleaned.
+ * @param[in]   exclude    Exclude hosts string, already cleaned, or NULL.
+ * @param[in]   max_hosts  Max hosts, 0 for no limit.
+ * @param[out]  count      Number of hosts, or -1 if over max_hosts.
+ *
+ * @return 0 success, 1 hosts need full expansion.
+ */
+static int
+count_ipv4_hosts (const char *hosts, const char *exclude, int max_hosts,
+                  int *count)
+{
+  GArray *included, *excluded;
+  guint64 included_count, excluded_count, overlap;
+  guint index, exclude_index;
+
+  if (ipv4_intervals_parse (hosts, &included, &included_count))
+    return 1;
+
+  if (exclude && *exclude)
+    {
+      if (ipv4_intervals_parse (exclude, &excluded, &excluded_count))
+        {
+          g_array_free (included, TRUE);
+          return 1;
+        }
+    }
+  else
+    {
+      excluded = g_array_new (FALSE, FALSE, sizeof (ipv4_interval_t));
+      excluded_count = 0;
+    }
+
+  if (max_hosts > 0
+      && (included_count > (guint64) max_hosts
+          || excluded_count > (guint64) max_hosts))
+    {
+      g_array_free (included, TRUE);
+      g_array_free (excluded, TRUE);
+      *count = -1;
+      return 0;
+    }
+
+  /* Both sets are sorted and disjoint, so one merge walk finds the
+   * addresses they share. */
+
+  overlap = 0;
+  index = exclude_index = 0;
+  while (index < included->len && exclude_index < excluded->len)
+    {
+      ipv4_interval_t *in, *out;
+      guint32 first, last;
+
+      in = &g_array_index (included, ipv4_interval_t, index);
+      out = &g_array_index (excluded, ipv4_interval_t, exclude_index);
+      first = MAX (in->first, out->first);
+      last = MIN (in->last, out->last);
+      if (first <= last)
+        overlap += (guint64) last - first + 1;
+      if (in->last < out->last)
+        index++;
+      else
+        exclude_index++;
+    }
+
+  g_array_free (included, TRUE);
+  g_array_free (excluded, TRUE);
+
+  *count = (int) MIN (included_count - overlap, (guint64) G_MAXINT);
+  return 0;
+}
+
 /**
  * @brief Return number of hosts described by a hosts string.
  *
+ * Plain IPv4 addresses, ranges and CIDR blocks are counted arithmetically.
+ * Anything else, like host names or IPv6, goes through gvm_hosts.
+ *
  * @param[in]  given_hosts      String describing hosts.
  * @param[in]  exclude_hosts    String describing hosts excluded from given set.
  * @param[in]  max_hosts        Max hosts.
@@ -160,6 +425,24 @@ manage_count_hosts_max (const char *given_hosts, const char *exclude_hosts,
   
   clean_hosts = clean_hosts_string (given_hosts);
 
+  if (clean_hosts && *clean_hosts)
+    {
+      gchar *clean_exclude_hosts;
+      int ret;
+
+      clean_exclude_hosts = exclude_hosts
+                             ? clean_hosts_string (exclude_hosts)
+                             : NULL;
+      ret = count_ipv4_hosts (clean_hosts, clean_exclude_hosts, max_hosts,
+                              &count);
+      g_free (clean_exclude_hosts);
+      if (ret == 0)
+        {
+          g_free (clean_hosts);
+          return count;
+        }
+    }
+
   hosts = gvm_hosts_new_with_max (clean_hosts, max_hosts);
   if (hosts == NULL)
     {
@@ -1465,3 +1748,134 @@ clean_hosts_string (const char *hosts)
   
   return g_string_free (new_hosts, FALSE);
 }
+
+/**
+ * @brief Compare two ranges by type then start.
+ *
+ * @param[in]  one  First range.
+ * @param[in]  two  Second range.
+ *
+ * @return 0 equal, 1 one greater, -1 two greater.
+ */
+static int
+range_compare (gconstpointer one, gconstpointer two)
+{
+  range_t *range_one, *range_two;
+
+  range_one = *((range_t**) one);
+  range_two = *((range_t**) two);
+
+  if (range_one->type > range_two->type)
+    return 1;
+
+  if (range_one->type < range_two->type)
+    return -1;
+
+  if (range_one->start > range_two->start)
+    return 1;
+
+  if (range_one->start < range_two->start)
+    return -1;
+
+  return 0;
+}
+
+/**
+ * @brief Sort and merge ranges into a canonical interval set.
+ *
+ * After this the ranges of each type are ordered by start, and neither
+ * overlap nor touch.  Merged ranges are freed.  Any NULL terminator is
+ * dropped, so callers that need one must call array_terminate again.
+ *
+ * @param[in]  ranges  Array of port ranges of type range_t.
+ */
+void
+ranges_sort_merge (array_t *ranges)
+{
+  guint length, index, last;
+
+  length = ranges->len;
+  while (length && g_ptr_array_index (ranges, length - 1) == NULL)
+    length--;
+  g_ptr_array_set_size (ranges, length);
+
+  if (length < 2)
+    return;
+
+  /* Sort by type then start. */
+
+  g_ptr_array_sort (ranges, range_compare);
+
+  /* Merge overlapping and adjacent ranges in one pass. */
+
+  last = 0;
+  for (index = 1; index < length; index++)
+    {
+      range_t *range, *last_range;
+
+      range = (range_t*) g_ptr_array_index (ranges, index);
+      last_range = (range_t*) g_ptr_array_index (ranges, last);
+
+      if (range->type == last_range->type
+          && range->start <= last_range->end + 1)
+        {
+          if (range->end > last_range->end)
+            last_range->end = range->end;
+          g_free (range);
+        }
+      else
+        {
+          last++;
+          g_ptr_array_index (ranges, last) = range;
+        }
+    }
+  g_ptr_array_set_size (ranges, last + 1);
+}
+
+/**
+ * @brief Get the scanner form of a set of port ranges.
+ *
+ * The ranges must already be merged with ranges_sort_merge.
+ *
+ * @param[in]  ranges  Array of port ranges of type range_t.
+ *
+ * @return Freshly allocated port range list, like "T:1-3,5,U:1-2".
+ */
+gchar *
+ranges_scanner_string (array_t *ranges)
+{
+  GString *string;
+  guint index;
+  int type;
+
+  string = g_string_new ("");
+  type = -1;
+  for (index = 0; index < ranges->len; index++)
+    {
+      range_t *range;
+      const char *prefix;
+
+      range = (range_t*) g_ptr_array_index (ranges, index);
+      if (range == NULL)
+        break;
+
+      /* Scanner can only handle: T:1-3,5-6,9,U:1-2 */
+
+      if (type == -1)
+        prefix = range->type == PORT_PROTOCOL_UDP ? "U:" : "T:";
+      else if (type == PORT_PROTOCOL_TCP && range->type == PORT_PROTOCOL_UDP)
+        prefix = "U:";
+      else
+        prefix = "";
+      type = range->type;
+
+      if (range->end && range->end != range->start)
+        g_string_append_printf (string, "%s%s%i-%i",
+                                index ? "," : "", prefix,
+                                range->start, range->end);
+      else
+        g_string_append_printf (string, "%s%s%i",
+                                index ? "," : "", prefix, range->start);
+    }
+  return g_string_free (string, FALSE);
+}
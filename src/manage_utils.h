@@ -28,6 +28,8 @@
 #undef _XOPEN_SOURCE
 #define _XOPEN_SOURCE
 #include <glib.h>
+#include <gvm/base/array.h>
+#include <gvm/base/networking.h>
 #include <libical/ical.h>
 #include <time.h>
 
@@ -101,4 +103,10 @@ icalendar_first_time_from_vcalendar (icalcomponent *, icaltimezone *);
 gchar *
 clean_hosts_string (const char *);
 
+void
+ranges_sort_merge (array_t *);
+
+gchar *
+ranges_scanner_string (array_t *);
+
 #endif /* not _GVMD_MANAGE_UTILS_H */
@@ -188,6 +188,79 @@ Ensure (manage_utils, clean_hosts_string_zeroes)
   g_free (clean_str);
 }
 
+/* Host count tests */
+
+Ensure (manage_utils, manage_count_hosts_max_ipv4_arithmetic)
+{
+  assert_that (manage_count_hosts_max ("10.0.0.0/24", NULL, 0),
+               is_equal_to (254));
+  assert_that (manage_count_hosts_max ("10.0.0.0/24",
+                                       "10.0.0.5, 10.0.0.10-20", 0),
+               is_equal_to (242));
+  assert_that (manage_count_hosts_max ("192.168.0.1,192.168.0.1-3", NULL, 0),
+               is_equal_to (3));
+  assert_that (manage_count_hosts_max ("10.0.0.1-10.0.1.0",
+                                       "10.0.0.0/16", 0),
+               is_equal_to (0));
+  assert_that (manage_count_hosts_max ("10.0.0.0/8", NULL, 4096),
+               is_equal_to (-1));
+}
+
+/* Port range tests */
+
+static range_t *
+make_range (port_protocol_t type, int start, int end)
+{
+  range_t *range;
+
+  range = g_malloc0 (sizeof (range_t));
+  range->type = type;
+  range->start = start;
+  range->end = end;
+  return range;
+}
+
+Ensure (manage_utils, ranges_sort_merge_merges_overlaps_and_neighbours)
+{
+  array_t *ranges;
+  gchar *string;
+
+  ranges = make_array ();
+  array_add (ranges, make_range (PORT_PROTOCOL_UDP, 5, 6));
+  array_add (ranges, make_range (PORT_PROTOCOL_TCP, 20, 30));
+  array_add (ranges, make_range (PORT_PROTOCOL_TCP, 1, 10));
+  array_add (ranges, make_range (PORT_PROTOCOL_TCP, 11, 12));
+  array_add (ranges, make_range (PORT_PROTOCOL_TCP, 25, 40));
+  array_add (ranges, make_range (PORT_PROTOCOL_UDP, 1, 3));
+  array_add (ranges, make_range (PORT_PROTOCOL_TCP, 50, 50));
+  array_terminate (ranges);
+
+  ranges_sort_merge (ranges);
+  assert_that (ranges->len, is_equal_to (5));
+
+  string = ranges_scanner_string (ranges);
+  assert_that (string, is_equal_to_string ("T:1-12,20-40,50,U:1-3,5-6"));
+  g_free (string);
+
+  array_free (ranges);
+}
+
+Ensure (manage_utils, ranges_scanner_string_udp_only)
+{
+  array_t *ranges;
+  gchar *string;
+
+  ranges = make_array ();
+  array_add (ranges, make_range (PORT_PROTOCOL_UDP, 53, 53));
+  ranges_sort_merge (ranges);
+
+  string = ranges_scanner_string (ranges);
+  assert_that (string, is_equal_to_string ("U:53"));
+  g_free (string);
+
+  array_free (ranges);
+}
+
 /* Test suite. */
 
 int
@@ -206,6 +279,13 @@ main (int argc, char **argv)
   
   add_test_with_context (suite, manage_utils, clean_hosts_string_zeroes);
 
+  add_test_with_context (suite, manage_utils,
+                         manage_count_hosts_max_ipv4_arithmetic);
+
+  add_test_with_context (suite, manage_utils,
+                         ranges_sort_merge_merges_overlaps_and_neighbours);
+  add_test_with_context (suite, manage_utils, ranges_scanner_string_udp_only);
+
   if (argc > 1)
     return run_single_test (suite, argv[1], create_text_reporter ());
 
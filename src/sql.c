@@ -55,9 +55,18 @@
 int
 sql_prepare_internal (int, int, const char*, va_list, sql_stmt_t **);
 
+int
+sql_prepare_ps_internal (int, int, const char*, va_list, sql_stmt_t **);
+
 int
 sql_exec_internal (int, sql_stmt_t *);
 
+int
+sql_exec_batch_internal (const char *);
+
+int
+sql_copy_in_internal (const char *, const char *, size_t);
+
 void
 sql_finalize (sql_stmt_t *);
 
@@ -76,6 +85,23 @@ sql_column_int64 (sql_stmt_t *, int);
 gchar **
 sql_column_array (sql_stmt_t *, int);
 
+
+/* Types. */
+
+/**
+ * @brief A batch of SQL statements.
+ */
+struct sql_batch
+{
+  GString *sql;      ///< Statements, separated by semicolons.
+  int count;         ///< Number of statements.
+};
+
+/**
+ * @brief Size of SQL at which a batch is sent automatically.
+ */
+#define SQL_BATCH_MAX_SIZE (1024 * 1024)
+
 
 /* Variables. */
 
@@ -208,8 +234,10 @@ sql_insert (const char *string)
 }
 
 /**
- * @brief Perform an SQL statement.
+ * @brief Perform an SQL statement, formatted or prepared.
  *
+ * @param[in]  ps     Whether \p sql is a prepared statement, in which case
+ *                    \p args are the parameters.
  * @param[in]  retry  Whether to keep retrying while database is busy or locked.
  * @param[in]  sql    Format string for SQL statement.
  * @param[in]  args   Arguments for format string.
@@ -218,8 +246,8 @@ sql_insert (const char *string)
  *         2 reserved (lock unavailable), 3 unique constraint violation,
  *         -1 error.
  */
-int
-sqlv (int retry, char* sql, va_list args)
+static int
+sqlv_x (int ps, int retry, const char* sql, va_list args)
 {
   while (1)
     {
@@ -231,7 +259,10 @@ sqlv (int retry, char* sql, va_list args)
        * Copy args for this because a va_list can only be used once.
        */
       va_copy (args_copy, args);
-      ret = sql_prepare_internal (retry, 1, sql, args_copy, &stmt);
+      if (ps)
+        ret = sql_prepare_ps_internal (retry, 1, sql, args_copy, &stmt);
+      else
+        ret = sql_prepare_internal (retry, 1, sql, args_copy, &stmt);
       va_end (args_copy);
       if (ret == -1)
         g_warning ("%s: sql_prepare_internal failed", __func__);
@@ -259,6 +290,23 @@ sqlv (int retry, char* sql, va_list args)
     }
 }
 
+/**
+ * @brief Perform an SQL statement.
+ *
+ * @param[in]  retry  Whether to keep retrying while database is busy or locked.
+ * @param[in]  sql    Format string for SQL statement.
+ * @param[in]  args   Arguments for format string.
+ *
+ * @return 0 success, 1 gave up (even when retry given),
+ *         2 reserved (lock unavailable), 3 unique constraint violation,
+ *         -1 error.
+ */
+int
+sqlv (int retry, char* sql, va_list args)
+{
+  return sqlv_x (0, retry, sql, args);
+}
+
 /**
  * @brief Perform an SQL statement, retrying if database is busy or locked.
  *
@@ -351,16 +399,55 @@ sql_giveup (char* sql, ...)
 }
 
 /**
- * @brief Get a particular cell from a SQL query.
+ * @brief Perform a prepared SQL statement, retrying if database is busy or
+ *        locked.
+ *
+ * @param[in]  sql    SQL statement, with parameters $1, $2 and so on.
+ * @param[in]  ...    Parameters, as sql_param_t pointers, ending with NULL.
+ */
+void
+sql_ps (const char* sql, ...)
+{
+  unsigned int deadlock_amount =  0;
+  while (1)
+    {
+      va_list args;
+      int ret;
+
+      va_start (args, sql);
+      ret = sqlv_x (1, 1, sql, args);
+      va_end (args);
+      if (ret == 1)
+        /* Gave up with statement reset. */
+        continue;
+      else if (ret == 4)
+        {
+          if (deadlock_amount++ > DEADLOCK_THRESHOLD)
+            g_warning ("%s: %d deadlocks detected, waiting and retrying %s",
+                       __func__, deadlock_amount, sql);
+          gvm_usleep (DEADLOCK_SLEEP);
+          continue;
+        }
+      else if (ret)
+        abort();
+      break;
+    }
+}
+
+/**
+ * @brief Get a particular cell from a SQL query, formatted or prepared.
  *
+ * @param[in]   ps           Whether \p sql is a prepared statement, in which
+ *                           case \p args are the parameters.
  * @param[in]   sql          Format string for SQL query.
  * @param[in]   args         Arguments for format string.
  * @param[out]  stmt_return  Return from statement.
  *
  * @return 0 success, 1 too few rows, -1 error.
  */
-int
-sql_x (char* sql, va_list args, sql_stmt_t** stmt_return)
+static int
+sql_x_internal (int ps, const char* sql, va_list args,
+                sql_stmt_t** stmt_return)
 {
   int ret;
 
@@ -373,7 +460,10 @@ sql_x (char* sql, va_list args, sql_stmt_t** stmt_return)
        */
       va_list args_copy;
       va_copy (args_copy, args);
-      ret = sql_prepare_internal (1, 1, sql, args_copy, stmt_return);
+      if (ps)
+        ret = sql_prepare_ps_internal (1, 1, sql, args_copy, stmt_return);
+      else
+        ret = sql_prepare_internal (1, 1, sql, args_copy, stmt_return);
       va_end (args_copy);
 
       if (ret)
@@ -407,6 +497,21 @@ sql_x (char* sql, va_list args, sql_stmt_t** stmt_return)
   return 0;
 }
 
+/**
+ * @brief Get a particular cell from a SQL query.
+ *
+ * @param[in]   sql          Format string for SQL query.
+ * @param[in]   args         Arguments for format string.
+ * @param[out]  stmt_return  Return from statement.
+ *
+ * @return 0 success, 1 too few rows, -1 error.
+ */
+int
+sql_x (char* sql, va_list args, sql_stmt_t** stmt_return)
+{
+  return sql_x_internal (0, sql, args, stmt_return);
+}
+
 /**
  * @brief Get the first value from a SQL query, as a double.
  *
@@ -579,6 +684,257 @@ sql_int64_0 (char* sql, ...)
   return ret;
 }
 
+/**
+ * @brief Get the first value from a prepared SQL query, as an int.
+ *
+ * @warning Aborts on invalid queries.
+ *
+ * @warning Aborts when the query returns no rows.
+ *
+ * @param[in]  sql    SQL query, with parameters $1, $2 and so on.
+ * @param[in]  ...    Parameters, as sql_param_t pointers, ending with NULL.
+ *
+ * @return Result of the query as an integer.
+ */
+int
+sql_int_ps (const char* sql, ...)
+{
+  sql_stmt_t* stmt;
+  va_list args;
+  int ret;
+
+  int sql_x_ret;
+  va_start (args, sql);
+  sql_x_ret = sql_x_internal (1, sql, args, &stmt);
+  va_end (args);
+  if (sql_x_ret)
+    {
+      sql_finalize (stmt);
+      abort ();
+    }
+  ret = sql_column_int (stmt, 0);
+  sql_finalize (stmt);
+  return ret;
+}
+
+/**
+ * @brief Get the first value from a prepared SQL query, as a string.
+ *
+ * @param[in]  sql    SQL query, with parameters $1, $2 and so on.
+ * @param[in]  ...    Parameters, as sql_param_t pointers, ending with NULL.
+ *
+ * @return Freshly allocated string containing the result, NULL otherwise.
+ *         NULL means that either the selected value was NULL or there were
+ *         no rows in the result.
+ */
+char*
+sql_string_ps (const char* sql, ...)
+{
+  sql_stmt_t* stmt;
+  const char* ret2;
+  char* ret;
+  int sql_x_ret;
+
+  va_list args;
+  va_start (args, sql);
+  sql_x_ret = sql_x_internal (1, sql, args, &stmt);
+  va_end (args);
+  if (sql_x_ret)
+    {
+      sql_finalize (stmt);
+      return NULL;
+    }
+  ret2 = sql_column_text (stmt, 0);
+  ret = g_strdup (ret2);
+  sql_finalize (stmt);
+  return ret;
+}
+
+/**
+ * @brief Get the first value from a prepared SQL query, as an int64.
+ *
+ * @param[in]  ret    Return value.
+ * @param[in]  sql    SQL query, with parameters $1, $2 and so on.
+ * @param[in]  ...    Parameters, as sql_param_t pointers, ending with NULL.
+ *
+ * @return 0 success, 1 too few rows, -1 error.
+ */
+int
+sql_int64_ps (long long int* ret, const char* sql, ...)
+{
+  sql_stmt_t* stmt;
+  int sql_x_ret;
+  va_list args;
+
+  va_start (args, sql);
+  sql_x_ret = sql_x_internal (1, sql, args, &stmt);
+  va_end (args);
+  switch (sql_x_ret)
+    {
+      case  0:
+        break;
+      case  1:
+        sql_finalize (stmt);
+        return 1;
+        break;
+      default:
+        assert (0);
+        /* Fall through. */
+      case -1:
+        sql_finalize (stmt);
+        return -1;
+        break;
+    }
+  *ret = sql_column_int64 (stmt, 0);
+  sql_finalize (stmt);
+  return 0;
+}
+
+/**
+ * @brief Get the first value from a prepared SQL query, as an int64.
+ *
+ * Return 0 on error.
+ *
+ * @param[in]  sql    SQL query, with parameters $1, $2 and so on.
+ * @param[in]  ...    Parameters, as sql_param_t pointers, ending with NULL.
+ *
+ * @return Column value.  0 if no row.
+ */
+long long int
+sql_int64_0_ps (const char* sql, ...)
+{
+  sql_stmt_t* stmt;
+  int sql_x_ret;
+  long long int ret;
+  va_list args;
+
+  va_start (args, sql);
+  sql_x_ret = sql_x_internal (1, sql, args, &stmt);
+  va_end (args);
+  if (sql_x_ret)
+    {
+      sql_finalize (stmt);
+      return 0;
+    }
+  ret = sql_column_int64 (stmt, 0);
+  sql_finalize (stmt);
+  return ret;
+}
+
+
+/* Batches. */
+
+/**
+ * @brief Begin a batch of SQL statements.
+ *
+ * The statements must not depend on each others results, because they are
+ * sent to the database together, in a single round trip.  Unless the batch
+ * runs inside a transaction, each flush of the batch runs as a transaction
+ * of its own.
+ *
+ * @return Batch.  Free with sql_batch_end.
+ */
+sql_batch_t *
+sql_batch_begin ()
+{
+  sql_batch_t *batch;
+
+  batch = g_malloc (sizeof (*batch));
+  batch->sql = g_string_new ("");
+  batch->count = 0;
+  return batch;
+}
+
+/**
+ * @brief Add a statement to a batch.
+ *
+ * Sends the batch if it has grown large.
+ *
+ * @param[in]  batch  Batch.
+ * @param[in]  sql    Format string for SQL statement.
+ * @param[in]  ...    Arguments for format string.
+ */
+void
+sql_batch_add (sql_batch_t *batch, const char *sql, ...)
+{
+  va_list args;
+  gchar *statement;
+
+  va_start (args, sql);
+  statement = g_strdup_vprintf (sql, args);
+  va_end (args);
+
+  g_debug ("   sql batch: %s", statement);
+  g_strchomp (statement);
+  g_string_append (batch->sql, statement);
+  if (batch->sql->len && batch->sql->str[batch->sql->len - 1] != ';')
+    g_string_append_c (batch->sql, ';');
+  g_string_append_c (batch->sql, '\n');
+  g_free (statement);
+  batch->count++;
+
+  if (batch->sql->len >= SQL_BATCH_MAX_SIZE)
+    sql_batch_flush (batch);
+}
+
+/**
+ * @brief Send the statements of a batch to the database.
+ *
+ * @warning Aborts if a statement fails, like sql.
+ *
+ * @param[in]  batch  Batch.
+ */
+void
+sql_batch_flush (sql_batch_t *batch)
+{
+  if (batch->count == 0)
+    return;
+
+  if (sql_exec_batch_internal (batch->sql->str))
+    {
+      g_warning ("%s: sql_exec_batch_internal failed", __func__);
+      abort ();
+    }
+
+  g_string_truncate (batch->sql, 0);
+  batch->count = 0;
+}
+
+/**
+ * @brief Send the rest of a batch and free it.
+ *
+ * @param[in]  batch  Batch.
+ */
+void
+sql_batch_end (sql_batch_t *batch)
+{
+  if (batch == NULL)
+    return;
+  sql_batch_flush (batch);
+  g_string_free (batch->sql, TRUE);
+  g_free (batch);
+}
+
+/**
+ * @brief Load rows into a table with COPY FROM STDIN.
+ *
+ * @warning Aborts on failure, like sql.
+ *
+ * @param[in]  copy_sql  COPY ... FROM STDIN statement.
+ * @param[in]  data      Rows, in COPY text format.
+ * @param[in]  length    Length of data.
+ */
+void
+sql_copy_in (const char *copy_sql, const char *data, size_t length)
+{
+  g_debug ("   sql copy: %s (%zu bytes)", copy_sql, length);
+  if (sql_copy_in_internal (copy_sql, data, length))
+    {
+      g_warning ("%s: sql_copy_in_internal failed", __func__);
+      abort ();
+    }
+}
+
 
 /* Iterators. */
 
@@ -609,6 +965,34 @@ init_iterator (iterator_t* iterator, const char* sql, ...)
   iterator->stmt = stmt;
 }
 
+/**
+ * @brief Initialise an iterator over a prepared statement.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  sql       SQL, with parameters $1, $2 and so on.
+ * @param[in]  ...       Parameters, as sql_param_t pointers, ending with NULL.
+ */
+void
+init_ps_iterator (iterator_t* iterator, const char* sql, ...)
+{
+  int ret;
+  sql_stmt_t* stmt;
+  va_list args;
+
+  iterator->done = FALSE;
+  iterator->crypt_ctx = NULL;
+
+  va_start (args, sql);
+  ret = sql_prepare_ps_internal (1, 1, sql, args, &stmt);
+  va_end (args);
+  if (ret)
+    {
+      g_warning ("%s: sql_prepare failed", __func__);
+      abort ();
+    }
+  iterator->stmt = stmt;
+}
+
 /**
  * @brief Get a double column from an iterator.
  *
@@ -725,7 +1109,7 @@ next (iterator_t* iterator)
   if (iterator->done) return FALSE;
 
   if (iterator->crypt_ctx)
-    lsc_crypt_flush (iterator->crypt_ctx);
+    lsc_crypt_reset (iterator->crypt_ctx);
   while (1)
     {
       ret = sql_exec_internal (1, iterator->stmt);
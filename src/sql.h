@@ -29,6 +29,62 @@
 
 #include <glib.h>
 
+/* Statement parameters. */
+
+/**
+ * @brief Type of a statement parameter.
+ */
+typedef enum
+{
+  SQL_PARAM_TYPE_DOUBLE,
+  SQL_PARAM_TYPE_INT,
+  SQL_PARAM_TYPE_RESOURCE,
+  SQL_PARAM_TYPE_STRING
+} sql_param_type_t;
+
+/**
+ * @brief A parameter of a prepared statement.
+ */
+typedef struct
+{
+  sql_param_type_t type;           ///< Type of value.
+  union
+  {
+    double double_value;           ///< Double value.
+    int int_value;                 ///< Integer value.
+    resource_t resource_value;     ///< Resource value.
+    const char *string_value;      ///< String value, NULL for SQL NULL.
+  } value;                         ///< Value.
+} sql_param_t;
+
+/**
+ * @brief Statement parameter from a double.
+ */
+#define SQL_DOUBLE_PARAM(v)                                           \
+  (&(sql_param_t) { .type = SQL_PARAM_TYPE_DOUBLE,                   \
+                    .value.double_value = (v) })
+
+/**
+ * @brief Statement parameter from an int.
+ */
+#define SQL_INT_PARAM(v)                                              \
+  (&(sql_param_t) { .type = SQL_PARAM_TYPE_INT,                      \
+                    .value.int_value = (v) })
+
+/**
+ * @brief Statement parameter from a resource.
+ */
+#define SQL_RESOURCE_PARAM(v)                                         \
+  (&(sql_param_t) { .type = SQL_PARAM_TYPE_RESOURCE,                 \
+                    .value.resource_value = (v) })
+
+/**
+ * @brief Statement parameter from a string.  The string is not quoted.
+ */
+#define SQL_STR_PARAM(v)                                              \
+  (&(sql_param_t) { .type = SQL_PARAM_TYPE_STRING,                   \
+                    .value.string_value = (v) })
+
 /* Helpers. */
 
 const char *
@@ -55,6 +111,33 @@ sql_default_database ();
 void
 sql_recursive_triggers_off ();
 
+void
+sql_set_slow_query_threshold (int);
+
+void
+sql_stats_reset ();
+
+void
+sql_set_replica (const gchar *, const gchar *, int);
+
+void
+sql_set_transaction_pooling (int);
+
+void
+sql_session_set (const char *, const char *);
+
+int
+sql_use_replica ();
+
+void
+sql_use_primary ();
+
+void
+sql_stats (int *, gint64 *);
+
+void
+sql_stats_add (int, gint64);
+
 int
 sql_is_open ();
 
@@ -115,9 +198,49 @@ sql_int64_0 (char *sql, ...);
 void
 sql_rename_column (const char *, const char *, const char *, const char *);
 
+/* Prepared statements.  The SQL refers to the parameters as $1, $2 and so
+ * on, and the parameters follow as sql_param_t pointers, ending with NULL. */
+
+void
+sql_ps (const char *, ...);
+
+int
+sql_int_ps (const char *, ...);
+
+char *
+sql_string_ps (const char *, ...);
+
+int
+sql_int64_ps (long long int *, const char *, ...);
+
+long long int
+sql_int64_0_ps (const char *, ...);
+
 int
 sql_cancel_internal ();
 
+/* Batches. */
+
+/**
+ * @brief A batch of SQL statements, sent to the database together.
+ */
+typedef struct sql_batch sql_batch_t;
+
+sql_batch_t *
+sql_batch_begin ();
+
+void
+sql_batch_add (sql_batch_t *, const char *, ...);
+
+void
+sql_batch_flush (sql_batch_t *);
+
+void
+sql_batch_end (sql_batch_t *);
+
+void
+sql_copy_in (const char *, const char *, size_t);
+
 /* Transactions. */
 
 void
@@ -140,9 +263,15 @@ sql_rollback ();
 void
 init_iterator (iterator_t *, const char *, ...);
 
+void
+init_ps_iterator (iterator_t *, const char *, ...);
+
 void
 iterator_rewind (iterator_t *iterator);
 
+void
+iterator_use_cursor (iterator_t *);
+
 double
 iterator_double (iterator_t *, int);
 
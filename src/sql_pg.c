@@ -24,6 +24,7 @@
  */
 
 #include "sql.h"
+#include "utils.h"
 
 #include <assert.h>
 #include <endian.h>
@@ -62,9 +63,14 @@ struct sql_stmt
   PGresult *result;       ///< Result set.
   int current_row;        ///< Row position in results.
   int executed;           ///< Whether statement has been executed.
+  int prepared;           ///< Whether to run as a prepared statement.
+  gchar *cursor;          ///< Name of cursor to fetch rows from, or NULL.
+  int cursor_done;        ///< Whether all rows were fetched from the cursor.
   array_t *param_values;  ///< Parameter values.
   GArray *param_lengths;  ///< Parameter lengths (int's).
   GArray *param_formats;  ///< Parameter formats (int's).
+  gint64 elapsed;         ///< Time spent executing, in microseconds.
+  PGconn *conn;           ///< Connection the statement was executed on.
 };
 
 
@@ -79,13 +85,245 @@ struct sql_stmt
 extern int log_errors;
 
 /**
- * @brief Handle on the database.
+ * @brief Handle on the database that statements run on.
+ *
+ * This is the primary, except between sql_use_replica and sql_use_primary,
+ * when it may be the read replica.
  */
 static PGconn *conn = NULL;
 
+/**
+ * @brief Handle on the primary database.
+ */
+static PGconn *primary_conn = NULL;
+
+/**
+ * @brief Handle on the read replica, or NULL if not connected.
+ */
+static PGconn *replica_conn = NULL;
+
+/**
+ * @brief Host or socket directory of the read replica, NULL for no replica.
+ */
+static gchar *replica_host = NULL;
+
+/**
+ * @brief Port or socket extension of the read replica.
+ */
+static gchar *replica_port = NULL;
+
+/**
+ * @brief Replication lag in seconds above which the replica is not used.
+ */
+static int replica_max_lag = 0;
+
+/**
+ * @brief Monotonic time before which not to connect to the replica again.
+ */
+static gint64 replica_retry_time = 0;
+
+/**
+ * @brief Seconds to wait before connecting again after the replica failed.
+ */
+#define REPLICA_RETRY_INTERVAL 60
+
+/**
+ * @brief Whether the database is reached through a transaction pooler.
+ *
+ * A pooler like PgBouncer in transaction mode may hand each transaction to
+ * a different backend, so no state may be left in the session.
+ */
+static int transaction_pooling = 0;
+
+/**
+ * @brief Session settings to apply to each transaction, when pooling.
+ */
+static GHashTable *pool_settings = NULL;
+
+/**
+ * @brief ID of the row inserted by the last statement run in its own
+ *        transaction, when pooling.
+ */
+static resource_t pool_last_insert_id = 0;
+
+/**
+ * @brief Names of the prepared statements of the primary, keyed on SQL.
+ */
+static GHashTable *prepared_statements = NULL;
+
+/**
+ * @brief Names of the prepared statements of the replica, keyed on SQL.
+ */
+static GHashTable *replica_prepared_statements = NULL;
+
+/**
+ * @brief Counter for the names of prepared statements.
+ */
+static unsigned int prepared_statement_count = 0;
+
+/**
+ * @brief Number of rows to fetch at a time from a cursor.
+ */
+#define SQL_CURSOR_FETCH_SIZE 1000
+
+/**
+ * @brief Counter for the names of cursors.
+ */
+static unsigned int cursor_count = 0;
+
+/**
+ * @brief Time in milliseconds above which a statement is logged, 0 for never.
+ */
+static int slow_query_threshold = 0;
+
+/**
+ * @brief Number of statements run since the last sql_stats_reset.
+ */
+static int stats_count = 0;
+
+/**
+ * @brief Time spent in statements since the last sql_stats_reset, in
+ *        microseconds.
+ */
+static gint64 stats_time = 0;
+
 
 /* Helpers. */
 
+/**
+ * @brief Set the time above which statements are logged as slow.
+ *
+ * @param[in]  threshold  Threshold in milliseconds, 0 to disable.
+ */
+void
+sql_set_slow_query_threshold (int threshold)
+{
+  slow_query_threshold = threshold > 0 ? threshold : 0;
+}
+
+/**
+ * @brief Set whether the database is reached through a transaction pooler.
+ *
+ * When pooling, session settings are applied to every transaction with
+ * SET LOCAL, every statement outside a transaction runs in a transaction
+ * of its own, and cursors and prepared statements are not used, because
+ * they live in a backend session.
+ *
+ * @param[in]  pooling  1 for a transaction pooler, 0 for a direct connection.
+ */
+void
+sql_set_transaction_pooling (int pooling)
+{
+  transaction_pooling = pooling ? 1 : 0;
+}
+
+/**
+ * @brief Set a setting for the rest of the session.
+ *
+ * When pooling, the setting is remembered and applied to each transaction.
+ *
+ * @param[in]  name   Name of setting, for example "TimeZone".
+ * @param[in]  value  Value.
+ */
+void
+sql_session_set (const char *name, const char *value)
+{
+  gchar *quoted_name, *quoted_value;
+
+  if (transaction_pooling)
+    {
+      if (pool_settings == NULL)
+        pool_settings = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, g_free);
+      g_hash_table_insert (pool_settings, g_strdup (name), g_strdup (value));
+      /* Later transactions get the setting when they start.  A transaction
+       * that is already open needs it now. */
+      if (conn == NULL || PQtransactionStatus (conn) == PQTRANS_IDLE)
+        return;
+    }
+
+  quoted_name = sql_quote (name);
+  quoted_value = sql_quote (value);
+  sql ("SELECT set_config ('%s', '%s', %s);",
+       quoted_name,
+       quoted_value,
+       transaction_pooling ? "true" : "false");
+  g_free (quoted_name);
+  g_free (quoted_value);
+}
+
+/**
+ * @brief Set the read replica that read-only commands may use.
+ *
+ * @param[in]  host     Host or socket directory of the replica, NULL for none.
+ * @param[in]  port     Port or socket extension of the replica.
+ * @param[in]  max_lag  Replication lag in seconds above which the primary is
+ *                      used instead.
+ */
+void
+sql_set_replica (const gchar *host, const gchar *port, int max_lag)
+{
+  g_free (replica_host);
+  g_free (replica_port);
+  replica_host = (host && strlen (host)) ? g_strdup (host) : NULL;
+  replica_port = g_strdup (port);
+  replica_max_lag = max_lag > 0 ? max_lag : 0;
+}
+
+/**
+ * @brief Reset the statement count and time.
+ */
+void
+sql_stats_reset ()
+{
+  stats_count = 0;
+  stats_time = 0;
+}
+
+/**
+ * @brief Add to the statement count and time.
+ *
+ * @param[in]  count  Number of statements.
+ * @param[in]  time   Time spent in the statements, in microseconds.
+ */
+void
+sql_stats_add (int count, gint64 time)
+{
+  stats_count += count;
+  stats_time += time;
+}
+
+/**
+ * @brief Get the statement count and time since the last sql_stats_reset.
+ *
+ * @param[out]  count  Number of statements.
+ * @param[out]  time   Time spent in the statements, in microseconds.
+ */
+void
+sql_stats (int *count, gint64 *time)
+{
+  if (count)
+    *count = stats_count;
+  if (time)
+    *time = stats_time;
+}
+
+/**
+ * @brief Log a statement if it took longer than the slow query threshold.
+ *
+ * @param[in]  sql      SQL statement.
+ * @param[in]  elapsed  Time spent in the statement, in microseconds.
+ */
+static void
+sql_log_slow (const char *sql, gint64 elapsed)
+{
+  if (slow_query_threshold
+      && elapsed >= (gint64) slow_query_threshold * 1000)
+    g_log (GVMD_PERF_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE,
+           "slow_sql ms=%" G_GINT64_FORMAT " sql=%s",
+           elapsed / 1000, sql);
+}
+
 /**
  * @brief Get main schema name.
  *
@@ -264,15 +502,16 @@ sql_default_database ()
 }
 
 /**
- * @brief Open the database.
+ * @brief Connect to a database.
  *
- * @param[in]  database  Database, or NULL for default.
+ * @param[in]  database  Database.
  *
- * @return 0 success, -1 error.
+ * @return Connection on success, NULL on error.
  */
-int
-sql_open (const db_conn_info_t *database)
+static PGconn *
+sql_connect (const db_conn_info_t *database)
 {
+  PGconn *new_conn;
   gchar *conn_info;
   PostgresPollingStatusType poll_status;
   int socket;
@@ -289,24 +528,24 @@ sql_open (const db_conn_info_t *database)
                                database->port ? database->port : "",
                                database->user ? database->user : "",
                                "gvmd");
-  conn = PQconnectStart (conn_info);
+  new_conn = PQconnectStart (conn_info);
   g_free (conn_info);
-  if (conn == NULL)
+  if (new_conn == NULL)
     {
       g_warning ("%s: PQconnectStart failed to allocate conn",
                  __func__);
-      return -1;
+      return NULL;
     }
-  if (PQstatus (conn) == CONNECTION_BAD)
+  if (PQstatus (new_conn) == CONNECTION_BAD)
     {
       g_warning ("%s: PQconnectStart to '%s' failed: %s",
                  __func__,
                  database->name ? database->name : sql_default_database (),
-                 PQerrorMessage (conn));
+                 PQerrorMessage (new_conn));
       goto fail;
     }
 
-  socket = PQsocket (conn);
+  socket = PQsocket (new_conn);
   if (socket == 0)
     {
       g_warning ("%s: PQsocket 0", __func__);
@@ -362,141 +601,816 @@ sql_open (const db_conn_info_t *database)
           g_warning ("%s: PQconnectPoll failed",
                      __func__);
           g_warning ("%s: PQerrorMessage (conn): %s", __func__,
-                     PQerrorMessage (conn));
+                     PQerrorMessage (new_conn));
           goto fail;
         }
       else if (poll_status == PGRES_POLLING_OK)
         /* Connection is ready, exit loop. */
         break;
 
-      poll_status = PQconnectPoll (conn);
+      poll_status = PQconnectPoll (new_conn);
     }
 
-  PQsetNoticeReceiver (conn, log_notice, NULL);
+  PQsetNoticeReceiver (new_conn, log_notice, NULL);
 
-  g_debug ("%s:   db: %s", __func__, PQdb (conn));
-  g_debug ("%s: user: %s", __func__, PQuser (conn));
-  g_debug ("%s: host: %s", __func__, PQhost (conn));
-  g_debug ("%s: port: %s", __func__, PQport (conn));
-  g_debug ("%s: socket: %i", __func__, PQsocket (conn));
-  g_debug ("%s: postgres version: %i", __func__, PQserverVersion (conn));
+  g_debug ("%s:   db: %s", __func__, PQdb (new_conn));
+  g_debug ("%s: user: %s", __func__, PQuser (new_conn));
+  g_debug ("%s: host: %s", __func__, PQhost (new_conn));
+  g_debug ("%s: port: %s", __func__, PQport (new_conn));
+  g_debug ("%s: socket: %i", __func__, PQsocket (new_conn));
+  g_debug ("%s: postgres version: %i", __func__, PQserverVersion (new_conn));
 
-  if (PQserverVersion (conn) < 90600)
+  if (PQserverVersion (new_conn) < 90600)
     {
       g_warning ("%s: PostgreSQL version 9.6 (90600) or higher is required",
                  __func__);
       g_warning ("%s: Current version is %i", __func__,
-                 PQserverVersion (conn));
+                 PQserverVersion (new_conn));
       goto fail;
     }
 
-  return 0;
+  return new_conn;
 
  fail:
-  PQfinish (conn);
-  conn = NULL;
-  return -1;
+  PQfinish (new_conn);
+  return NULL;
 }
 
 /**
- * @brief Close the database.
+ * @brief Open the database.
+ *
+ * @param[in]  database  Database, or NULL for default.
+ *
+ * @return 0 success, -1 error.
  */
-void
-sql_close ()
+int
+sql_open (const db_conn_info_t *database)
 {
-  PQfinish (conn);
-  conn = NULL;
+  primary_conn = sql_connect (database);
+  conn = primary_conn;
+  return conn ? 0 : -1;
 }
 
 /**
- * @brief Close the database in a forked process.
+ * @brief Start a transaction with the session settings, when pooling.
+ *
+ * @param[in]  connection  Connection.
+ *
+ * @return 0 success, -1 error.
  */
-void
-sql_close_fork ()
+static int
+sql_pool_begin (PGconn *connection)
 {
-  conn = NULL;
+  GString *begin;
+  GHashTableIter iter;
+  gpointer name, value;
+  PGresult *result;
+  int first, ret;
+
+  begin = g_string_new ("BEGIN;");
+  if (pool_settings)
+    {
+      first = 1;
+      g_hash_table_iter_init (&iter, pool_settings);
+      while (g_hash_table_iter_next (&iter, &name, &value))
+        {
+          char *quoted_name, *quoted_value;
+
+          quoted_name = PQescapeLiteral (connection, name, strlen (name));
+          quoted_value = PQescapeLiteral (connection, value, strlen (value));
+          g_string_append_printf (begin, "%s set_config (%s, %s, true)",
+                                  first ? " SELECT" : ",",
+                                  quoted_name ? quoted_name : "''",
+                                  quoted_value ? quoted_value : "''");
+          PQfreemem (quoted_name);
+          PQfreemem (quoted_value);
+          first = 0;
+        }
+      if (first == 0)
+        g_string_append (begin, ";");
+    }
+
+  result = PQexec (connection, begin->str);
+  ret = 0;
+  if (PQresultStatus (result) != PGRES_TUPLES_OK
+      && PQresultStatus (result) != PGRES_COMMAND_OK)
+    {
+      if (log_errors)
+        g_warning ("%s: failed to begin transaction: %s",
+                   __func__,
+                   PQresultErrorMessage (result));
+      ret = -1;
+    }
+  PQclear (result);
+  g_string_free (begin, TRUE);
+  if (ret && PQtransactionStatus (connection) != PQTRANS_IDLE)
+    PQclear (PQexec (connection, "ROLLBACK;"));
+  return ret;
 }
 
 /**
- * @brief Return 0.
+ * @brief End a transaction started by sql_pool_begin.
  *
- * @return 0.
+ * @param[in]  connection  Connection.
+ * @param[in]  failed      Whether to roll the transaction back.
+ *
+ * @return 0 success, -1 error.
  */
-int
-sql_changes ()
+static int
+sql_pool_end (PGconn *connection, int failed)
 {
-  /* TODO PQcmdTuples needs a PQresult.  Callers use for info only anyway. */
-  return 0;
+  PGresult *result;
+  int ret;
+
+  result = PQexec (connection, failed ? "ROLLBACK;" : "COMMIT;");
+  ret = PQresultStatus (result) == PGRES_COMMAND_OK ? 0 : -1;
+  if (ret && log_errors)
+    g_warning ("%s: failed to end transaction: %s",
+               __func__,
+               PQresultErrorMessage (result));
+  PQclear (result);
+  return ret;
 }
 
 /**
- * @brief Get the ID of the last inserted row.
+ * @brief Check whether a statement outside a transaction needs its own one.
  *
- * @return Resource.
+ * @return 1 if so, else 0.
  */
-resource_t
-sql_last_insert_id ()
+static int
+sql_pool_wrap_needed ()
 {
-  return sql_int ("SELECT LASTVAL ();");
+  return transaction_pooling
+         && conn
+         && PQtransactionStatus (conn) == PQTRANS_IDLE;
 }
 
 /**
- * @brief Prepare a statement.
+ * @brief Remember the ID of the row inserted in the current transaction.
  *
- * @param[in]  retry  Whether to keep retrying while database is busy or locked.
- * @param[in]  log    Whether to keep retrying while database is busy or locked.
- * @param[in]  sql    Format string for SQL statement.
- * @param[in]  args   Arguments for format string.
- * @param[out] stmt   Statement return.
+ * LASTVAL only works on the backend that ran the INSERT, which may already
+ * be serving someone else once the transaction ends.
  *
- * @return 0 success, 1 gave up, -1 error.
+ * @param[in]  connection  Connection.
  */
-int
-sql_prepare_internal (int retry, int log, const char* sql, va_list args,
-                      sql_stmt_t **stmt)
+static void
+sql_pool_save_last_insert_id (PGconn *connection)
 {
-  assert (stmt);
+  PGresult *result;
 
-  *stmt = (sql_stmt_t*) g_malloc (sizeof (sql_stmt_t));
-  sql_stmt_init (*stmt);
-  (*stmt)->sql = g_strdup_vprintf (sql, args);
+  /* LASTVAL fails if no sequence was used, so guard it with a savepoint. */
+  result = PQexec (connection, "SAVEPOINT gvmd_lastval; SELECT LASTVAL ();");
+  if (PQresultStatus (result) == PGRES_TUPLES_OK && PQntuples (result) == 1)
+    pool_last_insert_id = strtoull (PQgetvalue (result, 0, 0), NULL, 10);
+  else
+    PQclear (PQexec (connection, "ROLLBACK TO SAVEPOINT gvmd_lastval;"));
+  PQclear (result);
+}
 
-  if (log)
-    g_debug ("   sql: %s", (*stmt)->sql);
+/**
+ * @brief Get the prepared statement names of a connection.
+ *
+ * @param[in]  connection  Connection.
+ *
+ * @return Location of the hashtable of the connection.
+ */
+static GHashTable **
+sql_ps_cache (PGconn *connection)
+{
+  if (replica_conn && connection == replica_conn)
+    return &replica_prepared_statements;
+  return &prepared_statements;
+}
 
-  return 0;
+/**
+ * @brief Forget the prepared statements of the connections.
+ *
+ * Prepared statements only exist in the session that prepared them.
+ */
+static void
+sql_ps_cache_clear ()
+{
+  if (prepared_statements)
+    {
+      g_hash_table_destroy (prepared_statements);
+      prepared_statements = NULL;
+    }
+  if (replica_prepared_statements)
+    {
+      g_hash_table_destroy (replica_prepared_statements);
+      replica_prepared_statements = NULL;
+    }
 }
 
 /**
- * @brief Execute a statement.
+ * @brief Close the database.
+ */
+void
+sql_close ()
+{
+  if (replica_conn)
+    PQfinish (replica_conn);
+  PQfinish (primary_conn);
+  conn = NULL;
+  primary_conn = NULL;
+  replica_conn = NULL;
+  sql_ps_cache_clear ();
+}
+
+/**
+ * @brief Close the database in a forked process.
+ */
+void
+sql_close_fork ()
+{
+  conn = NULL;
+  primary_conn = NULL;
+  replica_conn = NULL;
+  sql_ps_cache_clear ();
+}
+
+/**
+ * @brief Drop the connection to the replica after it failed.
+ */
+static void
+sql_replica_drop ()
+{
+  if (conn == replica_conn)
+    conn = primary_conn;
+  PQfinish (replica_conn);
+  replica_conn = NULL;
+  if (replica_prepared_statements)
+    {
+      g_hash_table_destroy (replica_prepared_statements);
+      replica_prepared_statements = NULL;
+    }
+  replica_retry_time = g_get_monotonic_time ()
+                       + REPLICA_RETRY_INTERVAL * G_USEC_PER_SEC;
+}
+
+/**
+ * @brief Copy the session settings of gvmd from one connection to another.
  *
- * @param[in]  retry  Whether to keep retrying while database is busy or locked.
- * @param[in]  stmt   Statement.
+ * These are the user, the timezone and the schema search path, which the
+ * SQL functions of gvmd depend on.
  *
- * @return 0 complete, 1 row available in results, -1 error, -2 gave up,
- *         -3 lock unavailable, -4 unique constraint violation.
+ * @param[in]  from  Connection to copy the settings from.
+ * @param[in]  to    Connection to copy the settings to.
+ *
+ * @return 0 success, -1 error.
  */
-int
-sql_exec_internal (int retry, sql_stmt_t *stmt)
+static int
+sql_session_copy (PGconn *from, PGconn *to)
 {
-  PGresult *result;
-
-  assert (stmt->sql);
+  PGresult *settings, *result;
+  const char *values[4];
+  int index, ret;
+
+  settings = PQexec (from,
+                     "SELECT current_setting ('gvmd.user.id', true),"
+                     "       current_setting ('gvmd.tz_override', true),"
+                     "       current_setting ('TimeZone'),"
+                     "       current_setting ('search_path');");
+  if (PQresultStatus (settings) != PGRES_TUPLES_OK
+      || PQntuples (settings) != 1)
+    {
+      g_warning ("%s: failed to get settings: %s",
+                 __func__,
+                 PQresultErrorMessage (settings));
+      PQclear (settings);
+      return -1;
+    }
 
-  if (stmt->executed == 0)
+  for (index = 0; index < 4; index++)
+    values[index] = PQgetisnull (settings, 0, index)
+                     ? NULL
+                     : PQgetvalue (settings, 0, index);
+
+  result = PQexecParams (to,
+                         "SELECT set_config ('gvmd.user.id', $1, false),"
+                         "       set_config ('gvmd.tz_override', $2, false),"
+                         "       set_config ('TimeZone', $3, false),"
+                         "       set_config ('search_path', $4, false);",
+                         4, NULL, values, NULL, NULL, 0);
+  ret = 0;
+  if (PQresultStatus (result) != PGRES_TUPLES_OK)
     {
-      result = PQexecParams (conn,
-                             stmt->sql,
-                             stmt->param_values->len,
-                             NULL,                 /* Default param types. */
-                             (const char* const*) stmt->param_values->pdata,
-                             (const int*) stmt->param_lengths->data,
-                             (const int*) stmt->param_formats->data,
-                             0);                   /* Results as text. */
-      if (PQresultStatus (result) != PGRES_TUPLES_OK
-          && PQresultStatus (result) != PGRES_COMMAND_OK)
-        {
-          char *sqlstate;
+      g_warning ("%s: failed to set settings: %s",
+                 __func__,
+                 PQresultErrorMessage (result));
+      ret = -1;
+    }
+  PQclear (result);
+  PQclear (settings);
+  return ret;
+}
+
+/**
+ * @brief Get the replication lag of the replica.
+ *
+ * @return Lag in seconds, 0 if the replica has replayed everything it
+ *         received, -1 if unknown.
+ */
+static int
+sql_replica_lag ()
+{
+  PGresult *result;
+  int lag;
+
+  result = PQexec (replica_conn,
+                   "SELECT CASE"
+                   "       WHEN pg_last_wal_receive_lsn ()"
+                   "            = pg_last_wal_replay_lsn ()"
+                   "       THEN 0"
+                   "       ELSE coalesce"
+                   "             (extract (epoch FROM now ()"
+                   "                       - pg_last_xact_replay_timestamp ())"
+                   "              ::integer,"
+                   "              -1)"
+                   "       END;");
+  if (PQresultStatus (result) != PGRES_TUPLES_OK
+      || PQntuples (result) != 1)
+    {
+      g_warning ("%s: failed to get replica lag: %s",
+                 __func__,
+                 PQresultErrorMessage (result));
+      PQclear (result);
+      return -1;
+    }
+  lag = atoi (PQgetvalue (result, 0, 0));
+  PQclear (result);
+  return lag;
+}
+
+/**
+ * @brief Run following statements on the read replica, if possible.
+ *
+ * Stays on the primary if there is no replica, if the replica cannot be
+ * reached or lags too far behind, or if a transaction is open on the
+ * primary.  Transactions always move back to the primary, and so do
+ * statements that the replica refuses because they write.
+ *
+ * @return 1 if statements now run on the replica, else 0.
+ */
+int
+sql_use_replica ()
+{
+  int lag;
+
+  if (replica_host == NULL || primary_conn == NULL)
+    return 0;
+
+  if (replica_conn && conn == replica_conn)
+    return 1;
+
+  if (PQtransactionStatus (primary_conn) != PQTRANS_IDLE)
+    return 0;
+
+  if (replica_conn && PQstatus (replica_conn) == CONNECTION_BAD)
+    {
+      g_warning ("%s: lost connection to replica", __func__);
+      sql_replica_drop ();
+      return 0;
+    }
+
+  if (replica_conn == NULL)
+    {
+      db_conn_info_t replica;
+
+      if (g_get_monotonic_time () < replica_retry_time)
+        return 0;
+
+      replica.name = PQdb (primary_conn);
+      replica.host = replica_host;
+      replica.port = replica_port;
+      replica.user = PQuser (primary_conn);
+      replica_conn = sql_connect (&replica);
+      if (replica_conn == NULL)
+        {
+          g_warning ("%s: failed to connect to replica, using primary",
+                     __func__);
+          sql_replica_drop ();
+          return 0;
+        }
+    }
+
+  lag = sql_replica_lag ();
+  if (lag < 0 || lag > replica_max_lag)
+    {
+      g_debug ("%s: replica lag %i, using primary", __func__, lag);
+      return 0;
+    }
+
+  /* When pooling the settings are applied to each transaction anyway. */
+  if (transaction_pooling == 0
+      && sql_session_copy (primary_conn, replica_conn))
+    return 0;
+
+  conn = replica_conn;
+  return 1;
+}
+
+/**
+ * @brief Run following statements on the primary.
+ */
+void
+sql_use_primary ()
+{
+  if (conn == primary_conn)
+    return;
+
+  if (transaction_pooling == 0)
+    sql_session_copy (replica_conn, primary_conn);
+  conn = primary_conn;
+}
+
+/**
+ * @brief Return 0.
+ *
+ * @return 0.
+ */
+int
+sql_changes ()
+{
+  /* TODO PQcmdTuples needs a PQresult.  Callers use for info only anyway. */
+  return 0;
+}
+
+/**
+ * @brief Get the ID of the last inserted row.
+ *
+ * @return Resource.
+ */
+resource_t
+sql_last_insert_id ()
+{
+  if (sql_pool_wrap_needed ())
+    return pool_last_insert_id;
+  return sql_int ("SELECT LASTVAL ();");
+}
+
+/**
+ * @brief Prepare a statement.
+ *
+ * @param[in]  retry  Whether to keep retrying while database is busy or locked.
+ * @param[in]  log    Whether to keep retrying while database is busy or locked.
+ * @param[in]  sql    Format string for SQL statement.
+ * @param[in]  args   Arguments for format string.
+ * @param[out] stmt   Statement return.
+ *
+ * @return 0 success, 1 gave up, -1 error.
+ */
+int
+sql_prepare_internal (int retry, int log, const char* sql, va_list args,
+                      sql_stmt_t **stmt)
+{
+  assert (stmt);
+
+  *stmt = (sql_stmt_t*) g_malloc (sizeof (sql_stmt_t));
+  sql_stmt_init (*stmt);
+  (*stmt)->sql = g_strdup_vprintf (sql, args);
+
+  if (log)
+    g_debug ("   sql: %s", (*stmt)->sql);
+
+  return 0;
+}
+
+/**
+ * @brief Prepare a statement, binding parameters instead of formatting.
+ *
+ * The statement is prepared on the server the first time it runs in the
+ * session, and reused after that.
+ *
+ * @param[in]  retry  Whether to keep retrying while database is busy or locked.
+ * @param[in]  log    Whether to log the SQL.
+ * @param[in]  sql    SQL statement, with parameters $1, $2 and so on.
+ * @param[in]  args   Parameters, as sql_param_t pointers, ending with NULL.
+ * @param[out] stmt   Statement return.
+ *
+ * @return 0 success, 1 gave up, -1 error.
+ */
+int
+sql_prepare_ps_internal (int retry, int log, const char* sql, va_list args,
+                         sql_stmt_t **stmt)
+{
+  sql_param_t *param;
+
+  assert (stmt);
+
+  *stmt = (sql_stmt_t*) g_malloc (sizeof (sql_stmt_t));
+  sql_stmt_init (*stmt);
+  (*stmt)->sql = g_strdup (sql);
+  (*stmt)->prepared = 1;
+
+  while ((param = va_arg (args, sql_param_t *)))
+    {
+      gchar *value;
+      int zero;
+
+      switch (param->type)
+        {
+          case SQL_PARAM_TYPE_DOUBLE:
+            value = g_malloc (G_ASCII_DTOSTR_BUF_SIZE);
+            g_ascii_dtostr (value, G_ASCII_DTOSTR_BUF_SIZE,
+                            param->value.double_value);
+            break;
+          case SQL_PARAM_TYPE_INT:
+            value = g_strdup_printf ("%i", param->value.int_value);
+            break;
+          case SQL_PARAM_TYPE_RESOURCE:
+            value = g_strdup_printf ("%llu", param->value.resource_value);
+            break;
+          case SQL_PARAM_TYPE_STRING:
+            value = g_strdup (param->value.string_value);
+            break;
+          default:
+            assert (0);
+            value = NULL;
+            break;
+        }
+
+      /* Text format, so the length is ignored. */
+      zero = 0;
+      array_add ((*stmt)->param_values, value);
+      g_array_append_val ((*stmt)->param_lengths, zero);
+      g_array_append_val ((*stmt)->param_formats, zero);
+    }
+
+  if (log)
+    g_debug ("   sql: %s", (*stmt)->sql);
+
+  return 0;
+}
+
+/**
+ * @brief Get the name of the prepared statement for a statement.
+ *
+ * Prepares the statement on the server if this is the first time.
+ *
+ * @param[in]  stmt  Statement.
+ *
+ * @return Name of prepared statement, NULL on error.
+ */
+static const char *
+sql_ps_name (sql_stmt_t *stmt)
+{
+  const char *name;
+  gchar *new_name;
+  PGresult *result;
+  GHashTable **cache;
+
+  cache = sql_ps_cache (stmt->conn);
+  if (*cache == NULL)
+    *cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  name = g_hash_table_lookup (*cache, stmt->sql);
+  if (name)
+    return name;
+
+  new_name = g_strdup_printf ("gvmd_ps_%u", ++prepared_statement_count);
+  result = PQprepare (stmt->conn, new_name, stmt->sql, stmt->param_values->len,
+                      NULL);                 /* Infer param types. */
+  if (PQresultStatus (result) != PGRES_COMMAND_OK)
+    {
+      if (log_errors)
+        {
+          g_warning ("%s: PQprepare failed: %s",
+                     __func__,
+                     PQresultErrorMessage (result));
+          g_warning ("%s: SQL: %s", __func__, stmt->sql);
+        }
+      PQclear (result);
+      g_free (new_name);
+      return NULL;
+    }
+  PQclear (result);
+
+  g_hash_table_insert (*cache, g_strdup (stmt->sql), new_name);
+  return new_name;
+}
+
+/**
+ * @brief Run a prepared statement.
+ *
+ * @param[in]  stmt  Statement.
+ *
+ * @return Result, NULL if failed to prepare the statement.
+ */
+static PGresult *
+sql_exec_prepared (sql_stmt_t *stmt)
+{
+  const char *name;
+  PGresult *result;
+  char *sqlstate;
+
+  name = sql_ps_name (stmt);
+  if (name == NULL)
+    return NULL;
+
+  result = PQexecPrepared (stmt->conn,
+                           name,
+                           stmt->param_values->len,
+                           (const char* const*) stmt->param_values->pdata,
+                           (const int*) stmt->param_lengths->data,
+                           (const int*) stmt->param_formats->data,
+                           0);                 /* Results as text. */
+
+  sqlstate = PQresultErrorField (result, PG_DIAG_SQLSTATE);
+  if (sqlstate
+      && (strcmp (sqlstate, "0A000") == 0)
+      && PQtransactionStatus (stmt->conn) == PQTRANS_IDLE)
+    {
+      /* feature_not_supported, for example "cached plan must not change
+       * result type" after a table changed.  Prepare again. */
+      g_debug ("%s: re-preparing: %s", __func__, stmt->sql);
+      PQclear (result);
+      g_hash_table_remove (*sql_ps_cache (stmt->conn), stmt->sql);
+      name = sql_ps_name (stmt);
+      if (name == NULL)
+        return NULL;
+      result = PQexecPrepared (stmt->conn,
+                               name,
+                               stmt->param_values->len,
+                               (const char* const*) stmt->param_values->pdata,
+                               (const int*) stmt->param_lengths->data,
+                               (const int*) stmt->param_formats->data,
+                               0);
+    }
+
+  return result;
+}
+
+/**
+ * @brief Get the SQL to declare the cursor of a statement.
+ *
+ * @param[in]  stmt  Statement.
+ *
+ * @return Freshly allocated SQL.
+ */
+static gchar *
+sql_cursor_declare (sql_stmt_t *stmt)
+{
+  gchar *query, *declare;
+  size_t length;
+
+  /* Drop the trailing semicolon, so the query fits inside the DECLARE. */
+  query = g_strdup (stmt->sql);
+  g_strchomp (query);
+  length = strlen (query);
+  while (length && query[length - 1] == ';')
+    query[--length] = '\0';
+
+  /* WITH HOLD so that the cursor survives a COMMIT while iterating. */
+  declare = g_strdup_printf ("DECLARE %s NO SCROLL CURSOR WITH HOLD FOR %s;",
+                             stmt->cursor,
+                             query);
+  g_free (query);
+  return declare;
+}
+
+/**
+ * @brief Get the next row of a statement that fetches from a cursor.
+ *
+ * @param[in]  stmt  Statement.  Cursor must be declared.
+ *
+ * @return 0 complete, 1 row available in results, -1 error.
+ */
+static int
+sql_cursor_next (sql_stmt_t *stmt)
+{
+  PGresult *result;
+  gchar *fetch;
+
+  if (stmt->result && (stmt->current_row < (PQntuples (stmt->result) - 1)))
+    {
+      stmt->current_row++;
+      return 1;
+    }
+
+  if (stmt->cursor_done)
+    return 0;
+
+  PQclear (stmt->result);
+  stmt->result = NULL;
+  stmt->current_row = -1;
+
+  fetch = g_strdup_printf ("FETCH FORWARD %i FROM %s;",
+                           SQL_CURSOR_FETCH_SIZE,
+                           stmt->cursor);
+  result = PQexec (stmt->conn, fetch);
+  g_free (fetch);
+  if (PQresultStatus (result) != PGRES_TUPLES_OK)
+    {
+      if (log_errors)
+        {
+          g_warning ("%s: FETCH failed: %s (%i)",
+                     __func__,
+                     PQresultErrorMessage (result),
+                     PQresultStatus (result));
+          g_warning ("%s: SQL: %s", __func__, stmt->sql);
+        }
+      PQclear (result);
+      return -1;
+    }
+
+  stmt->result = result;
+  if (PQntuples (result) < SQL_CURSOR_FETCH_SIZE)
+    stmt->cursor_done = 1;
+  if (PQntuples (result) == 0)
+    return 0;
+  stmt->current_row = 0;
+  return 1;
+}
+
+/**
+ * @brief Close the cursor of a statement, if it is open.
+ *
+ * @param[in]  stmt  Statement.
+ */
+static void
+sql_cursor_close (sql_stmt_t *stmt)
+{
+  PGresult *result;
+  const char *values[1];
+
+  if (stmt->cursor == NULL || stmt->executed == 0 || conn == NULL
+      || stmt->conn == NULL)
+    return;
+
+  /* The cursor is gone if the transaction that declared it was rolled back,
+   * and a failing CLOSE would abort the current transaction. */
+  values[0] = stmt->cursor;
+  result = PQexecParams (stmt->conn,
+                         "SELECT 1 FROM pg_cursors WHERE name = $1;",
+                         1, NULL, values, NULL, NULL, 0);
+  if (PQresultStatus (result) == PGRES_TUPLES_OK && PQntuples (result) > 0)
+    {
+      gchar *close_sql;
+
+      PQclear (result);
+      close_sql = g_strdup_printf ("CLOSE %s;", stmt->cursor);
+      result = PQexec (stmt->conn, close_sql);
+      g_free (close_sql);
+    }
+  PQclear (result);
+}
+
+/**
+ * @brief Execute a statement, or step to its next row.
+ *
+ * @param[in]  retry  Whether to keep retrying while database is busy or locked.
+ * @param[in]  stmt   Statement.
+ *
+ * @return 0 complete, 1 row available in results, -1 error, -2 gave up,
+ *         -3 lock unavailable, -4 unique constraint violation, -6 write
+ *         refused by the replica.
+ */
+static int
+sql_exec_step (int retry, sql_stmt_t *stmt)
+{
+  PGresult *result;
+
+  assert (stmt->sql);
+
+  if (stmt->executed == 0)
+    {
+      stmt->conn = conn;
+      if (stmt->cursor)
+        {
+          gchar *declare;
+
+          declare = sql_cursor_declare (stmt);
+          result = PQexecParams (stmt->conn,
+                                 declare,
+                                 stmt->param_values->len,
+                                 NULL,             /* Default param types. */
+                                 (const char* const*)
+                                  stmt->param_values->pdata,
+                                 (const int*) stmt->param_lengths->data,
+                                 (const int*) stmt->param_formats->data,
+                                 0);
+          g_free (declare);
+        }
+      else if (stmt->prepared && transaction_pooling == 0)
+        {
+          result = sql_exec_prepared (stmt);
+          if (result == NULL)
+            return -1;
+        }
+      else
+        result = PQexecParams (stmt->conn,
+                               stmt->sql,
+                               stmt->param_values->len,
+                               NULL,               /* Default param types. */
+                               (const char* const*) stmt->param_values->pdata,
+                               (const int*) stmt->param_lengths->data,
+                               (const int*) stmt->param_formats->data,
+                               0);                 /* Results as text. */
+      if (PQresultStatus (result) != PGRES_TUPLES_OK
+          && PQresultStatus (result) != PGRES_COMMAND_OK)
+        {
+          char *sqlstate;
 
           sqlstate = PQresultErrorField (result, PG_DIAG_SQLSTATE);
           g_debug ("%s: sqlstate: %s", __func__, sqlstate);
@@ -506,6 +1420,16 @@ sql_exec_internal (int retry, sql_stmt_t *stmt)
               log_errors = 0;
               g_debug ("%s: canceled SQL: %s", __func__, stmt->sql);
             }
+          else if (sqlstate && (strcmp (sqlstate, "25006") == 0)
+                   && stmt->conn == replica_conn)
+            {
+              /* read_only_sql_transaction, on the replica.  Move to the
+               * primary for the rest of the command. */
+              g_debug ("%s: write on replica, using primary: %s",
+                       __func__, stmt->sql);
+              PQclear (result);
+              return -6;
+            }
           else if (sqlstate && (strcmp (sqlstate, "55P03") == 0))
             {
               /* lock_not_available */
@@ -543,10 +1467,16 @@ sql_exec_internal (int retry, sql_stmt_t *stmt)
           return -1;
         }
 
-      stmt->result = result;
       stmt->executed = 1;
+      if (stmt->cursor)
+        PQclear (result);
+      else
+        stmt->result = result;
     }
 
+  if (stmt->cursor)
+    return sql_cursor_next (stmt);
+
   if (stmt->current_row < (PQntuples (stmt->result) - 1))
     {
       stmt->current_row++;
@@ -556,7 +1486,222 @@ sql_exec_internal (int retry, sql_stmt_t *stmt)
   return 0;
 }
 
-
+/**
+ * @brief Execute a statement, in a transaction of its own if pooling needs it.
+ *
+ * The whole result is fetched when the statement runs, because cursors are
+ * not used when pooling, so the transaction can end right away.
+ *
+ * @param[in]  retry  Whether to keep retrying while database is busy or locked.
+ * @param[in]  stmt   Statement.
+ *
+ * @return As for sql_exec_step.
+ */
+static int
+sql_exec_wrapped (int retry, sql_stmt_t *stmt)
+{
+  PGconn *connection;
+  int ret;
+
+  if (stmt->executed || sql_pool_wrap_needed () == 0)
+    return sql_exec_step (retry, stmt);
+
+  connection = conn;
+  if (sql_pool_begin (connection))
+    return -1;
+  ret = sql_exec_step (retry, stmt);
+  if (ret >= 0
+      && g_ascii_strncasecmp (stmt->sql + strspn (stmt->sql, " \t\n"),
+                              "INSERT",
+                              strlen ("INSERT"))
+         == 0)
+    sql_pool_save_last_insert_id (connection);
+  if (sql_pool_end (connection, ret < 0) && ret >= 0)
+    ret = -1;
+  return ret;
+}
+
+/**
+ * @brief Execute a statement.
+ *
+ * Adds the time spent to the statement and to the statistics.  The time
+ * of a statement is only compared with the slow query threshold when it
+ * is finalized, so that all the cursor fetches of an iterator count.
+ *
+ * @param[in]  retry  Whether to keep retrying while database is busy or locked.
+ * @param[in]  stmt   Statement.
+ *
+ * @return 0 complete, 1 row available in results, -1 error, -2 gave up,
+ *         -3 lock unavailable, -4 unique constraint violation.
+ */
+int
+sql_exec_internal (int retry, sql_stmt_t *stmt)
+{
+  gint64 start, elapsed;
+  int ret;
+
+  if (stmt->executed == 0)
+    stats_count++;
+  start = g_get_monotonic_time ();
+  ret = sql_exec_wrapped (retry, stmt);
+  if (ret == -6)
+    {
+      /* Move to the primary for the rest of the command. */
+      sql_use_primary ();
+      ret = sql_exec_wrapped (retry, stmt);
+    }
+  elapsed = g_get_monotonic_time () - start;
+  stmt->elapsed += elapsed;
+  stats_time += elapsed;
+  return ret;
+}
+
+/**
+ * @brief Execute several statements in a single round trip.
+ *
+ * @param[in]  sql  Statements, separated by semicolons.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+sql_exec_batch_internal (const char *sql)
+{
+  PGresult *result;
+  gint64 elapsed;
+  int wrapped;
+
+  sql_use_primary ();
+  wrapped = sql_pool_wrap_needed ();
+  if (wrapped && sql_pool_begin (conn))
+    return -1;
+
+  /* The simple query protocol runs all the statements of the string and
+   * returns the result of the last one, or of the one that failed. */
+  stats_count++;
+  elapsed = g_get_monotonic_time ();
+  result = PQexec (conn, sql);
+  elapsed = g_get_monotonic_time () - elapsed;
+  stats_time += elapsed;
+  sql_log_slow (sql, elapsed);
+  if (PQresultStatus (result) != PGRES_TUPLES_OK
+      && PQresultStatus (result) != PGRES_COMMAND_OK)
+    {
+      if (log_errors)
+        {
+          g_warning ("%s: PQexec failed: %s (%i)",
+                     __func__,
+                     PQresultErrorMessage (result),
+                     PQresultStatus (result));
+          g_warning ("%s: SQL: %s", __func__, sql);
+        }
+      PQclear (result);
+      if (wrapped)
+        sql_pool_end (conn, 1);
+      return -1;
+    }
+
+  PQclear (result);
+  if (wrapped)
+    return sql_pool_end (conn, 0);
+  return 0;
+}
+
+/**
+ * @brief Run a COPY FROM STDIN statement, in the current transaction if any.
+ *
+ * @param[in]  copy_sql  COPY ... FROM STDIN statement.
+ * @param[in]  data      Rows, in COPY text format.
+ * @param[in]  length    Length of data.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+sql_copy_in_step (const char *copy_sql, const char *data, size_t length)
+{
+  PGresult *result;
+  int ret;
+
+  result = PQexec (conn, copy_sql);
+  if (PQresultStatus (result) != PGRES_COPY_IN)
+    {
+      if (log_errors)
+        {
+          g_warning ("%s: PQexec failed: %s (%i)",
+                     __func__,
+                     PQresultErrorMessage (result),
+                     PQresultStatus (result));
+          g_warning ("%s: SQL: %s", __func__, copy_sql);
+        }
+      PQclear (result);
+      return -1;
+    }
+  PQclear (result);
+
+  ret = 0;
+  if (PQputCopyData (conn, data, length) != 1)
+    {
+      g_warning ("%s: PQputCopyData failed: %s",
+                 __func__,
+                 PQerrorMessage (conn));
+      ret = -1;
+    }
+
+  if (PQputCopyEnd (conn, ret ? "data failed" : NULL) != 1)
+    {
+      g_warning ("%s: PQputCopyEnd failed: %s",
+                 __func__,
+                 PQerrorMessage (conn));
+      ret = -1;
+    }
+
+  /* Collect the result of the COPY. */
+  while ((result = PQgetResult (conn)))
+    {
+      if (PQresultStatus (result) != PGRES_COMMAND_OK)
+        {
+          if (log_errors)
+            {
+              g_warning ("%s: COPY failed: %s (%i)",
+                         __func__,
+                         PQresultErrorMessage (result),
+                         PQresultStatus (result));
+              g_warning ("%s: SQL: %s", __func__, copy_sql);
+            }
+          ret = -1;
+        }
+      PQclear (result);
+    }
+
+  return ret;
+}
+
+/**
+ * @brief Run a COPY FROM STDIN statement with the given data.
+ *
+ * @param[in]  copy_sql  COPY ... FROM STDIN statement.
+ * @param[in]  data      Rows, in COPY text format.
+ * @param[in]  length    Length of data.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+sql_copy_in_internal (const char *copy_sql, const char *data, size_t length)
+{
+  int ret;
+
+  sql_use_primary ();
+  if (sql_pool_wrap_needed () == 0)
+    return sql_copy_in_step (copy_sql, data, length);
+
+  if (sql_pool_begin (conn))
+    return -1;
+  ret = sql_copy_in_step (copy_sql, data, length);
+  if (sql_pool_end (conn, ret))
+    return -1;
+  return ret;
+}
+
+
 /* Transactions. */
 
 /**
@@ -565,7 +1710,12 @@ sql_exec_internal (int retry, sql_stmt_t *stmt)
 void
 sql_begin_immediate ()
 {
-  sql ("BEGIN;");
+  sql_use_primary ();
+  if (transaction_pooling)
+    /* Start the transaction with the session settings. */
+    sql_pool_begin (conn);
+  else
+    sql ("BEGIN;");
 }
 
 /**
@@ -578,6 +1728,9 @@ sql_begin_immediate_giveup ()
 {
   int ret;
 
+  sql_use_primary ();
+  if (transaction_pooling)
+    return sql_pool_begin (conn);
   ret = sql_giveup ("BEGIN;");
   if (ret)
     return ret;
@@ -631,8 +1784,47 @@ iterator_null (iterator_t* iterator, int col)
 void
 iterator_rewind (iterator_t* iterator)
 {
+  sql_stmt_t *stmt;
+
+  stmt = iterator->stmt;
   iterator->done = FALSE;
-  iterator->stmt->current_row = -1;
+  if (stmt->cursor)
+    {
+      /* The cursor only goes forward, so run the query again. */
+      sql_cursor_close (stmt);
+      PQclear (stmt->result);
+      stmt->result = NULL;
+      stmt->executed = 0;
+      stmt->cursor_done = 0;
+    }
+  stmt->current_row = -1;
+}
+
+/**
+ * @brief Make an iterator fetch its rows from a cursor, a chunk at a time.
+ *
+ * This keeps the memory used by the iterator flat, no matter how many rows
+ * the query returns, at the cost of a round trip for each chunk.  Must be
+ * called before the first call to next.
+ *
+ * @param[in]  iterator  Iterator.
+ */
+void
+iterator_use_cursor (iterator_t* iterator)
+{
+  sql_stmt_t *stmt;
+
+  stmt = iterator->stmt;
+  if (stmt->executed)
+    {
+      g_warning ("%s: iterator already started", __func__);
+      return;
+    }
+  /* Cursors live in the backend session, which a pooler may reassign. */
+  if (transaction_pooling)
+    return;
+  if (stmt->cursor == NULL)
+    stmt->cursor = g_strdup_printf ("gvmd_cursor_%u", ++cursor_count);
 }
 
 
@@ -646,6 +1838,9 @@ iterator_rewind (iterator_t* iterator)
 void
 sql_finalize (sql_stmt_t *stmt)
 {
+  sql_log_slow (stmt->sql, stmt->elapsed);
+  sql_cursor_close (stmt);
+  g_free (stmt->cursor);
   PQclear (stmt->result);
   g_free (stmt->sql);
   array_free (stmt->param_values);
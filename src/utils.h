@@ -28,6 +28,11 @@
 #include <gvm/util/xmlutils.h>
 #include <time.h>
 
+/**
+ * @brief GLib log domain for timings of SQL statements and GMP commands.
+ */
+#define GVMD_PERF_LOG_DOMAIN "md   perf"
+
 int
 gvm_usleep (unsigned int);
 